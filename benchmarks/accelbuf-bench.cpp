@@ -0,0 +1,319 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* scopehal-bench                                                                                                       *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@brief Microbenchmarks for AcceleratorBuffer allocation and transfer paths
+
+	Measures allocation throughput per memory configuration, PrepareForGpuAccess / PrepareForCpuAccess transfer
+	bandwidth as a function of buffer size, host access bandwidth to pinned vs paged memory, and iterator overhead
+	vs raw pointer access. Results are emitted as machine-readable JSON on stdout, tagged with the device name and
+	driver version so runs are comparable across machines, driver upgrades, and allocator changes.
+ */
+
+#include "../scopehal/scopehal.h"
+
+#include <cinttypes>
+#include <random>
+
+using namespace std;
+
+//Accumulator visible to the optimizer so the read loops can't be dead-code eliminated
+volatile float g_sink = 0;
+
+struct BenchResult
+{
+	string m_test;
+	string m_config;
+	size_t m_bytes;
+	double m_value;
+	string m_unit;
+};
+
+vector<BenchResult> g_results;
+
+static void Report(const string& test, const string& config, size_t bytes, double value, const string& unit)
+{
+	LogNotice("%-20s %-24s %12zu bytes: %.4g %s\n", test.c_str(), config.c_str(), bytes, value, unit.c_str());
+	g_results.push_back(BenchResult{test, config, bytes, value, unit});
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Allocation throughput
+
+static void BenchAllocation(
+	const string& config,
+	AcceleratorBuffer<float>::UsageHint cpuHint,
+	AcceleratorBuffer<float>::UsageHint gpuHint)
+{
+	const size_t sizes[] = {1024, 256 * 1024, 16 * 1024 * 1024};
+	for(auto size : sizes)
+	{
+		size_t elements = size / sizeof(float);
+
+		//Size the pass so it runs long enough to time well but doesn't take forever on big buffers
+		size_t iters = min<size_t>(2000, max<size_t>(50, (64 * 1024 * 1024) / size));
+
+		double start = GetTime();
+		for(size_t i=0; i<iters; i++)
+		{
+			AcceleratorBuffer<float> buf;
+			buf.SetCpuAccessHint(cpuHint);
+			buf.SetGpuAccessHint(gpuHint);
+			buf.resize(elements);
+
+			//Touch the allocation so lazily mapped memory is actually backed
+			if(cpuHint != AcceleratorBuffer<float>::HINT_NEVER)
+				buf[0] = 1.0f;
+		}
+		double dt = GetTime() - start;
+
+		Report("alloc", config, size, iters / dt, "allocs/sec");
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Transfer bandwidth
+
+static void BenchTransfer()
+{
+	for(size_t size = 64 * 1024; size <= 256 * 1024 * 1024; size *= 4)
+	{
+		size_t elements = size / sizeof(float);
+		size_t iters = min<size_t>(200, max<size_t>(5, (1024UL * 1024 * 1024) / size));
+
+		AcceleratorBuffer<float> buf;
+		buf.SetCpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
+		buf.SetGpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY, true);
+		buf.resize(elements);
+		buf.PrepareForCpuAccess();
+		for(size_t i=0; i<elements; i++)
+			buf[i] = i;
+
+		//Warm up one round trip so first-use setup doesn't count
+		buf.MarkModifiedFromCpu();
+		buf.PrepareForGpuAccess();
+		buf.MarkModifiedFromGpu();
+		buf.PrepareForCpuAccess();
+
+		//Host to device
+		double start = GetTime();
+		for(size_t i=0; i<iters; i++)
+		{
+			buf.MarkModifiedFromCpu();
+			buf.PrepareForGpuAccess();
+		}
+		double dt = GetTime() - start;
+		Report("transfer", "CopyToGpu", size, (size * iters) / dt / 1e9, "GB/s");
+
+		//Device to host
+		start = GetTime();
+		for(size_t i=0; i<iters; i++)
+		{
+			buf.MarkModifiedFromGpu();
+			buf.PrepareForCpuAccess();
+		}
+		dt = GetTime() - start;
+		Report("transfer", "CopyToCpu", size, (size * iters) / dt / 1e9, "GB/s");
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Host access to pinned vs paged memory
+
+static void BenchHostAccess(const string& config, AcceleratorBuffer<float>::UsageHint gpuHint)
+{
+	const size_t size = 64 * 1024 * 1024;
+	size_t elements = size / sizeof(float);
+
+	AcceleratorBuffer<float> buf;
+	buf.SetCpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
+	buf.SetGpuAccessHint(gpuHint, true);
+	buf.resize(elements);
+	buf.PrepareForCpuAccess();
+
+	auto p = buf.GetCpuPointer();
+	for(size_t i=0; i<elements; i++)
+		p[i] = i;
+
+	//Sequential read bandwidth
+	const size_t iters = 8;
+	double start = GetTime();
+	float sum = 0;
+	for(size_t j=0; j<iters; j++)
+	{
+		for(size_t i=0; i<elements; i++)
+			sum += p[i];
+	}
+	g_sink = sum;
+	double dt = GetTime() - start;
+	Report("host-read-seq", config, size, (size * iters) / dt / 1e9, "GB/s");
+
+	//Random access: dependent-chain style LCG walk to expose latency rather than bandwidth
+	const size_t accesses = 4 * 1024 * 1024;
+	uint64_t idx = 12345;
+	start = GetTime();
+	sum = 0;
+	for(size_t i=0; i<accesses; i++)
+	{
+		idx = (idx * 6364136223846793005UL + 1442695040888963407UL);
+		sum += p[(idx >> 32) % elements];
+	}
+	g_sink = sum;
+	dt = GetTime() - start;
+	Report("host-read-rand", config, size, (dt / accesses) * 1e9, "ns/access");
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Iterator overhead
+
+static void BenchIterators()
+{
+	const size_t size = 16 * 1024 * 1024;
+	size_t elements = size / sizeof(float);
+
+	AcceleratorBuffer<float> buf;
+	buf.SetCpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
+	buf.SetGpuAccessHint(AcceleratorBuffer<float>::HINT_NEVER);
+	buf.resize(elements);
+	for(size_t i=0; i<elements; i++)
+		buf[i] = i;
+
+	const size_t iters = 16;
+
+	//Raw pointer baseline
+	auto p = buf.GetCpuPointer();
+	double start = GetTime();
+	float sum = 0;
+	for(size_t j=0; j<iters; j++)
+	{
+		for(size_t i=0; i<elements; i++)
+			sum += p[i];
+	}
+	g_sink = sum;
+	double dt = GetTime() - start;
+	Report("iterate", "raw pointer", size, (elements * iters) / dt / 1e9, "Gelem/s");
+
+	//Iterator
+	start = GetTime();
+	sum = 0;
+	for(size_t j=0; j<iters; j++)
+	{
+		for(auto v : buf)
+			sum += v;
+	}
+	g_sink = sum;
+	dt = GetTime() - start;
+	Report("iterate", "iterator", size, (elements * iters) / dt / 1e9, "Gelem/s");
+
+	//operator[]
+	start = GetTime();
+	sum = 0;
+	for(size_t j=0; j<iters; j++)
+	{
+		for(size_t i=0; i<elements; i++)
+			sum += buf[i];
+	}
+	g_sink = sum;
+	dt = GetTime() - start;
+	Report("iterate", "operator[]", size, (elements * iters) / dt / 1e9, "Gelem/s");
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Entry point
+
+int main(int argc, char* argv[])
+{
+	Severity console_verbosity = Severity::NOTICE;
+	for(int i=1; i<argc; i++)
+	{
+		string s(argv[i]);
+		if(s == "--quiet")
+			console_verbosity = Severity::WARNING;
+		else if(s == "--debug")
+			console_verbosity = Severity::DEBUG;
+		else if(s == "--help")
+		{
+			fprintf(stderr, "Usage: accelbuf-bench [--quiet] [--debug]\n");
+			return 0;
+		}
+		else
+		{
+			fprintf(stderr, "Unrecognized argument %s\n", s.c_str());
+			return 1;
+		}
+	}
+
+	//Log to stderr so stdout carries only the JSON report
+	g_log_sinks.emplace_back(make_unique<STDLogSink>(console_verbosity));
+
+	if(!VulkanInit(true))
+	{
+		LogError("Vulkan initialization failed, cannot benchmark\n");
+		return 1;
+	}
+
+	auto props = g_vkComputePhysicalDevice->getProperties();
+
+	typedef AcceleratorBuffer<float> buf_t;
+	BenchAllocation("cpu paged", buf_t::HINT_LIKELY, buf_t::HINT_NEVER);
+	BenchAllocation("cpu pinned", buf_t::HINT_LIKELY, buf_t::HINT_LIKELY);
+	BenchAllocation("gpu only", buf_t::HINT_NEVER, buf_t::HINT_LIKELY);
+
+	BenchTransfer();
+
+	BenchHostAccess("paged", buf_t::HINT_NEVER);
+	BenchHostAccess("pinned", buf_t::HINT_LIKELY);
+
+	BenchIterators();
+
+	//Emit the JSON report
+	printf("{\n");
+	printf("  \"generator\": \"accelbuf-bench\",\n");
+	printf("  \"version\": \"%s\",\n", ScopehalGetVersion());
+	printf("  \"device\": \"%s\",\n", &props.deviceName[0]);
+	printf("  \"driver_version\": %u,\n", g_vkComputeDeviceDriverVer);
+	printf("  \"results\": [\n");
+	for(size_t i=0; i<g_results.size(); i++)
+	{
+		auto& r = g_results[i];
+		printf("    { \"test\": \"%s\", \"config\": \"%s\", \"bytes\": %zu, \"value\": %.6g, \"unit\": \"%s\" }%s\n",
+			r.m_test.c_str(),
+			r.m_config.c_str(),
+			r.m_bytes,
+			r.m_value,
+			r.m_unit.c_str(),
+			(i + 1 < g_results.size()) ? "," : "");
+	}
+	printf("  ]\n");
+	printf("}\n");
+
+	ScopehalStaticCleanup();
+	return 0;
+}
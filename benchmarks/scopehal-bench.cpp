@@ -0,0 +1,628 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* scopehal-bench                                                                                                       *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@brief Reproducible performance benchmark for a curated set of hot filters
+
+	Generates canonical waveforms (sinewave mixes, PRBS31 serial data, valid CAN and 10base-T frames), runs each
+	filter across a sweep of waveform sizes, and reports throughput in samples per second as machine-readable JSON
+	on stdout. Log output goes to stderr so the JSON stays clean.
+
+	For CI regression gating, point --baseline-dir at a directory of per-machine baselines: the first run on a
+	given host saves its results there, and subsequent runs compare against them and exit nonzero if any filter
+	slowed down by more than the threshold. Use --repeat to take the median of several timing passes so a noisy
+	neighbor doesn't fail the gate.
+ */
+
+#include "../scopehal/scopehal.h"
+#include "../scopehal/TestWaveformSource.h"
+#include "../scopeprotocols/scopeprotocols.h"
+
+#include <cinttypes>
+#include <cstring>
+#include <random>
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Stimulus generation
+
+/**
+	@brief Appends one CAN bit to the bus-level bitstream, inserting a stuff bit after five equal levels
+ */
+static void CanPushBit(vector<bool>& levels, bool dominant, int& run, bool& last, bool stuffing)
+{
+	levels.push_back(dominant);
+	if(!stuffing)
+		return;
+
+	if(dominant == last)
+		run ++;
+	else
+	{
+		run = 1;
+		last = dominant;
+	}
+
+	if(run == 5)
+	{
+		levels.push_back(!dominant);
+		run = 1;
+		last = !dominant;
+	}
+}
+
+/**
+	@brief Generates a digital waveform containing back-to-back valid CAN data frames
+
+	Frames are standard (11-bit ID) with an 8 byte payload and a correct CRC-15, so the decoder exercises its full
+	state machine rather than bailing out early on malformed input.
+ */
+static UniformDigitalWaveform* GenerateCanStimulus(size_t depth, int64_t bitrate, size_t samplesPerUI)
+{
+	//Logical frame bits, CAN convention: dominant = 0, recessive = 1
+	const uint32_t id = 0x2AA;
+	const uint8_t payload[8] = {0xDE, 0xAD, 0xBE, 0xEF, 0x01, 0x23, 0x45, 0x67};
+
+	vector<bool> logicalBits;
+	logicalBits.push_back(false);					//SOF (dominant)
+	for(int i=10; i>=0; i--)						//11 bit identifier
+		logicalBits.push_back((id >> i) & 1);
+	logicalBits.push_back(false);					//RTR = 0 (data frame)
+	logicalBits.push_back(false);					//IDE = 0 (standard frame)
+	logicalBits.push_back(false);					//r0
+	for(int i=3; i>=0; i--)							//DLC = 8
+		logicalBits.push_back((8 >> i) & 1);
+	for(size_t j=0; j<8; j++)
+	{
+		for(int i=7; i>=0; i--)
+			logicalBits.push_back((payload[j] >> i) & 1);
+	}
+
+	//CRC-15 over everything from SOF through the end of the data field
+	uint16_t crc = 0;
+	for(auto b : logicalBits)
+	{
+		bool crcnext = b ^ ((crc >> 14) & 1);
+		crc = (crc << 1) & 0x7fff;
+		if(crcnext)
+			crc ^= 0x4599;
+	}
+	for(int i=14; i>=0; i--)
+		logicalBits.push_back((crc >> i) & 1);
+
+	//Convert to bus levels (dominant = true) with stuffing, which covers SOF through the CRC sequence
+	vector<bool> levels;
+	int run = 0;
+	bool last = true;
+	for(auto b : logicalBits)
+		CanPushBit(levels, !b, run, last, true);
+
+	//CRC delimiter, ACK slot (driven dominant by the receiver), ACK delimiter, 7 bit EOF, 3 bit IFS
+	levels.push_back(false);
+	levels.push_back(true);
+	for(size_t i=0; i<12; i++)
+		levels.push_back(false);
+
+	//Extra idle time so the decoder can resynchronize between frames
+	for(size_t i=0; i<8; i++)
+		levels.push_back(false);
+
+	//Expand to samples and tile frames until we fill the requested depth
+	auto wfm = new UniformDigitalWaveform;
+	wfm->m_timescale = FS_PER_SECOND / (bitrate * samplesPerUI);
+	wfm->m_startTimestamp = time(nullptr);
+	wfm->m_startFemtoseconds = 0;
+	wfm->m_triggerPhase = 0;
+	wfm->Resize(depth);
+	wfm->PrepareForCpuAccess();
+
+	size_t nsamp = 0;
+	while(nsamp < depth)
+	{
+		for(size_t i=0; (i < levels.size()) && (nsamp < depth); i++)
+		{
+			for(size_t j=0; (j < samplesPerUI) && (nsamp < depth); j++)
+				wfm->m_samples[nsamp ++] = levels[i];
+		}
+	}
+	wfm->MarkModifiedFromCpu();
+	return wfm;
+}
+
+/**
+	@brief Generates an analog waveform containing back-to-back valid 10base-T Ethernet frames
+
+	Manchester encoded at 10 Mbps with a correct FCS, 10 samples per UI.
+ */
+static UniformAnalogWaveform* GenerateEthernetStimulus(size_t depth)
+{
+	//Assemble the frame: preamble, SFD, header, payload, FCS
+	vector<uint8_t> bytes;
+	for(size_t i=0; i<7; i++)
+		bytes.push_back(0x55);
+	bytes.push_back(0xD5);
+
+	const uint8_t header[14] =
+	{
+		0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,		//broadcast destination
+		0x02, 0x00, 0x00, 0xC0, 0xFF, 0xEE,		//locally administered source
+		0x08, 0x00								//IPv4 ethertype
+	};
+	for(size_t i=0; i<sizeof(header); i++)
+		bytes.push_back(header[i]);
+	for(size_t i=0; i<46; i++)
+		bytes.push_back(i);
+
+	uint32_t fcs = CRC32(&bytes[0], 8, bytes.size() - 1);
+	for(size_t i=0; i<4; i++)
+		bytes.push_back((fcs >> (i*8)) & 0xff);
+
+	//Manchester encode, LSB first: a 1 is low-then-high, a 0 is high-then-low
+	const size_t samplesPerUI = 10;
+	const size_t halfUI = samplesPerUI / 2;
+	const float amplitude = 1.0f;
+	const size_t idleUIs = 40;
+
+	auto wfm = new UniformAnalogWaveform;
+	wfm->m_timescale = 100000 * 1000 / samplesPerUI;	//100 ns UI
+	wfm->m_startTimestamp = time(nullptr);
+	wfm->m_startFemtoseconds = 0;
+	wfm->m_triggerPhase = 0;
+	wfm->Resize(depth);
+	wfm->PrepareForCpuAccess();
+
+	size_t nsamp = 0;
+	while(nsamp < depth)
+	{
+		for(size_t i=0; (i < bytes.size()) && (nsamp < depth); i++)
+		{
+			for(size_t j=0; (j < 8) && (nsamp < depth); j++)
+			{
+				bool b = (bytes[i] >> j) & 1;
+				for(size_t k=0; (k < samplesPerUI) && (nsamp < depth); k++)
+				{
+					bool firstHalf = (k < halfUI);
+					wfm->m_samples[nsamp ++] = (b ^ firstHalf) ? amplitude : -amplitude;
+				}
+			}
+		}
+
+		//Interframe gap at idle (0V differential)
+		for(size_t i=0; (i < idleUIs * samplesPerUI) && (nsamp < depth); i++)
+			wfm->m_samples[nsamp ++] = 0;
+	}
+	wfm->MarkModifiedFromCpu();
+	return wfm;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Benchmark harness
+
+struct BenchResult
+{
+	string m_filter;
+	size_t m_depth;
+	size_t m_iterations;
+	double m_seconds;
+	double m_samplesPerSec;
+};
+
+///@brief Number of timing passes per benchmark; the reported rate is the median (set by --repeat)
+static size_t g_repeat = 1;
+
+/**
+	@brief Times repeated refreshes of a filter against a fixed-size input
+
+	One warmup pass runs first so lazy pipeline creation and first-touch allocation don't count. The input's start
+	timestamp is perturbed between iterations so that incremental decoders re-decode the full waveform every pass.
+
+	With --repeat the whole timing loop runs several times and the median rate is reported, so a transient
+	frequency excursion or noisy neighbor on a shared CI box doesn't skew the result.
+ */
+static BenchResult BenchmarkFilter(
+	Filter* f,
+	WaveformBase* stimulus,
+	size_t depth,
+	const string& name,
+	vk::raii::CommandBuffer& cmdBuf,
+	shared_ptr<QueueHandle> queue)
+{
+	f->Refresh(cmdBuf, queue);
+
+	const size_t minIters = 3;
+	const size_t maxIters = 50;
+	const double minSeconds = 0.5;
+
+	BenchResult result;
+	result.m_filter = name;
+	result.m_depth = depth;
+
+	vector<double> rates;
+	for(size_t rep=0; rep<g_repeat; rep++)
+	{
+		double start = GetTime();
+		double elapsed = 0;
+		size_t iters = 0;
+		while( (iters < minIters) || ( (elapsed < minSeconds) && (iters < maxIters) ) )
+		{
+			stimulus->m_startFemtoseconds ++;
+			f->Refresh(cmdBuf, queue);
+			iters ++;
+			elapsed = GetTime() - start;
+		}
+
+		rates.push_back((depth * iters) / elapsed);
+
+		//Iteration count and wall time of the first pass go in the report
+		if(rep == 0)
+		{
+			result.m_iterations = iters;
+			result.m_seconds = elapsed;
+		}
+	}
+
+	sort(rates.begin(), rates.end());
+	size_t n = rates.size();
+	if(n & 1)
+		result.m_samplesPerSec = rates[n/2];
+	else
+		result.m_samplesPerSec = (rates[n/2 - 1] + rates[n/2]) / 2;
+
+	LogNotice("%-25s %10zu samples: %.3g samples/sec\n", name.c_str(), depth, result.m_samplesPerSec);
+	return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Baseline storage and comparison
+
+///@brief Name of this machine, used to pick the baseline file within the baseline directory
+static string GetHostName()
+{
+	#ifdef _WIN32
+		auto name = getenv("COMPUTERNAME");
+	#else
+		char buf[256] = {0};
+		gethostname(buf, sizeof(buf) - 1);
+		auto name = buf;
+	#endif
+
+	if( (name == nullptr) || (name[0] == '\0') )
+		return "unknown-host";
+	return name;
+}
+
+///@brief Writes the JSON report to the given stream (stdout for the normal report, or a baseline file)
+static void WriteReport(FILE* fp, const vector<BenchResult>& results)
+{
+	fprintf(fp, "{\n");
+	fprintf(fp, "  \"generator\": \"scopehal-bench\",\n");
+	fprintf(fp, "  \"version\": \"%s\",\n", ScopehalGetVersion());
+	fprintf(fp, "  \"host\": \"%s\",\n", GetHostName().c_str());
+	fprintf(fp, "  \"repeat\": %zu,\n", g_repeat);
+	fprintf(fp, "  \"results\": [\n");
+	for(size_t i=0; i<results.size(); i++)
+	{
+		auto& r = results[i];
+		fprintf(fp, "    { \"filter\": \"%s\", \"depth\": %zu, \"iterations\": %zu, \"seconds\": %f, "
+			"\"samples_per_sec\": %.6g }%s\n",
+			r.m_filter.c_str(),
+			r.m_depth,
+			r.m_iterations,
+			r.m_seconds,
+			r.m_samplesPerSec,
+			(i + 1 < results.size()) ? "," : "");
+	}
+	fprintf(fp, "  ]\n");
+	fprintf(fp, "}\n");
+}
+
+/**
+	@brief Reads a baseline file previously written by WriteReport()
+
+	This only has to parse the exact format we emit ourselves (one result object per line), so it scans for the
+	relevant keys rather than pulling in a general purpose JSON parser.
+ */
+static bool LoadBaseline(const string& path, vector<BenchResult>& results)
+{
+	FILE* fp = fopen(path.c_str(), "r");
+	if(!fp)
+		return false;
+
+	char line[1024];
+	while(fgets(line, sizeof(line), fp))
+	{
+		auto fstart = strstr(line, "\"filter\": \"");
+		if(!fstart)
+			continue;
+		fstart += strlen("\"filter\": \"");
+		auto fend = strchr(fstart, '\"');
+
+		auto dstart = strstr(line, "\"depth\": ");
+		auto rstart = strstr(line, "\"samples_per_sec\": ");
+		if(!fend || !dstart || !rstart)
+			continue;
+
+		BenchResult r;
+		r.m_filter = string(fstart, fend - fstart);
+		r.m_depth = strtoull(dstart + strlen("\"depth\": "), nullptr, 10);
+		r.m_iterations = 0;
+		r.m_seconds = 0;
+		r.m_samplesPerSec = strtod(rstart + strlen("\"samples_per_sec\": "), nullptr);
+		results.push_back(r);
+	}
+
+	fclose(fp);
+	return !results.empty();
+}
+
+/**
+	@brief Compares results against a baseline and reports regressions
+
+	@return number of tracked (filter, depth) pairs that regressed by more than the threshold
+ */
+static size_t CompareToBaseline(
+	const vector<BenchResult>& results,
+	const vector<BenchResult>& baseline,
+	double thresholdPercent)
+{
+	size_t regressions = 0;
+	for(auto& r : results)
+	{
+		const BenchResult* base = nullptr;
+		for(auto& b : baseline)
+		{
+			if( (b.m_filter == r.m_filter) && (b.m_depth == r.m_depth) )
+			{
+				base = &b;
+				break;
+			}
+		}
+
+		//New benchmark with no baseline yet; informational only
+		if(!base)
+		{
+			LogNotice("%-25s %10zu samples: no baseline\n", r.m_filter.c_str(), r.m_depth);
+			continue;
+		}
+
+		double deltaPercent = 100 * (r.m_samplesPerSec - base->m_samplesPerSec) / base->m_samplesPerSec;
+		if(deltaPercent < -thresholdPercent)
+		{
+			LogError("%-25s %10zu samples: %.3g samples/sec, %+.1f%% vs baseline %.3g (REGRESSION)\n",
+				r.m_filter.c_str(), r.m_depth, r.m_samplesPerSec, deltaPercent, base->m_samplesPerSec);
+			regressions ++;
+		}
+		else
+		{
+			LogNotice("%-25s %10zu samples: %.3g samples/sec, %+.1f%% vs baseline %.3g\n",
+				r.m_filter.c_str(), r.m_depth, r.m_samplesPerSec, deltaPercent, base->m_samplesPerSec);
+		}
+	}
+	return regressions;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Entry point
+
+int main(int argc, char* argv[])
+{
+	Severity console_verbosity = Severity::WARNING;
+	string baselineDir;
+	bool updateBaseline = false;
+	double thresholdPercent = 5;
+	for(int i=1; i<argc; i++)
+	{
+		string s(argv[i]);
+		if(s == "--verbose")
+			console_verbosity = Severity::VERBOSE;
+		else if(s == "--debug")
+			console_verbosity = Severity::DEBUG;
+		else if( (s == "--repeat") && (i + 1 < argc) )
+			g_repeat = max(strtoull(argv[++ i], nullptr, 10), 1ull);
+		else if( (s == "--baseline-dir") && (i + 1 < argc) )
+			baselineDir = argv[++ i];
+		else if(s == "--update-baseline")
+			updateBaseline = true;
+		else if( (s == "--threshold") && (i + 1 < argc) )
+			thresholdPercent = strtod(argv[++ i], nullptr);
+		else if(s == "--help")
+		{
+			fprintf(stderr,
+				"Usage: scopehal-bench [--verbose] [--debug] [--repeat k]\n"
+				"                      [--baseline-dir dir] [--update-baseline] [--threshold pct]\n"
+				"\n"
+				"    --repeat k          Run each benchmark k times and report the median rate (default 1)\n"
+				"    --baseline-dir dir  Compare against (or create) dir/<hostname>.json and exit nonzero\n"
+				"                        if any filter regressed by more than the threshold\n"
+				"    --update-baseline   Overwrite the baseline with this run's results instead of comparing\n"
+				"    --threshold pct     Regression threshold in percent (default 5)\n");
+			return 0;
+		}
+		else
+		{
+			fprintf(stderr, "Unrecognized argument %s\n", s.c_str());
+			return 1;
+		}
+	}
+
+	//Log to stderr so stdout carries only the JSON report
+	g_log_sinks.emplace_back(make_unique<STDLogSink>(console_verbosity));
+
+	TransportStaticInit();
+	DriverStaticInit();
+	ScopeProtocolStaticInit();
+	InitializeSearchPaths();
+	if(!VulkanInit(true))
+	{
+		LogError("Vulkan initialization failed, cannot benchmark\n");
+		return 1;
+	}
+
+	vector<BenchResult> results;
+
+	{
+		//Queue and command buffer for accelerated filters
+		shared_ptr<QueueHandle> queue(g_vkQueueManager->GetComputeQueue("scopehal-bench.queue"));
+		vk::CommandPoolCreateInfo poolInfo(
+			vk::CommandPoolCreateFlagBits::eTransient | vk::CommandPoolCreateFlagBits::eResetCommandBuffer,
+			queue->m_family );
+		vk::raii::CommandPool pool(*g_vkComputeDevice, poolInfo);
+		vk::CommandBufferAllocateInfo bufinfo(*pool, vk::CommandBufferLevel::ePrimary, 1);
+		vk::raii::CommandBuffer cmdBuf(move(vk::raii::CommandBuffers(*g_vkComputeDevice, bufinfo).front()));
+
+		//Offline scope to host the stimulus channels
+		auto scope = new MockOscilloscope("Benchmark", "scopehal", "0", "null", "mock", "");
+		auto chanSine = new OscilloscopeChannel(scope, "sine", "#ffff00",
+			Unit(Unit::UNIT_FS), Unit(Unit::UNIT_VOLTS), Stream::STREAM_TYPE_ANALOG, 0);
+		auto chanSerial = new OscilloscopeChannel(scope, "serial", "#00ffff",
+			Unit(Unit::UNIT_FS), Unit(Unit::UNIT_VOLTS), Stream::STREAM_TYPE_ANALOG, 1);
+		auto chanCan = new OscilloscopeChannel(scope, "can", "#00ff00",
+			Unit(Unit::UNIT_FS), Unit(Unit::UNIT_VOLTS), Stream::STREAM_TYPE_DIGITAL, 2);
+		auto chanEnet = new OscilloscopeChannel(scope, "enet", "#ff00ff",
+			Unit(Unit::UNIT_FS), Unit(Unit::UNIT_VOLTS), Stream::STREAM_TYPE_ANALOG, 3);
+		scope->AddChannel(chanSine);
+		scope->AddChannel(chanSerial);
+		scope->AddChannel(chanCan);
+		scope->AddChannel(chanEnet);
+		scope->SetChannelVoltageRange(1, 0, 1);
+
+		//Curated filter set
+		auto fft = Filter::CreateFilter("FFT");
+		fft->SetInput(0, StreamDescriptor(chanSine, 0));
+
+		auto fir = Filter::CreateFilter("FIR Filter");
+		fir->SetInput(0, StreamDescriptor(chanSine, 0));
+
+		auto cdr = Filter::CreateFilter("Clock Recovery (PLL)");
+		cdr->SetInput(0, StreamDescriptor(chanSerial, 0));
+		cdr->GetParameter("Symbol rate").SetFloatVal(10312500000.0f);	//10.3125 Gbps PRBS31
+
+		auto eye = dynamic_cast<EyePattern*>(Filter::CreateFilter("Eye pattern"));
+		eye->SetInput(0, StreamDescriptor(chanSerial, 0));
+		eye->SetInput(1, StreamDescriptor(cdr, 0));
+		eye->SetWidth(256);
+		eye->SetHeight(256);
+
+		auto can = Filter::CreateFilter("CAN");
+		can->SetInput(0, StreamDescriptor(chanCan, 0));
+		can->GetParameter("Bit Rate").SetIntVal(1000000);
+
+		auto enet = Filter::CreateFilter("Ethernet - 10baseT");
+		enet->SetInput(0, StreamDescriptor(chanEnet, 0));
+
+		minstd_rand rng;
+		TestWaveformSource source(rng);
+
+		const size_t depths[] = {100 * 1000, 1000 * 1000, 10 * 1000 * 1000};
+		for(auto depth : depths)
+		{
+			//Canonical stimulus at this depth (channel takes ownership and frees the previous waveform)
+			const int64_t sampleperiod = 10000;		//100 Gsps
+			auto sine = source.GenerateNoisySinewaveMix(0.9, 0.0, M_PI_4, 1e6, 1.1e6, sampleperiod, depth);
+			sine->MarkModifiedFromCpu();
+			chanSine->SetData(sine, 0);
+
+			auto serial = source.GeneratePRBS31(cmdBuf, queue, 0.9, 96969.6, sampleperiod, depth);
+			serial->MarkModifiedFromCpu();
+			chanSerial->SetData(serial, 0);
+
+			chanCan->SetData(GenerateCanStimulus(depth, 1000000, 16), 0);
+			chanEnet->SetData(GenerateEthernetStimulus(depth), 0);
+
+			results.push_back(BenchmarkFilter(fft, sine, depth, "FFT", cmdBuf, queue));
+			results.push_back(BenchmarkFilter(fir, sine, depth, "FIR Filter", cmdBuf, queue));
+			results.push_back(BenchmarkFilter(cdr, serial, depth, "Clock Recovery (PLL)", cmdBuf, queue));
+
+			//Eye pattern needs a valid recovered clock, so refresh the CDR once more with the final timestamp
+			cdr->Refresh(cmdBuf, queue);
+			results.push_back(BenchmarkFilter(eye, serial, depth, "Eye pattern", cmdBuf, queue));
+
+			results.push_back(
+				BenchmarkFilter(can, chanCan->GetData(0), depth, "CAN", cmdBuf, queue));
+			results.push_back(
+				BenchmarkFilter(enet, chanEnet->GetData(0), depth, "Ethernet - 10baseT", cmdBuf, queue));
+		}
+
+		delete eye;
+		delete cdr;
+		delete fft;
+		delete fir;
+		delete can;
+		delete enet;
+		delete scope;
+	}
+
+	//Emit the JSON report
+	WriteReport(stdout, results);
+
+	//Compare against (or create) the per-machine baseline
+	int code = 0;
+	if(!baselineDir.empty())
+	{
+		string path = baselineDir + "/" + GetHostName() + ".json";
+
+		vector<BenchResult> baseline;
+		if(!updateBaseline && LoadBaseline(path, baseline))
+		{
+			size_t regressions = CompareToBaseline(results, baseline, thresholdPercent);
+			if(regressions)
+			{
+				LogError("%zu benchmark(s) regressed by more than %.1f%% vs baseline %s\n",
+					regressions, thresholdPercent, path.c_str());
+				code = 1;
+			}
+		}
+
+		//First run on this machine (or explicit update): save the baseline for future comparisons
+		else
+		{
+			FILE* fp = fopen(path.c_str(), "w");
+			if(!fp)
+			{
+				LogError("Failed to open baseline file %s for writing\n", path.c_str());
+				code = 1;
+			}
+			else
+			{
+				WriteReport(fp, results);
+				fclose(fp);
+				LogNotice("Saved baseline to %s\n", path.c_str());
+			}
+		}
+	}
+
+	ScopehalStaticCleanup();
+	return code;
+}
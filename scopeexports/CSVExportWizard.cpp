@@ -302,8 +302,12 @@ void CSVExportWizard::on_apply()
 	}
 	auto timebaseWaveform = waveforms[0];
 
-	//Write data
+	//Write data, formatting into a bounded buffer that's flushed as it fills
 	//TODO: lots of redundant casting, this can probably be optimized!
+	string rowbuf;
+	const size_t flushThreshold = 1024 * 1024;
+	rowbuf.reserve(flushThreshold + 1024);
+	char tmp[48];
 	int64_t lastTimestamp = INT64_MIN;
 	auto timebaseSparse = dynamic_cast<SparseWaveformBase*>(timebaseWaveform);
 	auto timebaseUniform = dynamic_cast<UniformWaveformBase*>(timebaseWaveform);
@@ -318,26 +322,30 @@ void CSVExportWizard::on_apply()
 
 		//Write timestamp
 		if(timebaseUnit == Unit(Unit::UNIT_FS))
-			fprintf(fp, "%.10e", timestamp / FS_PER_SECOND);
-		else if(timebaseUnit == Unit(Unit::UNIT_HZ))
-			fprintf(fp, "%ld", timestamp);
+		{
+			snprintf(tmp, sizeof(tmp), "%.10e", timestamp / FS_PER_SECOND);
+			rowbuf += tmp;
+		}
 		else
-			fprintf(fp, "%ld", timestamp);
+			AppendInt64(rowbuf, timestamp);
 
 		//Write data from the reference channel as-is (no interpolation, it's the timebase by definition)
 		auto reftype = streams[0].GetType();
 		switch(reftype)
 		{
 			case Stream::STREAM_TYPE_ANALOG:
-				fprintf(fp, ",%f", GetValue(timebaseSparseAnalog, timebaseUniformAnalog, i));
+				rowbuf += ',';
+				AppendFloatFixed(rowbuf, GetValue(timebaseSparseAnalog, timebaseUniformAnalog, i));
 				break;
 
 			case Stream::STREAM_TYPE_DIGITAL:
-				fprintf(fp, ",%d", GetValue(timebaseSparseDigital, timebaseUniformDigital, i));
+				rowbuf += ',';
+				rowbuf += GetValue(timebaseSparseDigital, timebaseUniformDigital, i) ? '1' : '0';
 				break;
 
 			case Stream::STREAM_TYPE_PROTOCOL:
-				fprintf(fp, ",%s", timebaseWaveform->GetText(i).c_str());
+				rowbuf += ',';
+				rowbuf += timebaseWaveform->GetText(i);
 				break;
 
 			default:
@@ -384,7 +392,10 @@ void CSVExportWizard::on_apply()
 						auto san = dynamic_cast<SparseAnalogWaveform*>(w);
 
 						if(k+1 > w->size())
-							fprintf(fp, ",%f", GetValue(san, uan, k));
+						{
+							rowbuf += ',';
+							AppendFloatFixed(rowbuf, GetValue(san, uan, k));
+						}
 
 						//Interpolate
 						else
@@ -398,7 +409,8 @@ void CSVExportWizard::on_apply()
 							float frac = 1.0 * (timestamp - tleft) / (tright - tleft);
 
 							float flerp = vleft + frac * (vright-vleft);
-							fprintf(fp, ",%f", flerp);
+							rowbuf += ',';
+							AppendFloatFixed(rowbuf, flerp);
 						}
 					}
 					break;
@@ -408,17 +420,17 @@ void CSVExportWizard::on_apply()
 					{
 						auto udig = dynamic_cast<UniformDigitalWaveform*>(w);
 						auto sdig = dynamic_cast<SparseDigitalWaveform*>(w);
-						fprintf(fp, ",%d", GetValue(sdig, udig, k));
+						rowbuf += ',';
+						rowbuf += GetValue(sdig, udig, k) ? '1' : '0';
 					}
 					break;
 
 				//First-hit "interpolation"
 				case Stream::STREAM_TYPE_PROTOCOL:
 					{
+						rowbuf += ',';
 						if(firstHit)
-							fprintf(fp, ",%s", w->GetText(k).c_str());
-						else
-							fprintf(fp, ",");
+							rowbuf += w->GetText(k);
 					}
 					break;
 
@@ -428,10 +440,20 @@ void CSVExportWizard::on_apply()
 
 		}
 
-		fprintf(fp, "\n");
+		rowbuf += '\n';
 		lastTimestamp = timestamp;
+
+		//Flush when the buffer fills, keeping memory bounded regardless of export size
+		if(rowbuf.size() >= flushThreshold)
+		{
+			fwrite(rowbuf.data(), 1, rowbuf.size(), fp);
+			rowbuf.clear();
+		}
 	}
 
+	if(!rowbuf.empty())
+		fwrite(rowbuf.data(), 1, rowbuf.size(), fp);
+
 	fclose(fp);
 
 	hide();
@@ -37,6 +37,31 @@
 
 using namespace std;
 
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Incremental export state
+
+/**
+	@brief What's already been written to a given output file, so re-exporting a session that has only grown
+	can append the new transitions rather than rewriting the whole dump
+ */
+struct VCDExportState
+{
+	///@brief Names of the exported streams, in order (any change invalidates the file)
+	std::string m_config;
+
+	///@brief Trigger timestamps of each exported waveform when the file was written
+	std::vector<std::pair<time_t, int64_t>> m_waveformIds;
+
+	///@brief Last VCD timestamp emitted to the file
+	int64_t m_lastTimestamp;
+
+	///@brief Value of each signal as of m_lastTimestamp
+	std::vector<bool> m_lastValues;
+};
+
+///@brief Map of output file path to what it already contains
+static map<string, VCDExportState> g_vcdExportStates;
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 //VCDExportChannelSelectionPage
 
@@ -201,9 +226,12 @@ void VCDExportWizard::on_apply()
 	vector<UniformDigitalWaveform*> uniformwaveforms;
 	vector<size_t> indexes;
 	vector<size_t> lens;
+	string config;
+	vector<pair<time_t, int64_t>> waveformIds;
 	for(auto s : streams)
 	{
 		auto data = s.GetData();
+		data->PrepareForCpuAccess();
 
 		auto swfm = dynamic_cast<SparseDigitalWaveform*>(data);
 		sparsewaveforms.push_back(swfm);
@@ -213,32 +241,36 @@ void VCDExportWizard::on_apply()
 
 		indexes.push_back(0);
 		lens.push_back(data->size());
+
+		config += s.GetName() + ";";
+		waveformIds.push_back(pair<time_t, int64_t>(data->m_startTimestamp, data->m_startFemtoseconds));
 	}
 
-	//Write header section
+	//See if we can append to an existing export of the same session: same file, same streams, same trigger,
+	//and the data has only grown at the end since the file was written
 	auto fname = m_finalPage.m_chooser.get_filename();
-	FILE* fp = fopen(fname.c_str(), "w");
+	bool incremental = false;
+	VCDExportState state;
+	auto sit = g_vcdExportStates.find(fname);
+	if(sit != g_vcdExportStates.end())
+	{
+		state = sit->second;
+		incremental = (state.m_config == config) && (state.m_waveformIds == waveformIds);
+	}
+
+	FILE* fp = fopen(fname.c_str(), incremental ? "a" : "w");
 	if(!fp)
 	{
 		LogError("Failed to open output file\n");
 		return;
 	}
 
-	auto tnow = time(nullptr);
-	auto local = localtime(&tnow);
-	char timebuf[128] = {0};
-	strftime(timebuf, sizeof(timebuf), "%F %T", local);
-	fprintf(fp, "$date\n");
-	fprintf(fp, "    %s\n", timebuf);
-	fprintf(fp, "$end\n");
-	fprintf(fp, "$version\n");
-	fprintf(fp, "    glscopeclient (build date %s %s)\n", __DATE__, __TIME__);	//TODO: add git sha etc
-	fprintf(fp, "$end\n");
-	fprintf(fp, "$timescale 1fs\n");
-
-	//Dump the list of variables (for now, all a single module)
+	//Bound our buffering: format into a fixed 1MB stdio buffer and flush as it fills,
+	//rather than accumulating the whole dump anywhere
+	setvbuf(fp, nullptr, _IOFBF, 1024 * 1024);
+
+	//Generate short identifiers for each stream (base 52, deterministic, so appends reuse the same IDs)
 	std::map<size_t, string> ids;
-	fprintf(fp, "$scope module export $end\n");
 	for(size_t i=0; i<streams.size(); i++)
 	{
 		string id = "";
@@ -260,38 +292,96 @@ void VCDExportWizard::on_apply()
 				break;
 		}
 		ids[i] = id;
+	}
 
-		//Convert string to be fully alphanumeric
-		string name = streams[i].GetName();
-		for(size_t k=0; k<name.length(); k++)
+	//Write header section (appending to an existing file? it's already there)
+	if(!incremental)
+	{
+		auto tnow = time(nullptr);
+		auto local = localtime(&tnow);
+		char timebuf[128] = {0};
+		strftime(timebuf, sizeof(timebuf), "%F %T", local);
+		fprintf(fp, "$date\n");
+		fprintf(fp, "    %s\n", timebuf);
+		fprintf(fp, "$end\n");
+		fprintf(fp, "$version\n");
+		fprintf(fp, "    glscopeclient (build date %s %s)\n", __DATE__, __TIME__);	//TODO: add git sha etc
+		fprintf(fp, "$end\n");
+		fprintf(fp, "$timescale 1fs\n");
+
+		//Dump the list of variables (for now, all a single module)
+		fprintf(fp, "$scope module export $end\n");
+		for(size_t i=0; i<streams.size(); i++)
 		{
-			if(!isalnum(name[k]))
-				name[k] = '_';
+			//Convert string to be fully alphanumeric
+			string name = streams[i].GetName();
+			for(size_t k=0; k<name.length(); k++)
+			{
+				if(!isalnum(name[k]))
+					name[k] = '_';
+			}
+
+			//TODO: support digital vectors
+			fprintf(fp, "    $var wire 1 %3s %s $end\n",
+				ids[i].c_str(),
+				name.c_str());
 		}
-
-		//TODO: support digital vectors
-		fprintf(fp, "    $var wire 1 %3s %s $end\n",
-			id.c_str(),
-			name.c_str());
+		fprintf(fp, "$upscope $end\n");
+		fprintf(fp, "$enddefinitions $end\n");
+		fprintf(fp, "$dumpvars\n");
 	}
-	fprintf(fp, "$upscope $end\n");
-	fprintf(fp, "$enddefinitions $end\n");
-	fprintf(fp, "$dumpvars\n");
 
-	//Print the actual waveform
-	//TODO: more efficient, don't export every signal if only one has changed
+	//Starting position: beginning of the capture, or just past what the file already contains
 	int64_t timestamp = 0;
-	while(true)
+	vector<bool> lastValues(streams.size());
+	bool emitAll = true;
+	bool emitThisTimestamp = true;
+	if(incremental)
 	{
-		//Print signal values
-		fprintf(fp, "#%ld\n", timestamp);
+		timestamp = state.m_lastTimestamp;
+		lastValues = state.m_lastValues;
+		emitAll = false;
+		emitThisTimestamp = false;	//everything up to and including this timestamp is already in the file
+
 		for(size_t i=0; i<streams.size(); i++)
 		{
 			if(sparsewaveforms[i])
-				fprintf(fp,"%d%s\n", sparsewaveforms[i]->m_samples[indexes[i]], ids[i].c_str());
+				Filter::AdvanceToTimestampScaled(sparsewaveforms[i], indexes[i], lens[i], timestamp);
 			else
-				fprintf(fp,"%d%s\n", uniformwaveforms[i]->m_samples[indexes[i]], ids[i].c_str());
+				Filter::AdvanceToTimestampScaled(uniformwaveforms[i], indexes[i], lens[i], timestamp);
+		}
+	}
+
+	//Print the actual waveform
+	while(true)
+	{
+		//Print signal values, skipping any that didn't change since the last event
+		//(the initial $dumpvars block gets every signal)
+		if(emitThisTimestamp)
+		{
+			bool anyChanged = false;
+			for(size_t i=0; i<streams.size(); i++)
+			{
+				bool value;
+				if(sparsewaveforms[i])
+					value = sparsewaveforms[i]->m_samples[indexes[i]];
+				else
+					value = uniformwaveforms[i]->m_samples[indexes[i]];
+
+				if(emitAll || (value != lastValues[i]) )
+				{
+					if(!anyChanged)
+					{
+						fprintf(fp, "#%ld\n", timestamp);
+						anyChanged = true;
+					}
+					fprintf(fp, "%d%s\n", (int)value, ids[i].c_str());
+					lastValues[i] = value;
+				}
+			}
+			emitAll = false;
 		}
+		emitThisTimestamp = true;
 
 		//Get timestamp of next event on any channel
 		int64_t next = timestamp;
@@ -324,6 +414,14 @@ void VCDExportWizard::on_apply()
 	}
 
 	fclose(fp);
+
+	//Remember what the file now contains, so a later export of the same (grown) session appends the delta
+	state.m_config = config;
+	state.m_waveformIds = waveformIds;
+	state.m_lastTimestamp = timestamp;
+	state.m_lastValues = lastValues;
+	g_vcdExportStates[fname] = state;
+
 	hide();
 }
 
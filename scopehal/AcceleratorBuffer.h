@@ -36,7 +36,11 @@
 #define AcceleratorBuffer_h
 
 #include "AlignedAllocator.h"
+#include "PerfCounter.h"
 #include "QueueManager.h"
+#include "ScopehalUtil.h"
+#include "VulkanMemoryArena.h"
+#include "VulkanTransferBatch.h"
 
 #ifdef _WIN32
 #undef MemoryBarrier
@@ -47,8 +51,21 @@
 #include <unistd.h>
 #endif
 
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <future>
 #include <type_traits>
 
+/**
+	@brief Total bytes currently allocated by AcceleratorBuffer instances from the plain CPU heap
+
+	Covers MEM_TYPE_CPU_ONLY storage only: pinned memory is accounted for by g_vkPinnedMemoryArena, and
+	file-backed MEM_TYPE_CPU_PAGED storage can be reclaimed by the OS so it doesn't count as RAM pressure.
+	Read by MemoryGovernor (defined there too, since AcceleratorBuffer is header-only).
+ */
+extern std::atomic<size_t> g_cpuOnlyBufferBytes;
+
 extern uint32_t g_vkPinnedMemoryType;
 extern uint32_t g_vkLocalMemoryType;
 extern std::shared_ptr<vk::raii::Device> g_vkComputeDevice;
@@ -59,6 +76,14 @@ extern std::mutex g_vkTransferMutex;
 extern bool g_hasDebugUtils;
 extern bool g_vulkanDeviceHasUnifiedMemory;
 
+/**
+	@brief Runs a transfer operation on a background worker thread
+
+	The returned future becomes ready once the operation has completed. Used to overlap host<->device DMA with
+	other work rather than blocking the calling thread on the fence; see AcceleratorBuffer::PrepareForCpuAccessAsync().
+ */
+std::future<void> DispatchAsyncTransfer(std::function<void()> fn);
+
 template<class T>
 class AcceleratorBuffer;
 
@@ -225,11 +250,11 @@ protected:
 	///@brief CPU-side mapped pointer
 	T* m_cpuPtr;
 
-	///@brief CPU-side physical memory
-	std::unique_ptr<vk::raii::DeviceMemory> m_cpuPhysMem;
+	///@brief CPU-side physical memory (sub-allocated from g_vkPinnedMemoryArena)
+	std::unique_ptr<VulkanMemoryArena::Block> m_cpuPhysMem;
 
-	///@brief GPU-side physical memory
-	std::unique_ptr<vk::raii::DeviceMemory> m_gpuPhysMem;
+	///@brief GPU-side physical memory (sub-allocated from g_vkLocalMemoryArena)
+	std::unique_ptr<VulkanMemoryArena::Block> m_gpuPhysMem;
 
 	///@brief Buffer object for CPU-side memory
 	std::unique_ptr<vk::raii::Buffer> m_cpuBuffer;
@@ -246,11 +271,111 @@ protected:
 	///@brief True if m_gpuPhysMem contains stale data (m_cpuPtr has been modified and they point to different memory)
 	bool m_gpuPhysMemIsStale;
 
+	///@brief First stale element of the CPU mirror (only meaningful while m_cpuPhysMemIsStale is set)
+	size_t m_cpuStaleStart;
+
+	///@brief One past the last stale element of the CPU mirror (SIZE_MAX = the entire buffer)
+	size_t m_cpuStaleEnd;
+
+	///@brief First stale element of the GPU mirror (only meaningful while m_gpuPhysMemIsStale is set)
+	size_t m_gpuStaleStart;
+
+	///@brief One past the last stale element of the GPU mirror (SIZE_MAX = the entire buffer)
+	size_t m_gpuStaleEnd;
+
 	///@brief File handle used for MEM_TYPE_CPU_PAGED
 #ifndef _WIN32
 	int m_tempFileHandle;
 #endif
 
+	////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	// Copy-on-write sharing
+
+	/**
+		@brief Refcounted ownership of a CPU-side allocation shared between several AcceleratorBuffer instances
+
+		Created by ShareFrom(), which moves the source buffer's CPU-side storage in here so that the allocation
+		outlives any single instance referencing it. The last instance to let go (by detaching, reallocating,
+		or being destroyed) frees it.
+	 */
+	struct SharedStorage
+	{
+		SharedStorage()
+			: m_cpuPtr(nullptr)
+			, m_cpuMemoryType(MEM_TYPE_NULL)
+			, m_capacity(0)
+			#ifndef _WIN32
+			, m_tempFileHandle(-1)
+			#endif
+		{}
+
+		~SharedStorage()
+		{
+			//Free the Vulkan buffer object before the physical memory backing it
+			m_cpuBuffer = nullptr;
+
+			//Only trivially copyable types can be shared, so no destructors to run here
+			switch(m_cpuMemoryType)
+			{
+				case MEM_TYPE_CPU_DMA_CAPABLE:
+					m_cpuPhysMem = nullptr;
+					break;
+
+				case MEM_TYPE_CPU_PAGED:
+					#ifndef _WIN32
+						munmap(m_cpuPtr, m_capacity * sizeof(T));
+						close(m_tempFileHandle);
+					#endif
+					break;
+
+				case MEM_TYPE_CPU_ONLY:
+				{
+					AlignedAllocator<T, 32> alloc;
+					alloc.deallocate(m_cpuPtr, m_capacity);
+					break;
+				}
+
+				default:
+					break;
+			}
+		}
+
+		///@brief CPU-side mapped pointer
+		T* m_cpuPtr;
+
+		///@brief CPU-side physical memory (for MEM_TYPE_CPU_DMA_CAPABLE)
+		std::unique_ptr<VulkanMemoryArena::Block> m_cpuPhysMem;
+
+		///@brief Buffer object for the CPU-side memory, if it was GPU-reachable
+		std::unique_ptr<vk::raii::Buffer> m_cpuBuffer;
+
+		///@brief Type of the allocation
+		MemoryType m_cpuMemoryType;
+
+		///@brief Allocated size, in elements
+		size_t m_capacity;
+
+		///@brief File handle for MEM_TYPE_CPU_PAGED
+		#ifndef _WIN32
+		int m_tempFileHandle;
+		#endif
+	};
+
+	///@brief Shared storage block our CPU-side pointers reference, or null if we own our storage outright
+	std::shared_ptr<SharedStorage> m_sharedStorage;
+
+	/**
+		@brief Returns the Vulkan buffer object for the CPU-side memory
+
+		This is our own m_cpuBuffer normally, but lives in the shared storage block while we're sharing.
+	 */
+	vk::raii::Buffer* GetCpuVkBuffer() const
+	{
+		if(m_sharedStorage)
+			return m_sharedStorage->m_cpuBuffer.get();
+		return m_cpuBuffer.get();
+	}
+
 	////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 	// Iteration
 
@@ -295,6 +420,10 @@ public:
 		, m_buffersAreSame(false)
 		, m_cpuPhysMemIsStale(false)
 		, m_gpuPhysMemIsStale(false)
+		, m_cpuStaleStart(0)
+		, m_cpuStaleEnd(SIZE_MAX)
+		, m_gpuStaleStart(0)
+		, m_gpuStaleEnd(SIZE_MAX)
 		#ifndef _WIN32
 		, m_tempFileHandle(0)
 		#endif
@@ -399,7 +528,7 @@ public:
 		if(m_gpuBuffer != nullptr)
 			return **m_gpuBuffer;
 		else
-			return **m_cpuBuffer;
+			return **GetCpuVkBuffer();
 	}
 
 	/**
@@ -424,6 +553,16 @@ public:
 	 */
 	void resize(size_t size)
 	{
+		//Resizing is a statement of intent to write, so we can't keep scribbling on shared storage:
+		//materialize a private copy first (or just drop our reference, if we're being emptied)
+		if(m_sharedStorage)
+		{
+			if(size == 0)
+				FreeCpuBuffer();
+			else
+				Detach();
+		}
+
 		//Need to grow?
 		if(size > m_capacity)
 		{
@@ -464,6 +603,156 @@ public:
 			Reallocate(m_size);
 	}
 
+	/**
+		@brief Replaces our content with a copy-on-write mapping of a region of a file
+
+		Reads are served straight from the page cache with no copy; the first write to a page dirties a private
+		copy of it without touching the file. The mapping behaves like the anonymous temp-file backing used for
+		HINT_NEVER buffers, so all subsequent resize / access-pattern operations work normally (and detach from
+		the file by copying, as usual for a reallocation).
+
+		The caller may close fd after this returns (we keep our own handle to the file).
+
+		@param fd			File to map (may be opened read-only)
+		@param fileOffset	Byte offset of the region within the file; must be a multiple of the page size
+		@param count		Number of elements in the region
+
+		@return true on success. On failure the buffer is left empty. Always fails on Windows, where the caller
+				is expected to fall back to reading the file contents into a normally allocated buffer.
+	 */
+	 __attribute__((noinline))
+	bool AdoptFileMapping([[maybe_unused]] int fd, [[maybe_unused]] size_t fileOffset, [[maybe_unused]] size_t count)
+	{
+	#ifndef _WIN32
+		assert(std::is_trivially_copyable<T>::value);
+
+		//mmap requires a page aligned offset
+		if(fileOffset & (sysconf(_SC_PAGESIZE) - 1))
+			return false;
+
+		//Existing contents are being completely replaced, so drop both sides without syncing either one
+		m_cpuPhysMemIsStale = false;
+		m_gpuPhysMemIsStale = false;
+		FreeGpuBuffer();
+		FreeCpuBuffer();
+
+		if(count == 0)
+			return true;
+
+		void* p = mmap(nullptr, count * sizeof(T), PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, fileOffset);
+		if(p == MAP_FAILED)
+			return false;
+
+		m_cpuBuffer = nullptr;
+		m_cpuPtr = reinterpret_cast<T*>(p);
+		m_cpuMemoryType = MEM_TYPE_CPU_PAGED;
+
+		//Keep our own handle so the cleanup path (shared with the temp file backing) works unchanged
+		m_tempFileHandle = dup(fd);
+
+		m_size = count;
+		m_capacity = count;
+		MarkModifiedFromCpu();
+
+		return true;
+	#else
+		return false;
+	#endif
+	}
+
+	/**
+		@brief Shares another buffer's sample storage instead of copying it (copy-on-write)
+
+		On return, both buffers reference a single refcounted CPU-side allocation; whichever instance lets go
+		last frees it. Pinned storage stays pinned, so shared data can still be bound for GPU-side reads with
+		no copy. Any subsequent resize / CopyFrom / reallocation of either buffer - or an explicit Detach() -
+		materializes a private copy at that point, leaving the other instance untouched.
+
+		The sharing machinery can't see in-place element writes made through operator[], GetCpuPointer(), or a
+		bound shader, so callers doing that to a possibly-shared buffer must Detach() first. Filters which
+		regenerate their output from scratch each refresh (the intended users) satisfy this naturally, since
+		regeneration starts with a resize.
+
+		@return true on success, false if the source's data is somewhere we can't share from (e.g. GPU only)
+	 */
+	__attribute__((noinline))
+	bool ShareFrom(AcceleratorBuffer<T>& rhs)
+	{
+		assert(std::is_trivially_copyable<T>::value);
+
+		//Self-share is a no-op
+		if(&rhs == this)
+			return true;
+
+		//Drop any existing content without syncing either side
+		m_cpuPhysMemIsStale = false;
+		m_gpuPhysMemIsStale = false;
+		FreeGpuBuffer();
+		FreeCpuBuffer();
+
+		//Sharing nothing is trivially successful
+		if(rhs.m_size == 0)
+		{
+			m_size = 0;
+			return true;
+		}
+
+		//Make sure the source content is present and current on the CPU
+		rhs.PrepareForCpuAccess();
+		if(rhs.m_cpuPtr == nullptr)
+			return false;
+
+		//Move the source's storage into a shared block if it's not already sharing.
+		//The source keeps using the storage exactly as before; it just no longer owns it outright.
+		if(!rhs.m_sharedStorage)
+		{
+			auto block = std::make_shared<SharedStorage>();
+			block->m_cpuPtr = rhs.m_cpuPtr;
+			block->m_cpuPhysMem = std::move(rhs.m_cpuPhysMem);
+			block->m_cpuBuffer = std::move(rhs.m_cpuBuffer);
+			block->m_cpuMemoryType = rhs.m_cpuMemoryType;
+			block->m_capacity = rhs.m_capacity;
+			#ifndef _WIN32
+			block->m_tempFileHandle = rhs.m_tempFileHandle;
+			rhs.m_tempFileHandle = -1;
+			#endif
+			rhs.m_sharedStorage = block;
+		}
+
+		//Attach to the source's block. We share the CPU side only; a private GPU-side buffer gets allocated
+		//on demand if we're ever used on the GPU with non-pinned shared storage.
+		m_sharedStorage = rhs.m_sharedStorage;
+		m_cpuPtr = m_sharedStorage->m_cpuPtr;
+		m_cpuMemoryType = m_sharedStorage->m_cpuMemoryType;
+		m_cpuAccessHint = rhs.m_cpuAccessHint;
+		m_gpuAccessHint = rhs.m_gpuAccessHint;
+		m_size = rhs.m_size;
+		m_capacity = m_sharedStorage->m_capacity;
+
+		//Same "one physical copy" logic as Reallocate()
+		m_buffersAreSame = (m_cpuMemoryType == MEM_TYPE_CPU_DMA_CAPABLE) && (m_gpuMemoryType == MEM_TYPE_NULL);
+
+		return true;
+	}
+
+	/**
+		@brief Materializes a private copy of the buffer content if we're currently sharing storage
+
+		Resizing or copying into the buffer detaches automatically; call this explicitly before writing elements
+		in place (via operator[], GetCpuPointer(), or a shader) on a buffer that may be sharing its storage.
+	 */
+	void Detach()
+	{
+		if(m_sharedStorage && (m_size != 0))
+			Reallocate(m_capacity);
+	}
+
+	/**
+		@brief Returns true if we're currently sharing storage created by ShareFrom()
+	 */
+	bool IsShared() const
+	{ return (m_sharedStorage != nullptr); }
+
 	/**
 		@brief Copies our content from another AcceleratorBuffer
 	 */
@@ -490,6 +779,8 @@ public:
 				memcpy(m_cpuPtr, rhs.m_cpuPtr, m_size * sizeof(T));
 		}
 		m_cpuPhysMemIsStale = rhs.m_cpuPhysMemIsStale;
+		m_cpuStaleStart = rhs.m_cpuStaleStart;
+		m_cpuStaleEnd = rhs.m_cpuStaleEnd;
 
 		//Valid data GPU side? Copy it to here
 		if(rhs.HasGpuBuffer() && !rhs.m_gpuPhysMemIsStale)
@@ -506,6 +797,8 @@ public:
 			g_vkTransferQueue->SubmitAndBlock(*g_vkTransferCommandBuffer);
 		}
 		m_gpuPhysMemIsStale = rhs.m_gpuPhysMemIsStale;
+		m_gpuStaleStart = rhs.m_gpuStaleStart;
+		m_gpuStaleEnd = rhs.m_gpuStaleEnd;
 	}
 
 protected:
@@ -586,7 +879,11 @@ protected:
 				//(don't do a potentially unnecessary copy from the GPU)
 
 				//Now we're done with the old pointer so get rid of it
-				FreeCpuPointer(pOld, pOldPin, type, m_capacity);
+				//(if it was shared storage we didn't own it; just drop our reference)
+				if(m_sharedStorage)
+					m_sharedStorage = nullptr;
+				else
+					FreeCpuPointer(pOld, pOldPin, type, m_capacity);
 			}
 
 			//Allocate new CPU memory, replacing our current (null) pointer
@@ -597,7 +894,11 @@ protected:
 				//If we already had GPU-side memory containing data, then the new CPU-side buffer is stale
 				//until we copy stuff over to it
 				if(m_gpuPhysMem != nullptr)
+				{
 					m_cpuPhysMemIsStale = true;
+					m_cpuStaleStart = 0;
+					m_cpuStaleEnd = SIZE_MAX;
+				}
 			}
 		}
 
@@ -646,7 +947,11 @@ protected:
 					//until we copy stuff over to it.
 					//Special case: if m_size is 0 (newly allocated buffer) we're not stale yet
 					if( (m_cpuPhysMem != nullptr) && (m_size != 0) )
+					{
 						m_gpuPhysMemIsStale = true;
+						m_gpuStaleStart = 0;
+						m_gpuStaleEnd = SIZE_MAX;
+					}
 				}
 			}
 		}
@@ -691,9 +996,48 @@ public:
 		resize(m_size + 1);
 		m_cpuPtr[cursize] = value;
 
-		MarkModifiedFromCpu();
+		MarkModifiedFromCpu(cursize, 1);
 	}
 
+	/**
+		@brief Appends a block of elements to the end of the container in one pass
+
+		Equivalent to push_back() in a loop, but performs a single resize and a single stale-range update, so
+		bulk producers (streaming drivers appending to a history waveform, import filters, etc.) don't pay
+		per-element bookkeeping. Growth uses the same doubling policy as resize(), keeping repeated appends
+		amortized O(1) per element; this matters most for pinned buffers, where each reallocation re-registers
+		the memory with the device.
+	 */
+	void append(const T* data, size_t count)
+	{
+		if(count == 0)
+			return;
+
+		size_t cursize = m_size;
+		resize(m_size + count);
+
+		//non-trivially-copyable types have to be copied one at a time
+		if(!std::is_trivially_copyable<T>::value)
+		{
+			for(size_t i=0; i<count; i++)
+				m_cpuPtr[cursize + i] = data[i];
+		}
+
+		//Trivially copyable types can be done more efficiently in a block
+		else
+			memcpy(m_cpuPtr + cursize, data, count * sizeof(T));
+
+		MarkModifiedFromCpu(cursize, count);
+	}
+
+	/**
+		@brief Appends the contents of another buffer to the end of this one
+
+		The source buffer must be valid CPU side (call PrepareForCpuAccess() on it first).
+	 */
+	void append(const AcceleratorBuffer<T>& rhs)
+	{ append(rhs.m_cpuPtr, rhs.m_size); }
+
 	/**
 		@brief Removes the last item in the container
 	 */
@@ -748,6 +1092,9 @@ public:
 
 		//Don't touch GPU side buffer
 
+		//We're about to move elements in place, which isn't allowed on shared storage
+		Detach();
+
 		PrepareForCpuAccess();
 
 		//non-trivially-copyable types have to be copied one at a time
@@ -809,6 +1156,125 @@ public:
 			Reallocate(m_size);
 	}
 
+	////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	// NUMA replication
+
+	/**
+		@brief Enables per-NUMA-node replication of the CPU-side buffer.
+
+		Read-mostly reference data (golden waveforms, coefficient tables) loaded once and consumed by workers
+		pinned across a multi socket machine otherwise lives on whichever node first touched it, and every
+		remote-node reader pays the interconnect on every pass. With replication enabled, GetNumaLocalPointer()
+		hands each reader a copy resident on its own node. Replicas are built lazily, on first access from a
+		node, by the accessing thread itself - so first-touch placement puts the pages on the right node with
+		no libnuma dependency - and cost one extra copy of the buffer per node that actually reads it.
+
+		Replicas are snapshots of the primary CPU-side buffer, invalidated by MarkModifiedFromCpu/Gpu() and
+		rebuilt on the next access. Writers must finish (including PrepareForCpuAccess() after a GPU-side
+		write) before readers call GetNumaLocalPointer(); as with the GPU mirroring machinery, in-place element
+		writes that skip the MarkModified calls are invisible to it.
+
+		No-op on single node machines: GetNumaLocalPointer() just returns the primary buffer.
+	 */
+	void EnableNumaReplication()
+	{
+		if(!m_numaReplicas && (GetNumaNodeCount() > 1))
+			m_numaReplicas = std::make_unique<NumaReplicaSet>();
+	}
+
+	///@brief Disables per-node replication and frees all replicas
+	void DisableNumaReplication()
+	{ m_numaReplicas = nullptr; }
+
+	///@brief Returns true if per-node replication is active
+	bool IsNumaReplicationEnabled() const
+	{ return m_numaReplicas != nullptr; }
+
+	/**
+		@brief Returns a read-only pointer to a copy of the buffer local to the calling thread's NUMA node.
+
+		Falls back to the primary CPU buffer if replication is not active. The buffer must be valid CPU side
+		(PrepareForCpuAccess()) before calling. The returned pointer is only good until the next modification,
+		reallocation, or DisableNumaReplication(); it takes a short lock, so fetch it once per pass rather
+		than per element.
+	 */
+	const T* GetNumaLocalPointer()
+	{
+		if(!m_numaReplicas)
+			return m_cpuPtr;
+
+		size_t node = GetCurrentNumaNode();
+
+		std::lock_guard<std::mutex> lock(m_numaReplicas->m_lock);
+		auto& reps = m_numaReplicas->m_replicas;
+		if(reps.size() <= node)
+			reps.resize(node + 1);
+
+		//(Re)build the replica if missing or stale. We're running on the target node,
+		//so first-touch places the new pages locally.
+		uint64_t version = m_numaReplicas->m_version;
+		auto& rep = reps[node];
+		if( (rep.m_version != version) || (rep.m_size != m_size) )
+		{
+			if(rep.m_size != m_size)
+			{
+				rep.m_data = std::unique_ptr<T[]>(new T[m_size]);
+				rep.m_size = m_size;
+			}
+			std::copy(m_cpuPtr, m_cpuPtr + m_size, rep.m_data.get());
+			rep.m_version = version;
+		}
+		return rep.m_data.get();
+	}
+
+protected:
+
+	///@brief One per-node copy of the buffer contents
+	struct NumaReplica
+	{
+		NumaReplica()
+			: m_version(0)
+			, m_size(0)
+		{}
+
+		///@brief Version of the primary copy this replica was made from (0 = not built yet)
+		uint64_t m_version;
+
+		///@brief Number of elements
+		size_t m_size;
+
+		///@brief The copied elements
+		std::unique_ptr<T[]> m_data;
+	};
+
+	///@brief Per-node replicas of the CPU-side buffer (only allocated while replication is active)
+	struct NumaReplicaSet
+	{
+		NumaReplicaSet()
+			: m_version(1)
+		{}
+
+		///@brief Content version of the primary copy, bumped on every modification
+		std::atomic<uint64_t> m_version;
+
+		///@brief Guards m_replicas
+		std::mutex m_lock;
+
+		///@brief Replica per node (index = NUMA node)
+		std::vector<NumaReplica> m_replicas;
+	};
+
+	std::unique_ptr<NumaReplicaSet> m_numaReplicas;
+
+	///@brief Marks all per-node replicas as stale
+	void InvalidateNumaReplicas()
+	{
+		if(m_numaReplicas)
+			m_numaReplicas->m_version++;
+	}
+
+public:
+
 	////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 	// Cache invalidation
 
@@ -819,8 +1285,45 @@ public:
 	 */
 	void MarkModifiedFromCpu()
 	{
+		InvalidateNumaReplicas();
+
 		if(!m_buffersAreSame)
+		{
+			m_gpuPhysMemIsStale = true;
+			m_gpuStaleStart = 0;
+			m_gpuStaleEnd = SIZE_MAX;
+		}
+	}
+
+	/**
+		@brief Marks a range of the CPU-side copy of the buffer as modified.
+
+		Incremental writers (appending to a history waveform, accumulating into a density plot, etc.) should use this
+		rather than the whole-buffer overload so the next PrepareForGpuAccess() only transfers the elements that
+		actually changed. Ranges from successive calls are coalesced into a single span covering all of them.
+
+		@param offset	Index of the first modified element
+		@param len		Number of modified elements
+	 */
+	void MarkModifiedFromCpu(size_t offset, size_t len)
+	{
+		InvalidateNumaReplicas();
+
+		if(m_buffersAreSame)
+			return;
+
+		if(m_gpuPhysMemIsStale)
+		{
+			m_gpuStaleStart = std::min(m_gpuStaleStart, offset);
+			if(m_gpuStaleEnd != SIZE_MAX)
+				m_gpuStaleEnd = std::max(m_gpuStaleEnd, offset + len);
+		}
+		else
+		{
 			m_gpuPhysMemIsStale = true;
+			m_gpuStaleStart = offset;
+			m_gpuStaleEnd = offset + len;
+		}
 	}
 
 	/**
@@ -830,8 +1333,44 @@ public:
 	 */
 	void MarkModifiedFromGpu()
 	{
+		InvalidateNumaReplicas();
+
 		if(!m_buffersAreSame)
+		{
 			m_cpuPhysMemIsStale = true;
+			m_cpuStaleStart = 0;
+			m_cpuStaleEnd = SIZE_MAX;
+		}
+	}
+
+	/**
+		@brief Marks a range of the GPU-side copy of the buffer as modified.
+
+		See MarkModifiedFromCpu(size_t, size_t); this is the mirror image for shaders which only write part of the
+		buffer. Ranges from successive calls are coalesced into a single span covering all of them.
+
+		@param offset	Index of the first modified element
+		@param len		Number of modified elements
+	 */
+	void MarkModifiedFromGpu(size_t offset, size_t len)
+	{
+		InvalidateNumaReplicas();
+
+		if(m_buffersAreSame)
+			return;
+
+		if(m_cpuPhysMemIsStale)
+		{
+			m_cpuStaleStart = std::min(m_cpuStaleStart, offset);
+			if(m_cpuStaleEnd != SIZE_MAX)
+				m_cpuStaleEnd = std::max(m_cpuStaleEnd, offset + len);
+		}
+		else
+		{
+			m_cpuPhysMemIsStale = true;
+			m_cpuStaleStart = offset;
+			m_cpuStaleEnd = offset + len;
+		}
 	}
 
 	////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -853,7 +1392,74 @@ public:
 			AllocateCpuBuffer(m_capacity);
 
 		if(m_cpuPhysMemIsStale)
+		{
+			//The incoming copy would overwrite shared storage, so detach first
+			//(no wasted work: stale content is never copied during reallocation)
+			Detach();
 			CopyToCpu();
+		}
+	}
+
+	/**
+		@brief Prepares the buffer to be accessed from the CPU, deferring any needed copy to the supplied batch.
+
+		The CPU-side buffer must not be accessed until the batch has been flushed.
+	 */
+	void PrepareForCpuAccessBatched(VulkanTransferBatch& batch)
+	{
+		//Early out if no content
+		if(m_size == 0)
+			return;
+
+		//If there's no buffer at all on the CPU, allocate one
+		if(!HasCpuBuffer() && (m_gpuMemoryType != MEM_TYPE_GPU_DMA_CAPABLE))
+			AllocateCpuBuffer(m_capacity);
+
+		if(m_cpuPhysMemIsStale)
+		{
+			//The incoming copy would overwrite shared storage, so detach first
+			//(no wasted work: stale content is never copied during reallocation)
+			Detach();
+
+			//Copy only the stale region (clamped to the live size of the buffer)
+			size_t start = m_cpuStaleStart;
+			size_t end = std::min(m_cpuStaleEnd, m_size);
+			if(start >= end)
+				m_cpuPhysMemIsStale = false;
+			else
+			{
+				static PerfCounter& s_bytesToCpu = g_perfCounters.GetCounter("gpu.bytes_to_cpu", "bytes");
+				s_bytesToCpu.Add((end - start) * sizeof(T));
+
+				batch.AddCopy(
+					**m_gpuBuffer,
+					**GetCpuVkBuffer(),
+					(end - start) * sizeof(T),
+					&m_cpuPhysMemIsStale,
+					start * sizeof(T));
+			}
+		}
+	}
+
+	/**
+		@brief Starts an asynchronous copy of stale content back to the CPU-side buffer.
+
+		The copy runs on a background transfer thread; the returned future becomes ready once the CPU mirror is
+		up to date (it is already ready if there was nothing to copy). The caller must not resize, write to, or
+		otherwise mutate the buffer until the future is ready. Once it is, PrepareForCpuAccess() is free since
+		the mirror is no longer stale, so existing consumer code needs no changes beyond waiting on the future.
+	 */
+	std::future<void> PrepareForCpuAccessAsync()
+	{
+		//Nothing to copy: hand back an already-satisfied future
+		if( (m_size == 0) || !m_cpuPhysMemIsStale)
+		{
+			std::promise<void> p;
+			p.set_value();
+			return p.get_future();
+		}
+
+		return DispatchAsyncTransfer([this]{ PrepareForCpuAccess(); });
 	}
 
 	/**
@@ -883,6 +1489,52 @@ public:
 			CopyToGpu();
 	}
 
+	/**
+		@brief Prepares the buffer to be accessed from the GPU, deferring any needed copy to the supplied batch.
+
+		The GPU-side buffer must not be accessed until the batch has been flushed.
+
+		@param batch		Batch to append any needed host-to-device copy to
+		@param outputOnly	True if the buffer is output-only for the shader, so there's no need to copy anything
+							to the GPU even if data is stale.
+	 */
+	void PrepareForGpuAccessBatched(VulkanTransferBatch& batch, bool outputOnly = false)
+	{
+		//Early out if no content or if unified memory
+		if(m_size == 0 || g_vulkanDeviceHasUnifiedMemory)
+			return;
+
+		//If our current hint has no GPU access at all, update to say "unlikely" and reallocate
+		if(m_gpuAccessHint == HINT_NEVER)
+			SetGpuAccessHint(HINT_UNLIKELY, true);
+
+		//If we don't have a buffer, allocate one unless our CPU buffer is pinned and GPU-readable
+		if(!HasGpuBuffer() && (m_cpuMemoryType != MEM_TYPE_CPU_DMA_CAPABLE) )
+			AllocateGpuBuffer(m_capacity);
+
+		//Make sure the GPU-side buffer is up to date
+		if(m_gpuPhysMemIsStale && !outputOnly)
+		{
+			//Copy only the stale region (clamped to the live size of the buffer)
+			size_t start = m_gpuStaleStart;
+			size_t end = std::min(m_gpuStaleEnd, m_size);
+			if(start >= end)
+				m_gpuPhysMemIsStale = false;
+			else
+			{
+				static PerfCounter& s_bytesToGpu = g_perfCounters.GetCounter("gpu.bytes_to_gpu", "bytes");
+				s_bytesToGpu.Add((end - start) * sizeof(T));
+
+				batch.AddCopy(
+					**GetCpuVkBuffer(),
+					**m_gpuBuffer,
+					(end - start) * sizeof(T),
+					&m_gpuPhysMemIsStale,
+					start * sizeof(T));
+			}
+		}
+	}
+
 	/**
 		@brief Prepares the buffer to be accessed from the GPU
 
@@ -917,17 +1569,33 @@ protected:
 
 	/**
 		@brief Copy the buffer contents from GPU to CPU and blocks until the transfer completes.
+
+		Only the stale region of the buffer is transferred.
 	 */
 	void CopyToCpu()
 	{
 		assert(std::is_trivially_copyable<T>::value);
 
+		size_t start = m_cpuStaleStart;
+		size_t end = std::min(m_cpuStaleEnd, m_size);
+
+		//The stale region may be entirely beyond the live size of the buffer (e.g. after shrinking),
+		//in which case there's nothing to copy
+		if(start >= end)
+		{
+			m_cpuPhysMemIsStale = false;
+			return;
+		}
+
+		static PerfCounter& s_bytesToCpu = g_perfCounters.GetCounter("gpu.bytes_to_cpu", "bytes");
+		s_bytesToCpu.Add((end - start) * sizeof(T));
+
 		std::lock_guard<std::mutex> lock(g_vkTransferMutex);
 
 		//Make the transfer request
 		g_vkTransferCommandBuffer->begin({});
-		vk::BufferCopy region(0, 0, m_size * sizeof(T));
-		g_vkTransferCommandBuffer->copyBuffer(**m_gpuBuffer, **m_cpuBuffer, {region});
+		vk::BufferCopy region(start * sizeof(T), start * sizeof(T), (end - start) * sizeof(T));
+		g_vkTransferCommandBuffer->copyBuffer(**m_gpuBuffer, **GetCpuVkBuffer(), {region});
 		g_vkTransferCommandBuffer->end();
 
 		//Submit the request and block until it completes
@@ -938,17 +1606,30 @@ protected:
 
 	/**
 		@brief Copy the buffer contents from CPU to GPU and blocks until the transfer completes.
+
+		Only the stale region of the buffer is transferred.
 	 */
 	void CopyToGpu()
 	{
 		assert(std::is_trivially_copyable<T>::value);
 
+		size_t start = m_gpuStaleStart;
+		size_t end = std::min(m_gpuStaleEnd, m_size);
+		if(start >= end)
+		{
+			m_gpuPhysMemIsStale = false;
+			return;
+		}
+
+		static PerfCounter& s_bytesToGpu = g_perfCounters.GetCounter("gpu.bytes_to_gpu", "bytes");
+		s_bytesToGpu.Add((end - start) * sizeof(T));
+
 		std::lock_guard<std::mutex> lock(g_vkTransferMutex);
 
 		//Make the transfer request
 		g_vkTransferCommandBuffer->begin({});
-		vk::BufferCopy region(0, 0, m_size * sizeof(T));
-		g_vkTransferCommandBuffer->copyBuffer(**m_cpuBuffer, **m_gpuBuffer, {region});
+		vk::BufferCopy region(start * sizeof(T), start * sizeof(T), (end - start) * sizeof(T));
+		g_vkTransferCommandBuffer->copyBuffer(**GetCpuVkBuffer(), **m_gpuBuffer, {region});
 		g_vkTransferCommandBuffer->end();
 
 		//Submit the request and block until it completes
@@ -961,15 +1642,27 @@ protected:
 	/**
 		@brief Copy the buffer contents from CPU to GPU without blocking on the CPU.
 
+		Only the stale region of the buffer is transferred.
 		Inserts a memory barrier to ensure that GPU-side access is synchronized.
 	 */
 	void CopyToGpuNonblocking(vk::raii::CommandBuffer& cmdBuf)
 	{
 		assert(std::is_trivially_copyable<T>::value);
 
+		size_t start = m_gpuStaleStart;
+		size_t end = std::min(m_gpuStaleEnd, m_size);
+		if(start >= end)
+		{
+			m_gpuPhysMemIsStale = false;
+			return;
+		}
+
+		static PerfCounter& s_bytesToGpu = g_perfCounters.GetCounter("gpu.bytes_to_gpu", "bytes");
+		s_bytesToGpu.Add((end - start) * sizeof(T));
+
 		//Make the transfer request
-		vk::BufferCopy region(0, 0, m_size * sizeof(T));
-		cmdBuf.copyBuffer(**m_cpuBuffer, **m_gpuBuffer, {region});
+		vk::BufferCopy region(start * sizeof(T), start * sizeof(T), (end - start) * sizeof(T));
+		cmdBuf.copyBuffer(**GetCpuVkBuffer(), **m_gpuBuffer, {region});
 
 		//Add the barrier
 		cmdBuf.pipelineBarrier(
@@ -1024,8 +1717,14 @@ protected:
 		//Free the Vulkan buffer object
 		m_cpuBuffer = nullptr;
 
+		//If the storage is shared we don't own it; just drop our reference
+		//(the last instance to let go frees it)
+		if(m_sharedStorage)
+			m_sharedStorage = nullptr;
+
 		//Free the buffer and unmap any memory
-		FreeCpuPointer(m_cpuPtr, m_cpuPhysMem, m_cpuMemoryType, m_capacity);
+		else
+			FreeCpuPointer(m_cpuPtr, m_cpuPhysMem, m_cpuMemoryType, m_capacity);
 
 		//Mark CPU-side buffer as empty
 		m_cpuPtr = nullptr;
@@ -1089,13 +1788,11 @@ protected:
 			//(may be rounded up from what we asked for)
 			auto req = m_cpuBuffer->getMemoryRequirements();
 
-			//Allocate the physical memory to back the buffer
-			vk::MemoryAllocateInfo info(req.size, g_vkPinnedMemoryType);
-			m_cpuPhysMem = std::make_unique<vk::raii::DeviceMemory>(*g_vkComputeDevice, info);
-
-			//Map it and bind to the buffer
-			m_cpuPtr = reinterpret_cast<T*>(m_cpuPhysMem->mapMemory(0, req.size));
-			m_cpuBuffer->bindMemory(**m_cpuPhysMem, 0);
+			//Sub-allocate the physical memory to back the buffer
+			//(the arena's slabs are persistently mapped, so no mapMemory call is needed here)
+			m_cpuPhysMem = g_vkPinnedMemoryArena->Allocate(req.size, req.alignment);
+			m_cpuPtr = reinterpret_cast<T*>(m_cpuPhysMem->GetMappedPtr());
+			m_cpuBuffer->bindMemory(m_cpuPhysMem->GetMemory(), m_cpuPhysMem->GetOffset());
 
 			//We now have pinned memory
 			m_cpuMemoryType = MEM_TYPE_CPU_DMA_CAPABLE;
@@ -1110,6 +1807,7 @@ protected:
 			m_cpuBuffer = nullptr;
 			m_cpuMemoryType = MEM_TYPE_CPU_ONLY;
 			m_cpuPtr = m_cpuAllocator.allocate(size);
+			g_cpuOnlyBufferBytes += size * sizeof(T);
 		}
 
 		//If infrequent CPU access is expected, use a memory mapped temporary file so it can be paged out to disk
@@ -1122,6 +1820,7 @@ protected:
 				m_cpuBuffer = nullptr;
 				m_cpuMemoryType = MEM_TYPE_CPU_ONLY;
 				m_cpuPtr = m_cpuAllocator.allocate(size);
+				g_cpuOnlyBufferBytes += size * sizeof(T);
 
 			#else
 
@@ -1161,6 +1860,14 @@ protected:
 				}
 				m_cpuMemoryType = MEM_TYPE_CPU_PAGED;
 
+				//Ask for hugepage backing on big mappings, matching the AlignedAllocator policy.
+				//This only has effect when /tmp is a tmpfs with shmem THP enabled, and is harmlessly
+				//ignored everywhere else.
+				#ifdef MADV_HUGEPAGE
+					if(bytesize >= AlignedAllocator<T, 32>::HUGEPAGE_THRESHOLD)
+						madvise(m_cpuPtr, bytesize, MADV_HUGEPAGE);
+				#endif
+
 				//Delete it (file will be removed by the OS after our active handle is closed)
 				if(0 != unlink(fname))
 					LogWarning("Failed to unlink temporary file %s, file will remain after application terminates\n", fname);
@@ -1201,7 +1908,7 @@ protected:
 				break;
 
 			case MEM_TYPE_CPU_DMA_CAPABLE:
-				LogFatal("FreeCpuPointer for MEM_TYPE_CPU_DMA_CAPABLE requires the vk::raii::DeviceMemory\n");
+				LogFatal("FreeCpuPointer for MEM_TYPE_CPU_DMA_CAPABLE requires the VulkanMemoryArena::Block\n");
 				break;
 
 			case MEM_TYPE_CPU_PAGED:
@@ -1214,6 +1921,7 @@ protected:
 
 			case MEM_TYPE_CPU_ONLY:
 				m_cpuAllocator.deallocate(ptr, size);
+				g_cpuOnlyBufferBytes -= size * sizeof(T);
 				break;
 
 			default:
@@ -1229,12 +1937,13 @@ protected:
 		not the one we're getting rid of.
 	 */
 	__attribute__((noinline))
-	void FreeCpuPointer(T* ptr, std::unique_ptr<vk::raii::DeviceMemory>& buf, MemoryType type, size_t size)
+	void FreeCpuPointer(T* ptr, std::unique_ptr<VulkanMemoryArena::Block>& buf, MemoryType type, size_t size)
 	{
 		switch(type)
 		{
 			case MEM_TYPE_CPU_DMA_CAPABLE:
-				buf->unmapMemory();
+				//Return the block to the arena; the slab it lives in stays mapped
+				buf = nullptr;
 				break;
 
 			default:
@@ -1264,11 +1973,10 @@ protected:
 		auto req = m_gpuBuffer->getMemoryRequirements();
 
 		//For now, always use local memory
-		vk::MemoryAllocateInfo info(req.size, g_vkLocalMemoryType);
-		m_gpuPhysMem = std::make_unique<vk::raii::DeviceMemory>(*g_vkComputeDevice, info);
+		m_gpuPhysMem = g_vkLocalMemoryArena->Allocate(req.size, req.alignment);
 		m_gpuMemoryType = MEM_TYPE_GPU_ONLY;
 
-		m_gpuBuffer->bindMemory(**m_gpuPhysMem, 0);
+		m_gpuBuffer->bindMemory(m_gpuPhysMem->GetMemory(), m_gpuPhysMem->GetOffset());
 
 		if(g_hasDebugUtils)
 			UpdateGpuNames();
@@ -1291,19 +1999,13 @@ protected:
 		std::string prefix = std::string("AcceleratorBuffer.") + sname + ".";
 
 		std::string gpuBufName = prefix + "m_gpuBuffer";
-		std::string gpuPhysName = prefix + "m_gpuPhysMem";
 
+		//(physical memory is an arena slab shared with other buffers, and is named by the arena)
 		g_vkComputeDevice->setDebugUtilsObjectNameEXT(
 			vk::DebugUtilsObjectNameInfoEXT(
 				vk::ObjectType::eBuffer,
 				reinterpret_cast<uint64_t>(static_cast<VkBuffer>(**m_gpuBuffer)),
 				gpuBufName.c_str()));
-
-		g_vkComputeDevice->setDebugUtilsObjectNameEXT(
-			vk::DebugUtilsObjectNameInfoEXT(
-				vk::ObjectType::eDeviceMemory,
-				reinterpret_cast<uint64_t>(static_cast<VkDeviceMemory>(**m_gpuPhysMem)),
-				gpuPhysName.c_str()));
 	}
 
 	/**
@@ -1318,19 +2020,13 @@ protected:
 		std::string prefix = std::string("AcceleratorBuffer.") + sname + ".";
 
 		std::string cpuBufName = prefix + "m_cpuBuffer";
-		std::string cpuPhysName = prefix + "m_cpuPhysMem";
 
+		//(physical memory is an arena slab shared with other buffers, and is named by the arena)
 		g_vkComputeDevice->setDebugUtilsObjectNameEXT(
 			vk::DebugUtilsObjectNameInfoEXT(
 				vk::ObjectType::eBuffer,
 				reinterpret_cast<uint64_t>(static_cast<VkBuffer>(**m_cpuBuffer)),
 				cpuBufName.c_str()));
-
-		g_vkComputeDevice->setDebugUtilsObjectNameEXT(
-			vk::DebugUtilsObjectNameInfoEXT(
-				vk::ObjectType::eDeviceMemory,
-				reinterpret_cast<uint64_t>(static_cast<VkDeviceMemory>(**m_cpuPhysMem)),
-				cpuPhysName.c_str()));
 	}
 
 public:
@@ -38,18 +38,30 @@
 
 #ifdef _WIN32
 #include <windows.h>
+#else
+#include <sys/mman.h>
 #endif
 
 /**
 	@brief Aligned memory allocator for STL containers
 
 	Based on https://devblogs.microsoft.com/cppblog/the-mallocator/
+
+	Allocations of HUGEPAGE_THRESHOLD bytes or more get their own anonymous mapping, rounded up to a whole number
+	of 2MB hugepages and flagged for transparent hugepage backing. This cuts TLB pressure substantially when
+	filters stream through multi-megasample waveforms, and keeps big waveform buffers out of the middle of the
+	malloc heap. Since the mapping is anonymous, pages are physically placed on first touch: combined with the
+	NUMA-aware worker pinning in FilterGraphExecutor, a buffer ends up on the memory node local to the worker
+	thread that filled it.
  */
 template <class T, size_t alignment>
 class AlignedAllocator
 {
 public:
 
+	///@brief Allocations at least this large (in bytes, after rounding) are backed by whole 2MB hugepages
+	static const size_t HUGEPAGE_THRESHOLD = 2 * 1024 * 1024;
+
 	//Standard typedefs
 	typedef T* pointer;
 	typedef const T* const_pointer;
@@ -126,7 +138,30 @@ public:
 #ifdef _WIN32
 		T* ret = static_cast<T*>(_aligned_malloc(n*sizeof(T), alignment));
 #else
-		T* ret = static_cast<T*>(aligned_alloc(alignment, n*sizeof(T)));
+		T* ret;
+		size_t bytes = n * sizeof(T);
+		if(bytes >= HUGEPAGE_THRESHOLD)
+		{
+			//mmap returns page aligned addresses, which satisfies any alignment we're instantiated with
+			void* p = mmap(
+				nullptr,
+				RoundUpToHugePage(bytes),
+				PROT_READ | PROT_WRITE,
+				MAP_PRIVATE | MAP_ANONYMOUS,
+				-1,
+				0);
+			if(p == MAP_FAILED)
+				throw std::bad_alloc();
+
+			//Ask for hugepage backing (advisory; if THP is unavailable we just get normal pages)
+			#ifdef MADV_HUGEPAGE
+				madvise(p, RoundUpToHugePage(bytes), MADV_HUGEPAGE);
+			#endif
+
+			ret = static_cast<T*>(p);
+		}
+		else
+			ret = static_cast<T*>(aligned_alloc(alignment, bytes));
 #endif
 
 		//Error check
@@ -136,19 +171,28 @@ public:
 		return ret;
 	}
 
-	void deallocate(T* const p, const size_t /*unused*/) const
+	void deallocate(T* const p, const size_t n) const
 	{
 #ifdef _WIN32
+		(void)n;
 		_aligned_free(p);
 #else
-		free(p);
+		//Redo the same size rounding allocate() did, so we know which path created this block
+		size_t count = n;
+		if( (count % alignment) != 0)
+		{
+			count |= (alignment - 1);
+			count ++;
+		}
+
+		size_t bytes = count * sizeof(T);
+		if(bytes >= HUGEPAGE_THRESHOLD)
+			munmap(p, RoundUpToHugePage(bytes));
+		else
+			free(p);
 #endif
 	}
 
-	//convenience wrapper
-	void deallocate(T* const p) const
-	{ deallocate(p, 1); }
-
 	//Not quite sure what this is for but apparently we need it?
 	template<typename U>
 	T* allocate(const size_t n, const U* /* const hint */ const)
@@ -156,6 +200,12 @@ public:
 
 	//Disallow assignment
 	AlignedAllocator& operator=(const AlignedAllocator&) = delete;
+
+protected:
+
+	///@brief Rounds a byte count up to a whole number of 2MB hugepages
+	static size_t RoundUpToHugePage(size_t bytes)
+	{ return (bytes + HUGEPAGE_THRESHOLD - 1) & ~(HUGEPAGE_THRESHOLD - 1); }
 };
 
 #endif
@@ -30,8 +30,19 @@
 #include "../scopehal/scopehal.h"
 #include "PipelineCacheManager.h"
 
+#include <glslang_c_interface.h>
+#include <glslang/Public/resource_limits_c.h>
+
+#include <atomic>
+#include <set>
+#include <sstream>
+
 using namespace std;
 
+bool ComputePipeline::s_gpuTimingRequested = false;
+uint32_t ComputePipeline::s_tunedWorkgroupSize = 0;
+uint32_t ComputePipeline::s_tunedUnrollFactor = 0;
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Construction / destruction
 
@@ -46,11 +57,16 @@ ComputePipeline::ComputePipeline(
 	, m_numStorageImages(numStorageImages)
 	, m_numSampledImages(numSampledImages)
 	, m_pushConstantSize(pushConstantSize)
+	, m_descriptorsDirty(true)
+	, m_pendingTimestampQueries(0)
+	, m_timestampActive(false)
 {
 	m_writeDescriptors.resize(numSSBOs + numStorageImages + numSampledImages);
 	m_bufferInfo.resize(numSSBOs);
 	m_storageImageInfo.resize(numStorageImages);
 	m_sampledImageInfo.resize(numSampledImages);
+
+	RecordForWarmup();
 }
 
 void ComputePipeline::Reinitialize(
@@ -62,6 +78,7 @@ void ComputePipeline::Reinitialize(
 {
 	//Copy paths
 	m_shaderPath = shaderPath;
+	m_spirv.clear();
 	m_numSSBOs = numSSBOs;
 	m_numStorageImages = numStorageImages;
 	m_numSampledImages = numSampledImages;
@@ -73,6 +90,80 @@ void ComputePipeline::Reinitialize(
 	m_storageImageInfo.resize(numStorageImages);
 	m_sampledImageInfo.resize(numSampledImages);
 
+	//Cached descriptors referenced the old pipeline state, so forget the bindings entirely
+	//(a pointer-equal rebind must not be treated as a cache hit against the new descriptor set)
+	m_descriptorsDirty = true;
+	std::fill(m_bufferInfo.begin(), m_bufferInfo.end(), vk::DescriptorBufferInfo());
+	std::fill(m_storageImageInfo.begin(), m_storageImageInfo.end(), vk::DescriptorImageInfo());
+	std::fill(m_sampledImageInfo.begin(), m_sampledImageInfo.end(), vk::DescriptorImageInfo());
+
+	//Clear all of our deferred state
+	m_computePipeline = nullptr;
+	m_descriptorSetLayout = nullptr;
+	m_pipelineLayout = nullptr;
+	m_shaderModule = nullptr;
+
+	RecordForWarmup();
+}
+
+/**
+	@brief Reinitializes the pipeline from runtime-generated SPIR-V rather than a shader file on disk
+
+	The name is used for pipeline cache and debug object naming, so it should be unique per generated shader
+	(e.g. include a hash of the source it was compiled from). Generated shaders are not recorded for warmup,
+	since there's no path to recompile them from on the next run.
+ */
+void ComputePipeline::ReinitializeFromSpirv(
+	const string& name,
+	vector<uint32_t>&& spirv,
+	size_t numSSBOs,
+	size_t pushConstantSize)
+{
+	m_shaderPath = name;
+	m_spirv = std::move(spirv);
+	m_numSSBOs = numSSBOs;
+	m_numStorageImages = 0;
+	m_numSampledImages = 0;
+	m_pushConstantSize = pushConstantSize;
+
+	//Resize arrays
+	m_writeDescriptors.resize(numSSBOs);
+	m_bufferInfo.resize(numSSBOs);
+	m_storageImageInfo.clear();
+	m_sampledImageInfo.clear();
+
+	//Cached descriptors referenced the old pipeline state, so forget the bindings entirely
+	m_descriptorsDirty = true;
+	std::fill(m_bufferInfo.begin(), m_bufferInfo.end(), vk::DescriptorBufferInfo());
+
+	//Clear all of our deferred state
+	m_computePipeline = nullptr;
+	m_descriptorSetLayout = nullptr;
+	m_pipelineLayout = nullptr;
+	m_shaderModule = nullptr;
+}
+
+/**
+	@brief Sets the specialization constant values used when the pipeline is (re)created
+
+	Constants map to IDs 0...N-1 in order. By convention ID 0 is the workgroup width, for shaders that declare
+	local_size_x_id = 0; any remaining IDs are shader specific (unroll factors and the like).
+
+	If the pipeline has already been created it's destroyed and lazily rebuilt with the new constants on next
+	use, so variants can be switched at runtime without recompiling any SPIR-V.
+ */
+void ComputePipeline::SetSpecializationConstants(const vector<uint32_t>& constants)
+{
+	if(m_specConstants == constants)
+		return;
+	m_specConstants = constants;
+
+	//Cached descriptors referenced the old pipeline state, so forget the bindings entirely
+	m_descriptorsDirty = true;
+	std::fill(m_bufferInfo.begin(), m_bufferInfo.end(), vk::DescriptorBufferInfo());
+	std::fill(m_storageImageInfo.begin(), m_storageImageInfo.end(), vk::DescriptorImageInfo());
+	std::fill(m_sampledImageInfo.begin(), m_sampledImageInfo.end(), vk::DescriptorImageInfo());
+
 	//Clear all of our deferred state
 	m_computePipeline = nullptr;
 	m_descriptorSetLayout = nullptr;
@@ -90,17 +181,358 @@ ComputePipeline::~ComputePipeline()
 	m_shaderModule = nullptr;
 }
 
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Pipeline warmup
+
+///@brief Serialized pipeline configurations ("path;ssbos;push;storageimages;sampledimages") seen so far this run
+static set<string> g_warmupEntries;
+
+///@brief Mutex protecting g_warmupEntries
+static mutex g_warmupMutex;
+
+///@brief Key the usage list is stored under in the pipeline cache
+static const char* g_warmupCacheKey = "pipelineUsage";
+
+/**
+	@brief Records this pipeline's configuration in the persisted usage list
+
+	The next run can then compile it up front in WarmupAllPipelines() rather than stalling the filter graph
+	the first time the owning filter refreshes.
+ */
+void ComputePipeline::RecordForWarmup()
+{
+	//Too early in startup (or a unit test without Vulkan): nowhere to record to
+	if(!g_pipelineCacheMgr)
+		return;
+
+	//Placeholder pipeline with no shader attached yet: nothing to record
+	if(m_shaderPath.empty())
+		return;
+
+	char tmp[1024];
+	snprintf(tmp, sizeof(tmp), "%s;%zu;%zu;%zu;%zu",
+		m_shaderPath.c_str(), m_numSSBOs, m_pushConstantSize, m_numStorageImages, m_numSampledImages);
+
+	lock_guard<mutex> lock(g_warmupMutex);
+
+	//Already known? Nothing to do
+	if(!g_warmupEntries.emplace(tmp).second)
+		return;
+
+	//New configuration: re-serialize the list so it gets persisted with the rest of the cache
+	string blob;
+	for(auto& e : g_warmupEntries)
+		blob += e + "\n";
+	g_pipelineCacheMgr->StoreRaw(g_warmupCacheKey, make_shared< vector<uint8_t> >(blob.begin(), blob.end()));
+}
+
+/**
+	@brief Builds every pipeline configuration recorded by previous runs, in parallel on a worker pool
+
+	Intended to be called right after Vulkan initialization finishes, so driver shader compilation overlaps
+	instrument connection and the first Refresh of each filter finds everything already in the cache. Safe to
+	skip entirely; it's purely a cache-priming optimization.
+ */
+void ComputePipeline::WarmupAllPipelines()
+{
+	if(!g_pipelineCacheMgr)
+		return;
+	auto blob = g_pipelineCacheMgr->LookupRaw(g_warmupCacheKey);
+	if(!blob)
+		return;
+
+	//Parse the usage list saved by the last run
+	struct WarmupEntry
+	{
+		string m_path;
+		size_t m_numSSBOs;
+		size_t m_pushConstantSize;
+		size_t m_numStorageImages;
+		size_t m_numSampledImages;
+	};
+	vector<WarmupEntry> entries;
+	stringstream ss(string(blob->begin(), blob->end()));
+	string line;
+	while(getline(ss, line))
+	{
+		auto isplit = line.find(';');
+		if(isplit == string::npos)
+			continue;
+
+		WarmupEntry e;
+		e.m_path = line.substr(0, isplit);
+		if(4 != sscanf(line.c_str() + isplit, ";%zu;%zu;%zu;%zu",
+			&e.m_numSSBOs, &e.m_pushConstantSize, &e.m_numStorageImages, &e.m_numSampledImages))
+		{
+			continue;
+		}
+
+		//Shader may have been removed or renamed since the list was saved
+		if(FindDataFile(e.m_path).empty())
+			continue;
+
+		entries.push_back(e);
+
+		//Seed the in-memory list so re-registration by live filters doesn't thrash the stored blob
+		lock_guard<mutex> lock(g_warmupMutex);
+		g_warmupEntries.emplace(line);
+	}
+	if(entries.empty())
+		return;
+
+	LogTrace("Warming up %zu compute pipelines\n", entries.size());
+
+	//Build everything concurrently: pipeline creation is where the driver does its heavy compilation, and
+	//VkDevice and VkPipelineCache are internally synchronized for creation calls, so this scales with cores.
+	//The throwaway pipelines populate our per-shader cache objects and the driver's own caches; the real
+	//instances owned by filters then initialize as fast cache hits.
+	atomic<size_t> nextEntry(0);
+	size_t numThreads = min<size_t>(thread::hardware_concurrency(), entries.size());
+	vector<thread> threads;
+	for(size_t i=0; i<numThreads; i++)
+	{
+		threads.emplace_back([&entries, &nextEntry]
+		{
+			while(true)
+			{
+				size_t j = nextEntry.fetch_add(1);
+				if(j >= entries.size())
+					break;
+
+				auto& e = entries[j];
+				try
+				{
+					ComputePipeline pipe(
+						e.m_path, e.m_numSSBOs, e.m_pushConstantSize, e.m_numStorageImages, e.m_numSampledImages);
+					pipe.DeferredInit();
+				}
+				catch(const exception& err)
+				{
+					LogWarning("Pipeline warmup for %s failed: %s\n", e.m_path.c_str(), err.what());
+				}
+			}
+		});
+	}
+	for(auto& t : threads)
+		t.join();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Runtime shader compilation
+
+/**
+	@brief Compiles GLSL compute shader source to SPIR-V, for pipelines generated at runtime
+
+	glslang is already linked (and its process state initialized by VulkanInit) for other reasons, so runtime
+	compilation costs us nothing in dependencies. Returns false with the compile log printed on any error.
+ */
+bool ComputePipeline::CompileGlsl(const string& source, vector<uint32_t>& spirv)
+{
+	glslang_input_t input = {};
+	input.language = GLSLANG_SOURCE_GLSL;
+	input.stage = GLSLANG_STAGE_COMPUTE;
+	input.client = GLSLANG_CLIENT_VULKAN;
+	input.client_version = GLSLANG_TARGET_VULKAN_1_0;
+	input.target_language = GLSLANG_TARGET_SPV;
+	input.target_language_version = GLSLANG_TARGET_SPV_1_0;
+	input.code = source.c_str();
+	input.default_version = 450;
+	input.default_profile = GLSLANG_NO_PROFILE;
+	input.messages = GLSLANG_MSG_DEFAULT_BIT;
+	input.resource = glslang_default_resource();
+
+	auto shader = glslang_shader_create(&input);
+	if(!glslang_shader_preprocess(shader, &input) || !glslang_shader_parse(shader, &input))
+	{
+		LogError("Failed to compile generated shader:\n%s\n%s\n",
+			glslang_shader_get_info_log(shader),
+			glslang_shader_get_info_debug_log(shader));
+		glslang_shader_delete(shader);
+		return false;
+	}
+
+	auto program = glslang_program_create();
+	glslang_program_add_shader(program, shader);
+	if(!glslang_program_link(program, GLSLANG_MSG_SPV_RULES_BIT | GLSLANG_MSG_VULKAN_RULES_BIT))
+	{
+		LogError("Failed to link generated shader:\n%s\n%s\n",
+			glslang_program_get_info_log(program),
+			glslang_program_get_info_debug_log(program));
+		glslang_program_delete(program);
+		glslang_shader_delete(shader);
+		return false;
+	}
+
+	glslang_program_SPIRV_generate(program, GLSLANG_STAGE_COMPUTE);
+	spirv.resize(glslang_program_SPIRV_get_size(program));
+	glslang_program_SPIRV_get(program, spirv.data());
+
+	glslang_program_delete(program);
+	glslang_shader_delete(shader);
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Per-device workgroup size tuning
+
+///@brief Key the tuning results are stored under in the pipeline cache
+static const char* g_tuneCacheKey = "workgroupTune";
+
+/**
+	@brief Returns the workgroup width to use for elementwise compute shaders on this device
+
+	Falls back to the supplied default if tuning has not run yet (no Vulkan, or AutoTuneWorkgroupSize() was
+	never called).
+ */
+uint32_t ComputePipeline::GetTunedWorkgroupSize(uint32_t defaultSize)
+{
+	if(s_tunedWorkgroupSize != 0)
+		return s_tunedWorkgroupSize;
+	return defaultSize;
+}
+
+///@brief Returns the per-invocation unroll factor selected by AutoTuneWorkgroupSize(), or the supplied default
+uint32_t ComputePipeline::GetTunedUnrollFactor(uint32_t defaultFactor)
+{
+	if(s_tunedUnrollFactor != 0)
+		return s_tunedUnrollFactor;
+	return defaultFactor;
+}
+
+/**
+	@brief Benchmarks workgroup size / unroll factor variants of a synthetic elementwise shader, keeping the winner
+
+	The optimal workgroup width differs significantly between devices (integrated vs discrete, and between
+	vendors), but our shaders are compiled to SPIR-V once at build time. So shaders that opt in declare the
+	workgroup width as a specialization constant, and this picks the value to specialize them with at runtime.
+
+	The winner is persisted through PipelineCacheManager, which discards entries when the device or driver
+	changes, so the benchmark only runs once per device rather than once per launch. Intended to be called from
+	VulkanInit once the pipeline cache manager is up; anything calling GetTunedWorkgroupSize() before that just
+	sees the default.
+ */
+void ComputePipeline::AutoTuneWorkgroupSize()
+{
+	if(!g_pipelineCacheMgr)
+		return;
+
+	//Use the winner from a previous run on this device if we have one
+	auto blob = g_pipelineCacheMgr->LookupRaw(g_tuneCacheKey);
+	if(blob && (blob->size() == 2*sizeof(uint32_t)))
+	{
+		memcpy(&s_tunedWorkgroupSize, blob->data(), sizeof(uint32_t));
+		memcpy(&s_tunedUnrollFactor, blob->data() + sizeof(uint32_t), sizeof(uint32_t));
+		LogTrace("Tuned workgroup size (cached): %u wide, unroll %u\n", s_tunedWorkgroupSize, s_tunedUnrollFactor);
+		return;
+	}
+
+	//Candidate workgroup widths: powers of two up to the device limit
+	auto limits = g_vkComputePhysicalDevice->getProperties().limits;
+	uint32_t maxSize = min(limits.maxComputeWorkGroupInvocations, limits.maxComputeWorkGroupSize[0]);
+	vector<uint32_t> sizes;
+	for(uint32_t s = 32; (s <= 256) && (s <= maxSize); s *= 2)
+		sizes.push_back(s);
+	if(sizes.empty())
+		return;
+	const uint32_t unrolls[] = {1, 2, 4};
+
+	//Synthetic workload: a memory bound multiply-add over a few million samples, the same access pattern as
+	//the bulk of our elementwise shaders
+	const uint32_t npoints = 4 * 1024 * 1024;
+	const int niters = 10;
+	AcceleratorBuffer<float> bufin;
+	AcceleratorBuffer<float> bufout;
+	bufin.SetCpuAccessHint(AcceleratorBuffer<float>::HINT_UNLIKELY);
+	bufin.SetGpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
+	bufout.SetCpuAccessHint(AcceleratorBuffer<float>::HINT_UNLIKELY);
+	bufout.SetGpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
+	bufin.resize(npoints);
+	bufout.resize(npoints);
+
+	auto queue = g_vkQueueManager->GetComputeQueue("ComputePipeline.tune");
+	vk::CommandPoolCreateInfo poolInfo(
+		vk::CommandPoolCreateFlagBits::eTransient | vk::CommandPoolCreateFlagBits::eResetCommandBuffer,
+		queue->m_family );
+	vk::raii::CommandPool pool(*g_vkComputeDevice, poolInfo);
+	vk::CommandBufferAllocateInfo bufinfo(*pool, vk::CommandBufferLevel::ePrimary, 1);
+	vk::raii::CommandBuffer cmdBuf(std::move(vk::raii::CommandBuffers(*g_vkComputeDevice, bufinfo).front()));
+
+	ComputePipeline pipe("shaders/WorkgroupTune.spv", 2, sizeof(uint32_t));
+
+	uint32_t bestSize = 0;
+	uint32_t bestUnroll = 0;
+	double bestTime = -1;
+	for(auto wsize : sizes)
+	{
+		for(auto unroll : unrolls)
+		{
+			pipe.SetSpecializationConstants({wsize, unroll});
+			auto nblocks = GetComputeBlockCount((npoints + unroll - 1) / unroll, wsize);
+
+			//First pass warms up pipeline compilation and GPU clocks; the second is the timed run
+			double dt = 0;
+			for(int pass = 0; pass < 2; pass ++)
+			{
+				cmdBuf.begin({});
+				pipe.BindBuffer(0, bufout, true);
+				pipe.BindBuffer(1, bufin);
+				pipe.Dispatch(cmdBuf, npoints, nblocks);
+				for(int i=1; i<niters; i++)
+				{
+					AddComputeMemoryBarrier(cmdBuf);
+					pipe.DispatchNoRebind(cmdBuf, npoints, nblocks);
+				}
+				cmdBuf.end();
+
+				double start = GetTime();
+				queue->SubmitAndBlock(cmdBuf);
+				dt = GetTime() - start;
+			}
+
+			LogTrace("Workgroup size %3u, unroll %u: %.3f ms\n", wsize, unroll, dt * 1000);
+			if( (bestTime < 0) || (dt < bestTime) )
+			{
+				bestTime = dt;
+				bestSize = wsize;
+				bestUnroll = unroll;
+			}
+		}
+	}
+
+	s_tunedWorkgroupSize = bestSize;
+	s_tunedUnrollFactor = bestUnroll;
+	LogTrace("Tuned workgroup size: %u wide, unroll %u\n", bestSize, bestUnroll);
+
+	//Persist the winner for the next run
+	auto result = make_shared< vector<uint8_t> >(2*sizeof(uint32_t));
+	memcpy(result->data(), &bestSize, sizeof(uint32_t));
+	memcpy(result->data() + sizeof(uint32_t), &bestUnroll, sizeof(uint32_t));
+	g_pipelineCacheMgr->StoreRaw(g_tuneCacheKey, result);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Deferred initialization
+
 void ComputePipeline::DeferredInit()
 {
-	//Look up the pipeline cache to see if we have a binary etc to use
+	//Load the shader source: runtime-generated SPIR-V if we have it, otherwise a .spv file on disk
+	//(whose timestamp invalidates stale cache entries)
 	time_t tstamp = 0;
 	int64_t fs = 0;
-	GetTimestampOfFile(FindDataFile(m_shaderPath), tstamp, fs);
+	vector<uint32_t> srcvec;
+	if(m_spirv.empty())
+	{
+		GetTimestampOfFile(FindDataFile(m_shaderPath), tstamp, fs);
+		srcvec = ReadDataFileUint32(m_shaderPath);
+	}
+	else
+		srcvec = m_spirv;
+
+	//Look up the pipeline cache to see if we have a binary etc to use
 	auto shaderBase = BaseName(m_shaderPath);
 	auto cache = g_pipelineCacheMgr->Lookup(shaderBase, tstamp);
 
 	//Load the shader module
-	auto srcvec = ReadDataFileUint32(m_shaderPath);
 	vk::ShaderModuleCreateInfo info({}, srcvec);
 	m_shaderModule = make_unique<vk::raii::ShaderModule>(*g_vkComputeDevice, info);
 
@@ -146,8 +578,20 @@ void ComputePipeline::DeferredInit()
 		range);
 	m_pipelineLayout = make_unique<vk::raii::PipelineLayout>(*g_vkComputeDevice, linfo);
 
+	//Specialization constants, if any (value i maps to constant ID i, see SetSpecializationConstants)
+	vector<vk::SpecializationMapEntry> specMap;
+	for(size_t i=0; i<m_specConstants.size(); i++)
+		specMap.push_back(vk::SpecializationMapEntry(i, i*sizeof(uint32_t), sizeof(uint32_t)));
+	vk::SpecializationInfo specInfo(
+		specMap.size(), specMap.data(), m_specConstants.size() * sizeof(uint32_t), m_specConstants.data());
+
 	//Make the pipeline
-	vk::PipelineShaderStageCreateInfo stageinfo({}, vk::ShaderStageFlagBits::eCompute, **m_shaderModule, "main");
+	vk::PipelineShaderStageCreateInfo stageinfo(
+		{},
+		vk::ShaderStageFlagBits::eCompute,
+		**m_shaderModule,
+		"main",
+		m_specConstants.empty() ? nullptr : &specInfo);
 	vk::ComputePipelineCreateInfo pinfo({}, stageinfo, **m_pipelineLayout);
 	m_computePipeline = make_unique<vk::raii::Pipeline>(
 		std::move(g_vkComputeDevice->createComputePipelines(*cache, pinfo).front()));
@@ -219,3 +663,77 @@ void ComputePipeline::DeferredInit()
 		}
 	}
 }
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// GPU-side dispatch timing
+
+/**
+	@brief Records the starting timestamp for a dispatch, allocating the query pool if needed
+
+	If the pool is full (more than MAX_TIMED_DISPATCHES dispatches since the last GetGpuTimeAndReset() call),
+	the dispatch is silently left untimed rather than overwriting earlier results.
+ */
+void ComputePipeline::StartTimestampQuery(vk::raii::CommandBuffer& cmdBuf)
+{
+	if(m_pendingTimestampQueries >= MAX_TIMED_DISPATCHES)
+		return;
+
+	//Lazily create the query pool the first time timing is used on this pipeline
+	if(m_queryPool == nullptr)
+	{
+		vk::QueryPoolCreateInfo qinfo({}, vk::QueryType::eTimestamp, 2 * MAX_TIMED_DISPATCHES);
+		m_queryPool = make_unique<vk::raii::QueryPool>(*g_vkComputeDevice, qinfo);
+
+		if(g_hasDebugUtils)
+		{
+			string qpName = string("ComputePipeline.") + BaseName(m_shaderPath) + ".qpool";
+			g_vkComputeDevice->setDebugUtilsObjectNameEXT(
+				vk::DebugUtilsObjectNameInfoEXT(
+					vk::ObjectType::eQueryPool,
+					reinterpret_cast<uint64_t>(static_cast<VkQueryPool>(**m_queryPool)),
+					qpName.c_str()));
+		}
+	}
+
+	//Queries have to be reset on the GPU timeline before reuse
+	cmdBuf.resetQueryPool(**m_queryPool, m_pendingTimestampQueries*2, 2);
+	cmdBuf.writeTimestamp(vk::PipelineStageFlagBits::eTopOfPipe, **m_queryPool, m_pendingTimestampQueries*2);
+	m_timestampActive = true;
+}
+
+///@brief Records the ending timestamp for a dispatch started by StartTimestampQuery()
+void ComputePipeline::EndTimestampQuery(vk::raii::CommandBuffer& cmdBuf)
+{
+	if(!m_timestampActive)
+		return;
+
+	cmdBuf.writeTimestamp(vk::PipelineStageFlagBits::eBottomOfPipe, **m_queryPool, m_pendingTimestampQueries*2 + 1);
+	m_pendingTimestampQueries ++;
+	m_timestampActive = false;
+}
+
+/**
+	@brief Returns the total GPU execution time, in ns, of all timed dispatches since the last call, then resets
+
+	Must only be called after the command buffer containing the dispatches has completed execution
+	(e.g. after QueueHandle::SubmitAndBlock() returns). Returns 0 if no dispatches were timed.
+ */
+int64_t ComputePipeline::GetGpuTimeAndReset()
+{
+	if(m_pendingTimestampQueries == 0)
+		return 0;
+
+	auto result = m_queryPool->getResults<uint64_t>(
+		0,
+		m_pendingTimestampQueries * 2,
+		m_pendingTimestampQueries * 2 * sizeof(uint64_t),
+		sizeof(uint64_t),
+		vk::QueryResultFlagBits::e64 | vk::QueryResultFlagBits::eWait);
+
+	int64_t total = 0;
+	for(uint32_t i=0; i<m_pendingTimestampQueries; i++)
+		total += (result.second[i*2 + 1] - result.second[i*2]) * g_vkTimestampPeriod;
+
+	m_pendingTimestampQueries = 0;
+	return total;
+}
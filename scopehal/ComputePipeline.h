@@ -58,6 +58,35 @@ public:
 		size_t numStorageImages = 0,
 		size_t numSampledImages = 0);
 
+	void ReinitializeFromSpirv(
+		const std::string& name,
+		std::vector<uint32_t>&& spirv,
+		size_t numSSBOs,
+		size_t pushConstantSize);
+
+	static bool CompileGlsl(const std::string& source, std::vector<uint32_t>& spirv);
+
+	static void WarmupAllPipelines();
+
+	static void AutoTuneWorkgroupSize();
+	static uint32_t GetTunedWorkgroupSize(uint32_t defaultSize = 64);
+	static uint32_t GetTunedUnrollFactor(uint32_t defaultFactor = 1);
+
+	void SetSpecializationConstants(const std::vector<uint32_t>& constants);
+
+	/**
+		@brief Returns the workgroup width this pipeline will run with
+
+		Only meaningful for shaders declaring local_size_x_id = 0; for everything else the caller should keep
+		using the size hardcoded in the shader source (which is what the supplied default is for).
+	 */
+	uint32_t GetWorkgroupSize(uint32_t defaultSize = 64) const
+	{
+		if(!m_specConstants.empty())
+			return m_specConstants[0];
+		return defaultSize;
+	}
+
 	/**
 		@brief Binds a buffer to a descriptor slot
 	 */
@@ -69,7 +98,13 @@ public:
 
 		buf.PrepareForGpuAccess(outputOnly);
 
-		m_bufferInfo[i] = buf.GetBufferInfo();
+		//If the buffer identity hasn't changed since the last bind, the cached descriptor is still good
+		auto info = buf.GetBufferInfo();
+		if(info == m_bufferInfo[i])
+			return;
+		m_descriptorsDirty = true;
+
+		m_bufferInfo[i] = info;
 		if(g_hasPushDescriptor)
 		{
 			m_writeDescriptors[i] =
@@ -91,7 +126,11 @@ public:
 			DeferredInit();
 
 		size_t numImage = i - m_numSSBOs;
-		m_storageImageInfo[numImage] = vk::DescriptorImageInfo(sampler, view, layout);
+		vk::DescriptorImageInfo info(sampler, view, layout);
+		if(info == m_storageImageInfo[numImage])
+			return;
+		m_descriptorsDirty = true;
+		m_storageImageInfo[numImage] = info;
 
 		if(g_hasPushDescriptor)
 		{
@@ -114,7 +153,11 @@ public:
 			DeferredInit();
 
 		size_t numImage = i - (m_numSSBOs + m_numStorageImages);
-		m_sampledImageInfo[numImage] = vk::DescriptorImageInfo(sampler, view, layout);
+		vk::DescriptorImageInfo info(sampler, view, layout);
+		if(info == m_sampledImageInfo[numImage])
+			return;
+		m_descriptorsDirty = true;
+		m_sampledImageInfo[numImage] = info;
 
 		if(g_hasPushDescriptor)
 		{
@@ -145,7 +188,13 @@ public:
 
 		buf.PrepareForGpuAccessNonblocking(outputOnly, cmdBuf);
 
-		m_bufferInfo[i] = buf.GetBufferInfo();
+		//If the buffer identity hasn't changed since the last bind, the cached descriptor is still good
+		auto info = buf.GetBufferInfo();
+		if(info == m_bufferInfo[i])
+			return;
+		m_descriptorsDirty = true;
+
+		m_bufferInfo[i] = info;
 		if(g_hasPushDescriptor)
 		{
 			m_writeDescriptors[i] =
@@ -182,14 +231,35 @@ public:
 		cmdBuf.bindPipeline(vk::PipelineBindPoint::eCompute, **m_computePipeline);
 	}
 
+	/**
+		@brief Enables or disables GPU-side timing of compute dispatches (across all ComputePipeline instances)
+
+		When enabled, each Dispatch() / DispatchNoRebind() call writes a pair of timestamps to a query pool so the
+		actual GPU execution time of the shader can be read back with GetGpuTimeAndReset(). This is a small amount of
+		extra work per dispatch, so it's off by default.
+	 */
+	static void EnableGpuTiming(bool enable)
+	{ s_gpuTimingRequested = enable; }
+
+	///@brief Checks if GPU-side dispatch timing is requested and supported by the device
+	static bool IsGpuTimingEnabled()
+	{ return s_gpuTimingRequested && g_hasTimestampQueries; }
+
+	int64_t GetGpuTimeAndReset();
+
 	/**
 		@brief Dispatches a compute operation to a command buffer
 	 */
 	template<class T>
 	void Dispatch(vk::raii::CommandBuffer& cmdBuf, T pushConstants, uint32_t x, uint32_t y=1, uint32_t z=1)
 	{
-		if(!g_hasPushDescriptor)
+		//In steady state (same buffers bound every pass) the descriptor set from the previous
+		//pass is still valid, so skip re-dispatching the update
+		if(!g_hasPushDescriptor && m_descriptorsDirty)
+		{
 			g_vkComputeDevice->updateDescriptorSets(m_writeDescriptors, nullptr);
+			m_descriptorsDirty = false;
+		}
 
 		Bind(cmdBuf);
 		cmdBuf.pushConstants<T>(
@@ -216,7 +286,13 @@ public:
 				**m_descriptorSet,
 				{});
 		}
+
+		bool timing = IsGpuTimingEnabled();
+		if(timing)
+			StartTimestampQuery(cmdBuf);
 		cmdBuf.dispatch(x, y, z);
+		if(timing)
+			EndTimestampQuery(cmdBuf);
 	}
 
 	/**
@@ -244,18 +320,35 @@ public:
 			vk::ShaderStageFlagBits::eCompute,
 			0,
 			pushConstants);
+
+		bool timing = IsGpuTimingEnabled();
+		if(timing)
+			StartTimestampQuery(cmdBuf);
 		cmdBuf.dispatch(x, y, z);
+		if(timing)
+			EndTimestampQuery(cmdBuf);
 	}
 
 protected:
 	void DeferredInit();
+	void RecordForWarmup();
+
+	void StartTimestampQuery(vk::raii::CommandBuffer& cmdBuf);
+	void EndTimestampQuery(vk::raii::CommandBuffer& cmdBuf);
 
 	std::string m_shaderPath;
+
+	///@brief Runtime-generated SPIR-V used instead of loading m_shaderPath, if nonempty (see ReinitializeFromSpirv)
+	std::vector<uint32_t> m_spirv;
+
 	size_t m_numSSBOs;
 	size_t m_numStorageImages;
 	size_t m_numSampledImages;
 	size_t m_pushConstantSize;
 
+	///@brief Specialization constant values applied when the pipeline is created (see SetSpecializationConstants)
+	std::vector<uint32_t> m_specConstants;
+
 	std::unique_ptr<vk::raii::ShaderModule> m_shaderModule;
 	std::unique_ptr<vk::raii::Pipeline> m_computePipeline;
 	std::unique_ptr<vk::raii::PipelineLayout> m_pipelineLayout;
@@ -267,6 +360,30 @@ protected:
 	std::vector<vk::DescriptorBufferInfo> m_bufferInfo;
 	std::vector<vk::DescriptorImageInfo> m_storageImageInfo;
 	std::vector<vk::DescriptorImageInfo> m_sampledImageInfo;
+
+	///@brief True if a bind changed since the descriptor set was last updated (see Dispatch)
+	bool m_descriptorsDirty;
+
+	///@brief True if GPU-side dispatch timing has been requested (see EnableGpuTiming)
+	static bool s_gpuTimingRequested;
+
+	///@brief Workgroup width selected by AutoTuneWorkgroupSize() (0 until tuning has run)
+	static uint32_t s_tunedWorkgroupSize;
+
+	///@brief Per-invocation unroll factor selected by AutoTuneWorkgroupSize() (0 until tuning has run)
+	static uint32_t s_tunedUnrollFactor;
+
+	///@brief Maximum number of dispatches that can be timed between calls to GetGpuTimeAndReset()
+	static const uint32_t MAX_TIMED_DISPATCHES = 32;
+
+	///@brief Query pool for GPU-side dispatch timing (only allocated if timing is enabled)
+	std::unique_ptr<vk::raii::QueryPool> m_queryPool;
+
+	///@brief Number of timestamp query pairs written since the last GetGpuTimeAndReset() call
+	uint32_t m_pendingTimestampQueries;
+
+	///@brief True if StartTimestampQuery() armed a query that EndTimestampQuery() has yet to close out
+	bool m_timestampActive;
 };
 
 #endif
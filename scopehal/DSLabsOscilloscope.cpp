@@ -138,6 +138,17 @@ DSLabsOscilloscope::DSLabsOscilloscope(SCPITransport* transport)
 	m_diagnosticValues["% Received Waveforms Dropped"] = &m_diag_droppedPercent;
 
 	ResetPerCaptureDiagnostics();
+
+	//Initialize waveform buffers
+	for(size_t i=0; i<m_analogChannelCount; i++)
+	{
+		m_analogRawWaveformBuffers.push_back(std::make_unique<AcceleratorBuffer<uint8_t> >());
+		m_analogRawWaveformBuffers[i]->SetCpuAccessHint(AcceleratorBuffer<uint8_t>::HINT_LIKELY);
+		m_analogRawWaveformBuffers[i]->SetGpuAccessHint(AcceleratorBuffer<uint8_t>::HINT_LIKELY);
+	}
+
+	//Create Vulkan objects for the waveform conversion
+	m_sampleConverter = make_unique<RawSampleConverter>("DSLabsOscilloscope");
 }
 
 void DSLabsOscilloscope::ResetPerCaptureDiagnostics()
@@ -341,8 +352,8 @@ bool DSLabsOscilloscope::AcquireData()
 	int64_t fs = (t - floor(t)) * FS_PER_SECOND;
 
 	//Analog channels get processed separately
-	vector<uint8_t*> abufs;
 	vector<UniformAnalogWaveform*> awfms;
+	vector<size_t> achans;
 	vector<float> scales;
 	vector<float> offsets;
 
@@ -356,12 +367,13 @@ bool DSLabsOscilloscope::AcquireData()
 
 		// LogDebug("ch%ld: Receive %ld samples\n", chnum, memdepth);
 
-		uint8_t* buf = new uint8_t[memdepth];
-
 		//Analog channels
 		if(chnum < m_analogChannelCount)
 		{
-			abufs.push_back(buf);
+			auto& abuf = m_analogRawWaveformBuffers[chnum];
+			abuf->resize(memdepth);
+			abuf->PrepareForCpuAccess();
+			achans.push_back(chnum);
 
 			//Scale and offset are sent in the header since they might have changed since the capture began
 			if(!m_transport->ReadRawData(sizeof(config), (uint8_t*)&config))
@@ -378,8 +390,9 @@ bool DSLabsOscilloscope::AcquireData()
 
 			//TODO: stream timestamp from the server
 
-			if(!m_transport->ReadRawData(memdepth * sizeof(int8_t), (uint8_t*)buf))
+			if(!m_transport->ReadRawData(memdepth * sizeof(int8_t), abuf->GetCpuPointer()))
 				return false;
+			abuf->MarkModifiedFromCpu();
 
 			//Create our waveform
 			auto cap = new UniformAnalogWaveform;
@@ -399,6 +412,8 @@ bool DSLabsOscilloscope::AcquireData()
 		}
 		else
 		{
+			uint8_t* buf = new uint8_t[memdepth];
+
 			int32_t first_sample;
 
 			if(!m_transport->ReadRawData(sizeof(first_sample), (uint8_t*)&first_sample))
@@ -464,20 +479,35 @@ bool DSLabsOscilloscope::AcquireData()
 		}
 	}
 
-	//Process analog captures in parallel
-	#pragma omp parallel for
-	for(size_t i=0; i<awfms.size(); i++)
+	//If we have GPU support for int8, we can do the conversion on the card and the converted waveform
+	//never has to make a round trip through host memory
+	if(RawSampleConverter::IsGpuConversionAvailable8Bit())
 	{
-		auto cap = awfms[i];
-		cap->PrepareForCpuAccess();
-		ConvertUnsigned8BitSamples(
-			cap->m_samples.GetCpuPointer(),
-			abufs[i],
-			scales[i],
-			offsets[i],
-			cap->size());
-		cap->MarkSamplesModifiedFromCpu();
-		delete[] abufs[i];
+		m_sampleConverter->Begin();
+
+		for(size_t i=0; i<awfms.size(); i++)
+			m_sampleConverter->ConvertUnsigned8BitSamples(awfms[i], *m_analogRawWaveformBuffers[achans[i]], scales[i], offsets[i]);
+
+		m_sampleConverter->Submit();
+	}
+
+	//Fallback path if GPU doesn't have suitable integer support
+	else
+	{
+		//Process analog captures in parallel
+		#pragma omp parallel for
+		for(size_t i=0; i<awfms.size(); i++)
+		{
+			auto cap = awfms[i];
+			cap->PrepareForCpuAccess();
+			ConvertUnsigned8BitSamples(
+				cap->m_samples.GetCpuPointer(),
+				m_analogRawWaveformBuffers[achans[i]]->GetCpuPointer(),
+				scales[i],
+				offsets[i],
+				cap->size());
+			cap->MarkSamplesModifiedFromCpu();
+		}
 	}
 
 	FilterParameter* param = &m_diag_totalWFMs;
@@ -137,6 +137,11 @@ protected:
 	FilterParameter m_diag_droppedPercent;
 	HzClock m_receiveClock;
 
+	///@brief Buffers for storing raw ADC samples before converting to fp32
+	std::vector<std::unique_ptr<AcceleratorBuffer<uint8_t> > > m_analogRawWaveformBuffers;
+
+	std::unique_ptr<RawSampleConverter> m_sampleConverter;
+
 public:
 
 	static std::string GetDriverNameInternal();
@@ -0,0 +1,360 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Implementation of DecodeCache
+ */
+#include "scopehal.h"
+#include "PacketDecoder.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#include <shlwapi.h>
+#include <shlobj.h>
+#endif
+
+using namespace std;
+
+DecodeCache g_decodeCache;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Construction / destruction
+
+DecodeCache::DecodeCache()
+{
+	m_cacheDir = GetCacheDir();
+}
+
+/**
+	@brief Returns the directory cache files live in (creating it if needed), or "" if unavailable
+ */
+string DecodeCache::GetCacheDir()
+{
+	try
+	{
+	#ifdef _WIN32
+		wchar_t* stem;
+		if(S_OK != SHGetKnownFolderPath(
+			FOLDERID_RoamingAppData,
+			KF_FLAG_CREATE,
+			NULL,
+			&stem))
+		{
+			return "";
+		}
+
+		wchar_t directory[MAX_PATH];
+		if(NULL == PathCombineW(directory, stem, L"ngscopeclient"))
+		{
+			CoTaskMemFree(static_cast<void*>(stem));
+			return "";
+		}
+
+		// Ensure the directory exists
+		const auto result = CreateDirectoryW(directory, NULL);
+		CoTaskMemFree(static_cast<void*>(stem));
+		if(!result && GetLastError() != ERROR_ALREADY_EXISTS)
+			return "";
+
+		return NarrowPath(directory) + "\\";
+	#else
+		// Ensure all directories in path exist
+		CreateDirectory("~/.cache");
+		CreateDirectory("~/.cache/ngscopeclient");
+		return ExpandPath("~/.cache/ngscopeclient") + "/";
+	#endif
+	}
+	catch(const exception& e)
+	{
+		return "";
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Key computation
+
+/**
+	@brief Computes the content hash of one waveform, memoizing by (waveform, revision)
+
+	Returns false if the waveform type has no cacheable representation.
+ */
+bool DecodeCache::HashWaveform(WaveformBase* wfm, uint32_t& crc)
+{
+	//Fast path: we already hashed this revision of this waveform
+	{
+		lock_guard<mutex> lock(m_mutex);
+		auto it = m_waveformHashes.find(wfm);
+		if( (it != m_waveformHashes.end()) && (it->second.first == wfm->m_revision) )
+		{
+			crc = it->second.second;
+			return true;
+		}
+	}
+
+	//Hash the metadata that affects decode output, then a CRC per sample data column.
+	//Trigger timestamps are deliberately excluded: re-arming the same capture produces identical samples.
+	vector<uint8_t> blob;
+	auto append = [&blob](const void* p, size_t len)
+	{
+		auto q = reinterpret_cast<const uint8_t*>(p);
+		blob.insert(blob.end(), q, q + len);
+	};
+	auto appendBuf = [&](auto& buf)
+	{
+		buf.PrepareForCpuAccess();
+		size_t bytes = buf.size() * sizeof(buf[0]);
+		uint32_t c = 0;
+		if(bytes)
+			c = CRC32(reinterpret_cast<const uint8_t*>(buf.GetCpuPointer()), 0, bytes - 1);
+		append(&c, sizeof(c));
+	};
+
+	append(&wfm->m_timescale, sizeof(wfm->m_timescale));
+	append(&wfm->m_triggerPhase, sizeof(wfm->m_triggerPhase));
+	uint64_t len = wfm->size();
+	append(&len, sizeof(len));
+
+	uint8_t type;
+	if(auto ua = dynamic_cast<UniformAnalogWaveform*>(wfm))
+	{
+		type = 0;
+		append(&type, sizeof(type));
+		appendBuf(ua->m_samples);
+	}
+	else if(auto sa = dynamic_cast<SparseAnalogWaveform*>(wfm))
+	{
+		type = 1;
+		append(&type, sizeof(type));
+		appendBuf(sa->m_samples);
+		appendBuf(sa->m_offsets);
+		appendBuf(sa->m_durations);
+	}
+	else if(auto ud = dynamic_cast<UniformDigitalWaveform*>(wfm))
+	{
+		type = 2;
+		append(&type, sizeof(type));
+		appendBuf(ud->m_samples);
+	}
+	else if(auto sd = dynamic_cast<SparseDigitalWaveform*>(wfm))
+	{
+		type = 3;
+		append(&type, sizeof(type));
+		appendBuf(sd->m_samples);
+		appendBuf(sd->m_offsets);
+		appendBuf(sd->m_durations);
+	}
+	else
+		return false;
+
+	crc = CRC32(blob);
+
+	lock_guard<mutex> lock(m_mutex);
+	m_waveformHashes[wfm] = pair<uint64_t, uint32_t>(wfm->m_revision, crc);
+	return true;
+}
+
+/**
+	@brief Computes the cache key for a filter's current inputs and configuration
+
+	Returns false if the filter can't be keyed (missing input data, or an input type we can't hash).
+ */
+bool DecodeCache::ComputeKey(Filter* f, string& key)
+{
+	//Configuration: protocol name plus every parameter value.
+	//ToString with the display locale disabled, so the key doesn't depend on the user's number formatting.
+	string config = f->GetProtocolDisplayName();
+	for(auto it = f->GetParamBegin(); it != f->GetParamEnd(); it++)
+		config += "\n" + it->first + "=" + it->second.ToString(false);
+
+	//Inputs: stream index and content hash of every connected input
+	vector<uint8_t> inblob;
+	auto append = [&inblob](const void* p, size_t len)
+	{
+		auto q = reinterpret_cast<const uint8_t*>(p);
+		inblob.insert(inblob.end(), q, q + len);
+	};
+	for(size_t i=0; i<f->GetInputCount(); i++)
+	{
+		auto in = f->GetInput(i);
+
+		uint8_t state;
+		if(!in)
+		{
+			state = 0;
+			append(&state, sizeof(state));
+		}
+		else if(in.GetType() == Stream::STREAM_TYPE_ANALOG_SCALAR)
+		{
+			state = 1;
+			append(&state, sizeof(state));
+			double v = in.GetScalarValue();
+			append(&v, sizeof(v));
+		}
+		else
+		{
+			auto wfm = f->GetInputWaveform(i);
+			uint32_t crc;
+			if(!wfm || !HashWaveform(wfm, crc))
+				return false;
+			state = 2;
+			append(&state, sizeof(state));
+			append(&crc, sizeof(crc));
+		}
+	}
+
+	uint32_t configcrc = CRC32(reinterpret_cast<const uint8_t*>(config.data()), 0, config.length() - 1);
+	uint32_t incrc = inblob.empty() ? 0 : CRC32(inblob);
+
+	char tmp[32];
+	snprintf(tmp, sizeof(tmp), "%08x_%08x", configcrc, incrc);
+	key = tmp;
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Cache operations
+
+/**
+	@brief Attempts to restore a filter's output waveforms from the cache
+
+	Returns false on a miss (any output file absent or unreadable), leaving the filter untouched so the caller
+	falls back to a normal refresh. On a hit, every output stream is populated by mapping the cached file.
+ */
+bool DecodeCache::Restore(Filter* f)
+{
+	if(m_cacheDir.empty())
+		return false;
+
+	//Protocol decoders also produce packets, which the cache has no representation for
+	if(dynamic_cast<PacketDecoder*>(f) != nullptr)
+		return false;
+
+	string key;
+	if(!ComputeKey(f, key))
+		return false;
+
+	size_t nstreams = f->GetStreamCount();
+	if(nstreams == 0)
+		return false;
+
+	//Load every stream before touching the filter, so a partial hit is a clean miss
+	vector<WaveformBase*> loaded;
+	for(size_t i=0; i<nstreams; i++)
+	{
+		auto wfm = WaveformFile::Load(m_cacheDir + "decode_" + key + "_s" + to_string(i) + ".wfm");
+		if(!wfm)
+		{
+			for(auto w : loaded)
+				delete w;
+			return false;
+		}
+		loaded.push_back(wfm);
+	}
+
+	for(size_t i=0; i<nstreams; i++)
+		f->SetData(loaded[i], i);
+
+	LogTrace("Restored %zu output stream(s) of %s from decode cache\n",
+		nstreams, f->GetDisplayName().c_str());
+	return true;
+}
+
+/**
+	@brief Saves a filter's current output waveforms to the cache
+
+	Returns false (removing any partially written files) if the filter isn't cacheable: packet-producing
+	decoders, missing outputs, or output waveform types the columnar format can't represent.
+ */
+bool DecodeCache::Store(Filter* f)
+{
+	if(m_cacheDir.empty())
+		return false;
+
+	if(dynamic_cast<PacketDecoder*>(f) != nullptr)
+		return false;
+
+	string key;
+	if(!ComputeKey(f, key))
+		return false;
+
+	size_t nstreams = f->GetStreamCount();
+	if(nstreams == 0)
+		return false;
+
+	vector<string> written;
+	for(size_t i=0; i<nstreams; i++)
+	{
+		auto wfm = f->GetData(i);
+		string path = m_cacheDir + "decode_" + key + "_s" + to_string(i) + ".wfm";
+		if(!wfm || !WaveformFile::Save(path, wfm))
+		{
+			for(auto& p : written)
+				remove(p.c_str());
+			return false;
+		}
+		written.push_back(path);
+	}
+
+	return true;
+}
+
+/**
+	@brief Restores every filter instance whose inputs and configuration hit the cache
+
+	Intended to be called once after session load, when input waveforms are in place but before the first
+	full graph evaluation. Returns the number of filters restored.
+ */
+size_t DecodeCache::RestoreAll()
+{
+	size_t nhits = 0;
+	for(auto f : Filter::GetAllInstances())
+	{
+		if(Restore(f))
+			nhits ++;
+	}
+	return nhits;
+}
+
+/**
+	@brief Saves the outputs of every cacheable filter instance, returning the number stored
+
+	Intended to be called at session save, when all filter outputs are current.
+ */
+size_t DecodeCache::StoreAll()
+{
+	size_t nstored = 0;
+	for(auto f : Filter::GetAllInstances())
+	{
+		if(Store(f))
+			nstored ++;
+	}
+	return nstored;
+}
@@ -0,0 +1,91 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Declaration of DecodeCache
+ */
+#ifndef DecodeCache_h
+#define DecodeCache_h
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+
+class Filter;
+class WaveformBase;
+
+/**
+	@brief On-disk cache of filter output waveforms, keyed by input content and filter configuration
+
+	Re-opening a session normally re-runs every filter from scratch even though its inputs are bit-identical to
+	the previous run. The decode cache short-circuits that: after a refresh the client can Store() a filter's
+	output waveforms as WaveformFile payloads in the per-user cache directory, and on the next session load
+	Restore() puts them back by mapping the files copy-on-write - no recompute and no copy, with sample pages
+	faulted in lazily as they're first displayed.
+
+	The cache key combines the filter's protocol name and parameter values with a content hash of each input
+	waveform, so it is stable across sessions and oblivious to how the inputs were produced; any change to an
+	input or a parameter is a clean miss and the filter runs normally. Content hashes are memoized per
+	(waveform, revision) so repeated key computations over an unchanged input don't re-scan the sample data.
+
+	Only filters whose outputs are plain analog/digital waveforms are cached: protocol decoders also carry a
+	packet list that the columnar format has no representation for, so they always miss and recompute.
+ */
+class DecodeCache
+{
+public:
+	DecodeCache();
+
+	bool Restore(Filter* f);
+	bool Store(Filter* f);
+
+	size_t RestoreAll();
+	size_t StoreAll();
+
+protected:
+	std::string GetCacheDir();
+	bool ComputeKey(Filter* f, std::string& key);
+	bool HashWaveform(WaveformBase* wfm, uint32_t& crc);
+
+	///@brief Mutex protecting the hash memo
+	std::mutex m_mutex;
+
+	///@brief Memoized content hashes, keyed by waveform and valid for the recorded revision only
+	std::map<WaveformBase*, std::pair<uint64_t, uint32_t> > m_waveformHashes;
+
+	///@brief Directory cache files live in, or "" if unavailable (resolved once at construction)
+	std::string m_cacheDir;
+};
+
+extern DecodeCache g_decodeCache;
+
+#endif
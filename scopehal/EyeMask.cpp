@@ -50,6 +50,14 @@ using namespace std;
 EyeMask::EyeMask()
 	: m_hitrate(0)
 	, m_timebaseIsRelative(false)
+	, m_rasterWidth(0)
+	, m_rasterHeight(0)
+	, m_rasterXscale(0)
+	, m_rasterXoff(0)
+	, m_rasterFullScaleRange(0)
+	, m_rasterUiWidth(0)
+	, m_rasterBlocksPerRow(0)
+	, m_rasterBlockRows(0)
 {
 }
 
@@ -93,6 +101,7 @@ bool EyeMask::Load(const YAML::Node& node)
 	m_hitrate = 0;
 	m_timebaseIsRelative = false;
 	m_maskname = "";
+	m_rasterCache.clear();
 
 	//Load protocol section
 	auto proto = node["protocol"];
@@ -234,9 +243,11 @@ void EyeMask::RenderInternal(
 }
 
 /**
-	@brief Checks a raw eye pattern dataset against the mask
+	@brief Rasterizes the mask for analysis if the eye geometry changed since the last call
+
+	Also builds the coarse block occupancy grid used by CheckHitRateFastFail() in the same pass.
  */
-float EyeMask::CalculateHitRate(
+void EyeMask::UpdateRasterCache(
 	EyeWaveform* cap,
 	size_t width,
 	size_t height,
@@ -245,7 +256,15 @@ float EyeMask::CalculateHitRate(
 	float xoff
 	) const
 {
-	//TODO: performance optimization, don't re-render mask every waveform, only when we resize
+	//Up to date? Nothing to do
+	float uiWidth = cap->GetUIWidth();
+	if( !m_rasterCache.empty() &&
+		(width == m_rasterWidth) && (height == m_rasterHeight) &&
+		(xscale == m_rasterXscale) && (xoff == m_rasterXoff) &&
+		(fullscalerange == m_rasterFullScaleRange) && (uiWidth == m_rasterUiWidth) )
+	{
+		return;
+	}
 
 	//Create the Cairo surface we're drawing on
 	Cairo::RefPtr< Cairo::ImageSurface > surface =
@@ -268,24 +287,76 @@ float EyeMask::CalculateHitRate(
 		0,
 		height);
 
+	//Compact the rendered ARGB surface to one byte per pixel for the reduction pass,
+	//marking each coarse block containing at least one mask pixel as we go
+	m_rasterCache.resize(width * height);
+	m_rasterBlocksPerRow = (width + BLOCK_SIZE - 1) / BLOCK_SIZE;
+	m_rasterBlockRows = (height + BLOCK_SIZE - 1) / BLOCK_SIZE;
+	m_rasterBlockOccupied.clear();
+	m_rasterBlockOccupied.resize(m_rasterBlocksPerRow * m_rasterBlockRows, 0);
+	uint32_t* data = reinterpret_cast<uint32_t*>(surface->get_data());
+	int stride = surface->get_stride() / sizeof(uint32_t);
+	for(size_t y=0; y<height; y++)
+	{
+		auto row = data + (y*stride);
+		auto mrow = &m_rasterCache[y*width];
+		auto brow = &m_rasterBlockOccupied[(y/BLOCK_SIZE) * m_rasterBlocksPerRow];
+		for(size_t x=0; x<width; x++)
+		{
+			if( (row[x] & 0xff) != 0)
+			{
+				mrow[x] = 1;
+				brow[x/BLOCK_SIZE] = 1;
+			}
+			else
+				mrow[x] = 0;
+		}
+	}
+
+	m_rasterWidth = width;
+	m_rasterHeight = height;
+	m_rasterXscale = xscale;
+	m_rasterXoff = xoff;
+	m_rasterFullScaleRange = fullscalerange;
+	m_rasterUiWidth = uiWidth;
+}
+
+/**
+	@brief Checks a raw eye pattern dataset against the mask
+
+	The mask is rasterized only when the eye geometry changes; at steady state each update just runs the
+	reduction over the cached raster.
+ */
+float EyeMask::CalculateHitRate(
+	EyeWaveform* cap,
+	size_t width,
+	size_t height,
+	float fullscalerange,
+	float xscale,
+	float xoff
+	) const
+{
+	//Re-rasterize the mask if the eye geometry changed since last time
+	UpdateRasterCache(cap, width, height, fullscalerange, xscale, xoff);
+
 	//Test each pixel of the eye pattern against the mask
 	float nmax = 0;
 	if(cap->GetType() == EyeWaveform::EYE_NORMAL)
 	{
 		auto accum = cap->GetAccumData();
-		uint32_t* data = reinterpret_cast<uint32_t*>(surface->get_data());
-		int stride = surface->get_stride() / sizeof(uint32_t);
+		float norm = 1.0f / cap->GetTotalUIs();
+
+		#pragma omp parallel for reduction(max:nmax)
 		for(size_t y=0; y<height; y++)
 		{
-			auto row = data + (y*stride);
+			auto mrow = &m_rasterCache[y*width];
 			auto eyerow = accum + (y*width);
 			for(size_t x=0; x<width; x++)
 			{
 				//If mask pixel isn't black, count violations
-				uint32_t pix = row[x];
-				if( (pix & 0xff) != 0)
+				if(mrow[x])
 				{
-					float rate = (eyerow[x] * 1.0f / cap->GetTotalUIs());
+					float rate = eyerow[x] * norm;
 					if(rate > nmax)
 						nmax = rate;
 				}
@@ -295,19 +366,18 @@ float EyeMask::CalculateHitRate(
 	else //if(cap->GetType() == EyeWaveform::EYE_BER)
 	{
 		auto accum = cap->GetData();
-		uint32_t* data = reinterpret_cast<uint32_t*>(surface->get_data());
-		int stride = surface->get_stride() / sizeof(uint32_t);
+
+		#pragma omp parallel for reduction(max:nmax)
 		for(size_t y=0; y<height; y++)
 		{
-			auto row = data + (y*stride);
+			auto mrow = &m_rasterCache[y*width];
 			auto eyerow = accum + (y*width);
 			for(size_t x=0; x<width; x++)
 			{
 				//If mask pixel isn't black, count violations
-				uint32_t pix = row[x];
-				if( (pix & 0xff) != 0)
+				//BER eyes don't need any preprocessing since the pixel values are already raw BER
+				if(mrow[x])
 				{
-					//BER eyes don't need any preprocessing since the pixel values are already raw BER
 					float rate = eyerow[x];
 					if(rate > nmax)
 						nmax = rate;
@@ -318,3 +388,101 @@ float EyeMask::CalculateHitRate(
 
 	return nmax;
 }
+
+/**
+	@brief Pass/fail oriented mask test with early abort and violation localization
+
+	Intended for production compliance loops that only care whether the eye violates the mask, not about the
+	exact worst case hit rate. The scan walks the coarse block occupancy grid built by UpdateRasterCache() and
+	skips any block with no mask coverage; for normal eyes it additionally prunes blocks whose per-column hit
+	totals (an upper bound on any single bin in the column) cannot exceed abortThreshold, and only the
+	surviving blocks are refined at full resolution.
+
+	If hits is null, the scan returns as soon as any bin exceeds abortThreshold. If hits is non-null, every
+	violating bin is appended so failures can be localized without rescanning the source waveform; pruned
+	blocks are still skipped, so the cost is proportional to the mask coverage near violations rather than to
+	the full eye.
+
+	The return value is greater than abortThreshold if and only if a violation was found. Because pruned and
+	unscanned regions are not reflected in it, it is not the exact worst case rate that CalculateHitRate()
+	computes.
+ */
+float EyeMask::CheckHitRateFastFail(
+	EyeWaveform* cap,
+	size_t width,
+	size_t height,
+	float fullscalerange,
+	float xscale,
+	float xoff,
+	float abortThreshold,
+	vector<EyeMaskHit>* hits
+	) const
+{
+	//Re-rasterize the mask if the eye geometry changed since last time
+	UpdateRasterCache(cap, width, height, fullscalerange, xscale, xoff);
+
+	bool isNormal = (cap->GetType() == EyeWaveform::EYE_NORMAL);
+	float norm = isNormal ? 1.0f / cap->GetTotalUIs() : 1.0f;
+	auto accum = cap->GetAccumData();
+	auto berdata = cap->GetData();
+
+	//Per-column hit totals for the coarse prune (normal eyes only; BER bins aren't additive counts)
+	const vector<int64_t>* colMarginal = isNormal ? &cap->GetColumnMarginal() : nullptr;
+
+	float nmax = 0;
+	for(size_t by=0; by<m_rasterBlockRows; by++)
+	{
+		for(size_t bx=0; bx<m_rasterBlocksPerRow; bx++)
+		{
+			//Coarse grid test: skip blocks the mask doesn't touch at all
+			if(!m_rasterBlockOccupied[by*m_rasterBlocksPerRow + bx])
+				continue;
+
+			size_t x0 = bx * BLOCK_SIZE;
+			size_t x1 = min(x0 + BLOCK_SIZE, width);
+			size_t y0 = by * BLOCK_SIZE;
+			size_t y1 = min(y0 + BLOCK_SIZE, height);
+
+			//Coarse grid test: a column's total is an upper bound on every bin in it, so if no column in the
+			//block can reach the threshold there's no potential violation to refine here
+			if(colMarginal)
+			{
+				bool canViolate = false;
+				for(size_t x=x0; x<x1; x++)
+				{
+					if( ((*colMarginal)[x] * norm) > abortThreshold)
+					{
+						canViolate = true;
+						break;
+					}
+				}
+				if(!canViolate)
+					continue;
+			}
+
+			//Refine: full resolution scan of this block only
+			for(size_t y=y0; y<y1; y++)
+			{
+				auto mrow = &m_rasterCache[y*width];
+				for(size_t x=x0; x<x1; x++)
+				{
+					if(!mrow[x])
+						continue;
+
+					float rate = isNormal ? (accum[y*width + x] * norm) : berdata[y*width + x];
+					if(rate > nmax)
+						nmax = rate;
+					if(rate > abortThreshold)
+					{
+						//Early abort if the caller only wants pass/fail
+						if(hits == nullptr)
+							return rate;
+						hits->push_back(EyeMaskHit(x, y, rate));
+					}
+				}
+			}
+		}
+	}
+
+	return nmax;
+}
@@ -67,6 +67,26 @@ public:
 	std::vector<EyeMaskPoint> m_points;
 };
 
+/**
+	@brief A single mask violation (one raster bin inside the mask whose hit rate exceeds the pass threshold)
+ */
+class EyeMaskHit
+{
+public:
+	EyeMaskHit()
+	{}
+
+	EyeMaskHit(size_t x, size_t y, float rate)
+	: m_x(x)
+	, m_y(y)
+	, m_rate(rate)
+	{}
+
+	size_t m_x;		//column within the eye raster
+	size_t m_y;		//row within the eye raster
+	float m_rate;	//hit rate observed in this bin
+};
+
 /**
 	@brief A mask used for checking eye patterns
  */
@@ -114,6 +134,16 @@ public:
 		float xscale,
 		float xoff) const;
 
+	float CheckHitRateFastFail(
+		EyeWaveform* cap,
+		size_t width,
+		size_t height,
+		float fullscalerange,
+		float xscale,
+		float xoff,
+		float abortThreshold,
+		std::vector<EyeMaskHit>* hits = nullptr) const;
+
 	bool empty() const
 	{ return m_polygons.empty(); }
 
@@ -133,9 +163,37 @@ protected:
 		float yoff,
 		float height) const;
 
+	void UpdateRasterCache(
+		EyeWaveform* cap,
+		size_t width,
+		size_t height,
+		float fullscalerange,
+		float xscale,
+		float xoff) const;
+
 	std::string m_fname;
 	std::vector<EyeMaskPolygon> m_polygons;
 
+	//Cached analysis rasterization of the mask (one byte per pixel, nonzero = inside mask).
+	//Re-rendered only when the eye geometry changes, so steady-state hit testing skips the Cairo pass.
+	mutable std::vector<uint8_t> m_rasterCache;
+	mutable size_t m_rasterWidth;
+	mutable size_t m_rasterHeight;
+	mutable float m_rasterXscale;
+	mutable float m_rasterXoff;
+	mutable float m_rasterFullScaleRange;
+	mutable float m_rasterUiWidth;
+
+	///@brief Edge length of the square blocks of the coarse occupancy grid used by CheckHitRateFastFail()
+	static const size_t BLOCK_SIZE = 32;
+
+	//Coarse occupancy grid built alongside the raster cache: one byte per BLOCK_SIZE square block of the
+	//raster, nonzero if any pixel of the block is inside the mask. Lets the fast-fail test skip most of the
+	//eye without touching the full resolution raster.
+	mutable std::vector<uint8_t> m_rasterBlockOccupied;
+	mutable size_t m_rasterBlocksPerRow;
+	mutable size_t m_rasterBlockRows;
+
 	float m_hitrate;
 
 	//true = time measured in UIs
@@ -44,6 +44,8 @@ EyeWaveform::EyeWaveform(size_t width, size_t height, float center, EyeType etyp
 	, m_centerVoltage(center)
 	, m_maskHitRate(0)
 	, m_type(etype)
+	, m_cachedLayoutsStale(true)
+	, m_tilesPerRow(0)
 {
 	size_t npix = width*height;
 	m_accumdata = new int64_t[npix];
@@ -91,6 +93,71 @@ void EyeWaveform::Normalize()
 	for(size_t i=0; i<len; i++)
 		m_outdata[i] = min(1.0f, m_accumdata[i] * norm);
 	m_outdata.MarkModifiedFromCpu();
+
+	//Each accumulation pass ends here, so this is where the cached layouts go stale
+	m_cachedLayoutsStale = true;
+}
+
+/**
+	@brief Rebuilds the tiled accumulator layout and the row/column marginal histograms if they're stale
+
+	The row-major accumulator makes column-wise consumers (bathtubs, mask tests, eye opening searches) pay a full
+	cache line per row touched, and makes them re-reduce the whole map for aggregates. This caches a tiled copy
+	(TILE_SIZE square tiles, GPU friendly) plus both marginals, all built in a single fused pass, so those
+	consumers get cache-friendly column walks and O(1) marginal reads.
+
+	Rebuilt at most once per accumulation pass: Normalize() and ApplyDecay() mark the caches stale, and every
+	in-tree accumulator finishes its pass with Normalize(). Note that Normalize() mirrors the right half of the
+	accumulator onto the left in place, so the cached layouts match what consumers of the normalized density
+	buffer see.
+ */
+void EyeWaveform::UpdateCachedLayouts()
+{
+	if(!m_cachedLayoutsStale)
+		return;
+
+	m_tilesPerRow = (m_width + TILE_SIZE - 1) / TILE_SIZE;
+	size_t tilesPerCol = (m_height + TILE_SIZE - 1) / TILE_SIZE;
+	m_tiledAccum.assign(m_tilesPerRow * tilesPerCol * TILE_SIZE * TILE_SIZE, 0);
+	m_columnMarginal.assign(m_width, 0);
+	m_rowMarginal.assign(m_height, 0);
+
+	for(size_t y=0; y<m_height; y++)
+	{
+		int64_t* row = m_accumdata + y*m_width;
+		size_t tileRowBase = (y / TILE_SIZE) * m_tilesPerRow * TILE_SIZE * TILE_SIZE + (y % TILE_SIZE) * TILE_SIZE;
+		int64_t rowTotal = 0;
+		for(size_t x=0; x<m_width; x++)
+		{
+			int64_t hits = row[x];
+			m_tiledAccum[tileRowBase + (x / TILE_SIZE) * TILE_SIZE * TILE_SIZE + (x % TILE_SIZE)] = hits;
+			m_columnMarginal[x] += hits;
+			rowTotal += hits;
+		}
+		m_rowMarginal[y] = rowTotal;
+	}
+
+	m_cachedLayoutsStale = false;
+}
+
+/**
+	@brief Scales down the accumulated hit counts so that old UIs fade out of the eye.
+
+	Used for decaying-persistence mode on long soak tests: calling this before integrating each new batch of UIs
+	gives an exponential moving average of the hit density in constant memory, rather than integrating forever.
+	The integrated UI count is scaled by the same factor so normalization and mask hit rates stay consistent.
+
+	Counts truncate toward zero, so rarely-hit bins eventually disappear entirely rather than pinning at one hit.
+ */
+void EyeWaveform::ApplyDecay(float factor)
+{
+	size_t len = m_width * m_height;
+	for(size_t i=0; i<len; i++)
+		m_accumdata[i] = static_cast<int64_t>(m_accumdata[i] * static_cast<double>(factor));
+
+	m_totalUIs = static_cast<size_t>(m_totalUIs * static_cast<double>(factor));
+
+	m_cachedLayoutsStale = true;
 }
 
 /**
@@ -68,6 +68,8 @@ public:
 	void IntegrateUIs(size_t uis)
 	{ m_totalUIs += uis; }
 
+	void ApplyDecay(float factor);
+
 	float GetUIWidth()
 	{ return m_uiWidth; }
 
@@ -81,11 +83,68 @@ public:
 	void SetMaskHitRate(float rate)
 	{ m_maskHitRate = rate; }
 
+	///@brief A single localized mask violation, in eye coordinate space
+	struct MaskViolation
+	{
+		///@brief Time of the violating bin, in femtoseconds relative to the eye origin
+		int64_t m_time;
+
+		///@brief Voltage of the violating bin
+		float m_voltage;
+
+		///@brief Hit rate observed in the violating bin
+		float m_rate;
+	};
+
+	/**
+		@brief Returns the mask violations recorded by the most recent fast-fail mask test
+
+		Sorted by time, so callers can localize failures to a region of the UI with a binary search rather
+		than rescanning the source waveform. Empty if the eye passed, or if the last test ran in full mode.
+	 */
+	const std::vector<MaskViolation>& GetMaskViolations()
+	{ return m_maskViolations; }
+
+	void SetMaskViolations(const std::vector<MaskViolation>& violations)
+	{ m_maskViolations = violations; }
+
 	double GetBERAtPoint(ssize_t pointx, ssize_t pointy, ssize_t xmid, ssize_t ymid);
 
 	EyeType GetType()
 	{ return m_type; }
 
+	///@brief Edge length of the square tiles in the cached tiled accumulator layout
+	static const size_t TILE_SIZE = 32;
+
+	void UpdateCachedLayouts();
+
+	/**
+		@brief Reads one bin of the tiled accumulator layout
+
+		Tiles are TILE_SIZE x TILE_SIZE and stored contiguously, so column-wise walks touch one cache line per
+		TILE_SIZE rows instead of one per row. Caller must have called UpdateCachedLayouts() since the last
+		accumulation pass.
+	 */
+	int64_t GetAccumTiled(size_t x, size_t y)
+	{
+		size_t tile = (y / TILE_SIZE) * m_tilesPerRow + (x / TILE_SIZE);
+		return m_tiledAccum[tile*TILE_SIZE*TILE_SIZE + (y % TILE_SIZE)*TILE_SIZE + (x % TILE_SIZE)];
+	}
+
+	///@brief Returns total hit counts per X bin, summed over all rows
+	const std::vector<int64_t>& GetColumnMarginal()
+	{
+		UpdateCachedLayouts();
+		return m_columnMarginal;
+	}
+
+	///@brief Returns total hit counts per Y bin, summed over all columns
+	const std::vector<int64_t>& GetRowMarginal()
+	{
+		UpdateCachedLayouts();
+		return m_rowMarginal;
+	}
+
 protected:
 	int64_t* m_accumdata;
 
@@ -94,7 +153,25 @@ protected:
 
 	float m_maskHitRate;
 
+	///@brief Violations recorded by the most recent fast-fail mask test, sorted by time
+	std::vector<MaskViolation> m_maskViolations;
+
 	EyeType m_type;
+
+	///@brief Set when the accumulator has changed since the cached layouts were last rebuilt
+	bool m_cachedLayoutsStale;
+
+	///@brief Number of tiles per row of the tiled layout
+	size_t m_tilesPerRow;
+
+	///@brief Tiled copy of the accumulator (TILE_SIZE square tiles in row-major order, zero padded at the edges)
+	std::vector<int64_t> m_tiledAccum;
+
+	///@brief Per-column hit totals, rebuilt in the same pass as the tiled layout
+	std::vector<int64_t> m_columnMarginal;
+
+	///@brief Per-row hit totals, rebuilt in the same pass as the tiled layout
+	std::vector<int64_t> m_rowMarginal;
 };
 
 #endif
@@ -0,0 +1,186 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Implementation of FilePrefetchManager
+ */
+
+#include "scopehal.h"
+#include "FilePrefetchManager.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Construction / destruction
+
+FilePrefetchManager::FilePrefetchManager(size_t numThreads)
+	: m_numActive(0)
+	, m_shuttingDown(false)
+{
+	for(size_t i=0; i<numThreads; i++)
+		m_threads.push_back(thread(&FilePrefetchManager::WorkerThread, this));
+}
+
+FilePrefetchManager::~FilePrefetchManager()
+{
+	{
+		lock_guard<mutex> lock(m_mutex);
+		m_shuttingDown = true;
+		m_queue.clear();
+	}
+	m_workCond.notify_all();
+
+	for(auto& t : m_threads)
+		t.join();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Queue management
+
+///@brief Adds a file to the prefetch queue
+void FilePrefetchManager::EnqueueFile(const string& path)
+{
+	{
+		lock_guard<mutex> lock(m_mutex);
+		m_queue.push_back(path);
+	}
+	m_workCond.notify_one();
+}
+
+///@brief Adds several files to the prefetch queue, oldest first
+void FilePrefetchManager::EnqueueFiles(const vector<string>& paths)
+{
+	{
+		lock_guard<mutex> lock(m_mutex);
+		for(auto& p : paths)
+			m_queue.push_back(p);
+	}
+	m_workCond.notify_all();
+}
+
+///@brief Drops any queued files that haven't started prefetching yet (files in flight still complete)
+void FilePrefetchManager::Flush()
+{
+	lock_guard<mutex> lock(m_mutex);
+	m_queue.clear();
+}
+
+///@brief Blocks until the queue is empty and no worker is mid-file
+void FilePrefetchManager::WaitForIdle()
+{
+	unique_lock<mutex> lock(m_mutex);
+	m_idleCond.wait(lock, [this]{ return m_queue.empty() && (m_numActive == 0); });
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Worker threads
+
+void FilePrefetchManager::WorkerThread()
+{
+	#ifdef __linux__
+	pthread_setname_np(pthread_self(), "FilePrefetch");
+	#endif
+
+	while(true)
+	{
+		string path;
+		{
+			unique_lock<mutex> lock(m_mutex);
+			m_workCond.wait(lock, [this]{ return m_shuttingDown || !m_queue.empty(); });
+			if(m_shuttingDown)
+				return;
+
+			path = m_queue.front();
+			m_queue.pop_front();
+			m_numActive ++;
+		}
+
+		PrefetchFile(path);
+
+		{
+			lock_guard<mutex> lock(m_mutex);
+			m_numActive --;
+		}
+		m_idleCond.notify_all();
+	}
+}
+
+/**
+	@brief Pulls one file into the page cache
+
+	Reads through a small stack buffer that's immediately discarded; the point is the kernel's copy of the
+	pages, not ours. Aborts early if the manager is being destroyed.
+ */
+void FilePrefetchManager::PrefetchFile(const string& path)
+{
+	LogTrace("Prefetching %s\n", path.c_str());
+
+#ifndef _WIN32
+	int fd = open(path.c_str(), O_RDONLY);
+	if(fd < 0)
+		return;
+
+	//Tell the kernel what's coming so readahead can run ahead of our read loop
+	posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+	posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+
+	char buf[65536];
+	while(true)
+	{
+		ssize_t len = read(fd, buf, sizeof(buf));
+		if(len <= 0)
+			break;
+
+		if(m_shuttingDown)
+			break;
+	}
+
+	close(fd);
+#else
+	FILE* fp = fopen(path.c_str(), "rb");
+	if(fp == nullptr)
+		return;
+
+	char buf[65536];
+	while(fread(buf, 1, sizeof(buf), fp) == sizeof(buf))
+	{
+		if(m_shuttingDown)
+			break;
+	}
+
+	fclose(fp);
+#endif
+}
@@ -0,0 +1,102 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Declaration of FilePrefetchManager
+ */
+#ifndef FilePrefetchManager_h
+#define FilePrefetchManager_h
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+	@brief Background readahead of files about to be imported
+
+	Batch import jobs process hundreds of waveform files sequentially, so with a cold page cache every
+	ImportFilter spends most of its time blocked on disk rather than parsing. A FilePrefetchManager pulls the
+	next few files into the page cache on worker threads while the current one is being parsed: enqueue each
+	upcoming file a step or two before its import and the parser finds its bytes already resident.
+
+	Prefetching is purely advisory. Workers hint the kernel with posix_fadvise(POSIX_FADV_WILLNEED) and then
+	read the file through a small throwaway buffer, so nothing is retained in process memory and a file that
+	disappears before its import simply wastes a little readahead. Entries not yet started can be dropped with
+	Flush() if the job is cancelled.
+
+	ImportFilter::GetPrefetchManager() returns a process-wide instance shared by all import filters.
+ */
+class FilePrefetchManager
+{
+public:
+	FilePrefetchManager(size_t numThreads = 2);
+	~FilePrefetchManager();
+
+	//not copyable or assignable
+	FilePrefetchManager(const FilePrefetchManager&) =delete;
+	FilePrefetchManager& operator=(const FilePrefetchManager&) =delete;
+
+	void EnqueueFile(const std::string& path);
+	void EnqueueFiles(const std::vector<std::string>& paths);
+
+	void Flush();
+	void WaitForIdle();
+
+protected:
+	void WorkerThread();
+	void PrefetchFile(const std::string& path);
+
+	///@brief Mutex to interlock access to the queue and counters
+	std::mutex m_mutex;
+
+	///@brief Signaled when work is added or shutdown begins
+	std::condition_variable m_workCond;
+
+	///@brief Signaled when a worker finishes a file
+	std::condition_variable m_idleCond;
+
+	///@brief Files waiting to be prefetched, oldest first
+	std::deque<std::string> m_queue;
+
+	///@brief Number of files currently being read by workers
+	size_t m_numActive;
+
+	///@brief Set during destruction to make workers exit (and abort mid-file); atomic so the read loop can poll it
+	std::atomic<bool> m_shuttingDown;
+
+	///@brief Worker threads
+	std::vector<std::thread> m_threads;
+};
+
+#endif
@@ -42,10 +42,12 @@
 using namespace std;
 
 Filter::CreateMapType Filter::m_createprocs;
+vector< pair<Filter::ProtocolNameProcType, Filter::CreateProcType> > Filter::m_pendingProcs;
 set<Filter*> Filter::m_filters;
 
 mutex Filter::m_cacheMutex;
 map<pair<WaveformBase*, float>, vector<int64_t> > Filter::m_zeroCrossingCache;
+map<WaveformBase*, WaveformStats> Filter::m_statsCache;
 
 map<string, unsigned int> Filter::m_instanceCount;
 
@@ -57,6 +59,12 @@ Filter::Filter(
 	Category cat,
 	Unit xunit)
 	: OscilloscopeChannel(NULL, "", color, xunit, 0)	//TODO: handle this better?
+	, m_samplesProcessedCounter(nullptr)
+	, m_deferredCompletionAllowed(false)
+	, m_pendingSubmitValue(0)
+	, m_visibleWindowValid(false)
+	, m_visibleWindowStart(0)
+	, m_visibleWindowEnd(0)
 	, m_category(cat)
 	, m_usingDefault(true)
 {
@@ -101,14 +109,39 @@ void Filter::DoAddDecoderClass(const string& name, CreateProcType proc)
 	m_createprocs[name] = proc;
 }
 
+/**
+	@brief Registers a filter class without resolving its protocol name yet
+
+	Called (via the AddDecoderClass macro) for every filter class at startup. We only record the pair of
+	function pointers here; the name lookup map is populated lazily by LoadPendingDecoderClasses() the first
+	time somebody actually enumerates or instantiates a filter, so headless startup doesn't pay for building
+	a couple hundred protocol name strings it may never use.
+ */
+void Filter::DoAddDecoderClass(ProtocolNameProcType nameproc, CreateProcType proc)
+{
+	m_pendingProcs.push_back(pair<ProtocolNameProcType, CreateProcType>(nameproc, proc));
+}
+
+///@brief Moves any lazily registered filter classes into the name lookup map
+void Filter::LoadPendingDecoderClasses()
+{
+	for(auto& it : m_pendingProcs)
+		m_createprocs[it.first()] = it.second;
+	m_pendingProcs.clear();
+}
+
 void Filter::EnumProtocols(vector<string>& names)
 {
+	LoadPendingDecoderClasses();
+
 	for(CreateMapType::iterator it=m_createprocs.begin(); it != m_createprocs.end(); ++it)
 		names.push_back(it->first);
 }
 
 Filter* Filter::CreateFilter(const string& protocol, const string& color)
 {
+	LoadPendingDecoderClasses();
+
 	if(m_createprocs.find(protocol) != m_createprocs.end())
 	{
 		auto f = m_createprocs[protocol](color);
@@ -460,33 +493,90 @@ void Filter::FindZeroCrossings(UniformAnalogWaveform* data, float threshold, std
 	}
 
 	//Find times of the zero crossings
-	bool first = true;
-	bool last = false;
 	int64_t phoff = data->m_triggerPhase;
 	size_t len = data->m_samples.size();
 	float fscale = data->m_timescale;
 
-	for(size_t i=1; i<len; i++)
+	//A transition only depends on the two samples around it, so on long waveforms we can search in parallel:
+	//count the transitions in each chunk, then interpolate and write them out at the correct offsets
+	const size_t minParallelLen = 1024*1024;
+	const size_t chunkSize = 4*1024*1024;
+	if(len >= minParallelLen)
 	{
-		bool value = data->m_samples[i] > threshold;
+		size_t nchunks = (len-2 + chunkSize-1) / chunkSize;
 
-		//Save the last value
-		if(first)
+		//First pass: count transitions per chunk
+		vector<size_t> counts(nchunks, 0);
+		#pragma omp parallel for
+		for(size_t c=0; c<nchunks; c++)
 		{
-			last = value;
-			first = false;
-			continue;
+			size_t istart = 2 + c*chunkSize;
+			size_t iend = min(istart + chunkSize, len);
+			size_t n = 0;
+			for(size_t i=istart; i<iend; i++)
+			{
+				if( (data->m_samples[i] > threshold) != (data->m_samples[i-1] > threshold) )
+					n ++;
+			}
+			counts[c] = n;
 		}
 
-		//Skip samples with no transition
-		if(last == value)
-			continue;
+		//Prefix sum so each chunk knows where its edges land in the output
+		vector<size_t> offsets(nchunks, 0);
+		size_t total = edges.size();
+		for(size_t c=0; c<nchunks; c++)
+		{
+			offsets[c] = total;
+			total += counts[c];
+		}
+		edges.resize(total);
 
-		//Midpoint of the sample, plus the zero crossing
-		int64_t tfrac = fscale * InterpolateTime(data, i-1, threshold);
-		int64_t t = phoff + data->m_timescale*(i-1) + tfrac;
-		edges.push_back(t);
-		last = value;
+		//Second pass: interpolate the edge timestamps
+		#pragma omp parallel for
+		for(size_t c=0; c<nchunks; c++)
+		{
+			size_t istart = 2 + c*chunkSize;
+			size_t iend = min(istart + chunkSize, len);
+			size_t iout = offsets[c];
+			for(size_t i=istart; i<iend; i++)
+			{
+				if( (data->m_samples[i] > threshold) == (data->m_samples[i-1] > threshold) )
+					continue;
+
+				//Midpoint of the sample, plus the zero crossing
+				int64_t tfrac = fscale * InterpolateTime(data, i-1, threshold);
+				edges[iout ++] = phoff + data->m_timescale*(i-1) + tfrac;
+			}
+		}
+	}
+
+	//Short waveform, not worth spinning up threads for
+	else
+	{
+		bool first = true;
+		bool last = false;
+		for(size_t i=1; i<len; i++)
+		{
+			bool value = data->m_samples[i] > threshold;
+
+			//Save the last value
+			if(first)
+			{
+				last = value;
+				first = false;
+				continue;
+			}
+
+			//Skip samples with no transition
+			if(last == value)
+				continue;
+
+			//Midpoint of the sample, plus the zero crossing
+			int64_t tfrac = fscale * InterpolateTime(data, i-1, threshold);
+			int64_t t = phoff + data->m_timescale*(i-1) + tfrac;
+			edges.push_back(t);
+			last = value;
+		}
 	}
 
 	//Add to cache
@@ -547,30 +637,100 @@ void Filter::FindZeroCrossings(SparseDigitalWaveform* data, vector<int64_t>& edg
  */
 void Filter::FindZeroCrossings(UniformDigitalWaveform* data, vector<int64_t>& edges)
 {
+	pair<WaveformBase*, float> cachekey(data, 0);
+
+	//Check cache
+	{
+		lock_guard<mutex> lock(m_cacheMutex);
+		auto it = m_zeroCrossingCache.find(cachekey);
+		if(it != m_zeroCrossingCache.end())
+		{
+			edges = it->second;
+			return;
+		}
+	}
+
 	//Find times of the zero crossings
-	bool first = true;
-	bool last = data->m_samples[0];
 	int64_t phoff = data->m_timescale/2 + data->m_triggerPhase;
 	size_t len = data->m_samples.size();
-	for(size_t i=1; i<len; i++)
+
+	//Same chunked parallel search as the uniform analog path (no interpolation needed for digital data)
+	const size_t minParallelLen = 1024*1024;
+	const size_t chunkSize = 4*1024*1024;
+	if(len >= minParallelLen)
 	{
-		bool value = data->m_samples[i];
+		size_t nchunks = (len-2 + chunkSize-1) / chunkSize;
 
-		//Save the last value
-		if(first)
+		//First pass: count transitions per chunk
+		vector<size_t> counts(nchunks, 0);
+		#pragma omp parallel for
+		for(size_t c=0; c<nchunks; c++)
 		{
-			last = value;
-			first = false;
-			continue;
+			size_t istart = 2 + c*chunkSize;
+			size_t iend = min(istart + chunkSize, len);
+			size_t n = 0;
+			for(size_t i=istart; i<iend; i++)
+			{
+				if(data->m_samples[i] != data->m_samples[i-1])
+					n ++;
+			}
+			counts[c] = n;
 		}
 
-		//Skip samples with no transition
-		if(last == value)
-			continue;
+		//Prefix sum so each chunk knows where its edges land in the output
+		vector<size_t> offsets(nchunks, 0);
+		size_t total = edges.size();
+		for(size_t c=0; c<nchunks; c++)
+		{
+			offsets[c] = total;
+			total += counts[c];
+		}
+		edges.resize(total);
 
-		edges.push_back(phoff + data->m_timescale * i);
-		last = value;
+		//Second pass: write the edge timestamps
+		#pragma omp parallel for
+		for(size_t c=0; c<nchunks; c++)
+		{
+			size_t istart = 2 + c*chunkSize;
+			size_t iend = min(istart + chunkSize, len);
+			size_t iout = offsets[c];
+			for(size_t i=istart; i<iend; i++)
+			{
+				if(data->m_samples[i] != data->m_samples[i-1])
+					edges[iout ++] = phoff + data->m_timescale * i;
+			}
+		}
+	}
+
+	//Short waveform, not worth spinning up threads for
+	else
+	{
+		bool first = true;
+		bool last = data->m_samples[0];
+		for(size_t i=1; i<len; i++)
+		{
+			bool value = data->m_samples[i];
+
+			//Save the last value
+			if(first)
+			{
+				last = value;
+				first = false;
+				continue;
+			}
+
+			//Skip samples with no transition
+			if(last == value)
+				continue;
+
+			edges.push_back(phoff + data->m_timescale * i);
+			last = value;
+		}
 	}
+
+	//Add to cache
+	lock_guard<mutex> lock(m_cacheMutex);
+	m_zeroCrossingCache[cachekey] = edges;
 }
 
 /**
@@ -829,6 +989,184 @@ void Filter::Refresh(vk::raii::CommandBuffer& cmdBuf, shared_ptr<QueueHandle> qu
 	}
 }
 
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Elementwise filter fusion
+
+/**
+	@brief Reports the elementwise operation this filter currently implements, if any
+
+	Filters which are (in their current configuration) a simple per-sample transform of one analog input should
+	override this and fill out op, allowing the FilterGraphExecutor to fuse chains of such filters into a single
+	compute dispatch. The default implementation reports that the filter is not elementwise.
+ */
+bool Filter::GetElementwiseOperation(ElementwiseOperation& /*op*/)
+{
+	return false;
+}
+
+/**
+	@brief Executes a linear chain of elementwise filters as a single compute dispatch
+
+	The chain's input is read once, the full program of operations is applied in registers, and only the final
+	filter's output is written back. Intermediate filters in the chain get no output waveform.
+
+	Returns false without executing anything if the chain cannot be fused as currently configured (no analog
+	input waveform, too many stages, or a stage no longer reports an elementwise operation); the caller is then
+	responsible for refreshing each filter individually.
+ */
+bool Filter::RefreshFusedElementwiseChain(
+	const vector<Filter*>& chain,
+	vk::raii::CommandBuffer& cmdBuf,
+	shared_ptr<QueueHandle> queue,
+	ComputePipeline& pipeline)
+{
+	//Collect the operation program
+	if(chain.size() > ELEMENTWISE_CHAIN_MAX_OPS)
+		return false;
+	ElementwiseChainShaderArgs args;
+	for(size_t i=0; i<chain.size(); i++)
+	{
+		ElementwiseOperation op;
+		if(!chain[i]->GetElementwiseOperation(op))
+			return false;
+		args.op[i] = op.m_op;
+		args.operand[i] = op.m_operand;
+	}
+	args.numOps = chain.size();
+
+	//Find the head's analog vector input, which feeds the whole chain
+	auto head = chain.front();
+	WaveformBase* din = nullptr;
+	for(size_t i=0; i<head->GetInputCount(); i++)
+	{
+		if(head->GetInput(i).GetType() == Stream::STREAM_TYPE_ANALOG)
+		{
+			din = head->GetInputWaveform(i);
+			break;
+		}
+	}
+	if(!din)
+		return false;
+	auto sdin = dynamic_cast<SparseAnalogWaveform*>(din);
+	auto udin = dynamic_cast<UniformAnalogWaveform*>(din);
+	size_t len = din->size();
+	if( (!sdin && !udin) || !len )
+		return false;
+	args.size = len;
+
+	//Intermediate stages don't get their output materialized in fused mode
+	for(size_t i=0; i+1 < chain.size(); i++)
+		chain[i]->SetData(nullptr, 0);
+
+	//Set up the output on the last filter in the chain, copying timebase (and timestamps, if sparse)
+	//from the chain's input
+	auto tail = chain.back();
+	tail->m_streams[0].m_stype = Stream::STREAM_TYPE_ANALOG;
+	SparseAnalogWaveform* scap = nullptr;
+	UniformAnalogWaveform* ucap = nullptr;
+	if(sdin)
+	{
+		scap = tail->SetupSparseOutputWaveform(sdin, 0, 0, 0);
+		scap->Resize(len);
+	}
+	else
+	{
+		ucap = tail->SetupEmptyUniformAnalogOutputWaveform(udin, 0);
+		ucap->Resize(len);
+	}
+	auto& samplesIn = sdin ? sdin->m_samples : udin->m_samples;
+	auto& samplesOut = scap ? scap->m_samples : ucap->m_samples;
+
+	//One dispatch for the entire chain
+	cmdBuf.begin({});
+	pipeline.BindBufferNonblocking(0, samplesIn, cmdBuf);
+	pipeline.BindBufferNonblocking(1, samplesOut, cmdBuf, true);
+	pipeline.Dispatch(cmdBuf, args, GetComputeBlockCount(len, 64));
+	cmdBuf.end();
+	queue->SubmitAndBlock(cmdBuf);
+	samplesOut.MarkModifiedFromGpu();
+
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Batched execution
+
+/**
+	@brief Returns a key identifying which other filters this one can execute in a batch with, if any
+
+	Filters whose GPU work can be packed into a single set of dispatches with other identically-configured
+	instances (e.g. several same-length FFTs becoming one batched VkFFT call) should override this and return
+	a nonempty string encoding everything that must match for the instances to share a dispatch. During pass
+	setup the FilterGraphExecutor groups ready-to-run filters by key and hands each group of two or more to
+	RefreshBatch() on the first member. The default implementation reports that the filter is not batchable.
+ */
+string Filter::GetBatchKey()
+{
+	return "";
+}
+
+/**
+	@brief Executes a group of filters which all returned the same batch key as a single batched operation
+
+	Called on the first filter of the group, with the group (including the callee) as an argument. The callee
+	is responsible for producing the output waveforms of every filter in the group.
+
+	Returns false without executing anything if the group cannot be batched as currently configured (an input
+	changed size between pass setup and execution, etc); the caller is then responsible for refreshing each
+	filter individually.
+ */
+bool Filter::RefreshBatch(
+	const vector<Filter*>& /*filters*/,
+	vk::raii::CommandBuffer& /*cmdBuf*/,
+	shared_ptr<QueueHandle> /*queue*/)
+{
+	return false;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Deferred GPU completion
+
+/**
+	@brief Submits GPU work at the end of Refresh(), without blocking if the scheduler allows it
+
+	Call this in place of queue->SubmitAndBlock(cmdBuf) as the final action of a GPU Refresh() path whose
+	outputs are fully produced by the submitted command buffer. If the scheduler granted deferred completion
+	(every consumer of our output can chain to the submission device side), the buffer goes into the queue's
+	batch and the host never waits on it; consumers are ordered by queue submission order or a timeline
+	semaphore wait, and the scheduler drains everything at the end of the pass. Otherwise this is just a
+	plain blocking submit.
+
+	Callers must not reset or re-record cmdBuf afterwards within the same Refresh(): when the submission is
+	deferred, the buffer stays in flight after we return.
+ */
+void Filter::SubmitOrDefer(vk::raii::CommandBuffer& cmdBuf, shared_ptr<QueueHandle> queue)
+{
+	if(m_deferredCompletionAllowed && g_hasTimelineSemaphore)
+	{
+		m_pendingSubmitValue = queue->SubmitBatched(cmdBuf);
+		m_pendingSubmitQueue = queue;
+
+		//One-shot: a subsequent Refresh() outside the scheduler must not defer
+		m_deferredCompletionAllowed = false;
+	}
+	else
+		queue->SubmitAndBlock(cmdBuf);
+}
+
+/**
+	@brief Blocks until our deferred submission (if any) has completed, then clears the sync point
+ */
+void Filter::ResolveDeferredCompletion()
+{
+	if(!m_pendingSubmitQueue)
+		return;
+
+	m_pendingSubmitQueue->FlushBatchAndBlock();
+	m_pendingSubmitQueue = nullptr;
+	m_pendingSubmitValue = 0;
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Serialization
 
@@ -1035,6 +1373,116 @@ void Filter::ClearAnalysisCache()
 {
 	lock_guard<mutex> lock(m_cacheMutex);
 	m_zeroCrossingCache.clear();
+	m_statsCache.clear();
+}
+
+/**
+	@brief Computes fused statistics for a waveform in a single pass, using cached results if available
+ */
+WaveformStats Filter::GetWaveformStats(SparseAnalogWaveform* s, UniformAnalogWaveform* u)
+{
+	WaveformBase* key = s ? static_cast<WaveformBase*>(s) : static_cast<WaveformBase*>(u);
+
+	//Check cache
+	{
+		lock_guard<mutex> lock(m_cacheMutex);
+		auto it = m_statsCache.find(key);
+		if(it != m_statsCache.end())
+			return it->second;
+	}
+
+	auto& samples = s ? s->m_samples : u->m_samples;
+	size_t len = samples.size();
+
+	//Min/max and the sums all come out of one fused pass over the sample data
+	float vmin = FLT_MAX;
+	float vmax = -FLT_MAX;
+	double sum = 0;
+	double sumSquares = 0;
+	#pragma omp parallel for reduction(min:vmin) reduction(max:vmax) reduction(+:sum,sumSquares)
+	for(size_t i=0; i<len; i++)
+	{
+		float f = samples[i];
+		vmin = min(vmin, f);
+		vmax = max(vmax, f);
+		sum += f;
+		sumSquares += (double)f * f;
+	}
+
+	WaveformStats stats;
+	stats.m_min = vmin;
+	stats.m_max = vmax;
+	stats.m_sum = sum;
+	stats.m_sumSquares = sumSquares;
+	stats.m_count = len;
+
+	//The histogram needs the bounds, so it has to be a second pass
+	stats.m_histogram = MakeHistogram(s, u, vmin, vmax, 100);
+
+	//Add to cache
+	lock_guard<mutex> lock(m_cacheMutex);
+	m_statsCache[key] = stats;
+	return stats;
+}
+
+float Filter::GetMinVoltage(SparseAnalogWaveform* s, UniformAnalogWaveform* u)
+{
+	return GetWaveformStats(s, u).m_min;
+}
+
+float Filter::GetMaxVoltage(SparseAnalogWaveform* s, UniformAnalogWaveform* u)
+{
+	return GetWaveformStats(s, u).m_max;
+}
+
+float Filter::GetAvgVoltage(SparseAnalogWaveform* swfm, UniformAnalogWaveform* uwfm)
+{
+	auto stats = GetWaveformStats(swfm, uwfm);
+	return stats.m_sum / stats.m_count;
+}
+
+float Filter::GetBaseVoltage(SparseAnalogWaveform* swfm, UniformAnalogWaveform* uwfm)
+{
+	auto stats = GetWaveformStats(swfm, uwfm);
+	float delta = stats.m_max - stats.m_min;
+	const int nbins = 100;
+
+	//Find the highest peak in the first quarter of the histogram
+	size_t binval = 0;
+	int idx = 0;
+	for(int i=0; i<(nbins/4); i++)
+	{
+		if(stats.m_histogram[i] > binval)
+		{
+			binval = stats.m_histogram[i];
+			idx = i;
+		}
+	}
+
+	float fbin = (idx + 0.5f)/nbins;
+	return fbin*delta + stats.m_min;
+}
+
+float Filter::GetTopVoltage(SparseAnalogWaveform* swfm, UniformAnalogWaveform* uwfm)
+{
+	auto stats = GetWaveformStats(swfm, uwfm);
+	float delta = stats.m_max - stats.m_min;
+	const int nbins = 100;
+
+	//Find the highest peak in the third quarter of the histogram
+	size_t binval = 0;
+	int idx = 0;
+	for(int i=(nbins*3)/4; i<nbins; i++)
+	{
+		if(stats.m_histogram[i] > binval)
+		{
+			binval = stats.m_histogram[i];
+			idx = i;
+		}
+	}
+
+	float fbin = (idx + 0.5f)/nbins;
+	return fbin*delta + stats.m_min;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -1499,6 +1947,101 @@ bool Filter::NeedsConfig()
 	return false;
 }
 
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Viewport hinting for windowed re-decode
+
+/**
+	@brief Restricts fine-grained decoding to the given time range (fs, same epoch as waveform timestamps)
+
+	Propagates recursively up the chain of filters feeding this one, so zooming into a displayed decode narrows
+	every stage below it too. Filters that support windowed decode (UsesVisibleWindow) are marked dirty so the
+	next graph pass re-runs them over the new window; everything else ignores the hint and keeps its full-capture
+	output (e.g. summary statistics from the last coarse pass).
+ */
+void Filter::SetVisibleWindow(int64_t start, int64_t end)
+{
+	//No-op if the window didn't move (also breaks recursion on convergent graph paths)
+	if(m_visibleWindowValid && (m_visibleWindowStart == start) && (m_visibleWindowEnd == end) )
+		return;
+
+	m_visibleWindowValid = true;
+	m_visibleWindowStart = start;
+	m_visibleWindowEnd = end;
+
+	if(UsesVisibleWindow())
+		MarkDirty();
+
+	for(size_t i=0; i<GetInputCount(); i++)
+	{
+		auto f = dynamic_cast<Filter*>(GetInput(i).m_channel);
+		if(f)
+			f->SetVisibleWindow(start, end);
+	}
+}
+
+/**
+	@brief Removes the visible-window restriction (returning to full-capture decode), propagating upstream
+ */
+void Filter::ClearVisibleWindow()
+{
+	if(!m_visibleWindowValid)
+		return;
+
+	m_visibleWindowValid = false;
+
+	if(UsesVisibleWindow())
+		MarkDirty();
+
+	for(size_t i=0; i<GetInputCount(); i++)
+	{
+		auto f = dynamic_cast<Filter*>(GetInput(i).m_channel);
+		if(f)
+			f->ClearVisibleWindow();
+	}
+}
+
+/**
+	@brief Returns the active visible window, or false if decoding should cover the full capture
+ */
+bool Filter::GetVisibleWindow(int64_t& start, int64_t& end)
+{
+	if(!m_visibleWindowValid)
+		return false;
+
+	start = m_visibleWindowStart;
+	end = m_visibleWindowEnd;
+	return true;
+}
+
+/**
+	@brief Converts the active visible window to a sample index range [istart, iend) of a sparse waveform
+
+	The waveform's offsets must already be in femtoseconds (as produced by the SampleOn*Edges helpers) and
+	CPU-accessible. With no window active the full [0, len) range is returned.
+ */
+void Filter::GetVisibleWindowIndices(SparseWaveformBase* wfm, size_t len, size_t& istart, size_t& iend)
+{
+	istart = 0;
+	iend = len;
+	if(!m_visibleWindowValid || (len == 0) )
+		return;
+
+	int64_t* offsets = wfm->m_offsets.GetCpuPointer();
+
+	//First sample ending at or after the window start (back up one so a sample spanning the edge is included)
+	size_t lo = BinarySearchForGequal(offsets, len, m_visibleWindowStart);
+	if(lo > 0)
+		lo --;
+
+	//First sample starting after the window end
+	size_t hi = BinarySearchForGequal(offsets, len, m_visibleWindowEnd);
+	while( (hi < len) && (offsets[hi] <= m_visibleWindowEnd) )
+		hi ++;
+
+	istart = lo;
+	iend = hi;
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Vertical scaling
 
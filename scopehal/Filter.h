@@ -75,6 +75,25 @@ public:
 	uint64_t m_rev;
 };
 
+/**
+	@brief Fused single-pass statistics for an analog waveform
+
+	Computed once per waveform per filter graph pass and shared by every filter that measures the waveform,
+	so stacking many scalar measurements on one channel only costs a single pass over the sample data.
+ */
+class WaveformStats
+{
+public:
+	float m_min;
+	float m_max;
+	double m_sum;
+	double m_sumSquares;
+	size_t m_count;
+
+	///@brief Histogram of sample values: 100 bins spanning [m_min, m_max]
+	std::vector<size_t> m_histogram;
+};
+
 /**
 	@brief Abstract base class for all filters and protocol decoders
  */
@@ -180,6 +199,26 @@ public:
 	 */
 	virtual std::string GetProtocolDisplayName() =0;
 
+	/**
+		@brief Returns the telemetry counter tracking total samples produced by this filter class
+
+		Shared by all instances of the class; created lazily since the display name isn't available until the
+		leaf class is constructed.
+	 */
+	PerfCounter& GetSamplesProcessedCounter()
+	{
+		if(!m_samplesProcessedCounter)
+		{
+			m_samplesProcessedCounter = &g_perfCounters.GetCounter(
+				std::string("filter.") + GetProtocolDisplayName() + ".samples", "samples");
+		}
+		return *m_samplesProcessedCounter;
+	}
+
+protected:
+	///@brief Telemetry counter for samples produced (owned by the registry)
+	PerfCounter* m_samplesProcessedCounter;
+
 public:
 	/**
 		@brief Clears any integrated data from past triggers (e.g. eye patterns).
@@ -194,6 +233,130 @@ public:
 	//GPU accelerated refresh method
 	virtual void Refresh(vk::raii::CommandBuffer& cmdBuf, std::shared_ptr<QueueHandle> queue) override;
 
+	////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	// Elementwise filter fusion
+
+	/**
+		@brief A single per-sample operation applied uniformly to every sample of an analog waveform
+
+		Opcode values must match those in ElementwiseChain.glsl.
+	 */
+	struct ElementwiseOperation
+	{
+		enum op_t
+		{
+			OP_ADD,			//out = in + operand
+			OP_MULTIPLY,	//out = in * operand
+			OP_MIN,			//out = min(in, operand)
+			OP_MAX			//out = max(in, operand)
+		} m_op;
+
+		float m_operand;
+	};
+
+	virtual bool GetElementwiseOperation(ElementwiseOperation& op);
+
+	static bool RefreshFusedElementwiseChain(
+		const std::vector<Filter*>& chain,
+		vk::raii::CommandBuffer& cmdBuf,
+		std::shared_ptr<QueueHandle> queue,
+		ComputePipeline& pipeline);
+
+	////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	// Batched execution
+
+	virtual std::string GetBatchKey();
+
+	virtual bool RefreshBatch(
+		const std::vector<Filter*>& filters,
+		vk::raii::CommandBuffer& cmdBuf,
+		std::shared_ptr<QueueHandle> queue);
+
+	////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	// Deferred GPU completion
+
+	/**
+		@brief Returns true if Refresh() only ever touches input sample data from GPU dispatches
+
+		When true, the scheduler may run this filter while the submission producing one of its inputs is still
+		in flight: ordering is guaranteed device side (queue submission order for same-queue producers, or a
+		timeline semaphore wait for cross-queue ones) with no host round trip in between. Any filter with a
+		CPU path that reads input samples, directly or via PrepareForCpuAccess(), must return false (the
+		default).
+	 */
+	virtual bool CanConsumeDeferredInputs()
+	{ return false; }
+
+	/**
+		@brief Called by the scheduler before Refresh() when every consumer of this filter's output can chain
+		to it device side, letting SubmitOrDefer() skip its blocking wait.
+
+		One-shot: consumed by SubmitOrDefer() and cleared by the scheduler after Refresh() returns, so a
+		Refresh() outside the scheduler never sees a stale grant.
+	 */
+	void SetDeferredCompletionAllowed(bool allowed)
+	{ m_deferredCompletionAllowed = allowed; }
+
+	///@brief Returns true if our last submission has not yet been synchronized with the host
+	bool IsDeferredCompletionPending()
+	{ return m_pendingSubmitQueue != nullptr; }
+
+	///@brief Returns the queue holding our deferred submission (null if none pending)
+	std::shared_ptr<QueueHandle> GetPendingSubmitQueue()
+	{ return m_pendingSubmitQueue; }
+
+	///@brief Returns the timeline semaphore value our deferred submission signals on completion
+	uint64_t GetPendingSubmitValue()
+	{ return m_pendingSubmitValue; }
+
+	void ResolveDeferredCompletion();
+
+protected:
+	void SubmitOrDefer(vk::raii::CommandBuffer& cmdBuf, std::shared_ptr<QueueHandle> queue);
+
+	///@brief True if the scheduler has allowed our next submission to complete asynchronously
+	bool m_deferredCompletionAllowed;
+
+	///@brief Queue holding our deferred submission, if any
+	std::shared_ptr<QueueHandle> m_pendingSubmitQueue;
+
+	///@brief Timeline semaphore value signaled when our deferred submission completes
+	uint64_t m_pendingSubmitValue;
+
+public:
+	////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	// Viewport hinting for windowed re-decode
+
+	/**
+		@brief Returns true if this filter restricts fine-grained decoding to the visible window
+
+		Filters returning true are marked dirty when the window hint changes, so the next graph pass re-runs
+		them over the new window. The default implementation ignores window hints entirely.
+	 */
+	virtual bool UsesVisibleWindow()
+	{ return false; }
+
+	void SetVisibleWindow(int64_t start, int64_t end);
+	void ClearVisibleWindow();
+
+	///@brief Returns true if a visible-window restriction is currently active
+	bool HasVisibleWindow()
+	{ return m_visibleWindowValid; }
+
+protected:
+	bool GetVisibleWindow(int64_t& start, int64_t& end);
+	void GetVisibleWindowIndices(SparseWaveformBase* wfm, size_t len, size_t& istart, size_t& iend);
+
+	///@brief True if a visible-window restriction is active
+	bool m_visibleWindowValid;
+
+	///@brief Start of the visible window, in fs
+	int64_t m_visibleWindowStart;
+
+	///@brief End of the visible window, in fs
+	int64_t m_visibleWindowEnd;
+
+public:
 	////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 	// Vertical scaling
 
@@ -287,6 +450,15 @@ public:
 	}
 
 protected:
+	/*
+		Output reuse contract: Refresh() implementations should obtain output waveforms through these helpers
+		(or an equivalent GetData() dynamic_cast-and-reuse pattern) rather than unconditionally allocating
+		fresh ones. The helpers recycle the previous trigger's output object when its type matches, so in
+		steady state - where waveform sizes are stable from trigger to trigger - clear() and Resize() run
+		entirely within the retained capacity and no AcceleratorBuffer reallocation or GPU buffer recreation
+		happens at all. Calling SetData() with a newly allocated waveform every pass defeats this and costs a
+		heap allocation plus a device buffer rebuild per trigger.
+	 */
 	UniformAnalogWaveform* SetupEmptyUniformAnalogOutputWaveform(WaveformBase* din, size_t stream, bool clear=true);
 	SparseAnalogWaveform* SetupEmptySparseAnalogOutputWaveform(WaveformBase* din, size_t stream, bool clear=true);
 	UniformDigitalWaveform* SetupEmptyUniformDigitalOutputWaveform(WaveformBase* din, size_t stream);
@@ -396,15 +568,19 @@ public:
 	}
 
 	/**
-		@brief Gets the lowest voltage of a waveform
+		@brief Gets the lowest voltage of a waveform, using cached single-pass statistics
 	 */
-	static float GetMinVoltage(SparseAnalogWaveform* s, UniformAnalogWaveform* u)
-	{
-		if(s)
-			return GetMinVoltage(s);
-		else
-			return GetMinVoltage(u);
-	}
+	static float GetMinVoltage(SparseAnalogWaveform* s, UniformAnalogWaveform* u);
+
+	/**
+		@brief Computes fused statistics for a waveform in a single pass, using cached results if available
+
+		Results are cached until the end of the current filter graph pass, so any number of measurement
+		filters can consume the statistics while only paying for one pass over the sample data.
+
+		The caller is expected to dynamic_cast the waveform twice and pass both copies, one of which should be null.
+	 */
+	static WaveformStats GetWaveformStats(SparseAnalogWaveform* s, UniformAnalogWaveform* u);
 
 	/**
 		@brief Gets the highest voltage of a waveform
@@ -426,15 +602,9 @@ public:
 	}
 
 	/**
-		@brief Gets the lowest voltage of a waveform
+		@brief Gets the highest voltage of a waveform, using cached single-pass statistics
 	 */
-	static float GetMaxVoltage(SparseAnalogWaveform* s, UniformAnalogWaveform* u)
-	{
-		if(s)
-			return GetMaxVoltage(s);
-		else
-			return GetMaxVoltage(u);
-	}
+	static float GetMaxVoltage(SparseAnalogWaveform* s, UniformAnalogWaveform* u);
 
 	/**
 		@brief Gets the most probable "0" level for a digital waveform
@@ -468,15 +638,9 @@ public:
 	}
 
 	/**
-		@brief Gets the base voltage of a waveform which may be sparse or uniform
+		@brief Gets the base voltage of a waveform which may be sparse or uniform, using cached single-pass statistics
 	 */
-	static float GetBaseVoltage(SparseAnalogWaveform* swfm, UniformAnalogWaveform* uwfm)
-	{
-		if(swfm)
-			return GetBaseVoltage(swfm);
-		else
-			return GetBaseVoltage(uwfm);
-	}
+	static float GetBaseVoltage(SparseAnalogWaveform* swfm, UniformAnalogWaveform* uwfm);
 
 	/**
 		@brief Gets the most probable "1" level for a digital waveform
@@ -510,15 +674,9 @@ public:
 	}
 
 	/**
-		@brief Gets the top voltage of a waveform which may be sparse or uniform
+		@brief Gets the top voltage of a waveform which may be sparse or uniform, using cached single-pass statistics
 	 */
-	static float GetTopVoltage(SparseAnalogWaveform* swfm, UniformAnalogWaveform* uwfm)
-	{
-		if(swfm)
-			return GetTopVoltage(swfm);
-		else
-			return GetTopVoltage(uwfm);
-	}
+	static float GetTopVoltage(SparseAnalogWaveform* swfm, UniformAnalogWaveform* uwfm);
 
 	/**
 		@brief Gets the average voltage of a waveform
@@ -538,15 +696,9 @@ public:
 	}
 
 	/**
-		@brief Gets the average voltage of a waveform which may be sparse or uniform
+		@brief Gets the average voltage of a waveform which may be sparse or uniform, using cached single-pass statistics
 	 */
-	static float GetAvgVoltage(SparseAnalogWaveform* swfm, UniformAnalogWaveform* uwfm)
-	{
-		if(swfm)
-			return GetAvgVoltage(swfm);
-		else
-			return GetAvgVoltage(uwfm);
-	}
+	static float GetAvgVoltage(SparseAnalogWaveform* swfm, UniformAnalogWaveform* uwfm);
 
 	/**
 		@brief Makes a histogram from a waveform with the specified number of bins.
@@ -1113,16 +1265,24 @@ protected:
 
 public:
 	typedef Filter* (*CreateProcType)(const std::string&);
+	typedef std::string (*ProtocolNameProcType)();
 	static void DoAddDecoderClass(const std::string& name, CreateProcType proc);
+	static void DoAddDecoderClass(ProtocolNameProcType nameproc, CreateProcType proc);
 
 	static void EnumProtocols(std::vector<std::string>& names);
 	static Filter* CreateFilter(const std::string& protocol, const std::string& color = "#ffffff");
 
 protected:
+	static void LoadPendingDecoderClasses();
+
 	//Class enumeration
 	typedef std::map< std::string, CreateProcType > CreateMapType;
 	static CreateMapType m_createprocs;
 
+	//Classes registered but not yet added to m_createprocs (so startup doesn't resolve ~200 protocol names
+	//that may never be used; see LoadPendingDecoderClasses)
+	static std::vector< std::pair<ProtocolNameProcType, CreateProcType> > m_pendingProcs;
+
 	//Object enumeration
 	static std::set<Filter*> m_filters;
 
@@ -1132,6 +1292,7 @@ protected:
 	//Caching
 	static std::mutex m_cacheMutex;
 	static std::map<std::pair<WaveformBase*, float>, std::vector<int64_t> > m_zeroCrossingCache;
+	static std::map<WaveformBase*, WaveformStats> m_statsCache;
 };
 
 #define PROTOCOL_DECODER_INITPROC(T) \
@@ -1142,6 +1303,6 @@ protected:
 	virtual std::string GetProtocolDisplayName() override \
 	{ return GetProtocolName(); }
 
-#define AddDecoderClass(T) Filter::DoAddDecoderClass(T::GetProtocolName(), T::CreateInstance)
+#define AddDecoderClass(T) Filter::DoAddDecoderClass(T::GetProtocolName, T::CreateInstance)
 
 #endif
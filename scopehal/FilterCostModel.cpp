@@ -0,0 +1,214 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Implementation of FilterCostModel
+ */
+#include "scopehal.h"
+#include "PipelineCacheManager.h"
+
+#include <cinttypes>
+#include <sstream>
+
+using namespace std;
+
+FilterCostModel g_filterCostModel;
+
+extern unique_ptr<PipelineCacheManager> g_pipelineCacheMgr;
+
+///@brief Key the decision table is stored under in the pipeline cache
+static const char* g_costModelCacheKey = "filterCostModel";
+
+FilterCostModel::FilterCostModel()
+	: m_loaded(false)
+	, m_recordsSinceStore(0)
+{
+}
+
+///@brief Returns the power-of-two bucket a given work size falls in
+size_t FilterCostModel::Bucket(uint64_t work)
+{
+	size_t b = 0;
+	while(work >>= 1)
+		b ++;
+	return b;
+}
+
+/**
+	@brief Predicts the runtime of one path at a given bucket, or a negative value if the path has
+	never been measured for this filter class
+
+	Cost is roughly linear in work for both paths, so estimates from the nearest measured bucket are
+	scaled by the bucket distance.
+ */
+double FilterCostModel::PredictNs(map<size_t, BucketStats>& buckets, size_t bucket, bool gpu)
+{
+	double best = -1;
+	size_t bestDistance = 0;
+	for(auto& it : buckets)
+	{
+		auto& stats = gpu ? it.second.m_gpu : it.second.m_cpu;
+		if(stats.m_count == 0)
+			continue;
+
+		size_t distance = (it.first > bucket) ? (it.first - bucket) : (bucket - it.first);
+		if( (best < 0) || (distance < bestDistance) )
+		{
+			bestDistance = distance;
+			if(it.first > bucket)
+				best = stats.m_avgNs / (double)(1ULL << distance);
+			else
+				best = stats.m_avgNs * (double)(1ULL << distance);
+		}
+	}
+	return best;
+}
+
+/**
+	@brief Returns true if the GPU path is predicted to be faster than the CPU path for this much work
+
+	Callers are expected to report the actual runtime of whichever path they took via Record(), so the
+	prediction improves over time. The caller is responsible for checking g_gpuFilterEnabled.
+ */
+bool FilterCostModel::PreferGpu(const string& filterClass, uint64_t work)
+{
+	lock_guard<mutex> lock(m_mutex);
+	LoadIfNeeded();
+
+	auto& buckets = m_table[filterClass];
+	size_t bucket = Bucket(work);
+
+	//Exact bucket measured on both paths: direct comparison
+	auto it = buckets.find(bucket);
+	if( (it != buckets.end()) && it->second.m_cpu.m_count && it->second.m_gpu.m_count)
+		return it->second.m_gpu.m_avgNs <= it->second.m_cpu.m_avgNs;
+
+	double cpu = PredictNs(buckets, bucket, false);
+	double gpu = PredictNs(buckets, bucket, true);
+
+	//Calibration: a path that has never been measured for this class is chosen once.
+	//GPU goes first, matching the old static behavior when nothing is known yet.
+	if(gpu < 0)
+		return true;
+	if(cpu < 0)
+		return false;
+
+	return gpu <= cpu;
+}
+
+/**
+	@brief Reports the measured runtime of one filter invocation
+ */
+void FilterCostModel::Record(const string& filterClass, bool gpu, uint64_t work, int64_t ns)
+{
+	lock_guard<mutex> lock(m_mutex);
+	LoadIfNeeded();
+
+	auto& bucket = m_table[filterClass][Bucket(work)];
+	auto& stats = gpu ? bucket.m_gpu : bucket.m_cpu;
+
+	//Exponential moving average so the model adapts to thermal or load changes,
+	//but the first observation seeds it directly
+	if(stats.m_count == 0)
+		stats.m_avgNs = ns;
+	else
+		stats.m_avgNs += 0.25 * (ns - stats.m_avgNs);
+	stats.m_count ++;
+
+	//Re-serialize the table now and then (eagerly while a bucket is fresh, since early observations
+	//move the averages the most)
+	m_recordsSinceStore ++;
+	if( (stats.m_count <= 4) || (m_recordsSinceStore >= 256) )
+		Store();
+}
+
+/**
+	@brief Loads the decision table persisted by a previous run
+ */
+void FilterCostModel::LoadIfNeeded()
+{
+	//Too early in startup (or a unit test without Vulkan): nowhere to load from, try again later
+	if(m_loaded || !g_pipelineCacheMgr)
+		return;
+	m_loaded = true;
+
+	auto blob = g_pipelineCacheMgr->LookupRaw(g_costModelCacheKey);
+	if(!blob)
+		return;
+
+	stringstream ss(string(blob->begin(), blob->end()));
+	string line;
+	while(getline(ss, line))
+	{
+		auto isplit = line.find(';');
+		if(isplit == string::npos)
+			continue;
+
+		size_t bucket;
+		BucketStats stats;
+		if(5 != sscanf(line.c_str() + isplit, ";%zu;%lf;%" SCNu64 ";%lf;%" SCNu64,
+			&bucket, &stats.m_cpu.m_avgNs, &stats.m_cpu.m_count, &stats.m_gpu.m_avgNs, &stats.m_gpu.m_count))
+		{
+			continue;
+		}
+
+		m_table[line.substr(0, isplit)][bucket] = stats;
+	}
+}
+
+/**
+	@brief Re-serializes the decision table so it gets persisted with the rest of the pipeline cache
+ */
+void FilterCostModel::Store()
+{
+	if(!g_pipelineCacheMgr)
+		return;
+	m_recordsSinceStore = 0;
+
+	string blob;
+	char tmp[256];
+	for(auto& fit : m_table)
+	{
+		for(auto& bit : fit.second)
+		{
+			snprintf(tmp, sizeof(tmp), "%s;%zu;%f;%" PRIu64 ";%f;%" PRIu64 "\n",
+				fit.first.c_str(),
+				bit.first,
+				bit.second.m_cpu.m_avgNs,
+				bit.second.m_cpu.m_count,
+				bit.second.m_gpu.m_avgNs,
+				bit.second.m_gpu.m_count);
+			blob += tmp;
+		}
+	}
+
+	g_pipelineCacheMgr->StoreRaw(g_costModelCacheKey, make_shared< vector<uint8_t> >(blob.begin(), blob.end()));
+}
@@ -0,0 +1,94 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Declaration of FilterCostModel
+ */
+#ifndef FilterCostModel_h
+#define FilterCostModel_h
+
+/**
+	@brief Measured cost model for filters with both CPU and GPU implementations
+
+	For small waveforms the GPU dispatch overhead loses, for big ones the CPU loses, and the crossover
+	depends on the machine. Rather than hardcoding thresholds, filters report the work size and runtime
+	of each invocation; the model keeps per-filter-class, per-size-bucket running averages of both paths
+	and predicts the faster one, extrapolating from the nearest measured bucket when an exact match is
+	not available. An unmeasured path is chosen once so it gets calibrated.
+
+	The decision table is persisted in the pipeline cache directory, so the calibration survives
+	restarts.
+ */
+class FilterCostModel
+{
+public:
+	FilterCostModel();
+
+	bool PreferGpu(const std::string& filterClass, uint64_t work);
+	void Record(const std::string& filterClass, bool gpu, uint64_t work, int64_t ns);
+
+protected:
+	///@brief Running statistics for one execution path in one bucket
+	struct PathStats
+	{
+		double m_avgNs;
+		uint64_t m_count;
+	};
+
+	///@brief CPU and GPU statistics for one power-of-two work-size bucket
+	struct BucketStats
+	{
+		PathStats m_cpu;
+		PathStats m_gpu;
+	};
+
+	static size_t Bucket(uint64_t work);
+	double PredictNs(std::map<size_t, BucketStats>& buckets, size_t bucket, bool gpu);
+
+	void LoadIfNeeded();
+	void Store();
+
+	///@brief Mutex to interlock access to the table
+	std::mutex m_mutex;
+
+	///@brief True once the persisted table has been loaded
+	bool m_loaded;
+
+	///@brief Observations since the table was last re-serialized
+	size_t m_recordsSinceStore;
+
+	///@brief Statistics per filter class, per work-size bucket
+	std::map<std::string, std::map<size_t, BucketStats> > m_table;
+};
+
+extern FilterCostModel g_filterCostModel;
+
+#endif
@@ -28,19 +28,54 @@
 ***********************************************************************************************************************/
 
 #include "scopehal.h"
+#include "PausableFilter.h"
+
+#ifdef __linux__
+#include <sched.h>
+#include <cstring>
+#include <functional>
+#endif
 
 using namespace std;
 
+atomic<bool> FilterGraphExecutor::s_cancelRequested(false);
+atomic<FilterGraphExecutor::ThreadPlacement> FilterGraphExecutor::s_threadPlacement(
+	FilterGraphExecutor::PLACEMENT_AUTO);
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Construction / destruction
 
 FilterGraphExecutor::FilterGraphExecutor(size_t numThreads)
-	: m_allWorkersComplete(true)
+	: m_remainingNodes(0)
+	, m_allWorkersComplete(true)
+	, m_passPending(false)
+	, m_passStartWallclock(0)
 	, m_terminating(false)
+	, m_profilingEnabled(false)
+	, m_lastPassStartWallclock(0)
+	, m_fusionEnabled(false)
+	, m_batchingEnabled(false)
+	, m_prefetchEnabled(false)
+	, m_decimationEnabled(false)
+	, m_decimationFactor(1)
+	, m_targetPassLatency(0)
+	, m_avgPassLatency(0)
+	, m_passCount(0)
+	, m_scheduleMode(SCHEDULE_NORMAL)
+	, m_replayCursor(0)
+	, m_serialNodeInFlight(false)
+	, m_replayDiverged(false)
 {
-	//Create our thread pool
+	//Size the pool from the topology unless the caller picked a count
+	if(numThreads == 0)
+		numThreads = GetDefaultThreadCount();
+
+	//Create our thread pool (and one work-stealing deque per worker)
 	for(size_t i=0; i<numThreads; i++)
+	{
+		m_queues.push_back(make_unique<WorkerQueue>());
 		m_threads.push_back(make_unique<thread>(&FilterGraphExecutor::ExecutorThread, this, i));
+	}
 }
 
 FilterGraphExecutor::~FilterGraphExecutor()
@@ -59,120 +94,950 @@ FilterGraphExecutor::~FilterGraphExecutor()
 	@brief Evaluates the filter graph, blocking until execution has completed
  */
 void FilterGraphExecutor::RunBlocking(const set<FlowGraphNode*>& nodes)
+{
+	//Wind down any speculative pass still in flight before looking at what's dirty: nodes it already
+	//evaluated are clean now, and ones whose inputs changed since have been re-marked dirty
+	WaitForPass();
+
+	if(StartPass(nodes))
+		WaitForPass();
+}
+
+/**
+	@brief Starts evaluating the filter graph speculatively, without blocking for completion.
+
+	Call this when part of a capture is available but the rest is still downloading: idle workers pre-run
+	everything that is currently dirty (e.g. decoders fed by channels that have already arrived) behind the
+	I/O. When the remaining data lands, the affected channels get re-marked dirty as usual, so the next
+	RunBlocking() re-runs exactly the subgraphs whose inputs actually changed — speculative results computed
+	from data that didn't change are kept, the rest are discarded by being recomputed.
+
+	Callers must invoke WaitForPass() (or another RunBlocking(), which waits internally) before consuming any
+	outputs, since the speculative pass may still be executing.
+
+	@return true if a speculative pass was started, false if there was nothing to run or a pass is in flight
+ */
+bool FilterGraphExecutor::StartSpeculativePass(const set<FlowGraphNode*>& nodes)
+{
+	//Never queue behind an in-flight pass: speculation is only worthwhile if workers are actually idle
+	{
+		lock_guard<mutex> lock(m_completionCvarMutex);
+		if(!m_allWorkersComplete)
+			return false;
+	}
+
+	return StartPass(nodes);
+}
+
+/**
+	@brief Sets up and launches a pass over the dirty subset of the given nodes
+
+	@return true if a pass was started, false if there was nothing to run
+ */
+bool FilterGraphExecutor::StartPass(const set<FlowGraphNode*>& nodes)
 {
 	//Nothing to do if we have no nodes to run
 	if(nodes.empty())
-		return;
+		return false;
+
+	m_passStartWallclock = GetTime();
 
 	{
 		lock_guard<mutex> lock(m_mutex);
 
 		if(!m_allWorkersComplete)
-			LogWarning("Entering RunBlocking() but not all workers are complete from previous run\n");
+			LogWarning("Starting a pass but not all workers are complete from previous run\n");
+
+		auto passNodes = nodes;
+		passNodes.erase(nullptr);	//don't crash if a null filter somehow ended up in the list
+
+		//Incremental execution: propagate dirty flags downstream until the set converges, then drop any node
+		//that is neither dirty itself nor downstream of a dirty node. Static reference waveforms, import
+		//filters, and anything else whose inputs didn't change keep their existing output untouched.
+		//Inputs fed by nodes outside the pass (typically instrument channels) count too: we consume their
+		//dirty flag here and taint their direct loads.
+		set<FlowGraphNode*> dirtySources;
+		for(auto f : passNodes)
+		{
+			for(size_t i=0; i<f->GetInputCount(); i++)
+			{
+				auto in = f->GetInput(i).m_channel;
+				if(in && (passNodes.find(in) == passNodes.end()) && in->IsDirty())
+				{
+					dirtySources.emplace(in);
+					f->MarkDirty();
+				}
+			}
+		}
+		for(auto s : dirtySources)
+			s->ClearDirty();
+		bool propagating = true;
+		while(propagating)
+		{
+			propagating = false;
+			for(auto f : passNodes)
+			{
+				if(f->IsDirty())
+					continue;
+				for(size_t i=0; i<f->GetInputCount(); i++)
+				{
+					auto in = f->GetInput(i).m_channel;
+					if( (passNodes.find(in) != passNodes.end()) && in->IsDirty() )
+					{
+						f->MarkDirty();
+						propagating = true;
+						break;
+					}
+				}
+			}
+		}
+		for(auto it = passNodes.begin(); it != passNodes.end(); )
+		{
+			if(!(*it)->IsDirty())
+				it = passNodes.erase(it);
+			else
+				++it;
+		}
+
+		//If nothing changed since the last pass, we're done already
+		if(passNodes.empty())
+			return false;
+
+		//Under load, defer cosmetic nodes on all but every Nth pass (see EnableAdaptiveDecimation)
+		m_passCount ++;
+		if(m_decimationEnabled && (m_decimationFactor > 1) && ( (m_passCount % m_decimationFactor) != 0) )
+		{
+			DropDecimatedNodes(passNodes);
+			if(passNodes.empty())
+				return false;
+		}
+
+		//Build the dependency graph for this pass: for each node, count how many of its inputs are produced
+		//by other nodes in the pass, and record the reverse (dependent) edges so completions can decrement
+		//the counters of downstream nodes without any global bookkeeping
+		m_dependents.clear();
+		m_remainingDeps.clear();
+		for(auto f : passNodes)
+		{
+			size_t ndeps = 0;
+			for(size_t i=0; i<f->GetInputCount(); i++)
+			{
+				auto in = f->GetInput(i).m_channel;
+				if(passNodes.find(in) != passNodes.end())
+				{
+					m_dependents[in].push_back(f);
+					ndeps ++;
+				}
+			}
+			m_remainingDeps.emplace(piecewise_construct, forward_as_tuple(f), forward_as_tuple(ndeps));
+		}
+
+		//Identify chains of elementwise filters that can be fused into a single dispatch
+		m_fusionChains.clear();
+		m_fusedMembers.clear();
+		if(m_fusionEnabled && g_gpuFilterEnabled)
+			FindElementwiseChains(passNodes);
+
+		//Identify groups of identically-configured filters that can be executed as one batched dispatch
+		m_batchGroups.clear();
+		m_batchMembers.clear();
+		if(m_batchingEnabled && g_gpuFilterEnabled)
+			FindBatchGroups(passNodes);
 
-		m_incompleteNodes = nodes;
-		m_incompleteNodes.erase(nullptr);	//don't crash if a null filter somehow ended up in the list
+		//Identify nodes whose GPU submissions can complete asynchronously, chained to their consumers
+		//device side rather than through a host round trip. Serialized scheduling modes skip this: a node's
+		//GPU work outliving its retirement would reorder effects behind the deterministic dispatch order.
+		ScheduleMode smode = m_scheduleMode;
+		bool serialized = (smode == SCHEDULE_REPLAY) || (smode == SCHEDULE_STRESS);
+		m_deferralAllowed.clear();
+		if(g_gpuFilterEnabled && g_hasTimelineSemaphore && !serialized)
+			FindDeferrableNodes(passNodes);
 
-		m_runnableNodes.clear();
+		m_remainingNodes = passNodes.size();
 		m_allWorkersComplete = false;
 
+		//Any cancellation request from before this point targeted a previous (now finished) pass
+		s_cancelRequested = false;
+
 		Filter::ClearAnalysisCache();
+
+		//Start the profiling clock for this pass
+		if(m_profilingEnabled)
+		{
+			lock_guard<mutex> plock(m_profileMutex);
+			m_passStartTime = chrono::steady_clock::now();
+			m_readyTimes.clear();
+			m_currentPassEvents.clear();
+		}
+
+		//Reset schedule recording / replay state for the new pass
+		if(smode != SCHEDULE_NORMAL)
+		{
+			lock_guard<mutex> rlock(m_replayMutex);
+			if( (smode == SCHEDULE_RECORD) || (smode == SCHEDULE_STRESS) )
+				m_recordedSchedule.clear();
+			m_replayCursor = 0;
+			m_serialNodeInFlight = false;
+			m_replayDiverged = false;
+		}
+
+		//Estimate each node's critical path so the long poles of the graph start as early as possible
+		ComputeCriticalPaths(passNodes);
+
+		//Distribute the initially runnable nodes (those with no in-pass dependencies) round robin
+		//across the worker deques so everyone has something to start on. Push in ascending critical
+		//path order: owners pop LIFO, so each worker starts on the longest pole it was dealt.
+		vector<FlowGraphNode*> seeds;
+		for(auto f : passNodes)
+		{
+			if(m_remainingDeps[f] == 0)
+				seeds.push_back(f);
+		}
+		sort(seeds.begin(), seeds.end(),
+			[this](FlowGraphNode* a, FlowGraphNode* b)
+			{ return m_criticalPath[a] < m_criticalPath[b]; });
+		size_t iq = 0;
+		for(auto f : seeds)
+		{
+			if(m_profilingEnabled)
+				RecordNodeReady(f);
+
+			lock_guard<mutex> qlock(m_queues[iq]->m_lock);
+			m_queues[iq]->m_deque.push_back(f);
+			iq = (iq + 1) % m_queues.size();
+		}
+	}
+
+	m_passPending = true;
+
+	//Wake up our workers
+	m_workerCvar.notify_all();
+	return true;
+}
+
+/**
+	@brief Blocks until the in-flight pass (if any) has fully completed and its results are safe to consume
+ */
+void FilterGraphExecutor::WaitForPass()
+{
+	//Nothing started (or already waited for)? Then there's nothing to wind down
+	if(!m_passPending.exchange(false))
+		return;
+
+	//Block until the workers are finished
+	{
+		unique_lock<mutex> lock(m_completionCvarMutex);
+		m_completionCvar.wait(lock, [this]{return m_allWorkersComplete;});
+	}
+
+	//Wind down any deferred GPU submissions so their outputs are safe for CPU-side consumers
+	//(usually a no-op, since workers drain their own queues as they finish the pass)
+	{
+		lock_guard<mutex> lock(m_deferredMutex);
+		for(auto f : m_deferredNodes)
+			f->ResolveDeferredCompletion();
+		m_deferredNodes.clear();
+	}
+
+	//Wait for any in-flight output readbacks to land before handing results back to the caller
+	{
+		lock_guard<mutex> lock(m_prefetchMutex);
+		for(auto& fut : m_prefetchFutures)
+			fut.wait();
+		m_prefetchFutures.clear();
+	}
+
+	//Publish the profiling data for the completed pass
+	if(m_profilingEnabled)
+	{
+		lock_guard<mutex> lock(m_profileMutex);
+		m_lastPassEvents = std::move(m_currentPassEvents);
+		m_currentPassEvents.clear();
+		m_lastPassStartWallclock = m_passStartWallclock;
+	}
+
+	//Always-on telemetry: record the wall-clock latency of the pass
+	double latency = GetTime() - m_passStartWallclock;
+	g_perfFilterPassLatency.Record(latency * 1e6);
+
+	//Steer the cosmetic decimation factor to keep up with the trigger rate
+	if(m_decimationEnabled)
+		UpdateDecimationFactor(latency);
+}
+
+/**
+	@brief Removes cosmetic nodes (and anything only they consume) from a decimated pass
+
+	A cosmetic node still runs if a non-cosmetic node consumes its output, directly or transitively: we can
+	defer someone's eye re-render, but not the input of a mask test. Dropped nodes keep their dirty flags, so
+	the next undecimated pass picks them up.
+ */
+void FilterGraphExecutor::DropDecimatedNodes(set<FlowGraphNode*>& passNodes)
+{
+	//Everything non-cosmetic must run
+	set<FlowGraphNode*> mustRun;
+	for(auto f : passNodes)
+	{
+		if(f->GetPriorityTier() != FlowGraphNode::PRIORITY_COSMETIC)
+			mustRun.emplace(f);
+	}
+
+	//...and so must everything a must-run node takes input from, transitively
+	bool growing = true;
+	while(growing)
+	{
+		growing = false;
+		for(auto f : passNodes)
+		{
+			if(mustRun.find(f) == mustRun.end())
+				continue;
+			for(size_t i=0; i<f->GetInputCount(); i++)
+			{
+				auto in = f->GetInput(i).m_channel;
+				if( (passNodes.find(in) != passNodes.end()) && (mustRun.find(in) == mustRun.end()) )
+				{
+					mustRun.emplace(in);
+					growing = true;
+				}
+			}
+		}
+	}
+
+	for(auto it = passNodes.begin(); it != passNodes.end(); )
+	{
+		if(mustRun.find(*it) == mustRun.end())
+			it = passNodes.erase(it);
+		else
+			++it;
+	}
+}
+
+/**
+	@brief Adjusts the decimation factor based on the measured latency of the pass that just finished
+
+	Uses an exponential moving average so a single slow pass doesn't slam the factor around, and a wide
+	deadband below the target so the factor doesn't oscillate as decimated (cheap) and full (expensive)
+	passes alternate.
+ */
+void FilterGraphExecutor::UpdateDecimationFactor(double latency)
+{
+	double target = m_targetPassLatency;
+	if(target <= 0)
+		return;
+
+	if(m_avgPassLatency == 0)
+		m_avgPassLatency = latency;
+	else
+		m_avgPassLatency = (m_avgPassLatency * 0.9) + (latency * 0.1);
+
+	size_t decim = m_decimationFactor;
+	if(m_avgPassLatency > target)
+	{
+		if(decim < MAX_DECIMATION)
+			m_decimationFactor = decim * 2;
+	}
+	else if( (m_avgPassLatency < (target * 0.4)) && (decim > 1) )
+		m_decimationFactor = decim / 2;
+}
+
+/**
+	@brief Requests cooperative cancellation of the in-progress pass.
+
+	Call this when fresher data arrives (e.g. a new trigger event) and the results of the pass currently
+	executing are already stale. Nodes that have not started yet are retired without running and keep their
+	dirty flags, so the next pass picks up exactly where this one left off; nodes already mid-execution finish
+	(or bail out early if they poll IsCancelPending()) and stay dirty as well. RunBlocking() then returns as
+	soon as the in-flight nodes have drained, rather than after the entire graph has been evaluated.
+
+	Safe to call from any thread. Has no effect if no pass is running.
+ */
+void FilterGraphExecutor::Cancel()
+{
+	s_cancelRequested = true;
+
+	//Wake any workers blocked waiting for new work so they drain their deques promptly
+	m_workerCvar.notify_all();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Scheduling
+
+/**
+	@brief Computes the estimated critical path length of every node in the pass
+
+	A node's critical path is its own estimated runtime plus the longest chain of dependent work downstream
+	of it; scheduling the highest ranked runnable node first minimizes the idle tail at the end of the pass,
+	where everyone waits on the one long pole that was started last. Estimates come from the rolling runtime
+	history; nodes we've never run get a deliberately pessimistic default so they're explored early and
+	measured.
+
+	Called from StartPass() with the dependency graph already built, before any worker starts.
+ */
+void FilterGraphExecutor::ComputeCriticalPaths(const set<FlowGraphNode*>& passNodes)
+{
+	m_criticalPath.clear();
+
+	//Estimated cost of a node with no history yet: 1 ms
+	const double defaultCost = 1e6;
+
+	lock_guard<mutex> lock(m_runtimeHistoryMutex);
+
+	//Memoized DFS over the dependent edges (recursion depth is bounded by the graph depth)
+	std::function<double(FlowGraphNode*)> rank = [&](FlowGraphNode* f) -> double
+	{
+		auto it = m_criticalPath.find(f);
+		if(it != m_criticalPath.end())
+			return it->second;
+
+		auto hit = m_runtimeHistory.find(f);
+		double cost = (hit != m_runtimeHistory.end()) ? hit->second : defaultCost;
+
+		double tail = 0;
+		auto dit = m_dependents.find(f);
+		if(dit != m_dependents.end())
+		{
+			for(auto d : dit->second)
+				tail = max(tail, rank(d));
+		}
+
+		double r = cost + tail;
+		m_criticalPath[f] = r;
+		return r;
+	};
+
+	for(auto f : passNodes)
+		rank(f);
+}
+
+/**
+	@brief Folds one measured execution into a node's rolling runtime estimate
+ */
+void FilterGraphExecutor::RecordNodeRuntime(FlowGraphNode* f, double ns)
+{
+	lock_guard<mutex> lock(m_runtimeHistoryMutex);
+	auto it = m_runtimeHistory.find(f);
+	if(it == m_runtimeHistory.end())
+		m_runtimeHistory[f] = ns;
+	else
+		it->second += 0.25 * (ns - it->second);
+}
+
+/**
+	@brief Pushes a newly runnable node onto worker i's deque and wakes up anyone who might want to steal it
+ */
+void FilterGraphExecutor::PushRunnable(FlowGraphNode* f, size_t i)
+{
+	if(m_profilingEnabled)
+		RecordNodeReady(f);
+
+	{
+		lock_guard<mutex> lock(m_queues[i]->m_lock);
+		m_queues[i]->m_deque.push_back(f);
+	}
+	m_workerCvar.notify_one();
+}
+
+/**
+	@brief Pops a node from worker i's own deque, or steals one from another worker if ours is empty
+
+	The owner pops from the back (most recently pushed, hottest in cache) while thieves take from the front,
+	minimizing contention between the victim and the thief.
+ */
+FlowGraphNode* FilterGraphExecutor::PopOrSteal(size_t i)
+{
+	//Fast path: grab from our own deque
+	{
+		lock_guard<mutex> lock(m_queues[i]->m_lock);
+		if(!m_queues[i]->m_deque.empty())
+		{
+			auto f = m_queues[i]->m_deque.back();
+			m_queues[i]->m_deque.pop_back();
+			return f;
+		}
+	}
+
+	//Our deque is empty, go try to steal from someone else's
+	for(size_t j=1; j<m_queues.size(); j++)
+	{
+		auto& victim = *m_queues[(i + j) % m_queues.size()];
+		lock_guard<mutex> lock(victim.m_lock);
+		if(!victim.m_deque.empty())
+		{
+			auto f = victim.m_deque.front();
+			victim.m_deque.pop_front();
+			return f;
+		}
+	}
+
+	return nullptr;
+}
+
+/**
+	@brief Returns the next filter available to run, blocking if none are ready.
+
+	Returns null if there are no remaining filters to evaluate in this pass.
+ */
+FlowGraphNode* FilterGraphExecutor::GetNextRunnableNode(size_t i)
+{
+	//Serialized debug modes dispatch one node at a time in a controlled order
+	ScheduleMode mode = m_scheduleMode;
+	if( (mode == SCHEDULE_REPLAY) || (mode == SCHEDULE_STRESS) )
+		return GetNextSerializedNode(i, mode == SCHEDULE_STRESS);
+
+	while(true)
+	{
+		//Pass is over? Stop
+		if(m_remainingNodes == 0)
+			return nullptr;
+
+		//Check for stuff in the deques
+		auto f = PopOrSteal(i);
+		if(f)
+		{
+			//If the pass has been cancelled, retire the node without running it so the pass drains quickly.
+			//It keeps its dirty flag and will be re-run by the next pass.
+			if(s_cancelRequested)
+			{
+				OnNodeAbandoned(f, i);
+				continue;
+			}
+
+			//Log the dispatch if we're recording a schedule for later replay
+			if(mode == SCHEDULE_RECORD)
+			{
+				lock_guard<mutex> lock(m_replayMutex);
+				m_recordedSchedule.push_back(ScheduleEvent{GetNodeSchedulingName(f), i});
+			}
+
+			return f;
+		}
+
+		//Still nothing to run? Block until a completion pushes new work
+		unique_lock<mutex> lock(m_workerCvarMutex);
+		m_workerCvar.wait_for(lock, chrono::milliseconds(1));
+	}
+}
+
+/**
+	@brief Serialized-mode counterpart of GetNextRunnableNode(): dispatches one node at a time in replay or
+	stress order
+
+	Only one node is ever in flight across the whole pool, so the dispatch order fully determines the execution
+	order. Workers that aren't allowed to take the next node (thread affinity in replay mode, or another node
+	still in flight) sleep on the worker cvar and re-check when something completes.
+ */
+FlowGraphNode* FilterGraphExecutor::GetNextSerializedNode(size_t i, bool stress)
+{
+	while(true)
+	{
+		//Pass is over? Stop
+		if(m_remainingNodes == 0)
+			return nullptr;
+
+		FlowGraphNode* f = nullptr;
+		{
+			lock_guard<mutex> lock(m_replayMutex);
+			if(!m_serialNodeInFlight)
+			{
+				f = stress ? PickStressNode(i) : PickReplayNode(i);
+				if(f)
+					m_serialNodeInFlight = true;
+			}
+		}
+
+		if(f)
+		{
+			//If the pass has been cancelled, retire the node without running it so the pass drains quickly
+			if(s_cancelRequested)
+			{
+				OnNodeAbandoned(f, i);
+				continue;
+			}
+
+			return f;
+		}
+
+		//Not our turn yet (or nothing ready): wait for the in-flight node to complete
+		unique_lock<mutex> lock(m_workerCvarMutex);
+		m_workerCvar.wait_for(lock, chrono::milliseconds(1));
+	}
+}
+
+/**
+	@brief Picks the next node per the replay schedule, removing it from whichever deque it's queued on
+
+	Caller must hold m_replayMutex. Returns null if the next scheduled entry belongs to another worker.
+	Serialized replay only ever enlarges the ready set relative to the recording (everything dispatched earlier
+	has fully completed), so with an unchanged graph the next scheduled node is always ready; not finding it
+	means the graph no longer matches the recording, in which case we warn once and finish in default order.
+ */
+FlowGraphNode* FilterGraphExecutor::PickReplayNode(size_t i)
+{
+	//Lock every deque, in index order so this can't deadlock against the single-deque locks elsewhere
+	vector<unique_lock<mutex>> locks;
+	locks.reserve(m_queues.size());
+	for(auto& q : m_queues)
+		locks.emplace_back(q->m_lock);
+
+	size_t total = 0;
+	for(auto& q : m_queues)
+		total += q->m_deque.size();
+	if(total == 0)
+		return nullptr;
+
+	if(!m_replayDiverged && (m_replayCursor < m_replaySchedule.size()) )
+	{
+		auto& ev = m_replaySchedule[m_replayCursor];
+
+		//Honor the recorded thread assignment, unless the pool is now too small for it
+		if( (ev.m_thread < m_queues.size()) && (ev.m_thread != i) )
+			return nullptr;
+
+		for(auto& q : m_queues)
+		{
+			for(size_t j=0; j<q->m_deque.size(); j++)
+			{
+				auto f = q->m_deque[j];
+				if(GetNodeSchedulingName(f) == ev.m_name)
+				{
+					q->m_deque.erase(q->m_deque.begin() + j);
+					m_replayCursor ++;
+					return f;
+				}
+			}
+		}
+	}
+
+	//Schedule exhausted, or the next scheduled node doesn't exist in this graph: warn once, then
+	//dispatch in deque order so the pass still completes
+	if(!m_replayDiverged)
+	{
+		m_replayDiverged = true;
+		LogWarning("FilterGraphExecutor: replay schedule does not match the current graph, finishing pass in default order\n");
+	}
+	for(auto& q : m_queues)
+	{
+		if(!q->m_deque.empty())
+		{
+			auto f = q->m_deque.front();
+			q->m_deque.pop_front();
+			return f;
+		}
+	}
+	return nullptr;
+}
+
+/**
+	@brief Picks a uniformly random ready node, recording the dispatch so a failing stress run can be replayed
+
+	Caller must hold m_replayMutex.
+ */
+FlowGraphNode* FilterGraphExecutor::PickStressNode(size_t i)
+{
+	//Lock every deque, in index order so this can't deadlock against the single-deque locks elsewhere
+	vector<unique_lock<mutex>> locks;
+	locks.reserve(m_queues.size());
+	for(auto& q : m_queues)
+		locks.emplace_back(q->m_lock);
+
+	size_t total = 0;
+	for(auto& q : m_queues)
+		total += q->m_deque.size();
+	if(total == 0)
+		return nullptr;
+
+	size_t r = m_stressPrng() % total;
+	for(auto& q : m_queues)
+	{
+		if(r < q->m_deque.size())
+		{
+			auto f = q->m_deque[r];
+			q->m_deque.erase(q->m_deque.begin() + r);
+			m_recordedSchedule.push_back(ScheduleEvent{GetNodeSchedulingName(f), i});
+			return f;
+		}
+		r -= q->m_deque.size();
+	}
+	return nullptr;
+}
+
+///@brief Returns the name a node is identified by in recorded schedules
+string FilterGraphExecutor::GetNodeSchedulingName(FlowGraphNode* f)
+{
+	auto chan = dynamic_cast<InstrumentChannel*>(f);
+	return chan ? chan->GetDisplayName() : "(unnamed node)";
+}
+
+/**
+	@brief Marks a node as complete and hands off any nodes it unblocked to worker i's deque
+ */
+void FilterGraphExecutor::OnNodeComplete(FlowGraphNode* f, size_t i)
+{
+	//A time-sliced filter that yielded mid-decode is not actually done: stay dirty (and skip readback,
+	//since the outputs are still growing) so the next pass reschedules it to resume where it left off.
+	auto pf = dynamic_cast<PausableFilter*>(f);
+	bool yielded = pf && pf->HasPendingWork();
+
+	//Our output is now up to date with respect to our inputs and configuration.
+	//If the pass was cancelled while we were executing, the filter may have bailed out of its Refresh()
+	//early, so stay dirty and let the next pass re-run us against the fresh data.
+	if(!s_cancelRequested && !yielded)
+	{
+		f->ClearDirty();
+
+		//If nobody downstream consumes this node's outputs, start copying them back to the CPU now,
+		//overlapping the readback DMA with execution of the rest of the graph
+		if(m_prefetchEnabled && (m_dependents.find(f) == m_dependents.end()))
+			PrefetchNodeOutputs(f);
+	}
+
+	RetireNode(f, i);
+}
+
+/**
+	@brief Starts asynchronous CPU readback of a terminal node's output waveforms
+
+	Only called for nodes with no consumers in the current pass, so nothing else touches these waveforms until
+	RunBlocking() has waited for the transfers to complete.
+ */
+void FilterGraphExecutor::PrefetchNodeOutputs(FlowGraphNode* f)
+{
+	auto chan = dynamic_cast<OscilloscopeChannel*>(f);
+	if(!chan)
+		return;
+
+	for(size_t j=0; j<chan->GetStreamCount(); j++)
+	{
+		auto data = chan->GetData(j);
+		if(!data)
+			continue;
+
+		auto fut = DispatchAsyncTransfer([data]{ data->PrepareForCpuAccess(); });
+
+		lock_guard<mutex> lock(m_prefetchMutex);
+		m_prefetchFutures.push_back(std::move(fut));
+	}
+}
+
+/**
+	@brief Retires a node from a cancelled pass without executing it.
+
+	The node keeps its dirty flag so the next pass re-runs it; downstream bookkeeping proceeds as if it had
+	completed, so the pass winds down through the normal completion path.
+ */
+void FilterGraphExecutor::OnNodeAbandoned(FlowGraphNode* f, size_t i)
+{
+	RetireNode(f, i);
+}
+
+/**
+	@brief Removes a node from the current pass, handing off any nodes it unblocked to worker i's deque
+ */
+void FilterGraphExecutor::RetireNode(FlowGraphNode* f, size_t i)
+{
+	//Decrement the dependency counters of everything downstream of us.
+	//Whoever decrements a counter to zero owns the node and pushes it; no lock is needed for the handoff itself.
+	auto it = m_dependents.find(f);
+	if(it != m_dependents.end())
+	{
+		//Collect everything we just unblocked, then push in ascending critical path order: the owner pops
+		//LIFO, so the node with the longest downstream chain starts first (and thieves, taking from the
+		//opposite end, pick up the short ones)
+		vector<FlowGraphNode*> unblocked;
+		for(auto d : it->second)
+		{
+			if(m_remainingDeps[d].fetch_sub(1) == 1)
+				unblocked.push_back(d);
+		}
+		if(unblocked.size() > 1)
+		{
+			//find() rather than operator[]: several workers can be retiring nodes concurrently, and the map
+			//must stay read-only here (every pass node got an entry in ComputeCriticalPaths)
+			auto rank = [this](FlowGraphNode* n)
+			{
+				auto rit = m_criticalPath.find(n);
+				return (rit != m_criticalPath.end()) ? rit->second : 0.0;
+			};
+			sort(unblocked.begin(), unblocked.end(),
+				[&rank](FlowGraphNode* a, FlowGraphNode* b)
+				{ return rank(a) < rank(b); });
+		}
+		for(auto d : unblocked)
+			PushRunnable(d, i);
 	}
 
-	//Wake up our workers
-	m_workerCvar.notify_all();
+	//In serialized scheduling modes, this node's completion is what lets the next one dispatch
+	ScheduleMode mode = m_scheduleMode;
+	if( (mode == SCHEDULE_REPLAY) || (mode == SCHEDULE_STRESS) )
+	{
+		{
+			lock_guard<mutex> lock(m_replayMutex);
+			m_serialNodeInFlight = false;
+		}
+		m_workerCvar.notify_all();
+	}
 
-	//Block until they're finished
-	while(true)
+	//If this was the last node in the pass, wake up the main thread
+	if(m_remainingNodes.fetch_sub(1) == 1)
 	{
-		unique_lock<mutex> lock(m_completionCvarMutex);
-		m_completionCvar.wait(lock, [this]{return m_allWorkersComplete;});
+		{
+			lock_guard<mutex> lock(m_completionCvarMutex);
+			m_allWorkersComplete = true;
+		}
+		m_completionCvar.notify_all();
 
-		lock_guard<mutex> lock2(m_mutex);
-		if(m_runnableNodes.empty())
-			break;
+		//Wake any workers still blocked waiting for work so they notice the pass is over
+		m_workerCvar.notify_all();
 	}
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-// Scheduling
+// 	Main parallel execution logic
+
+#ifdef __linux__
 
 /**
-	@brief Returns the next filter available to run, blocking if none are ready.
+	@brief Parses a sysfs cpulist file (a comma separated list of CPU ranges like "0-15,64-79") into a cpu_set_t
 
-	Returns null if there are no remaining filters to evaluate.
+	Returns false if the file doesn't exist or describes no CPUs.
  */
-FlowGraphNode* FilterGraphExecutor::GetNextRunnableNode()
+static bool ParseCpuListFile(const string& path, cpu_set_t& cpus)
 {
-	while(true)
+	CPU_ZERO(&cpus);
+
+	FILE* fp = fopen(path.c_str(), "r");
+	if(!fp)
+		return false;
+
+	char line[256] = {0};
+	bool gotLine = (fgets(line, sizeof(line), fp) != nullptr);
+	fclose(fp);
+	if(!gotLine)
+		return false;
+
+	char* ctx = nullptr;
+	for(char* tok = strtok_r(line, ",", &ctx); tok != nullptr; tok = strtok_r(nullptr, ",", &ctx))
 	{
-		//Check for stuff
-		{
-			lock_guard<mutex> lock(m_mutex);
+		int lo;
+		int hi;
+		if(2 == sscanf(tok, "%d-%d", &lo, &hi))
+		{}
+		else if(1 == sscanf(tok, "%d", &lo))
+			hi = lo;
+		else
+			continue;
+
+		for(int c = lo; (c <= hi) && (c < CPU_SETSIZE); c++)
+			CPU_SET(c, &cpus);
+	}
+
+	return CPU_COUNT(&cpus) > 0;
+}
+
+///@brief CPU topology relevant to worker placement, enumerated from sysfs once at startup
+struct CpuTopology
+{
+	///@brief CPUs in each NUMA node
+	vector<cpu_set_t> m_nodeCpus;
+
+	///@brief Performance ("core" as opposed to "atom") CPUs, only meaningful if m_hybrid
+	cpu_set_t m_perfCpus;
 
-			//Nothing left to run? Stop
-			if(m_incompleteNodes.empty())
-				return nullptr;
+	///@brief True if this is a hybrid P/E-core part
+	bool m_hybrid;
+};
 
-			//Nothing ready to run? Update the run queue
-			if(m_runnableNodes.empty())
-				UpdateRunnable();
+static const CpuTopology& GetCpuTopology()
+{
+	static CpuTopology topo = []()
+	{
+		CpuTopology t;
 
-			//If there is something ready to run, grab it
-			if(!m_runnableNodes.empty())
+		for(int node=0; ; node++)
+		{
+			cpu_set_t cpus;
+			if(!ParseCpuListFile(
+				string("/sys/devices/system/node/node") + to_string(node) + "/cpulist", cpus))
 			{
-				auto f = *m_runnableNodes.begin();
-				m_runnableNodes.erase(f);
-				m_runningNodes.emplace(f);
-				return f;
+				break;
 			}
+			t.m_nodeCpus.push_back(cpus);
 		}
 
-		//Still nothing to run? Block
-		unique_lock<mutex> lock(m_workerCvarMutex);
-		m_workerCvar.wait(lock);
-	}
+		//Hybrid parts expose separate "cpu_core" and "cpu_atom" pseudo-devices
+		cpu_set_t ecores;
+		t.m_hybrid =
+			ParseCpuListFile("/sys/devices/cpu_core/cpus", t.m_perfCpus) &&
+			ParseCpuListFile("/sys/devices/cpu_atom/cpus", ecores);
+
+		return t;
+	}();
+
+	return topo;
 }
 
 /**
-	@brief Searches m_incompleteNodes for any that are unblocked, and adds them to m_runnableNodes
+	@brief Applies the configured placement policy to a worker thread
+
+	Hybrid parts get all workers pinned to the performance cores: a work-stealing pass finishes when its
+	slowest worker does, so cache-heavy filters that land on an E-core make the whole pass a straggler.
+
+	Multi node machines get workers spread round robin across the NUMA nodes. Anonymous memory is physically
+	placed on the node of the thread that first touches it, so pinning workers keeps the waveform buffers a
+	filter fills local to the node its thread runs on, instead of randomly landing on the far side of a dual
+	socket machine.
 
-	Assumes m_mutex is locked
+	Single node, non-hybrid systems (the common case) are left alone so the scheduler retains full freedom.
  */
-void FilterGraphExecutor::UpdateRunnable()
+static void PlaceWorkerThread(size_t i)
 {
-	//Do nothing if we already have other filters marked runnable
-	if(!m_runnableNodes.empty())
+	auto placement = FilterGraphExecutor::GetThreadPlacement();
+	if(placement == FilterGraphExecutor::PLACEMENT_NONE)
 		return;
 
-	//Look for new filters that are eligible to run
-	for(auto f : m_incompleteNodes)
+	const auto& topo = GetCpuTopology();
+
+	if(topo.m_hybrid &&
+		( (placement == FilterGraphExecutor::PLACEMENT_AUTO) ||
+		  (placement == FilterGraphExecutor::PLACEMENT_PERFORMANCE) ) )
 	{
-		//If the filter is already running, nothing we can do
-		if(m_runningNodes.find(f) != m_runningNodes.end())
-			continue;
+		if(0 != pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &topo.m_perfCpus))
+			LogWarning("Failed to pin filter graph worker %zu to performance cores\n", i);
+		return;
+	}
 
-		//Not actively running.
-		//Is it blocked by any of our incomplete filters?
-		bool ok = true;
-		for(size_t i=0; i<f->GetInputCount(); i++)
-		{
-			auto in = f->GetInput(i).m_channel;
-			if(m_incompleteNodes.find(in) != m_incompleteNodes.end())
-			{
-				ok = false;
-				break;
-			}
-		}
+	if(placement == FilterGraphExecutor::PLACEMENT_PERFORMANCE)
+		return;
 
-		//Not blocked. It's runnable.
-		if(ok)
-			m_runnableNodes.emplace(f);
-	}
+	//Nothing to do unless we actually have more than one node
+	if(topo.m_nodeCpus.size() < 2)
+		return;
+
+	size_t node = i % topo.m_nodeCpus.size();
+	if(0 != pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &topo.m_nodeCpus[node]))
+		LogWarning("Failed to pin filter graph worker %zu to NUMA node %zu\n", i, node);
 }
+#endif
 
-////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-// 	Main parallel execution logic
+/**
+	@brief Returns the worker pool size to use when the constructor isn't given an explicit count
+
+	One worker per performance core on hybrid parts (E-core workers straggle, see PlaceWorkerThread()),
+	otherwise one per hardware thread. Falls back to 8 if the topology can't be queried.
+ */
+size_t FilterGraphExecutor::GetDefaultThreadCount()
+{
+	#ifdef __linux__
+	const auto& topo = GetCpuTopology();
+	if(topo.m_hybrid && (GetThreadPlacement() != PLACEMENT_NONE) )
+		return CPU_COUNT(&topo.m_perfCpus);
+	#endif
+
+	size_t n = thread::hardware_concurrency();
+	if(n == 0)
+		n = 8;
+	return n;
+}
 
 /**
 	@brief Thread function to handle filter graph execution
@@ -181,6 +1046,7 @@ void FilterGraphExecutor::ExecutorThread(FilterGraphExecutor* pThis, size_t i)
 {
 	#ifdef __linux__
 	pthread_setname_np(pthread_self(), "FilterGraph");
+	PlaceWorkerThread(i);
 	#endif
 
 	pThis->DoExecutorThread(i);
@@ -198,6 +1064,10 @@ void FilterGraphExecutor::DoExecutorThread(size_t i)
 	vk::CommandBufferAllocateInfo bufinfo(*pool, vk::CommandBufferLevel::ePrimary, 1);
 	vk::raii::CommandBuffer cmdbuf(std::move(vk::raii::CommandBuffers(*g_vkComputeDevice, bufinfo).front()));
 
+	//Pipeline for executing fused elementwise chains (Vulkan state is created lazily on first use,
+	//so this costs nothing unless fusion is enabled and a chain actually runs on this thread)
+	ComputePipeline fusionPipeline("shaders/ElementwiseChain.spv", 2, sizeof(ElementwiseChainShaderArgs));
+
 	if(g_hasDebugUtils)
 	{
 		string prefix = string("FilterGraphExecutor[") + to_string(i) + "]";
@@ -238,54 +1108,529 @@ void FilterGraphExecutor::DoExecutorThread(size_t i)
 
 		//Evaluate nodes as they become available, then stop when there's nothing left to do
 		FlowGraphNode* f;
-		while( (f = GetNextRunnableNode()) != nullptr)
+		VulkanTransferBatch batch;
+		vector<vk::raii::CommandBuffer> parkedBufs;
+		while( (f = GetNextRunnableNode(i)) != nullptr)
 		{
-			//Make sure the filter's inputs are where we need them
-			auto loc = f->GetInputLocation();
-			if(loc != Filter::LOC_DONTCARE)
+			//Sample the profiling flag once so a mid-node toggle can't give us a start without an end.
+			//The timestamps themselves are taken unconditionally (steady_clock reads are cheap) since they
+			//also feed the runtime history behind critical-path-first scheduling.
+			bool profiling = m_profilingEnabled;
+			int64_t tstart = GetProfileTimestamp();
+
+			//Fused elementwise chains: the head executes the entire chain in a single dispatch,
+			//so member nodes have nothing left to do by the time the scheduler reaches them
+			if(m_fusedMembers.find(f) != m_fusedMembers.end())
+			{}
+			else if(m_fusionChains.find(f) != m_fusionChains.end())
+				ExecuteFusedChain(m_fusionChains[f], cmdbuf, queue, fusionPipeline, batch);
+
+			//Batch groups work the same way: the group head produces every member's output, and members
+			//(made artificially dependent on the head during pass setup) are no-ops when their turn comes
+			else if(m_batchMembers.find(f) != m_batchMembers.end())
+			{}
+			else if(m_batchGroups.find(f) != m_batchGroups.end())
+				ExecuteBatchGroup(m_batchGroups[f], cmdbuf, queue, batch);
+
+			else
 			{
-				bool expectGpuInput = (loc == Filter::LOC_GPU);
-				bool expectCpuInput = (loc == Filter::LOC_CPU);
-				for(size_t j=0; j<f->GetInputCount(); j++)
+				//Make sure the filter's inputs are where we need them,
+				//and snapshot them so Refresh() doesn't chase descriptors per access
+				PrepareNodeInputs(f, batch);
+				f->ResolveInputWaveforms();
+
+				//If an input's producing submission is still in flight, chain to it device side
+				//(or block on it if we have to), and decide whether this node may defer its own
+				auto filt = dynamic_cast<Filter*>(f);
+				if(filt)
 				{
-					auto data = f->GetInput(j).GetData();
-					if(data)
+					ResolveUpstreamSyncPoints(f, queue);
+					filt->SetDeferredCompletionAllowed(m_deferralAllowed.find(f) != m_deferralAllowed.end());
+				}
+
+				//Actually execute the filter
+				f->Refresh(cmdbuf, queue);
+
+				if(filt)
+				{
+					//Clear the grant so a Refresh() outside the scheduler can't pick it up later
+					filt->SetDeferredCompletionAllowed(false);
+
+					//If the filter deferred its completion, the command buffer is still in flight:
+					//park it (so the next node gets a fresh one) and record the node for the
+					//end-of-pass drain
+					if(filt->IsDeferredCompletionPending())
 					{
-						if(expectGpuInput)
-							data->PrepareForGpuAccess();
-						else if(expectCpuInput)
-							data->PrepareForCpuAccess();
+						parkedBufs.push_back(std::move(cmdbuf));
+						vk::CommandBufferAllocateInfo rbinfo(*pool, vk::CommandBufferLevel::ePrimary, 1);
+						cmdbuf = std::move(vk::raii::CommandBuffers(*g_vkComputeDevice, rbinfo).front());
+
+						lock_guard<mutex> dlock(m_deferredMutex);
+						m_deferredNodes.push_back(filt);
 					}
 				}
 			}
 
-			//Actually execute the filter
-			f->Refresh(cmdbuf, queue);
+			//Always-on telemetry: count output samples against this filter class
+			//(a relaxed atomic add, so cheap enough to leave enabled in production)
+			auto fil = dynamic_cast<Filter*>(f);
+			if(fil)
+			{
+				uint64_t samples = 0;
+				for(size_t s=0; s<fil->GetStreamCount(); s++)
+				{
+					auto data = fil->GetData(s);
+					if(data)
+						samples += data->size();
+				}
+				if(samples)
+					fil->GetSamplesProcessedCounter().Add(samples);
+			}
+
+			//Fold this execution into the node's runtime estimate for future pass scheduling
+			//(execution time includes the input transfers above, since those are attributable to this
+			//node's placement)
+			auto tend = GetProfileTimestamp();
+			RecordNodeRuntime(f, double(tend - tstart));
+
+			//Record timing for this node
+			if(profiling)
+			{
+				auto chan = dynamic_cast<InstrumentChannel*>(f);
+
+				ProfileEvent ev;
+				ev.m_name = chan ? chan->GetDisplayName() : "(unnamed node)";
+				ev.m_thread = i;
+				ev.m_startTime = tstart;
+				ev.m_endTime = tend;
+
+				lock_guard<mutex> plock(m_profileMutex);
+				auto rit = m_readyTimes.find(f);
+				ev.m_readyTime = (rit != m_readyTimes.end()) ? rit->second : tstart;
+				m_currentPassEvents.push_back(ev);
+
+				//Update the rolling averages (exponential moving average, so recent passes dominate)
+				const double alpha = 0.1;
+				double texec = tend - tstart;
+				double twait = tstart - ev.m_readyTime;
+				auto& stats = m_profileStats[ev.m_name];
+				if(stats.m_numExecutions == 0)
+				{
+					stats.m_avgExecutionNs = texec;
+					stats.m_avgQueueWaitNs = twait;
+				}
+				else
+				{
+					stats.m_avgExecutionNs += alpha * (texec - stats.m_avgExecutionNs);
+					stats.m_avgQueueWaitNs += alpha * (twait - stats.m_avgQueueWaitNs);
+				}
+				stats.m_numExecutions ++;
+			}
+
+			//Filter execution has completed, hand off anything we just unblocked
+			OnNodeComplete(f, i);
+		}
+
+		//Pass is over for us: flush and wait out anything we deferred, so the parked command
+		//buffers are safe to free. This is the single host sync for a whole device-side chain.
+		if(!parkedBufs.empty())
+		{
+			queue->FlushBatchAndBlock();
+			parkedBufs.clear();
+		}
+	}
+}
+
+/**
+	@brief Moves a node's inputs to wherever it wants them (CPU or GPU) before Refresh() is called
+
+	Batches the copies for all of the inputs into a single submit with one fence wait,
+	rather than a serialized submit/wait round trip per input buffer.
+ */
+void FilterGraphExecutor::PrepareNodeInputs(FlowGraphNode* f, VulkanTransferBatch& batch)
+{
+	auto loc = f->GetInputLocation();
+	if(loc == Filter::LOC_DONTCARE)
+		return;
+
+	bool expectGpuInput = (loc == Filter::LOC_GPU);
+	bool expectCpuInput = (loc == Filter::LOC_CPU);
+	for(size_t j=0; j<f->GetInputCount(); j++)
+	{
+		auto data = f->GetInput(j).GetData();
+		if(data)
+		{
+			if(expectGpuInput)
+				data->PrepareForGpuAccessBatched(batch);
+			else if(expectCpuInput)
+				data->PrepareForCpuAccessBatched(batch);
+		}
+	}
+	batch.Flush();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Elementwise filter fusion
+
+/**
+	@brief Checks if node f's output feeds a single elementwise filter that can be appended to a fused chain
+
+	Returns the downstream filter if so, or null if the chain can't be extended past f.
+ */
+Filter* FilterGraphExecutor::GetFusableSuccessor(FlowGraphNode* f)
+{
+	//Must have exactly one in-pass consumer (duplicate entries appear if one node uses us for several inputs)
+	auto it = m_dependents.find(f);
+	if( (it == m_dependents.end()) || (it->second.size() != 1) )
+		return nullptr;
+
+	//The consumer must itself be an elementwise filter...
+	auto next = dynamic_cast<Filter*>(it->second[0]);
+	Filter::ElementwiseOperation op;
+	if(!next || !next->GetElementwiseOperation(op))
+		return nullptr;
+
+	//...must depend on nothing else being computed this pass
+	//(so completing the whole chain when the head runs can't run ahead of another input)
+	if(m_remainingDeps[next] != 1)
+		return nullptr;
+
+	//...and must consume us through its analog vector input, not e.g. a scalar operand
+	size_t nrefs = 0;
+	bool analog = false;
+	for(size_t j=0; j<next->GetInputCount(); j++)
+	{
+		auto& in = next->GetInput(j);
+		if(in.m_channel == f)
+		{
+			nrefs ++;
+			analog = (in.GetType() == Stream::STREAM_TYPE_ANALOG);
+		}
+	}
+	if( (nrefs != 1) || !analog)
+		return nullptr;
+
+	return next;
+}
+
+/**
+	@brief Finds linear chains of elementwise filters in the pass that can be fused into single dispatches
+ */
+void FilterGraphExecutor::FindElementwiseChains(const set<FlowGraphNode*>& passNodes)
+{
+	//First figure out which elementwise nodes are extensions of an upstream elementwise node,
+	//so we don't start a second chain in the middle of a longer one
+	set<FlowGraphNode*> extended;
+	Filter::ElementwiseOperation op;
+	for(auto f : passNodes)
+	{
+		auto fil = dynamic_cast<Filter*>(f);
+		if(!fil || !fil->GetElementwiseOperation(op))
+			continue;
+		auto next = GetFusableSuccessor(f);
+		if(next)
+			extended.emplace(next);
+	}
 
-			//Filter execution has completed, remove it from the running list and mark as completed
-			lock_guard<mutex> lock2(m_mutex);
-			m_runningNodes.erase(f);
-			m_incompleteNodes.erase(f);
+	//Every elementwise node that isn't itself an extension starts a chain; walk each one downstream
+	for(auto f : passNodes)
+	{
+		auto fil = dynamic_cast<Filter*>(f);
+		if(!fil || extended.count(f) || !fil->GetElementwiseOperation(op))
+			continue;
 
-			//Wake up all threads that might have been waiting on this filter to complete
-			m_workerCvar.notify_all();
+		vector<Filter*> chain;
+		chain.push_back(fil);
+		auto cur = fil;
+		while(chain.size() < ELEMENTWISE_CHAIN_MAX_OPS)
+		{
+			auto next = GetFusableSuccessor(cur);
+			if(!next)
+				break;
+			chain.push_back(next);
+			cur = next;
 		}
 
-		//We have no more filters to run.
-		//If this was the last filter (nothing left incomplete), we're done - wake up the main thread
-		bool empty = false;
+		//A chain of one is just a normal filter execution
+		if(chain.size() < 2)
+			continue;
+
+		m_fusionChains[f] = chain;
+		for(size_t j=1; j<chain.size(); j++)
+			m_fusedMembers.emplace(chain[j]);
+	}
+}
+
+/**
+	@brief Executes a fused chain of elementwise filters, falling back to stage-by-stage execution if
+	the fused version can't handle it (no analog input, somebody reconfigured a filter mid-pass, etc)
+ */
+void FilterGraphExecutor::ExecuteFusedChain(
+	const vector<Filter*>& chain,
+	vk::raii::CommandBuffer& cmdBuf,
+	shared_ptr<QueueHandle> queue,
+	ComputePipeline& pipeline,
+	VulkanTransferBatch& batch)
+{
+	if(Filter::RefreshFusedElementwiseChain(chain, cmdBuf, queue, pipeline))
+		return;
+
+	//Fallback: the chain is linear, so refreshing each stage in order satisfies all dependencies
+	for(auto f : chain)
+	{
+		PrepareNodeInputs(f, batch);
+		f->ResolveInputWaveforms();
+		f->Refresh(cmdBuf, queue);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Batched filter execution
+
+/**
+	@brief Finds groups of identically-configured filters in the pass that can be executed as one batched dispatch
+
+	Only filters with no in-pass dependencies are considered (all of their inputs exist before the pass starts,
+	so the whole group is guaranteed to be co-runnable). Each member of a group is given an artificial dependency
+	on the group head, so the scheduler cannot reach a member before the head has produced its output.
+ */
+void FilterGraphExecutor::FindBatchGroups(const set<FlowGraphNode*>& passNodes)
+{
+	//Bucket candidate filters by batch key
+	map<string, vector<Filter*>> candidates;
+	for(auto f : passNodes)
+	{
+		auto fil = dynamic_cast<Filter*>(f);
+		if(!fil || (m_remainingDeps[f] != 0) )
+			continue;
+
+		//A node can't be in a fused elementwise chain and a batch group at the same time
+		if( (m_fusedMembers.find(f) != m_fusedMembers.end()) || (m_fusionChains.find(f) != m_fusionChains.end()) )
+			continue;
+
+		auto key = fil->GetBatchKey();
+		if(key.empty())
+			continue;
+		candidates[key].push_back(fil);
+	}
+
+	//A group of one is just a normal filter execution
+	for(auto& it : candidates)
+	{
+		auto& group = it.second;
+		if(group.size() < 2)
+			continue;
+
+		auto head = group[0];
+		m_batchGroups[head] = group;
+		for(size_t j=1; j<group.size(); j++)
 		{
-			lock_guard<mutex> lock2(m_mutex);
-			empty = m_incompleteNodes.empty();
+			m_batchMembers.emplace(group[j]);
+			m_dependents[head].push_back(group[j]);
+			m_remainingDeps[group[j]] ++;
 		}
-		if(empty)
+	}
+}
+
+/**
+	@brief Executes a group of identically-configured filters as one batched set of dispatches, falling back to
+	filter-by-filter execution if the batched version can't handle it (somebody reconfigured a filter mid-pass, etc)
+ */
+void FilterGraphExecutor::ExecuteBatchGroup(
+	const vector<Filter*>& group,
+	vk::raii::CommandBuffer& cmdBuf,
+	shared_ptr<QueueHandle> queue,
+	VulkanTransferBatch& batch)
+{
+	for(auto f : group)
+	{
+		PrepareNodeInputs(f, batch);
+		f->ResolveInputWaveforms();
+	}
+
+	if(group[0]->RefreshBatch(group, cmdBuf, queue))
+		return;
+
+	//Fallback: every member's inputs come from outside the pass, so any execution order works
+	for(auto f : group)
+		f->Refresh(cmdBuf, queue);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Device-side chaining of GPU filter dependencies
+
+/**
+	@brief Finds nodes in the pass whose GPU submissions may complete asynchronously
+
+	A node may defer its completion when every in-pass consumer of its output promises to touch the data only
+	from GPU dispatches (CanConsumeDeferredInputs), so ordering can be guaranteed device side: consumers on the
+	same queue are covered by submission order, consumers on other queues get a timeline semaphore wait attached
+	to their own submission. Terminal nodes never defer, since their outputs go straight to readback and the UI.
+
+	Whether a granted node actually defers is up to its Refresh(): only filters ending in SubmitOrDefer() do.
+ */
+void FilterGraphExecutor::FindDeferrableNodes(const set<FlowGraphNode*>& passNodes)
+{
+	for(auto f : passNodes)
+	{
+		if(!dynamic_cast<Filter*>(f))
+			continue;
+
+		//Fused chains and batch groups submit on behalf of several nodes at once; keep them fully synchronous
+		if( (m_fusedMembers.find(f) != m_fusedMembers.end()) || (m_fusionChains.find(f) != m_fusionChains.end()) )
+			continue;
+		if( (m_batchMembers.find(f) != m_batchMembers.end()) || (m_batchGroups.find(f) != m_batchGroups.end()) )
+			continue;
+
+		//Must have in-pass consumers, all of which can chain to an in-flight producer
+		auto it = m_dependents.find(f);
+		if( (it == m_dependents.end()) || it->second.empty() )
+			continue;
+		bool ok = true;
+		for(auto d : it->second)
 		{
+			auto dfil = dynamic_cast<Filter*>(d);
+			if(!dfil || !dfil->CanConsumeDeferredInputs())
+			{
+				ok = false;
+				break;
+			}
+			if( (m_fusedMembers.find(d) != m_fusedMembers.end()) || (m_fusionChains.find(d) != m_fusionChains.end()) ||
+				(m_batchMembers.find(d) != m_batchMembers.end()) || (m_batchGroups.find(d) != m_batchGroups.end()) )
 			{
-				lock_guard<mutex> lock3(m_completionCvarMutex);
-				m_allWorkersComplete = true;
+				ok = false;
+				break;
 			}
+		}
+		if(ok)
+			m_deferralAllowed.emplace(f);
+	}
+}
+
+/**
+	@brief Orders node f's execution after any of its producers whose submissions are still in flight
+
+	Same-queue producers need nothing (queue submission order covers them); cross-queue producers get a
+	device-side timeline semaphore wait attached to this worker's next submission.
+ */
+void FilterGraphExecutor::ResolveUpstreamSyncPoints(FlowGraphNode* f, shared_ptr<QueueHandle> queue)
+{
+	for(size_t j=0; j<f->GetInputCount(); j++)
+	{
+		auto in = dynamic_cast<Filter*>(f->GetInput(j).m_channel);
+		if(in && in->IsDeferredCompletionPending())
+			queue->AddPendingWait(in->GetPendingSubmitQueue(), in->GetPendingSubmitValue());
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Profiling
+
+/**
+	@brief Records the time at which a node became runnable
+ */
+void FilterGraphExecutor::RecordNodeReady(FlowGraphNode* f)
+{
+	auto t = GetProfileTimestamp();
+
+	lock_guard<mutex> lock(m_profileMutex);
+	m_readyTimes[f] = t;
+}
+
+/**
+	@brief Renders the most recently profiled pass as chrome://tracing JSON.
+
+	Load the result in chrome://tracing or ui.perfetto.dev to see the per-thread execution timeline. Each node
+	produces an optional "wait" slice covering the time from when it became runnable to when a worker picked it
+	up, followed by an execution slice covering input transfers and Refresh().
+ */
+string FilterGraphExecutor::GetLastPassTraceJSON()
+{
+	lock_guard<mutex> lock(m_profileMutex);
+
+	string json = "{\"traceEvents\":[\n";
+	char tmp[512];
+	bool first = true;
+	for(auto& ev : m_lastPassEvents)
+	{
+		//Escape anything in the display name that would break the JSON string
+		string name;
+		for(auto c : ev.m_name)
+		{
+			if( (c == '"') || (c == '\\') )
+				name += '\\';
+			if( (unsigned char)c >= 0x20 )
+				name += c;
+		}
 
-			m_completionCvar.notify_all();
+		if(!first)
+			json += ",\n";
+		first = false;
+
+		//Queue wait slice (zero length waits omitted to reduce clutter)
+		if(ev.m_startTime > ev.m_readyTime)
+		{
+			snprintf(tmp, sizeof(tmp),
+				"{\"name\": \"%s (wait)\", \"cat\": \"wait\", \"ph\": \"X\", \"pid\": 0, \"tid\": %zu, "
+				"\"ts\": %.3f, \"dur\": %.3f},\n",
+				name.c_str(),
+				ev.m_thread,
+				ev.m_readyTime * 1e-3,
+				(ev.m_startTime - ev.m_readyTime) * 1e-3);
+			json += tmp;
 		}
+
+		//Execution slice (timestamps are ns, chrome://tracing wants us)
+		snprintf(tmp, sizeof(tmp),
+			"{\"name\": \"%s\", \"cat\": \"filter\", \"ph\": \"X\", \"pid\": 0, \"tid\": %zu, "
+			"\"ts\": %.3f, \"dur\": %.3f}",
+			name.c_str(),
+			ev.m_thread,
+			ev.m_startTime * 1e-3,
+			(ev.m_endTime - ev.m_startTime) * 1e-3);
+		json += tmp;
+	}
+	json += "\n]}\n";
+	return json;
+}
+
+/**
+	@brief Returns a copy of the rolling per-node statistics
+ */
+map<string, FilterGraphExecutor::ProfileStats> FilterGraphExecutor::GetProfilingStats()
+{
+	lock_guard<mutex> lock(m_profileMutex);
+	return m_profileStats;
+}
+
+/**
+	@brief Returns the wall clock completion time of each node in the most recently profiled pass.
+
+	Times are from GetTime(), on the same timebase as Oscilloscope::TriggerLatencyRecord, so a per-trigger
+	latency budget can be walked from trigger arrival through download, conversion, and each filter node to
+	find which stage blew it. If the same display name executed more than once in the pass, the last
+	completion wins.
+ */
+map<string, double> FilterGraphExecutor::GetLastPassCompletionTimes()
+{
+	lock_guard<mutex> lock(m_profileMutex);
+
+	map<string, double> ret;
+	for(auto& ev : m_lastPassEvents)
+	{
+		double t = m_lastPassStartWallclock + ev.m_endTime * 1e-9;
+		auto it = ret.find(ev.m_name);
+		if( (it == ret.end()) || (it->second < t) )
+			ret[ev.m_name] = t;
 	}
+	return ret;
+}
+
+/**
+	@brief Discards all accumulated rolling statistics
+ */
+void FilterGraphExecutor::ResetProfilingStats()
+{
+	lock_guard<mutex> lock(m_profileMutex);
+	m_profileStats.clear();
 }
@@ -32,37 +32,382 @@
 
 #include <condition_variable>
 #include <atomic>
+#include <chrono>
+#include <deque>
+#include <future>
+#include <random>
+#include <unordered_map>
 
 /**
 	@brief Execution manager / scheduler for the filter graph
+
+	Scheduling uses a work-stealing deque per worker thread. When a node completes, any downstream nodes it unblocks
+	are pushed to the completing worker's own deque (LIFO, for cache locality); idle workers steal from the opposite
+	end of a victim's deque. Readiness is tracked with per-node atomic dependency counters, so the hot path only ever
+	takes the short per-deque locks rather than a single global mutex that all workers contend on.
+
+	Runnable nodes are ordered by estimated critical path, computed per pass from an always-on rolling history of
+	node runtimes, so the long poles of the graph start as early as their dependencies allow rather than idling at
+	the tail of the pass.
  */
 class FilterGraphExecutor
 {
 public:
-	FilterGraphExecutor(size_t numThreads = 8);
+	///@brief Creates the thread pool; numThreads = 0 sizes it from the CPU topology (see GetDefaultThreadCount())
+	FilterGraphExecutor(size_t numThreads = 0);
 	~FilterGraphExecutor();
 
 	void RunBlocking(const std::set<FlowGraphNode*>& nodes);
+	bool StartSpeculativePass(const std::set<FlowGraphNode*>& nodes);
+	void WaitForPass();
+	void Cancel();
+
+	/**
+		@brief Checks if cancellation of the in-progress pass has been requested.
+
+		Long-running filters may poll this between iterations of their outer processing loop and return early;
+		any node executed (fully or partially) while cancellation is pending keeps its dirty flag, so the next
+		pass re-runs it from scratch.
+	 */
+	static bool IsCancelPending()
+	{ return s_cancelRequested; }
+
+	FlowGraphNode* GetNextRunnableNode(size_t i);
+
+	////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	// Profiling
+
+	///@brief A single node execution from the most recent profiled pass
+	struct ProfileEvent
+	{
+		///@brief Display name of the node
+		std::string m_name;
+
+		///@brief Index of the worker thread that executed the node
+		size_t m_thread;
+
+		///@brief Time the node became runnable, in ns relative to the start of the pass
+		int64_t m_readyTime;
+
+		///@brief Time execution (including input transfers) began, in ns relative to the start of the pass
+		int64_t m_startTime;
+
+		///@brief Time execution completed, in ns relative to the start of the pass
+		int64_t m_endTime;
+	};
+
+	///@brief Rolling performance statistics for a single node, aggregated across profiled passes
+	struct ProfileStats
+	{
+		ProfileStats()
+			: m_avgExecutionNs(0)
+			, m_avgQueueWaitNs(0)
+			, m_numExecutions(0)
+		{}
+
+		///@brief Exponential moving average of execution time, in ns
+		double m_avgExecutionNs;
+
+		///@brief Exponential moving average of time spent runnable-but-queued, in ns
+		double m_avgQueueWaitNs;
+
+		///@brief Total number of executions recorded
+		uint64_t m_numExecutions;
+	};
+
+	/**
+		@brief Enables or disables per-node profiling.
+
+		Profiling adds a timestamp and a short lock acquisition around each node execution, so it is off by default.
+	 */
+	void EnableProfiling(bool enable)
+	{ m_profilingEnabled = enable; }
+
+	bool IsProfilingEnabled()
+	{ return m_profilingEnabled; }
+
+	std::string GetLastPassTraceJSON();
+	std::map<std::string, ProfileStats> GetProfilingStats();
+	void ResetProfilingStats();
+	std::map<std::string, double> GetLastPassCompletionTimes();
+
+	////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	// Deterministic scheduling replay
+
+	///@brief One node dispatch in a recorded schedule
+	struct ScheduleEvent
+	{
+		///@brief Display name of the node
+		std::string m_name;
+
+		///@brief Index of the worker thread that dispatched it
+		size_t m_thread;
+	};
+
+	/**
+		@brief Scheduling modes (see SetScheduleMode())
+
+		Ordering-dependent output diffs from the parallel scheduler are unreproducible by nature: the interleaving
+		that triggered them is gone by the time anyone notices. These modes make a schedule a first-class artifact.
+		Record a pass's dispatch order, replay it exactly to reproduce a failure, or stress with seeded-random legal
+		orders to flush out ordering dependencies before they ship (a failing seed is itself a reproducer, since
+		stress passes record their schedule too).
+
+		Replay and stress dispatch one node at a time, so they are debugging tools, not production configurations.
+		Replay matches nodes by display name and honors the recorded thread assignment where the pool is large
+		enough; if the graph no longer matches the recording, it warns once and finishes the pass in default order.
+
+		Mode changes apply cleanly at pass boundaries; don't change modes while a pass is in flight.
+	 */
+	enum ScheduleMode
+	{
+		///@brief Normal work-stealing execution (the default)
+		SCHEDULE_NORMAL,
+
+		///@brief Normal execution, recording dispatch order and thread assignment for later replay
+		SCHEDULE_RECORD,
+
+		///@brief Serialized execution following the schedule set by SetReplaySchedule() exactly
+		SCHEDULE_REPLAY,
+
+		///@brief Serialized execution dispatching a seeded-random legal order (see SetStressSeed())
+		SCHEDULE_STRESS
+	};
+
+	void SetScheduleMode(ScheduleMode mode)
+	{ m_scheduleMode = mode; }
+
+	ScheduleMode GetScheduleMode()
+	{ return m_scheduleMode; }
+
+	///@brief Returns the schedule recorded by the most recent SCHEDULE_RECORD or SCHEDULE_STRESS pass
+	std::vector<ScheduleEvent> GetRecordedSchedule()
+	{
+		std::lock_guard<std::mutex> lock(m_replayMutex);
+		return m_recordedSchedule;
+	}
+
+	///@brief Sets the schedule to follow, and switches to SCHEDULE_REPLAY mode
+	void SetReplaySchedule(const std::vector<ScheduleEvent>& schedule)
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_replayMutex);
+			m_replaySchedule = schedule;
+		}
+		m_scheduleMode = SCHEDULE_REPLAY;
+	}
+
+	///@brief Seeds the PRNG driving SCHEDULE_STRESS dispatch order (same seed = same sequence of schedules)
+	void SetStressSeed(uint32_t seed)
+	{
+		std::lock_guard<std::mutex> lock(m_replayMutex);
+		m_stressPrng.seed(seed);
+	}
+
+	////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	// Elementwise filter fusion
+
+	/**
+		@brief Enables or disables fusion of elementwise filter chains.
+
+		When enabled, linear chains of filters which all report an ElementwiseOperation (add / multiply / min / max
+		by a constant) are executed as a single compute dispatch rather than one full pass over the waveform per
+		filter, eliminating the intermediate buffer traffic. The intermediate filters in a fused chain do not get
+		their own output waveforms, so only enable this if those streams aren't being displayed or otherwise
+		consumed outside the graph.
+	 */
+	void EnableElementwiseFusion(bool enable)
+	{ m_fusionEnabled = enable; }
+
+	bool IsElementwiseFusionEnabled()
+	{ return m_fusionEnabled; }
+
+	////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	// Batched filter execution
+
+	/**
+		@brief Enables or disables batched execution of identically-configured filters.
+
+		When enabled, filters that are ready at the start of a pass and report the same batch key (e.g. several
+		FFTs of the same length hanging off different scope channels) are executed as one batched set of GPU
+		dispatches with a single queue submit, rather than one serialized submit-and-wait round trip per filter.
+	 */
+	void EnableFilterBatching(bool enable)
+	{ m_batchingEnabled = enable; }
+
+	bool IsFilterBatchingEnabled()
+	{ return m_batchingEnabled; }
+
+	////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	// Terminal output prefetch
+
+	/**
+		@brief Enables or disables asynchronous CPU readback of terminal node outputs.
+
+		When enabled, as soon as a node with no in-pass consumers finishes executing, its output waveforms are
+		copied back to the CPU on a background transfer thread while the rest of the graph is still running.
+		Consumers that touch the results on the CPU afterwards (export filters, measurement displays) then find
+		the mirrors already up to date instead of stalling on a synchronous DMA. RunBlocking() waits for all
+		in-flight readbacks before returning, so results are never handed back mid-transfer.
+
+		This forces a CPU mirror to be allocated for every terminal output, so only enable it if those outputs
+		are actually consumed on the CPU (rather than, say, rendered straight from the GPU).
+	 */
+	void EnableOutputPrefetch(bool enable)
+	{ m_prefetchEnabled = enable; }
+
+	bool IsOutputPrefetchEnabled()
+	{ return m_prefetchEnabled; }
+
+	////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	// Trigger-rate adaptive decimation
+
+	/**
+		@brief Enables or disables trigger-rate adaptive decimation of cosmetic nodes.
+
+		When the trigger rate exceeds the processing rate, rather than everything degrading equally, nodes tagged
+		FlowGraphNode::PRIORITY_COSMETIC (deep decodes, full eye re-renders, etc) are only evaluated every Nth
+		pass, with N steered by the measured pass latency relative to the budget set by SetTargetPassLatency().
+		PRIORITY_CRITICAL and PRIORITY_NORMAL nodes run on every pass regardless, as does any cosmetic node whose
+		output a non-cosmetic node consumes.
+
+		Deferred nodes keep their dirty flag, so they catch up (against the then-current data) on the next pass
+		that includes them; their outputs are simply stale in between.
+	 */
+	void EnableAdaptiveDecimation(bool enable)
+	{ m_decimationEnabled = enable; }
+
+	bool IsAdaptiveDecimationEnabled()
+	{ return m_decimationEnabled; }
+
+	/**
+		@brief Sets the pass latency budget, in seconds, that the decimation controller steers toward.
+
+		Typically the expected trigger interval. Zero (the default) disables adaptation, freezing the
+		decimation factor at its current value.
+	 */
+	void SetTargetPassLatency(double seconds)
+	{ m_targetPassLatency = seconds; }
+
+	///@brief Returns the current decimation factor (cosmetic nodes run every Nth pass)
+	size_t GetDecimationFactor()
+	{ return m_decimationFactor; }
+
+	///@brief Upper bound on the adaptive decimation factor
+	static const size_t MAX_DECIMATION = 64;
+
+	////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	// CPU topology awareness
+
+	///@brief Worker thread placement policies (see SetThreadPlacement())
+	enum ThreadPlacement
+	{
+		///@brief Pin to performance cores on hybrid CPUs, else spread across NUMA nodes (the default)
+		PLACEMENT_AUTO,
+
+		///@brief Leave workers wherever the OS scheduler puts them
+		PLACEMENT_NONE,
 
-	FlowGraphNode* GetNextRunnableNode();
+		///@brief Pin all workers to performance cores (no-op on non-hybrid CPUs)
+		PLACEMENT_PERFORMANCE,
+
+		///@brief Spread workers round robin across NUMA nodes (no-op on single node systems)
+		PLACEMENT_NUMA
+	};
+
+	/**
+		@brief Sets the worker thread placement policy.
+
+		Workers apply the policy as they start up, so set this before constructing the executor; changing it
+		afterward only affects executors created later.
+	 */
+	static void SetThreadPlacement(ThreadPlacement placement)
+	{ s_threadPlacement = placement; }
+
+	static ThreadPlacement GetThreadPlacement()
+	{ return s_threadPlacement; }
+
+	static size_t GetDefaultThreadCount();
 
 protected:
 	static void ExecutorThread(FilterGraphExecutor* pThis, size_t i);
 	void DoExecutorThread(size_t i);
 
-	void UpdateRunnable();
+	bool StartPass(const std::set<FlowGraphNode*>& nodes);
+
+	void OnNodeComplete(FlowGraphNode* f, size_t i);
+	void OnNodeAbandoned(FlowGraphNode* f, size_t i);
+	void RetireNode(FlowGraphNode* f, size_t i);
+	void PushRunnable(FlowGraphNode* f, size_t i);
+	FlowGraphNode* PopOrSteal(size_t i);
+
+	FlowGraphNode* GetNextSerializedNode(size_t i, bool stress);
+	FlowGraphNode* PickReplayNode(size_t i);
+	FlowGraphNode* PickStressNode(size_t i);
+	static std::string GetNodeSchedulingName(FlowGraphNode* f);
+
+	void PrepareNodeInputs(FlowGraphNode* f, VulkanTransferBatch& batch);
+	void PrefetchNodeOutputs(FlowGraphNode* f);
 
-	//Mutex for access to shared state
+	void FindElementwiseChains(const std::set<FlowGraphNode*>& passNodes);
+	Filter* GetFusableSuccessor(FlowGraphNode* f);
+	void ExecuteFusedChain(
+		const std::vector<Filter*>& chain,
+		vk::raii::CommandBuffer& cmdBuf,
+		std::shared_ptr<QueueHandle> queue,
+		ComputePipeline& pipeline,
+		VulkanTransferBatch& batch);
+
+	void FindBatchGroups(const std::set<FlowGraphNode*>& passNodes);
+
+	void FindDeferrableNodes(const std::set<FlowGraphNode*>& passNodes);
+	void ResolveUpstreamSyncPoints(FlowGraphNode* f, std::shared_ptr<QueueHandle> queue);
+
+	void DropDecimatedNodes(std::set<FlowGraphNode*>& passNodes);
+	void UpdateDecimationFactor(double latency);
+	void ExecuteBatchGroup(
+		const std::vector<Filter*>& group,
+		vk::raii::CommandBuffer& cmdBuf,
+		std::shared_ptr<QueueHandle> queue,
+		VulkanTransferBatch& batch);
+
+	///@brief One work-stealing deque, with a short-hold lock guarding only the deque itself
+	struct WorkerQueue
+	{
+		std::mutex m_lock;
+		std::deque<FlowGraphNode*> m_deque;
+	};
+
+	//Mutex for access to pass setup state (only taken between passes, never on the scheduling hot path)
 	std::mutex m_mutex;
 
-	//Nodes that have not yet been updated
-	std::set<FlowGraphNode*> m_incompleteNodes;
+	///@brief Per-worker run queues
+	std::vector<std::unique_ptr<WorkerQueue>> m_queues;
+
+	///@brief Map from each node in the current pass to the nodes consuming its outputs
+	std::unordered_map<FlowGraphNode*, std::vector<FlowGraphNode*>> m_dependents;
+
+	///@brief Number of incomplete upstream dependencies for each node in the current pass
+	std::unordered_map<FlowGraphNode*, std::atomic<size_t>> m_remainingDeps;
 
-	//Nodes that have no dependencies and are eligible to run now
-	std::set<FlowGraphNode*> m_runnableNodes;
+	///@brief Estimated critical path length (node runtime plus longest downstream chain, in ns) per pass node
+	std::unordered_map<FlowGraphNode*, double> m_criticalPath;
 
-	//Nodes that are actively being run
-	std::set<FlowGraphNode*> m_runningNodes;
+	/**
+		@brief Rolling average execution time per node, in ns, kept across passes
+
+		Entries for deleted nodes are never looked up again and simply linger; a recycled allocation may
+		inherit a stale estimate for a pass or two, which only costs a slightly suboptimal schedule.
+	 */
+	std::unordered_map<FlowGraphNode*, double> m_runtimeHistory;
+
+	std::mutex m_runtimeHistoryMutex;
+
+	void ComputeCriticalPaths(const std::set<FlowGraphNode*>& passNodes);
+	void RecordNodeRuntime(FlowGraphNode* f, double ns);
+
+	///@brief Number of nodes in the current pass that have not yet finished executing
+	std::atomic<size_t> m_remainingNodes;
 
 	//Set of thread contexts
 	std::vector<std::unique_ptr<std::thread>> m_threads;
@@ -82,8 +427,127 @@ protected:
 	///@brief Indicates that all worker threads have finished executing this pass
 	bool m_allWorkersComplete;
 
+	///@brief Set by StartPass(), cleared by the WaitForPass() that winds the pass down
+	std::atomic<bool> m_passPending;
+
+	///@brief Wall clock time the current pass started, for latency telemetry
+	double m_passStartWallclock;
+
 	//Shutdown flag
 	bool m_terminating;
+
+	///@brief Set when the in-progress pass should be abandoned (cleared at the start of each pass)
+	static std::atomic<bool> s_cancelRequested;
+
+	///@brief Worker placement policy applied by threads as they start up
+	static std::atomic<ThreadPlacement> s_threadPlacement;
+
+	///@brief True if elementwise chain fusion is active
+	std::atomic<bool> m_fusionEnabled;
+
+	///@brief Map from chain head to the full chain (head first) for the current pass
+	std::unordered_map<FlowGraphNode*, std::vector<Filter*>> m_fusionChains;
+
+	///@brief Nodes in the current pass that are executed by their chain head rather than by themselves
+	std::set<FlowGraphNode*> m_fusedMembers;
+
+	///@brief True if batched execution of identically-configured filters is active
+	std::atomic<bool> m_batchingEnabled;
+
+	///@brief Map from group head to the full batch group (head first) for the current pass
+	std::unordered_map<FlowGraphNode*, std::vector<Filter*>> m_batchGroups;
+
+	///@brief Nodes in the current pass that are executed by their group head rather than by themselves
+	std::set<FlowGraphNode*> m_batchMembers;
+
+	///@brief Nodes in the current pass allowed to complete their GPU submission asynchronously
+	std::set<FlowGraphNode*> m_deferralAllowed;
+
+	///@brief Filters that deferred a submission this pass, drained by WaitForPass()
+	std::vector<Filter*> m_deferredNodes;
+
+	///@brief Mutex for access to m_deferredNodes
+	std::mutex m_deferredMutex;
+
+	///@brief True if asynchronous readback of terminal node outputs is active
+	std::atomic<bool> m_prefetchEnabled;
+
+	///@brief True if trigger-rate adaptive decimation of cosmetic nodes is active
+	std::atomic<bool> m_decimationEnabled;
+
+	///@brief Cosmetic nodes run every this-many'th pass (1 = every pass)
+	std::atomic<size_t> m_decimationFactor;
+
+	///@brief Pass latency budget the decimation controller steers toward, in seconds (0 = don't adapt)
+	std::atomic<double> m_targetPassLatency;
+
+	///@brief Exponential moving average of pass latency, in seconds (only touched from WaitForPass)
+	double m_avgPassLatency;
+
+	///@brief Number of passes started, for phasing the decimation (only touched under m_mutex)
+	uint64_t m_passCount;
+
+	///@brief Guards m_prefetchFutures
+	std::mutex m_prefetchMutex;
+
+	///@brief Completion futures for readbacks started during the current pass
+	std::vector<std::future<void>> m_prefetchFutures;
+
+	///@brief Current scheduling mode (see ScheduleMode)
+	std::atomic<ScheduleMode> m_scheduleMode;
+
+	///@brief Guards the schedule recording / replay state below
+	std::mutex m_replayMutex;
+
+	///@brief Dispatch order recorded by the most recent SCHEDULE_RECORD or SCHEDULE_STRESS pass
+	std::vector<ScheduleEvent> m_recordedSchedule;
+
+	///@brief The schedule being followed in SCHEDULE_REPLAY mode
+	std::vector<ScheduleEvent> m_replaySchedule;
+
+	///@brief Index of the next m_replaySchedule entry to dispatch
+	size_t m_replayCursor;
+
+	///@brief True while a serialized-mode node is executing (only one runs at a time)
+	bool m_serialNodeInFlight;
+
+	///@brief True once the current pass has been reported as diverging from the replay schedule
+	bool m_replayDiverged;
+
+	///@brief PRNG driving SCHEDULE_STRESS dispatch order
+	std::minstd_rand m_stressPrng;
+
+	///@brief True if per-node profiling is active
+	std::atomic<bool> m_profilingEnabled;
+
+	///@brief Start time of the current pass (only valid while profiling)
+	std::chrono::steady_clock::time_point m_passStartTime;
+
+	///@brief Guards the profiling state below (only taken when profiling is enabled)
+	std::mutex m_profileMutex;
+
+	///@brief Time each node in the current pass became runnable, in ns relative to the start of the pass
+	std::unordered_map<FlowGraphNode*, int64_t> m_readyTimes;
+
+	///@brief Execution records from the most recently completed profiled pass
+	std::vector<ProfileEvent> m_lastPassEvents;
+
+	///@brief Wall clock start time (from GetTime()) of the pass m_lastPassEvents was captured from
+	double m_lastPassStartWallclock;
+
+	///@brief Execution records being accumulated for the in-progress pass
+	std::vector<ProfileEvent> m_currentPassEvents;
+
+	///@brief Rolling per-node statistics, keyed by display name
+	std::map<std::string, ProfileStats> m_profileStats;
+
+	int64_t GetProfileTimestamp()
+	{
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now() - m_passStartTime).count();
+	}
+
+	void RecordNodeReady(FlowGraphNode* f);
 };
 
 #endif
@@ -130,7 +130,7 @@ public:
 	/**
 		@brief Returns the value of the parameter interpreted as a file path
 	 */
-	std::string GetFileName() const
+	const std::string& GetFileName() const
 	{ return m_string; }
 
 	void SetBoolVal(bool b);
@@ -260,4 +260,56 @@ protected:
 	bool						m_readOnly;
 };
 
+/**
+	@brief A pre-resolved snapshot of a FilterParameter's numeric value, for use in Refresh() hot paths
+
+	Consulting m_parameters costs a string-keyed map search, so a filter which reads several parameters on every
+	trigger pays for string compares long after the parameter was last touched. A CachedParameter binds to the
+	underlying parameter once (map entries are never relocated) and snapshots the resolved integer and float
+	values, refreshing them only from the parameter's change notification. The hot path then reads a plain number
+	with no string handling at all.
+ */
+class CachedParameter : public sigc::trackable
+{
+public:
+	CachedParameter()
+	: m_param(nullptr)
+	, m_intval(0)
+	, m_floatval(0)
+	{}
+
+	/**
+		@brief Binds to a parameter, which must outlive us (typically both live in the same filter)
+	 */
+	void Bind(FilterParameter& param)
+	{
+		m_param = &param;
+		param.signal_changed().connect(sigc::mem_fun(*this, &CachedParameter::OnValueChanged));
+		OnValueChanged();
+	}
+
+	///@brief Returns the bound parameter's value interpreted as a boolean
+	bool GetBoolVal() const
+	{ return (m_intval != 0); }
+
+	///@brief Returns the bound parameter's value interpreted as an integer (pre-resolved for enums)
+	int64_t GetIntVal() const
+	{ return m_intval; }
+
+	///@brief Returns the bound parameter's value interpreted as a floating point number
+	float GetFloatVal() const
+	{ return m_floatval; }
+
+protected:
+	void OnValueChanged()
+	{
+		m_intval = m_param->GetIntVal();
+		m_floatval = m_param->GetFloatVal();
+	}
+
+	FilterParameter* m_param;
+	int64_t m_intval;
+	float m_floatval;
+};
+
 #endif
@@ -49,6 +49,8 @@ string StreamDescriptor::GetName() const
 // Construction / destruction
 
 FlowGraphNode::FlowGraphNode()
+	: m_dirty(true)
+	, m_priorityTier(PRIORITY_NORMAL)
 {
 }
 
@@ -166,6 +168,9 @@ void FlowGraphNode::SetInput(size_t i, StreamDescriptor stream, bool force)
 		if(stream == m_inputs[i])
 			return;
 
+		//Anything past this point changes the input, so we need to re-evaluate on the next graph pass
+		MarkDirty();
+
 		if(stream.m_channel == nullptr)	//NULL is always legal
 		{
 			m_inputs[i] = StreamDescriptor(nullptr, 0);
@@ -340,6 +345,9 @@ YAML::Node FlowGraphNode::SerializeConfiguration(IDTable& table)
 
 void FlowGraphNode::LoadParameters(const YAML::Node& node, IDTable& /*table*/)
 {
+	//Loaded configuration may differ from whatever we last ran with
+	MarkDirty();
+
 	auto parameters = node["parameters"];
 	for(auto it : parameters)
 	{
@@ -38,6 +38,8 @@
 class OscilloscopeChannel;
 class WaveformBase;
 
+#include <atomic>
+
 #include "FilterParameter.h"
 #include "Waveform.h"
 #include "Stream.h"
@@ -109,6 +111,45 @@ public:
 
 	StreamDescriptor GetInput(size_t i);
 
+	/**
+		@brief Pre-resolved snapshot of one input, built by ResolveInputWaveforms()
+
+		A flat copy of everything a filter's hot path needs to know about an input, so per-access descriptor
+		chasing and validity checks are paid once per Refresh() instead of once per use.
+	 */
+	struct ResolvedInput
+	{
+		///@brief Waveform attached to the input, or nullptr if unconnected or no data
+		WaveformBase* m_waveform;
+
+		///@brief Channel driving the input, or nullptr if unconnected
+		InstrumentChannel* m_channel;
+
+		///@brief Stream index within the source channel
+		size_t m_stream;
+
+		///@brief Type of the source stream (STREAM_TYPE_ANALOG if unconnected, matching StreamDescriptor::GetType())
+		Stream::StreamType m_type;
+
+		///@brief Value of the source stream if it's a scalar, otherwise zero
+		float m_scalarValue;
+	};
+
+	void ResolveInputWaveforms();
+
+	/**
+		@brief Returns the snapshot of an input built by the most recent ResolveInputWaveforms() call
+
+		Only valid during Refresh(): the graph executor resolves inputs at pass setup, and filters refreshed
+		outside the scheduler should call ResolveInputWaveforms() themselves before using this.
+	 */
+	const ResolvedInput& GetResolvedInput(size_t i) const
+	{ return m_resolvedInputs[i]; }
+
+	///@brief Returns the snapshotted waveform of an input; see GetResolvedInput()
+	WaveformBase* GetResolvedInputWaveform(size_t i) const
+	{ return m_resolvedInputs[i].m_waveform; }
+
 protected:
 	virtual void OnInputChanged(size_t i);
 
@@ -144,6 +185,50 @@ public:
 
 	bool IsDownstreamOf(std::set<FlowGraphNode*> nodes);
 
+	////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	// Dirty tracking for incremental graph execution
+
+	/**
+		@brief Marks this node as needing re-evaluation on the next graph pass
+
+		Called automatically when an input is connected, a new waveform arrives, or configuration is loaded.
+		Code which mutates a FilterParameter or otherwise changes node behavior out of band should call this
+		so the next FilterGraphExecutor pass knows the node's output is stale.
+	 */
+	void MarkDirty()
+	{ m_dirty = true; }
+
+	///@brief Returns true if this node's inputs, input data, or configuration changed since it last ran
+	bool IsDirty()
+	{ return m_dirty; }
+
+	///@brief Clears the dirty flag, normally called by FilterGraphExecutor after re-evaluating the node
+	void ClearDirty()
+	{ m_dirty = false; }
+
+	////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	// Priority tiers for trigger-rate adaptive scheduling
+
+	enum PriorityTier
+	{
+		///@brief Must run on every acquisition (trigger counters, pass/fail mask tests)
+		PRIORITY_CRITICAL,
+
+		///@brief Default: runs on every pass, never decimated
+		PRIORITY_NORMAL,
+
+		///@brief Expensive display-only processing that may be decimated to every Nth trigger under load
+		PRIORITY_COSMETIC
+	};
+
+	///@brief Returns the scheduling priority tier of this node
+	PriorityTier GetPriorityTier()
+	{ return m_priorityTier; }
+
+	///@brief Sets the scheduling priority tier (see FilterGraphExecutor::EnableAdaptiveDecimation)
+	void SetPriorityTier(PriorityTier tier)
+	{ m_priorityTier = tier; }
+
 	////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 	// Accelerated waveform accessors
 
@@ -212,9 +297,18 @@ protected:
 	///The channel (if any) connected to each of our inputs
 	std::vector<StreamDescriptor> m_inputs;
 
+	///@brief Flat per-input snapshots rebuilt by ResolveInputWaveforms() at the start of each pass
+	std::vector<ResolvedInput> m_resolvedInputs;
+
 	//Parameters
 	ParameterMapType m_parameters;
 
+	///@brief True if our inputs, input data, or configuration changed since we last ran (see MarkDirty)
+	std::atomic<bool> m_dirty;
+
+	///@brief Scheduling priority tier (see SetPriorityTier)
+	PriorityTier m_priorityTier;
+
 public:
 
 	sigc::signal<void()> signal_parametersChanged()
@@ -58,4 +58,38 @@ inline Stream::StreamType StreamDescriptor::GetType()
 	return m_channel->GetType(m_stream);
 }
 
+/**
+	@brief Snapshots every input into the flat resolved-input table
+
+	The graph executor calls this at pass setup, immediately before Refresh(); filters refreshed outside the
+	scheduler should call it themselves at the top of Refresh(). Afterwards GetResolvedInput() and
+	GetResolvedInputWaveform() read straight out of the table with no descriptor chasing or validity checks.
+ */
+inline void FlowGraphNode::ResolveInputWaveforms()
+{
+	m_resolvedInputs.resize(m_inputs.size());
+	for(size_t i=0; i<m_inputs.size(); i++)
+	{
+		auto& in = m_inputs[i];
+		auto& r = m_resolvedInputs[i];
+
+		r.m_channel = in.m_channel;
+		r.m_stream = in.m_stream;
+
+		if(in.m_channel == nullptr)
+		{
+			r.m_waveform = nullptr;
+			r.m_type = Stream::STREAM_TYPE_ANALOG;
+			r.m_scalarValue = 0;
+		}
+		else
+		{
+			r.m_waveform = in.m_channel->GetData(in.m_stream);
+			r.m_type = in.m_channel->GetType(in.m_stream);
+			r.m_scalarValue = (r.m_type == Stream::STREAM_TYPE_ANALOG_SCALAR)
+				? in.m_channel->GetScalarValue(in.m_stream) : 0;
+		}
+	}
+}
+
 #endif
@@ -34,6 +34,12 @@
  */
 #include "scopehal.h"
 
+#ifdef _WIN32
+#include <windows.h>
+#include <shlwapi.h>
+#include <shlobj.h>
+#endif
+
 using namespace std;
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -246,6 +252,346 @@ void IBISParser::Clear()
 	m_models.clear();
 }
 
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Binary side cache
+
+//Format identifier at the start of a cache file
+static const uint32_t IBIS_CACHE_MAGIC = 0x49424943;	//"IBIC"
+
+//Bump this whenever the serialized layout of the parsed models changes
+static const uint32_t IBIS_CACHE_VERSION = 1;
+
+#pragma pack(push, 1)
+struct IBISCacheFileHeader
+{
+	uint32_t	magic;
+	uint32_t	version;
+	uint32_t	filecrc;
+	uint64_t	filelen;
+	uint64_t	payloadlen;
+	uint32_t	payloadcrc;
+};
+#pragma pack(pop)
+
+/**
+	@brief Returns the directory the binary cache lives in (creating it if needed), or "" if unavailable
+ */
+static string GetIBISCacheDir()
+{
+	try
+	{
+	#ifdef _WIN32
+		wchar_t* stem;
+		if(S_OK != SHGetKnownFolderPath(
+			FOLDERID_RoamingAppData,
+			KF_FLAG_CREATE,
+			NULL,
+			&stem))
+		{
+			return "";
+		}
+
+		wchar_t directory[MAX_PATH];
+		if(NULL == PathCombineW(directory, stem, L"ngscopeclient"))
+		{
+			CoTaskMemFree(static_cast<void*>(stem));
+			return "";
+		}
+
+		// Ensure the directory exists
+		const auto result = CreateDirectoryW(directory, NULL);
+		CoTaskMemFree(static_cast<void*>(stem));
+		if(!result && GetLastError() != ERROR_ALREADY_EXISTS)
+			return "";
+
+		return NarrowPath(directory) + "\\";
+	#else
+		// Ensure all directories in path exist
+		CreateDirectory("~/.cache");
+		CreateDirectory("~/.cache/ngscopeclient");
+		return ExpandPath("~/.cache/ngscopeclient") + "/";
+	#endif
+	}
+	catch(const exception& e)
+	{
+		return "";
+	}
+}
+
+/**
+	@brief Hashes a file's contents, returning false if it couldn't be read
+ */
+static bool HashFile(const string& fname, uint32_t& crc, uint64_t& len)
+{
+	FILE* fp = fopen(fname.c_str(), "rb");
+	if(!fp)
+		return false;
+
+	fseek(fp, 0, SEEK_END);
+	len = ftell(fp);
+	fseek(fp, 0, SEEK_SET);
+
+	vector<uint8_t> buf;
+	buf.resize(len);
+	if( (len != 0) && (len != fread(&buf[0], 1, len, fp)) )
+	{
+		fclose(fp);
+		return false;
+	}
+	fclose(fp);
+
+	crc = CRC32(buf);
+	return true;
+}
+
+//Serialization primitives for the cache payload.
+//Everything is stored in host byte order: the cache is a local artifact regenerated on demand,
+//not an interchange format.
+
+static void CacheAppend(vector<uint8_t>& blob, const void* p, size_t len)
+{
+	auto q = reinterpret_cast<const uint8_t*>(p);
+	blob.insert(blob.end(), q, q + len);
+}
+
+static void CacheAppendString(vector<uint8_t>& blob, const string& str)
+{
+	uint32_t len = str.length();
+	CacheAppend(blob, &len, sizeof(len));
+	CacheAppend(blob, str.data(), len);
+}
+
+template<class T>
+static void CacheAppendPoints(vector<uint8_t>& blob, const vector<T>& vec)
+{
+	uint64_t n = vec.size();
+	CacheAppend(blob, &n, sizeof(n));
+	if(n)
+		CacheAppend(blob, &vec[0], n * sizeof(T));
+}
+
+static bool CacheRead(const vector<uint8_t>& blob, size_t& pos, void* p, size_t len)
+{
+	if( (pos + len) > blob.size() )
+		return false;
+	memcpy(p, &blob[pos], len);
+	pos += len;
+	return true;
+}
+
+static bool CacheReadString(const vector<uint8_t>& blob, size_t& pos, string& str)
+{
+	uint32_t len;
+	if(!CacheRead(blob, pos, &len, sizeof(len)))
+		return false;
+	if( (pos + len) > blob.size() )
+		return false;
+	str.assign(reinterpret_cast<const char*>(&blob[pos]), len);
+	pos += len;
+	return true;
+}
+
+template<class T>
+static bool CacheReadPoints(const vector<uint8_t>& blob, size_t& pos, vector<T>& vec)
+{
+	uint64_t n;
+	if(!CacheRead(blob, pos, &n, sizeof(n)))
+		return false;
+	if(n > ( (blob.size() - pos) / sizeof(T) ) )
+		return false;
+	vec.resize(n);
+	if(n)
+	{
+		memcpy(&vec[0], &blob[pos], n * sizeof(T));
+		pos += n * sizeof(T);
+	}
+	return true;
+}
+
+/**
+	@brief Attempts to load previously parsed models from the binary cache
+
+	Returns false (without touching parser state on a clean miss) if the cache is absent, stale, or damaged,
+	in which case the caller falls back to the text parser.
+ */
+bool IBISParser::LoadCache(const string& path, uint32_t filecrc, uint64_t filelen)
+{
+	FILE* fp = fopen(path.c_str(), "rb");
+	if(!fp)
+		return false;
+
+	//Validate the header before trusting any of the content
+	IBISCacheFileHeader header;
+	if(1 != fread(&header, sizeof(header), 1, fp))
+	{
+		fclose(fp);
+		return false;
+	}
+	if( (header.magic != IBIS_CACHE_MAGIC) ||
+		(header.version != IBIS_CACHE_VERSION) ||
+		(header.filecrc != filecrc) ||
+		(header.filelen != filelen) )
+	{
+		LogTrace("Rejecting stale IBIS cache file %s\n", path.c_str());
+		fclose(fp);
+		return false;
+	}
+
+	//Read and checksum the payload
+	vector<uint8_t> blob;
+	blob.resize(header.payloadlen);
+	if(header.payloadlen != fread(&blob[0], 1, header.payloadlen, fp))
+	{
+		fclose(fp);
+		return false;
+	}
+	fclose(fp);
+	if(header.payloadcrc != CRC32(blob))
+	{
+		LogWarning("Rejecting IBIS cache file %s due to bad CRC\n", path.c_str());
+		return false;
+	}
+
+	//Deserialize the models
+	size_t pos = 0;
+	uint32_t nmodels = 0;
+	bool ok =
+		CacheReadString(blob, pos, m_component) &&
+		CacheReadString(blob, pos, m_manufacturer) &&
+		CacheRead(blob, pos, &nmodels, sizeof(nmodels));
+	for(uint32_t i=0; ok && (i < nmodels); i++)
+	{
+		string name;
+		if(!CacheReadString(blob, pos, name))
+		{
+			ok = false;
+			break;
+		}
+
+		auto model = new IBISModel(name);
+		m_models[name] = model;
+
+		uint32_t type;
+		ok = CacheRead(blob, pos, &type, sizeof(type)) &&
+			CacheRead(blob, pos, model->m_vil, sizeof(model->m_vil)) &&
+			CacheRead(blob, pos, model->m_vih, sizeof(model->m_vih)) &&
+			CacheRead(blob, pos, model->m_temps, sizeof(model->m_temps)) &&
+			CacheRead(blob, pos, model->m_voltages, sizeof(model->m_voltages)) &&
+			CacheRead(blob, pos, model->m_dieCapacitance, sizeof(model->m_dieCapacitance));
+		model->m_type = static_cast<IBISModel::type_t>(type);
+
+		//I/V curves
+		for(int j=0; ok && (j < 3); j++)
+			ok = CacheReadPoints(blob, pos, model->m_pulldown[j].m_curve);
+		for(int j=0; ok && (j < 3); j++)
+			ok = CacheReadPoints(blob, pos, model->m_pullup[j].m_curve);
+
+		//V/T curves
+		for(int half=0; ok && (half < 2); half++)
+		{
+			auto& waves = half ? model->m_falling : model->m_rising;
+
+			uint32_t nwaves = 0;
+			ok = CacheRead(blob, pos, &nwaves, sizeof(nwaves));
+			for(uint32_t j=0; ok && (j < nwaves); j++)
+			{
+				VTCurves wave;
+				ok = CacheRead(blob, pos, &wave.m_fixtureResistance, sizeof(wave.m_fixtureResistance)) &&
+					CacheRead(blob, pos, &wave.m_fixtureVoltage, sizeof(wave.m_fixtureVoltage));
+				for(int k=0; ok && (k < 3); k++)
+					ok = CacheReadPoints(blob, pos, wave.m_curves[k]);
+				if(ok)
+					waves.push_back(wave);
+			}
+		}
+	}
+
+	//A truncated payload means the file is damaged: throw away the partial state and re-parse
+	if(!ok)
+	{
+		LogWarning("Rejecting damaged IBIS cache file %s\n", path.c_str());
+		Clear();
+		return false;
+	}
+
+	LogTrace("Loaded %zu IBIS models from cache %s\n", m_models.size(), path.c_str());
+	return true;
+}
+
+/**
+	@brief Writes the parsed models out to the binary cache
+ */
+void IBISParser::SaveCache(const string& path, uint32_t filecrc, uint64_t filelen)
+{
+	//Serialize the models
+	vector<uint8_t> blob;
+	CacheAppendString(blob, m_component);
+	CacheAppendString(blob, m_manufacturer);
+	uint32_t nmodels = m_models.size();
+	CacheAppend(blob, &nmodels, sizeof(nmodels));
+	for(auto it : m_models)
+	{
+		auto model = it.second;
+		CacheAppendString(blob, model->m_name);
+
+		uint32_t type = model->m_type;
+		CacheAppend(blob, &type, sizeof(type));
+		CacheAppend(blob, model->m_vil, sizeof(model->m_vil));
+		CacheAppend(blob, model->m_vih, sizeof(model->m_vih));
+		CacheAppend(blob, model->m_temps, sizeof(model->m_temps));
+		CacheAppend(blob, model->m_voltages, sizeof(model->m_voltages));
+		CacheAppend(blob, model->m_dieCapacitance, sizeof(model->m_dieCapacitance));
+
+		//I/V curves
+		for(int j=0; j<3; j++)
+			CacheAppendPoints(blob, model->m_pulldown[j].m_curve);
+		for(int j=0; j<3; j++)
+			CacheAppendPoints(blob, model->m_pullup[j].m_curve);
+
+		//V/T curves
+		for(int half=0; half<2; half++)
+		{
+			auto& waves = half ? model->m_falling : model->m_rising;
+
+			uint32_t nwaves = waves.size();
+			CacheAppend(blob, &nwaves, sizeof(nwaves));
+			for(auto& wave : waves)
+			{
+				CacheAppend(blob, &wave.m_fixtureResistance, sizeof(wave.m_fixtureResistance));
+				CacheAppend(blob, &wave.m_fixtureVoltage, sizeof(wave.m_fixtureVoltage));
+				for(int k=0; k<3; k++)
+					CacheAppendPoints(blob, wave.m_curves[k]);
+			}
+		}
+	}
+
+	IBISCacheFileHeader header;
+	header.magic = IBIS_CACHE_MAGIC;
+	header.version = IBIS_CACHE_VERSION;
+	header.filecrc = filecrc;
+	header.filelen = filelen;
+	header.payloadlen = blob.size();
+	header.payloadcrc = CRC32(blob);
+
+	FILE* fp = fopen(path.c_str(), "wb");
+	if(!fp)
+	{
+		LogWarning("Couldn't open IBIS cache file %s for writing\n", path.c_str());
+		return;
+	}
+	if( (1 != fwrite(&header, sizeof(header), 1, fp)) ||
+		(blob.size() != fwrite(&blob[0], 1, blob.size(), fp)) )
+	{
+		LogWarning("Write IBIS cache file failed (%s)\n", path.c_str());
+	}
+	fclose(fp);
+
+	LogTrace("Saved %zu IBIS models to cache %s (%zu bytes)\n", m_models.size(), path.c_str(), blob.size());
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Text format parsing
+
 bool IBISParser::Load(string fname)
 {
 	FILE* fp = fopen(fname.c_str(), "r");
@@ -255,6 +601,28 @@ bool IBISParser::Load(string fname)
 		return false;
 	}
 
+	//Hash the file and see if we have an up to date binary cache of the parsed models.
+	//Big vendor IBIS files take a while to go through the text parser, and they get reloaded every session.
+	uint32_t filecrc = 0;
+	uint64_t filelen = 0;
+	string cachePath;
+	if(HashFile(fname, filecrc, filelen))
+	{
+		auto cacheDir = GetIBISCacheDir();
+		if(!cacheDir.empty())
+		{
+			char cacheName[64];
+			snprintf(cacheName, sizeof(cacheName), "ibis_%08x.bin", filecrc);
+			cachePath = cacheDir + cacheName;
+
+			if(LoadCache(cachePath, filecrc, filelen))
+			{
+				fclose(fp);
+				return true;
+			}
+		}
+	}
+
 	//Comment char defaults to pipe, but can be changed (weird)
 	char comment = '|';
 
@@ -649,6 +1017,11 @@ bool IBISParser::Load(string fname)
 	}
 
 	fclose(fp);
+
+	//Parse succeeded, so write out the binary cache for next time
+	if(!cachePath.empty())
+		SaveCache(cachePath, filecrc, filelen);
+
 	return true;
 }
 
@@ -193,6 +193,9 @@ public:
 
 protected:
 	float ParseNumber(const char* str);
+
+	bool LoadCache(const std::string& path, uint32_t filecrc, uint64_t filelen);
+	void SaveCache(const std::string& path, uint32_t filecrc, uint64_t filelen);
 };
 
 #endif
@@ -52,6 +52,18 @@ bool ImportFilter::ValidateChannel(size_t /*i*/, StreamDescriptor /*stream*/)
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Accessors
 
+/**
+	@brief Returns the process-wide prefetch manager shared by all import filters
+
+	Batch import jobs should enqueue each upcoming file here a step or two before setting it as the filename
+	parameter, so the parse finds its bytes already in the page cache instead of blocking on disk.
+ */
+FilePrefetchManager& ImportFilter::GetPrefetchManager()
+{
+	static FilePrefetchManager mgr;
+	return mgr;
+}
+
 void ImportFilter::SetDefaultName()
 {
 	auto fname = m_parameters[m_fpname].ToString();
@@ -35,6 +35,8 @@
 #ifndef ImportFilter_h
 #define ImportFilter_h
 
+#include "FilePrefetchManager.h"
+
 /**
 	@brief Helper base class for filters that import a waveform from a file.
 
@@ -56,6 +58,8 @@ public:
 	std::string GetFileNameParameter()
 	{ return m_fpname; }
 
+	static FilePrefetchManager& GetPrefetchManager();
+
 protected:
 	std::string m_fpname;
 
@@ -134,6 +134,9 @@ size_t InstrumentChannel::AddStream(Unit yunit, const string& name, Stream::Stre
  */
 void InstrumentChannel::SetData(WaveformBase* pNew, size_t stream)
 {
+	//New acquisition data means everything downstream of us is stale, even if the waveform object was recycled
+	MarkDirty();
+
 	if(m_streams[stream].m_waveform == pNew)
 		return;
 
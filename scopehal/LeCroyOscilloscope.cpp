@@ -79,7 +79,9 @@ LeCroyOscilloscope::LeCroyOscilloscope(SCPITransport* transport)
 	, m_interleavingValid(false)
 	, m_meterMode(Multimeter::DC_VOLTAGE)
 	, m_meterModeValid(false)
+	, m_measurementSlotsValid(false)
 	, m_highDefinition(false)
+	, m_parallelDownload(false)
 {
 	//standard initialization
 	FlushConfigCache();
@@ -1011,7 +1013,8 @@ void LeCroyOscilloscope::DetectAnalogChannels()
 
 LeCroyOscilloscope::~LeCroyOscilloscope()
 {
-
+	for(auto t : m_channelDataTransports)
+		delete t;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -1046,6 +1049,7 @@ void LeCroyOscilloscope::FlushConfigCache()
 	m_triggerOffsetValid = false;
 	m_interleavingValid = false;
 	m_meterModeValid = false;
+	m_measurementSlotsValid = false;
 
 	//Clear cached display name of all channels
 	for(auto c : m_channels)
@@ -2298,6 +2302,37 @@ bool LeCroyOscilloscope::ReadWaveformBlock(string& data)
 	return true;
 }
 
+/**
+	@brief Gets (lazily opening) the secondary data connection for a channel, or NULL if one cannot be opened
+ */
+SCPITransport* LeCroyOscilloscope::GetChannelDataTransport(size_t i)
+{
+	if(m_channelDataTransports.size() <= i)
+		m_channelDataTransports.resize(m_analogChannelCount, nullptr);
+
+	if(m_channelDataTransports[i])
+		return m_channelDataTransports[i];
+
+	//Open a second session to the instrument using the same transport type and arguments
+	auto transport = SCPITransport::CreateTransport(m_transport->GetName(), m_transport->GetConnectionString());
+	if(!transport || !transport->IsConnected())
+	{
+		LogWarning("Failed to open secondary data connection for channel %zu, falling back to serial download\n", i);
+		delete transport;
+		return nullptr;
+	}
+
+	//Configure the new session to match the data format of the main connection
+	transport->SendCommandImmediate("CHDR OFF");
+	if(m_highDefinition)
+		transport->SendCommandImmediate("COMM_FORMAT DEF9,WORD,BIN");
+	else
+		transport->SendCommandImmediate("COMM_FORMAT DEF9,BYTE,BIN");
+
+	m_channelDataTransports[i] = transport;
+	return transport;
+}
+
 /**
 	@brief Optimized function for checking channel enable status en masse with less round trips to the scope
  */
@@ -2381,6 +2416,8 @@ bool LeCroyOscilloscope::ReadWavedescs(
 		if(enabled[i])
 			any_enabled = true;
 	}
+	vector<string> queries;
+	vector<unsigned int> qchans;
 	for(unsigned int i=0; i<m_analogChannelCount; i++)
 	{
 		wavedescs.push_back("");
@@ -2391,19 +2428,16 @@ bool LeCroyOscilloscope::ReadWavedescs(
 		{
 			if(firstEnabledChannel == UINT_MAX)
 				firstEnabledChannel = i;
-			m_transport->SendCommandQueued(GetOscilloscopeChannel(i)->GetHwname() + ":WF? DESC");
+			queries.push_back(GetOscilloscopeChannel(i)->GetHwname() + ":WF? DESC");
+			qchans.push_back(i);
 		}
 	}
 
-	m_transport->FlushCommandQueue();
-	for(unsigned int i=0; i<m_analogChannelCount; i++)
+	BatchPull(queries, [&](size_t n)
 	{
-		if(enabled[i] || (!any_enabled && i==0))
-		{
-			if(!ReadWaveformBlock(wavedescs[i]))
-				LogError("ReadWaveformBlock for wavedesc %u failed\n", i);
-		}
-	}
+		if(!ReadWaveformBlock(wavedescs[qchans[n]]))
+			LogError("ReadWaveformBlock for wavedesc %u failed\n", qchans[n]);
+	});
 
 	//Check length, complain if a wavedesc comes back too short
 	size_t expected_wavedesc_size = 346;
@@ -2421,7 +2455,7 @@ bool LeCroyOscilloscope::ReadWavedescs(
 	return true;
 }
 
-void LeCroyOscilloscope::RequestWaveforms(bool* enabled, uint32_t num_sequences, bool denabled)
+void LeCroyOscilloscope::RequestWaveforms(bool* enabled, uint32_t num_sequences, bool denabled, bool parallelAnalog)
 {
 	//Ask for all analog waveforms
 	bool sent_wavetime = false;
@@ -2436,8 +2470,9 @@ void LeCroyOscilloscope::RequestWaveforms(bool* enabled, uint32_t num_sequences,
 				sent_wavetime = true;
 			}
 
-			//Ask for the data
-			m_transport->SendCommandQueued(GetOscilloscopeChannel(i)->GetHwname() + ":WF? DAT1");
+			//Ask for the data (unless it's being downloaded over the per-channel sockets instead)
+			if(!parallelAnalog)
+				m_transport->SendCommandQueued(GetOscilloscopeChannel(i)->GetHwname() + ":WF? DAT1");
 		}
 	}
 
@@ -2539,11 +2574,17 @@ vector<WaveformBase*> LeCroyOscilloscope::ProcessAnalogWaveform(
 	const int16_t* wdata = reinterpret_cast<const int16_t*>(data);
 	const int8_t* bdata = reinterpret_cast<const int8_t*>(data);
 
+	//Decimate at parse time if requested, so the waveform entering the graph is already at analysis rate
+	uint64_t decimation = GetEffectiveDownloadDecimation();
+	auto decmode = GetDownloadDecimationMode();
+	if(num_per_segment < decimation)
+		decimation = 1;
+
 	for(size_t j=0; j<num_sequences; j++)
 	{
 		//Set up the capture we're going to store our data into
 		auto cap = AllocateAnalogWaveform(m_nickname + "." + GetChannel(j)->GetHwname());
-		cap->m_timescale = round(interval);
+		cap->m_timescale = round(interval) * decimation;
 		cap->m_triggerPhase = h_off_frac;
 		cap->m_startTimestamp = ttime;
 		cap->PrepareForCpuAccess();
@@ -2554,11 +2595,60 @@ vector<WaveformBase*> LeCroyOscilloscope::ProcessAnalogWaveform(
 		else
 			cap->m_startFemtoseconds = static_cast<int64_t>(basetime * FS_PER_SECOND);
 
-		cap->Resize(num_per_segment);
-
 		//Convert raw ADC samples to volts
-		if(m_highDefinition)
+		if(decimation > 1)
+		{
+			cap->Resize(GetDecimatedLength(num_per_segment, decimation, decmode));
+			if(m_highDefinition)
+			{
+				if(decmode == DECIMATE_MINMAX)
+				{
+					Convert16BitSamplesMinMax(
+						cap->m_samples.GetCpuPointer(),
+						wdata + j*num_per_segment,
+						v_gain,
+						v_off,
+						num_per_segment,
+						decimation);
+				}
+				else
+				{
+					Convert16BitSamplesBoxcar(
+						cap->m_samples.GetCpuPointer(),
+						wdata + j*num_per_segment,
+						v_gain,
+						v_off,
+						num_per_segment,
+						decimation);
+				}
+			}
+			else
+			{
+				if(decmode == DECIMATE_MINMAX)
+				{
+					Convert8BitSamplesMinMax(
+						cap->m_samples.GetCpuPointer(),
+						bdata + j*num_per_segment,
+						v_gain,
+						v_off,
+						num_per_segment,
+						decimation);
+				}
+				else
+				{
+					Convert8BitSamplesBoxcar(
+						cap->m_samples.GetCpuPointer(),
+						bdata + j*num_per_segment,
+						v_gain,
+						v_off,
+						num_per_segment,
+						decimation);
+				}
+			}
+		}
+		else if(m_highDefinition)
 		{
+			cap->Resize(num_per_segment);
 			Convert16BitSamples(
 				cap->m_samples.GetCpuPointer(),
 				wdata + j*num_per_segment,
@@ -2568,6 +2658,7 @@ vector<WaveformBase*> LeCroyOscilloscope::ProcessAnalogWaveform(
 		}
 		else
 		{
+			cap->Resize(num_per_segment);
 			Convert8BitSamples(
 				cap->m_samples.GetCpuPointer(),
 				bdata + j*num_per_segment,
@@ -2823,8 +2914,34 @@ bool LeCroyOscilloscope::AcquireData()
 				return false;
 		}
 
+		//See if we can download the analog waveforms over per-channel sockets in parallel.
+		//Only worth the extra connections if more than one channel has data to move.
+		bool parallelAnalog = false;
+		if(m_parallelDownload && pdesc)
+		{
+			unsigned int numEnabled = 0;
+			for(unsigned int i=0; i<m_analogChannelCount; i++)
+			{
+				if(enabled[i])
+					numEnabled ++;
+			}
+
+			if(numEnabled > 1)
+			{
+				parallelAnalog = true;
+				for(unsigned int i=0; i<m_analogChannelCount; i++)
+				{
+					if(enabled[i] && !GetChannelDataTransport(i))
+					{
+						parallelAnalog = false;
+						break;
+					}
+				}
+			}
+		}
+
 		//Ask for every enabled channel up front, so the scope can send us the next while we parse the first
-		RequestWaveforms(enabled, num_sequences, denabled);
+		RequestWaveforms(enabled, num_sequences, denabled, parallelAnalog);
 		m_transport->FlushCommandQueue();
 
 		if(pdesc)
@@ -2847,10 +2964,40 @@ bool LeCroyOscilloscope::AcquireData()
 			}
 
 			//Read the data from each analog waveform
-			for(unsigned int i=0; i<m_analogChannelCount; i++)
+			if(parallelAnalog)
 			{
-				if(enabled[i])
-					analogWaveformData[i] = m_transport->ReadReply();
+				//Pre-create the map entries so the worker threads never mutate the map structure
+				for(unsigned int i=0; i<m_analogChannelCount; i++)
+				{
+					if(enabled[i])
+						analogWaveformData[i] = "";
+				}
+
+				//One download thread per enabled channel, each with its own socket
+				vector<thread> downloadThreads;
+				for(unsigned int i=0; i<m_analogChannelCount; i++)
+				{
+					if(!enabled[i])
+						continue;
+
+					downloadThreads.emplace_back([this, i, &analogWaveformData]()
+					{
+						auto transport = m_channelDataTransports[i];
+						transport->SendCommandImmediate(GetOscilloscopeChannel(i)->GetHwname() + ":WF? DAT1");
+						analogWaveformData[i] = transport->ReadReply();
+					});
+				}
+
+				for(auto& t : downloadThreads)
+					t.join();
+			}
+			else
+			{
+				for(unsigned int i=0; i<m_analogChannelCount; i++)
+				{
+					if(enabled[i])
+						analogWaveformData[i] = m_transport->ReadReply();
+				}
 			}
 		}
 
@@ -3723,6 +3870,28 @@ int64_t LeCroyOscilloscope::GetDeskewForChannel(size_t channel)
 	return skew_ps;
 }
 
+bool LeCroyOscilloscope::IsDownloadWindowingSupported()
+{
+	return true;
+}
+
+void LeCroyOscilloscope::SetDownloadWindow(uint64_t start, uint64_t length)
+{
+	//WAVEFORM_SETUP controls which part of acquisition memory WF? transfers:
+	//SP = sparsing (0 = every point), NP = number of points (0 = all), FP = first point, SN = segment (0 = all)
+	m_transport->SendCommandQueued(
+		"WAVEFORM_SETUP SP,0,NP," + to_string(length) + ",FP," + to_string(start) + ",SN,0");
+
+	Oscilloscope::SetDownloadWindow(start, length);
+}
+
+void LeCroyOscilloscope::ClearDownloadWindow()
+{
+	m_transport->SendCommandQueued("WAVEFORM_SETUP SP,0,NP,0,FP,0,SN,0");
+
+	Oscilloscope::ClearDownloadWindow();
+}
+
 bool LeCroyOscilloscope::IsInterleaving()
 {
 	//interleaving is automatic / not possible
@@ -3966,6 +4135,73 @@ void LeCroyOscilloscope::SetADCMode(size_t /*channel*/, size_t mode)
 	}
 }
 
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Hardware measurements
+
+vector<Oscilloscope::HardwareMeasurement> LeCroyOscilloscope::GetHardwareMeasurements()
+{
+	//Figure out which of the P1...P8 parameter slots are turned on. This is cached: the set only changes
+	//when the user reconfigures measurements, which flushes the config cache. The view flags themselves are
+	//fetched with one compound VBS query rather than eight separate round trips.
+	vector<string> names;
+	{
+		lock_guard<recursive_mutex> lock(m_cacheMutex);
+		if(!m_measurementSlotsValid)
+		{
+			m_measurementSlots.clear();
+
+			string query = "VBS? 'return = ";
+			for(int i=1; i<=8; i++)
+			{
+				if(i > 1)
+					query += " & \",\" & ";
+				query += string("CStr(app.Measure.P") + to_string(i) + ".View)";
+			}
+			query += "'";
+
+			auto flags = explode(Trim(m_transport->SendCommandQueuedWithReply(query)), ',');
+			for(size_t i=0; i<flags.size(); i++)
+			{
+				if(Trim(flags[i]) == "True")
+					m_measurementSlots.push_back(string("P") + to_string(i+1));
+			}
+			m_measurementSlotsValid = true;
+		}
+		names = m_measurementSlots;
+	}
+
+	vector<HardwareMeasurement> ret;
+	if(names.empty())
+		return ret;
+
+	//Read every enabled slot's current value in a single round trip
+	string query = "VBS? 'return = ";
+	for(size_t i=0; i<names.size(); i++)
+	{
+		if(i > 0)
+			query += " & \";\" & ";
+		query += string("CStr(app.Measure.") + names[i] + ".Out.Result.Value)";
+	}
+	query += "'";
+
+	auto fields = explode(Trim(m_transport->SendCommandQueuedWithReply(query)), ';');
+	for(size_t i=0; (i < fields.size()) && (i < names.size()); i++)
+	{
+		//A slot with no valid result this acquisition returns non-numeric text; skip it
+		auto field = Trim(fields[i]);
+		char* end = nullptr;
+		double value = strtod(field.c_str(), &end);
+		if(end == field.c_str())
+			continue;
+
+		HardwareMeasurement m;
+		m.m_name = names[i];
+		m.m_value = value;
+		ret.push_back(m);
+	}
+	return ret;
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Logic analyzer configuration
 
@@ -5481,4 +5717,28 @@ void LeCroyOscilloscope::ForceHDMode(bool mode)
 	else
 		m_transport->SendCommandQueued("COMM_FORMAT DEF9,BYTE,BIN");
 
+	//Keep any secondary data connections in sync with the main one
+	for(auto t : m_channelDataTransports)
+	{
+		if(!t)
+			continue;
+
+		if(m_highDefinition)
+			t->SendCommandImmediate("COMM_FORMAT DEF9,WORD,BIN");
+		else
+			t->SendCommandImmediate("COMM_FORMAT DEF9,BYTE,BIN");
+	}
+}
+
+void LeCroyOscilloscope::SetParallelWaveformDownload(bool enable)
+{
+	m_parallelDownload = enable;
+
+	//Tear down the secondary connections if no longer wanted
+	if(!enable)
+	{
+		for(auto t : m_channelDataTransports)
+			delete t;
+		m_channelDataTransports.clear();
+	}
 }
@@ -81,6 +81,19 @@ public:
 
 	void ForceHDMode(bool mode);
 
+	/**
+		@brief Enables or disables parallel waveform download using one data socket per analog channel.
+
+		LeCroy instruments accept multiple concurrent remote control sessions, so when enabled, AcquireData()
+		opens a secondary connection per enabled channel and downloads all of them simultaneously rather than
+		serializing the transfers over the main control socket. Falls back to the single-connection path if
+		the extra sockets cannot be opened.
+	 */
+	void SetParallelWaveformDownload(bool enable);
+
+	bool GetParallelWaveformDownload()
+	{ return m_parallelDownload; }
+
 	//Channel configuration
 	virtual bool IsChannelEnabled(size_t i) override;
 	virtual void EnableChannel(size_t i) override;
@@ -233,6 +246,9 @@ public:
 	virtual int64_t GetTriggerOffset() override;
 	virtual void SetDeskewForChannel(size_t channel, int64_t skew) override;
 	virtual int64_t GetDeskewForChannel(size_t channel) override;
+	virtual bool IsDownloadWindowingSupported() override;
+	virtual void SetDownloadWindow(uint64_t start, uint64_t length) override;
+	virtual void ClearDownloadWindow() override;
 
 	////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 	// Logic analyzer configuration
@@ -257,6 +273,11 @@ public:
 	virtual size_t GetADCMode(size_t channel) override;
 	virtual void SetADCMode(size_t channel, size_t mode) override;
 
+	////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	// Hardware measurements
+
+	virtual std::vector<HardwareMeasurement> GetHardwareMeasurements() override;
+
 	//public so it can be called by TRCImportFilter
 	static time_t ExtractTimestamp(unsigned char* wavedesc, double& basetime);
 
@@ -300,12 +321,13 @@ protected:
 	std::string GetPossiblyEmptyString(const std::string& property);
 
 	bool ReadWaveformBlock(std::string& data);
+	SCPITransport* GetChannelDataTransport(size_t i);
 	bool ReadWavedescs(
 		std::vector<std::string>& wavedescs,
 		bool* enabled,
 		unsigned int& firstEnabledChannel,
 		bool& any_enabled);
-	void RequestWaveforms(bool* enabled, uint32_t num_sequences, bool denabled);
+	void RequestWaveforms(bool* enabled, uint32_t num_sequences, bool denabled, bool parallelAnalog = false);
 	std::vector<WaveformBase*> ProcessAnalogWaveform(
 		const char* data,
 		size_t datalen,
@@ -365,11 +387,19 @@ protected:
 	bool m_interleavingValid;
 	Multimeter::MeasurementTypes m_meterMode;
 	bool m_meterModeValid;
+	std::vector<std::string> m_measurementSlots;
+	bool m_measurementSlotsValid;
 	std::map<size_t, bool> m_probeIsActive;
 
 	//True if we have >8 bit capture depth
 	bool m_highDefinition;
 
+	///@brief True if parallel multi-socket waveform download has been requested
+	bool m_parallelDownload;
+
+	///@brief Secondary data-only connections used for parallel waveform download (indexed by analog channel)
+	std::vector<SCPITransport*> m_channelDataTransports;
+
 	///@brief External trigger input
 	OscilloscopeChannel* m_extTrigChannel;
 
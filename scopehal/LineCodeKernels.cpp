@@ -0,0 +1,239 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Implementation of LineCodeKernels
+ */
+#include "scopehal.h"
+#include "LineCodeKernels.h"
+
+#ifdef __x86_64__
+#include <immintrin.h>
+#endif
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Threshold crossing scans
+
+/**
+	@brief Returns the index of the first sample after (and including) start that is above the threshold
+
+	Returns count if no such sample exists.
+ */
+size_t LineCodeKernels::FindNextAbove(const float* pin, size_t count, size_t start, float threshold)
+{
+#ifdef __x86_64__
+	if(g_hasAvx2)
+		return FindNextAboveAVX2(pin, count, start, threshold);
+#endif
+	return FindNextAboveGeneric(pin, count, start, threshold);
+}
+
+/**
+	@brief Returns the index of the first sample after (and including) start that is below the threshold
+
+	Returns count if no such sample exists.
+ */
+size_t LineCodeKernels::FindNextBelow(const float* pin, size_t count, size_t start, float threshold)
+{
+#ifdef __x86_64__
+	if(g_hasAvx2)
+		return FindNextBelowAVX2(pin, count, start, threshold);
+#endif
+	return FindNextBelowGeneric(pin, count, start, threshold);
+}
+
+///@brief Generic backend for FindNextAbove()
+size_t LineCodeKernels::FindNextAboveGeneric(const float* pin, size_t count, size_t start, float threshold)
+{
+	for(size_t i=start; i<count; i++)
+	{
+		if(pin[i] > threshold)
+			return i;
+	}
+	return count;
+}
+
+///@brief Generic backend for FindNextBelow()
+size_t LineCodeKernels::FindNextBelowGeneric(const float* pin, size_t count, size_t start, float threshold)
+{
+	for(size_t i=start; i<count; i++)
+	{
+		if(pin[i] < threshold)
+			return i;
+	}
+	return count;
+}
+
+#ifdef __x86_64__
+
+/**
+	@brief AVX2 backend for FindNextAbove()
+
+	Compares eight samples at a time; the first hit falls out of the comparison mask with a count-trailing-zeros.
+ */
+__attribute__((target("avx2")))
+size_t LineCodeKernels::FindNextAboveAVX2(const float* pin, size_t count, size_t start, float threshold)
+{
+	size_t i = start;
+	if(count >= 8)
+	{
+		__m256 vt = _mm256_set1_ps(threshold);
+		size_t end = count - 8;
+		for(; i <= end; i += 8)
+		{
+			__m256 v = _mm256_loadu_ps(pin + i);
+			unsigned int mask = _mm256_movemask_ps(_mm256_cmp_ps(v, vt, _CMP_GT_OQ));
+			if(mask)
+				return i + __builtin_ctz(mask);
+		}
+	}
+
+	//Tail samples
+	for(; i<count; i++)
+	{
+		if(pin[i] > threshold)
+			return i;
+	}
+	return count;
+}
+
+/**
+	@brief AVX2 backend for FindNextBelow()
+ */
+__attribute__((target("avx2")))
+size_t LineCodeKernels::FindNextBelowAVX2(const float* pin, size_t count, size_t start, float threshold)
+{
+	size_t i = start;
+	if(count >= 8)
+	{
+		__m256 vt = _mm256_set1_ps(threshold);
+		size_t end = count - 8;
+		for(; i <= end; i += 8)
+		{
+			__m256 v = _mm256_loadu_ps(pin + i);
+			unsigned int mask = _mm256_movemask_ps(_mm256_cmp_ps(v, vt, _CMP_LT_OQ));
+			if(mask)
+				return i + __builtin_ctz(mask);
+		}
+	}
+
+	//Tail samples
+	for(; i<count; i++)
+	{
+		if(pin[i] < threshold)
+			return i;
+	}
+	return count;
+}
+
+#endif
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Bit packing
+
+/**
+	@brief Packs a digital sample array into LSB-first 64-bit words
+
+	Writes (count+63)/64 words; unused bits of the final word are zero. Callers that use ExtractBitWindow() must
+	allocate (and zero) one extra word past that.
+ */
+void LineCodeKernels::PackBits(const bool* pin, size_t count, uint64_t* pout)
+{
+#ifdef __x86_64__
+	if(g_hasAvx2)
+	{
+		PackBitsAVX2(pin, count, pout);
+		return;
+	}
+#endif
+	PackBitsGeneric(pin, count, pout);
+}
+
+///@brief Generic backend for PackBits()
+void LineCodeKernels::PackBitsGeneric(const bool* pin, size_t count, uint64_t* pout)
+{
+	size_t nwords = count / 64;
+	for(size_t w=0; w<nwords; w++)
+	{
+		uint64_t tmp = 0;
+		const bool* p = pin + w*64;
+		for(size_t j=0; j<64; j++)
+			tmp |= static_cast<uint64_t>(p[j]) << j;
+		pout[w] = tmp;
+	}
+
+	//Tail bits
+	if(count % 64)
+	{
+		uint64_t tmp = 0;
+		const bool* p = pin + nwords*64;
+		for(size_t j=0; j<(count % 64); j++)
+			tmp |= static_cast<uint64_t>(p[j]) << j;
+		pout[nwords] = tmp;
+	}
+}
+
+#ifdef __x86_64__
+/**
+	@brief AVX2 backend for PackBits()
+
+	Each bool is one byte in memory, so a compare-greater-than-zero plus movemask packs 32 samples per instruction
+	pair; two iterations fill a word.
+ */
+__attribute__((target("avx2")))
+void LineCodeKernels::PackBitsAVX2(const bool* pin, size_t count, uint64_t* pout)
+{
+	const __m256i* vin = reinterpret_cast<const __m256i*>(pin);
+	__m256i zero = _mm256_setzero_si256();
+
+	size_t nwords = count / 64;
+	for(size_t w=0; w<nwords; w++)
+	{
+		uint64_t lo = static_cast<uint32_t>(
+			_mm256_movemask_epi8(_mm256_cmpgt_epi8(_mm256_loadu_si256(vin + w*2), zero)));
+		uint64_t hi = static_cast<uint32_t>(
+			_mm256_movemask_epi8(_mm256_cmpgt_epi8(_mm256_loadu_si256(vin + w*2 + 1), zero)));
+		pout[w] = lo | (hi << 32);
+	}
+
+	//Tail bits
+	if(count % 64)
+	{
+		uint64_t tmp = 0;
+		const bool* p = pin + nwords*64;
+		for(size_t j=0; j<(count % 64); j++)
+			tmp |= static_cast<uint64_t>(p[j]) << j;
+		pout[nwords] = tmp;
+	}
+}
+#endif
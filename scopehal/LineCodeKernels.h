@@ -0,0 +1,111 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Declaration of LineCodeKernels
+ */
+#ifndef LineCodeKernels_h
+#define LineCodeKernels_h
+
+/**
+	@brief Bit-parallel primitives for line code decoders (Manchester, NRZI, MLT-3)
+
+	Line code decoders spend most of their time in two kinds of inner loop: scanning analog samples for the next
+	threshold crossing (edge hunting in Manchester timing recovery), and walking recovered bitstreams one bit at a
+	time (descrambler sync, pattern searches). Both vectorize well if the data is viewed as comparison bitmasks:
+	a block of samples compares against the threshold in one instruction and the resulting mask is scanned with a
+	count-trailing-zeros, and a packed bitstream XORs against 64 keystream bits per word operation.
+
+	These helpers are shared here so each decoder doesn't grow its own scalar copy. FindNextAbove / FindNextBelow
+	are drop-in replacements for "advance i until sample crosses threshold" loops. PackBits converts a digital
+	sample array to LSB-first 64-bit words for word-at-a-time processing; ExtractBitWindow reads 64 bits from an
+	arbitrary (unaligned) bit position of such an array.
+
+	AdvanceSideStreamScrambler64 steps the x^11 + x^9 + 1 side-stream scrambler LFSR (100baseTX, FDDI TP-PMD) by
+	64 output bits in a handful of word operations, so descrambling runs one XOR per 64 bits instead of one LFSR
+	update per bit.
+ */
+class LineCodeKernels
+{
+public:
+	static size_t FindNextAbove(const float* pin, size_t count, size_t start, float threshold);
+	static size_t FindNextBelow(const float* pin, size_t count, size_t start, float threshold);
+
+	static void PackBits(const bool* pin, size_t count, uint64_t* pout);
+
+	/**
+		@brief Reads 64 bits starting at an arbitrary bit position of a packed LSB-first bit array
+
+		The caller must pad the array with one extra zero word past the last data word so that reads near the end
+		stay in bounds (PackBits callers normally allocate (count+63)/64 + 1 words).
+	 */
+	static uint64_t ExtractBitWindow(const uint64_t* packed, size_t pos)
+	{
+		uint64_t w = packed[pos >> 6];
+		size_t shift = pos & 63;
+		if(shift)
+		{
+			w >>= shift;
+			w |= packed[(pos >> 6) + 1] << (64 - shift);
+		}
+		return w;
+	}
+
+	/**
+		@brief Advances the x^11 + x^9 + 1 side-stream scrambler keystream by one 64-bit word
+
+		Input is the previous 64 keystream bits, LSB-first (bit 0 oldest). The recurrence k[n] = k[n-9] ^ k[n-11]
+		only reaches 11 bits back, so the next 64 outputs are a function of the current word alone: seed the new
+		word from the top 11 bits of the old one, then iterate the shifted-XOR until all 64 bits have propagated
+		(each pass finalizes at least 9 more low bits, so 8 passes converge).
+	 */
+	static uint64_t AdvanceSideStreamScrambler64(uint64_t w)
+	{
+		uint64_t seed = (w >> 55) ^ (w >> 53);
+		uint64_t n = seed;
+		for(int i=0; i<8; i++)
+			n = seed ^ (n << 9) ^ (n << 11);
+		return n;
+	}
+
+protected:
+	static size_t FindNextAboveGeneric(const float* pin, size_t count, size_t start, float threshold);
+	static size_t FindNextBelowGeneric(const float* pin, size_t count, size_t start, float threshold);
+	static void PackBitsGeneric(const bool* pin, size_t count, uint64_t* pout);
+
+#ifdef __x86_64__
+	static size_t FindNextAboveAVX2(const float* pin, size_t count, size_t start, float threshold);
+	static size_t FindNextBelowAVX2(const float* pin, size_t count, size_t start, float threshold);
+	static void PackBitsAVX2(const bool* pin, size_t count, uint64_t* pout);
+#endif
+};
+
+#endif
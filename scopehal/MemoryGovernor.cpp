@@ -0,0 +1,193 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Implementation of MemoryGovernor
+ */
+#include "scopehal.h"
+
+using namespace std;
+
+///@brief Process-wide memory governor (disabled until a budget is configured)
+MemoryGovernor g_memoryGovernor;
+
+//AcceleratorBuffer is header-only, so its heap usage counter is defined here with its consumer
+std::atomic<size_t> g_cpuOnlyBufferBytes(0);
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Construction / destruction
+
+MemoryGovernor::MemoryGovernor()
+	: m_memoryBudget(0)
+	, m_level(PRESSURE_NONE)
+	, m_recommendedDecimation(1)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Usage tracking
+
+/**
+	@brief Returns the total bytes of host RAM currently held by waveform buffers
+
+	Counts the pinned memory arena (reserved, not just live, since reserved slabs are resident) plus heap-backed
+	MEM_TYPE_CPU_ONLY buffers. File-backed MEM_TYPE_CPU_PAGED buffers are excluded: the OS can reclaim those
+	pages on its own, so they're not what kills us under pressure.
+ */
+size_t MemoryGovernor::GetHostBytesInUse()
+{
+	size_t total = g_cpuOnlyBufferBytes;
+	if(g_vkPinnedMemoryArena)
+		total += g_vkPinnedMemoryArena->GetStatistics().m_bytesReserved;
+	return total;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Pressure response
+
+/**
+	@brief Compares usage to the budget and runs the staged responses for the resulting pressure level
+
+	Called from the acquisition path once per popped waveform; cheap no-op when no budget is configured.
+ */
+void MemoryGovernor::Check()
+{
+	PressureLevel newLevel;
+	size_t used;
+	size_t budget;
+	bool changed = false;
+
+	{
+		lock_guard<mutex> lock(m_mutex);
+
+		budget = m_memoryBudget;
+		if(budget == 0)
+			return;
+
+		used = GetHostBytesInUse();
+
+		if(used >= budget)
+			newLevel = PRESSURE_CRITICAL;
+		else if(used >= (budget/10)*9)
+			newLevel = PRESSURE_HARD;
+		else if(used >= (budget/10)*8)
+			newLevel = PRESSURE_SOFT;
+		else
+			newLevel = PRESSURE_NONE;
+
+		//Soft response: recycled buffers are pure cache, drop them all
+		if(newLevel >= PRESSURE_SOFT)
+		{
+			g_analogWaveformPool.Trim(0);
+			g_digitalWaveformPool.Trim(0);
+		}
+
+		//Hard response: push registered histories to disk beyond what their own budgets require
+		if(newLevel >= PRESSURE_HARD)
+		{
+			for(auto h : m_histories)
+				h->Spill(h->GetStats().m_residentBytes / 2);
+		}
+
+		//Critical response: escalate the decimation recommendation until usage comes back down
+		if(newLevel == PRESSURE_CRITICAL)
+			m_recommendedDecimation = min(m_recommendedDecimation * 2, static_cast<uint64_t>(256));
+		else if(newLevel == PRESSURE_NONE)
+			m_recommendedDecimation = 1;
+
+		if(newLevel != m_level)
+		{
+			m_level = newLevel;
+			changed = true;
+		}
+	}
+
+	//Emit outside the lock, since a handler may legitimately call back into the governor
+	if(changed)
+		m_pressureSignal.emit(newLevel, used, budget);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Accessors
+
+void MemoryGovernor::SetMemoryBudget(size_t bytes)
+{
+	lock_guard<mutex> lock(m_mutex);
+	m_memoryBudget = bytes;
+}
+
+size_t MemoryGovernor::GetMemoryBudget()
+{
+	lock_guard<mutex> lock(m_mutex);
+	return m_memoryBudget;
+}
+
+MemoryGovernor::PressureLevel MemoryGovernor::GetPressureLevel()
+{
+	lock_guard<mutex> lock(m_mutex);
+	return m_level;
+}
+
+/**
+	@brief Returns the recommended decimation factor for incoming waveforms (1 = no decimation needed)
+
+	Advisory only: acquisition code that knows what fidelity loss is acceptable decides whether to honor it.
+ */
+uint64_t MemoryGovernor::GetRecommendedDecimation()
+{
+	lock_guard<mutex> lock(m_mutex);
+	return m_recommendedDecimation;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// History registration
+
+/**
+	@brief Makes a history eligible for spilling under hard pressure (the governor does not take ownership)
+ */
+void MemoryGovernor::RegisterHistory(WaveformHistory* history)
+{
+	lock_guard<mutex> lock(m_mutex);
+	m_histories.push_back(history);
+}
+
+void MemoryGovernor::UnregisterHistory(WaveformHistory* history)
+{
+	lock_guard<mutex> lock(m_mutex);
+	for(size_t i=0; i<m_histories.size(); i++)
+	{
+		if(m_histories[i] == history)
+		{
+			m_histories.erase(m_histories.begin() + i);
+			break;
+		}
+	}
+}
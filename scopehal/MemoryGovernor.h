@@ -0,0 +1,125 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Declaration of MemoryGovernor
+ */
+#ifndef MemoryGovernor_h
+#define MemoryGovernor_h
+
+class WaveformHistory;
+
+/**
+	@brief Tracks waveform memory usage against a budget and degrades gracefully under pressure
+
+	Deep-memory captures plus history can exhaust RAM faster than the OS can page, at which point the process
+	dies mid test instead of losing a little fidelity. The governor watches global AcceleratorBuffer usage
+	(pinned arena plus heap-backed buffers) and, when a budget is configured, runs staged responses as usage
+	climbs:
+
+	    * Soft pressure: drop recycled buffers from the global waveform pools (pure cache, costs nothing but
+	      a reallocation on the next trigger)
+	    * Hard pressure: ask registered WaveformHistory instances to spill resident entries to disk, coldest
+	      first, beyond what their own budgets would have done
+	    * Critical pressure: recommend decimation of incoming waveforms, doubling the factor each check while
+	      usage stays critical
+
+	Level transitions are reported through a sigc signal so a supervising process can log and alert rather
+	than discovering the problem from an OOM kill. The governor never frees live waveform data itself; the
+	decimation recommendation is advisory and consumed by acquisition code that knows what fidelity loss is
+	acceptable.
+
+	Checks are driven from the acquisition path (Oscilloscope::PopPendingWaveform), so an idle session under
+	pressure stays where it is rather than thrashing. With no budget configured (the default) the governor
+	is entirely passive.
+ */
+class MemoryGovernor
+{
+public:
+	MemoryGovernor();
+
+	///@brief How close we are to the memory budget, in increasing order of severity
+	enum PressureLevel
+	{
+		///@brief Below the soft threshold (or no budget configured)
+		PRESSURE_NONE,
+
+		///@brief Over the soft threshold: pooled buffers are being dropped
+		PRESSURE_SOFT,
+
+		///@brief Over the hard threshold: history is being spilled to disk
+		PRESSURE_HARD,
+
+		///@brief Over the budget: incoming waveforms should be decimated
+		PRESSURE_CRITICAL
+	};
+
+	void Check();
+
+	size_t GetHostBytesInUse();
+
+	void SetMemoryBudget(size_t bytes);
+	size_t GetMemoryBudget();
+
+	PressureLevel GetPressureLevel();
+
+	uint64_t GetRecommendedDecimation();
+
+	void RegisterHistory(WaveformHistory* history);
+	void UnregisterHistory(WaveformHistory* history);
+
+	///@brief Signal emitted on pressure level transitions, with the new level, bytes in use, and the budget
+	sigc::signal<void(PressureLevel, size_t, size_t)>& signal_pressure()
+	{ return m_pressureSignal; }
+
+protected:
+	///@brief Lock guarding all governor state
+	std::mutex m_mutex;
+
+	///@brief Maximum bytes of waveform memory before staged responses kick in (0 = governor disabled)
+	size_t m_memoryBudget;
+
+	///@brief Pressure level as of the last Check()
+	PressureLevel m_level;
+
+	///@brief Current decimation recommendation (1 = none)
+	uint64_t m_recommendedDecimation;
+
+	///@brief Histories we may spill under hard pressure (not owned)
+	std::vector<WaveformHistory*> m_histories;
+
+	///@brief Signal emitted on pressure level transitions
+	sigc::signal<void(PressureLevel, size_t, size_t)> m_pressureSignal;
+};
+
+extern MemoryGovernor g_memoryGovernor;
+
+#endif
@@ -49,12 +49,22 @@ using namespace std;
 
 Oscilloscope::CreateMapType Oscilloscope::m_createprocs;
 
+std::atomic<double> Oscilloscope::s_lastConversionComplete{0};
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Construction / destruction
 
 Oscilloscope::Oscilloscope()
 {
 	m_trigger = NULL;
+	m_pipelineThreadRunning = false;
+	m_pipelineShutdown = false;
+	m_latencyTrackingEnabled = false;
+	m_downloadWindowEnabled = false;
+	m_downloadWindowStart = 0;
+	m_downloadWindowLength = 0;
+	m_downloadDecimation = 1;
+	m_downloadDecimationMode = DECIMATE_BOXCAR;
 
 	m_serializers.push_back(sigc::mem_fun(*this, &Oscilloscope::DoSerializeConfiguration));
 	m_loaders.push_back(sigc::mem_fun(*this, &Oscilloscope::DoLoadConfiguration));
@@ -63,6 +73,9 @@ Oscilloscope::Oscilloscope()
 
 Oscilloscope::~Oscilloscope()
 {
+	//Backstop only: by now the derived class is gone, so the app must have stopped the thread already
+	StopPipelinedAcquisition();
+
 	if(m_trigger)
 	{
 		m_trigger->DetachInputs();
@@ -146,6 +159,108 @@ bool Oscilloscope::WaitForTrigger(int timeout)
 	return false;
 }
 
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Pipelined acquisition
+
+void Oscilloscope::StartPipelinedAcquisition()
+{
+	if(m_pipelineThreadRunning)
+		return;
+
+	m_pipelineShutdown = false;
+	m_pipelineThreadRunning = true;
+	m_pipelineThread = thread(&Oscilloscope::PipelineThread, this);
+}
+
+void Oscilloscope::StopPipelinedAcquisition()
+{
+	if(!m_pipelineThreadRunning)
+		return;
+
+	m_pipelineShutdown = true;
+	m_pipelineThread.join();
+	m_pipelineThreadRunning = false;
+}
+
+/**
+	@brief Background thread which overlaps download of the next trigger with processing of the previous one
+ */
+void Oscilloscope::PipelineThread()
+{
+	#ifdef __linux__
+	pthread_setname_np(pthread_self(), "ScopeDownload");
+	#endif
+
+	while(!m_pipelineShutdown)
+	{
+		//Let the consumer catch up before buffering more than one waveform ahead, so a slow filter graph
+		//throttles the download instead of running the host out of memory
+		if(GetPendingWaveformCount() >= 2)
+		{
+			this_thread::sleep_for(chrono::milliseconds(1));
+			continue;
+		}
+
+		//Download as soon as the instrument has data for us.
+		//AcquireData() pushes onto m_pendingWaveforms and re-arms the trigger unless we're in one-shot mode,
+		//so the next acquisition proceeds on the instrument while the consumer crunches this one.
+		if(PollTrigger() == TRIGGER_MODE_TRIGGERED)
+		{
+			bool track = m_latencyTrackingEnabled;
+			double ttrig = track ? GetTime() : 0;
+			AcquireData();
+			if(track)
+				RecordTriggerLatency(ttrig, GetTime());
+		}
+		else
+			this_thread::sleep_for(chrono::milliseconds(1));
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Latency tracking
+
+/**
+	@brief Opens a latency record for an acquisition that has just finished downloading.
+
+	@param ttrig	Wall clock time the trigger was first observed
+	@param tdone	Wall clock time AcquireData() returned
+
+	One record is opened per AcquireData() call; the dequeue timestamp is filled in when the first waveform set
+	it produced is popped by the consumer. The conversion timestamp is taken from the shared sample conversion
+	helpers, so it is only attributed if a conversion actually ran during this download (drivers that convert
+	on the instrument, or not at all, report zero).
+ */
+void Oscilloscope::RecordTriggerLatency(double ttrig, double tdone)
+{
+	TriggerLatencyRecord rec;
+	rec.m_triggerArrival = ttrig;
+	rec.m_downloadComplete = tdone;
+	rec.m_dequeued = 0;
+
+	//The conversion stamp is global across instruments, so only believe it if it falls inside this download
+	double tconv = s_lastConversionComplete.load(std::memory_order_relaxed);
+	if( (tconv >= ttrig) && (tconv <= tdone) )
+		rec.m_conversionComplete = tconv;
+	else
+		rec.m_conversionComplete = 0;
+
+	lock_guard<mutex> lock(m_latencyMutex);
+	m_latencyInFlight.push_back(rec);
+}
+
+/**
+	@brief Returns per-trigger latency records for the most recent acquisitions, oldest first.
+
+	Only complete records (trigger observed, downloaded, and popped by the consumer) are returned; the most
+	recent 64 are retained.
+ */
+vector<Oscilloscope::TriggerLatencyRecord> Oscilloscope::GetTriggerLatencyRecords()
+{
+	lock_guard<mutex> lock(m_latencyMutex);
+	return vector<TriggerLatencyRecord>(m_latencyRecords.begin(), m_latencyRecords.end());
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Sequenced capture
 
@@ -174,6 +289,10 @@ void Oscilloscope::ClearPendingWaveforms()
 			delete it.second;
 		m_pendingWaveforms.pop_front();
 	}
+
+	//Discarded waveforms never reach the consumer, so their latency records are meaningless
+	lock_guard<mutex> lock2(m_latencyMutex);
+	m_latencyInFlight.clear();
 }
 
 /**
@@ -181,6 +300,9 @@ void Oscilloscope::ClearPendingWaveforms()
  */
 bool Oscilloscope::PopPendingWaveform()
 {
+	//Let the governor react to memory pressure once per acquisition (no-op if no budget is configured)
+	g_memoryGovernor.Check();
+
 	lock_guard<mutex> lock(m_pendingWaveformsMutex);
 	if(m_pendingWaveforms.size())
 	{
@@ -188,6 +310,22 @@ bool Oscilloscope::PopPendingWaveform()
 		for(auto it : set)
 			it.first.m_channel->SetData(it.second, it.first.m_stream);
 		m_pendingWaveforms.pop_front();
+
+		//Close out the oldest in-flight latency record now that the consumer has the data
+		if(m_latencyTrackingEnabled)
+		{
+			lock_guard<mutex> lock2(m_latencyMutex);
+			if(!m_latencyInFlight.empty())
+			{
+				auto rec = m_latencyInFlight.front();
+				m_latencyInFlight.pop_front();
+				rec.m_dequeued = GetTime();
+				m_latencyRecords.push_back(rec);
+				while(m_latencyRecords.size() > 64)
+					m_latencyRecords.pop_front();
+			}
+		}
+
 		return true;
 	}
 	return false;
@@ -686,6 +824,39 @@ int64_t Oscilloscope::GetDeskewForChannel(size_t /*channel*/)
 	return 0;
 }
 
+bool Oscilloscope::IsDownloadWindowingSupported()
+{
+	//override this function in the driver class if windowed download is supported
+	return false;
+}
+
+void Oscilloscope::SetDownloadWindow(uint64_t start, uint64_t length)
+{
+	//Drivers override this to push the transfer setup to the instrument, then call the base implementation
+	m_downloadWindowStart = start;
+	m_downloadWindowLength = length;
+	m_downloadWindowEnabled = true;
+}
+
+void Oscilloscope::ClearDownloadWindow()
+{
+	m_downloadWindowEnabled = false;
+	m_downloadWindowStart = 0;
+	m_downloadWindowLength = 0;
+}
+
+bool Oscilloscope::GetDownloadWindow(uint64_t& start, uint64_t& length)
+{
+	start = m_downloadWindowStart;
+	length = m_downloadWindowLength;
+	return m_downloadWindowEnabled;
+}
+
+uint64_t Oscilloscope::GetEffectiveDownloadDecimation()
+{
+	return max(m_downloadDecimation, g_memoryGovernor.GetRecommendedDecimation());
+}
+
 bool Oscilloscope::CanInterleave()
 {
 	//Check each conflict in the list
@@ -917,6 +1088,15 @@ bool Oscilloscope::HasTimebaseControls()
 	return true;
 }
 
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Hardware measurements
+
+vector<Oscilloscope::HardwareMeasurement> Oscilloscope::GetHardwareMeasurements()
+{
+	//No hardware measurement support in the base class
+	return {};
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Helpers for converting raw 8-bit ADC samples to fp32 waveforms
 
@@ -977,6 +1157,9 @@ void Oscilloscope::Convert8BitSamples(float* pout, const int8_t* pin, float gain
 		#endif
 			Convert8BitSamplesGeneric(pout, pin, gain, offset, count);
 	}
+
+	//Stamp completion for per-trigger latency tracking (see TriggerLatencyRecord)
+	s_lastConversionComplete.store(GetTime(), std::memory_order_relaxed);
 }
 
 /**
@@ -1109,6 +1292,9 @@ void Oscilloscope::ConvertUnsigned8BitSamples(float* pout, const uint8_t* pin, f
 		#endif
 			ConvertUnsigned8BitSamplesGeneric(pout, pin, gain, offset, count);
 	}
+
+	//Stamp completion for per-trigger latency tracking (see TriggerLatencyRecord)
+	s_lastConversionComplete.store(GetTime(), std::memory_order_relaxed);
 }
 
 /**
@@ -1270,6 +1456,9 @@ void Oscilloscope::Convert16BitSamples(float* pout, const int16_t* pin, float ga
 		#endif /* __x86_64__ */
 			Convert16BitSamplesGeneric(pout, pin, gain, offset, count);
 	}
+
+	//Stamp completion for per-trigger latency tracking (see TriggerLatencyRecord)
+	s_lastConversionComplete.store(GetTime(), std::memory_order_relaxed);
 }
 
 /**
@@ -1476,3 +1665,166 @@ void Oscilloscope::Convert16BitSamplesAVX512F(float* pout, const int16_t* pin, f
 
 #endif /* __x86_64__ */
 
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Decimating sample format conversion (for download decimation)
+
+/**
+	@brief Returns the number of output samples the decimating converters produce for a given input length
+ */
+size_t Oscilloscope::GetDecimatedLength(size_t count, size_t factor, DownloadDecimationMode mode)
+{
+	if(mode == DECIMATE_MINMAX)
+		return 2 * (count / (2*factor));
+	return count / factor;
+}
+
+/**
+	@brief Converts 8-bit ADC samples to floating point, averaging each block of factor samples
+ */
+void Oscilloscope::Convert8BitSamplesBoxcar(
+	float* pout, const int8_t* pin, float gain, float offset, size_t count, size_t factor)
+{
+	size_t outlen = count / factor;
+	float norm = gain / factor;
+
+	#pragma omp parallel for if(outlen > 250000)
+	for(size_t k=0; k<outlen; k++)
+	{
+		const int8_t* p = pin + k*factor;
+		int32_t sum = 0;
+		for(size_t j=0; j<factor; j++)
+			sum += p[j];
+		pout[k] = sum * norm - offset;
+	}
+
+	s_lastConversionComplete.store(GetTime(), std::memory_order_relaxed);
+}
+
+/**
+	@brief Converts 8-bit ADC samples to floating point, keeping the min and max of each block of 2*factor samples
+
+	Output samples alternate minimum then maximum, so the envelope survives the reduction (like hardware peak
+	detect) and the overall rate reduction matches boxcar mode.
+ */
+void Oscilloscope::Convert8BitSamplesMinMax(
+	float* pout, const int8_t* pin, float gain, float offset, size_t count, size_t factor)
+{
+	size_t blocksize = 2*factor;
+	size_t npairs = count / blocksize;
+
+	#pragma omp parallel for if(npairs > 125000)
+	for(size_t k=0; k<npairs; k++)
+	{
+		const int8_t* p = pin + k*blocksize;
+		int8_t vmin = p[0];
+		int8_t vmax = p[0];
+		for(size_t j=1; j<blocksize; j++)
+		{
+			vmin = min(vmin, p[j]);
+			vmax = max(vmax, p[j]);
+		}
+		pout[k*2] = vmin * gain - offset;
+		pout[k*2 + 1] = vmax * gain - offset;
+	}
+
+	s_lastConversionComplete.store(GetTime(), std::memory_order_relaxed);
+}
+
+/**
+	@brief Converts unsigned 8-bit ADC samples to floating point, averaging each block of factor samples
+ */
+void Oscilloscope::ConvertUnsigned8BitSamplesBoxcar(
+	float* pout, const uint8_t* pin, float gain, float offset, size_t count, size_t factor)
+{
+	size_t outlen = count / factor;
+	float norm = gain / factor;
+
+	#pragma omp parallel for if(outlen > 250000)
+	for(size_t k=0; k<outlen; k++)
+	{
+		const uint8_t* p = pin + k*factor;
+		uint32_t sum = 0;
+		for(size_t j=0; j<factor; j++)
+			sum += p[j];
+		pout[k] = sum * norm - offset;
+	}
+
+	s_lastConversionComplete.store(GetTime(), std::memory_order_relaxed);
+}
+
+/**
+	@brief Converts unsigned 8-bit ADC samples to floating point, keeping the min and max of each block
+ */
+void Oscilloscope::ConvertUnsigned8BitSamplesMinMax(
+	float* pout, const uint8_t* pin, float gain, float offset, size_t count, size_t factor)
+{
+	size_t blocksize = 2*factor;
+	size_t npairs = count / blocksize;
+
+	#pragma omp parallel for if(npairs > 125000)
+	for(size_t k=0; k<npairs; k++)
+	{
+		const uint8_t* p = pin + k*blocksize;
+		uint8_t vmin = p[0];
+		uint8_t vmax = p[0];
+		for(size_t j=1; j<blocksize; j++)
+		{
+			vmin = min(vmin, p[j]);
+			vmax = max(vmax, p[j]);
+		}
+		pout[k*2] = vmin * gain - offset;
+		pout[k*2 + 1] = vmax * gain - offset;
+	}
+
+	s_lastConversionComplete.store(GetTime(), std::memory_order_relaxed);
+}
+
+/**
+	@brief Converts 16-bit ADC samples to floating point, averaging each block of factor samples
+ */
+void Oscilloscope::Convert16BitSamplesBoxcar(
+	float* pout, const int16_t* pin, float gain, float offset, size_t count, size_t factor)
+{
+	size_t outlen = count / factor;
+	float norm = gain / factor;
+
+	#pragma omp parallel for if(outlen > 250000)
+	for(size_t k=0; k<outlen; k++)
+	{
+		const int16_t* p = pin + k*factor;
+		int32_t sum = 0;
+		for(size_t j=0; j<factor; j++)
+			sum += p[j];
+		pout[k] = sum * norm - offset;
+	}
+
+	s_lastConversionComplete.store(GetTime(), std::memory_order_relaxed);
+}
+
+/**
+	@brief Converts 16-bit ADC samples to floating point, keeping the min and max of each block
+ */
+void Oscilloscope::Convert16BitSamplesMinMax(
+	float* pout, const int16_t* pin, float gain, float offset, size_t count, size_t factor)
+{
+	size_t blocksize = 2*factor;
+	size_t npairs = count / blocksize;
+
+	#pragma omp parallel for if(npairs > 125000)
+	for(size_t k=0; k<npairs; k++)
+	{
+		const int16_t* p = pin + k*blocksize;
+		int16_t vmin = p[0];
+		int16_t vmax = p[0];
+		for(size_t j=1; j<blocksize; j++)
+		{
+			vmin = min(vmin, p[j]);
+			vmax = max(vmax, p[j]);
+		}
+		pout[k*2] = vmin * gain - offset;
+		pout[k*2 + 1] = vmax * gain - offset;
+	}
+
+	s_lastConversionComplete.store(GetTime(), std::memory_order_relaxed);
+}
+
@@ -666,6 +666,93 @@ public:
 	 */
 	virtual int64_t GetDeskewForChannel(size_t channel);
 
+	////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	// Windowed (region of interest) download
+
+	/**
+		@brief Returns true if the driver supports downloading a subset of acquisition memory (a zoom window)
+
+		The default implementation returns false.
+	 */
+	virtual bool IsDownloadWindowingSupported();
+
+	/**
+		@brief Restricts waveform download to a window of the acquisition record
+
+		Subsequent AcquireData() calls transfer only samples [start, start+length) of each enabled channel, cutting
+		per-trigger transfer size by the same ratio. This changes what is downloaded, not what the instrument
+		acquires: trigger position, sample rate, and memory depth are unaffected.
+
+		Typical protocol-debug use is to grab one full-depth capture for context, then window subsequent triggers
+		around the region of interest and recombine with the coarse capture graph side (see WaveformStitchFilter).
+
+		@param start	Index of the first sample to download
+		@param length	Number of samples to download
+
+		The base implementation only records the window; drivers reporting IsDownloadWindowingSupported() override
+		this (and ClearDownloadWindow()) to push the corresponding transfer setup to the instrument.
+	 */
+	virtual void SetDownloadWindow(uint64_t start, uint64_t length);
+
+	///@brief Returns waveform download to the full acquisition record
+	virtual void ClearDownloadWindow();
+
+	/**
+		@brief Gets the current download window, if one is active
+
+		@return True if a window is set (start/length filled in), false if downloading the full record
+	 */
+	bool GetDownloadWindow(uint64_t& start, uint64_t& length);
+
+	////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	// Download decimation
+
+	///@brief Reduction applied when parsing downloaded samples, if a download decimation factor is set
+	enum DownloadDecimationMode
+	{
+		///@brief Average each block of samples (antialiasing for analysis of in-band content)
+		DECIMATE_BOXCAR,
+
+		///@brief Keep the minimum and maximum of successive blocks (envelope preserving, like scope peak detect)
+		DECIMATE_MINMAX
+	};
+
+	/**
+		@brief Decimates waveforms by the requested factor while parsing the downloaded data
+
+		Monitoring setups often only need a fraction of the instrument's sample rate, but pay download time,
+		conversion time, and memory for the full rate waveform before the graph ever decimates it. With a download
+		decimation factor set, the raw-to-float conversion emits one output sample per block of @c factor inputs
+		(see DownloadDecimationMode for the reduction used), so the waveform entering the filter graph is already
+		at analysis rate.
+
+		This changes only how the downloaded record is parsed: the instrument still acquires and transfers full
+		rate data, and trigger position and timebase configuration are unaffected. A factor of 1 disables
+		decimation.
+	 */
+	void SetDownloadDecimation(uint64_t factor)
+	{ m_downloadDecimation = std::max(factor, static_cast<uint64_t>(1)); }
+
+	///@brief Returns the configured download decimation factor (1 = none)
+	uint64_t GetDownloadDecimation()
+	{ return m_downloadDecimation; }
+
+	///@brief Selects how blocks of samples are reduced when download decimation is active
+	void SetDownloadDecimationMode(DownloadDecimationMode mode)
+	{ m_downloadDecimationMode = mode; }
+
+	///@brief Returns the reduction used when download decimation is active
+	DownloadDecimationMode GetDownloadDecimationMode()
+	{ return m_downloadDecimationMode; }
+
+	/**
+		@brief Returns the decimation factor drivers should apply when parsing downloaded waveforms
+
+		This is the larger of the configured factor and the memory governor's advisory decimation, so waveforms
+		shrink automatically under memory pressure even if no factor was configured.
+	 */
+	uint64_t GetEffectiveDownloadDecimation();
+
 	////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 	// Sequenced triggering
 
@@ -823,6 +910,28 @@ public:
 
 	//TODO: window controls
 
+	////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	// Hardware measurements
+
+	///@brief A single measurement value read from the instrument's own measurement subsystem
+	struct HardwareMeasurement
+	{
+		///@brief Instrument-assigned slot name (e.g. "MEAS1" on Tektronix, "P1" on LeCroy)
+		std::string m_name;
+
+		///@brief Current value, in the measurement's natural units
+		double m_value;
+	};
+
+	/**
+		@brief Reads the current values of all measurements configured on the instrument
+
+		The default implementation returns an empty list (no hardware measurement support). Drivers should
+		override this with a single compound query parsed locally, so that polling N configured measurements
+		costs one round trip rather than N - the difference between ~10ms and ~100ms per update over a WAN.
+	 */
+	virtual std::vector<HardwareMeasurement> GetHardwareMeasurements();
+
 	////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 	// Configuration storage
 
@@ -865,6 +974,135 @@ public:
 	static void Convert16BitSamplesAVX512F(float* pout, const int16_t* pin, float gain, float offset, size_t count);
 #endif
 
+	//Decimating variants: fused conversion and reduction for download decimation.
+	//count is the INPUT sample count; the output length is GetDecimatedLength(count, factor, mode) samples.
+	static size_t GetDecimatedLength(size_t count, size_t factor, DownloadDecimationMode mode);
+
+	static void Convert8BitSamplesBoxcar(
+		float* pout, const int8_t* pin, float gain, float offset, size_t count, size_t factor);
+	static void Convert8BitSamplesMinMax(
+		float* pout, const int8_t* pin, float gain, float offset, size_t count, size_t factor);
+
+	static void ConvertUnsigned8BitSamplesBoxcar(
+		float* pout, const uint8_t* pin, float gain, float offset, size_t count, size_t factor);
+	static void ConvertUnsigned8BitSamplesMinMax(
+		float* pout, const uint8_t* pin, float gain, float offset, size_t count, size_t factor);
+
+	static void Convert16BitSamplesBoxcar(
+		float* pout, const int16_t* pin, float gain, float offset, size_t count, size_t factor);
+	static void Convert16BitSamplesMinMax(
+		float* pout, const int16_t* pin, float gain, float offset, size_t count, size_t factor);
+
+public:
+	////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	// Pipelined acquisition
+
+	/**
+		@brief Starts a background thread that arms and downloads waveforms continuously.
+
+		While the thread is running, the next trigger's data is downloaded over the transport while the application
+		processes the previous one, using m_pendingWaveforms as the handoff point: the thread polls for a trigger,
+		calls AcquireData() (which re-arms the instrument unless in one-shot mode), and pushes the result onto the
+		pending-waveform queue for the consumer to pop. At most two waveforms are buffered ahead, so a slow consumer
+		throttles the download rather than running the host out of memory.
+
+		The application must not call AcquireData() or PollTrigger() itself while pipelined acquisition is active,
+		and must call StopPipelinedAcquisition() before destroying the instrument.
+	 */
+	void StartPipelinedAcquisition();
+
+	///@brief Stops the background acquisition thread, blocking until it exits
+	void StopPipelinedAcquisition();
+
+	///@brief Checks if the background acquisition thread is running
+	bool IsPipelinedAcquisitionRunning()
+	{ return m_pipelineThreadRunning; }
+
+protected:
+	void PipelineThread();
+
+	///@brief Background waveform download thread
+	std::thread m_pipelineThread;
+
+	///@brief True if the download thread has been started and not yet stopped
+	std::atomic<bool> m_pipelineThreadRunning;
+
+	///@brief Set to request shutdown of the download thread
+	std::atomic<bool> m_pipelineShutdown;
+
+public:
+	////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	// Latency tracking
+
+	/**
+		@brief Timestamps for one trigger's trip through the acquisition pipeline.
+
+		All fields are wall-clock times from GetTime(), on the same timebase as
+		FilterGraphExecutor::GetLastPassCompletionTimes(), so the scope-side and filter-side pieces of an
+		end-to-end latency budget can be joined into a single per-trigger breakdown.
+	 */
+	struct TriggerLatencyRecord
+	{
+		///@brief PollTrigger() first reported the trigger
+		double m_triggerArrival;
+
+		///@brief AcquireData() returned (waveform downloaded, converted, and queued)
+		double m_downloadComplete;
+
+		///@brief The last raw-to-float sample conversion finished (0 if no shared conversion helper ran)
+		double m_conversionComplete;
+
+		///@brief The consumer popped the waveform set off the pending queue
+		double m_dequeued;
+	};
+
+	/**
+		@brief Enables or disables per-trigger latency tracking.
+
+		Tracking adds a few clock reads and a short lock acquisition per acquisition cycle, so it is off by
+		default. Records are only captured automatically when pipelined acquisition is active; an application
+		driving PollTrigger() / AcquireData() itself can call RecordTriggerLatency() with its own timestamps.
+	 */
+	void EnableLatencyTracking(bool enable)
+	{ m_latencyTrackingEnabled = enable; }
+
+	bool IsLatencyTrackingEnabled()
+	{ return m_latencyTrackingEnabled; }
+
+	void RecordTriggerLatency(double ttrig, double tdone);
+	std::vector<TriggerLatencyRecord> GetTriggerLatencyRecords();
+
+protected:
+	///@brief True if per-trigger latency records are being captured
+	std::atomic<bool> m_latencyTrackingEnabled;
+
+	///@brief Serializes access to the latency record queues
+	std::mutex m_latencyMutex;
+
+	///@brief Records for acquisitions that have been downloaded but not yet popped by the consumer
+	std::deque<TriggerLatencyRecord> m_latencyInFlight;
+
+	///@brief Completed records for the most recent triggers, oldest first
+	std::deque<TriggerLatencyRecord> m_latencyRecords;
+
+	///@brief Completion timestamp of the most recent raw-to-float sample conversion, in any driver
+	static std::atomic<double> s_lastConversionComplete;
+
+	///@brief True if a download window (region of interest) is active
+	bool m_downloadWindowEnabled;
+
+	///@brief Index of the first sample of the download window
+	uint64_t m_downloadWindowStart;
+
+	///@brief Length of the download window, in samples
+	uint64_t m_downloadWindowLength;
+
+	///@brief Decimation factor applied when parsing downloaded waveforms (1 = none)
+	uint64_t m_downloadDecimation;
+
+	///@brief Reduction used when download decimation is active
+	DownloadDecimationMode m_downloadDecimationMode;
+
 public:
 	////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 	// Waveform Access
@@ -917,14 +1155,9 @@ protected:
 	//The trigger
 	Trigger* m_trigger;
 
-	//Pool for reusing memory allocations
-	WaveformPool m_analogWaveformPool;
-
-	WaveformPool m_digitalWaveformPool;
-
 	UniformAnalogWaveform* AllocateAnalogWaveform(const std::string& name)
 	{
-		auto p = m_analogWaveformPool.Get();
+		auto p = g_analogWaveformPool.Get();
 		auto ret = dynamic_cast<UniformAnalogWaveform*>(p);
 		if(ret)
 		{
@@ -942,7 +1175,7 @@ protected:
 
 	SparseDigitalWaveform* AllocateDigitalWaveform(const std::string& name)
 	{
-		auto p = m_digitalWaveformPool.Get();
+		auto p = g_digitalWaveformPool.Get();
 		auto ret = dynamic_cast<SparseDigitalWaveform*>(p);
 		if(ret)
 		{
@@ -960,10 +1193,10 @@ protected:
 
 public:
 	void AddWaveformToAnalogPool(WaveformBase* w)
-	{ m_analogWaveformPool.Add(w); }
+	{ g_analogWaveformPool.Add(w); }
 
 	void AddWaveformToDigitalPool(WaveformBase* w)
-	{ m_digitalWaveformPool.Add(w); }
+	{ g_digitalWaveformPool.Add(w); }
 
 public:
 	typedef std::shared_ptr<Oscilloscope> (*CreateProcType)(SCPITransport*);
@@ -47,6 +47,69 @@ std::string PacketDecoder::m_backgroundColors[PROTO_STANDARD_COLOR_COUNT] =
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Packet
 
+namespace
+{
+	/**
+		@brief Pool of recycled Packet-sized memory blocks, carved from large slabs
+
+		Long packet-heavy captures create and destroy millions of Packet objects. Allocating them one at a time from
+		the global heap is slow and scatters them across memory; carving them out of slabs keeps consecutive packets
+		adjacent and makes freeing a cheap push onto the free list.
+	 */
+	class PacketPool
+	{
+	public:
+		void* Allocate()
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			if(m_freeList.empty())
+				AllocateSlab();
+			void* ret = m_freeList.back();
+			m_freeList.pop_back();
+			return ret;
+		}
+
+		void Free(void* p)
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_freeList.push_back(p);
+		}
+
+	protected:
+		void AllocateSlab()
+		{
+			const size_t packetsPerSlab = 4096;
+			m_slabs.emplace_back(new uint8_t[sizeof(Packet) * packetsPerSlab]);
+			auto base = m_slabs.back().get();
+			for(size_t i=0; i<packetsPerSlab; i++)
+				m_freeList.push_back(base + i*sizeof(Packet));
+		}
+
+		std::mutex m_mutex;
+		std::vector<void*> m_freeList;
+		std::vector<std::unique_ptr<uint8_t[]>> m_slabs;
+	};
+
+	PacketPool g_packetPool;
+}
+
+void* Packet::operator new(size_t size)
+{
+	//Derived classes (or anything else with a different size) go to the regular heap
+	if(size != sizeof(Packet))
+		return ::operator new(size);
+
+	return g_packetPool.Allocate();
+}
+
+void Packet::operator delete(void* p, size_t size)
+{
+	if(size != sizeof(Packet))
+		::operator delete(p);
+	else
+		g_packetPool.Free(p);
+}
+
 Packet::Packet()
 	: m_offset(0)
 	, m_len(0)
@@ -60,6 +123,89 @@ Packet::~Packet()
 {
 }
 
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// PacketIndex
+
+PacketIndex::PacketIndex()
+	: m_indexedCount(0)
+{
+}
+
+///@brief Discards all index state
+void PacketIndex::Clear()
+{
+	m_indexedCount = 0;
+	m_columns.clear();
+	m_errorBitmap.clear();
+}
+
+/**
+	@brief Indexes one packet
+
+	Packets must be added in ascending index order with no gaps, which keeps every posting list sorted
+	without ever needing an explicit sort.
+ */
+void PacketIndex::AddPacket(size_t i, Packet* p)
+{
+	for(auto& it : p->m_headers)
+		m_columns[it.first][it.second].push_back(i);
+
+	if(p->m_displayBackgroundColor == PacketDecoder::m_backgroundColors[PacketDecoder::PROTO_COLOR_ERROR])
+	{
+		size_t word = i / 64;
+		if(word >= m_errorBitmap.size())
+			m_errorBitmap.resize(word + 1, 0);
+		m_errorBitmap[word] |= (uint64_t(1) << (i % 64));
+	}
+
+	m_indexedCount = i + 1;
+}
+
+///@brief Returns the sorted packet indexes whose column exactly equals value, or null if there are none
+const std::vector<uint32_t>* PacketIndex::GetEqual(const std::string& column, const std::string& value) const
+{
+	auto cit = m_columns.find(column);
+	if(cit == m_columns.end())
+		return nullptr;
+	auto vit = cit->second.find(value);
+	if(vit == cit->second.end())
+		return nullptr;
+	return &vit->second;
+}
+
+///@brief Returns the sorted packet indexes whose column starts with prefix
+std::vector<uint32_t> PacketIndex::GetPrefix(const std::string& column, const std::string& prefix) const
+{
+	std::vector<uint32_t> ret;
+	auto cit = m_columns.find(column);
+	if(cit == m_columns.end())
+		return ret;
+
+	//Values are sorted, so all matches are contiguous starting at the lower bound of the prefix
+	for(auto vit = cit->second.lower_bound(prefix); vit != cit->second.end(); ++vit)
+	{
+		if(0 != vit->first.compare(0, prefix.size(), prefix))
+			break;
+		ret.insert(ret.end(), vit->second.begin(), vit->second.end());
+	}
+
+	//Merge the per-value posting lists back into capture order
+	std::sort(ret.begin(), ret.end());
+	return ret;
+}
+
+///@brief Returns the distinct values seen in a column, in sorted order
+std::vector<std::string> PacketIndex::GetValues(const std::string& column) const
+{
+	std::vector<std::string> ret;
+	auto cit = m_columns.find(column);
+	if(cit == m_columns.end())
+		return ret;
+	for(auto& it : cit->second)
+		ret.push_back(it.first);
+	return ret;
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Construction / destruction
 
@@ -82,6 +228,27 @@ void PacketDecoder::ClearPackets()
 	for(auto p : m_packets)
 		delete p;
 	m_packets.clear();
+	m_packetIndex.Clear();
+}
+
+/**
+	@brief Returns the query index over this filter's packets, indexing anything added since the last call
+
+	Lazy decoders get their outstanding packets materialized through GetPacket() as they're indexed, so the
+	header strings the index is built from are always populated.
+ */
+PacketIndex& PacketDecoder::GetPacketIndex()
+{
+	size_t n = GetPacketCount();
+
+	//If the packet list shrank we can't tell what else changed, so rebuild from scratch
+	if(m_packetIndex.GetIndexedCount() > n)
+		m_packetIndex.Clear();
+
+	for(size_t i = m_packetIndex.GetIndexedCount(); i < n; i++)
+		m_packetIndex.AddPacket(i, GetPacket(i));
+
+	return m_packetIndex;
 }
 
 bool PacketDecoder::GetShowDataColumn()
@@ -32,6 +32,97 @@
 
 #include "Filter.h"
 
+#include <omp.h>
+
+/**
+	@class
+	@brief Flat key-value store for packet headers
+
+	Provides the subset of the std::map interface that header code actually uses, but stores the entries in a single
+	contiguous vector. Packets rarely have more than a handful of headers, so a linear scan is faster than a tree
+	walk and avoids a per-node heap allocation for every header of every packet.
+ */
+class PacketHeaderMap
+{
+public:
+	typedef std::pair<std::string, std::string> value_type;
+	typedef std::vector<value_type>::iterator iterator;
+	typedef std::vector<value_type>::const_iterator const_iterator;
+
+	///@brief Returns a reference to the value for a key, inserting an empty value if not already present
+	std::string& operator[](const std::string& key)
+	{
+		for(auto& it : m_entries)
+		{
+			if(it.first == key)
+				return it.second;
+		}
+		m_entries.emplace_back(key, std::string());
+		return m_entries.back().second;
+	}
+
+	iterator find(const std::string& key)
+	{
+		for(auto it = m_entries.begin(); it != m_entries.end(); ++it)
+		{
+			if(it->first == key)
+				return it;
+		}
+		return m_entries.end();
+	}
+
+	const_iterator find(const std::string& key) const
+	{
+		for(auto it = m_entries.begin(); it != m_entries.end(); ++it)
+		{
+			if(it->first == key)
+				return it;
+		}
+		return m_entries.end();
+	}
+
+	iterator begin()
+	{ return m_entries.begin(); }
+
+	iterator end()
+	{ return m_entries.end(); }
+
+	const_iterator begin() const
+	{ return m_entries.begin(); }
+
+	const_iterator end() const
+	{ return m_entries.end(); }
+
+	size_t size() const
+	{ return m_entries.size(); }
+
+	bool empty() const
+	{ return m_entries.empty(); }
+
+	void clear()
+	{ m_entries.clear(); }
+
+	///@brief Key-by-key comparison (entries are kept in insertion order, which is ignored here)
+	bool operator==(const PacketHeaderMap& rhs) const
+	{
+		if(m_entries.size() != rhs.m_entries.size())
+			return false;
+		for(auto& it : m_entries)
+		{
+			auto jt = rhs.find(it.first);
+			if( (jt == rhs.end()) || (jt->second != it.second) )
+				return false;
+		}
+		return true;
+	}
+
+	bool operator!=(const PacketHeaderMap& rhs) const
+	{ return !(*this == rhs); }
+
+protected:
+	std::vector<value_type> m_entries;
+};
+
 /**
 	@class
 	@brief Generic display representation for arbitrary packetized data
@@ -42,6 +133,11 @@ public:
 	Packet();
 	virtual ~Packet();
 
+	//Packet-heavy decodes allocate these by the millions, so recycle them through a pool
+	//rather than hitting the global allocator for every packet
+	static void* operator new(size_t size);
+	static void operator delete(void* p, size_t size);
+
 	///Offset of the packet from the start of the capture (femtoseconds)
 	int64_t m_offset;
 
@@ -49,7 +145,7 @@ public:
 	int64_t m_len;
 
 	//Arbitrary header properties (human readable)
-	std::map<std::string, std::string> m_headers;
+	PacketHeaderMap m_headers;
 
 	//Packet bytes
 	std::vector<uint8_t> m_data;
@@ -77,6 +173,60 @@ public:
 	}
 };
 
+/**
+	@class
+	@brief Query index over a PacketDecoder's packet list
+
+	Interactive filtering in the protocol analyzer re-evaluates its predicate against every packet on each
+	keystroke, which doesn't scale to multi-million packet captures. This maintains, per header column, a
+	sorted map from value to the ascending list of packet indexes carrying that value, plus a bitmap of the
+	packets drawn in the error color (the most common canned predicate). Equality and prefix queries then
+	run in time proportional to the result size rather than the capture size.
+
+	The index is extended incrementally: packets appended since the last query get indexed on the next one,
+	so streaming captures don't pay for a rebuild every acquisition. Use PacketDecoder::GetPacketIndex()
+	rather than constructing one directly so this bookkeeping is handled for you.
+ */
+class PacketIndex
+{
+public:
+	PacketIndex();
+
+	void Clear();
+	void AddPacket(size_t i, Packet* p);
+
+	///@brief Returns the number of packets indexed so far
+	size_t GetIndexedCount() const
+	{ return m_indexedCount; }
+
+	const std::vector<uint32_t>* GetEqual(const std::string& column, const std::string& value) const;
+	std::vector<uint32_t> GetPrefix(const std::string& column, const std::string& prefix) const;
+	std::vector<std::string> GetValues(const std::string& column) const;
+
+	///@brief Returns the bitmap of packets drawn in the error color (bit i%64 of word i/64 = packet i)
+	const std::vector<uint64_t>& GetErrorBitmap() const
+	{ return m_errorBitmap; }
+
+	///@brief Checks whether a single packet is drawn in the error color
+	bool IsError(size_t i) const
+	{
+		size_t word = i / 64;
+		if(word >= m_errorBitmap.size())
+			return false;
+		return (m_errorBitmap[word] >> (i % 64)) & 1;
+	}
+
+protected:
+	///@brief Number of packets indexed so far
+	size_t m_indexedCount;
+
+	///@brief Map of column name -> value -> ascending packet indexes carrying that value
+	std::map<std::string, std::map<std::string, std::vector<uint32_t>>> m_columns;
+
+	///@brief One bit per packet, set if the packet is drawn in the error color
+	std::vector<uint64_t> m_errorBitmap;
+};
+
 /**
 	@class
 	@brief A protocol decoder that outputs packetized data
@@ -87,9 +237,32 @@ public:
 	PacketDecoder(const std::string& color, Filter::Category cat);
 	virtual ~PacketDecoder();
 
-	const std::vector<Packet*>& GetPackets()
+	/**
+		@brief Returns the full list of packets in the capture.
+
+		Lazy decoders materialize every outstanding packet before returning, so prefer the indexed
+		GetPacketCount() / GetPacket() interface when only a subset of rows is actually being displayed.
+	 */
+	virtual const std::vector<Packet*>& GetPackets()
 	{ return m_packets; }
 
+	///@brief Returns the number of packets in the capture
+	virtual size_t GetPacketCount()
+	{ return m_packets.size(); }
+
+	/**
+		@brief Returns the i'th packet, or null if out of range.
+
+		Decoders supporting lazy expansion override this to materialize packet details (header strings,
+		data bytes, colors) on first access rather than during Refresh().
+	 */
+	virtual Packet* GetPacket(size_t i)
+	{
+		if(i >= m_packets.size())
+			return nullptr;
+		return m_packets[i];
+	}
+
 	virtual std::vector<std::string> GetHeaders() =0;
 
 	virtual bool GetShowDataColumn();
@@ -118,18 +291,119 @@ public:
 
 	static std::string m_backgroundColors[PROTO_STANDARD_COLOR_COUNT];
 
+	PacketIndex& GetPacketIndex();
+
 	/**
 		@brief Clears the list of packets attached to this filter *without* freeing memory.
 
 		Typically used after copying the packets somewhere else and assuming ownership of them.
 	 */
 	void DetachPackets()
-	{ m_packets.clear(); }
+	{
+		m_packets.clear();
+		m_packetIndex.Clear();
+	}
 
 protected:
 	void ClearPackets();
 
+	/**
+		@brief Decodes a large capture as parallel chunks, for protocols where an idle bus carries no decoder state.
+
+		Splits the input at protocol idle boundaries, decodes each chunk into private waveform and packet buffers on
+		separate threads, then stitches the results back together in time order. Only safe for protocols where the
+		decoder can restart cold at an idle boundary: any state carried across packets (register pages, address
+		latches, etc) rules this out.
+
+		@param len			Number of input samples
+		@param findBoundary	Returns the index of the first safe restart point at or after the argument,
+							or len if there is none
+		@param decodeChunk	Decodes input samples [start, end), appending output samples to the supplied waveform
+							and any packets to the supplied list
+		@param cap			Output waveform, already configured with timescale and timestamps
+	 */
+	template<class W>
+	void DecodeChunked(
+		size_t len,
+		const std::function<size_t(size_t)>& findBoundary,
+		const std::function<void(size_t, size_t, W*, std::vector<Packet*>&)>& decodeChunk,
+		W* cap)
+	{
+		//Decode short captures in place, since fork/join and stitching overhead outweighs the parallelism
+		//TODO: tune split
+		const size_t minSamplesPerChunk = 250 * 1000;
+		size_t nchunks = std::min<size_t>(omp_get_max_threads(), len / minSamplesPerChunk);
+		if(nchunks < 2)
+		{
+			decodeChunk(0, len, cap, m_packets);
+			return;
+		}
+
+		//Find chunk boundaries, aligned forward to the next idle point so no chunk starts mid-packet
+		std::vector<size_t> bounds;
+		bounds.push_back(0);
+		size_t target = len / nchunks;
+		for(size_t i=1; i<nchunks; i++)
+		{
+			size_t b = findBoundary(i * target);
+			if(b >= len)
+				break;
+			if(b > bounds[bounds.size() - 1])
+				bounds.push_back(b);
+		}
+		bounds.push_back(len);
+		nchunks = bounds.size() - 1;
+		if(nchunks < 2)
+		{
+			decodeChunk(0, len, cap, m_packets);
+			return;
+		}
+
+		//Decode each chunk into private buffers
+		std::vector<std::unique_ptr<W>> chunkCaps;
+		std::vector<std::vector<Packet*>> chunkPackets(nchunks);
+		for(size_t i=0; i<nchunks; i++)
+		{
+			std::unique_ptr<W> c(new W);
+			c->m_timescale = cap->m_timescale;
+			c->m_startTimestamp = cap->m_startTimestamp;
+			c->m_startFemtoseconds = cap->m_startFemtoseconds;
+			c->m_triggerPhase = cap->m_triggerPhase;
+			c->PrepareForCpuAccess();
+			chunkCaps.push_back(std::move(c));
+		}
+
+		#pragma omp parallel for
+		for(size_t i=0; i<nchunks; i++)
+			decodeChunk(bounds[i], bounds[i+1], chunkCaps[i].get(), chunkPackets[i]);
+
+		//Stitch the chunk outputs back together in time order
+		size_t total = cap->m_samples.size();
+		for(size_t i=0; i<nchunks; i++)
+			total += chunkCaps[i]->m_samples.size();
+		cap->m_offsets.reserve(total);
+		cap->m_durations.reserve(total);
+		cap->m_samples.reserve(total);
+		for(size_t i=0; i<nchunks; i++)
+		{
+			auto& c = *chunkCaps[i];
+			size_t clen = c.m_samples.size();
+			for(size_t j=0; j<clen; j++)
+			{
+				cap->m_offsets.push_back(c.m_offsets[j]);
+				cap->m_durations.push_back(c.m_durations[j]);
+				cap->m_samples.push_back(c.m_samples[j]);
+			}
+
+			for(auto p : chunkPackets[i])
+				m_packets.push_back(p);
+		}
+	}
+
 	std::vector<Packet*> m_packets;
+
+	///@brief Query index over m_packets, maintained by GetPacketIndex()
+	PacketIndex m_packetIndex;
 };
 
 #endif
@@ -0,0 +1,175 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Implementation of PacketTimeline
+ */
+
+#include "scopehal.h"
+#include "PacketTimeline.h"
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Decoder management
+
+/**
+	@brief Adds a decoder to the timeline and positions its cursor at the first packet
+ */
+void PacketTimeline::AddDecoder(PacketDecoder* decoder)
+{
+	size_t i = m_decoders.size();
+	m_decoders.push_back(decoder);
+	m_positions.push_back(0);
+	m_onHeap.push_back(false);
+	PushCursor(i);
+}
+
+///@brief Removes all decoders from the timeline
+void PacketTimeline::Clear()
+{
+	m_decoders.clear();
+	m_positions.clear();
+	m_onHeap.clear();
+	m_heap = {};
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Cursor movement
+
+///@brief Rewinds the cursor to the start of the merged timeline
+void PacketTimeline::Reset()
+{
+	m_heap = {};
+	for(size_t i=0; i<m_decoders.size(); i++)
+	{
+		m_positions[i] = 0;
+		m_onHeap[i] = false;
+		PushCursor(i);
+	}
+}
+
+/**
+	@brief Positions the cursor at the first packet starting at or after the given timestamp
+
+	Binary searches each decoder's (time sorted) packet list then rebuilds the heap, so a seek is
+	O(k log n) regardless of where the cursor was beforehand.
+ */
+void PacketTimeline::SeekToTime(int64_t timeFs)
+{
+	m_heap = {};
+	for(size_t i=0; i<m_decoders.size(); i++)
+	{
+		auto d = m_decoders[i];
+		size_t lo = 0;
+		size_t hi = d->GetPacketCount();
+		while(lo < hi)
+		{
+			size_t mid = lo + (hi-lo)/2;
+			if(d->GetPacket(mid)->m_offset < timeFs)
+				lo = mid + 1;
+			else
+				hi = mid;
+		}
+		m_positions[i] = lo;
+		m_onHeap[i] = false;
+		PushCursor(i);
+	}
+}
+
+/**
+	@brief Puts a decoder's current packet on the heap, if it has one
+
+	A decoder that has run out of packets gets no heap entry; RefillHeap() retries it later so that
+	packets appended at the tail during streaming capture are still merged in.
+ */
+void PacketTimeline::PushCursor(size_t idecoder)
+{
+	if(m_onHeap[idecoder])
+		return;
+
+	auto d = m_decoders[idecoder];
+	size_t pos = m_positions[idecoder];
+	if(pos >= d->GetPacketCount())
+		return;
+
+	m_heap.emplace(d->GetPacket(pos)->m_offset, idecoder);
+	m_onHeap[idecoder] = true;
+}
+
+///@brief Re-checks decoders that previously ran dry, in case more packets have shown up since
+void PacketTimeline::RefillHeap()
+{
+	for(size_t i=0; i<m_decoders.size(); i++)
+	{
+		if(!m_onHeap[i])
+			PushCursor(i);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Iteration
+
+/**
+	@brief Returns the next packet of the merged timeline without consuming it
+
+	Returns false if every decoder's packets have been consumed.
+ */
+bool PacketTimeline::Peek(Entry& entry)
+{
+	RefillHeap();
+	if(m_heap.empty())
+		return false;
+
+	size_t i = m_heap.top().second;
+	entry.m_decoder = m_decoders[i];
+	entry.m_index = m_positions[i];
+	entry.m_packet = entry.m_decoder->GetPacket(entry.m_index);
+	return true;
+}
+
+/**
+	@brief Returns the next packet of the merged timeline and advances past it
+
+	Returns false if every decoder's packets have been consumed.
+ */
+bool PacketTimeline::Next(Entry& entry)
+{
+	if(!Peek(entry))
+		return false;
+
+	size_t i = m_heap.top().second;
+	m_heap.pop();
+	m_onHeap[i] = false;
+	m_positions[i] ++;
+	PushCursor(i);
+	return true;
+}
@@ -0,0 +1,102 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Declaration of PacketTimeline
+ */
+#ifndef PacketTimeline_h
+#define PacketTimeline_h
+
+#include "PacketDecoder.h"
+
+#include <queue>
+
+/**
+	@class
+	@brief Merged chronological view over the packet lists of several decoders
+
+	Correlating traffic across buses (say CAN, LIN, and Ethernet in one automotive capture) means walking
+	several decoders' packet lists in a single time order. Each list is already time sorted by construction,
+	so this runs a k-way heap merge over them with an incremental cursor: advancing to the next packet is
+	O(log k), seeking is a binary search per decoder, and nothing is ever re-sorted no matter how many times
+	the cursor moves.
+
+	Packet offsets are compared directly, so all decoders must share a time axis (packets decoded from the
+	same acquisition do). Lists may grow at the tail between calls - newly appended packets are picked up as
+	the cursor reaches them - but a Refresh() that replaces a decoder's packets invalidates the cursor; call
+	Reset() afterward.
+ */
+class PacketTimeline
+{
+public:
+
+	///@brief One entry of the merged timeline
+	struct Entry
+	{
+		///@brief Decoder the packet came from
+		PacketDecoder* m_decoder;
+
+		///@brief Index of the packet within its decoder's list
+		size_t m_index;
+
+		///@brief The packet itself
+		Packet* m_packet;
+	};
+
+	void AddDecoder(PacketDecoder* decoder);
+	void Clear();
+	void Reset();
+	void SeekToTime(int64_t timeFs);
+
+	bool Peek(Entry& entry);
+	bool Next(Entry& entry);
+
+protected:
+	void PushCursor(size_t idecoder);
+	void RefillHeap();
+
+	///@brief Decoders being merged
+	std::vector<PacketDecoder*> m_decoders;
+
+	///@brief Next unconsumed packet index for each decoder
+	std::vector<size_t> m_positions;
+
+	///@brief True if the decoder's current packet is on the heap
+	std::vector<bool> m_onHeap;
+
+	///@brief Min-heap of (packet offset, decoder index) over each decoder's current packet
+	std::priority_queue<
+		std::pair<int64_t, size_t>,
+		std::vector<std::pair<int64_t, size_t>>,
+		std::greater<std::pair<int64_t, size_t>>> m_heap;
+};
+
+#endif
@@ -46,6 +46,12 @@ PausableFilter::PausableFilter(const string& color, Category cat, Unit xunit)
 	: Filter(color, cat, xunit)
 	, m_running(true)
 	, m_oneShot(false)
+	, m_workQuantum(0)
+	, m_pendingWork(false)
+	, m_sliceStart(0)
+	, m_sliceInput(nullptr)
+	, m_sliceInputRevision(0)
+	, m_sliceResumeIndex(0)
 {
 }
 
@@ -97,6 +103,67 @@ bool PausableFilter::PerformAction(const string& id)
 	return false;
 }
 
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Time-sliced execution
+
+///@brief Marks the start of a work quantum; call at the top of a resumable Refresh()
+void PausableFilter::BeginSlice()
+{
+	m_sliceStart = GetTime();
+}
+
+/**
+	@brief Checks if the current slice has used up its quantum
+
+	Calling GetTime() per sample would dominate a tight decode loop, so check this every few tens of thousands
+	of samples instead.
+ */
+bool PausableFilter::SliceExpired()
+{
+	if(m_workQuantum <= 0)
+		return false;
+	return (GetTime() - m_sliceStart) * 1000 > m_workQuantum;
+}
+
+/**
+	@brief Retrieves the saved resume position, if the previous slice's work is still valid
+
+	@return True if resuming (index set to the saved position), false if starting fresh (index untouched).
+			A resume cursor is only honored if the input is the same waveform object at the same revision we
+			yielded on; anything else means the data changed and the decode must restart.
+ */
+bool PausableFilter::ResumeSlice(WaveformBase* input, size_t& index)
+{
+	if(!m_pendingWork)
+		return false;
+
+	m_pendingWork = false;
+
+	if( (input != m_sliceInput) || !input || (input->m_revision != m_sliceInputRevision) )
+		return false;
+
+	index = m_sliceResumeIndex;
+	return true;
+}
+
+///@brief Saves the resume position and requests rescheduling next pass
+void PausableFilter::YieldSlice(WaveformBase* input, size_t nextIndex)
+{
+	m_sliceInput = input;
+	m_sliceInputRevision = input ? input->m_revision : 0;
+	m_sliceResumeIndex = nextIndex;
+	m_pendingWork = true;
+}
+
+///@brief Marks the decode as finished (no rescheduling needed)
+void PausableFilter::CompleteSlice()
+{
+	m_pendingWork = false;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Refresh eligibility
+
 bool PausableFilter::ShouldRefresh()
 {
 	//Running?
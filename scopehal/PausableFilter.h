@@ -38,7 +38,33 @@
 #include "ActionProvider.h"
 
 /**
-	@brief A filter which may be started and stopped
+	@brief A filter which may be started and stopped, and optionally executed in bounded time slices
+
+	Long decodes normally run monolithically inside one executor pass, blocking a worker thread (and anything
+	scheduled behind them) until done. A subclass can opt into time-sliced execution by setting a work quantum
+	and structuring its Refresh() as a resumable loop:
+
+	@code
+	BeginSlice();
+	size_t i = 0;
+	ResumeSlice(din, i);		//continue where the last slice stopped, if inputs are unchanged
+	for(; i<len; i++)
+	{
+		//...decode sample i, appending to the output...
+
+		if( ((i & 0xffff) == 0) && SliceExpired() )
+		{
+			YieldSlice(din, i);
+			return;
+		}
+	}
+	CompleteSlice();
+	@endcode
+
+	A filter that yields keeps its dirty flag (see FilterGraphExecutor::OnNodeComplete), so the next pass
+	reschedules it and the decode resumes from the saved position instead of restarting. Partial outputs must be
+	left coherent at every yield point, since downstream consumers re-run against them each pass. If the input
+	changes between slices, ResumeSlice() detects the stale cursor and the decode restarts from the beginning.
  */
 class PausableFilter
 	: public Filter
@@ -60,9 +86,46 @@ public:
 	void Single();
 	void Stop();
 
+	///@brief Sets the work quantum for time-sliced execution, in milliseconds (0 = run to completion)
+	void SetWorkQuantum(int64_t ms)
+	{ m_workQuantum = ms; }
+
+	///@brief Returns the work quantum, in milliseconds (0 = run to completion)
+	int64_t GetWorkQuantum()
+	{ return m_workQuantum; }
+
+	///@brief Returns true if the last Refresh() yielded with work remaining
+	bool HasPendingWork()
+	{ return m_pendingWork; }
+
+protected:
+	void BeginSlice();
+	bool SliceExpired();
+	bool ResumeSlice(WaveformBase* input, size_t& index);
+	void YieldSlice(WaveformBase* input, size_t nextIndex);
+	void CompleteSlice();
+
 protected:
 	bool m_running;
 	bool m_oneShot;
+
+	///@brief Work quantum for time-sliced execution, in milliseconds (0 = run to completion)
+	int64_t m_workQuantum;
+
+	///@brief True if the last Refresh() yielded before finishing
+	bool m_pendingWork;
+
+	///@brief Wall clock time the current slice started
+	double m_sliceStart;
+
+	///@brief Input the saved resume position refers to (not owned, only compared against)
+	WaveformBase* m_sliceInput;
+
+	///@brief Revision of m_sliceInput when we yielded, to detect stale cursors
+	uint64_t m_sliceInputRevision;
+
+	///@brief Position to resume decoding from
+	size_t m_sliceResumeIndex;
 };
 
 #endif
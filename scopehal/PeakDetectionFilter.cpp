@@ -44,6 +44,122 @@ PeakDetector::~PeakDetector()
 {
 }
 
+/**
+	@brief GPU implementation of FindPeaks() for uniformly sampled waveforms
+
+	First pass finds local-maximum candidates (same window test as the CPU search) and compacts them into a short
+	index list, while also reducing the per-workgroup minimum of the waveform. Second pass refines each candidate's
+	position by weighted averaging and walks outward to measure FWHM. Only the candidate list and refinement records
+	(a few kB) ever come back to the host, so the waveform itself can stay GPU resident.
+ */
+void PeakDetector::FindPeaksGpu(
+	UniformAnalogWaveform* cap,
+	int64_t max_peaks,
+	float search_hz,
+	vk::raii::CommandBuffer& cmdBuf,
+	shared_ptr<QueueHandle> queue)
+{
+	size_t nouts = cap->size();
+	if( (max_peaks == 0) || (nouts < 2) )
+	{
+		m_peaks.clear();
+		return;
+	}
+
+	//Get peak search width in bins
+	//(bins are equal size since the input is uniformly sampled)
+	int64_t binsize = cap->m_timescale;
+	int64_t search_bins = ceil(search_hz / binsize);
+	int64_t search_rad = search_bins/2;
+	search_rad = std::max(search_rad, (int64_t)1);
+
+	const size_t minpeak = 10;		//Skip this many bins at left to avoid false positives on the DC peak
+	const uint32_t maxCandidates = 32768;
+
+	if(!m_candidatePipeline)
+	{
+		m_candidatePipeline = make_unique<ComputePipeline>(
+			"shaders/PeakDetectionCandidates.spv", 3, sizeof(PeakCandidateShaderArgs));
+		m_refinePipeline = make_unique<ComputePipeline>(
+			"shaders/PeakDetectionRefine.spv", 3, sizeof(PeakRefineShaderArgs));
+	}
+
+	//Reset the candidate counter
+	m_peakCandidateBuf.resize(maxCandidates + 1);
+	m_peakCandidateBuf.PrepareForCpuAccess();
+	m_peakCandidateBuf[0] = 0;
+	m_peakCandidateBuf.MarkModifiedFromCpu();
+
+	size_t nblocks = GetComputeBlockCount(nouts, 64);
+	m_blockMinBuf.resize(nblocks);
+
+	//First pass: local-max candidates plus per-workgroup minima
+	cmdBuf.begin({});
+	m_candidatePipeline->BindBufferNonblocking(0, cap->m_samples, cmdBuf);
+	m_candidatePipeline->BindBufferNonblocking(1, m_peakCandidateBuf, cmdBuf);
+	m_candidatePipeline->BindBufferNonblocking(2, m_blockMinBuf, cmdBuf, true);
+
+	PeakCandidateShaderArgs cargs;
+	cargs.size = nouts;
+	cargs.searchRad = search_rad;
+	cargs.minIdx = minpeak;
+	cargs.maxCandidates = maxCandidates;
+	m_candidatePipeline->Dispatch(cmdBuf, cargs, nblocks);
+
+	cmdBuf.end();
+	queue->SubmitAndBlock(cmdBuf);
+	m_peakCandidateBuf.MarkModifiedFromGpu();
+	m_blockMinBuf.MarkModifiedFromGpu();
+
+	//See how many candidates we found, and finish the min reduction on the host
+	m_peakCandidateBuf.PrepareForCpuAccess();
+	m_blockMinBuf.PrepareForCpuAccess();
+	size_t ncand = min((size_t)m_peakCandidateBuf[0], (size_t)maxCandidates);
+	if(ncand == 0)
+	{
+		m_peaks.clear();
+		return;
+	}
+	float baseline = FLT_MAX;
+	for(size_t i=0; i<nblocks; i++)
+		baseline = min(baseline, m_blockMinBuf[i]);
+
+	//Second pass: fine tune each candidate's position and measure FWHM
+	m_peakRefinementBuf.resize(ncand);
+	cmdBuf.begin({});
+	m_refinePipeline->BindBufferNonblocking(0, cap->m_samples, cmdBuf);
+	m_refinePipeline->BindBufferNonblocking(1, m_peakCandidateBuf, cmdBuf);
+	m_refinePipeline->BindBufferNonblocking(2, m_peakRefinementBuf, cmdBuf, true);
+
+	PeakRefineShaderArgs rargs;
+	rargs.size = nouts;
+	rargs.numCandidates = ncand;
+	rargs.fineRad = 10;
+	rargs.baseline = baseline;
+	m_refinePipeline->Dispatch(cmdBuf, rargs, GetComputeBlockCount(ncand, 64));
+
+	cmdBuf.end();
+	queue->SubmitAndBlock(cmdBuf);
+	m_peakRefinementBuf.MarkModifiedFromGpu();
+	m_peakRefinementBuf.PrepareForCpuAccess();
+
+	//Convert the refinement records to Peak objects
+	vector<Peak> peaks;
+	for(size_t n=0; n<ncand; n++)
+	{
+		auto& r = m_peakRefinementBuf[n];
+		int64_t peak_location = round(r.idx + r.num / r.den);
+		float fwhm = GetOffsetScaled(cap, r.hmright) - GetOffsetScaled(cap, r.hmleft);
+		peaks.push_back(Peak(peak_location, r.y, fwhm));
+	}
+
+	//Sort the peak table and pluck out the requested count
+	std::sort(peaks.rbegin(), peaks.rend(), std::less<Peak>());
+	m_peaks.clear();
+	for(size_t i=0; i<(size_t)max_peaks && i<peaks.size(); i++)
+		m_peaks.push_back(peaks[i]);
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Construction / destruction
 
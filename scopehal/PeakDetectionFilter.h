@@ -52,6 +52,35 @@ public:
 	float m_fwhm;
 };
 
+///@brief Push constants for the candidate-search shader
+struct PeakCandidateShaderArgs
+{
+	uint32_t size;
+	uint32_t searchRad;
+	uint32_t minIdx;
+	uint32_t maxCandidates;
+};
+
+///@brief Push constants for the refinement shader
+struct PeakRefineShaderArgs
+{
+	uint32_t size;
+	uint32_t numCandidates;
+	uint32_t fineRad;
+	float baseline;
+};
+
+///@brief Readback record for one GPU-refined peak candidate (must match PeakDetectionRefine.glsl)
+struct PeakRefinementResult
+{
+	uint32_t idx;
+	float y;
+	float num;
+	float den;
+	uint32_t hmleft;
+	uint32_t hmright;
+};
+
 class PeakDetector
 {
 public:
@@ -61,6 +90,13 @@ public:
 	const std::vector<Peak>& GetPeaks()
 	{ return m_peaks; }
 
+	void FindPeaksGpu(
+		UniformAnalogWaveform* cap,
+		int64_t max_peaks,
+		float search_hz,
+		vk::raii::CommandBuffer& cmdBuf,
+		std::shared_ptr<QueueHandle> queue);
+
 	template<class T>
 	__attribute__((noinline))
 	void FindPeaks(T* cap, int64_t max_peaks, float search_hz)
@@ -173,6 +209,13 @@ public:
 
 protected:
 	std::vector<Peak> m_peaks;
+
+	//GPU peak search state (lazily created the first time FindPeaksGpu() is called)
+	std::unique_ptr<ComputePipeline> m_candidatePipeline;
+	std::unique_ptr<ComputePipeline> m_refinePipeline;
+	AcceleratorBuffer<uint32_t> m_peakCandidateBuf;
+	AcceleratorBuffer<float> m_blockMinBuf;
+	AcceleratorBuffer<PeakRefinementResult> m_peakRefinementBuf;
 };
 
 /**
@@ -197,6 +240,27 @@ protected:
 			m_parameters[m_peakwindowname].GetFloatVal());
 	}
 
+	/**
+		@brief Runs the peak search on the GPU if filter acceleration is enabled, falling back to the CPU otherwise
+
+		Intended to be called at the end of a filter's Refresh() while the output waveform is still GPU resident,
+		so the search runs against the buffer the preceding compute passes just wrote.
+	 */
+	void FindPeaks(UniformAnalogWaveform* cap, vk::raii::CommandBuffer& cmdBuf, std::shared_ptr<QueueHandle> queue)
+	{
+		if(g_gpuFilterEnabled)
+		{
+			FindPeaksGpu(
+				cap,
+				m_parameters[m_numpeaksname].GetIntVal(),
+				m_parameters[m_peakwindowname].GetFloatVal(),
+				cmdBuf,
+				queue);
+		}
+		else
+			FindPeaks(cap);
+	}
+
 	std::string m_numpeaksname;
 	std::string m_peakwindowname;
 };
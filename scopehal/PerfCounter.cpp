@@ -0,0 +1,149 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Implementation of PerfCounter, PerfHistogram, and PerfCounterRegistry
+ */
+
+#include "scopehal.h"
+
+using namespace std;
+
+//The registry must be constructed before (and destroyed after) any global counters defined below it
+PerfCounterRegistry g_perfCounters;
+
+PerfHistogram g_perfFilterPassLatency("filter.pass_latency", "us");
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// PerfCounter
+
+PerfCounter::PerfCounter(const string& name, const string& unit)
+	: m_value(0)
+	, m_name(name)
+	, m_unit(unit)
+{
+	g_perfCounters.Register(this);
+}
+
+PerfCounter::~PerfCounter()
+{
+	g_perfCounters.Unregister(this);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// PerfHistogram
+
+PerfHistogram::PerfHistogram(const string& name, const string& unit)
+	: m_sum(0)
+	, m_name(name)
+	, m_unit(unit)
+{
+	for(size_t i=0; i<PERF_HISTOGRAM_BUCKETS; i++)
+		m_buckets[i] = 0;
+
+	g_perfCounters.Register(this);
+}
+
+PerfHistogram::~PerfHistogram()
+{
+	g_perfCounters.Unregister(this);
+}
+
+uint64_t PerfHistogram::GetCount() const
+{
+	uint64_t total = 0;
+	for(size_t i=0; i<PERF_HISTOGRAM_BUCKETS; i++)
+		total += GetBucket(i);
+	return total;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// PerfCounterRegistry
+
+void PerfCounterRegistry::Register(PerfCounter* counter)
+{
+	lock_guard<mutex> lock(m_mutex);
+	m_counters.emplace(counter);
+}
+
+void PerfCounterRegistry::Unregister(PerfCounter* counter)
+{
+	lock_guard<mutex> lock(m_mutex);
+	m_counters.erase(counter);
+}
+
+void PerfCounterRegistry::Register(PerfHistogram* histogram)
+{
+	lock_guard<mutex> lock(m_mutex);
+	m_histograms.emplace(histogram);
+}
+
+void PerfCounterRegistry::Unregister(PerfHistogram* histogram)
+{
+	lock_guard<mutex> lock(m_mutex);
+	m_histograms.erase(histogram);
+}
+
+PerfCounter& PerfCounterRegistry::GetCounter(const string& name, const string& unit)
+{
+	//Do the lookup under our own lock, but construct outside the set so Register()'s lock (taken by the
+	//PerfCounter constructor) doesn't deadlock against us
+	{
+		lock_guard<mutex> lock(m_mutex);
+		auto it = m_ownedCounters.find(name);
+		if(it != m_ownedCounters.end())
+			return *it->second;
+	}
+
+	auto counter = make_unique<PerfCounter>(name, unit);
+
+	lock_guard<mutex> lock(m_mutex);
+	auto& slot = m_ownedCounters[name];
+
+	//Lost a race with another thread creating the same counter? Use theirs
+	if(!slot)
+		slot = std::move(counter);
+	return *slot;
+}
+
+void PerfCounterRegistry::EnumCounters(function<void(const PerfCounter&)> callback)
+{
+	lock_guard<mutex> lock(m_mutex);
+	for(auto c : m_counters)
+		callback(*c);
+}
+
+void PerfCounterRegistry::EnumHistograms(function<void(const PerfHistogram&)> callback)
+{
+	lock_guard<mutex> lock(m_mutex);
+	for(auto h : m_histograms)
+		callback(*h);
+}
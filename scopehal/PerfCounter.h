@@ -0,0 +1,173 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Declaration of PerfCounter, PerfHistogram, and PerfCounterRegistry
+ */
+#ifndef PerfCounter_h
+#define PerfCounter_h
+
+#include <atomic>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+
+/**
+	@brief A lightweight always-on performance counter
+
+	Updates are a single relaxed atomic add, so counters can live on hot paths and cost essentially nothing when
+	nobody is reading them. Counters register themselves with the global registry at construction so a telemetry
+	exporter can discover and scrape them without any per-counter wiring.
+ */
+class PerfCounter
+{
+public:
+	PerfCounter(const std::string& name, const std::string& unit = "");
+	~PerfCounter();
+
+	///@brief Adds to the counter (safe to call from any thread)
+	void Add(uint64_t n)
+	{ m_value.fetch_add(n, std::memory_order_relaxed); }
+
+	///@brief Increments the counter by one
+	void Increment()
+	{ Add(1); }
+
+	///@brief Returns the current value
+	uint64_t GetValue() const
+	{ return m_value.load(std::memory_order_relaxed); }
+
+	const std::string& GetName() const
+	{ return m_name; }
+
+	const std::string& GetUnit() const
+	{ return m_unit; }
+
+protected:
+	std::atomic<uint64_t> m_value;
+	std::string m_name;
+	std::string m_unit;
+};
+
+///@brief Number of buckets in a PerfHistogram (bucket i counts values above 2^(i-1) up to and including 2^i)
+#define PERF_HISTOGRAM_BUCKETS 40
+
+/**
+	@brief A log2-bucketed histogram for latency style metrics
+
+	Recording a sample is a handful of instructions plus one relaxed atomic add. Bucket upper bounds are
+	successive powers of two in whatever unit the caller records in; cumulative bucket counts map directly onto
+	Prometheus histogram semantics.
+ */
+class PerfHistogram
+{
+public:
+	PerfHistogram(const std::string& name, const std::string& unit = "");
+	~PerfHistogram();
+
+	///@brief Records one sample (safe to call from any thread)
+	void Record(uint64_t value)
+	{
+		size_t bucket = 64 - __builtin_clzll(value | 1);
+		if(bucket >= PERF_HISTOGRAM_BUCKETS)
+			bucket = PERF_HISTOGRAM_BUCKETS - 1;
+		m_buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+		m_sum.fetch_add(value, std::memory_order_relaxed);
+	}
+
+	///@brief Returns the count in a single bucket
+	uint64_t GetBucket(size_t i) const
+	{ return m_buckets[i].load(std::memory_order_relaxed); }
+
+	///@brief Returns the inclusive upper bound of a bucket
+	static uint64_t GetBucketUpperBound(size_t i)
+	{ return 1UL << i; }
+
+	///@brief Returns the total number of recorded samples
+	uint64_t GetCount() const;
+
+	///@brief Returns the sum of all recorded samples
+	uint64_t GetSum() const
+	{ return m_sum.load(std::memory_order_relaxed); }
+
+	const std::string& GetName() const
+	{ return m_name; }
+
+	const std::string& GetUnit() const
+	{ return m_unit; }
+
+protected:
+	std::atomic<uint64_t> m_buckets[PERF_HISTOGRAM_BUCKETS];
+	std::atomic<uint64_t> m_sum;
+	std::string m_name;
+	std::string m_unit;
+};
+
+/**
+	@brief Global registry of performance counters with a pull API for telemetry exporters
+
+	Counters and histograms register at construction and unregister at destruction. Dynamically named counters
+	(per instrument, per filter class) are created on demand with GetCounter() and owned by the registry; callers
+	should cache the returned reference rather than looking it up on every update.
+ */
+class PerfCounterRegistry
+{
+public:
+	void Register(PerfCounter* counter);
+	void Unregister(PerfCounter* counter);
+	void Register(PerfHistogram* histogram);
+	void Unregister(PerfHistogram* histogram);
+
+	///@brief Returns the counter with the given name, creating it if it doesn't exist yet
+	PerfCounter& GetCounter(const std::string& name, const std::string& unit = "");
+
+	//Pull API: iterate all registered counters / histograms under the registry lock
+	void EnumCounters(std::function<void(const PerfCounter&)> callback);
+	void EnumHistograms(std::function<void(const PerfHistogram&)> callback);
+
+protected:
+	std::mutex m_mutex;
+	std::set<PerfCounter*> m_counters;
+	std::set<PerfHistogram*> m_histograms;
+
+	///@brief Storage for counters created via GetCounter()
+	std::map<std::string, std::unique_ptr<PerfCounter>> m_ownedCounters;
+};
+
+extern PerfCounterRegistry g_perfCounters;
+
+///@brief Wall-clock latency of each completed filter graph pass, in microseconds
+extern PerfHistogram g_perfFilterPassLatency;
+
+#endif
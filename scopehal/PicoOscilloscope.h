@@ -226,10 +226,7 @@ protected:
 	std::vector<std::unique_ptr<AcceleratorBuffer<int16_t> > > m_analogRawWaveformBuffers;
 
 	//Vulkan waveform conversion
-	std::shared_ptr<QueueHandle> m_queue;
-	std::unique_ptr<vk::raii::CommandPool> m_pool;
-	std::unique_ptr<vk::raii::CommandBuffer> m_cmdBuf;
-	std::unique_ptr<ComputePipeline> m_conversionPipeline;
+	std::unique_ptr<RawSampleConverter> m_sampleConverter;
 
 public:
 
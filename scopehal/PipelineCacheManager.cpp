@@ -38,6 +38,9 @@
 #include <shlobj.h>
 #else
 #include <sys/stat.h>
+#include <sys/file.h>
+#include <fcntl.h>
+#include <unistd.h>
 #include <wordexp.h>
 #endif
 
@@ -45,6 +48,70 @@ using namespace std;
 
 unique_ptr<PipelineCacheManager> g_pipelineCacheMgr;
 
+/**
+	@brief Takes an advisory lock on the cache directory so concurrent processes don't read half-written files
+
+	Returns a file descriptor to pass to UnlockCacheDir(), or -1 if locking is unavailable.
+
+	Windows builds do not lock; sharing one cache directory between processes is only supported elsewhere.
+ */
+static int LockCacheDir(const string& cacheRootDir, bool exclusive)
+{
+#ifndef _WIN32
+	int fd = open((cacheRootDir + "cache.lock").c_str(), O_RDWR | O_CREAT, 0644);
+	if(fd < 0)
+		return -1;
+	if(0 != flock(fd, exclusive ? LOCK_EX : LOCK_SH))
+	{
+		close(fd);
+		return -1;
+	}
+	return fd;
+#else
+	(void)cacheRootDir;
+	(void)exclusive;
+	return -1;
+#endif
+}
+
+///@brief Releases a lock taken by LockCacheDir()
+static void UnlockCacheDir(int fd)
+{
+#ifndef _WIN32
+	if(fd >= 0)
+	{
+		flock(fd, LOCK_UN);
+		close(fd);
+	}
+#else
+	(void)fd;
+#endif
+}
+
+/**
+	@brief Computes the device hash appended to cache file names
+
+	Hashing the GPU UUID, driver version, and vkFFT version into the name makes entries content addressed per
+	device, so several GPUs (or driver versions) sharing one cache directory never clobber each other's files.
+ */
+static string MakeDeviceSuffix()
+{
+	vector<uint8_t> idblock;
+	idblock.insert(idblock.end(), g_vkComputeDeviceUuid, g_vkComputeDeviceUuid + 16);
+
+	uint32_t driver = g_vkComputeDeviceDriverVer;
+	auto p = reinterpret_cast<const uint8_t*>(&driver);
+	idblock.insert(idblock.end(), p, p + sizeof(driver));
+
+	int32_t vkfft = VkFFTGetVersion();
+	p = reinterpret_cast<const uint8_t*>(&vkfft);
+	idblock.insert(idblock.end(), p, p + sizeof(vkfft));
+
+	char tmp[16];
+	snprintf(tmp, sizeof(tmp), "%08x", CRC32(idblock));
+	return tmp;
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Construction / destruction
 
@@ -54,6 +121,7 @@ unique_ptr<PipelineCacheManager> g_pipelineCacheMgr;
 PipelineCacheManager::PipelineCacheManager()
 {
 	FindPath();
+	m_deviceSuffix = MakeDeviceSuffix();
 	LoadFromDisk();
 }
 
@@ -68,6 +136,28 @@ PipelineCacheManager::~PipelineCacheManager()
 
 void PipelineCacheManager::FindPath()
 {
+	//Environment override so a fleet of processes (possibly running as different users) can share one cache
+	auto sharedDir = getenv("SCOPEHAL_CACHE_DIR");
+	if( (sharedDir != nullptr) && (sharedDir[0] != '\0') )
+	{
+		m_cacheRootDir = sharedDir;
+
+#ifdef _WIN32
+		if(!CreateDirectoryA(m_cacheRootDir.c_str(), NULL) && (GetLastError() != ERROR_ALREADY_EXISTS) )
+			throw runtime_error("failed to create cache directory");
+		if(m_cacheRootDir.back() != '\\')
+			m_cacheRootDir += "\\";
+#else
+		CreateDirectory(m_cacheRootDir);
+		m_cacheRootDir = ExpandPath(m_cacheRootDir);
+		if(m_cacheRootDir.back() != '/')
+			m_cacheRootDir += "/";
+#endif
+
+		LogTrace("Cache root directory is %s (shared)\n", m_cacheRootDir.c_str());
+		return;
+	}
+
 #ifdef _WIN32
 	wchar_t* stem;
 	if(S_OK != SHGetKnownFolderPath(
@@ -207,6 +297,9 @@ void PipelineCacheManager::LoadFromDisk()
 	string shaderPrefix = "pipeline_";
 	string shaderSuffix = ".bin";
 
+	//Don't look at files while another process is in the middle of publishing them
+	int lockfd = LockCacheDir(m_cacheRootDir, false);
+
 	//Load raw binary blobs (mostly for vkFFT)
 	auto prefix = m_cacheRootDir + "shader_";
 	auto files = Glob(prefix + "*", false);
@@ -215,6 +308,12 @@ void PipelineCacheManager::LoadFromDisk()
 		if(f.find(prefix) == string::npos)
 			f = m_cacheRootDir + f;
 
+		//Skip in-progress temporaries left by a concurrent (or crashed) writer
+		if(f.length() < shaderSuffix.length())
+			continue;
+		if(f.compare(f.length() - shaderSuffix.length(), shaderSuffix.length(), shaderSuffix) != 0)
+			continue;
+
 		//Extract the key from the file name
 		auto key = f.substr(prefix.length());
 		key = key.substr(0, key.length() - shaderSuffix.length());
@@ -224,12 +323,54 @@ void PipelineCacheManager::LoadFromDisk()
 		else
 			key = key.substr(shaderPrefix.length());
 
-		//Read the header and make sure it checks out
+		//Strip the device hash from the key. If the hash is for a different device, don't even open the file
+		//(in a shared directory most entries may belong to other GPUs). Legacy file names without a hash are
+		//still considered; the header checks below weed out any that don't match us.
+		auto devSuffix = string("_") + m_deviceSuffix;
+		if( (key.length() > devSuffix.length()) &&
+			(key.compare(key.length() - devSuffix.length(), devSuffix.length(), devSuffix) == 0) )
+		{
+			key = key.substr(0, key.length() - devSuffix.length());
+		}
+		else if(key.length() > 9)
+		{
+			auto tail = key.substr(key.length() - 9);
+			if( (tail[0] == '_') && (tail.find_first_not_of("0123456789abcdef", 1) == string::npos) )
+			{
+				LogTrace("Skipping cache file (%s) belonging to another device\n", f.c_str());
+				continue;
+			}
+		}
+
+		//Map (or on Windows, read) the file content.
+		//Mapping means the blob is handed to the driver straight out of the page cache, and hot pages are
+		//shared between every process using the same cache directory.
+		const uint8_t* payload = nullptr;
+#ifndef _WIN32
+		MappedFileView view(f);
+		if( view.IsValid() && (view.m_len >= sizeof(header)) )
+		{
+			memcpy(&header, view.m_data, sizeof(header));
+			if( (view.m_len - sizeof(header)) >= header.len )
+				payload = reinterpret_cast<const uint8_t*>(view.m_data) + sizeof(header);
+		}
+#else
+		vector<uint8_t> fdata;
 		FILE* fp = fopen(f.c_str(), "rb");
-		if(1 != fread(&header, sizeof(header), 1, fp))
+		if(fp != nullptr)
 		{
-			LogWarning("Read cache header failed (%s)\n", f.c_str());
+			if(1 == fread(&header, sizeof(header), 1, fp))
+			{
+				fdata.resize(header.len);
+				if( (header.len == 0) || (header.len == fread(&fdata[0], 1, header.len, fp)) )
+					payload = fdata.empty() ? reinterpret_cast<const uint8_t*>(&header) : &fdata[0];
+			}
 			fclose(fp);
+		}
+#endif
+		if(payload == nullptr)
+		{
+			LogWarning("Read cache file failed (%s)\n", f.c_str());
 			continue;
 		}
 
@@ -239,52 +380,41 @@ void PipelineCacheManager::LoadFromDisk()
 		if(0 != memcmp(header.cache_uuid, g_vkComputeDeviceUuid, 16))
 		{
 			LogTrace("Rejecting cache file (%s) due to mismatching UUID\n", f.c_str());
-			fclose(fp);
 			continue;
 		}
 		if(header.vkfft_ver != vkfft_expected)
 		{
 			LogTrace("Rejecting cache file (%s) due to mismatching vkFFT version\n", f.c_str());
-			fclose(fp);
 			continue;
 		}
 		if(header.driver_ver != g_vkComputeDeviceDriverVer)
 		{
 			LogTrace("Rejecting cache file (%s) due to mismatching driver version\n", f.c_str());
-			fclose(fp);
-			continue;
-		}
-
-		//All good. Read the file content
-		auto p = make_shared< vector<uint8_t> >();
-		p->resize(header.len);
-		if(header.len != fread(&((*p)[0]), 1, header.len, fp))
-		{
-			LogWarning("Read cache content failed (%s)\n", f.c_str());
-			fclose(fp);
 			continue;
 		}
-		fclose(fp);
 
 		//Verify the CRC
-		if(header.crc != CRC32(*p))
+		if( (header.len != 0) && (header.crc != CRC32(payload, 0, header.len - 1)) )
 		{
 			LogWarning("Rejecting cache file (%s) due to bad CRC\n", f.c_str());
 			continue;
 		}
 
-		//Done, add to cache if we get this far
+		//Done, add to cache if we get this far.
+		//Raw blobs are handed out by pointer so they need a copy we own; pipeline blobs go straight to the
+		//driver, which copies during creation.
 		if(typeIsRaw)
-			m_rawDataCache[key] = p;
+			m_rawDataCache[key] = make_shared< vector<uint8_t> >(payload, payload + header.len);
 		else
 		{
-			vector<uint8_t>& vec = *p;
-			vk::PipelineCacheCreateInfo info({}, vec.size(), &vec[0]);
+			vk::PipelineCacheCreateInfo info({}, header.len, payload);
 			auto ret = make_shared<vk::raii::PipelineCache>(*g_vkComputeDevice, info);
 			m_vkCache[key] = ret;
 			m_vkCacheTimestamps[key] = header.file_mtime;
 		}
 	}
+
+	UnlockCacheDir(lockfd);
 }
 
 /**
@@ -302,14 +432,24 @@ void PipelineCacheManager::SaveToDisk()
 	header.driver_ver = g_vkComputeDeviceDriverVer;
 	header.vkfft_ver = VkFFTGetVersion();
 
+	//Keep other processes out while we publish, and write each file to a temporary name followed by an
+	//atomic rename so a reader never observes a half-written blob even if we crash partway through.
+	int lockfd = LockCacheDir(m_cacheRootDir, true);
+
 	//Save raw data
 	for(auto it : m_rawDataCache)
 	{
 		auto key = it.first;
 		auto& vec = *it.second;
-		auto fname = m_cacheRootDir + "shader_raw_" + key + ".bin";
+		auto fname = m_cacheRootDir + "shader_raw_" + key + "_" + m_deviceSuffix + ".bin";
+		auto tmpname = fname + ".tmp";
 		LogTrace("Saving shader %s (%zu bytes)\n", fname.c_str(), vec.size());
-		FILE* fp = fopen(fname.c_str(), "wb");
+		FILE* fp = fopen(tmpname.c_str(), "wb");
+		if(fp == nullptr)
+		{
+			LogWarning("Open cache file failed (%s)\n", tmpname.c_str());
+			continue;
+		}
 
 		//Write the cache header
 		header.len = vec.size();
@@ -317,16 +457,27 @@ void PipelineCacheManager::SaveToDisk()
 		header.file_mtime = 0;	//not used
 		if(1 != fwrite(&header, sizeof(header), 1, fp))
 		{
-			LogWarning("Write cache header failed (%s)\n", fname.c_str());
+			LogWarning("Write cache header failed (%s)\n", tmpname.c_str());
 			fclose(fp);
 			continue;
 		}
 
 		//Write the data
 		if(header.len != fwrite(&vec[0], 1, header.len, fp))
-			LogWarning("Write cache data failed (%s)\n", fname.c_str());
+		{
+			LogWarning("Write cache data failed (%s)\n", tmpname.c_str());
+			fclose(fp);
+			continue;
+		}
 
 		fclose(fp);
+
+		//Publish the completed file
+#ifdef _WIN32
+		remove(fname.c_str());
+#endif
+		if(0 != rename(tmpname.c_str(), fname.c_str()))
+			LogWarning("Rename cache file failed (%s)\n", fname.c_str());
 	}
 
 	//Save Vulkan shader cache
@@ -334,13 +485,19 @@ void PipelineCacheManager::SaveToDisk()
 	{
 		auto key = it.first;
 		auto pcache = it.second;
-		auto fname = m_cacheRootDir + "shader_pipeline_" + key + ".bin";
+		auto fname = m_cacheRootDir + "shader_pipeline_" + key + "_" + m_deviceSuffix + ".bin";
+		auto tmpname = fname + ".tmp";
 
 		//Extract the raw shader content
 		auto vec = pcache->getData();
 		LogTrace("Saving shader %s (%zu bytes)\n", fname.c_str(), vec.size());
 
-		FILE* fp = fopen(fname.c_str(), "wb");
+		FILE* fp = fopen(tmpname.c_str(), "wb");
+		if(fp == nullptr)
+		{
+			LogWarning("Open cache file failed (%s)\n", tmpname.c_str());
+			continue;
+		}
 
 		//Write the cache header
 		header.len = vec.size();
@@ -348,15 +505,28 @@ void PipelineCacheManager::SaveToDisk()
 		header.file_mtime = m_vkCacheTimestamps[key];
 		if(1 != fwrite(&header, sizeof(header), 1, fp))
 		{
-			LogWarning("Write cache header failed (%s)\n", fname.c_str());
+			LogWarning("Write cache header failed (%s)\n", tmpname.c_str());
 			fclose(fp);
 			continue;
 		}
 
 		//Write the data
 		if(header.len != fwrite(&vec[0], 1, header.len, fp))
-			LogWarning("Write cache data failed (%s)\n", fname.c_str());
+		{
+			LogWarning("Write cache data failed (%s)\n", tmpname.c_str());
+			fclose(fp);
+			continue;
+		}
 
 		fclose(fp);
+
+		//Publish the completed file
+#ifdef _WIN32
+		remove(fname.c_str());
+#endif
+		if(0 != rename(tmpname.c_str(), fname.c_str()))
+			LogWarning("Rename cache file failed (%s)\n", fname.c_str());
 	}
+
+	UnlockCacheDir(lockfd);
 }
@@ -52,9 +52,21 @@ struct PipelineCacheFileHeader
 	@brief Helper for managing Vulkan / vkFFT pipeline cache objects
 
 	The cache is stored on disk under the .cache/glscopeclient directory on Linux, or FIXME on Windows.
+	Setting the SCOPEHAL_CACHE_DIR environment variable overrides the default location, allowing a fleet of
+	headless processes on one server to share a single cache directory so that only the first process to see a
+	given shader has to compile it.
 
-	Raw data: $cachedir/shader_raw_[key].bin
-	Vulkan shader data: $cachedir/shader_pipeline_[key].bin
+	Raw data: $cachedir/shader_raw_[key]_[device].bin
+	Vulkan shader data: $cachedir/shader_pipeline_[key]_[device].bin
+
+	The [device] component is a hash of the GPU UUID, driver version, and vkFFT version, so caches for several
+	GPUs or driver versions can coexist in a shared directory without overwriting each other. Legacy file names
+	without the device hash are still loaded (subject to the usual header validation) but are never written.
+
+	Concurrent access to a shared directory is interlocked with an advisory lock on $cachedir/cache.lock
+	(non-Windows only), and files are published atomically via a write-to-temporary-then-rename sequence. On
+	non-Windows platforms cache files are also mmapped rather than read, so SPIR-V and driver blob pages are
+	shared between every process on the host through the page cache.
  */
 class PipelineCacheManager
 {
@@ -88,6 +100,9 @@ protected:
 
 	///@brief Root directory of the cache
 	std::string m_cacheRootDir;
+
+	///@brief Hash of the GPU UUID / driver version / vkFFT version, appended to cache file names
+	std::string m_deviceSuffix;
 };
 
 extern std::unique_ptr<PipelineCacheManager> g_pipelineCacheMgr;
@@ -0,0 +1,249 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Implementation of PolyphaseResampler
+ */
+#include "scopehal.h"
+
+using namespace std;
+
+static float sinc(float x, float width)
+{
+	float xi = x - width/2;
+
+	if(fabs(xi) < 1e-7)
+		return 1.0f;
+	else
+	{
+		float px = M_PI*xi;
+		return sin(px) / px;
+	}
+}
+
+static float blackman(float x, float width)
+{
+	if(x > width)
+		return 0;
+	return 0.42 - 0.5*cos(2*M_PI * x / width) + 0.08 * cos(4*M_PI*x/width);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Construction / destruction
+
+PolyphaseResampler::PolyphaseResampler()
+	: m_interpolation(0)
+	, m_decimation(0)
+	, m_tapsPerPhase(0)
+	, m_center(0)
+	, m_window(0)
+	, m_computePipeline("shaders/PolyphaseResampler.spv", 3, sizeof(PolyphaseResamplerArgs))
+{
+	//Use pinned memory for the coefficient bank
+	m_coeffs.SetCpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
+	m_coeffs.SetGpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Configuration
+
+/**
+	@brief Configure as an interpolator: windowed-sinc prototype, decomposed into one sub-filter per output phase
+
+	Logically we upsample by inserting zeroes, then convolve with the sinc filter. The polyphase
+	decomposition gathers the taps that line up with nonzero samples for each output phase into a
+	contiguous row, so nothing is ever multiplied by zero.
+ */
+void PolyphaseResampler::ConfigureUpsample(size_t upsampleFactor, size_t window)
+{
+	//No-op if configuration unchanged, coefficients are already on the GPU
+	if( (m_interpolation == upsampleFactor) && (m_decimation == 1) && (m_window == window) )
+		return;
+
+	m_interpolation = upsampleFactor;
+	m_decimation = 1;
+	m_window = window;
+	m_center = 0;
+
+	//Create the prototype interpolation filter
+	size_t kernel = window * upsampleFactor;
+	float frac_kernel = kernel * 1.0f / upsampleFactor;
+	vector<float> proto;
+	proto.resize(kernel);
+	for(size_t i=0; i<kernel; i++)
+	{
+		float frac = i*1.0f / upsampleFactor;
+		proto[i] = sinc(frac, frac_kernel) * blackman(frac, frac_kernel);
+	}
+
+	//Decompose into sub-filters.
+	//Output sample i*factor + p is sum over m of proto[m*factor - p] * input[i + m],
+	//so phase p's row holds proto[m*factor - p] (zero padded at the row edge).
+	m_tapsPerPhase = window + 1;
+	m_coeffs.resize(upsampleFactor * m_tapsPerPhase);
+	m_coeffs.PrepareForCpuAccess();
+	for(size_t p=0; p<upsampleFactor; p++)
+	{
+		float* row = &m_coeffs[p * m_tapsPerPhase];
+		for(size_t m=0; m <= window; m++)
+		{
+			size_t k = m*upsampleFactor;
+			if( (k >= p) && (k - p < kernel) )
+				row[m] = proto[k - p];
+			else
+				row[m] = 0;
+		}
+	}
+	m_coeffs.MarkModifiedFromCpu();
+}
+
+/**
+	@brief Configure as a decimator: Gaussian antialiasing filter evaluated at the output rate
+
+	A pure decimator has a single phase, so the polyphase structure degenerates to one sub-filter
+	applied with a stride of decimationFactor through the input.
+ */
+void PolyphaseResampler::ConfigureDecimation(size_t decimationFactor)
+{
+	//No-op if configuration unchanged, coefficients are already on the GPU
+	if( (m_interpolation == 1) && (m_decimation == decimationFactor) )
+		return;
+
+	m_interpolation = 1;
+	m_decimation = decimationFactor;
+	m_window = 0;
+
+	//Cut off all frequencies shorter than our decimation factor
+	float cutoff_period = decimationFactor;
+	float sigma = cutoff_period / sqrt(2 * log(2));
+	int kernel_radius = ceil(3*sigma);
+	m_center = kernel_radius;
+
+	//Generate the actual Gaussian kernel
+	int kernel_size = kernel_radius*2 + 1;
+	m_tapsPerPhase = kernel_size;
+	m_coeffs.resize(kernel_size);
+	m_coeffs.PrepareForCpuAccess();
+	float alpha = 1.0f / (sigma * sqrt(2*M_PI));
+	for(int x=0; x < kernel_size; x++)
+	{
+		int delta = (x - kernel_radius);
+		m_coeffs[x] = alpha * exp(-delta*delta/(2*sigma));
+	}
+	float sum = 0;
+	for(int i=0; i<kernel_size; i++)
+		sum += m_coeffs[i];
+	for(int i=0; i<kernel_size; i++)
+		m_coeffs[i] /= sum;
+	m_coeffs.MarkModifiedFromCpu();
+}
+
+/**
+	@brief Returns the output length produced from a given input length
+ */
+size_t PolyphaseResampler::GetOutputLength(size_t inlen)
+{
+	if(m_interpolation > 1)
+	{
+		if(inlen < m_window)
+			return 0;
+		return (inlen - m_window) * m_interpolation;
+	}
+	return inlen / m_decimation;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Rate conversion
+
+/**
+	@brief Record the resampling dispatch into an already-open command buffer
+ */
+void PolyphaseResampler::Resample(
+	vk::raii::CommandBuffer& cmdBuf,
+	AcceleratorBuffer<float>& din,
+	AcceleratorBuffer<float>& dout,
+	size_t inlen,
+	size_t outlen)
+{
+	m_computePipeline.BindBufferNonblocking(0, din, cmdBuf);
+	m_computePipeline.BindBufferNonblocking(1, m_coeffs, cmdBuf);
+	m_computePipeline.BindBufferNonblocking(2, dout, cmdBuf, true);
+
+	PolyphaseResamplerArgs args;
+	args.outlen = outlen;
+	args.inlen = inlen;
+	args.interpolation = m_interpolation;
+	args.decimation = m_decimation;
+	args.tapsPerPhase = m_tapsPerPhase;
+	args.center = m_center;
+
+	m_computePipeline.Dispatch(cmdBuf, args, GetComputeBlockCount(outlen, 64));
+}
+
+/**
+	@brief Software fallback path
+ */
+void PolyphaseResampler::ResampleCpu(
+	AcceleratorBuffer<float>& din,
+	AcceleratorBuffer<float>& dout,
+	size_t inlen,
+	size_t outlen)
+{
+	din.PrepareForCpuAccess();
+	dout.PrepareForCpuAccess();
+
+	size_t interpolation = m_interpolation;
+	size_t decimation = m_decimation;
+	size_t taps = m_tapsPerPhase;
+	int64_t center = m_center;
+
+	#pragma omp parallel for
+	for(size_t n=0; n < outlen; n++)
+	{
+		size_t phase = n % interpolation;
+		int64_t base = (n / interpolation) * decimation - center;
+
+		const float* row = &m_coeffs[phase * taps];
+
+		float f = 0;
+		for(size_t t=0; t<taps; t++)
+		{
+			int64_t pos = base + t;
+			if( (pos < 0) || (pos >= (int64_t)inlen) )
+				continue;
+			f += row[t] * din[pos];
+		}
+
+		dout[n] = f;
+	}
+
+	dout.MarkModifiedFromCpu();
+}
@@ -0,0 +1,117 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Declaration of PolyphaseResampler
+ */
+#ifndef PolyphaseResampler_h
+#define PolyphaseResampler_h
+
+///@brief Push constants for the polyphase resampler shader
+struct PolyphaseResamplerArgs
+{
+	uint32_t outlen;
+	uint32_t inlen;
+	uint32_t interpolation;
+	uint32_t decimation;
+	uint32_t tapsPerPhase;
+	int32_t center;
+};
+
+/**
+	@brief Rational rate converter using a polyphase FIR decomposition
+
+	The prototype filter is split into one sub-filter per output phase, stored contiguously, so each
+	output sample reads only the taps that line up with nonzero input samples rather than the full
+	zero-stuffed kernel.
+
+	Used by UpsampleFilter and DownsampleFilter, and available to drivers that need to rate convert
+	waveforms at import time. The coefficient set is cached, so reconfiguring with unchanged
+	parameters does not recompute or re-push anything.
+ */
+class PolyphaseResampler
+{
+public:
+	PolyphaseResampler();
+
+	void ConfigureUpsample(size_t upsampleFactor, size_t window = 5);
+	void ConfigureDecimation(size_t decimationFactor);
+
+	size_t GetOutputLength(size_t inlen);
+
+	void Resample(
+		vk::raii::CommandBuffer& cmdBuf,
+		AcceleratorBuffer<float>& din,
+		AcceleratorBuffer<float>& dout,
+		size_t inlen,
+		size_t outlen);
+
+	void ResampleCpu(
+		AcceleratorBuffer<float>& din,
+		AcceleratorBuffer<float>& dout,
+		size_t inlen,
+		size_t outlen);
+
+	///@brief Returns the polyphase coefficient bank, for kernels that fuse the FIR with other work
+	AcceleratorBuffer<float>& GetCoefficients()
+	{ return m_coeffs; }
+
+	///@brief Returns the length of each polyphase sub-filter
+	size_t GetTapsPerPhase()
+	{ return m_tapsPerPhase; }
+
+	///@brief Returns the offset of the filter center from the base input sample
+	int64_t GetCenter()
+	{ return m_center; }
+
+protected:
+	///@brief Upsampling factor (number of polyphase sub-filters)
+	size_t m_interpolation;
+
+	///@brief Decimation factor (stride through the input)
+	size_t m_decimation;
+
+	///@brief Length of each polyphase sub-filter
+	size_t m_tapsPerPhase;
+
+	///@brief Offset of the filter center from the base input sample
+	int64_t m_center;
+
+	///@brief Prototype filter length in input samples, for caching upsample configurations
+	size_t m_window;
+
+	///@brief Polyphase coefficient bank, phase-major (sub-filter for phase p starts at p*m_tapsPerPhase)
+	AcceleratorBuffer<float> m_coeffs;
+
+	ComputePipeline m_computePipeline;
+};
+
+#endif
@@ -0,0 +1,114 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Declaration of ProtocolStateTable
+ */
+
+#ifndef ProtocolStateTable_h
+#define ProtocolStateTable_h
+
+/**
+	@brief Compile-time generated transition table for a protocol decoder state machine.
+
+	Serial decoders typically walk their input as a chain of if/else blocks keyed on the current decode state and the
+	observed line activity. That structure is hard for the compiler to flatten and mispredicts badly on dense input.
+	This class lets a decoder describe the same machine as a list of (state, event) -> (next state, action) rules,
+	expanded at compile time into a dense 2D table so the hot loop becomes a single indexed load followed by a small
+	switch over the action code.
+
+	Usage:
+	* Define dense zero-based enums for the decoder's states, events, and actions
+	* List the transition rules as a constexpr array of Rule; any (state, event) cell not named by a rule self-loops
+	  with the supplied default (no-op) action
+	* In the sample loop, classify the line activity into an event, look up the table cell, dispatch on the action
+	  code, then advance to the cell's next state
+
+	The table only encodes control flow; data side effects (accumulating bits, emitting samples) stay in the decoder's
+	action handlers, which may override the next state for transitions that depend on runtime counters (e.g. "byte
+	complete after eight bits").
+ */
+template<typename state_t, typename event_t, typename action_t, size_t NSTATES, size_t NEVENTS>
+class ProtocolStateTable
+{
+public:
+
+	///@brief A single transition rule in the declarative description of the machine
+	struct Rule
+	{
+		state_t		from;
+		event_t		event;
+		state_t		to;
+		action_t	action;
+	};
+
+	///@brief A cell of the expanded table (kept to two bytes so the whole table stays cache resident)
+	struct Entry
+	{
+		uint8_t		next;
+		uint8_t		action;
+	};
+
+	/**
+		@brief Expands a rule list into the dense transition table
+
+		@param rules			Transition rules; later rules override earlier ones for the same (state, event) cell
+		@param defaultAction	Action assigned to cells not named by any rule (which self-loop)
+	 */
+	template<size_t NRULES>
+	constexpr ProtocolStateTable(const Rule (&rules)[NRULES], action_t defaultAction)
+		: m_entries()
+	{
+		for(size_t s = 0; s < NSTATES; s++)
+		{
+			for(size_t e = 0; e < NEVENTS; e++)
+			{
+				m_entries[s][e].next = static_cast<uint8_t>(s);
+				m_entries[s][e].action = static_cast<uint8_t>(defaultAction);
+			}
+		}
+
+		for(size_t i = 0; i < NRULES; i++)
+		{
+			m_entries[static_cast<size_t>(rules[i].from)][static_cast<size_t>(rules[i].event)] =
+				Entry{ static_cast<uint8_t>(rules[i].to), static_cast<uint8_t>(rules[i].action) };
+		}
+	}
+
+	///@brief Looks up the transition for the given state and event
+	constexpr const Entry& operator()(state_t state, event_t event) const
+	{ return m_entries[static_cast<size_t>(state)][static_cast<size_t>(event)]; }
+
+protected:
+	Entry m_entries[NSTATES][NEVENTS];
+};
+
+#endif
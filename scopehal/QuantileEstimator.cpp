@@ -0,0 +1,333 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Implementation of QuantileEstimator and QuantileSelector
+ */
+#include "scopehal.h"
+#include "QuantileEstimator.h"
+
+#include <algorithm>
+
+using namespace std;
+
+namespace
+{
+	///@brief Push constants for the QuantileHistogram shader
+	struct QuantileHistogramArgs
+	{
+		uint32_t size;
+		uint32_t keyshift;
+		uint32_t prefix;
+		uint32_t prefixMask;
+	};
+
+	///@brief Flips a float to a monotonically increasing unsigned key
+	uint32_t FloatToKey(float f)
+	{
+		uint32_t key;
+		memcpy(&key, &f, sizeof(key));
+		return (key & 0x80000000) ? ~key : (key | 0x80000000);
+	}
+
+	///@brief Inverse of FloatToKey
+	float KeyToFloat(uint32_t key)
+	{
+		uint32_t bits = (key & 0x80000000) ? (key & 0x7fffffff) : ~key;
+		float f;
+		memcpy(&f, &bits, sizeof(f));
+		return f;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// QuantileEstimator
+
+QuantileEstimator::QuantileEstimator(double quantile)
+	: m_quantile(quantile)
+{
+	Reset();
+}
+
+///@brief Discards all state and starts a fresh stream
+void QuantileEstimator::Reset()
+{
+	m_count = 0;
+
+	double p = m_quantile;
+	m_desired[0] = 1;
+	m_desired[1] = 1 + 2*p;
+	m_desired[2] = 1 + 4*p;
+	m_desired[3] = 3 + 2*p;
+	m_desired[4] = 5;
+
+	m_increments[0] = 0;
+	m_increments[1] = p / 2;
+	m_increments[2] = p;
+	m_increments[3] = (1 + p) / 2;
+	m_increments[4] = 1;
+
+	for(int i=0; i<5; i++)
+	{
+		m_heights[i] = 0;
+		m_positions[i] = i + 1;
+	}
+}
+
+///@brief Folds one sample into the running estimate
+void QuantileEstimator::AddSample(double v)
+{
+	//The first five samples just seed the markers
+	if(m_count < 5)
+	{
+		m_heights[m_count ++] = v;
+		if(m_count == 5)
+			sort(m_heights, m_heights + 5);
+		return;
+	}
+
+	//Find the cell the new sample falls in, growing the extremes if needed
+	int k;
+	if(v < m_heights[0])
+	{
+		m_heights[0] = v;
+		k = 0;
+	}
+	else if(v >= m_heights[4])
+	{
+		m_heights[4] = v;
+		k = 3;
+	}
+	else
+	{
+		for(k=0; k<3; k++)
+		{
+			if(v < m_heights[k+1])
+				break;
+		}
+	}
+
+	for(int i=k+1; i<5; i++)
+		m_positions[i] ++;
+	for(int i=0; i<5; i++)
+		m_desired[i] += m_increments[i];
+	m_count ++;
+
+	//Move interior markers toward their desired positions
+	for(int i=1; i<=3; i++)
+	{
+		double d = m_desired[i] - m_positions[i];
+		if(	( (d >= 1) && (m_positions[i+1] - m_positions[i] > 1) ) ||
+			( (d <= -1) && (m_positions[i-1] - m_positions[i] < -1) ) )
+		{
+			double ds = (d >= 0) ? 1 : -1;
+
+			//Parabolic height update
+			double qp = m_heights[i] + (ds / (m_positions[i+1] - m_positions[i-1])) * (
+				(m_positions[i] - m_positions[i-1] + ds) *
+					(m_heights[i+1] - m_heights[i]) / (m_positions[i+1] - m_positions[i]) +
+				(m_positions[i+1] - m_positions[i] - ds) *
+					(m_heights[i] - m_heights[i-1]) / (m_positions[i] - m_positions[i-1]) );
+
+			//Fall back to linear interpolation if the parabola leaves the bracket
+			if( (qp <= m_heights[i-1]) || (qp >= m_heights[i+1]) )
+			{
+				int j = i + (int)ds;
+				qp = m_heights[i] +
+					ds * (m_heights[j] - m_heights[i]) / (m_positions[j] - m_positions[i]);
+			}
+
+			m_heights[i] = qp;
+			m_positions[i] += ds;
+		}
+	}
+}
+
+///@brief Returns the current estimate of the tracked quantile
+double QuantileEstimator::GetValue()
+{
+	if(m_count == 0)
+		return 0;
+
+	if(m_count >= 5)
+		return m_heights[2];
+
+	//Too few samples for the markers to be initialized, answer exactly from the seed set
+	double tmp[5];
+	copy(m_heights, m_heights + m_count, tmp);
+	sort(tmp, tmp + m_count);
+	return tmp[ (size_t)round(m_quantile * (m_count - 1)) ];
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// QuantileSelector
+
+QuantileSelector::QuantileSelector()
+	: m_histogramPipeline("shaders/QuantileHistogram.spv", 2, sizeof(QuantileHistogramArgs))
+{
+	m_histogram.SetCpuAccessHint(AcceleratorBuffer<uint32_t>::HINT_LIKELY);
+	m_histogram.SetGpuAccessHint(AcceleratorBuffer<uint32_t>::HINT_LIKELY);
+}
+
+/**
+	@brief Returns the exact sample at the requested quantile of a buffer
+
+	The input is not modified or copied: four radix histogram passes narrow the candidate key range by 8 bits
+	each. Runs on the GPU where available (the sample data never leaves the device), CPU otherwise.
+ */
+float QuantileSelector::Select(
+	AcceleratorBuffer<float>& din,
+	size_t len,
+	double quantile,
+	vk::raii::CommandBuffer& cmdBuf,
+	shared_ptr<QueueHandle> queue)
+{
+	if(len == 0)
+		return 0;
+	quantile = min(max(quantile, 0.0), 1.0);
+	size_t rank = (size_t)round(quantile * (len - 1));
+
+	//Shaders index with 32 bit sample positions
+	if( !IsAvailable() || !g_gpuFilterEnabled || (len > 0xffffffff) )
+		return SelectCpu(din, len, rank);
+
+	m_histogram.resize(256);
+
+	uint32_t prefix = 0;
+	uint32_t prefixMask = 0;
+	size_t k = rank;
+	for(int pass=0; pass<4; pass++)
+	{
+		QuantileHistogramArgs args;
+		args.size = len;
+		args.keyshift = 24 - pass*8;
+		args.prefix = prefix;
+		args.prefixMask = prefixMask;
+
+		m_histogram.PrepareForCpuAccess();
+		for(int b=0; b<256; b++)
+			m_histogram[b] = 0;
+		m_histogram.MarkModifiedFromCpu();
+
+		cmdBuf.begin({});
+		m_histogramPipeline.BindBufferNonblocking(0, din, cmdBuf);
+		m_histogramPipeline.BindBufferNonblocking(1, m_histogram, cmdBuf, true);
+		m_histogramPipeline.Dispatch(cmdBuf, args, GetComputeBlockCount(len, 64));
+		cmdBuf.end();
+		queue->SubmitAndBlock(cmdBuf);
+		m_histogram.MarkModifiedFromGpu();
+
+		//Find the bin holding the k-th smallest remaining sample
+		m_histogram.PrepareForCpuAccess();
+		size_t cum = 0;
+		for(uint32_t b=0; b<256; b++)
+		{
+			size_t c = m_histogram[b];
+			if(k < cum + c)
+			{
+				k -= cum;
+				prefix |= b << args.keyshift;
+				prefixMask |= 0xffu << args.keyshift;
+				break;
+			}
+			cum += c;
+		}
+	}
+
+	return KeyToFloat(prefix);
+}
+
+/**
+	@brief CPU backend for Select()
+ */
+float QuantileSelector::SelectCpu(AcceleratorBuffer<float>& din, size_t len, size_t rank)
+{
+	din.PrepareForCpuAccess();
+	const float* p = din.GetCpuPointer();
+
+	uint32_t prefix = 0;
+	uint32_t prefixMask = 0;
+	size_t k = rank;
+	for(int pass=0; pass<4; pass++)
+	{
+		uint32_t keyshift = 24 - pass*8;
+		uint64_t hist[256] = {0};
+
+		//Big buffers get per-thread histograms merged at the end
+		if(len > 1000000)
+		{
+			#pragma omp parallel
+			{
+				uint64_t lhist[256] = {0};
+
+				#pragma omp for nowait
+				for(size_t i=0; i<len; i++)
+				{
+					uint32_t key = FloatToKey(p[i]);
+					if((key & prefixMask) == prefix)
+						lhist[(key >> keyshift) & 0xff] ++;
+				}
+
+				#pragma omp critical
+				{
+					for(int b=0; b<256; b++)
+						hist[b] += lhist[b];
+				}
+			}
+		}
+		else
+		{
+			for(size_t i=0; i<len; i++)
+			{
+				uint32_t key = FloatToKey(p[i]);
+				if((key & prefixMask) == prefix)
+					hist[(key >> keyshift) & 0xff] ++;
+			}
+		}
+
+		//Find the bin holding the k-th smallest remaining sample
+		size_t cum = 0;
+		for(uint32_t b=0; b<256; b++)
+		{
+			size_t c = hist[b];
+			if(k < cum + c)
+			{
+				k -= cum;
+				prefix |= b << keyshift;
+				prefixMask |= 0xffu << keyshift;
+				break;
+			}
+			cum += c;
+		}
+	}
+
+	return KeyToFloat(prefix);
+}
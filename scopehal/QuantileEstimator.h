@@ -0,0 +1,126 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Declaration of QuantileEstimator and QuantileSelector
+ */
+#ifndef QuantileEstimator_h
+#define QuantileEstimator_h
+
+/**
+	@brief Streaming approximate quantile estimator (the P-squared algorithm of Jain & Chlamtac)
+
+	Tracks a single quantile of a stream in O(1) memory by maintaining five markers whose heights are adjusted
+	with parabolic interpolation as samples arrive: no copy of the data, no sort. Accuracy is excellent for the
+	smooth, heavily oversampled distributions measurement filters see (base/top levels, interval statistics).
+
+	Feed samples with AddSample() and read the running estimate with GetValue() at any point; Reset() starts a
+	fresh stream. For an exact answer on data already in memory, use QuantileSelector instead.
+ */
+class QuantileEstimator
+{
+public:
+	QuantileEstimator(double quantile);
+
+	void Reset();
+	void AddSample(double v);
+	double GetValue();
+
+	///@brief Returns the number of samples seen so far
+	size_t GetCount() const
+	{ return m_count; }
+
+	///@brief Returns the quantile being estimated
+	double GetQuantile() const
+	{ return m_quantile; }
+
+protected:
+	///@brief Quantile to estimate, in [0, 1]
+	double m_quantile;
+
+	///@brief Number of samples seen so far
+	size_t m_count;
+
+	///@brief Marker heights (estimates of the quantiles at m_desired)
+	double m_heights[5];
+
+	///@brief Actual marker positions (number of samples at or below each marker)
+	double m_positions[5];
+
+	///@brief Desired marker positions
+	double m_desired[5];
+
+	///@brief Per-sample increments of the desired positions
+	double m_increments[5];
+};
+
+/**
+	@brief Exact k-th order statistic of a sample buffer by radix select
+
+	Finds the sample at a given quantile without sorting (or even copying) the data: four histogram passes over
+	the 256-ary radix of a sign-flipped float key narrow the candidate partition by 8 bits each, giving the exact
+	k-th smallest value in O(n) work and O(1) extra memory. The histogram passes run on the GPU where available
+	(data stays device-side), with a multithreaded CPU fallback.
+
+	Intended for one-shot robust statistics (median / percentile extraction) over full captures, where a
+	sort-based approach would allocate and order a copy of the entire waveform. NaN samples sort above +inf
+	and will skew results; filter them out first if the input may contain gaps.
+ */
+class QuantileSelector
+{
+public:
+	QuantileSelector();
+
+	//not copyable or assignable
+	QuantileSelector(const QuantileSelector&) =delete;
+	QuantileSelector& operator=(const QuantileSelector&) =delete;
+
+	///@brief Checks if the GPU supports the shaders this primitive needs
+	static bool IsAvailable()
+	{ return g_hasPushDescriptor; }
+
+	float Select(
+		AcceleratorBuffer<float>& din,
+		size_t len,
+		double quantile,
+		vk::raii::CommandBuffer& cmdBuf,
+		std::shared_ptr<QueueHandle> queue);
+
+protected:
+	float SelectCpu(AcceleratorBuffer<float>& din, size_t len, size_t rank);
+
+	ComputePipeline m_histogramPipeline;
+
+	///@brief 256-bin histogram of the current radix digit
+	AcceleratorBuffer<uint32_t> m_histogram;
+};
+
+#endif
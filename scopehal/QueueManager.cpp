@@ -42,6 +42,7 @@ using namespace std;
 
 
 extern bool g_hasDebugUtils;
+extern bool g_hasTimelineSemaphore;
 
 
 QueueHandle::QueueHandle(std::shared_ptr<vk::raii::Device> device, size_t family, size_t index, string name)
@@ -52,6 +53,7 @@ QueueHandle::QueueHandle(std::shared_ptr<vk::raii::Device> device, size_t family
 , m_device(device)
 , m_queue(make_unique<vk::raii::Queue>(*device, family, index))
 , m_fence(nullptr)
+, m_timelineValue(0)
 {
 	AddName(name);
 }
@@ -59,7 +61,11 @@ QueueHandle::QueueHandle(std::shared_ptr<vk::raii::Device> device, size_t family
 QueueHandle::~QueueHandle()
 {
 	const lock_guard<recursive_mutex> lock(m_mutex);
+	m_pendingBuffers.clear();
+	m_pendingWaits.clear();
+	m_timelineSemaphore = nullptr;
 	m_fence = nullptr;
+	m_freeFences.clear();
 	m_queue = nullptr;
 	m_device = nullptr;
 }
@@ -86,43 +92,225 @@ void QueueHandle::Submit(vk::raii::CommandBuffer const& cmdBuf)
 {
 	const lock_guard<recursive_mutex> lock(m_mutex);
 
-	_waitFence();
+	//Hand any batched work to the driver first so it stays ahead of us in queue order
+	//(no need to block on it: it's on the same queue as us)
+	_flushPending();
 
-	vk::SubmitInfo info({}, {}, *cmdBuf);
-	m_fence = make_unique<vk::raii::Fence>(*m_device, vk::FenceCreateInfo());
-	if(g_hasDebugUtils)
+	//Wait out any previous non-blocking submit so the fence slot is free for reuse
+	if(m_fence)
 	{
-		m_device->setDebugUtilsObjectNameEXT(
-			vk::DebugUtilsObjectNameInfoEXT(
-				vk::ObjectType::eFence,
-				reinterpret_cast<uint64_t>(static_cast<VkFence>(**m_fence)),
-				m_name.c_str()));
+		while(vk::Result::eTimeout == m_device->waitForFences({**m_fence}, VK_TRUE, 1000 * 1000))
+		{}
+
+		_recycleFence(m_fence);
+		m_fence = nullptr;
 	}
+
+	vector<vk::Semaphore> waitSems;
+	vector<uint64_t> waitValues;
+	vector<vk::PipelineStageFlags> waitStages;
+	_takeWaits(waitSems, waitValues, waitStages);
+
+	vk::SubmitInfo info(waitSems, waitStages, *cmdBuf);
+	vk::TimelineSemaphoreSubmitInfo tsinfo(waitValues, {});
+	if(!waitSems.empty())
+		info.pNext = &tsinfo;
+	m_fence = _getFence();
 	m_queue->submit(info, **m_fence);
 }
 
 void QueueHandle::SubmitAndBlock(vk::raii::CommandBuffer const& cmdBuf)
+{
+	//Submit while holding the lock (queues require external synchronization), but wait on our own
+	//fence after releasing it. This lets other threads sharing this queue submit independent work
+	//while our dispatch executes, instead of serializing on whole submit-plus-wait pairs.
+	shared_ptr<vk::raii::Fence> fence;
+	{
+		const lock_guard<recursive_mutex> lock(m_mutex);
+
+		//Hand any batched work to the driver first so it stays ahead of us in queue order.
+		//No host sync needed: our own fence wait below covers it transitively.
+		_flushPending();
+
+		//Wait out any previous non-blocking submit so the fence slot is free for reuse
+		if(m_fence)
+		{
+			while(vk::Result::eTimeout == m_device->waitForFences({**m_fence}, VK_TRUE, 1000 * 1000))
+			{}
+
+			_recycleFence(m_fence);
+			m_fence = nullptr;
+		}
+
+		vector<vk::Semaphore> waitSems;
+		vector<uint64_t> waitValues;
+		vector<vk::PipelineStageFlags> waitStages;
+		_takeWaits(waitSems, waitValues, waitStages);
+
+		vk::SubmitInfo info(waitSems, waitStages, *cmdBuf);
+		vk::TimelineSemaphoreSubmitInfo tsinfo(waitValues, {});
+		if(!waitSems.empty())
+			info.pNext = &tsinfo;
+		fence = _getFence();
+		m_queue->submit(info, **fence);
+	}
+
+	//Wait for our submit to finish
+	while(vk::Result::eTimeout == m_device->waitForFences({**fence}, VK_TRUE, 1000 * 1000))
+	{}
+
+	const lock_guard<recursive_mutex> lock(m_mutex);
+	_recycleFence(fence);
+}
+
+uint64_t QueueHandle::SubmitBatched(vk::raii::CommandBuffer const& cmdBuf)
+{
+	const lock_guard<recursive_mutex> lock(m_mutex);
+
+	m_pendingBuffers.push_back(*cmdBuf);
+
+	//The batch containing this buffer signals the next timeline value when it's eventually flushed
+	uint64_t value = g_hasTimelineSemaphore ? (m_timelineValue + 1) : 0;
+
+	//Don't let the batch grow without bound, so callers don't have to keep an
+	//arbitrarily large set of command buffers alive
+	if(m_pendingBuffers.size() >= MAX_BATCH_SIZE)
+		_flushPending();
+
+	return value;
+}
+
+void QueueHandle::FlushBatch()
+{
+	const lock_guard<recursive_mutex> lock(m_mutex);
+	_flushPending();
+}
+
+void QueueHandle::FlushBatchAndBlock()
 {
 	const lock_guard<recursive_mutex> lock(m_mutex);
 
+	//_waitFence() flushes anything still batched, then waits for it all to complete
 	_waitFence();
+}
 
-	vk::SubmitInfo info({}, {}, *cmdBuf);
-	m_fence = make_unique<vk::raii::Fence>(*m_device, vk::FenceCreateInfo());
-	if(g_hasDebugUtils)
+void QueueHandle::AddPendingWait(shared_ptr<QueueHandle> other, uint64_t value)
+{
+	//Work already submitted to our own queue stays ahead of us in queue order, nothing to do
+	if(other.get() == this)
+		return;
+
+	//Make sure the batch that signals the requested value has actually been handed to the driver
+	other->FlushBatch();
+
+	//If the sync point can't be expressed device side, fall back to a host wait right here
+	bool deviceSide = false;
 	{
-		m_device->setDebugUtilsObjectNameEXT(
-			vk::DebugUtilsObjectNameInfoEXT(
-				vk::ObjectType::eFence,
-				reinterpret_cast<uint64_t>(static_cast<VkFence>(**m_fence)),
-				m_name.c_str()));
+		const lock_guard<recursive_mutex> olock(other->m_mutex);
+		if(other->m_timelineSemaphore && (value != 0) )
+			deviceSide = true;
 	}
-	m_queue->submit(info, **m_fence);
-	_waitFence();
+	if(!deviceSide)
+	{
+		other->FlushBatchAndBlock();
+		return;
+	}
+
+	const lock_guard<recursive_mutex> lock(m_mutex);
+	m_pendingWaits.push_back(PendingWait{other, value});
+}
+
+void QueueHandle::_takeWaits(
+	vector<vk::Semaphore>& sems,
+	vector<uint64_t>& values,
+	vector<vk::PipelineStageFlags>& stages)
+{
+	for(auto& w : m_pendingWaits)
+	{
+		//No lock on the other handle: AddPendingWait verified the semaphore existed when the wait was
+		//recorded, and once created it's never replaced until the handle is destroyed
+		if(!w.m_handle->m_timelineSemaphore)
+			continue;
+
+		sems.push_back(**w.m_handle->m_timelineSemaphore);
+		values.push_back(w.m_value);
+		stages.push_back(vk::PipelineStageFlagBits::eAllCommands);
+	}
+	m_pendingWaits.clear();
+}
+
+void QueueHandle::_flushPending()
+{
+	if(m_pendingBuffers.empty())
+		return;
+
+	//Timeline semaphore path: one submit for the whole batch, no fence needed.
+	//Completion is observed by waiting for the semaphore to reach the signaled value.
+	if(g_hasTimelineSemaphore)
+	{
+		if(!m_timelineSemaphore)
+		{
+			vk::SemaphoreTypeCreateInfo timelineInfo(vk::SemaphoreType::eTimeline, 0);
+			vk::SemaphoreCreateInfo cinfo;
+			cinfo.pNext = &timelineInfo;
+			m_timelineSemaphore = make_unique<vk::raii::Semaphore>(*m_device, cinfo);
+
+			if(g_hasDebugUtils)
+			{
+				m_device->setDebugUtilsObjectNameEXT(
+					vk::DebugUtilsObjectNameInfoEXT(
+						vk::ObjectType::eSemaphore,
+						reinterpret_cast<uint64_t>(static_cast<VkSemaphore>(**m_timelineSemaphore)),
+						m_name.c_str()));
+			}
+		}
+
+		vector<vk::Semaphore> waitSems;
+		vector<uint64_t> waitValues;
+		vector<vk::PipelineStageFlags> waitStages;
+		_takeWaits(waitSems, waitValues, waitStages);
+
+		m_timelineValue ++;
+		vk::TimelineSemaphoreSubmitInfo tsinfo(waitValues, m_timelineValue);
+		vk::SubmitInfo info(waitSems, waitStages, m_pendingBuffers, **m_timelineSemaphore);
+		info.pNext = &tsinfo;
+		m_queue->submit(info);
+	}
+
+	//No timeline semaphores: still a single submit, but tracked by a pooled fence.
+	//Only one fence slot, so wait out any previous submit before reusing it.
+	else
+	{
+		if(m_fence)
+		{
+			while(vk::Result::eTimeout == m_device->waitForFences({**m_fence}, VK_TRUE, 1000 * 1000))
+			{}
+
+			_recycleFence(m_fence);
+			m_fence = nullptr;
+		}
+
+		vk::SubmitInfo info({}, {}, m_pendingBuffers);
+		m_fence = _getFence();
+		m_queue->submit(info, **m_fence);
+	}
+
+	m_pendingBuffers.clear();
 }
 
 void QueueHandle::_waitFence()
 {
+	//Anything still batched has to be submitted before the queue can drain
+	_flushPending();
+
+	//Wait for the last batched submit to complete
+	if(m_timelineSemaphore)
+	{
+		vk::SemaphoreWaitInfo winfo({}, **m_timelineSemaphore, m_timelineValue);
+		while(vk::Result::eTimeout == m_device->waitSemaphores(winfo, 1000 * 1000))
+		{}
+	}
+
 	if(!m_fence)
 		return;
 
@@ -130,9 +318,37 @@ void QueueHandle::_waitFence()
 	while(vk::Result::eTimeout == m_device->waitForFences({**m_fence}, VK_TRUE, 1000 * 1000))
 	{}
 
+	_recycleFence(m_fence);
 	m_fence = nullptr;
 }
 
+shared_ptr<vk::raii::Fence> QueueHandle::_getFence()
+{
+	if(!m_freeFences.empty())
+	{
+		auto fence = m_freeFences.back();
+		m_freeFences.pop_back();
+		return fence;
+	}
+
+	auto fence = make_shared<vk::raii::Fence>(*m_device, vk::FenceCreateInfo());
+	if(g_hasDebugUtils)
+	{
+		m_device->setDebugUtilsObjectNameEXT(
+			vk::DebugUtilsObjectNameInfoEXT(
+				vk::ObjectType::eFence,
+				reinterpret_cast<uint64_t>(static_cast<VkFence>(**fence)),
+				m_name.c_str()));
+	}
+	return fence;
+}
+
+void QueueHandle::_recycleFence(shared_ptr<vk::raii::Fence> fence)
+{
+	m_device->resetFences({**fence});
+	m_freeFences.push_back(fence);
+}
+
 
 QueueManager::QueueManager(vk::raii::PhysicalDevice* phys, std::shared_ptr<vk::raii::Device> device)
 : m_phys(phys)
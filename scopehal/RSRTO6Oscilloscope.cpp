@@ -783,10 +783,13 @@ bool RSRTO6Oscilloscope::AcquireData()
 		// Request a reasonably-sized buffer as this may cause RAM allocation in recv(2)
 		const size_t block_size = 50e6;
 
-		unsigned char* dest_buf = (unsigned char*)cap->m_samples.GetCpuPointer();
-
 		LogDebug(" - Begin transfer of %zu bytes\n", length);
 
+		//Build the full chunk list up front so the whole download goes out as one pipelined batch:
+		//each DATA? is already on the wire before the previous chunk finishes arriving, so we don't
+		//pay a round trip plus instrument prep time per chunk
+		vector<SCPITransport::BlockQuery> chunks;
+		vector<size_t> chunk_lengths;
 		while (transferred != length)
 		{
 			size_t this_length = block_size;
@@ -798,40 +801,40 @@ bool RSRTO6Oscilloscope::AcquireData()
 			if (transferred == 0 && this_length == length)
 				params = "";
 
-			LogDebug("[%3d%%] Query ...`DATA?%s` (B)\n", (int)(100*((float)transferred/(float)length)), params.c_str());
+			LogDebug("Query ...`DATA?%s` (B)\n", params.c_str());
 
-			//Ask for the data
-			size_t len_bytes;
-			unsigned char* samples = (unsigned char*)m_transport->SendCommandImmediateWithRawBlockReply(m_channels[i]->GetHwname() + ":DATA?"+params+"; *WAI", len_bytes);
+			chunks.emplace_back(
+				m_channels[i]->GetHwname() + ":DATA?"+params+"; *WAI",
+				transferred*sizeof(float));
+			chunk_lengths.push_back(this_length);
 
-			if (len_bytes != (this_length*sizeof(float)))
-			{
-				LogError("Unexpected number of bytes back; aborting acquisition");
-				std::this_thread::sleep_for(std::chrono::microseconds(100000));
-				m_transport->FlushRXBuffer();
+			transferred += this_length;
+		}
 
-				delete cap;
+		//Read the payloads directly into the waveform's pinned buffer
+		//(each block has a trailing newline we have to discard)
+		auto len_bytes = m_transport->SendBlockQueryBatch(chunks, cap->m_samples, 1);
 
-				for (auto* c : pending_waveforms[i])
-				{
-					delete c;
-				}
+		bool ok = (len_bytes.size() == chunks.size());
+		for (size_t j=0; ok && (j < chunks.size()); j++)
+		{
+			if (len_bytes[j] != (chunk_lengths[j]*sizeof(float)))
+				ok = false;
+		}
+		if (!ok)
+		{
+			LogError("Unexpected number of bytes back; aborting acquisition");
+			std::this_thread::sleep_for(std::chrono::microseconds(100000));
+			m_transport->FlushRXBuffer();
 
-				delete[] samples;
+			delete cap;
 
-				return false;
+			for (auto* c : pending_waveforms[i])
+			{
+				delete c;
 			}
 
-			unsigned char* cpy_target = dest_buf+(transferred*sizeof(float));
-			// LogDebug("Copying %zuB from %p to %p\n", len_bytes, samples, cpy_target);
-
-			memcpy(cpy_target, samples, len_bytes);
-			transferred += this_length;
-			delete[] samples;
-
-			//Discard trailing newline
-			uint8_t disregard;
-			m_transport->ReadRawData(1, &disregard);
+			return false;
 		}
 
 		LogDebug("[100%%] Done\n");
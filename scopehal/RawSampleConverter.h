@@ -0,0 +1,204 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal v0.1                                                                                                     *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Declaration of RawSampleConverter
+ */
+
+#ifndef RawSampleConverter_h
+#define RawSampleConverter_h
+
+/**
+	@brief Helper for converting raw ADC codes to float32 on the GPU
+
+	Wraps the Convert*Samples compute shaders, together with the queue, command pool, and pipelines needed to run
+	them, so that any driver can upload raw int8/uint8/int16 ADC blocks and have the gain/offset conversion write
+	straight into a waveform's GPU-side buffer rather than burning a CPU core per channel and then uploading the
+	converted samples anyway.
+
+	Usage: call Begin(), then one Convert*Samples() call per waveform, then Submit() to run the entire batch with
+	a single queue submission. Check IsGpuConversionAvailable*() first and fall back to the CPU helpers in
+	Oscilloscope if the device lacks the required integer storage support.
+
+	Conversion semantics match Oscilloscope::Convert8BitSamples() etc: out = in*gain - offset.
+ */
+class RawSampleConverter
+{
+public:
+	RawSampleConverter(const std::string& name);
+
+	//not copyable or assignable
+	RawSampleConverter(const RawSampleConverter&) =delete;
+	RawSampleConverter& operator=(const RawSampleConverter&) =delete;
+
+	///@brief Checks if the GPU can convert 8-bit samples (signed or unsigned)
+	static bool IsGpuConversionAvailable8Bit()
+	{ return g_hasShaderInt8 && g_hasPushDescriptor; }
+
+	///@brief Checks if the GPU can convert 16-bit samples
+	static bool IsGpuConversionAvailable16Bit()
+	{ return g_hasShaderInt16 && g_hasPushDescriptor; }
+
+	void Begin();
+	void Submit();
+
+	/**
+		@brief Queues conversion of a block of signed 8-bit ADC codes into a waveform's sample buffer
+
+		Templated on the raw buffer's element type since some drivers store packed 8-bit codes in wider buffers;
+		the shader always interprets the raw buffer contents as int8.
+	 */
+	template<class T>
+	void Convert8BitSamples(UniformAnalogWaveform* cap, AcceleratorBuffer<T>& raw, float gain, float offset)
+	{
+		if(!m_pipeline8Bit)
+		{
+			m_pipeline8Bit = std::make_unique<ComputePipeline>(
+				"shaders/Convert8BitSamples.spv", 2, sizeof(ConvertRawSamplesShaderArgs) );
+			m_pipeline8Bit->SetSpecializationConstants( { ComputePipeline::GetTunedWorkgroupSize() } );
+		}
+
+		Convert(*m_pipeline8Bit, cap, raw, gain, offset);
+	}
+
+	///@brief Queues conversion of a block of unsigned 8-bit ADC codes into a waveform's sample buffer
+	template<class T>
+	void ConvertUnsigned8BitSamples(UniformAnalogWaveform* cap, AcceleratorBuffer<T>& raw, float gain, float offset)
+	{
+		if(!m_pipelineUnsigned8Bit)
+		{
+			m_pipelineUnsigned8Bit = std::make_unique<ComputePipeline>(
+				"shaders/ConvertUnsigned8BitSamples.spv", 2, sizeof(ConvertRawSamplesShaderArgs) );
+			m_pipelineUnsigned8Bit->SetSpecializationConstants( { ComputePipeline::GetTunedWorkgroupSize() } );
+		}
+
+		Convert(*m_pipelineUnsigned8Bit, cap, raw, gain, offset);
+	}
+
+	///@brief Queues conversion of a block of signed 16-bit ADC codes into a waveform's sample buffer
+	template<class T>
+	void Convert16BitSamples(UniformAnalogWaveform* cap, AcceleratorBuffer<T>& raw, float gain, float offset)
+	{
+		if(!m_pipeline16Bit)
+		{
+			m_pipeline16Bit = std::make_unique<ComputePipeline>(
+				"shaders/Convert16BitSamples.spv", 2, sizeof(ConvertRawSamplesShaderArgs) );
+			m_pipeline16Bit->SetSpecializationConstants( { ComputePipeline::GetTunedWorkgroupSize() } );
+		}
+
+		Convert(*m_pipeline16Bit, cap, raw, gain, offset);
+	}
+
+	/**
+		@brief Queues de-interleaving conversion of signed 16-bit IQ pairs into separate I and Q waveforms
+
+		The raw buffer holds npairs interleaved (I, Q) code pairs; converted samples land at [outbase,
+		outbase + npairs) in each output. Chunking a large recording through a bounded staging buffer with
+		increasing outbase streams it onto the GPU without ever holding the whole file's float form in RAM.
+	 */
+	void ConvertInterleaved16BitSamples(
+		UniformAnalogWaveform* capI,
+		UniformAnalogWaveform* capQ,
+		AcceleratorBuffer<int16_t>& raw,
+		size_t npairs,
+		size_t outbase,
+		float gain,
+		float offset)
+	{
+		if(!m_pipelineInterleaved16Bit)
+		{
+			m_pipelineInterleaved16Bit = std::make_unique<ComputePipeline>(
+				"shaders/ConvertInterleaved16BitSamples.spv", 3, sizeof(ConvertInterleavedSamplesShaderArgs) );
+			m_pipelineInterleaved16Bit->SetSpecializationConstants( { ComputePipeline::GetTunedWorkgroupSize() } );
+		}
+
+		auto& pipeline = *m_pipelineInterleaved16Bit;
+		if(m_boundPipeline != &pipeline)
+		{
+			pipeline.Bind(*m_cmdBuf);
+			m_boundPipeline = &pipeline;
+		}
+
+		pipeline.BindBufferNonblocking(0, capI->m_samples, *m_cmdBuf, true);
+		pipeline.BindBufferNonblocking(1, capQ->m_samples, *m_cmdBuf, true);
+		pipeline.BindBufferNonblocking(2, raw, *m_cmdBuf);
+
+		ConvertInterleavedSamplesShaderArgs args;
+		args.size = npairs;
+		args.outbase = outbase;
+		args.gain = gain;
+		args.offset = offset;
+
+		pipeline.DispatchNoRebind(*m_cmdBuf, args, GetComputeBlockCount(npairs, pipeline.GetWorkgroupSize()));
+
+		capI->MarkModifiedFromGpu();
+		capQ->MarkModifiedFromGpu();
+	}
+
+protected:
+	template<class T>
+	void Convert(ComputePipeline& pipeline, UniformAnalogWaveform* cap, AcceleratorBuffer<T>& raw, float gain, float offset)
+	{
+		//Rebind if this dispatch uses a different pipeline than the previous one in the batch
+		if(m_boundPipeline != &pipeline)
+		{
+			pipeline.Bind(*m_cmdBuf);
+			m_boundPipeline = &pipeline;
+		}
+
+		pipeline.BindBufferNonblocking(0, cap->m_samples, *m_cmdBuf, true);
+		pipeline.BindBufferNonblocking(1, raw, *m_cmdBuf);
+
+		ConvertRawSamplesShaderArgs args;
+		args.size = cap->size();
+		args.gain = gain;
+		args.offset = offset;
+
+		pipeline.DispatchNoRebind(*m_cmdBuf, args, GetComputeBlockCount(cap->size(), pipeline.GetWorkgroupSize()));
+
+		cap->MarkModifiedFromGpu();
+	}
+
+	std::shared_ptr<QueueHandle> m_queue;
+	std::unique_ptr<vk::raii::CommandPool> m_pool;
+	std::unique_ptr<vk::raii::CommandBuffer> m_cmdBuf;
+
+	//Conversion pipelines (lazily created the first time each sample format is used)
+	std::unique_ptr<ComputePipeline> m_pipeline8Bit;
+	std::unique_ptr<ComputePipeline> m_pipelineUnsigned8Bit;
+	std::unique_ptr<ComputePipeline> m_pipeline16Bit;
+	std::unique_ptr<ComputePipeline> m_pipelineInterleaved16Bit;
+
+	///@brief Pipeline currently bound to the command buffer within the active batch, if any
+	ComputePipeline* m_boundPipeline;
+};
+
+#endif
@@ -39,6 +39,8 @@ RemoteBridgeOscilloscope::RemoteBridgeOscilloscope(SCPITransport* transport, boo
 	: SCPIDevice(transport, identify)
 	, SCPIOscilloscope()
 	, m_triggerArmed(false)
+	, m_continuousArm(false)
+	, m_continuousArmMaxPending(0)
 {
 
 }
@@ -87,6 +89,68 @@ void RemoteBridgeOscilloscope::PullTrigger()
 	//pulling not needed, we always have a valid trigger cached
 }
 
+/**
+	@brief Enables the continuous-arm protocol extension.
+
+	In this mode the bridge re-arms the digitizer immediately after each trigger instead of sitting idle while
+	the host downloads, and streams completed segments over the data socket as long as it holds credits. The
+	host grants one credit per segment it has queue space for: maxPendingDepth credits up front, then one more
+	each time a waveform set is popped off m_pendingWaveforms. A slow consumer therefore backpressures the
+	bridge instead of causing unbounded buffering.
+
+	Only call this when the connected bridge implements the CONTARM command; drivers that already send their own
+	per-waveform request byte (e.g. ThunderScope) should not mix that with continuous-arm mode.
+ */
+void RemoteBridgeOscilloscope::EnableContinuousArm(size_t maxPendingDepth)
+{
+	lock_guard<recursive_mutex> lock(m_mutex);
+
+	m_continuousArm = true;
+	m_continuousArmMaxPending = maxPendingDepth;
+	m_transport->SendCommand("CONTARM ON");
+
+	//Grant the bridge one credit per queue slot to get streaming started
+	for(size_t i=0; i<maxPendingDepth; i++)
+		SendStreamCredit();
+}
+
+void RemoteBridgeOscilloscope::DisableContinuousArm()
+{
+	lock_guard<recursive_mutex> lock(m_mutex);
+
+	m_continuousArm = false;
+	m_transport->SendCommand("CONTARM OFF");
+}
+
+/**
+	@brief Grants the bridge a credit to capture and stream one more segment
+ */
+void RemoteBridgeOscilloscope::SendStreamCredit()
+{
+	const uint8_t k = 'K';
+	m_transport->SendRawData(1, &k);
+}
+
+/**
+	@brief Pops a waveform set off the pending queue, then replenishes the bridge's segment credit.
+
+	This ties the continuous-arm flow control directly to the pending waveform queue depth: consuming a set
+	frees exactly one credit, so the queue can never grow past the depth passed to EnableContinuousArm().
+ */
+bool RemoteBridgeOscilloscope::PopPendingWaveform()
+{
+	if(!Oscilloscope::PopPendingWaveform())
+		return false;
+
+	if(m_continuousArm)
+	{
+		lock_guard<recursive_mutex> lock(m_mutex);
+		SendStreamCredit();
+	}
+
+	return true;
+}
+
 void RemoteBridgeOscilloscope::SetTriggerOffset(int64_t offset)
 {
 	lock_guard<recursive_mutex> lock(m_mutex);
@@ -61,6 +61,15 @@ public:
 	virtual void StartSingleTrigger() override;
 	virtual void ForceTrigger() override;
 	virtual void Stop() override;
+
+	// Continuous-arm streaming (protocol extension, not supported by all bridges)
+	void EnableContinuousArm(size_t maxPendingDepth = 2);
+	void DisableContinuousArm();
+
+	bool IsContinuousArmEnabled()
+	{ return m_continuousArm; }
+
+	virtual bool PopPendingWaveform() override;
 	virtual void PushTrigger() override;
 	virtual void PullTrigger() override;
 	virtual bool IsTriggerArmed() override;
@@ -75,10 +84,18 @@ public:
 	virtual void SetSampleRate(uint64_t rate) override;
 
 protected:
+	void SendStreamCredit();
+
 	bool m_triggerArmed;
 	bool m_triggerOneShot;
 	int64_t m_triggerOffset;
 
+	///@brief True if the bridge is in continuous-arm mode and streams segments against our credits
+	bool m_continuousArm;
+
+	///@brief Pending-queue depth (and thus credit count) negotiated in EnableContinuousArm()
+	size_t m_continuousArmMaxPending;
+
 	uint64_t m_srate;
 	uint64_t m_mdepth;
 
@@ -0,0 +1,964 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Implementation of RemoteFilterGraphClient and RemoteFilterGraphServer
+ */
+
+#include "scopehal.h"
+#include "RemoteFilterGraph.h"
+
+#ifdef HAS_ZSTD
+#include <zstd.h>
+#endif
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Wire protocol
+
+namespace
+{
+	///@brief Message types exchanged between client and server
+	enum RemoteGraphMessageType
+	{
+		///@brief YAML description of the subgraph (client to server)
+		MSG_GRAPH		= 1,
+
+		///@brief An input waveform payload (client to server)
+		MSG_WAVEFORM	= 2,
+
+		///@brief Run the graph (client to server)
+		MSG_EXECUTE		= 3,
+
+		///@brief An output waveform payload (server to client)
+		MSG_RESULT		= 4,
+
+		///@brief End of the results for one execution (server to client)
+		MSG_DONE		= 5
+	};
+
+	///@brief Framing header preceding every message
+	struct RemoteGraphMessageHeader
+	{
+		///@brief A RemoteGraphMessageType value
+		uint32_t	m_type;
+
+		///@brief Reserved for future use, write as zero
+		uint32_t	m_reserved;
+
+		///@brief Length of the payload following this header, in bytes
+		uint64_t	m_length;
+	};
+
+	///@brief Start of a MSG_WAVEFORM / MSG_RESULT payload
+	struct RemoteGraphWaveformHeader
+	{
+		///@brief IDTable ID of the node the waveform belongs to
+		uint64_t	m_node;
+
+		///@brief Stream index on that node
+		uint32_t	m_stream;
+
+		///@brief A WaveformFile::WaveformEncoding value
+		uint32_t	m_encoding;
+
+		///@brief Number of samples in the waveform
+		uint64_t	m_numSamples;
+
+		///@brief WaveformBase::m_timescale
+		int64_t		m_timescale;
+
+		///@brief WaveformBase::m_triggerPhase
+		int64_t		m_triggerPhase;
+
+		///@brief WaveformBase::m_startTimestamp
+		int64_t		m_startTimestamp;
+
+		///@brief WaveformBase::m_startFemtoseconds
+		int64_t		m_startFemtoseconds;
+
+		///@brief WaveformBase::m_flags
+		uint32_t	m_flags;
+
+		///@brief Number of columns following this header
+		uint32_t	m_numColumns;
+	};
+
+	///@brief Descriptor for one column within a waveform payload
+	struct RemoteGraphColumnHeader
+	{
+		///@brief A WaveformFile::ColumnType value
+		uint32_t	m_type;
+
+		///@brief A WaveformFile::CompressionType value
+		uint32_t	m_compression;
+
+		///@brief Uncompressed length of the column, in bytes
+		uint64_t	m_byteLength;
+
+		///@brief Length of the column as sent on the wire, in bytes
+		uint64_t	m_wireLength;
+	};
+
+	///@brief Upper bound on a single message, as a sanity check against garbage or malicious length fields
+	const uint64_t MAX_MESSAGE_SIZE = 0x1000000000ULL;	//64 GB
+
+	///@brief Columns smaller than this aren't worth the CPU time to compress
+	const size_t COMPRESSION_THRESHOLD = 4096;
+
+	/**
+		@brief Placeholder channel holding an input waveform streamed from the client
+
+		Has no parent instrument; exists only so the hosted filters have something to take their inputs from.
+	 */
+	class RemoteInputChannel : public OscilloscopeChannel
+	{
+	public:
+		RemoteInputChannel(const string& name, const string& color, Unit xunit)
+			: OscilloscopeChannel(nullptr, name, color, xunit)
+		{}
+
+		//Streams are described by the client rather than baked into a driver, so stream creation has to be public
+		using InstrumentChannel::AddStream;
+	};
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Framing helpers
+
+static bool SendFramed(Socket& sock, uint32_t type, const uint8_t* data = nullptr, uint64_t len = 0)
+{
+	RemoteGraphMessageHeader hdr;
+	hdr.m_type = type;
+	hdr.m_reserved = 0;
+	hdr.m_length = len;
+
+	if(!sock.SendLooped((unsigned char*)&hdr, sizeof(hdr)))
+		return false;
+	if(len != 0)
+		return sock.SendLooped((unsigned char*)data, len);
+	return true;
+}
+
+static bool RecvFramed(Socket& sock, uint32_t& type, vector<uint8_t>& payload)
+{
+	RemoteGraphMessageHeader hdr;
+	if(!sock.RecvLooped((unsigned char*)&hdr, sizeof(hdr)))
+		return false;
+
+	if(hdr.m_length > MAX_MESSAGE_SIZE)
+	{
+		LogError("Remote filter graph message length %" PRIu64 " exceeds sanity limit\n", hdr.m_length);
+		return false;
+	}
+
+	payload.resize(hdr.m_length);
+	if(hdr.m_length != 0)
+	{
+		if(!sock.RecvLooped(payload.data(), hdr.m_length))
+			return false;
+	}
+
+	type = hdr.m_type;
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Waveform serialization
+
+/**
+	@brief Appends one column to a waveform payload, zstd compressing it if that's available and worthwhile
+ */
+static void AppendColumn(vector<uint8_t>& payload, uint32_t type, const void* data, uint64_t len)
+{
+	RemoteGraphColumnHeader ch;
+	ch.m_type = type;
+	ch.m_compression = WaveformFile::COMPRESSION_NONE;
+	ch.m_byteLength = len;
+	ch.m_wireLength = len;
+
+#ifdef HAS_ZSTD
+	if(len >= COMPRESSION_THRESHOLD)
+	{
+		vector<uint8_t> cbuf(ZSTD_compressBound(len));
+		size_t clen = ZSTD_compress(cbuf.data(), cbuf.size(), data, len, ZSTD_CLEVEL_DEFAULT);
+
+		//Only use the compressed form if it actually got smaller
+		if(!ZSTD_isError(clen) && (clen < len) )
+		{
+			ch.m_compression = WaveformFile::COMPRESSION_ZSTD;
+			ch.m_wireLength = clen;
+
+			size_t base = payload.size();
+			payload.resize(base + sizeof(ch) + clen);
+			memcpy(payload.data() + base, &ch, sizeof(ch));
+			memcpy(payload.data() + base + sizeof(ch), cbuf.data(), clen);
+			return;
+		}
+	}
+#endif
+
+	size_t base = payload.size();
+	payload.resize(base + sizeof(ch) + len);
+	memcpy(payload.data() + base, &ch, sizeof(ch));
+	if(len != 0)
+		memcpy(payload.data() + base + sizeof(ch), data, len);
+}
+
+/**
+	@brief Reads one column out of a waveform payload into an AcceleratorBuffer
+
+	Returns false on truncation, element size mismatch, or decompression failure.
+ */
+template<class T>
+static bool ReadColumn(const RemoteGraphColumnHeader& ch, const uint8_t* wire, AcceleratorBuffer<T>& buf)
+{
+	if( (ch.m_byteLength % sizeof(T)) != 0)
+	{
+		LogError("Remote filter graph column length %" PRIu64 " is not a multiple of the element size\n",
+			ch.m_byteLength);
+		return false;
+	}
+
+	buf.resize(ch.m_byteLength / sizeof(T));
+	buf.PrepareForCpuAccess();
+
+	switch(ch.m_compression)
+	{
+		case WaveformFile::COMPRESSION_NONE:
+			if(ch.m_wireLength != ch.m_byteLength)
+				return false;
+			memcpy(buf.GetCpuPointer(), wire, ch.m_byteLength);
+			break;
+
+		case WaveformFile::COMPRESSION_ZSTD:
+			{
+#ifdef HAS_ZSTD
+				size_t dlen = ZSTD_decompress(buf.GetCpuPointer(), ch.m_byteLength, wire, ch.m_wireLength);
+				if(ZSTD_isError(dlen) || (dlen != ch.m_byteLength) )
+				{
+					LogError("Failed to decompress remote filter graph column\n");
+					return false;
+				}
+#else
+				LogError("Remote filter graph peer sent zstd compressed data, but we were built without zstd\n");
+				return false;
+#endif
+			}
+			break;
+
+		default:
+			LogError("Unknown compression type %u in remote filter graph column\n", ch.m_compression);
+			return false;
+	}
+
+	buf.MarkModifiedFromCpu();
+	return true;
+}
+
+/**
+	@brief Serializes a waveform into a MSG_WAVEFORM / MSG_RESULT payload
+
+	Returns false for waveform types that can't cross the wire (eye patterns, spectrograms, etc).
+ */
+static bool SerializeWaveformMessage(vector<uint8_t>& payload, uint64_t nodeId, size_t stream, WaveformBase* wfm)
+{
+	auto ua = dynamic_cast<UniformAnalogWaveform*>(wfm);
+	auto sa = dynamic_cast<SparseAnalogWaveform*>(wfm);
+	auto ud = dynamic_cast<UniformDigitalWaveform*>(wfm);
+	auto sd = dynamic_cast<SparseDigitalWaveform*>(wfm);
+
+	RemoteGraphWaveformHeader hdr;
+	hdr.m_node = nodeId;
+	hdr.m_stream = stream;
+	hdr.m_numSamples = wfm->size();
+	hdr.m_timescale = wfm->m_timescale;
+	hdr.m_triggerPhase = wfm->m_triggerPhase;
+	hdr.m_startTimestamp = wfm->m_startTimestamp;
+	hdr.m_startFemtoseconds = wfm->m_startFemtoseconds;
+	hdr.m_flags = wfm->m_flags;
+
+	if(ua)
+	{
+		hdr.m_encoding = WaveformFile::ENCODING_UNIFORM_ANALOG;
+		hdr.m_numColumns = 1;
+	}
+	else if(sa)
+	{
+		hdr.m_encoding = WaveformFile::ENCODING_SPARSE_ANALOG;
+		hdr.m_numColumns = 3;
+	}
+	else if(ud)
+	{
+		hdr.m_encoding = WaveformFile::ENCODING_UNIFORM_DIGITAL;
+		hdr.m_numColumns = 1;
+	}
+	else if(sd)
+	{
+		hdr.m_encoding = WaveformFile::ENCODING_SPARSE_DIGITAL;
+		hdr.m_numColumns = 3;
+	}
+	else
+		return false;
+
+	wfm->PrepareForCpuAccess();
+
+	payload.clear();
+	payload.resize(sizeof(hdr));
+	memcpy(payload.data(), &hdr, sizeof(hdr));
+
+	if(ua)
+		AppendColumn(payload, WaveformFile::COLUMN_SAMPLES, ua->m_samples.GetCpuPointer(), ua->size() * sizeof(float));
+	else if(sa)
+	{
+		AppendColumn(payload, WaveformFile::COLUMN_SAMPLES, sa->m_samples.GetCpuPointer(), sa->size() * sizeof(float));
+		AppendColumn(payload, WaveformFile::COLUMN_OFFSETS, sa->m_offsets.GetCpuPointer(), sa->size() * sizeof(int64_t));
+		AppendColumn(payload, WaveformFile::COLUMN_DURATIONS, sa->m_durations.GetCpuPointer(), sa->size() * sizeof(int64_t));
+	}
+	else if(ud)
+		AppendColumn(payload, WaveformFile::COLUMN_SAMPLES, ud->m_samples.GetCpuPointer(), ud->size() * sizeof(bool));
+	else if(sd)
+	{
+		AppendColumn(payload, WaveformFile::COLUMN_SAMPLES, sd->m_samples.GetCpuPointer(), sd->size() * sizeof(bool));
+		AppendColumn(payload, WaveformFile::COLUMN_OFFSETS, sd->m_offsets.GetCpuPointer(), sd->size() * sizeof(int64_t));
+		AppendColumn(payload, WaveformFile::COLUMN_DURATIONS, sd->m_durations.GetCpuPointer(), sd->size() * sizeof(int64_t));
+	}
+
+	return true;
+}
+
+/**
+	@brief Deserializes a waveform out of a MSG_WAVEFORM / MSG_RESULT payload
+
+	On success returns the new waveform (owned by the caller) and fills hdr; on any parse error returns null.
+ */
+static WaveformBase* DeserializeWaveformMessage(const vector<uint8_t>& payload, RemoteGraphWaveformHeader& hdr)
+{
+	if(payload.size() < sizeof(hdr))
+	{
+		LogError("Truncated remote filter graph waveform message\n");
+		return nullptr;
+	}
+	memcpy(&hdr, payload.data(), sizeof(hdr));
+
+	//Create the right type of waveform
+	WaveformBase* wfm;
+	UniformAnalogWaveform* ua = nullptr;
+	SparseAnalogWaveform* sa = nullptr;
+	UniformDigitalWaveform* ud = nullptr;
+	SparseDigitalWaveform* sd = nullptr;
+	switch(hdr.m_encoding)
+	{
+		case WaveformFile::ENCODING_UNIFORM_ANALOG:
+			wfm = ua = new UniformAnalogWaveform;
+			break;
+		case WaveformFile::ENCODING_SPARSE_ANALOG:
+			wfm = sa = new SparseAnalogWaveform;
+			break;
+		case WaveformFile::ENCODING_UNIFORM_DIGITAL:
+			wfm = ud = new UniformDigitalWaveform;
+			break;
+		case WaveformFile::ENCODING_SPARSE_DIGITAL:
+			wfm = sd = new SparseDigitalWaveform;
+			break;
+		default:
+			LogError("Unknown waveform encoding %u in remote filter graph message\n", hdr.m_encoding);
+			return nullptr;
+	}
+
+	wfm->m_timescale = hdr.m_timescale;
+	wfm->m_triggerPhase = hdr.m_triggerPhase;
+	wfm->m_startTimestamp = hdr.m_startTimestamp;
+	wfm->m_startFemtoseconds = hdr.m_startFemtoseconds;
+	wfm->m_flags = hdr.m_flags;
+
+	//Walk the columns
+	size_t offset = sizeof(hdr);
+	bool ok = true;
+	for(uint32_t i=0; (i < hdr.m_numColumns) && ok; i++)
+	{
+		RemoteGraphColumnHeader ch;
+		if( (offset + sizeof(ch)) > payload.size() )
+		{
+			ok = false;
+			break;
+		}
+		memcpy(&ch, payload.data() + offset, sizeof(ch));
+		offset += sizeof(ch);
+
+		if( (offset + ch.m_wireLength) > payload.size() )
+		{
+			ok = false;
+			break;
+		}
+		auto wire = payload.data() + offset;
+		offset += ch.m_wireLength;
+
+		switch(ch.m_type)
+		{
+			case WaveformFile::COLUMN_SAMPLES:
+				if(ua)
+					ok = ReadColumn(ch, wire, ua->m_samples);
+				else if(sa)
+					ok = ReadColumn(ch, wire, sa->m_samples);
+				else if(ud)
+					ok = ReadColumn(ch, wire, ud->m_samples);
+				else
+					ok = ReadColumn(ch, wire, sd->m_samples);
+				break;
+
+			case WaveformFile::COLUMN_OFFSETS:
+				if(sa)
+					ok = ReadColumn(ch, wire, sa->m_offsets);
+				else if(sd)
+					ok = ReadColumn(ch, wire, sd->m_offsets);
+				else
+					ok = false;
+				break;
+
+			case WaveformFile::COLUMN_DURATIONS:
+				if(sa)
+					ok = ReadColumn(ch, wire, sa->m_durations);
+				else if(sd)
+					ok = ReadColumn(ch, wire, sd->m_durations);
+				else
+					ok = false;
+				break;
+
+			default:
+				LogError("Unknown column type %u in remote filter graph message\n", ch.m_type);
+				ok = false;
+				break;
+		}
+	}
+
+	if(!ok)
+	{
+		LogError("Malformed remote filter graph waveform message\n");
+		delete wfm;
+		return nullptr;
+	}
+
+	wfm->Resize(hdr.m_numSamples);
+	return wfm;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// RemoteFilterGraphClient construction / destruction
+
+RemoteFilterGraphClient::RemoteFilterGraphClient()
+	: m_socket(AF_INET, SOCK_STREAM, IPPROTO_TCP)
+	, m_graphDirty(true)
+{
+}
+
+RemoteFilterGraphClient::~RemoteFilterGraphClient()
+{
+	Disconnect();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// RemoteFilterGraphClient connection management
+
+bool RemoteFilterGraphClient::Connect(const string& host, uint16_t port)
+{
+	if(!m_socket.Connect(host, port))
+	{
+		LogError("Failed to connect to remote filter graph server at %s:%u\n", host.c_str(), (unsigned int)port);
+		return false;
+	}
+	m_socket.DisableNagle();
+
+	//New server session knows nothing about us, so everything has to be (re)sent
+	m_graphDirty = true;
+	m_sentWaveforms.clear();
+	m_idTable.clear();
+
+	return true;
+}
+
+/**
+	@brief Closes the connection to the server
+
+	The underlying socket cannot be reopened; create a new client object to reconnect.
+ */
+void RemoteFilterGraphClient::Disconnect()
+{
+	if(m_socket.IsValid())
+		m_socket.Close();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// RemoteFilterGraphClient graph management
+
+/**
+	@brief Adds a filter to the set executed remotely
+
+	The filter's configuration and input wiring are mirrored to the server on the next Execute() call.
+ */
+void RemoteFilterGraphClient::AddFilter(Filter* f)
+{
+	if(find(m_filters.begin(), m_filters.end(), f) != m_filters.end())
+		return;
+	m_filters.push_back(f);
+	m_graphDirty = true;
+}
+
+void RemoteFilterGraphClient::RemoveFilter(Filter* f)
+{
+	auto it = find(m_filters.begin(), m_filters.end(), f);
+	if(it == m_filters.end())
+		return;
+	m_filters.erase(it);
+	m_graphDirty = true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// RemoteFilterGraphClient execution
+
+/**
+	@brief Runs the remote subgraph once
+
+	Pushes the graph description (if changed) and any input waveforms that changed since the last run, executes the
+	graph on the server, and blocks until the terminal filters' outputs have been copied back into the local filter
+	objects.
+ */
+bool RemoteFilterGraphClient::Execute()
+{
+	if(!IsConnected())
+	{
+		LogError("RemoteFilterGraphClient::Execute() called while not connected\n");
+		return false;
+	}
+	if(m_filters.empty())
+		return true;
+
+	if(m_graphDirty)
+	{
+		if(!SendGraph())
+			return false;
+	}
+	if(!SendChangedInputs())
+		return false;
+	if(!SendFramed(m_socket, MSG_EXECUTE))
+		return false;
+
+	return ReceiveResults();
+}
+
+bool RemoteFilterGraphClient::SendGraph()
+{
+	//Sending a graph resets the server session, so all cached state is invalid
+	m_idTable.clear();
+	m_sentWaveforms.clear();
+
+	set<InstrumentChannel*> remoteFilters(m_filters.begin(), m_filters.end());
+
+	YAML::Node doc;
+
+	//Describe every channel feeding the subgraph from outside it.
+	//IDs for these must be assigned before serializing the filters, so the input references match up.
+	set<InstrumentChannel*> described;
+	YAML::Node channels;
+	for(auto f : m_filters)
+	{
+		for(size_t i=0; i<f->GetInputCount(); i++)
+		{
+			auto chan = f->GetInput(i).m_channel;
+			if(chan == nullptr)
+				continue;
+			if(remoteFilters.find(chan) != remoteFilters.end())
+				continue;
+			if(described.find(chan) != described.end())
+				continue;
+			described.emplace(chan);
+
+			YAML::Node cnode;
+			cnode["id"] = (uint64_t)m_idTable.emplace(chan);
+			cnode["name"] = chan->GetDisplayName();
+			cnode["color"] = chan->m_displaycolor;
+			cnode["xunit"] = chan->GetXAxisUnits().ToString();
+
+			YAML::Node streams;
+			for(size_t j=0; j<chan->GetStreamCount(); j++)
+			{
+				YAML::Node snode;
+				snode["name"] = chan->GetStreamName(j);
+				snode["yunit"] = chan->GetYAxisUnits(j).ToString();
+				snode["stype"] = (int)chan->GetType(j);
+				snode["flags"] = (int)chan->GetStreamFlags(j);
+				streams.push_back(snode);
+			}
+			cnode["streams"] = streams;
+
+			channels.push_back(cnode);
+		}
+	}
+	doc["channels"] = channels;
+
+	//Then the filters themselves, using the same serialization as session files
+	YAML::Node filters;
+	for(auto f : m_filters)
+		filters.push_back(f->SerializeConfiguration(m_idTable));
+	doc["filters"] = filters;
+
+	auto yaml = YAML::Dump(doc);
+	if(!SendFramed(m_socket, MSG_GRAPH, (const uint8_t*)yaml.c_str(), yaml.length()))
+		return false;
+
+	m_graphDirty = false;
+	return true;
+}
+
+bool RemoteFilterGraphClient::SendChangedInputs()
+{
+	set<InstrumentChannel*> remoteFilters(m_filters.begin(), m_filters.end());
+
+	vector<uint8_t> payload;
+	for(auto f : m_filters)
+	{
+		for(size_t i=0; i<f->GetInputCount(); i++)
+		{
+			auto desc = f->GetInput(i);
+			if(desc.m_channel == nullptr)
+				continue;
+			if(remoteFilters.find(desc.m_channel) != remoteFilters.end())
+				continue;
+
+			auto wfm = desc.GetData();
+			if(wfm == nullptr)
+				continue;
+
+			//Delta check: skip anything the server already has a current copy of
+			auto it = m_sentWaveforms.find(desc);
+			if( (it != m_sentWaveforms.end()) &&
+				(it->second.first == wfm) &&
+				(it->second.second == wfm->m_revision) )
+			{
+				continue;
+			}
+
+			if(!SerializeWaveformMessage(payload, m_idTable.emplace(desc.m_channel), desc.m_stream, wfm))
+			{
+				LogError("Input %s of filter %s cannot be sent to a remote filter graph server\n",
+					f->GetInputName(i).c_str(), f->GetDisplayName().c_str());
+				return false;
+			}
+			if(!SendFramed(m_socket, MSG_WAVEFORM, payload.data(), payload.size()))
+				return false;
+
+			m_sentWaveforms[desc] = pair<WaveformBase*, uint64_t>(wfm, wfm->m_revision);
+		}
+	}
+	return true;
+}
+
+bool RemoteFilterGraphClient::ReceiveResults()
+{
+	while(true)
+	{
+		uint32_t type;
+		vector<uint8_t> payload;
+		if(!RecvFramed(m_socket, type, payload))
+		{
+			LogError("Lost connection to remote filter graph server\n");
+			return false;
+		}
+
+		if(type == MSG_DONE)
+			return true;
+		if(type != MSG_RESULT)
+		{
+			LogError("Unexpected message type %u from remote filter graph server\n", type);
+			return false;
+		}
+
+		RemoteGraphWaveformHeader hdr;
+		auto wfm = DeserializeWaveformMessage(payload, hdr);
+		if(wfm == nullptr)
+			return false;
+
+		//Attach the result to the local filter object
+		Filter* f = nullptr;
+		if(m_idTable.HasID(hdr.m_node))
+			f = dynamic_cast<Filter*>(static_cast<OscilloscopeChannel*>(m_idTable[hdr.m_node]));
+		if( (f == nullptr) || (hdr.m_stream >= f->GetStreamCount()) )
+		{
+			LogError("Remote filter graph server sent a result for an unknown node or stream\n");
+			delete wfm;
+			return false;
+		}
+		f->SetData(wfm, hdr.m_stream);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// RemoteFilterGraphServer construction / destruction
+
+RemoteFilterGraphServer::RemoteFilterGraphServer()
+	: m_listenSocket(AF_INET, SOCK_STREAM, IPPROTO_TCP)
+	, m_quit(false)
+{
+}
+
+RemoteFilterGraphServer::~RemoteFilterGraphServer()
+{
+	ResetSession();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// RemoteFilterGraphServer main loop
+
+/**
+	@brief Accepts and serves client connections, one at a time, until Stop() is called
+
+	Stop() takes effect the next time the current client disconnects (or the next connection is accepted).
+ */
+bool RemoteFilterGraphServer::Run(uint16_t port)
+{
+	if(!m_listenSocket.Bind(port))
+	{
+		LogError("Failed to bind remote filter graph server to port %u\n", (unsigned int)port);
+		return false;
+	}
+	if(!m_listenSocket.Listen())
+	{
+		LogError("Failed to listen on remote filter graph server socket\n");
+		return false;
+	}
+	LogVerbose("Remote filter graph server listening on port %u\n", (unsigned int)port);
+
+	while(!m_quit)
+	{
+		Socket client = m_listenSocket.Accept();
+		if(!client.IsValid())
+			break;
+		client.DisableNagle();
+
+		LogVerbose("Remote filter graph client connected\n");
+		ServeClient(client);
+		LogVerbose("Remote filter graph client disconnected\n");
+
+		ResetSession();
+	}
+	return true;
+}
+
+void RemoteFilterGraphServer::ServeClient(Socket& client)
+{
+	while(!m_quit)
+	{
+		uint32_t type;
+		vector<uint8_t> payload;
+		if(!RecvFramed(client, type, payload))
+			return;
+
+		bool ok;
+		switch(type)
+		{
+			case MSG_GRAPH:
+				ok = OnGraph(payload);
+				break;
+			case MSG_WAVEFORM:
+				ok = OnWaveform(payload);
+				break;
+			case MSG_EXECUTE:
+				ok = OnExecute(client);
+				break;
+			default:
+				LogError("Unexpected message type %u from remote filter graph client\n", type);
+				ok = false;
+				break;
+		}
+
+		//A malformed message leaves the session in an undefined state, so drop the connection
+		if(!ok)
+			return;
+	}
+}
+
+/**
+	@brief Frees all hosted filters and channels at the end of a client session
+ */
+void RemoteFilterGraphServer::ResetSession()
+{
+	//Pin every filter, then detach all inputs, so that dereffing can't cascade into deleting
+	//a filter we're about to delete ourselves
+	for(auto f : m_filters)
+		f->AddRef();
+	for(auto f : m_filters)
+		f->DetachInputs();
+
+	for(auto f : m_filters)
+		delete f;
+	m_filters.clear();
+
+	for(auto c : m_inputChannels)
+		delete c;
+	m_inputChannels.clear();
+
+	m_idTable.clear();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// RemoteFilterGraphServer message handlers
+
+bool RemoteFilterGraphServer::OnGraph(const vector<uint8_t>& payload)
+{
+	//A new graph replaces anything we were hosting before
+	ResetSession();
+
+	YAML::Node doc;
+	try
+	{
+		doc = YAML::Load(string(payload.begin(), payload.end()));
+	}
+	catch(const YAML::Exception& ex)
+	{
+		LogError("Failed to parse remote filter graph description: %s\n", ex.what());
+		return false;
+	}
+
+	//Create placeholder channels for the inputs streamed from the client side
+	for(auto cnode : doc["channels"])
+	{
+		auto chan = new RemoteInputChannel(
+			cnode["name"].as<string>(),
+			cnode["color"].as<string>(),
+			Unit(cnode["xunit"].as<string>()));
+
+		for(auto snode : cnode["streams"])
+		{
+			chan->AddStream(
+				Unit(snode["yunit"].as<string>()),
+				snode["name"].as<string>(),
+				(Stream::StreamType)snode["stype"].as<int>(),
+				(uint8_t)snode["flags"].as<int>());
+		}
+
+		m_inputChannels.push_back(chan);
+		m_idTable.emplace(cnode["id"].as<uint64_t>(), chan);
+	}
+
+	//First pass: instantiate the filters and claim their IDs, so forward references between filters resolve
+	for(auto fnode : doc["filters"])
+	{
+		auto f = Filter::CreateFilter(fnode["protocol"].as<string>(), fnode["color"].as<string>());
+		if(f == nullptr)
+		{
+			LogError("Remote filter graph client requested a filter type we don't have\n");
+			return false;
+		}
+		m_filters.push_back(f);
+		m_idTable.emplace(fnode["id"].as<uint64_t>(), f);
+	}
+
+	//Second pass: load parameters and wire up inputs
+	size_t i = 0;
+	for(auto fnode : doc["filters"])
+	{
+		auto f = m_filters[i ++];
+		f->LoadParameters(fnode, m_idTable);
+		f->LoadInputs(fnode, m_idTable);
+	}
+
+	return true;
+}
+
+bool RemoteFilterGraphServer::OnWaveform(const vector<uint8_t>& payload)
+{
+	RemoteGraphWaveformHeader hdr;
+	auto wfm = DeserializeWaveformMessage(payload, hdr);
+	if(wfm == nullptr)
+		return false;
+
+	if(!m_idTable.HasID(hdr.m_node))
+	{
+		LogError("Remote filter graph client sent a waveform for an unknown node\n");
+		delete wfm;
+		return false;
+	}
+	auto chan = static_cast<OscilloscopeChannel*>(m_idTable[hdr.m_node]);
+	if(hdr.m_stream >= chan->GetStreamCount())
+	{
+		LogError("Remote filter graph client sent a waveform for an unknown stream\n");
+		delete wfm;
+		return false;
+	}
+
+	chan->SetData(wfm, hdr.m_stream);
+	return true;
+}
+
+bool RemoteFilterGraphServer::OnExecute(Socket& client)
+{
+	//Run the hosted graph with all the usual local acceleration
+	set<FlowGraphNode*> nodes(m_filters.begin(), m_filters.end());
+	m_executor.RunBlocking(nodes);
+
+	//Find the terminal filters: anything no other hosted filter consumes is a result the client wants back
+	set<InstrumentChannel*> consumed;
+	for(auto f : m_filters)
+	{
+		for(size_t i=0; i<f->GetInputCount(); i++)
+		{
+			auto chan = f->GetInput(i).m_channel;
+			if(chan != nullptr)
+				consumed.emplace(chan);
+		}
+	}
+
+	vector<uint8_t> payload;
+	for(auto f : m_filters)
+	{
+		if(consumed.find(f) != consumed.end())
+			continue;
+
+		for(size_t i=0; i<f->GetStreamCount(); i++)
+		{
+			auto wfm = f->GetData(i);
+			if(wfm == nullptr)
+				continue;
+
+			if(!SerializeWaveformMessage(payload, m_idTable.emplace(f), i, wfm))
+			{
+				LogWarning("Output %zu of filter %s cannot be sent back to the remote filter graph client\n",
+					i, f->GetDisplayName().c_str());
+				continue;
+			}
+			if(!SendFramed(client, MSG_RESULT, payload.data(), payload.size()))
+				return false;
+		}
+	}
+
+	return SendFramed(client, MSG_DONE);
+}
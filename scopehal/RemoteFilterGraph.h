@@ -0,0 +1,155 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Declaration of RemoteFilterGraphClient and RemoteFilterGraphServer
+ */
+#ifndef RemoteFilterGraph_h
+#define RemoteFilterGraph_h
+
+#include "../xptools/Socket.h"
+
+/**
+	@brief Runs a subgraph of the filter graph in a remote scopehal process
+
+	This is intended for splitting acquisition from analysis: a machine physically near the instruments captures
+	waveforms, while the compute heavy filters run on a remote box with a big GPU. RemoteFilterGraphClient mirrors a
+	set of locally configured Filter objects to a RemoteFilterGraphServer, streams their input waveforms over a TCP
+	socket, executes the graph remotely, and copies the terminal filters' output waveforms back into the local filter
+	objects as if they had run locally.
+
+	Wire protocol: framed messages (RemoteGraphMessageType plus a length), all little endian like the rest of our
+	on-disk formats. Graph topology and filter parameters travel as a YAML document using the same
+	SerializeConfiguration() / LoadParameters() / LoadInputs() machinery as session files, with IDTable IDs naming
+	nodes on both ends. Waveform payloads are sent one column per AcceleratorBuffer, zstd compressed when we're built
+	with zstd support. Unlike WaveformFile we compress each column as a single frame - a streaming link never seeks,
+	so there's no reason to pay the seekable-frame-index overhead.
+
+	Input waveforms are only retransmitted when they change: the client remembers the (pointer, m_revision) pair it
+	last sent for each external input stream and skips streams that still match. In the steady state of a repeating
+	acquisition this means each trigger costs one compressed copy of the new capture and the graph description is
+	never resent, keeping the network link rather than the acquisition machine's GPU as the bottleneck.
+
+	Limitations: only the four basic waveform encodings (uniform/sparse analog/digital) can cross the wire, so
+	filters producing eye patterns, spectrograms, etc. must run locally. Remote filters cannot see the acquisition
+	side's instrument state; anything that calls GetScope() on an input channel has to stay local too.
+ */
+class RemoteFilterGraphClient
+{
+public:
+	RemoteFilterGraphClient();
+	~RemoteFilterGraphClient();
+
+	bool Connect(const std::string& host, uint16_t port);
+	void Disconnect();
+
+	bool IsConnected()
+	{ return m_socket.IsValid(); }
+
+	void AddFilter(Filter* f);
+	void RemoveFilter(Filter* f);
+
+	bool Execute();
+
+	///@brief Default TCP port the server listens on if not otherwise specified
+	static const uint16_t DEFAULT_PORT = 5126;
+
+protected:
+	bool SendGraph();
+	bool SendChangedInputs();
+	bool ReceiveResults();
+
+	///@brief Socket to the remote execution server
+	Socket m_socket;
+
+	///@brief Filters to be executed remotely, in the order they were added
+	std::vector<Filter*> m_filters;
+
+	///@brief IDs shared with the server for filters and external input channels
+	IDTable m_idTable;
+
+	///@brief True if m_filters changed since the graph was last sent (or we reconnected)
+	bool m_graphDirty;
+
+	///@brief Waveform (pointer, revision) last sent for each external input stream
+	std::map<StreamDescriptor, std::pair<WaveformBase*, uint64_t> > m_sentWaveforms;
+};
+
+/**
+	@brief Server side of RemoteFilterGraphClient
+
+	Hosts filters on behalf of a remote client: reconstructs them from the streamed YAML description with
+	Filter::CreateFilter(), parks incoming input waveforms on scope-less placeholder channels, runs the graph through
+	a local FilterGraphExecutor (so all of the usual GPU acceleration, fusion, and scheduling applies), and streams
+	the terminal filters' outputs back.
+
+	Serves one client at a time; Run() accepts connections in a loop until Stop() is called, so a lab setup can
+	leave a server process running on the GPU box indefinitely.
+ */
+class RemoteFilterGraphServer
+{
+public:
+	RemoteFilterGraphServer();
+	~RemoteFilterGraphServer();
+
+	bool Run(uint16_t port = RemoteFilterGraphClient::DEFAULT_PORT);
+
+	void Stop()
+	{ m_quit = true; }
+
+protected:
+	void ServeClient(Socket& client);
+	void ResetSession();
+
+	bool OnGraph(const std::vector<uint8_t>& payload);
+	bool OnWaveform(const std::vector<uint8_t>& payload);
+	bool OnExecute(Socket& client);
+
+	///@brief Listening socket
+	Socket m_listenSocket;
+
+	///@brief Set by Stop() to shut down the accept loop
+	bool m_quit;
+
+	///@brief IDs shared with the client, mapping to our local Filter / channel objects
+	IDTable m_idTable;
+
+	///@brief Filters we're hosting for the client, in the order they were described
+	std::vector<Filter*> m_filters;
+
+	///@brief Placeholder channels holding the client's streamed input waveforms
+	std::vector<OscilloscopeChannel*> m_inputChannels;
+
+	///@brief Executor for running the hosted graph
+	FilterGraphExecutor m_executor;
+};
+
+#endif
@@ -201,6 +201,22 @@ RigolOscilloscope::RigolOscilloscope(SCPITransport* transport)
 		m_transport->SendCommandQueued(":TIM:VERN ON");
 	FlushConfigCache();
 
+	//Prefetch the per-channel settings in one burst so initial UI population doesn't cost a round trip per query
+	for(size_t i = 0; i < m_analogChannelCount; i++)
+	{
+		string chan = m_channels[i]->GetHwname();
+		RegisterSnapshotQuery(":" + chan + ":DISP?");
+		RegisterSnapshotQuery(":" + chan + ":COUP?");
+		RegisterSnapshotQuery(":" + chan + ":PROB?");
+		RegisterSnapshotQuery(":" + chan + ":OFFS?");
+		RegisterSnapshotQuery(chan + ":BWL?");
+		if(m_protocol == DS)
+			RegisterSnapshotQuery(":" + chan + ":RANGE?");
+		else
+			RegisterSnapshotQuery(":" + chan + ":SCALE?");
+	}
+	SnapshotStateCache();
+
 	//make sure all setup commands finish before we proceed
 	m_transport->FlushCommandQueue();
 }
@@ -232,6 +248,9 @@ string RigolOscilloscope::GetDriverNameInternal()
 
 void RigolOscilloscope::FlushConfigCache()
 {
+	//Invalidate the raw reply cache too, so the parsed caches below get repopulated from the hardware
+	InvalidateStateCache();
+
 	lock_guard<recursive_mutex> lock(m_cacheMutex);
 
 	m_channelAttenuations.clear();
@@ -265,7 +284,7 @@ bool RigolOscilloscope::IsChannelEnabled(size_t i)
 			return m_channelsEnabled[i];
 	}
 
-	auto reply = Trim(m_transport->SendCommandQueuedWithReply(":" + m_channels[i]->GetHwname() + ":DISP?"));
+	auto reply = Trim(QueryStateCached(":" + m_channels[i]->GetHwname() + ":DISP?"));
 	if(reply == "0")
 	{
 		lock_guard<recursive_mutex> lock(m_cacheMutex);
@@ -285,6 +304,7 @@ void RigolOscilloscope::EnableChannel(size_t i)
 	m_transport->SendCommandQueued(":" + m_channels[i]->GetHwname() + ":DISP ON");
 	// invalidate channel enable cache until confirmed on next IsChannelEnabled
 	m_channelsEnabled.erase(i);
+	InvalidateStateCache(":" + m_channels[i]->GetHwname() + ":DISP?");
 }
 
 void RigolOscilloscope::DisableChannel(size_t i)
@@ -292,6 +312,7 @@ void RigolOscilloscope::DisableChannel(size_t i)
 	m_transport->SendCommandQueued(":" + m_channels[i]->GetHwname() + ":DISP OFF");
 	// invalidate channel enable cache until confirmed on next IsChannelEnabled
 	m_channelsEnabled.erase(i);
+	InvalidateStateCache(":" + m_channels[i]->GetHwname() + ":DISP?");
 }
 
 vector<OscilloscopeChannel::CouplingType> RigolOscilloscope::GetAvailableCouplings(size_t /*i*/)
@@ -313,7 +334,7 @@ OscilloscopeChannel::CouplingType RigolOscilloscope::GetChannelCoupling(size_t i
 			return m_channelCouplings[i];
 	}
 
-	auto reply = Trim(m_transport->SendCommandQueuedWithReply(":" + m_channels[i]->GetHwname() + ":COUP?"));
+	auto reply = Trim(QueryStateCached(":" + m_channels[i]->GetHwname() + ":COUP?"));
 
 	lock_guard<recursive_mutex> lock(m_cacheMutex);
 	if(reply == "AC")
@@ -349,6 +370,7 @@ void RigolOscilloscope::SetChannelCoupling(size_t i, OscilloscopeChannel::Coupli
 
 	if(valid)
 	{
+		InvalidateStateCache(":" + m_channels[i]->GetHwname() + ":COUP?");
 		lock_guard<recursive_mutex> lock2(m_cacheMutex);
 		m_channelCouplings[i] = type;
 	}
@@ -362,7 +384,7 @@ double RigolOscilloscope::GetChannelAttenuation(size_t i)
 			return m_channelAttenuations[i];
 	}
 
-	auto reply = Trim(m_transport->SendCommandQueuedWithReply(":" + m_channels[i]->GetHwname() + ":PROB?"));
+	auto reply = Trim(QueryStateCached(":" + m_channels[i]->GetHwname() + ":PROB?"));
 
 	double atten;
 	sscanf(reply.c_str(), "%lf", &atten);
@@ -467,6 +489,7 @@ void RigolOscilloscope::SetChannelAttenuation(size_t i, double atten)
 
 	if(valid)
 	{
+		InvalidateStateCache(":" + m_channels[i]->GetHwname() + ":PROB?");
 		lock_guard<recursive_mutex> lock2(m_cacheMutex);
 		m_channelAttenuations[i] = (int)(atten * 10000 + 0.1) * 0.0001;
 	}
@@ -511,7 +534,7 @@ unsigned int RigolOscilloscope::GetChannelBandwidthLimit(size_t i)
 			return m_channelBandwidthLimits[i];
 	}
 
-	auto reply = Trim(m_transport->SendCommandQueuedWithReply(m_channels[i]->GetHwname() + ":BWL?"));
+	auto reply = Trim(QueryStateCached(m_channels[i]->GetHwname() + ":BWL?"));
 
 	lock_guard<recursive_mutex> lock2(m_cacheMutex);
 	if(reply == "20M")
@@ -575,6 +598,7 @@ void RigolOscilloscope::SetChannelBandwidthLimit(size_t i, unsigned int limit_mh
 
 	if(valid)
 	{
+		InvalidateStateCache(m_channels[i]->GetHwname() + ":BWL?");
 		lock_guard<recursive_mutex> lock2(m_cacheMutex);
 		if(limit_mhz == 0)
 			m_channelBandwidthLimits[i] = m_bandwidth;	  // max
@@ -601,9 +625,9 @@ float RigolOscilloscope::GetChannelVoltageRange(size_t i, size_t /*stream*/)
 
 	string reply;
 	if(m_protocol == DS)
-		reply = Trim(m_transport->SendCommandQueuedWithReply(":" + m_channels[i]->GetHwname() + ":RANGE?"));
+		reply = Trim(QueryStateCached(":" + m_channels[i]->GetHwname() + ":RANGE?"));
 	else if(m_protocol == MSO5 || m_protocol == DS_OLD || m_protocol == DHO)
-		reply = Trim(m_transport->SendCommandQueuedWithReply(":" + m_channels[i]->GetHwname() + ":SCALE?"));
+		reply = Trim(QueryStateCached(":" + m_channels[i]->GetHwname() + ":SCALE?"));
 
 	float range;
 	sscanf(reply.c_str(), "%f", &range);
@@ -625,9 +649,15 @@ void RigolOscilloscope::SetChannelVoltageRange(size_t i, size_t /*stream*/, floa
 	}
 
 	if(m_protocol == DS)
+	{
 		m_transport->SendCommandQueued(":" + m_channels[i]->GetHwname() + ":RANGE " + to_string(range));
+		InvalidateStateCache(":" + m_channels[i]->GetHwname() + ":RANGE?");
+	}
 	else if(m_protocol == MSO5 || m_protocol == DS_OLD || m_protocol == DHO)
+	{
 		m_transport->SendCommandQueued(":" + m_channels[i]->GetHwname() + ":SCALE " + to_string(range / 8));
+		InvalidateStateCache(":" + m_channels[i]->GetHwname() + ":SCALE?");
+	}
 }
 
 OscilloscopeChannel* RigolOscilloscope::GetExternalTrigger()
@@ -645,7 +675,7 @@ float RigolOscilloscope::GetChannelOffset(size_t i, size_t /*stream*/)
 			return m_channelOffsets[i];
 	}
 
-	auto reply = Trim(m_transport->SendCommandQueuedWithReply(":" + m_channels[i]->GetHwname() + ":OFFS?"));
+	auto reply = Trim(QueryStateCached(":" + m_channels[i]->GetHwname() + ":OFFS?"));
 
 	float offset;
 	sscanf(reply.c_str(), "%f", &offset);
@@ -658,6 +688,7 @@ float RigolOscilloscope::GetChannelOffset(size_t i, size_t /*stream*/)
 void RigolOscilloscope::SetChannelOffset(size_t i, size_t /*stream*/, float offset)
 {
 	m_transport->SendCommandQueued(":" + m_channels[i]->GetHwname() + ":OFFS " + to_string(offset));
+	InvalidateStateCache(":" + m_channels[i]->GetHwname() + ":OFFS?");
 
 	lock_guard<recursive_mutex> lock(m_cacheMutex);
 	m_channelOffsets[i] = offset;
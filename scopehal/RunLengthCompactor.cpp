@@ -0,0 +1,150 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Implementation of RunLengthCompactor
+ */
+#include "scopehal.h"
+#include "RunLengthCompactor.h"
+
+using namespace std;
+
+namespace
+{
+	///@brief Push constants for the RunLengthDurations shader
+	struct RunLengthDurationsArgs
+	{
+		uint32_t nruns;
+		uint32_t size;
+	};
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Construction / destruction
+
+RunLengthCompactor::RunLengthCompactor()
+	: m_scanPipeline("shaders/RunLengthScan.spv", 3, sizeof(uint32_t))
+	, m_scatterPipeline("shaders/RunLengthScatter.spv", 5, sizeof(uint32_t))
+	, m_durationsPipeline("shaders/RunLengthDurations.spv", 2, sizeof(RunLengthDurationsArgs))
+{
+	m_localScan.SetCpuAccessHint(AcceleratorBuffer<uint32_t>::HINT_NEVER);
+	m_localScan.SetGpuAccessHint(AcceleratorBuffer<uint32_t>::HINT_LIKELY);
+
+	m_blockSums.SetCpuAccessHint(AcceleratorBuffer<uint32_t>::HINT_LIKELY);
+	m_blockSums.SetGpuAccessHint(AcceleratorBuffer<uint32_t>::HINT_LIKELY);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Compaction
+
+/**
+	@brief Converts a dense digital sample buffer into run-length sparse output, entirely on-device
+
+	Output offsets and durations are in input sample ticks (the caller is expected to copy timescale etc from the
+	input waveform). The output waveform is resized to exactly the number of runs and marked as modified from the
+	GPU. Returns false (without touching the output) if the GPU can't run the shaders; callers keep a CPU fallback.
+
+	Synchronizes with the host once mid-pipeline to finish the prefix sum over per-block run counts, then again
+	after the scatter; the command buffer is reusable afterward.
+ */
+bool RunLengthCompactor::CompactDigital(
+	AcceleratorBuffer<bool>& din,
+	size_t len,
+	SparseDigitalWaveform* cap,
+	vk::raii::CommandBuffer& cmdBuf,
+	shared_ptr<QueueHandle> queue)
+{
+	if(!IsAvailable())
+		return false;
+
+	//Shaders index with 32 bit sample positions
+	if(len > 0xffffffff)
+		return false;
+
+	if(len == 0)
+	{
+		cap->Resize(0);
+		cap->MarkModifiedFromCpu();
+		return true;
+	}
+
+	size_t nblocks = GetComputeBlockCount(len, 256);
+	m_localScan.resize(len);
+	m_blockSums.resize(nblocks);
+
+	//First pass: flag run boundaries and scan them within each workgroup
+	cmdBuf.begin({});
+	m_scanPipeline.BindBufferNonblocking(0, din, cmdBuf);
+	m_scanPipeline.BindBufferNonblocking(1, m_localScan, cmdBuf, true);
+	m_scanPipeline.BindBufferNonblocking(2, m_blockSums, cmdBuf, true);
+	m_scanPipeline.Dispatch(cmdBuf, (uint32_t)len, nblocks);
+	cmdBuf.end();
+	queue->SubmitAndBlock(cmdBuf);
+	m_localScan.MarkModifiedFromGpu();
+	m_blockSums.MarkModifiedFromGpu();
+
+	//Finish the scan over the (tiny) per-block totals on the host and size the output exactly
+	m_blockSums.PrepareForCpuAccess();
+	uint32_t nruns = 0;
+	for(size_t i=0; i<nblocks; i++)
+	{
+		uint32_t count = m_blockSums[i];
+		m_blockSums[i] = nruns;
+		nruns += count;
+	}
+	m_blockSums.MarkModifiedFromCpu();
+	cap->Resize(nruns);
+
+	//Second pass: scatter offsets and sample values to their final slots, then derive durations
+	cmdBuf.begin({});
+	m_scatterPipeline.BindBufferNonblocking(0, din, cmdBuf);
+	m_scatterPipeline.BindBufferNonblocking(1, m_localScan, cmdBuf);
+	m_scatterPipeline.BindBufferNonblocking(2, m_blockSums, cmdBuf);
+	m_scatterPipeline.BindBufferNonblocking(3, cap->m_offsets, cmdBuf, true);
+	m_scatterPipeline.BindBufferNonblocking(4, cap->m_samples, cmdBuf, true);
+	m_scatterPipeline.Dispatch(cmdBuf, (uint32_t)len, nblocks);
+	m_scatterPipeline.AddComputeMemoryBarrier(cmdBuf);
+
+	RunLengthDurationsArgs args;
+	args.nruns = nruns;
+	args.size = len;
+	m_durationsPipeline.BindBufferNonblocking(0, cap->m_offsets, cmdBuf);
+	m_durationsPipeline.BindBufferNonblocking(1, cap->m_durations, cmdBuf, true);
+	m_durationsPipeline.Dispatch(cmdBuf, args, GetComputeBlockCount(nruns, 64));
+
+	cmdBuf.end();
+	queue->SubmitAndBlock(cmdBuf);
+
+	cap->m_offsets.MarkModifiedFromGpu();
+	cap->m_durations.MarkModifiedFromGpu();
+	cap->m_samples.MarkModifiedFromGpu();
+	return true;
+}
@@ -0,0 +1,82 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Declaration of RunLengthCompactor
+ */
+#ifndef RunLengthCompactor_h
+#define RunLengthCompactor_h
+
+/**
+	@brief GPU stream compaction of dense digital data into run-length sparse waveforms
+
+	Building a SparseWaveform from dense data on the CPU serializes on push_back into m_offsets / m_durations.
+	This primitive does the conversion on-device with a prefix-sum pipeline: a first dispatch flags run boundaries
+	and scans them within each workgroup, the host finishes the (tiny) scan over per-block totals and sizes the
+	output exactly, then a second dispatch scatters packed offset/sample pairs straight into the SparseWaveform's
+	AcceleratorBuffers and derives durations from adjacent offsets. Samples never round-trip to the CPU.
+
+	Requires 8-bit and 64-bit shader storage plus push descriptors; callers must check IsAvailable() (and
+	g_gpuFilterEnabled if appropriate) and keep a CPU fallback.
+ */
+class RunLengthCompactor
+{
+public:
+	RunLengthCompactor();
+
+	//not copyable or assignable
+	RunLengthCompactor(const RunLengthCompactor&) =delete;
+	RunLengthCompactor& operator=(const RunLengthCompactor&) =delete;
+
+	///@brief Checks if the GPU supports the shaders this primitive needs
+	static bool IsAvailable()
+	{ return g_hasShaderInt8 && g_hasShaderInt64 && g_hasPushDescriptor; }
+
+	bool CompactDigital(
+		AcceleratorBuffer<bool>& din,
+		size_t len,
+		SparseDigitalWaveform* cap,
+		vk::raii::CommandBuffer& cmdBuf,
+		std::shared_ptr<QueueHandle> queue);
+
+protected:
+	ComputePipeline m_scanPipeline;
+	ComputePipeline m_scatterPipeline;
+	ComputePipeline m_durationsPipeline;
+
+	///@brief Per-sample exclusive scan of run boundary flags, within each workgroup's block
+	AcceleratorBuffer<uint32_t> m_localScan;
+
+	///@brief Per-block boundary counts, overwritten in place by their host-side exclusive scan
+	AcceleratorBuffer<uint32_t> m_blockSums;
+};
+
+#endif
@@ -29,13 +29,74 @@
 
 #include "scopehal.h"
 
+#include <fstream>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <shlwapi.h>
+#include <shlobj.h>
+#endif
+
 using namespace std;
 
+namespace
+{
+	///@brief Returns the directory warm state files live in, creating it if needed (same location as the pipeline cache)
+	string GetWarmStateDir()
+	{
+	#ifdef _WIN32
+		wchar_t* stem;
+		if(S_OK != SHGetKnownFolderPath(
+			FOLDERID_RoamingAppData,
+			KF_FLAG_CREATE,
+			NULL,
+			&stem))
+		{
+			throw std::runtime_error("failed to resolve %appdata%");
+		}
+
+		wchar_t directory[MAX_PATH];
+		if(NULL == PathCombineW(directory, stem, L"ngscopeclient"))
+		{
+			throw runtime_error("failed to build directory path");
+		}
+
+		const auto result = CreateDirectoryW(directory, NULL);
+		if(!result && GetLastError() != ERROR_ALREADY_EXISTS)
+		{
+			throw runtime_error("failed to create preferences directory");
+		}
+
+		CoTaskMemFree(static_cast<void*>(stem));
+		return NarrowPath(directory) + "\\";
+	#else
+		CreateDirectory("~/.cache");
+		CreateDirectory("~/.cache/ngscopeclient");
+		return ExpandPath("~/.cache/ngscopeclient") + "/";
+	#endif
+	}
+
+	///@brief Makes an identity string safe to embed in a file name
+	string SanitizeForFilename(const string& in)
+	{
+		string ret;
+		for(char c : in)
+		{
+			if(isalnum((unsigned char)c) || (c == '-') || (c == '_') || (c == '.'))
+				ret += c;
+			else
+				ret += '_';
+		}
+		return ret;
+	}
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Construction / destruction
 
 SCPIInstrument::SCPIInstrument(SCPITransport* transport, bool identify)
 	: SCPIDevice(transport, identify)
+	, m_stateCacheGeneration(0)
 {
 	m_serializers.push_back(sigc::mem_fun(*this, &SCPIInstrument::DoSerializeConfiguration));
 }
@@ -73,6 +134,197 @@ string SCPIInstrument::GetSerial() const
 	return m_serial;
 }
 
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// State cache
+
+/**
+	@brief Registers a query to be fetched by the next SnapshotStateCache() call
+ */
+void SCPIInstrument::RegisterSnapshotQuery(const string& query)
+{
+	lock_guard<recursive_mutex> lock(m_stateCacheMutex);
+	m_snapshotQueries.push_back(query);
+}
+
+/**
+	@brief Fetches all registered snapshot queries in one pipelined burst and caches the replies
+
+	On transports that support batching, every query is sent before any reply is read, so the whole snapshot costs
+	roughly one round trip rather than one per query. Intended to be called once at the end of a driver's constructor
+	(and again after reconnecting) so the QueryStateCached() calls made while the UI populates all hit the cache.
+ */
+void SCPIInstrument::SnapshotStateCache()
+{
+	//Copy the query list so we don't hold the cache mutex during network I/O
+	vector<string> queries;
+	{
+		lock_guard<recursive_mutex> lock(m_stateCacheMutex);
+		queries = m_snapshotQueries;
+	}
+	if(queries.empty())
+		return;
+
+	vector<string> replies;
+	if(m_transport->IsCommandBatchingSupported())
+	{
+		lock_guard<recursive_mutex> lock(m_transport->GetMutex());
+
+		//Anything already queued has to go out first so our replies come back in order
+		m_transport->FlushCommandQueue();
+
+		for(auto& q : queries)
+			m_transport->SendCommandImmediate(q);
+		for(size_t i=0; i<queries.size(); i++)
+			replies.push_back(m_transport->ReadReply());
+	}
+
+	//Transport can't pipeline (e.g. VXI-11), fall back to one round trip per query
+	else
+	{
+		for(auto& q : queries)
+			replies.push_back(m_transport->SendCommandImmediateWithReply(q));
+	}
+
+	lock_guard<recursive_mutex> lock(m_stateCacheMutex);
+	for(size_t i=0; i<queries.size(); i++)
+		m_stateCache[queries[i]] = CachedReply{replies[i], m_stateCacheGeneration};
+}
+
+/**
+	@brief Sends a query, caching the raw reply
+
+	Repeated calls with the same query string return the cached reply without touching the instrument until the cache
+	is invalidated. The unparsed reply is cached, so a single entry can back several driver-side parsed caches.
+ */
+string SCPIInstrument::QueryStateCached(const string& query)
+{
+	{
+		lock_guard<recursive_mutex> lock(m_stateCacheMutex);
+		auto it = m_stateCache.find(query);
+		if( (it != m_stateCache.end()) && (it->second.m_generation == m_stateCacheGeneration) )
+			return it->second.m_value;
+	}
+
+	auto reply = m_transport->SendCommandQueuedWithReply(query);
+
+	lock_guard<recursive_mutex> lock(m_stateCacheMutex);
+	m_stateCache[query] = CachedReply{reply, m_stateCacheGeneration};
+	return reply;
+}
+
+/**
+	@brief Invalidates the entire state cache in O(1) by bumping the generation counter
+
+	Stale entries are overwritten in place the next time their query is issued. Drivers should call this from
+	FlushConfigCache() so a flush really does re-read the hardware.
+ */
+void SCPIInstrument::InvalidateStateCache()
+{
+	lock_guard<recursive_mutex> lock(m_stateCacheMutex);
+	m_stateCacheGeneration ++;
+}
+
+/**
+	@brief Invalidates the cache entry for a single query (typically called after writing the matching setting)
+ */
+void SCPIInstrument::InvalidateStateCache(const string& query)
+{
+	lock_guard<recursive_mutex> lock(m_stateCacheMutex);
+	m_stateCache.erase(query);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Warm state file
+
+/**
+	@brief Returns the path of this instrument's warm state file, keyed by driver name and serial number
+ */
+string SCPIInstrument::GetWarmStateCachePath()
+{
+	return GetWarmStateDir() + "warmstate_" + SanitizeForFilename(GetDriverName()) + "_" +
+		SanitizeForFilename(m_serial) + ".yml";
+}
+
+/**
+	@brief Serializes the currently valid state cache entries to disk
+
+	A daemon should call this once its driver has finished probing (typically right after construction), so the
+	next restart can skip the probe via LoadStateCacheFromDisk().
+ */
+void SCPIInstrument::SaveStateCacheToDisk()
+{
+	YAML::Node node;
+	node["vendor"] = m_vendor;
+	node["model"] = m_model;
+	node["serial"] = m_serial;
+	node["fwVersion"] = m_fwVersion;
+
+	YAML::Node state;
+	{
+		lock_guard<recursive_mutex> lock(m_stateCacheMutex);
+		for(auto& it : m_stateCache)
+		{
+			if(it.second.m_generation == m_stateCacheGeneration)
+				state[it.first] = it.second.m_value;
+		}
+	}
+	node["state"] = state;
+
+	auto path = GetWarmStateCachePath();
+	ofstream outfs(path);
+	if(!outfs)
+	{
+		LogWarning("Couldn't open warm state file %s for writing\n", path.c_str());
+		return;
+	}
+	outfs << node;
+}
+
+/**
+	@brief Populates the state cache from a previous session's warm state file
+
+	Only loads if vendor, model, serial, and firmware version all match the connected instrument, so a firmware
+	update or a swapped unit forces a fresh probe. Returns true if the cache was populated.
+
+	Loaded entries go stale the same way live ones do: InvalidateStateCache() discards them, and any setting
+	changed through the driver overwrites its entry. State changed from the instrument's front panel while we
+	were down is NOT detected; daemons that can't rule that out should invalidate after loading anything
+	correctness-critical.
+ */
+bool SCPIInstrument::LoadStateCacheFromDisk()
+{
+	YAML::Node node;
+	try
+	{
+		node = YAML::LoadFile(GetWarmStateCachePath());
+	}
+	catch(const exception&)
+	{
+		return false;
+	}
+	if(!node)
+		return false;
+
+	//Identity must match exactly
+	if(node["vendor"].as<string>("") != m_vendor)
+		return false;
+	if(node["model"].as<string>("") != m_model)
+		return false;
+	if(node["serial"].as<string>("") != m_serial)
+		return false;
+	if(node["fwVersion"].as<string>("") != m_fwVersion)
+		return false;
+
+	auto state = node["state"];
+	if(!state)
+		return false;
+
+	lock_guard<recursive_mutex> lock(m_stateCacheMutex);
+	for(auto it : state)
+		m_stateCache[it.first.as<string>()] = CachedReply{it.second.as<string>(), m_stateCacheGeneration};
+	return true;
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Serialization
 
@@ -48,8 +48,40 @@ public:
 	virtual std::string GetSerial() const;
 	virtual std::string GetDriverName() const =0;
 
+	//Instrument state cache
+	std::string QueryStateCached(const std::string& query);
+	void RegisterSnapshotQuery(const std::string& query);
+	void SnapshotStateCache();
+	void InvalidateStateCache();
+	void InvalidateStateCache(const std::string& query);
+
+	//Warm state file (serialized state cache, so a restarted daemon skips capability re-probing)
+	bool LoadStateCacheFromDisk();
+	void SaveStateCacheToDisk();
+
 protected:
 	void DoSerializeConfiguration(YAML::Node& node, IDTable& table);
+
+	std::string GetWarmStateCachePath();
+
+	///@brief One cached raw SCPI reply, valid only while its generation matches m_stateCacheGeneration
+	struct CachedReply
+	{
+		std::string m_value;
+		uint64_t m_generation;
+	};
+
+	///@brief Mutex protecting the state cache
+	std::recursive_mutex m_stateCacheMutex;
+
+	///@brief Cached replies, keyed by the exact query string that produced them
+	std::map<std::string, CachedReply> m_stateCache;
+
+	///@brief Current cache generation (bumped to invalidate every entry at once)
+	uint64_t m_stateCacheGeneration;
+
+	///@brief Queries fetched in bulk by SnapshotStateCache()
+	std::vector<std::string> m_snapshotQueries;
 };
 
 #endif
@@ -74,6 +74,8 @@ SCPILinuxGPIBTransport::SCPILinuxGPIBTransport(const string& args)
 
 SCPILinuxGPIBTransport::~SCPILinuxGPIBTransport()
 {
+	ShutdownFlusher();
+
 	if (IsConnected())
 		ibonl(m_handle, 0);
 
@@ -103,6 +103,8 @@ SCPILxiTransport::SCPILxiTransport(const string& args)
 
 SCPILxiTransport::~SCPILxiTransport()
 {
+	ShutdownFlusher();
+
 	delete[] m_staging_buf;
 }
 
@@ -171,6 +173,7 @@ void SCPILxiTransport::SendRawData(size_t len, const unsigned char* buf)
 	//Need the cast when using liblxi versions prior to 63ea109 because they don't have "const" on the argument.
 	//It doesn't actually change the inputs, so safe to cast.
 	lxi_send(m_device, const_cast<char*>(reinterpret_cast<const char*>(buf)), len, m_timeout);
+	CountTxBytes(len);
 }
 
 size_t SCPILxiTransport::ReadRawData(size_t len, unsigned char* buf)
@@ -214,6 +217,7 @@ size_t SCPILxiTransport::ReadRawData(size_t len, unsigned char* buf)
 		return 0;
 	}
 
+	CountRxBytes(len);
 	return len;
 }
 
@@ -51,7 +51,7 @@ SCPINullTransport::SCPINullTransport(const string& args)
 
 SCPINullTransport::~SCPINullTransport()
 {
-
+	ShutdownFlusher();
 }
 
 bool SCPINullTransport::IsConnected()
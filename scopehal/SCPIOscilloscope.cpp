@@ -52,3 +52,36 @@ string SCPIOscilloscope::IDPing()
 	m_transport->SendCommand("*IDN?");
 	return m_transport->ReadReply();
 }
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Batch acquisition
+
+/**
+	@brief Issues a set of waveform pull queries as a single pipelined burst, then reads the replies back to back
+
+	All of the commands are queued and flushed in one go, so the full network round trip is paid once per batch rather
+	than once per channel. The reader callback is then invoked once per command, in order, and must consume exactly
+	the reply produced by its command (typically a block read plus any trailing terminator bytes).
+
+	The transport mutex is held for the duration of the batch so that no other thread can interleave traffic between
+	our queries and their replies.
+
+	@param commands		Queries to issue, in order
+	@param reader		Callback invoked with the index of each command once its reply is ready to be read
+ */
+void SCPIOscilloscope::BatchPull(const vector<string>& commands, function<void(size_t)> reader)
+{
+	if(commands.empty())
+		return;
+
+	lock_guard<recursive_mutex> lock(m_transport->GetMutex());
+
+	//Send every query up front in a single burst
+	for(auto& cmd : commands)
+		m_transport->SendCommandQueued(cmd);
+	m_transport->FlushCommandQueue();
+
+	//Then drain the replies back to back
+	for(size_t i=0; i<commands.size(); i++)
+		reader(i);
+}
@@ -30,6 +30,8 @@
 #ifndef SCPIOscilloscope_h
 #define SCPIOscilloscope_h
 
+#include <functional>
+
 /**
 	@brief An SCPI-based oscilloscope
  */
@@ -43,6 +45,8 @@ public:
 	virtual std::string IDPing();
 
 protected:
+	void BatchPull(const std::vector<std::string>& commands, std::function<void(size_t)> reader);
+
 	bool m_triggerArmed;
 	bool m_triggerOneShot;
 
@@ -0,0 +1,184 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Implementation of SCPIRecordTransport
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "scopehal.h"
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Construction / destruction
+
+SCPIRecordTransport::SCPIRecordTransport(const string& args)
+	: m_args(args)
+	, m_inner(nullptr)
+	, m_logFile(nullptr)
+	, m_startTime(GetTime())
+{
+	//Split off the log file name and the inner transport name; the rest is the inner transport's args
+	//(which may themselves contain colons, e.g. host:port)
+	auto nfile = args.find(':');
+	auto ntransport = (nfile == string::npos) ? string::npos : args.find(':', nfile + 1);
+	if(ntransport == string::npos)
+	{
+		LogError("SCPIRecordTransport expected arguments of the form logfile:transport:args, got \"%s\"\n",
+			args.c_str());
+		return;
+	}
+
+	auto fname = args.substr(0, nfile);
+	auto transport = args.substr(nfile + 1, ntransport - nfile - 1);
+	auto innerArgs = args.substr(ntransport + 1);
+
+	m_inner = SCPITransport::CreateTransport(transport, innerArgs);
+	if(!m_inner)
+	{
+		LogError("SCPIRecordTransport: failed to create inner transport \"%s\"\n", transport.c_str());
+		return;
+	}
+
+	m_logFile = fopen(fname.c_str(), "wb");
+	if(!m_logFile)
+	{
+		LogError("SCPIRecordTransport: failed to open log file \"%s\"\n", fname.c_str());
+		return;
+	}
+
+	fwrite(GetLogMagic(), 1, 8, m_logFile);
+	uint32_t version = LOG_VERSION;
+	fwrite(&version, sizeof(version), 1, m_logFile);
+}
+
+SCPIRecordTransport::~SCPIRecordTransport()
+{
+	ShutdownFlusher();
+
+	if(m_logFile)
+		fclose(m_logFile);
+	if(m_inner)
+		delete m_inner;
+}
+
+bool SCPIRecordTransport::IsConnected()
+{
+	return m_inner && m_inner->IsConnected();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Actual transport code
+
+string SCPIRecordTransport::GetTransportName()
+{
+	return "record";
+}
+
+string SCPIRecordTransport::GetConnectionString()
+{
+	return m_args;
+}
+
+/**
+	@brief Appends one event to the log
+ */
+void SCPIRecordTransport::LogEvent(LogEventType type, const unsigned char* data, size_t len)
+{
+	if(!m_logFile)
+		return;
+
+	lock_guard<mutex> lock(m_logMutex);
+
+	uint8_t t = type;
+	uint64_t tstamp = (uint64_t)( (GetTime() - m_startTime) * 1e9 );
+	uint64_t length = len;
+	fwrite(&t, sizeof(t), 1, m_logFile);
+	fwrite(&tstamp, sizeof(tstamp), 1, m_logFile);
+	fwrite(&length, sizeof(length), 1, m_logFile);
+	if(len)
+		fwrite(data, 1, len, m_logFile);
+}
+
+void SCPIRecordTransport::FlushRXBuffer()
+{
+	if(m_inner)
+		m_inner->FlushRXBuffer();
+}
+
+bool SCPIRecordTransport::SendCommand(const string& cmd)
+{
+	if(!m_inner)
+		return false;
+
+	bool ok = m_inner->SendCommand(cmd);
+	LogEvent(EVENT_COMMAND, reinterpret_cast<const unsigned char*>(cmd.c_str()), cmd.length());
+	return ok;
+}
+
+string SCPIRecordTransport::ReadReply(bool endOnSemicolon)
+{
+	if(!m_inner)
+		return "";
+
+	auto reply = m_inner->ReadReply(endOnSemicolon);
+	LogEvent(EVENT_REPLY, reinterpret_cast<const unsigned char*>(reply.c_str()), reply.length());
+	return reply;
+}
+
+void SCPIRecordTransport::SendRawData(size_t len, const unsigned char* buf)
+{
+	if(!m_inner)
+		return;
+
+	m_inner->SendRawData(len, buf);
+	LogEvent(EVENT_RAW_WRITE, buf, len);
+}
+
+size_t SCPIRecordTransport::ReadRawData(size_t len, unsigned char* buf)
+{
+	if(!m_inner)
+		return 0;
+
+	//Log what was actually read, not what was asked for
+	size_t nread = m_inner->ReadRawData(len, buf);
+	LogEvent(EVENT_RAW_READ, buf, nread);
+	return nread;
+}
+
+bool SCPIRecordTransport::IsCommandBatchingSupported()
+{
+	return m_inner && m_inner->IsCommandBatchingSupported();
+}
@@ -0,0 +1,104 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Declaration of SCPIRecordTransport
+ */
+
+#ifndef SCPIRecordTransport_h
+#define SCPIRecordTransport_h
+
+/**
+	@brief Pass-through SCPITransport that records a live session's traffic to a log for later replay
+
+	Wraps any other transport and captures every command, reply and raw block (with nanosecond timestamps
+	relative to the start of the session) to a compact binary log that SCPIReplayTransport can play back.
+	Connection string: recordfile:innertransport:innerargs, e.g.
+
+		record:session.scpilog:lan:192.168.1.1:5025
+
+	Recording a session against real hardware once, then replaying it at original or accelerated speed, gives
+	deterministic wire-rate input for benchmarking driver AcquireData changes without racking an instrument.
+ */
+class SCPIRecordTransport : public SCPITransport
+{
+public:
+	SCPIRecordTransport(const std::string& args);
+	virtual ~SCPIRecordTransport();
+
+	virtual std::string GetConnectionString() override;
+	static std::string GetTransportName();
+
+	virtual void FlushRXBuffer() override;
+	virtual bool SendCommand(const std::string& cmd) override;
+	virtual std::string ReadReply(bool endOnSemicolon = true) override;
+	virtual size_t ReadRawData(size_t len, unsigned char* buf) override;
+	virtual void SendRawData(size_t len, const unsigned char* buf) override;
+
+	virtual bool IsCommandBatchingSupported() override;
+	virtual bool IsConnected() override;
+
+	///@brief Log file magic, followed by a uint32 version number
+	static const char* GetLogMagic()
+	{ return "SCPILOG\n"; }
+
+	///@brief Log file format version
+	static const uint32_t LOG_VERSION = 1;
+
+	///@brief Type codes for logged events (each record is type, uint64 timestamp in ns, uint64 length, payload)
+	enum LogEventType : uint8_t
+	{
+		EVENT_COMMAND	= 0,	//SendCommand(), payload is the command string
+		EVENT_REPLY		= 1,	//ReadReply(), payload is the reply string
+		EVENT_RAW_READ	= 2,	//ReadRawData(), payload is the data read
+		EVENT_RAW_WRITE	= 3		//SendRawData(), payload is the data written
+	};
+
+	TRANSPORT_INITPROC(SCPIRecordTransport)
+
+protected:
+	void LogEvent(LogEventType type, const unsigned char* data, size_t len);
+
+	std::string m_args;
+
+	///@brief The transport doing the actual I/O
+	SCPITransport* m_inner;
+
+	FILE* m_logFile;
+
+	///@brief Wallclock time the session started (event timestamps are relative to this)
+	double m_startTime;
+
+	///@brief Serializes log writes (the inner transport provides its own net-level locking)
+	std::mutex m_logMutex;
+};
+
+#endif
@@ -0,0 +1,242 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Implementation of SCPIReplayTransport
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "scopehal.h"
+#include "SCPIRecordTransport.h"
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Construction / destruction
+
+SCPIReplayTransport::SCPIReplayTransport(const string& args)
+	: m_args(args)
+	, m_cursor(0)
+	, m_speed(1)
+	, m_replayStart(0)
+{
+	//An optional rate multiplier follows the file name; anything after the last colon that parses as a
+	//number is treated as one (log file names with colons in them are your own fault)
+	auto fname = args;
+	auto nsplit = args.rfind(':');
+	if(nsplit != string::npos)
+	{
+		char* end = nullptr;
+		auto tail = args.substr(nsplit + 1);
+		double speed = strtod(tail.c_str(), &end);
+		if(end && (*end == '\0') && !tail.empty())
+		{
+			m_speed = speed;
+			fname = args.substr(0, nsplit);
+		}
+	}
+
+	FILE* fp = fopen(fname.c_str(), "rb");
+	if(!fp)
+	{
+		LogError("SCPIReplayTransport: failed to open log file \"%s\"\n", fname.c_str());
+		return;
+	}
+
+	//Validate the header
+	char magic[8] = {0};
+	uint32_t version = 0;
+	if( (fread(magic, 1, 8, fp) != 8) ||
+		(memcmp(magic, SCPIRecordTransport::GetLogMagic(), 8) != 0) ||
+		(fread(&version, sizeof(version), 1, fp) != 1) ||
+		(version != SCPIRecordTransport::LOG_VERSION) )
+	{
+		LogError("SCPIReplayTransport: \"%s\" is not a version %u SCPI session log\n",
+			fname.c_str(), SCPIRecordTransport::LOG_VERSION);
+		fclose(fp);
+		return;
+	}
+
+	//Preload the whole session so replay throughput is bounded by the driver under test, not the disk
+	while(true)
+	{
+		ReplayEvent ev;
+		uint64_t length;
+		if(fread(&ev.m_type, sizeof(ev.m_type), 1, fp) != 1)
+			break;
+		if( (fread(&ev.m_timestamp, sizeof(ev.m_timestamp), 1, fp) != 1) ||
+			(fread(&length, sizeof(length), 1, fp) != 1) )
+		{
+			LogWarning("SCPIReplayTransport: log file \"%s\" is truncated\n", fname.c_str());
+			break;
+		}
+		ev.m_data.resize(length);
+		if(length && (fread(&ev.m_data[0], 1, length, fp) != length) )
+		{
+			LogWarning("SCPIReplayTransport: log file \"%s\" is truncated\n", fname.c_str());
+			break;
+		}
+		m_events.push_back(std::move(ev));
+	}
+
+	fclose(fp);
+}
+
+SCPIReplayTransport::~SCPIReplayTransport()
+{
+	ShutdownFlusher();
+}
+
+bool SCPIReplayTransport::IsConnected()
+{
+	return !m_events.empty();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Replay machinery
+
+string SCPIReplayTransport::GetTransportName()
+{
+	return "replay";
+}
+
+string SCPIReplayTransport::GetConnectionString()
+{
+	return m_args;
+}
+
+/**
+	@brief Sleeps until the recorded timestamp (scaled by the rate multiplier) comes due
+ */
+void SCPIReplayTransport::WaitForTimestamp(uint64_t tstamp)
+{
+	if(m_speed <= 0)
+		return;
+
+	if(m_replayStart == 0)
+		m_replayStart = GetTime();
+
+	double target = m_replayStart + (tstamp * 1e-9) / m_speed;
+	double now = GetTime();
+	if(now < target)
+		this_thread::sleep_for(chrono::duration<double>(target - now));
+}
+
+/**
+	@brief Advances the cursor to the next event of the requested type and paces to its timestamp
+
+	Normally that's simply the next event in the log; skipping anything is a divergence between the recorded
+	and replayed sessions and gets warned about. Returns null at end of log. Caller must hold m_replayMutex.
+ */
+const SCPIReplayTransport::ReplayEvent* SCPIReplayTransport::NextEvent(uint8_t type)
+{
+	size_t i = m_cursor;
+	while( (i < m_events.size()) && (m_events[i].m_type != type) )
+		i ++;
+
+	if(i >= m_events.size())
+	{
+		LogWarning("SCPIReplayTransport: end of log reached (replayed session ran past the recorded one)\n");
+		return nullptr;
+	}
+
+	if(i != m_cursor)
+	{
+		LogWarning("SCPIReplayTransport: replayed session diverged from the log (skipped %zu event(s))\n",
+			i - m_cursor);
+	}
+
+	m_cursor = i + 1;
+	WaitForTimestamp(m_events[i].m_timestamp);
+	return &m_events[i];
+}
+
+bool SCPIReplayTransport::SendCommand(const string& cmd)
+{
+	lock_guard<mutex> lock(m_replayMutex);
+
+	auto ev = NextEvent(SCPIRecordTransport::EVENT_COMMAND);
+	if(!ev)
+		return false;
+
+	string logged(ev->m_data.begin(), ev->m_data.end());
+	if(logged != cmd)
+	{
+		LogWarning("SCPIReplayTransport: sent command \"%s\" does not match logged command \"%s\"\n",
+			cmd.c_str(), logged.c_str());
+	}
+	return true;
+}
+
+string SCPIReplayTransport::ReadReply(bool /*endOnSemicolon*/)
+{
+	lock_guard<mutex> lock(m_replayMutex);
+
+	auto ev = NextEvent(SCPIRecordTransport::EVENT_REPLY);
+	if(!ev)
+		return "";
+	return string(ev->m_data.begin(), ev->m_data.end());
+}
+
+void SCPIReplayTransport::SendRawData(size_t /*len*/, const unsigned char* /*buf*/)
+{
+	lock_guard<mutex> lock(m_replayMutex);
+	NextEvent(SCPIRecordTransport::EVENT_RAW_WRITE);
+}
+
+size_t SCPIReplayTransport::ReadRawData(size_t len, unsigned char* buf)
+{
+	lock_guard<mutex> lock(m_replayMutex);
+
+	auto ev = NextEvent(SCPIRecordTransport::EVENT_RAW_READ);
+	if(!ev)
+		return 0;
+
+	if(ev->m_data.size() != len)
+	{
+		LogWarning("SCPIReplayTransport: replayed session asked for %zu bytes but the log has %zu\n",
+			len, ev->m_data.size());
+	}
+
+	size_t nread = min(len, ev->m_data.size());
+	if(nread)
+		memcpy(buf, &ev->m_data[0], nread);
+	CountRxBytes(nread);
+	return nread;
+}
+
+bool SCPIReplayTransport::IsCommandBatchingSupported()
+{
+	return false;
+}
@@ -0,0 +1,107 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Declaration of SCPIReplayTransport
+ */
+
+#ifndef SCPIReplayTransport_h
+#define SCPIReplayTransport_h
+
+/**
+	@brief SCPITransport that replays a session recorded by SCPIRecordTransport
+
+	Connection string: replayfile[:speed], where speed is a playback rate multiplier: 1 (the default) paces
+	events at the original inter-event intervals, larger values run proportionally faster and 0 replays with
+	no pacing at all (as fast as the driver can consume data).
+
+	The whole log is preloaded into RAM at connect time, so replay throughput is bounded by the driver under
+	test rather than disk - deterministic input for benchmarking AcquireData changes and catching throughput
+	regressions in CI with no instrument attached.
+
+	Replay is positional: commands sent by the driver are matched against the log in order, and a mismatch
+	logs a warning and resynchronizes to the next event of the expected type. This tolerates small divergences
+	(e.g. an added settings query) but a substantially changed command sequence needs a fresh recording.
+ */
+class SCPIReplayTransport : public SCPITransport
+{
+public:
+	SCPIReplayTransport(const std::string& args);
+	virtual ~SCPIReplayTransport();
+
+	virtual std::string GetConnectionString() override;
+	static std::string GetTransportName();
+
+	virtual bool SendCommand(const std::string& cmd) override;
+	virtual std::string ReadReply(bool endOnSemicolon = true) override;
+	virtual size_t ReadRawData(size_t len, unsigned char* buf) override;
+	virtual void SendRawData(size_t len, const unsigned char* buf) override;
+
+	virtual bool IsCommandBatchingSupported() override;
+	virtual bool IsConnected() override;
+
+	TRANSPORT_INITPROC(SCPIReplayTransport)
+
+protected:
+
+	///@brief One event from the log
+	struct ReplayEvent
+	{
+		uint8_t m_type;
+
+		///@brief Nanoseconds since the start of the recorded session
+		uint64_t m_timestamp;
+
+		std::vector<unsigned char> m_data;
+	};
+
+	const ReplayEvent* NextEvent(uint8_t type);
+	void WaitForTimestamp(uint64_t tstamp);
+
+	std::string m_args;
+
+	///@brief The preloaded log
+	std::vector<ReplayEvent> m_events;
+
+	///@brief Index of the next event to replay
+	size_t m_cursor;
+
+	///@brief Playback rate multiplier (0 = no pacing)
+	double m_speed;
+
+	///@brief Wallclock time replay started (lazily set by the first event)
+	double m_replayStart;
+
+	///@brief Serializes replay state (the immediate-command API can be hit from several threads)
+	std::mutex m_replayMutex;
+};
+
+#endif
@@ -0,0 +1,253 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Implementation of SCPIShmTransport
+ */
+
+#include "scopehal.h"
+
+#ifndef _WIN32
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace std;
+
+namespace
+{
+	///@brief Expected value of SegmentHeader::m_magic ("SHMB")
+	const uint32_t SHM_MAGIC = 0x424d4853;
+
+	///@brief Supported segment layout version
+	const uint32_t SHM_VERSION = 1;
+
+	///@brief Offset of the first ring's data area from the start of the segment
+	const size_t SHM_DATA_OFFSET = 4096;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Construction / destruction
+
+SCPIShmTransport::SCPIShmTransport(const string& args)
+	: SCPISocketTransport(args)
+	, m_shmName("/scopehal-bridge")
+	, m_hdr(nullptr)
+	, m_rxData(nullptr)
+	, m_txData(nullptr)
+	, m_mappedSize(0)
+{
+	//Shared memory name is the third colon-separated field, if present
+	char hostname[128];
+	unsigned int port;
+	char name[128];
+	if(3 == sscanf(args.c_str(), "%127[^:]:%u:%127s", hostname, &port, name))
+		m_shmName = name;
+
+	//Map the segment the bridge daemon created
+	int fd = shm_open(m_shmName.c_str(), O_RDWR, 0);
+	if(fd < 0)
+	{
+		LogError("SCPIShmTransport: couldn't open shared memory segment %s (is the bridge running with shm support?)\n",
+			m_shmName.c_str());
+		return;
+	}
+
+	struct stat st;
+	if(0 != fstat(fd, &st))
+	{
+		LogError("SCPIShmTransport: couldn't stat shared memory segment %s\n", m_shmName.c_str());
+		close(fd);
+		return;
+	}
+	m_mappedSize = st.st_size;
+
+	void* base = mmap(nullptr, m_mappedSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if(base == MAP_FAILED)
+	{
+		LogError("SCPIShmTransport: couldn't map shared memory segment %s\n", m_shmName.c_str());
+		m_mappedSize = 0;
+		return;
+	}
+
+	//Sanity check the header before touching the rings
+	auto hdr = reinterpret_cast<SegmentHeader*>(base);
+	bool rxSizeValid = (hdr->m_rxSize != 0) && ((hdr->m_rxSize & (hdr->m_rxSize - 1)) == 0);
+	bool txSizeValid = (hdr->m_txSize != 0) && ((hdr->m_txSize & (hdr->m_txSize - 1)) == 0);
+	if( (hdr->m_magic != SHM_MAGIC) ||
+		(hdr->m_version != SHM_VERSION) ||
+		!rxSizeValid ||
+		!txSizeValid ||
+		(SHM_DATA_OFFSET + hdr->m_rxSize + hdr->m_txSize > m_mappedSize) )
+	{
+		LogError("SCPIShmTransport: shared memory segment %s has a bad or incompatible header\n", m_shmName.c_str());
+		munmap(base, m_mappedSize);
+		m_mappedSize = 0;
+		return;
+	}
+
+	m_hdr = hdr;
+	m_rxData = reinterpret_cast<uint8_t*>(base) + SHM_DATA_OFFSET;
+	m_txData = m_rxData + hdr->m_rxSize;
+
+	LogDebug("Mapped bridge shared memory segment %s (%zu kB rx, %zu kB tx)\n",
+		m_shmName.c_str(),
+		(size_t)(hdr->m_rxSize / 1024),
+		(size_t)(hdr->m_txSize / 1024));
+}
+
+SCPIShmTransport::~SCPIShmTransport()
+{
+	ShutdownFlusher();
+
+	if(m_hdr)
+		munmap(m_hdr, m_mappedSize);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Discovery
+
+string SCPIShmTransport::GetTransportName()
+{
+	return "shm";
+}
+
+string SCPIShmTransport::GetConnectionString()
+{
+	char tmp[256];
+	snprintf(tmp, sizeof(tmp), "%s:%u:%s", m_hostname.c_str(), m_port, m_shmName.c_str());
+	return string(tmp);
+}
+
+bool SCPIShmTransport::IsConnected()
+{
+	return (m_hdr != nullptr) && SCPISocketTransport::IsConnected();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Ring buffer I/O
+
+/**
+	@brief Blocking read of exactly len bytes from a ring
+
+	Spins briefly then backs off to short sleeps while the ring is empty, since the producer is another process on
+	the same host and data normally arrives within microseconds of being requested.
+ */
+size_t SCPIShmTransport::RingRead(RingControl& ring, const uint8_t* base, uint64_t size, uint8_t* buf, size_t len)
+{
+	size_t done = 0;
+	unsigned int spins = 0;
+	while(done < len)
+	{
+		uint64_t head = ring.m_head.load(memory_order_acquire);
+		uint64_t tail = ring.m_tail.load(memory_order_relaxed);
+		uint64_t avail = head - tail;
+		if(avail == 0)
+		{
+			if(++spins < 1000)
+				this_thread::yield();
+			else
+				this_thread::sleep_for(chrono::microseconds(100));
+			continue;
+		}
+		spins = 0;
+
+		size_t n = min((size_t)avail, len - done);
+		size_t idx = tail & (size - 1);
+
+		//Copy up to the end of the ring, then wrap
+		size_t contig = min((size_t)(size - idx), n);
+		memcpy(buf + done, base + idx, contig);
+		if(n > contig)
+			memcpy(buf + done + contig, base, n - contig);
+
+		done += n;
+		ring.m_tail.store(tail + n, memory_order_release);
+	}
+	return done;
+}
+
+/**
+	@brief Blocking write of exactly len bytes to a ring
+ */
+void SCPIShmTransport::RingWrite(RingControl& ring, uint8_t* base, uint64_t size, const uint8_t* buf, size_t len)
+{
+	size_t done = 0;
+	unsigned int spins = 0;
+	while(done < len)
+	{
+		uint64_t head = ring.m_head.load(memory_order_relaxed);
+		uint64_t tail = ring.m_tail.load(memory_order_acquire);
+		uint64_t space = size - (head - tail);
+		if(space == 0)
+		{
+			if(++spins < 1000)
+				this_thread::yield();
+			else
+				this_thread::sleep_for(chrono::microseconds(100));
+			continue;
+		}
+		spins = 0;
+
+		size_t n = min((size_t)space, len - done);
+		size_t idx = head & (size - 1);
+
+		size_t contig = min((size_t)(size - idx), n);
+		memcpy(base + idx, buf + done, contig);
+		if(n > contig)
+			memcpy(base, buf + done + contig, n - contig);
+
+		done += n;
+		ring.m_head.store(head + n, memory_order_release);
+	}
+}
+
+size_t SCPIShmTransport::ReadRawData(size_t len, unsigned char* buf)
+{
+	if(!m_hdr)
+		return 0;
+	size_t ret = RingRead(m_hdr->m_rx, m_rxData, m_hdr->m_rxSize, buf, len);
+	CountRxBytes(ret);
+	return ret;
+}
+
+void SCPIShmTransport::SendRawData(size_t len, const unsigned char* buf)
+{
+	if(!m_hdr)
+		return;
+	RingWrite(m_hdr->m_tx, m_txData, m_hdr->m_txSize, buf, len);
+	CountTxBytes(len);
+}
+
+#endif
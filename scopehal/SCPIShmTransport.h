@@ -0,0 +1,118 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Declaration of SCPIShmTransport
+ */
+
+#ifndef SCPIShmTransport_h
+#define SCPIShmTransport_h
+
+#ifndef _WIN32
+
+#include <atomic>
+
+/**
+	@brief A SCPISocketTransport plus a shared-memory ring buffer for waveform data
+
+	Intended for bridge daemons running on the same host as the client: commands and replies use the normal SCPI
+	socket, while Read/WriteRawData are directed at a pair of single-producer single-consumer ring buffers in a
+	POSIX shared memory segment created by the daemon. Bulk sample data thus never crosses the loopback TCP stack;
+	the only copy left on the download path is the one from the ring into the destination buffer, which for
+	SendCommandImmediateWithRawBlockReply() is an AcceleratorBuffer's pinned host memory.
+
+	Connection string: host:port[:shmname] where shmname is the daemon's shm_open() name
+	(default "/scopehal-bridge").
+
+	Segment layout: SegmentHeader at offset 0, daemon-to-client ring data at SHM_DATA_OFFSET, client-to-daemon ring
+	data immediately after. Ring sizes must be powers of two; head/tail are free-running 64-bit counters so fill
+	level is simply head minus tail.
+ */
+class SCPIShmTransport : public SCPISocketTransport
+{
+public:
+	SCPIShmTransport(const std::string& args);
+	virtual ~SCPIShmTransport();
+
+	virtual std::string GetConnectionString() override;
+	static std::string GetTransportName();
+
+	virtual bool IsConnected() override;
+
+	virtual size_t ReadRawData(size_t len, unsigned char* buf) override;
+	virtual void SendRawData(size_t len, const unsigned char* buf) override;
+
+	TRANSPORT_INITPROC(SCPIShmTransport)
+
+protected:
+
+	///@brief Producer/consumer indices for one ring direction, padded to separate cache lines
+	struct RingControl
+	{
+		std::atomic<uint64_t> m_head;
+		uint8_t m_padding1[56];
+		std::atomic<uint64_t> m_tail;
+		uint8_t m_padding2[56];
+	};
+
+	///@brief Header at the start of the shared memory segment (must match the bridge daemon's layout)
+	struct SegmentHeader
+	{
+		uint32_t m_magic;
+		uint32_t m_version;
+		uint64_t m_rxSize;
+		uint64_t m_txSize;
+		RingControl m_rx;
+		RingControl m_tx;
+	};
+
+	size_t RingRead(RingControl& ring, const uint8_t* base, uint64_t size, uint8_t* buf, size_t len);
+	void RingWrite(RingControl& ring, uint8_t* base, uint64_t size, const uint8_t* buf, size_t len);
+
+	///@brief Name of the shared memory segment
+	std::string m_shmName;
+
+	///@brief Segment header (null if the segment could not be mapped)
+	SegmentHeader* m_hdr;
+
+	///@brief Daemon-to-client ring data
+	uint8_t* m_rxData;
+
+	///@brief Client-to-daemon ring data
+	uint8_t* m_txData;
+
+	///@brief Total mapped size of the segment
+	size_t m_mappedSize;
+};
+
+#endif
+
+#endif
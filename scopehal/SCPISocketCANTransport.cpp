@@ -123,6 +123,8 @@ SCPISocketCANTransport::SCPISocketCANTransport(const string& args)
 
 SCPISocketCANTransport::~SCPISocketCANTransport()
 {
+	ShutdownFlusher();
+
 	close(m_socket);
 }
 
@@ -263,6 +265,7 @@ size_t SCPISocketCANTransport::ReadRawData(size_t len, unsigned char* buf)
 	else if(rlen == 0)
 		return 0;
 
+	CountRxBytes(rlen);
 	return rlen;
 }
 
@@ -37,11 +37,16 @@
 
 using namespace std;
 
+///@brief Size of the local receive buffer used for terminator scanning
+static const size_t RX_BUFFER_SIZE = 1024 * 1024;
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Construction / destruction
 
 SCPISocketTransport::SCPISocketTransport(const string& args)
 	: m_socket(AF_INET, SOCK_STREAM, IPPROTO_TCP)
+	, m_rxBufStart(0)
+	, m_rxBufEnd(0)
 {
 	char hostname[128];
 	unsigned int port = 0;
@@ -64,12 +69,17 @@ SCPISocketTransport::SCPISocketTransport(const string& hostname, unsigned short
 	: m_socket(AF_INET, SOCK_STREAM, IPPROTO_TCP)
 	, m_hostname(hostname)
 	, m_port(port)
+	, m_rxBufStart(0)
+	, m_rxBufEnd(0)
 {
 	SharedCtorInit();
 }
 
 void SCPISocketTransport::SharedCtorInit()
 {
+	//Allocate the RX buffer up front so it's valid even if the connection attempt fails
+	m_rxBuf.resize(RX_BUFFER_SIZE);
+
 	LogDebug("Connecting to SCPI device at %s:%d\n", m_hostname.c_str(), m_port);
 
 	if(!m_socket.Connect(m_hostname, m_port))
@@ -94,10 +104,16 @@ void SCPISocketTransport::SharedCtorInit()
 		LogError("Couldn't disable delayed ACK\n");
 		return;
 	}
+
+	//Attempt to set a 32 MB RX buffer for high rate streaming instruments.
+	//Can be adjusted per deployment via GetSocket() before any traffic flows.
+	if(!m_socket.SetRxBuffer(32 * 1024 * 1024))
+		LogWarning("Could not set 32 MB RX buffer. Consider increasing /proc/sys/net/core/rmem_max\n");
 }
 
 SCPISocketTransport::~SCPISocketTransport()
 {
+	ShutdownFlusher();
 }
 
 bool SCPISocketTransport::IsConnected()
@@ -127,19 +143,67 @@ bool SCPISocketTransport::SendCommand(const string& cmd)
 	return m_socket.SendLooped((unsigned char*)tempbuf.c_str(), tempbuf.length());
 }
 
+/**
+	@brief Reads up to len bytes from the socket, blocking until at least one byte is available
+
+	Unlike RecvLooped(), this does not wait for the full requested length, so a bulk read can grab however
+	much of a reply has already arrived in a single syscall.
+
+	@return Number of bytes read, or 0 on error / connection close
+ */
+size_t SCPISocketTransport::RecvUpTo(unsigned char* buf, size_t len)
+{
+	#ifdef _WIN32
+		int result = recv(m_socket, reinterpret_cast<char*>(buf), (int)len, 0);
+	#else
+		ssize_t result = recv(m_socket, buf, len, 0);
+	#endif
+	if(result <= 0)
+		return 0;
+	return (size_t)result;
+}
+
+/**
+	@brief Refills the local receive buffer with whatever the socket has pending
+
+	Only legal when the buffer has been fully drained.
+
+	@return true if at least one byte was read
+ */
+bool SCPISocketTransport::FillRxBuffer()
+{
+	size_t n = RecvUpTo(&m_rxBuf[0], m_rxBuf.size());
+	if(n == 0)
+		return false;
+	m_rxBufStart = 0;
+	m_rxBufEnd = n;
+	return true;
+}
+
 string SCPISocketTransport::ReadReply(bool endOnSemicolon)
 {
-	//FIXME: there *has* to be a more efficient way to do this...
-	char tmp = ' ';
 	string ret;
 	while(true)
 	{
-		if(!m_socket.RecvLooped((unsigned char*)&tmp, 1))
-			break;
-		if( (tmp == '\n') || ( (tmp == ';') && endOnSemicolon ) )
+		//Scan whatever we've already buffered for a terminator
+		for(size_t i = m_rxBufStart; i < m_rxBufEnd; i++)
+		{
+			char c = (char)m_rxBuf[i];
+			if( (c == '\n') || ( (c == ';') && endOnSemicolon ) )
+			{
+				ret.append((const char*)&m_rxBuf[m_rxBufStart], i - m_rxBufStart);
+				m_rxBufStart = i + 1;
+				LogTrace("[%s] Got %s\n", m_hostname.c_str(), ret.c_str());
+				return ret;
+			}
+		}
+
+		//No terminator yet: consume everything we have, then go get more in one bulk read
+		ret.append((const char*)&m_rxBuf[m_rxBufStart], m_rxBufEnd - m_rxBufStart);
+		m_rxBufStart = 0;
+		m_rxBufEnd = 0;
+		if(!FillRxBuffer())
 			break;
-		else
-			ret += tmp;
 	}
 	LogTrace("[%s] Got %s\n", m_hostname.c_str(), ret.c_str());
 	return ret;
@@ -147,23 +211,42 @@ string SCPISocketTransport::ReadReply(bool endOnSemicolon)
 
 void SCPISocketTransport::FlushRXBuffer(void)
 {
+	m_rxBufStart = 0;
+	m_rxBufEnd = 0;
 	m_socket.FlushRxBuffer();
 }
 
 void SCPISocketTransport::SendRawData(size_t len, const unsigned char* buf)
 {
 	m_socket.SendLooped(buf, len);
+	CountTxBytes(len);
 }
 
 size_t SCPISocketTransport::ReadRawData(size_t len, unsigned char* buf)
 {
-	if(!m_socket.RecvLooped(buf, len))
+	//Use up anything already buffered by ReadReply() before touching the socket,
+	//so data stays in order if a reply was over-read
+	size_t nbuffered = min(len, m_rxBufEnd - m_rxBufStart);
+	if(nbuffered != 0)
 	{
-		LogTrace("Failed to get %zu bytes\n", len);
-		return 0;
+		memcpy(buf, &m_rxBuf[m_rxBufStart], nbuffered);
+		m_rxBufStart += nbuffered;
+	}
+
+	if(nbuffered < len)
+	{
+		if(!m_socket.RecvLooped(buf + nbuffered, len - nbuffered))
+		{
+			//Report whatever partial progress we made so the stall watchdog can tell
+			//"died mid-download" apart from "never answered at all"
+			CountRxBytes(nbuffered);
+			LogTrace("Failed to get %zu bytes\n", len);
+			return 0;
+		}
 	}
 
 	LogTrace("Got %zu bytes\n", len);
+	CountRxBytes(len);
 	return len;
 }
 
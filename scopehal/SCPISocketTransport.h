@@ -74,14 +74,35 @@ public:
 		m_socket.SetRxTimeout(rxUs);
 	}
 
+	virtual bool SetReadTimeout(std::chrono::milliseconds timeout) override
+	{ return m_socket.SetRxTimeout(std::chrono::duration_cast<std::chrono::microseconds>(timeout).count()); }
+
+	/**
+		@brief Returns the underlying socket, for per-deployment tuning (SO_RCVBUF size, timeouts, etc.)
+	 */
+	Socket& GetSocket()
+	{ return m_socket; }
+
 protected:
 
 	void SharedCtorInit();
 
+	virtual size_t RecvUpTo(unsigned char* buf, size_t len);
+	bool FillRxBuffer();
+
 	Socket m_socket;
 
 	std::string m_hostname;
 	unsigned short m_port;
+
+	///@brief Buffered RX data, so terminator scanning in ReadReply() runs in memory over bulk reads
+	std::vector<uint8_t> m_rxBuf;
+
+	///@brief Index of the first unconsumed byte in m_rxBuf
+	size_t m_rxBufStart;
+
+	///@brief One past the last valid byte in m_rxBuf
+	size_t m_rxBufEnd;
 };
 
 #endif
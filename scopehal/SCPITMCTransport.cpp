@@ -98,6 +98,8 @@ SCPITMCTransport::SCPITMCTransport(const string& args)
 
 SCPITMCTransport::~SCPITMCTransport()
 {
+	ShutdownFlusher();
+
 	if (IsConnected())
 		close(m_handle);
 
@@ -165,6 +167,7 @@ void SCPITMCTransport::SendRawData(size_t len, const unsigned char* buf)
 {
 	// XXX: Should this reset m_data_depleted just like SendCommmand?
 	write(m_handle, (const char *)buf, len);
+	CountTxBytes(len);
 }
 
 size_t SCPITMCTransport::ReadRawData(size_t len, unsigned char* buf)
@@ -238,6 +241,7 @@ size_t SCPITMCTransport::ReadRawData(size_t len, unsigned char* buf)
 		return 0;
 	}
 
+	CountRxBytes(len);
 	return len;
 }
 
@@ -40,13 +40,43 @@ using namespace std;
 SCPITransport::CreateMapType SCPITransport::m_createprocs;
 
 SCPITransport::SCPITransport()
-	: m_rateLimitingEnabled(false)
-	, m_rateLimitingInterval(0)
+	: m_rxBytesCounter(nullptr)
+	, m_txBytesCounter(nullptr)
+	, m_opName(nullptr)
+	, m_opExpected(0)
+	, m_opCompleted(0)
+	, m_opLastProgress(0)
+	, m_stallCounter(nullptr)
+	, m_reconnectCounter(nullptr)
+	, m_reconnectPolicy(RECONNECT_NONE)
+	, m_txQueueSize(0)
+	, m_flusherWork(false)
+	, m_flusherShutdown(false)
+	, m_rateLimitingEnabled(false)
+	, m_defaultRateLimitEnabled(false)
 {
+	//Stub node so producers always have a predecessor to link behind
+	m_txQueueHead = new QueuedCommand;
+	m_txQueueTail = m_txQueueHead;
+
+	m_flusherThread = thread(&SCPITransport::FlusherThread, this);
 }
 
 SCPITransport::~SCPITransport()
 {
+	//Shut down the flusher thread.
+	//This is a backstop only: derived destructors must have already called ShutdownFlusher(), since by the
+	//time we get here their SendCommand() implementations are gone.
+	ShutdownFlusher();
+
+	//Free anything still in the queue (including the stub node)
+	auto node = m_txQueueHead;
+	while(node)
+	{
+		auto next = node->m_next.load();
+		delete node;
+		node = next;
+	}
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -75,102 +105,141 @@ SCPITransport* SCPITransport::CreateTransport(const string& transport, const str
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Command batching
 
-/**
-	@brief Pushes a command into the transmit FIFO then returns immediately.
-
-	This command will actually be sent the next time FlushCommandQueue() is called.
- */
-void SCPITransport::SendCommandQueued(const string& cmd)
+namespace
 {
-	lock_guard<mutex> lock(m_queueMutex);
-
-	//Do deduplication if there are existing queued commands
-	if(!m_dedupCommands.empty() && !m_txQueue.empty())
+	///@brief Splits a SCPI command into its subject (if any) and the command mnemonic
+	void ParseCommandSubject(const string& command, string& subject, string& cmd)
 	{
-		//Parse the INCOMING command into sections
-
 		//Split off subject, if we have one
 		//(ignore leading colon)
-		string tmp = cmd;
+		string tmp = command;
 		size_t icolon;
 		if(tmp[0] == ':')
 			icolon = tmp.find(':', 1);
 		else
 			icolon = tmp.find(':', 0);
-		string incoming_subject;
 		if(icolon != string::npos)
 		{
-			incoming_subject = tmp.substr(0, icolon);
+			subject = tmp.substr(0, icolon);
 			tmp = tmp.substr(icolon + 1);
 		}
 
 		//Split off command from arguments
 		size_t ispace = tmp.find(' ');
-		string incoming_cmd;
 		if(ispace != string::npos)
-			incoming_cmd = tmp.substr(0, ispace);
+			cmd = tmp.substr(0, ispace);
+	}
+}
 
-		//Only attempt to deduplicate previous instances if this command is on the list of commands where it's OK
-		if(m_dedupCommands.find(incoming_cmd) != m_dedupCommands.end())
-		{
-			auto it = m_txQueue.begin();
-			while(it != m_txQueue.end())
-			{
-				tmp = *it;
-
-				//Split off subject, if we have one
-				//(ignore leading colon)
-				if(tmp[0] == ':')
-					icolon = tmp.find(':', 1);
-				else
-					icolon = tmp.find(':', 0);
-				string subject;
-				if(icolon != string::npos)
-				{
-					subject = tmp.substr(0, icolon);
-					tmp = tmp.substr(icolon + 1);
-				}
-
-				//Split off command from arguments
-				ispace = tmp.find(' ');
-				string ncmd;
-				if(ispace != string::npos)
-					ncmd = tmp.substr(0, ispace);
-
-				//Deduplicate if the same command is operating on the same subject
-				if( (incoming_cmd == ncmd) && (incoming_subject == subject) )
-				{
-					LogTrace("Deduplicating redundant %s command %s and pushing new command %s\n",
-						ncmd.c_str(),
-						(*it).c_str(),
-						cmd.c_str());
-
-					auto oldit = it;
-					it++;
-
-					m_txQueue.erase(oldit);
-				}
-
-				//Nope, skip it
-				else
-					it++;
-			}
-		}
+/**
+	@brief Pushes a command into the transmit FIFO then returns immediately.
+
+	The push is lock-free, so this never blocks behind a bulk data transfer on the net mutex: the command
+	is actually sent by the flusher thread (or the next explicit FlushCommandQueue() call), whichever comes first.
+ */
+void SCPITransport::SendCommandQueued(const string& cmd)
+{
+	auto node = new QueuedCommand(cmd);
+	auto prev = m_txQueueTail.exchange(node, std::memory_order_acq_rel);
+	prev->m_next.store(node, std::memory_order_release);
+
+	size_t n = ++m_txQueueSize;
+	LogTrace("%zu commands now queued\n", n);
+
+	//Wake the flusher
+	{
+		lock_guard<mutex> lock(m_flusherMutex);
+		m_flusherWork = true;
+	}
+	m_flusherCvar.notify_one();
+}
+
+/**
+	@brief Stops the flusher thread and waits for it to exit
 
+	Called by every concrete transport destructor (and again, harmlessly, by the base destructor) so the
+	thread can never call into a partially destroyed derived object.
+ */
+void SCPITransport::ShutdownFlusher()
+{
+	{
+		lock_guard<mutex> lock(m_flusherMutex);
+		m_flusherShutdown = true;
 	}
+	m_flusherCvar.notify_one();
+	if(m_flusherThread.joinable())
+		m_flusherThread.join();
+}
 
-	m_txQueue.push_back(cmd);
+/**
+	@brief Background thread which flushes the command queue whenever something is pushed onto it
+ */
+void SCPITransport::FlusherThread()
+{
+	#ifdef __linux__
+	pthread_setname_np(pthread_self(), "SCPIFlush");
+	#endif
 
-	LogTrace("%zu commands now queued\n", m_txQueue.size());
+	while(true)
+	{
+		{
+			unique_lock<mutex> lock(m_flusherMutex);
+			m_flusherCvar.wait(lock, [this]{ return m_flusherWork || m_flusherShutdown; });
+			if(m_flusherShutdown)
+				return;
+			m_flusherWork = false;
+		}
+
+		FlushCommandQueue();
+	}
 }
 
 /**
-	@brief Block until it's time to send the next command when rate limiting.
+	@brief Block until the command's token bucket has a token to spend, then take it.
+
+	Commands with no configured class fall through to the default bucket if EnableRateLimiting() was called,
+	and are sent at full speed otherwise.
  */
-void SCPITransport::RateLimitingWait()
+void SCPITransport::RateLimitingWait(const string& command)
 {
-	this_thread::sleep_until(m_nextCommandReady);
-	m_nextCommandReady = chrono::system_clock::now() + m_rateLimitingInterval;
+	//Find the bucket pacing this command, if any
+	RateLimitBucket* bucket = nullptr;
+	if(!m_rateLimitClasses.empty())
+	{
+		string subject;
+		string cmd;
+		ParseCommandSubject(command, subject, cmd);
+		auto it = m_rateLimitClasses.find(cmd);
+		if(it != m_rateLimitClasses.end())
+			bucket = &it->second;
+	}
+	if(!bucket)
+	{
+		if(!m_defaultRateLimitEnabled)
+			return;
+		bucket = &m_defaultRateLimitBucket;
+	}
+	if(bucket->m_interval.count() == 0)
+		return;
+
+	//Add tokens earned since the last refill, up to the burst limit
+	auto now = chrono::system_clock::now();
+	double earned =
+		chrono::duration_cast<chrono::duration<double, milli>>(now - bucket->m_lastRefill).count() /
+		bucket->m_interval.count();
+	bucket->m_tokens = min(bucket->m_tokens + earned, (double)bucket->m_burst);
+	bucket->m_lastRefill = now;
+
+	//Bucket empty? Sleep until a full token has accumulated
+	if(bucket->m_tokens < 1)
+	{
+		auto deficit = chrono::duration<double, milli>( (1 - bucket->m_tokens) * bucket->m_interval.count() );
+		this_thread::sleep_for(chrono::duration_cast<chrono::milliseconds>(deficit));
+		bucket->m_tokens = 1;
+		bucket->m_lastRefill = chrono::system_clock::now();
+	}
+
+	bucket->m_tokens -= 1;
 }
 
 /**
@@ -178,23 +247,60 @@ void SCPITransport::RateLimitingWait()
  */
 bool SCPITransport::FlushCommandQueue()
 {
-	//Grab the queue, then immediately release the mutex so we can do more queued sends
-	list<string> tmp;
+	lock_guard<recursive_mutex> lock(m_netMutex);
+
+	//Drain the queue (we're the only consumer, since the consumer end is guarded by the net mutex).
+	//A producer may have swapped the tail but not yet linked its node; such a command is simply
+	//picked up by the next flush.
+	vector<string> tmp;
+	while(true)
 	{
-		lock_guard<mutex> lock(m_queueMutex);
-		tmp = std::move(m_txQueue);
-		m_txQueue.clear();
+		auto head = m_txQueueHead;
+		auto next = head->m_next.load(std::memory_order_acquire);
+		if(!next)
+			break;
+		tmp.push_back(std::move(next->m_cmd));
+		m_txQueueHead = next;
+		delete head;
 	}
+	m_txQueueSize -= tmp.size();
 
 	if(tmp.size())
 		LogTrace("%zu commands being flushed\n", tmp.size());
 
-	lock_guard<recursive_mutex> lock(m_netMutex);
-	for(auto str : tmp)
+	//Do deduplication: for commands on the dedup list, only the newest instance per subject is sent
+	vector<bool> drop(tmp.size(), false);
+	if(!m_dedupCommands.empty() && (tmp.size() > 1) )
+	{
+		set<pair<string, string>> seen;
+		for(size_t i = tmp.size(); i > 0; i--)
+		{
+			string subject;
+			string ncmd;
+			ParseCommandSubject(tmp[i-1], subject, ncmd);
+
+			//Only attempt to deduplicate if this command is on the list of commands where it's OK
+			if(m_dedupCommands.find(ncmd) == m_dedupCommands.end())
+				continue;
+
+			auto key = make_pair(ncmd, subject);
+			if(seen.find(key) != seen.end())
+			{
+				LogTrace("Deduplicating redundant %s command %s\n", ncmd.c_str(), tmp[i-1].c_str());
+				drop[i-1] = true;
+			}
+			else
+				seen.emplace(key);
+		}
+	}
+
+	for(size_t i = 0; i < tmp.size(); i++)
 	{
+		if(drop[i])
+			continue;
 		if(m_rateLimitingEnabled)
-			RateLimitingWait();
-		SendCommand(str);
+			RateLimitingWait(tmp[i]);
+		SendCommand(tmp[i]);
 	}
 	return true;
 }
@@ -210,6 +316,50 @@ string SCPITransport::SendCommandQueuedWithReply(string cmd, bool endOnSemicolon
 	return SendCommandImmediateWithReply(cmd, endOnSemicolon);
 }
 
+/**
+	@brief Sends a burst of queries, then reads all of the replies, pipelining where the transport allows it.
+
+	On transports that support command batching, every query goes out back to back before the first reply is
+	read, so a capability probe of N queries costs roughly one network round trip instead of N. Replies are
+	returned in query order. Transports that can't batch (or can't keep replies ordered) fall back to one
+	query at a time, so callers don't need their own fallback path.
+
+	This is an atomic operation requiring no mutexing at the caller side.
+ */
+vector<string> SCPITransport::SendQueryBatch(const vector<string>& queries, bool endOnSemicolon)
+{
+	FlushCommandQueue();
+
+	lock_guard<recursive_mutex> lock(m_netMutex);
+
+	vector<string> replies;
+	replies.reserve(queries.size());
+
+	if(IsCommandBatchingSupported())
+	{
+		for(auto& q : queries)
+		{
+			if(m_rateLimitingEnabled)
+				RateLimitingWait(q);
+			SendCommand(q);
+		}
+		for(size_t i=0; i<queries.size(); i++)
+			replies.push_back(ReadReply(endOnSemicolon));
+	}
+	else
+	{
+		for(auto& q : queries)
+		{
+			if(m_rateLimitingEnabled)
+				RateLimitingWait(q);
+			SendCommand(q);
+			replies.push_back(ReadReply(endOnSemicolon));
+		}
+	}
+
+	return replies;
+}
+
 /**
 	@brief Sends a command (jumping ahead of the queue), then returns the response.
 
@@ -220,7 +370,7 @@ string SCPITransport::SendCommandImmediateWithReply(string cmd, bool endOnSemico
 	lock_guard<recursive_mutex> lock(m_netMutex);
 
 	if(m_rateLimitingEnabled)
-		RateLimitingWait();
+		RateLimitingWait(cmd);
 
 	SendCommand(cmd);
 
@@ -235,7 +385,7 @@ void SCPITransport::SendCommandImmediate(string cmd)
 	lock_guard<recursive_mutex> lock(m_netMutex);
 
 	if(m_rateLimitingEnabled)
-		RateLimitingWait();
+		RateLimitingWait(cmd);
 
 	SendCommand(cmd);
 }
@@ -248,30 +398,104 @@ void* SCPITransport::SendCommandImmediateWithRawBlockReply(string cmd, size_t& l
 	lock_guard<recursive_mutex> lock(m_netMutex);
 
 	if(m_rateLimitingEnabled)
-		RateLimitingWait();
+		RateLimitingWait(cmd);
 	SendCommand(cmd);
 
+	if(!ReadRawBlockHeader(len))
+		return NULL;
+
+	//Read the actual data
+	unsigned char* buf = new unsigned char[len];
+	len = ReadRawData(len, buf);
+	return buf;
+}
+
+/**
+	@brief Reads the "#nddd" length header preceding a SCPI binary block, returning the payload length
+ */
+bool SCPITransport::ReadRawBlockHeader(size_t& len)
+{
 	//Read the length
 	char tmplen[3] = {0};
 	if(2 != ReadRawData(2, (unsigned char*)tmplen))			//expect #n
-		return NULL;
+		return false;
 	if(tmplen[0] == 0)	//Not sure how this happens, but sometimes occurs on Tek MSO6?
-		return NULL;
+		return false;
 	size_t ndigits = stoull(tmplen+1);
 
 	//Read the digits
 	char digits[10] = {0};
 	if(ndigits != ReadRawData(ndigits, (unsigned char*)digits))
-		return NULL;
+		return false;
 	len = stoull(digits);
-
-	//Read the actual data
-	unsigned char* buf = new unsigned char[len];
-	len = ReadRawData(len, buf);
-	return buf;
+	return true;
 }
 
 void SCPITransport::FlushRXBuffer(void)
 {
 	LogError("SCPITransport::FlushRXBuffer is unimplemented\n");
 }
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Stall watchdog
+
+bool SCPITransport::SetReadTimeout(chrono::milliseconds /*timeout*/)
+{
+	//No timeout mechanism in the base class; transports with a bounded read primitive override this
+	return false;
+}
+
+/**
+	@brief Reports the progress of the watchdog-bracketed operation currently in flight, if any
+
+	Safe to call from any thread without taking the net mutex, so a watchdog can diagnose a wedged transport while
+	the owning thread is still blocked inside ReadRawData().
+
+	@return True if an operation is in flight (output parameters filled), false if the transport is idle
+ */
+bool SCPITransport::GetOperationProgress(
+	string& what, size_t& expectedBytes, size_t& completedBytes, int64_t& msSinceProgress)
+{
+	auto name = m_opName.load(memory_order_acquire);
+	if(name == nullptr)
+		return false;
+
+	what = name;
+	expectedBytes = m_opExpected.load(memory_order_relaxed);
+	completedBytes = m_opCompleted.load(memory_order_relaxed);
+	msSinceProgress = GetMonotonicMillis() - m_opLastProgress.load(memory_order_relaxed);
+	return true;
+}
+
+bool SCPITransport::TryReconnect()
+{
+	return false;
+}
+
+/**
+	@brief Counts, logs, and (policy permitting) recovers from a bounded read that came back short
+ */
+void SCPITransport::RecordStall(size_t expectedBytes, size_t completedBytes)
+{
+	if(!m_stallCounter)
+		m_stallCounter = &g_perfCounters.GetCounter(
+			"transport." + GetConnectionString() + ".stalls", "stalls");
+	m_stallCounter->Increment();
+
+	LogWarning("[%s] Transport stalled: got %zu of %zu expected bytes\n",
+		GetConnectionString().c_str(), completedBytes, expectedBytes);
+
+	if(m_reconnectPolicy == RECONNECT_ON_STALL)
+	{
+		if(TryReconnect())
+		{
+			if(!m_reconnectCounter)
+				m_reconnectCounter = &g_perfCounters.GetCounter(
+					"transport." + GetConnectionString() + ".reconnects", "reconnects");
+			m_reconnectCounter->Increment();
+			LogNotice("[%s] Reconnected after stall\n", GetConnectionString().c_str());
+		}
+		else
+			LogWarning("[%s] Reconnect after stall failed\n", GetConnectionString().c_str());
+	}
+}
@@ -36,7 +36,13 @@
 #ifndef SCPITransport_h
 #define SCPITransport_h
 
+#include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <condition_variable>
+#include <thread>
+
+template<class T> class AcceleratorBuffer;
 
 /**
 	@brief Abstraction of a transport layer for moving SCPI data between endpoints
@@ -53,19 +59,151 @@ public:
 	/*
 		Queued command API
 
-		Note that glscopeclient flushes the command queue in ScopeThread.
-		Headless applications will need to do this manually after performing a write-only application, otherwise
-		the command will remain queued indefinitely.
+		SendCommandQueued() pushes onto a lock-free MPSC queue and never touches the net mutex, so the UI thread
+		can queue settings changes while a bulk waveform download is in progress on another thread.
 
-		TODO: look into a background thread or something that's automatically launched by the transport to do this
-		after some kind of fixed timeout?
+		A flusher thread owned by the transport drains the queue in the background; applications may still call
+		FlushCommandQueue() to block until everything queued so far has been sent.
 	 */
 	void SendCommandQueued(const std::string& cmd);
 	std::string SendCommandQueuedWithReply(std::string cmd, bool endOnSemicolon = true);
+	std::vector<std::string> SendQueryBatch(const std::vector<std::string>& queries, bool endOnSemicolon = true);
 	void SendCommandImmediate(std::string cmd);
 	std::string SendCommandImmediateWithReply(std::string cmd, bool endOnSemicolon = true);
 	void* SendCommandImmediateWithRawBlockReply(std::string cmd, size_t& len);
-	bool FlushCommandQueue();
+	virtual bool FlushCommandQueue();
+
+	/**
+		@brief Sends a command (jumping ahead of the queue), then reads a binary block reply directly into an
+		AcceleratorBuffer's pinned host memory.
+
+		The payload lands in the buffer's CPU-side allocation starting at byteOffset, so bulk ADC data goes from
+		the wire into DMA-able memory with no intermediate copy. The buffer is grown if needed, but never shrunk,
+		since large downloads are often assembled from several chunks.
+
+		@return Number of payload bytes read, or zero on failure
+	 */
+	template<class T>
+	size_t SendCommandImmediateWithRawBlockReply(const std::string& cmd, AcceleratorBuffer<T>& buf, size_t byteOffset = 0)
+	{
+		std::lock_guard<std::recursive_mutex> lock(m_netMutex);
+
+		if(m_rateLimitingEnabled)
+			RateLimitingWait(cmd);
+		SendCommand(cmd);
+
+		size_t len;
+		if(!ReadRawBlockHeader(len))
+			return 0;
+
+		size_t needed = (byteOffset + len + sizeof(T) - 1) / sizeof(T);
+		if(buf.size() < needed)
+			buf.resize(needed);
+		buf.PrepareForCpuAccess();
+
+		BeginOperation("block read", len);
+		size_t nread = ReadRawData(len, reinterpret_cast<unsigned char*>(buf.GetCpuPointer()) + byteOffset);
+		size_t counted = EndOperation();
+		buf.MarkModifiedFromCpu();
+
+		if(nread != len)
+			RecordStall(len, (nread > counted) ? nread : counted);
+		return nread;
+	}
+
+	///@brief One query in a SendBlockQueryBatch(): a command expecting a block reply, and where its payload lands
+	struct BlockQuery
+	{
+		BlockQuery(const std::string& cmd = "", size_t byteOffset = 0)
+			: m_cmd(cmd)
+			, m_byteOffset(byteOffset)
+		{}
+
+		///@brief The query to send
+		std::string m_cmd;
+
+		///@brief Destination offset of the payload within the buffer, in bytes
+		size_t m_byteOffset;
+	};
+
+	/**
+		@brief Sends a batch of block queries, reading each reply into an AcceleratorBuffer at its requested offset.
+
+		Where the transport supports batching, every query goes out on the wire before the first reply is read, so
+		while we're still draining block N the instrument is already preparing and sending block N+1. Compared to
+		calling SendCommandImmediateWithRawBlockReply() in a loop this hides one round trip plus TCP ramp-up per
+		block, which adds up fast when a deep capture is chunked into many transfers. The line-reply equivalent of
+		this API is SendQueryBatch().
+
+		The buffer is grown as each block header arrives, but never shrunk. Some instruments append a terminator
+		after each payload; pass its length as trailingBytesPerBlock so it's consumed before the next header.
+
+		@return Per-query payload byte counts, in order. The list is cut short if a block header never arrives;
+				the stream may be desynchronized past that point, so callers should abort and FlushRXBuffer().
+	 */
+	template<class T>
+	std::vector<size_t> SendBlockQueryBatch(
+		const std::vector<BlockQuery>& queries, AcceleratorBuffer<T>& buf, size_t trailingBytesPerBlock = 0)
+	{
+		FlushCommandQueue();
+
+		std::lock_guard<std::recursive_mutex> lock(m_netMutex);
+
+		std::vector<size_t> lengths;
+		lengths.reserve(queries.size());
+
+		bool batched = IsCommandBatchingSupported();
+		if(batched)
+		{
+			for(auto& q : queries)
+			{
+				if(m_rateLimitingEnabled)
+					RateLimitingWait(q.m_cmd);
+				SendCommand(q.m_cmd);
+			}
+		}
+
+		for(auto& q : queries)
+		{
+			if(!batched)
+			{
+				if(m_rateLimitingEnabled)
+					RateLimitingWait(q.m_cmd);
+				SendCommand(q.m_cmd);
+			}
+
+			size_t len;
+			if(!ReadRawBlockHeader(len))
+				break;
+
+			size_t needed = (q.m_byteOffset + len + sizeof(T) - 1) / sizeof(T);
+			if(buf.size() < needed)
+				buf.resize(needed);
+			buf.PrepareForCpuAccess();
+
+			BeginOperation("block read", len);
+			size_t nread = ReadRawData(len, reinterpret_cast<unsigned char*>(buf.GetCpuPointer()) + q.m_byteOffset);
+			size_t counted = EndOperation();
+
+			if(nread != len)
+				RecordStall(len, (nread > counted) ? nread : counted);
+
+			//Consume any terminator the instrument sends after the payload, so the next header parses cleanly
+			unsigned char discard[16];
+			for(size_t left = trailingBytesPerBlock; left > 0; )
+			{
+				size_t chunk = std::min(left, sizeof(discard));
+				if(ReadRawData(chunk, discard) != chunk)
+					break;
+				left -= chunk;
+			}
+
+			lengths.push_back(nread);
+		}
+
+		buf.MarkModifiedFromCpu();
+		return lengths;
+	}
 
 	//Manual mutex locking for ReadRawData() etc
 	std::recursive_mutex& GetMutex()
@@ -82,19 +220,41 @@ public:
 	virtual bool IsConnected() =0;
 
 	/**
-		@brief Enables rate limiting. Rate limiting is only applied to the queued command API.
+		@brief Enables rate limiting for all commands.
 
-		The rate limiting feature ensures a minimum delay between SCPI commands. This severely degrades performance and
-		is intended to be used as a crutch to work around instrument firmware bugs. Other synchronization mechanisms
-		should be used if at all possible.
+		Commands are paced by a token bucket: tokens accumulate at one per interval up to the burst size, and each
+		command spends one, so short bursts go out back to back while sustained traffic averages one command per
+		interval. The default burst of 1 degenerates to a fixed inter-command delay.
 
-		Once rate limiting is enabled on a transport, it cannot be disabled.
+		This severely degrades performance and is intended as a crutch to work around instrument firmware bugs.
+		If only specific subsystems misbehave, use SetCommandRateLimit() instead so everything else (notably bulk
+		waveform queries) runs at full speed.
 	 */
-	void EnableRateLimiting(std::chrono::milliseconds interval)
+	void EnableRateLimiting(std::chrono::milliseconds interval, size_t burst = 1)
 	{
 		m_rateLimitingEnabled = true;
-		m_rateLimitingInterval = interval;
-		m_nextCommandReady = std::chrono::system_clock::now();
+		m_defaultRateLimitEnabled = true;
+		m_defaultRateLimitBucket = RateLimitBucket(interval, burst);
+	}
+
+	/**
+		@brief Rate limits only commands with the given mnemonic, each class by its own token bucket.
+
+		Matching follows the same subject/mnemonic split as DeduplicateCommand(), so "OFFS" paces "C2:OFFS 1.1" on
+		any channel. Commands with no configured class (and no EnableRateLimiting() default) are not paced at all.
+	 */
+	void SetCommandRateLimit(const std::string& cmd, std::chrono::milliseconds interval, size_t burst = 1)
+	{
+		m_rateLimitingEnabled = true;
+		m_rateLimitClasses[cmd] = RateLimitBucket(interval, burst);
+	}
+
+	///@brief Removes all rate limiting from this transport
+	void DisableRateLimiting()
+	{
+		m_rateLimitingEnabled = false;
+		m_defaultRateLimitEnabled = false;
+		m_rateLimitClasses.clear();
 	}
 
 	/**
@@ -118,6 +278,53 @@ public:
 	void DeduplicateCommand(const std::string& cmd)
 	{ m_dedupCommands.emplace(cmd); }
 
+	/*
+		Stall watchdog
+
+		An instrument that wedges mid-block-read used to freeze the whole pipeline with no diagnosis: ReadRawData()
+		blocked forever holding the net mutex. Bulk reads are now bracketed by progress markers that other threads
+		can poll via GetOperationProgress() without touching the net mutex, so a watchdog or UI can tell "waiting on
+		a 40MB download that last made progress 80ms ago" apart from "hung for an hour with zero bytes".
+
+		The per-syscall deadline comes from the underlying transport (socket receive timeouts etc, configurable via
+		SetReadTimeout() where supported). When a bounded read comes back short, the stall is counted against the
+		transport.<connection>.stalls telemetry counter, logged with its partial progress, and - if the reconnect
+		policy allows - handed to TryReconnect() so a recoverable wedge costs one timeout instead of a lab visit.
+	 */
+
+	///@brief What to do when a stalled operation is detected
+	enum ReconnectPolicy
+	{
+		///@brief Count and log the stall, but leave the connection alone (default)
+		RECONNECT_NONE,
+
+		///@brief Call TryReconnect() after each stall
+		RECONNECT_ON_STALL
+	};
+
+	void SetReconnectPolicy(ReconnectPolicy policy)
+	{ m_reconnectPolicy = policy; }
+
+	/**
+		@brief Sets the deadline for a single read syscall, where the underlying transport supports one
+
+		@return True if the timeout was applied, false if this transport has no timeout mechanism
+	 */
+	virtual bool SetReadTimeout(std::chrono::milliseconds timeout);
+
+	bool GetOperationProgress(
+		std::string& what, size_t& expectedBytes, size_t& completedBytes, int64_t& msSinceProgress);
+
+	/**
+		@brief Attempts to re-establish a wedged connection
+
+		The default implementation does nothing and reports failure; transports with reconnectable links may
+		override. Called with the net mutex held, so implementations must not issue commands through the normal API.
+
+		@return True if the connection was re-established
+	 */
+	virtual bool TryReconnect();
+
 public:
 	typedef SCPITransport* (*CreateProcType)(const std::string& args);
 	static void DoAddTransportClass(std::string name, CreateProcType proc);
@@ -126,24 +333,166 @@ public:
 	static SCPITransport* CreateTransport(const std::string& transport, const std::string& args);
 
 protected:
-	void RateLimitingWait();
+	void RateLimitingWait(const std::string& cmd);
+	void FlusherThread();
+
+	/**
+		@brief Stops the background flusher thread, blocking until any in-flight flush completes
+
+		Concrete transport destructors must call this before tearing down their connection state: the flusher
+		calls the virtual SendCommand(), so it has to be joined while the derived object is still fully alive.
+		Safe to call more than once; the base class destructor calls it as a backstop.
+	 */
+	void ShutdownFlusher();
+	bool ReadRawBlockHeader(size_t& len);
+
+	/**
+		@brief Counts received payload bytes against this instrument's telemetry counter
+
+		Transport implementations should call this from ReadRawData() with the number of bytes actually read.
+		The counter is created lazily on first use since the connection string isn't known at base construction.
+	 */
+	void CountRxBytes(size_t len)
+	{
+		if(!m_rxBytesCounter)
+			m_rxBytesCounter = &g_perfCounters.GetCounter(
+				"transport." + GetConnectionString() + ".rx_bytes", "bytes");
+		m_rxBytesCounter->Add(len);
+
+		//Stamp watchdog progress if a bracketed operation is in flight
+		if(m_opName.load(std::memory_order_relaxed) != nullptr)
+		{
+			m_opCompleted.fetch_add(len, std::memory_order_relaxed);
+			m_opLastProgress.store(GetMonotonicMillis(), std::memory_order_relaxed);
+		}
+	}
+
+	///@brief Millisecond timestamp on the monotonic clock, for watchdog math
+	static int64_t GetMonotonicMillis()
+	{
+		return std::chrono::duration_cast<std::chrono::milliseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	///@brief Marks the start of a watchdog-bracketed operation
+	void BeginOperation(const char* what, size_t expectedBytes)
+	{
+		m_opExpected.store(expectedBytes, std::memory_order_relaxed);
+		m_opCompleted.store(0, std::memory_order_relaxed);
+		m_opLastProgress.store(GetMonotonicMillis(), std::memory_order_relaxed);
+		m_opName.store(what, std::memory_order_release);
+	}
+
+	///@brief Marks the end of a watchdog-bracketed operation, returning the bytes counted during it
+	size_t EndOperation()
+	{
+		m_opName.store(nullptr, std::memory_order_release);
+		return m_opCompleted.load(std::memory_order_relaxed);
+	}
+
+	void RecordStall(size_t expectedBytes, size_t completedBytes);
+
+	///@brief Counts transmitted payload bytes against this instrument's telemetry counter
+	void CountTxBytes(size_t len)
+	{
+		if(!m_txBytesCounter)
+			m_txBytesCounter = &g_perfCounters.GetCounter(
+				"transport." + GetConnectionString() + ".tx_bytes", "bytes");
+		m_txBytesCounter->Add(len);
+	}
+
+	///@brief Telemetry counter for received bytes (owned by the registry)
+	PerfCounter* m_rxBytesCounter;
+
+	///@brief Telemetry counter for transmitted bytes (owned by the registry)
+	PerfCounter* m_txBytesCounter;
+
+	//Watchdog state for the operation currently in flight (name is null when idle; string literals only, so the
+	//pointer never dangles and readers need no lock)
+	std::atomic<const char*> m_opName;
+	std::atomic<size_t> m_opExpected;
+	std::atomic<size_t> m_opCompleted;
+	std::atomic<int64_t> m_opLastProgress;
+
+	///@brief Telemetry counter for detected stalls (owned by the registry)
+	PerfCounter* m_stallCounter;
+
+	///@brief Telemetry counter for successful automatic reconnects (owned by the registry)
+	PerfCounter* m_reconnectCounter;
+
+	///@brief What to do when a stall is detected
+	ReconnectPolicy m_reconnectPolicy;
 
 	//Class enumeration
 	typedef std::map< std::string, CreateProcType > CreateMapType;
 	static CreateMapType m_createprocs;
 
-	//Queued commands waiting to be sent
-	std::mutex m_queueMutex;
+	///@brief A single command on the transmit queue
+	struct QueuedCommand
+	{
+		QueuedCommand(const std::string& cmd = "")
+			: m_cmd(cmd)
+			, m_next(nullptr)
+		{}
+
+		std::string m_cmd;
+		std::atomic<QueuedCommand*> m_next;
+	};
+
+	//Queued commands waiting to be sent (lock-free MPSC list, values live in the node after the one popped).
+	//Producers push at the tail; the consumer end is only touched while holding the net mutex.
+	QueuedCommand* m_txQueueHead;
+	std::atomic<QueuedCommand*> m_txQueueTail;
+
+	///@brief Approximate number of commands in the queue (for logging)
+	std::atomic<size_t> m_txQueueSize;
+
 	std::recursive_mutex m_netMutex;
-	std::list<std::string> m_txQueue;
+
+	//Background thread that drains the command queue as soon as anything is pushed
+	std::thread m_flusherThread;
+	std::mutex m_flusherMutex;
+	std::condition_variable m_flusherCvar;
+	bool m_flusherWork;
+	bool m_flusherShutdown;
 
 	//Set of commands that are OK to deduplicate
 	std::set<std::string> m_dedupCommands;
 
-	//Rate limiting (send max of one command per X time)
+	///@brief Token bucket for pacing commands to instruments with firmware bugs
+	struct RateLimitBucket
+	{
+		RateLimitBucket()
+			: m_interval(0)
+			, m_burst(1)
+			, m_tokens(1)
+		{}
+
+		RateLimitBucket(std::chrono::milliseconds interval, size_t burst)
+			: m_interval(interval)
+			, m_burst(burst)
+			, m_tokens((double)burst)
+			, m_lastRefill(std::chrono::system_clock::now())
+		{}
+
+		///@brief Time to earn one token
+		std::chrono::milliseconds m_interval;
+
+		///@brief Maximum number of saved-up tokens (burst credit)
+		size_t m_burst;
+
+		///@brief Current token count
+		double m_tokens;
+
+		///@brief When tokens were last added to the bucket
+		std::chrono::system_clock::time_point m_lastRefill;
+	};
+
+	//Rate limiting (fast-path flag plus the buckets; buckets are only touched while holding the net mutex)
 	bool m_rateLimitingEnabled;
-	std::chrono::system_clock::time_point m_nextCommandReady;
-	std::chrono::milliseconds m_rateLimitingInterval;
+	bool m_defaultRateLimitEnabled;
+	RateLimitBucket m_defaultRateLimitBucket;
+	std::map<std::string, RateLimitBucket> m_rateLimitClasses;
 };
 
 #define TRANSPORT_INITPROC(T) \
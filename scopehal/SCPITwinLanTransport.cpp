@@ -65,6 +65,7 @@ SCPITwinLanTransport::SCPITwinLanTransport(const string& args)
 
 SCPITwinLanTransport::~SCPITwinLanTransport()
 {
+	ShutdownFlusher();
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -88,7 +89,10 @@ string SCPITwinLanTransport::GetConnectionString()
 size_t SCPITwinLanTransport::ReadRawData(size_t len, unsigned char* buf)
 {
 	if(m_secondarysocket.RecvLooped(buf, len))
+	{
+		CountRxBytes(len);
 		return len;
+	}
 	else
 		return 0;
 }
@@ -96,4 +100,5 @@ size_t SCPITwinLanTransport::ReadRawData(size_t len, unsigned char* buf)
 void SCPITwinLanTransport::SendRawData(size_t len, const unsigned char* buf)
 {
 	m_secondarysocket.SendLooped(buf, len);
+	CountTxBytes(len);
 }
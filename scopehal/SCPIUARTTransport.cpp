@@ -68,6 +68,7 @@ SCPIUARTTransport::SCPIUARTTransport(const string& args)
 
 SCPIUARTTransport::~SCPIUARTTransport()
 {
+	ShutdownFlusher();
 }
 
 bool SCPIUARTTransport::IsConnected()
@@ -119,12 +120,14 @@ string SCPIUARTTransport::ReadReply(bool endOnSemicolon)
 void SCPIUARTTransport::SendRawData(size_t len, const unsigned char* buf)
 {
 	m_uart.Write(buf, len);
+	CountTxBytes(len);
 }
 
 size_t SCPIUARTTransport::ReadRawData(size_t len, unsigned char* buf)
 {
 	if(!m_uart.Read(buf, len))
 		return 0;
+	CountRxBytes(len);
 	return len;
 }
 
@@ -0,0 +1,309 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Implementation of SCPIUringTransport
+ */
+
+#include "scopehal.h"
+
+#ifdef HAS_LIBURING
+
+using namespace std;
+
+///@brief Number of SQEs in the ring (must be >= MAX_PENDING_SENDS plus one receive)
+static const unsigned int QUEUE_DEPTH = 64;
+
+///@brief Maximum number of commands chained into one submission before we force a flush
+static const size_t MAX_PENDING_SENDS = 32;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Construction / destruction
+
+SCPIUringTransport::SCPIUringTransport(const string& args)
+	: SCPISocketTransport(args)
+	, m_ringValid(false)
+	, m_rxBufRegistered(false)
+	, m_lastPendingSqe(nullptr)
+{
+	//Base class constructor does the actual connect; nothing to do if that failed
+	if(!m_socket.IsValid())
+		return;
+
+	int err = io_uring_queue_init(QUEUE_DEPTH, &m_ring, 0);
+	if(err != 0)
+	{
+		LogWarning("io_uring setup failed (%s), falling back to blocking socket I/O\n", strerror(-err));
+		return;
+	}
+	m_ringValid = true;
+
+	//Register the RX staging buffer with the kernel so reply reads skip per-operation page pinning.
+	//Not fatal if this fails (some kernels cap registered memory); we just use normal recv SQEs.
+	struct iovec iov;
+	iov.iov_base = &m_rxBuf[0];
+	iov.iov_len = m_rxBuf.size();
+	if(0 == io_uring_register_buffers(&m_ring, &iov, 1))
+		m_rxBufRegistered = true;
+}
+
+SCPIUringTransport::~SCPIUringTransport()
+{
+	ShutdownFlusher();
+
+	if(m_ringValid)
+	{
+		FlushPendingSends();
+		io_uring_queue_exit(&m_ring);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Actual transport code
+
+string SCPIUringTransport::GetTransportName()
+{
+	return "uring";
+}
+
+/**
+	@brief Submits everything currently in the ring and blocks for a single completion
+
+	@return Completion result (bytes transferred, or negative errno), -1 if the wait itself failed
+ */
+int SCPIUringTransport::SubmitAndWaitOne()
+{
+	io_uring_submit(&m_ring);
+
+	struct io_uring_cqe* cqe;
+	if(0 != io_uring_wait_cqe(&m_ring, &cqe))
+		return -1;
+	int res = cqe->res;
+	io_uring_cqe_seen(&m_ring, cqe);
+	return res;
+}
+
+/**
+	@brief Preps a send SQE for the command but does NOT submit it
+
+	Consecutive commands are chained with IOSQE_IO_LINK so the kernel sends them in order; the whole chain
+	goes out in one io_uring_submit() when a reply is needed or the command queue is flushed.
+ */
+bool SCPIUringTransport::SendCommand(const string& cmd)
+{
+	if(!m_ringValid)
+		return SCPISocketTransport::SendCommand(cmd);
+
+	LogTrace("[%s] Sending %s\n", m_hostname.c_str(), cmd.c_str());
+
+	if(m_pendingSends.size() >= MAX_PENDING_SENDS)
+		FlushPendingSends();
+
+	//Deque, not vector: the kernel reads the string data asynchronously, so element addresses must not move
+	//as more commands are queued behind this one
+	m_pendingSends.push_back(cmd + "\n");
+	auto& data = m_pendingSends.back();
+
+	auto sqe = io_uring_get_sqe(&m_ring);
+	if(!sqe)
+	{
+		//Ring full (shouldn't happen given MAX_PENDING_SENDS < QUEUE_DEPTH, but don't drop the command)
+		m_pendingSends.pop_back();
+		string tempbuf = cmd + "\n";
+		return m_socket.SendLooped((unsigned char*)tempbuf.c_str(), tempbuf.length());
+	}
+
+	//Chain the previous pending send to this one so TCP ordering is preserved within the batch
+	if(m_lastPendingSqe)
+		m_lastPendingSqe->flags |= IOSQE_IO_LINK;
+
+	int fd = m_socket;
+	io_uring_prep_send(sqe, fd, data.c_str(), data.length(), MSG_NOSIGNAL);
+	m_lastPendingSqe = sqe;
+
+	return true;
+}
+
+/**
+	@brief Submits all chained sends in one syscall and reaps their completions
+
+	Any command that didn't complete fully (short send, or cancelled because an earlier link in the chain
+	failed) is retried on the blocking path, in order, so nothing is silently dropped.
+ */
+void SCPIUringTransport::FlushPendingSends()
+{
+	if(m_pendingSends.empty())
+		return;
+	m_lastPendingSqe = nullptr;
+
+	size_t n = m_pendingSends.size();
+	io_uring_submit(&m_ring);
+
+	vector<int> results(n, -ECANCELED);
+	for(size_t i = 0; i < n; i++)
+	{
+		struct io_uring_cqe* cqe;
+		if(0 != io_uring_wait_cqe(&m_ring, &cqe))
+			break;
+		results[i] = cqe->res;
+		io_uring_cqe_seen(&m_ring, cqe);
+	}
+
+	//Patch up anything that didn't make it onto the wire.
+	//A failed link cancels everything after it, so the blocking retries still go out in order.
+	for(size_t i = 0; i < n; i++)
+	{
+		auto& data = m_pendingSends[i];
+		if(results[i] == (int)data.length())
+			continue;
+		size_t sent = (results[i] > 0) ? (size_t)results[i] : 0;
+		m_socket.SendLooped((unsigned char*)data.c_str() + sent, data.length() - sent);
+	}
+
+	m_pendingSends.clear();
+}
+
+/**
+	@brief Flushes the queued command API, then pushes the resulting send chain to the kernel
+
+	The base class drains the application-level queue into SendCommand() calls; those pile up as one
+	SQE chain here and hit the wire in a single submission.
+ */
+bool SCPIUringTransport::FlushCommandQueue()
+{
+	bool ok = SCPITransport::FlushCommandQueue();
+
+	lock_guard<recursive_mutex> lock(m_netMutex);
+	if(m_ringValid)
+		FlushPendingSends();
+	return ok;
+}
+
+size_t SCPIUringTransport::RecvUpTo(unsigned char* buf, size_t len)
+{
+	if(!m_ringValid)
+		return SCPISocketTransport::RecvUpTo(buf, len);
+
+	//Push any batched commands first, or we'd deadlock waiting for a reply to a command still in our queue
+	FlushPendingSends();
+
+	auto sqe = io_uring_get_sqe(&m_ring);
+	if(!sqe)
+		return SCPISocketTransport::RecvUpTo(buf, len);
+
+	int fd = m_socket;
+	if(m_rxBufRegistered && (buf == &m_rxBuf[0]))
+		io_uring_prep_read_fixed(sqe, fd, buf, len, 0, 0);
+	else
+		io_uring_prep_recv(sqe, fd, buf, len, 0);
+
+	int res = SubmitAndWaitOne();
+	if(res <= 0)
+		return 0;
+	return (size_t)res;
+}
+
+size_t SCPIUringTransport::ReadRawData(size_t len, unsigned char* buf)
+{
+	if(!m_ringValid)
+		return SCPISocketTransport::ReadRawData(len, buf);
+
+	FlushPendingSends();
+
+	//Use up anything already buffered by ReadReply() before touching the socket
+	size_t nbuffered = min(len, m_rxBufEnd - m_rxBufStart);
+	if(nbuffered != 0)
+	{
+		memcpy(buf, &m_rxBuf[m_rxBufStart], nbuffered);
+		m_rxBufStart += nbuffered;
+	}
+
+	//MSG_WAITALL makes the kernel loop internally, so a whole waveform block is normally one submission.
+	//The outer loop only matters if a signal cuts the recv short.
+	size_t pos = nbuffered;
+	int fd = m_socket;
+	while(pos < len)
+	{
+		auto sqe = io_uring_get_sqe(&m_ring);
+		if(!sqe)
+		{
+			if(!m_socket.RecvLooped(buf + pos, len - pos))
+				return 0;
+			break;
+		}
+
+		io_uring_prep_recv(sqe, fd, buf + pos, len - pos, MSG_WAITALL);
+		int res = SubmitAndWaitOne();
+		if(res <= 0)
+		{
+			LogTrace("Failed to get %zu bytes\n", len);
+			return 0;
+		}
+		pos += (size_t)res;
+	}
+
+	LogTrace("Got %zu bytes\n", len);
+	CountRxBytes(len);
+	return len;
+}
+
+void SCPIUringTransport::SendRawData(size_t len, const unsigned char* buf)
+{
+	if(!m_ringValid)
+	{
+		SCPISocketTransport::SendRawData(len, buf);
+		return;
+	}
+
+	//Raw data must land after any batched commands (typically the command that asked for this data)
+	FlushPendingSends();
+
+	size_t pos = 0;
+	int fd = m_socket;
+	while(pos < len)
+	{
+		auto sqe = io_uring_get_sqe(&m_ring);
+		if(!sqe)
+		{
+			m_socket.SendLooped(buf + pos, len - pos);
+			return;
+		}
+
+		io_uring_prep_send(sqe, fd, buf + pos, len - pos, MSG_NOSIGNAL);
+		int res = SubmitAndWaitOne();
+		if(res <= 0)
+			return;
+		pos += (size_t)res;
+	}
+	CountTxBytes(len);
+}
+
+#endif
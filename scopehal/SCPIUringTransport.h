@@ -0,0 +1,97 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Declaration of SCPIUringTransport
+ */
+
+#ifdef HAS_LIBURING
+
+#ifndef SCPIUringTransport_h
+#define SCPIUringTransport_h
+
+#include "SCPISocketTransport.h"
+
+#include <liburing.h>
+#include <deque>
+
+/**
+	@brief A TCP SCPI transport doing its I/O through io_uring (Linux only)
+
+	Wire protocol and argument format are identical to SCPISocketTransport ("lan"); only the syscall pattern differs.
+	Commands accumulate as a linked chain of send SQEs and go to the kernel in a single submission when the command
+	queue is flushed or a reply is needed, so a burst of setup commands costs one syscall instead of one per command.
+	Bulk reads use MSG_WAITALL so a whole waveform block normally completes in a single submission, and the RX
+	staging buffer is registered with the ring to skip per-operation page pinning on reply reads.
+
+	If ring setup fails (old kernel, locked-down container, etc.) everything falls back to the blocking socket path.
+ */
+class SCPIUringTransport : public SCPISocketTransport
+{
+public:
+	SCPIUringTransport(const std::string& args);
+	virtual ~SCPIUringTransport();
+
+	static std::string GetTransportName();
+
+	virtual bool SendCommand(const std::string& cmd) override;
+	virtual size_t ReadRawData(size_t len, unsigned char* buf) override;
+	virtual void SendRawData(size_t len, const unsigned char* buf) override;
+
+	virtual bool FlushCommandQueue() override;
+
+	TRANSPORT_INITPROC(SCPIUringTransport)
+
+protected:
+	virtual size_t RecvUpTo(unsigned char* buf, size_t len) override;
+
+	void FlushPendingSends();
+	int SubmitAndWaitOne();
+
+	///@brief The ring all of our I/O goes through
+	struct io_uring m_ring;
+
+	///@brief True if ring setup succeeded (otherwise we use the inherited blocking path)
+	bool m_ringValid;
+
+	///@brief True if the RX staging buffer is registered with the ring
+	bool m_rxBufRegistered;
+
+	///@brief Commands prepped as send SQEs but not yet submitted (deque so element addresses stay stable)
+	std::deque<std::string> m_pendingSends;
+
+	///@brief SQE of the newest pending send, so the next one can be chained to it
+	struct io_uring_sqe* m_lastPendingSqe;
+};
+
+#endif
+
+#endif
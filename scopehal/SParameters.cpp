@@ -200,6 +200,88 @@ float SParameterVector::InterpolateAngle(float frequency) const
 	return InterpolatePoint(frequency).m_phase;
 }
 
+/**
+	@brief Resamples the network onto a uniform frequency grid, producing separate magnitude / phase arrays
+
+	Functionally equivalent to calling InterpolatePoint() once per bin, but since the output grid is monotonic
+	the straddling input points only ever advance: one sequential merge-style pass over the dataset replaces a
+	binary search (with log(n) scattered reads) per bin. Output is struct-of-arrays float buffers, suitable for
+	direct GPU upload (the frequency axis is implicit in the grid).
+ */
+void SParameterVector::InterpolateUniformGrid(
+	double bin_hz,
+	size_t nouts,
+	AcceleratorBuffer<float>& amplitudes,
+	AcceleratorBuffer<float>& phases) const
+{
+	amplitudes.resize(nouts);
+	phases.resize(nouts);
+	amplitudes.PrepareForCpuAccess();
+	phases.PrepareForCpuAccess();
+
+	size_t len = m_points.size();
+	if(len == 0)
+	{
+		for(size_t i=0; i<nouts; i++)
+		{
+			amplitudes[i] = 0;
+			phases[i] = 0;
+		}
+		amplitudes.MarkModifiedFromCpu();
+		phases.MarkModifiedFromCpu();
+		return;
+	}
+
+	float fmin = m_points[0].m_frequency;
+	float fmax = m_points[len-1].m_frequency;
+	size_t lo = 0;
+
+	for(size_t i=0; i<nouts; i++)
+	{
+		float frequency = bin_hz * i;
+
+		//If out of range, clip (same rules as InterpolatePoint)
+		if(frequency < fmin)
+		{
+			//Use insertion loss of the lowest point, but interpolate phase to zero at time zero
+			amplitudes[i] = m_points[0].m_amplitude;
+			phases[i] = InterpolatePhase(0, m_points[0].m_phase, frequency / fmin);
+		}
+		else if(frequency > fmax)
+		{
+			amplitudes[i] = 0;
+			phases[i] = 0;
+		}
+		else
+		{
+			//Advance to the pair of points straddling this bin (never moves backwards)
+			while( (lo+1 < len-1) && (m_points[lo+1].m_frequency < frequency) )
+				lo++;
+			size_t hi = lo + 1;
+			if(hi >= len)
+				hi = len - 1;
+
+			//Find position between the points for interpolation
+			float freq_lo = m_points[lo].m_frequency;
+			float freq_hi = m_points[hi].m_frequency;
+			float dfreq = freq_hi - freq_lo;
+			float frac;
+			if(dfreq > FLT_EPSILON)
+				frac = (frequency - freq_lo) / dfreq;
+			else
+				frac = 0;
+
+			float amp_lo = m_points[lo].m_amplitude;
+			float amp_hi = m_points[hi].m_amplitude;
+			amplitudes[i] = amp_lo + (amp_hi - amp_lo)*frac;
+			phases[i] = InterpolatePhase(m_points[lo].m_phase, m_points[hi].m_phase, frac);
+		}
+	}
+
+	amplitudes.MarkModifiedFromCpu();
+	phases.MarkModifiedFromCpu();
+}
+
 /**
 	@brief Gets the group delay at a given bin
  */
@@ -255,23 +337,24 @@ void SParameters::Allocate(int nports)
 /**
 	@brief Serializes a S-parameter model to a Touchstone file
 
-	For now, assumes full 2 port
+	Points are formatted in parallel, a few thousand per chunk, then the chunks are written sequentially;
+	a dense measured sweep exports at memory bandwidth rather than being serialized behind per-point fprintf
+	calls. The optional window clips the export to a frequency band and/or decimates it, so writing out one
+	band of interest from a deep sweep only formats the points that land in the file.
 
 	@param path		Output file name
 	@param format	Output data format
 	@param freqUnit	Frequency units for the generated file
+	@param window	Frequency range / decimation to export (defaults to the whole network)
  */
-void SParameters::SaveToFile(const string& path, ParameterFormat format, FreqUnit freqUnit)
+void SParameters::SaveToFile(const string& path, ParameterFormat format, FreqUnit freqUnit, const ExportWindow& window)
 {
-	if(m_nports != 2)
+	if(m_nports < 1)
 	{
-		LogError("SParameters::SaveToFile() only supports 2-port for now\n");
+		LogError("SParameters::SaveToFile() called with no ports allocated\n");
 		return;
 	}
 
-	if(format != FORMAT_MAG_ANGLE)
-		LogWarning("Formats other than mag-angle not implemented yet (exporting as mag-angle)\n");
-
 	FILE* fp = fopen(path.c_str(), "w");
 	if(!fp)
 	{
@@ -305,24 +388,135 @@ void SParameters::SaveToFile(const string& path, ParameterFormat format, FreqUni
 			freqScale = 1e-9;
 			break;
 	}
-	fprintf(fp, "# %s S MA R 50.000\n", freqText.c_str());
 
-	//Get the parameters
-	auto& s11 = (*this)[SPair(1, 1)];
-	auto& s12 = (*this)[SPair(1, 2)];
-	auto& s21 = (*this)[SPair(2, 1)];
-	auto& s22 = (*this)[SPair(2, 2)];
+	string formatText;
+	switch(format)
+	{
+		case FORMAT_DBMAG_ANGLE:
+			formatText = "DB";
+			break;
 
-	//Mag-angle format
+		case FORMAT_REAL_IMAGINARY:
+			formatText = "RI";
+			break;
+
+		case FORMAT_MAG_ANGLE:
+		default:
+			formatText = "MA";
+			break;
+	}
+	fprintf(fp, "# %s S %s R 50.000\n", freqText.c_str(), formatText.c_str());
+
+	//Gather the parameters in file order: the 2-port format is column major (S11 S21 S12 S22),
+	//everything else is row major
+	vector<const SParameterVector*> elements;
+	if(m_nports == 2)
+	{
+		elements.push_back(&(*this)[SPair(1, 1)]);
+		elements.push_back(&(*this)[SPair(2, 1)]);
+		elements.push_back(&(*this)[SPair(1, 2)]);
+		elements.push_back(&(*this)[SPair(2, 2)]);
+	}
+	else
+	{
+		for(size_t to=1; to <= m_nports; to++)
+		{
+			for(size_t from=1; from <= m_nports; from++)
+				elements.push_back(&(*this)[SPair(to, from)]);
+		}
+	}
+	auto& ref = *elements[0];
+
+	//Select the points to export: clip to the window, then keep every Nth survivor
+	size_t decimation = max(window.m_decimation, static_cast<size_t>(1));
+	vector<size_t> points;
+	size_t kept = 0;
+	for(size_t i=0; i<ref.size(); i++)
+	{
+		float freq = ref[i].m_frequency;
+		if(freq < window.m_minFreq)
+			continue;
+		if(freq > window.m_maxFreq)
+			break;
+		if( (kept++ % decimation) == 0)
+			points.push_back(i);
+	}
+
+	//Format the output in parallel, one chunk of points per string
 	float rad2deg = 180 / M_PI;
-	for(size_t i=0; i<s11.size(); i++)
+	const size_t chunksize = 4096;
+	size_t nchunks = (points.size() + chunksize - 1) / chunksize;
+	vector<string> chunks(nchunks);
+
+	#pragma omp parallel for
+	for(size_t c=0; c<nchunks; c++)
 	{
-		float freq = s11[i].m_frequency;
-		fprintf(fp, "%f %f %f %f %f %f %f %f %f\n", freq * freqScale,
-			s11[i].m_amplitude, s11[i].m_phase * rad2deg,
-			s21[i].m_amplitude, s21[i].m_phase * rad2deg,
-			s12[i].m_amplitude, s12[i].m_phase * rad2deg,
-			s22[i].m_amplitude, s22[i].m_phase * rad2deg);
+		auto& out = chunks[c];
+		out.reserve(chunksize * (16 + 24*elements.size()));
+
+		size_t end = min( (c+1)*chunksize, points.size());
+		char tmp[64];
+		for(size_t k=c*chunksize; k<end; k++)
+		{
+			size_t i = points[k];
+
+			snprintf(tmp, sizeof(tmp), "%f", ref[i].m_frequency * freqScale);
+			out += tmp;
+
+			for(size_t e=0; e<elements.size(); e++)
+			{
+				auto& vec = *elements[e];
+
+				float a = 0;
+				float b = 0;
+				if(i < vec.size())
+				{
+					float amp = vec[i].m_amplitude;
+					float phase = vec[i].m_phase;
+					switch(format)
+					{
+						case FORMAT_DBMAG_ANGLE:
+							a = 20 * log10(amp);
+							b = phase * rad2deg;
+							break;
+
+						case FORMAT_REAL_IMAGINARY:
+							a = amp * cos(phase);
+							b = amp * sin(phase);
+							break;
+
+						case FORMAT_MAG_ANGLE:
+						default:
+							a = amp;
+							b = phase * rad2deg;
+							break;
+					}
+				}
+				snprintf(tmp, sizeof(tmp), " %f %f", a, b);
+				out += tmp;
+
+				//For 3+ ports, each matrix row starts on its own line, with at most four parameters per line
+				if(m_nports > 2)
+				{
+					size_t col = e % m_nports;
+					bool rowEnd = (col == (m_nports - 1));
+					bool lineFull = ( (col % 4) == 3);
+					if( (rowEnd || lineFull) && (e+1 < elements.size()) )
+						out += "\n\t";
+				}
+			}
+			out += "\n";
+		}
+	}
+
+	//Write the chunks out in order
+	for(size_t c=0; c<nchunks; c++)
+	{
+		if(chunks[c].size() != fwrite(chunks[c].data(), 1, chunks[c].size(), fp))
+		{
+			LogError("Write error exporting %s\n", path.c_str());
+			break;
+		}
 	}
 
 	fclose(fp);
@@ -35,6 +35,7 @@
 #ifndef SParameters_h
 #define SParameters_h
 
+#include <cfloat>
 #include <complex>
 
 /**
@@ -172,6 +173,12 @@ public:
 	float InterpolateMagnitude(float frequency) const;
 	float InterpolateAngle(float frequency) const;
 
+	void InterpolateUniformGrid(
+		double bin_hz,
+		size_t nouts,
+		AcceleratorBuffer<float>& amplitudes,
+		AcceleratorBuffer<float>& phases) const;
+
 	AcceleratorBuffer<SParameterPoint> m_points;
 
 	void resize(size_t nsize)
@@ -238,7 +245,35 @@ public:
 		FORMAT_REAL_IMAGINARY
 	};
 
-	void SaveToFile(const std::string& path, ParameterFormat format = FORMAT_MAG_ANGLE, FreqUnit freqUnit = FREQ_GHZ);
+	/**
+		@brief Optional windowing of a Touchstone export (see SaveToFile)
+
+		The defaults export the full network. Clipping and decimation happen at export, so writing one band of
+		a dense sweep only formats the points that end up in the file.
+	 */
+	struct ExportWindow
+	{
+		ExportWindow()
+			: m_minFreq(0)
+			, m_maxFreq(FLT_MAX)
+			, m_decimation(1)
+		{}
+
+		///@brief Lowest frequency to export, in Hz
+		float m_minFreq;
+
+		///@brief Highest frequency to export, in Hz
+		float m_maxFreq;
+
+		///@brief Keep every Nth point within the frequency range (1 = all)
+		size_t m_decimation;
+	};
+
+	void SaveToFile(
+		const std::string& path,
+		ParameterFormat format = FORMAT_MAG_ANGLE,
+		FreqUnit freqUnit = FREQ_GHZ,
+		const ExportWindow& window = ExportWindow());
 
 	size_t GetNumPorts() const
 	{ return m_nports; }
@@ -38,9 +38,15 @@
 #include <windows.h>
 #else
 #include <time.h>
+#include <unistd.h>
+#endif
+
+#ifdef __linux__
+#include <sched.h>
 #endif
 
 #include <cstdint>
+#include <cstdio>
 
 double GetTime()
 {
@@ -61,3 +67,46 @@ double GetTime()
 	return d;
 #endif
 }
+
+/**
+	@brief Returns the number of NUMA nodes in the system (1 on single node machines and unsupported platforms)
+ */
+size_t GetNumaNodeCount()
+{
+#ifdef __linux__
+	static size_t count = []()
+	{
+		size_t n = 0;
+		while(true)
+		{
+			char path[128];
+			snprintf(path, sizeof(path), "/sys/devices/system/node/node%zu/cpulist", n);
+			if(0 != access(path, R_OK))
+				break;
+			n++;
+		}
+		return (n == 0) ? static_cast<size_t>(1) : n;
+	}();
+	return count;
+#else
+	return 1;
+#endif
+}
+
+/**
+	@brief Returns the NUMA node the calling thread is currently running on (0 if unknown)
+
+	Sampled per call; the scheduler may migrate the thread at any time, so treat the result as a locality
+	hint rather than an identity (pinned threads excepted).
+ */
+size_t GetCurrentNumaNode()
+{
+#ifdef __linux__
+	unsigned int node = 0;
+	if(0 != getcpu(nullptr, &node))
+		return 0;
+	return node;
+#else
+	return 0;
+#endif
+}
@@ -36,6 +36,11 @@
 #ifndef ScopehalUtil_h
 #define ScopehalUtil_h
 
+#include <cstddef>
+
 double GetTime();
 
+size_t GetNumaNodeCount();
+size_t GetCurrentNumaNode();
+
 #endif
\ No newline at end of file
@@ -0,0 +1,182 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief  Implementation of ScratchBufferPool
+ */
+#include "scopehal.h"
+#include "ScratchBufferPool.h"
+
+using namespace std;
+
+///@brief Process-wide pool for recycling filter scratch buffers
+ScratchBufferPool g_scratchBufferPool;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Construction / destruction
+
+ScratchBufferPool::ScratchBufferPool(size_t memoryBudget)
+	: m_memoryBudget(memoryBudget)
+	, m_totalBytes(0)
+	, m_useCounter(0)
+{
+}
+
+ScratchBufferPool::~ScratchBufferPool()
+{
+	for(auto& it : m_freeLists)
+	{
+		for(size_t i=0; i<NUM_BUCKETS; i++)
+		{
+			for(auto& entry : it.second[i])
+				delete entry.m_buffer;
+		}
+	}
+	m_freeLists.clear();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Pool operations
+
+/**
+	@brief Checks out a scratch buffer of (at least) the requested element count
+
+	Returns the most recently returned buffer from the smallest suitable bucket of the queue's free list, or
+	allocates a fresh one if nothing suitable is free. Contents are undefined.
+
+	@param queue	Queue the borrower will execute on. Buffers are only recycled within the same queue.
+	@param size		Minimum element count; the buffer is resized to exactly this
+ */
+AcceleratorBuffer<float>* ScratchBufferPool::Checkout(QueueHandle* queue, size_t size)
+{
+	AcceleratorBuffer<float>* buf = nullptr;
+
+	{
+		lock_guard<mutex> lock(m_mutex);
+
+		auto it = m_freeLists.find(queue);
+		if(it != m_freeLists.end())
+		{
+			//Find the smallest bucket with a free buffer big enough for the request
+			auto& buckets = it->second;
+			for(size_t i = GetBucketIndex(size * sizeof(float)); i < NUM_BUCKETS; i++)
+			{
+				if(!buckets[i].empty())
+				{
+					auto entry = buckets[i].front();
+					buckets[i].pop_front();
+					m_totalBytes -= entry.m_bytes;
+					buf = entry.m_buffer;
+					break;
+				}
+			}
+		}
+	}
+
+	//Nothing suitable pooled, make a new one
+	if(!buf)
+	{
+		buf = new AcceleratorBuffer<float>("ScratchBufferPool.buffer");
+		buf->SetCpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
+		buf->SetGpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
+	}
+
+	buf->resize(size);
+	return buf;
+}
+
+/**
+	@brief Returns a scratch buffer to the pool, evicting the least recently returned buffers if over budget
+
+	@param queue	Queue the buffer was checked out for. Must match the Checkout() call.
+	@param buf		The borrowed buffer
+ */
+void ScratchBufferPool::Checkin(QueueHandle* queue, AcceleratorBuffer<float>* buf)
+{
+	lock_guard<mutex> lock(m_mutex);
+
+	PooledBuffer entry;
+	entry.m_buffer = buf;
+	entry.m_bytes = buf->capacity() * sizeof(float);
+	entry.m_lastUse = m_useCounter ++;
+
+	m_freeLists[queue][GetBucketIndex(entry.m_bytes)].push_front(entry);
+	m_totalBytes += entry.m_bytes;
+
+	ShrinkToBudget();
+}
+
+/**
+	@brief Frees the least recently returned buffers until we're back under the memory budget
+
+	Caller must hold m_mutex.
+ */
+void ScratchBufferPool::ShrinkToBudget()
+{
+	while(m_totalBytes > m_memoryBudget)
+	{
+		//The back of each bucket is its oldest entry, so the eviction candidate is the oldest of the backs
+		list<PooledBuffer>* victim = nullptr;
+		uint64_t oldest = UINT64_MAX;
+		for(auto& it : m_freeLists)
+		{
+			for(size_t i=0; i<NUM_BUCKETS; i++)
+			{
+				auto& bucket = it.second[i];
+				if(!bucket.empty() && (bucket.back().m_lastUse < oldest))
+				{
+					oldest = bucket.back().m_lastUse;
+					victim = &bucket;
+				}
+			}
+		}
+
+		//Nothing left to evict
+		if(!victim)
+			break;
+
+		auto& entry = victim->back();
+		m_totalBytes -= entry.m_bytes;
+		delete entry.m_buffer;
+		victim->pop_back();
+	}
+}
+
+/**
+	@brief Returns the bucket index for a buffer of the given allocated size (bucket i holds up to 2^i bytes)
+ */
+size_t ScratchBufferPool::GetBucketIndex(size_t bytes)
+{
+	size_t i = 0;
+	while( ( (static_cast<size_t>(1) << i) < bytes) && (i < NUM_BUCKETS-1) )
+		i ++;
+	return i;
+}
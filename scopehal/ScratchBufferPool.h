@@ -0,0 +1,135 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief  Declaration of ScratchBufferPool
+ */
+#ifndef ScratchBufferPool_h
+#define ScratchBufferPool_h
+
+#include <array>
+#include <list>
+
+/**
+	@brief Thread safe checkout/checkin registry for transient GPU scratch buffers
+
+	FFT-family filters need waveform-sized temporary buffers during Refresh() but not between refreshes. Keeping
+	those as permanent members means every instantiated filter holds its own copy of scratch space that is idle
+	almost all of the time. Borrowing from this pool instead means the steady-state footprint is set by the number
+	of filters *running* concurrently, not the number instantiated.
+
+	Free buffers are binned by power-of-two capacity so a checkout is steered to a recycled buffer of similar size,
+	and the free lists are segregated by the queue the borrower executes on: a buffer is only ever recycled onto the
+	queue that last touched it, so reuse is serialized by queue order and no cross-queue hazard can occur even if a
+	borrower checks in before its GPU work has drained. All pooled buffers are created with HINT_LIKELY access from
+	both CPU and GPU.
+
+	Total bytes held are capped by a budget; least recently returned buffers are freed when the cap is exceeded.
+ */
+class ScratchBufferPool
+{
+public:
+	ScratchBufferPool(size_t memoryBudget = 256 * 1024 * 1024);
+	~ScratchBufferPool();
+
+	AcceleratorBuffer<float>* Checkout(QueueHandle* queue, size_t size);
+	void Checkin(QueueHandle* queue, AcceleratorBuffer<float>* buf);
+
+protected:
+
+	///@brief A free buffer plus the bookkeeping needed for budgeting and eviction
+	struct PooledBuffer
+	{
+		AcceleratorBuffer<float>* m_buffer;
+
+		///@brief Allocated bytes, sampled when the buffer was checked in
+		size_t m_bytes;
+
+		///@brief Value of m_useCounter when the buffer was checked in (for LRU eviction)
+		uint64_t m_lastUse;
+	};
+
+	size_t GetBucketIndex(size_t bytes);
+	void ShrinkToBudget();
+
+	///@brief Maximum number of bytes the pool may hold before evicting
+	size_t m_memoryBudget;
+
+	///@brief Total bytes currently held across all queues and buckets
+	size_t m_totalBytes;
+
+	///@brief Monotonically increasing counter used to order entries for LRU eviction
+	uint64_t m_useCounter;
+
+	std::mutex m_mutex;
+
+	///@brief Number of size buckets (bucket i holds buffers of up to 2^i bytes)
+	static const size_t NUM_BUCKETS = 48;
+
+	///@brief Free lists keyed by owning queue, binned by power-of-two allocation size
+	std::map<QueueHandle*, std::array<std::list<PooledBuffer>, NUM_BUCKETS>> m_freeLists;
+};
+
+//Process-wide pool shared by all filters
+extern ScratchBufferPool g_scratchBufferPool;
+
+/**
+	@brief RAII checkout of a scratch buffer for the duration of a filter's Refresh()
+
+	Checks a buffer of (at least) the requested element count out of g_scratchBufferPool on construction and
+	returns it when it goes out of scope. Contents are undefined at checkout.
+ */
+class ScratchBuffer
+{
+public:
+	ScratchBuffer(std::shared_ptr<QueueHandle> queue, size_t size)
+		: m_queue(queue.get())
+		, m_buf(g_scratchBufferPool.Checkout(m_queue, size))
+	{}
+
+	~ScratchBuffer()
+	{ g_scratchBufferPool.Checkin(m_queue, m_buf); }
+
+	ScratchBuffer(const ScratchBuffer&) = delete;
+	ScratchBuffer& operator=(const ScratchBuffer&) = delete;
+
+	AcceleratorBuffer<float>& Get()
+	{ return *m_buf; }
+
+	operator AcceleratorBuffer<float>&()
+	{ return *m_buf; }
+
+protected:
+	QueueHandle* m_queue;
+	AcceleratorBuffer<float>* m_buf;
+};
+
+#endif
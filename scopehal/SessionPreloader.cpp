@@ -0,0 +1,117 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief  Implementation of SessionPreloader
+ */
+#include "scopehal.h"
+#include "SessionPreloader.h"
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Preload tasks
+
+/**
+	@brief Starts Vulkan initialization (device creation, pipeline cache load, FFT library setup) on a worker thread
+
+	Defaults to skipping GLFW since headless daemons have no window system. The returned future yields the
+	VulkanInit() result; nothing that touches the GPU may run before it resolves true.
+ */
+future<bool> SessionPreloader::PreloadVulkan(bool skipGLFW)
+{
+	return async(launch::async, [skipGLFW]
+	{ return VulkanInit(skipGLFW); });
+}
+
+/**
+	@brief Starts connecting a transport on a worker thread
+
+	The returned future yields the connected transport (caller takes ownership), or null on failure.
+ */
+future<SCPITransport*> SessionPreloader::PreloadTransport(const string& transport, const string& args)
+{
+	return async(launch::async, [transport, args]() -> SCPITransport*
+	{
+		auto t = SCPITransport::CreateTransport(transport, args);
+		if(t && !t->IsConnected())
+		{
+			delete t;
+			return nullptr;
+		}
+		return t;
+	});
+}
+
+/**
+	@brief Starts connecting a transport and constructing an instrument driver on a worker thread
+
+	Driver construction is where capability probing happens, so this is typically the longest leg of startup and
+	the most valuable to overlap with Vulkan init. The returned future yields the instrument, or null if either
+	the transport or the driver failed to come up.
+ */
+future<shared_ptr<Oscilloscope>> SessionPreloader::PreloadOscilloscope(
+	const string& driver,
+	const string& transport,
+	const string& args)
+{
+	return async(launch::async, [driver, transport, args]() -> shared_ptr<Oscilloscope>
+	{
+		auto t = SCPITransport::CreateTransport(transport, args);
+		if(!t)
+			return nullptr;
+		if(!t->IsConnected())
+		{
+			delete t;
+			return nullptr;
+		}
+
+		//Driver takes ownership of the transport
+		return Oscilloscope::CreateOscilloscope(driver, t);
+	});
+}
+
+/**
+	@brief Starts connecting a whole rack of instruments, one worker thread per instrument
+
+	Each instrument's transport connect and capability probe proceeds independently, so total connect time
+	for the rack is the slowest single instrument rather than the sum. Futures are returned in descriptor
+	order; a failed connect yields null in that slot without disturbing the others.
+ */
+vector<future<shared_ptr<Oscilloscope>>> SessionPreloader::PreloadOscilloscopes(
+	const vector<InstrumentDescriptor>& instruments)
+{
+	vector<future<shared_ptr<Oscilloscope>>> ret;
+	ret.reserve(instruments.size());
+	for(auto& inst : instruments)
+		ret.push_back(PreloadOscilloscope(inst.m_driver, inst.m_transport, inst.m_args));
+	return ret;
+}
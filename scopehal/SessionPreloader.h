@@ -0,0 +1,82 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief  Declaration of SessionPreloader
+ */
+#ifndef SessionPreloader_h
+#define SessionPreloader_h
+
+#include <future>
+
+/**
+	@brief Concurrent startup helper for headless capture daemons
+
+	Cold start of a session is dominated by a few independent, slow steps: Vulkan device creation and pipeline
+	warmup, transport connection, and instrument capability probing. Run sequentially they add up to many seconds;
+	none of them depend on each other until the filter graph is built.
+
+	SessionPreloader launches each subsystem on its own thread and hands back a std::future as the explicit join
+	point, so a daemon can overlap all of them and only block where a result is actually consumed:
+
+		auto vk = SessionPreloader::PreloadVulkan();
+		auto scope = SessionPreloader::PreloadOscilloscope("siglent", "lan", "192.0.2.10");
+		//...build filter graph skeleton, load session config, etc...
+		if(!vk.get())
+			return 1;
+		auto inst = scope.get();	//joins; capability probe ran concurrently with Vulkan init
+
+	Instrument-side probe time can be cut further across restarts by the warm state file: see
+	SCPIInstrument::LoadStateCacheFromDisk() / SaveStateCacheToDisk().
+ */
+class SessionPreloader
+{
+public:
+	static std::future<bool> PreloadVulkan(bool skipGLFW = true);
+	static std::future<SCPITransport*> PreloadTransport(const std::string& transport, const std::string& args);
+	static std::future<std::shared_ptr<Oscilloscope>> PreloadOscilloscope(
+		const std::string& driver,
+		const std::string& transport,
+		const std::string& args);
+
+	///@brief Connection info for one instrument in a batch connect
+	struct InstrumentDescriptor
+	{
+		std::string m_driver;
+		std::string m_transport;
+		std::string m_args;
+	};
+
+	static std::vector<std::future<std::shared_ptr<Oscilloscope>>> PreloadOscilloscopes(
+		const std::vector<InstrumentDescriptor>& instruments);
+};
+
+#endif
@@ -1532,6 +1532,9 @@ bool SiglentSCPIOscilloscope::ReadWavedescs(
 		any_enabled |= enabled[i];
 	}
 
+	//Request all of the preambles in a single burst, then read them back to back
+	vector<string> queries;
+	vector<unsigned int> qchans;
 	for(unsigned int i = 0; i < m_analogChannelCount; i++)
 	{
 		if(enabled[i] || (!any_enabled && i == 0))
@@ -1539,15 +1542,21 @@ bool SiglentSCPIOscilloscope::ReadWavedescs(
 			if(firstEnabledChannel == UINT_MAX)
 				firstEnabledChannel = i;
 
-			m_transport->SendCommand(":WAVEFORM:SOURCE C" + to_string(i + 1) + ";:WAVEFORM:PREAMBLE?");
-			if(WAVEDESC_SIZE != ReadWaveformBlock(WAVEDESC_SIZE, wavedescs[i]))
-				LogError("ReadWaveformBlock for wavedesc %u failed\n", i);
-
-			// I have no idea why this is needed, but it certainly is
-			m_transport->ReadReply();
+			queries.push_back(":WAVEFORM:SOURCE C" + to_string(i + 1) + ";:WAVEFORM:PREAMBLE?");
+			qchans.push_back(i);
 		}
 	}
 
+	BatchPull(queries, [&](size_t n)
+	{
+		unsigned int i = qchans[n];
+		if(WAVEDESC_SIZE != ReadWaveformBlock(WAVEDESC_SIZE, wavedescs[i]))
+			LogError("ReadWaveformBlock for wavedesc %u failed\n", i);
+
+		// I have no idea why this is needed, but it certainly is
+		m_transport->ReadReply();
+	});
+
 	return true;
 }
 
@@ -1916,6 +1925,9 @@ bool SiglentSCPIOscilloscope::AcquireData()
 	double* pwtime = NULL;
 	char tmp[128];
 
+	//Worker threads converting raw blocks to waveforms, overlapped with the next channel's network read
+	vector<thread> convertThreads;
+
 	//Acquire the data (but don't parse it)
 
 	lock_guard<recursive_mutex> lock(m_transport->GetMutex());
@@ -1939,16 +1951,57 @@ bool SiglentSCPIOscilloscope::AcquireData()
 				any_enabled |= enabled[i];
 			}
 			start = GetTime();
-			for(unsigned int i = 0; i < m_analogChannelCount; i++)
+			waveforms.resize(m_analogChannelCount);
 			{
-				if(enabled[i])
+				//Request all enabled channels' data in one burst, then read the blocks back to back
+				vector<string> queries;
+				vector<unsigned int> qchans;
+				for(unsigned int i = 0; i < m_analogChannelCount; i++)
 				{
-					m_transport->SendCommand("C" + to_string(i + 1) + ":WAVEFORM? DAT2");
-					// length of data is current memory depth
-					m_analogWaveformDataSize[i] = ReadWaveformBlock(WAVEFORM_SIZE, m_analogWaveformData[i]);
-					// This is the 0x0a0a at the end
-					m_transport->ReadRawData(2, (unsigned char*)tmp);
+					if(enabled[i])
+					{
+						queries.push_back("C" + to_string(i + 1) + ":WAVEFORM? DAT2");
+						qchans.push_back(i);
+					}
 				}
+				BatchPull(queries, [&](size_t n)
+					{
+						unsigned int i = qchans[n];
+
+						// length of data is current memory depth
+						m_analogWaveformDataSize[i] = ReadWaveformBlock(WAVEFORM_SIZE, m_analogWaveformData[i]);
+						// This is the 0x0a0a at the end
+						m_transport->ReadRawData(2, (unsigned char*)tmp);
+
+						//Kick off conversion of this channel while the next one's block downloads.
+						//Grab cached scale factors here so the worker never touches the transport
+						//(we hold the net mutex for the rest of this function)
+						float gain = m_channelVoltageRanges[i] / (8 * 25);
+						float offset = m_channelOffsets[i];
+						convertThreads.emplace_back(
+							[this, i, start, gain, offset, h_off_frac, &waveforms]()
+							{
+								auto cap = new UniformAnalogWaveform;
+								cap->m_timescale = FS_PER_SECOND / m_sampleRate;
+								// no high res timer on scope ?
+								cap->m_triggerPhase = h_off_frac;
+								cap->m_startTimestamp = time(NULL);
+								// Fixme
+								cap->m_startFemtoseconds = (start - floor(start)) * FS_PER_SECOND;
+
+								cap->Resize(m_analogWaveformDataSize[i]);
+								cap->PrepareForCpuAccess();
+
+								Convert8BitSamples(
+									cap->m_samples.GetCpuPointer(),
+									(int8_t*)m_analogWaveformData[i],
+									gain,
+									offset,
+									m_analogWaveformDataSize[i]);
+								cap->MarkSamplesModifiedFromCpu();
+								waveforms[i].push_back(cap);
+							});
+					});
 			}
 			//At this point all data has been read so the scope is free to go do
 			//its thing while we crunch the results.  Re-arm the trigger if not
@@ -1959,43 +2012,9 @@ bool SiglentSCPIOscilloscope::AcquireData()
 				m_triggerArmed = true;
 			}
 
-			//Process analog waveforms
-			waveforms.resize(m_analogChannelCount);
-			for(unsigned int i = 0; i < m_analogChannelCount; i++)
-			{
-				std::vector<WaveformBase*> ret;
-				if(m_channelsEnabled[i])
-				{
-					auto cap = new UniformAnalogWaveform;
-					cap->m_timescale = FS_PER_SECOND / m_sampleRate;
-					// no high res timer on scope ?
-					cap->m_triggerPhase = h_off_frac;
-					cap->m_startTimestamp = time(NULL);
-					// Fixme
-					cap->m_startFemtoseconds = (start - floor(start)) * FS_PER_SECOND;
-
-					cap->Resize(m_analogWaveformDataSize[i]);
-					cap->PrepareForCpuAccess();
-
-					Convert8BitSamples(
-						cap->m_samples.GetCpuPointer(),
-						(int8_t*)m_analogWaveformData[i],
-						m_channelVoltageRanges[i] / (8 * 25),
-						m_channelOffsets[i],
-						m_analogWaveformDataSize[i]);
-					cap->MarkSamplesModifiedFromCpu();
-					ret.push_back(cap);
-				}
-#if (defined(__GNUC__) && !defined(__clang__))
-//WORKAROUND likely GCC bug in newer versions
-#pragma GCC diagnostic push
-#pragma GCC diagnostic warning "-Warray-bounds"
-#endif
-				waveforms[i] = ret;
-#if (defined(__GNUC__) && !defined(__clang__))
-#pragma GCC diagnostic pop
-#endif
-			}
+			//Wait for the conversion workers to finish
+			for(auto& t : convertThreads)
+				t.join();
 
 			//Save analog waveform data
 			for(unsigned int i = 0; i < m_analogChannelCount; i++)
@@ -2078,17 +2097,45 @@ bool SiglentSCPIOscilloscope::AcquireData()
 				//2000X+ HD running firmware 1.1.7.0 seems to report size in bytes.
 				bool hdWorkaround = m_requireSizeWorkaround && m_highDefinition;
 
-				//Read the data from each analog waveform
+				//Read the data from each analog waveform, kicking off conversion of each channel on a worker
+				//thread as soon as its block arrives so the crunching overlaps with the next channel's network read
+				waveforms.resize(m_analogChannelCount);
+				vector<string> queries;
+				vector<unsigned int> qchans;
 				for(unsigned int i = 0; i < m_analogChannelCount; i++)
 				{
 					if(enabled[i])
 					{
-						m_transport->SendCommand(":WAVEFORM:SOURCE C" + to_string(i + 1) + ";:WAVEFORM:DATA?");
+						queries.push_back(":WAVEFORM:SOURCE C" + to_string(i + 1) + ";:WAVEFORM:DATA?");
+						qchans.push_back(i);
+
+						//Warm the voltage range cache so the worker never needs the transport.
+						//This has to happen before the burst goes out: a cache miss mid-burst would
+						//interleave the range query's reply with the waveform blocks
+						GetChannelVoltageRange(i, 0);
+					}
+				}
+
+				BatchPull(queries, [&](size_t n)
+					{
+						unsigned int i = qchans[n];
 						m_analogWaveformDataSize[i] = ReadWaveformBlock(WAVEFORM_SIZE, m_analogWaveformData[i], hdWorkaround);
 						// This is the 0x0a0a at the end
 						m_transport->ReadRawData(2, (unsigned char*)tmp);
-					}
-				}
+
+						convertThreads.emplace_back(
+							[this, i, num_sequences, ttime, basetime, pwtime, &waveforms]()
+							{
+								waveforms[i] = ProcessAnalogWaveform(&m_analogWaveformData[i][0],
+									m_analogWaveformDataSize[i],
+									&m_wavedescs[i][0],
+									num_sequences,
+									ttime,
+									basetime,
+									pwtime,
+									i);
+							});
+					});
 			}
 
 			//Read the data from the digital waveforms, if enabled
@@ -2097,6 +2144,10 @@ bool SiglentSCPIOscilloscope::AcquireData()
 				if(!ReadWaveformBlock(WAVEFORM_SIZE, m_digitalWaveformDataBytes))
 				{
 					LogDebug("failed to download digital waveform\n");
+
+					//Don't leak the conversion workers (destroying a joinable thread aborts)
+					for(auto& t : convertThreads)
+						t.join();
 					return false;
 				}
 			}
@@ -2109,22 +2160,9 @@ bool SiglentSCPIOscilloscope::AcquireData()
 				m_triggerArmed = true;
 			}
 
-			//Process analog waveforms
-			waveforms.resize(m_analogChannelCount);
-			for(unsigned int i = 0; i < m_analogChannelCount; i++)
-			{
-				if(enabled[i])
-				{
-					waveforms[i] = ProcessAnalogWaveform(&m_analogWaveformData[i][0],
-						m_analogWaveformDataSize[i],
-						&m_wavedescs[i][0],
-						num_sequences,
-						ttime,
-						basetime,
-						pwtime,
-						i);
-				}
-			}
+			//Wait for the conversion workers to finish
+			for(auto& t : convertThreads)
+				t.join();
 
 			//Save analog waveform data
 			for(unsigned int i = 0; i < m_analogChannelCount; i++)
@@ -3319,6 +3357,48 @@ int64_t SiglentSCPIOscilloscope::GetDeskewForChannel(size_t channel)
 	return skew_ps;
 }
 
+bool SiglentSCPIOscilloscope::IsDownloadWindowingSupported()
+{
+	switch(m_modelid)
+	{
+		//Only the newer protocol has :WAVEFORM:START / :WAVEFORM:POINT
+		// --------------------------------------------------
+		case MODEL_SIGLENT_SDS2000XP:
+		case MODEL_SIGLENT_SDS2000X_HD:
+		case MODEL_SIGLENT_SDS5000X:
+		case MODEL_SIGLENT_SDS6000A:
+			return true;
+		// --------------------------------------------------
+		default:
+			return false;
+			// --------------------------------------------------
+	}
+}
+
+void SiglentSCPIOscilloscope::SetDownloadWindow(uint64_t start, uint64_t length)
+{
+	if(!IsDownloadWindowingSupported())
+		return;
+
+	//Applies to all channels; :WAVEFORM:DATA? then transfers [start, start+length) of the record
+	sendOnly(":WAVEFORM:START %" PRIu64, start);
+	sendOnly(":WAVEFORM:POINT %" PRIu64, length);
+
+	Oscilloscope::SetDownloadWindow(start, length);
+}
+
+void SiglentSCPIOscilloscope::ClearDownloadWindow()
+{
+	if(IsDownloadWindowingSupported())
+	{
+		//Zero points = transfer the whole record
+		sendOnly(":WAVEFORM:START 0");
+		sendOnly(":WAVEFORM:POINT 0");
+	}
+
+	Oscilloscope::ClearDownloadWindow();
+}
+
 bool SiglentSCPIOscilloscope::IsInterleaving()
 {
 	switch(m_modelid)
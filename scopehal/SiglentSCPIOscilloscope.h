@@ -160,6 +160,9 @@ public:
 	virtual int64_t GetTriggerOffset() override;
 	virtual void SetDeskewForChannel(size_t channel, int64_t skew) override;
 	virtual int64_t GetDeskewForChannel(size_t channel) override;
+	virtual bool IsDownloadWindowingSupported() override;
+	virtual void SetDownloadWindow(uint64_t start, uint64_t length) override;
+	virtual void ClearDownloadWindow() override;
 
 	////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 	// Function generator
@@ -189,22 +189,17 @@ bool SocketCANAnalyzer::PopPendingWaveform()
 			auto data = dynamic_cast<CANWaveform*>(it.second);
 			auto nstream = it.first.m_stream;
 
-			//If there is an existing waveform, append to it
-			//TODO: make this more efficient
+			//If there is an existing waveform, append to it in bulk
+			//(append() marks only the new tail stale, so the next GPU transfer is just the added samples)
 			auto oldWaveform = dynamic_cast<CANWaveform*>(chan->GetData(nstream));
 			if(oldWaveform && data && m_appendingNext)
 			{
-				size_t len = data->size();
 				oldWaveform->PrepareForCpuAccess();
 				data->PrepareForCpuAccess();
-				for(size_t i=0; i<len; i++)
-				{
-					oldWaveform->m_samples.push_back(data->m_samples[i]);
-					oldWaveform->m_offsets.push_back(data->m_offsets[i]);
-					oldWaveform->m_durations.push_back(data->m_durations[i]);
-				}
+				oldWaveform->m_samples.append(data->m_samples);
+				oldWaveform->m_offsets.append(data->m_offsets);
+				oldWaveform->m_durations.append(data->m_durations);
 				oldWaveform->m_revision ++;
-				oldWaveform->MarkModifiedFromCpu();
 			}
 			else
 				chan->SetData(data, nstream);
@@ -0,0 +1,169 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Implementation of SparseMetadataPacker
+ */
+#include "scopehal.h"
+#include "SparseMetadataPacker.h"
+
+using namespace std;
+
+namespace
+{
+	///@brief Push constants for the SparseUnpackTimestamps shader
+	struct SparseUnpackArgs
+	{
+		int64_t base;
+		uint32_t size;
+	};
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Construction / destruction
+
+SparseMetadataPacker::SparseMetadataPacker()
+	: m_packPipeline("shaders/SparsePackTimestamps.spv", 5, sizeof(uint32_t))
+	, m_unpackPipeline("shaders/SparseUnpackTimestamps.spv", 4, sizeof(SparseUnpackArgs))
+{
+	m_status.SetCpuAccessHint(AcceleratorBuffer<int64_t>::HINT_LIKELY);
+	m_status.SetGpuAccessHint(AcceleratorBuffer<int64_t>::HINT_LIKELY);
+	m_status.resize(2);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Conversion
+
+/**
+	@brief Converts a waveform's timestamps to the packed at-rest form, entirely on-device
+
+	Same contract as SparseWaveformBase::PackMetadata(): returns false, leaving the waveform in the int64
+	representation, if any offset delta or duration overflows 32 bits. No-op if already packed.
+ */
+bool SparseMetadataPacker::Pack(SparseWaveformBase* wfm, vk::raii::CommandBuffer& cmdBuf, shared_ptr<QueueHandle> queue)
+{
+	if(wfm->IsMetadataPacked())
+		return true;
+
+	//Shaders index with 32 bit sample positions
+	size_t len = wfm->m_offsets.size();
+	if(!IsAvailable() || !g_gpuFilterEnabled || (len > 0xffffffff) || (len == 0) )
+		return wfm->PackMetadata();
+
+	wfm->m_packedOffsets.resize(len);
+	wfm->m_packedDurations.resize(len);
+
+	//Clear the overflow flag (the base slot is written unconditionally by the shader)
+	m_status.PrepareForCpuAccess();
+	m_status[1] = 0;
+	m_status.MarkModifiedFromCpu();
+
+	cmdBuf.begin({});
+	m_packPipeline.BindBufferNonblocking(0, wfm->m_offsets, cmdBuf);
+	m_packPipeline.BindBufferNonblocking(1, wfm->m_durations, cmdBuf);
+	m_packPipeline.BindBufferNonblocking(2, wfm->m_packedOffsets, cmdBuf, true);
+	m_packPipeline.BindBufferNonblocking(3, wfm->m_packedDurations, cmdBuf, true);
+	m_packPipeline.BindBufferNonblocking(4, m_status, cmdBuf);
+	m_packPipeline.Dispatch(cmdBuf, (uint32_t)len, GetComputeBlockCount(len, 64));
+	cmdBuf.end();
+	queue->SubmitAndBlock(cmdBuf);
+
+	wfm->m_packedOffsets.MarkModifiedFromGpu();
+	wfm->m_packedDurations.MarkModifiedFromGpu();
+	m_status.MarkModifiedFromGpu();
+
+	//On overflow, discard the partial output and stay in the int64 form
+	m_status.PrepareForCpuAccess();
+	if(m_status[1] != 0)
+	{
+		wfm->m_packedOffsets.clear();
+		wfm->m_packedOffsets.shrink_to_fit();
+		wfm->m_packedDurations.clear();
+		wfm->m_packedDurations.shrink_to_fit();
+		return false;
+	}
+
+	//Free the wide buffers (and the coarse index, which points into them)
+	wfm->m_offsets.clear();
+	wfm->m_offsets.shrink_to_fit();
+	wfm->m_durations.clear();
+	wfm->m_durations.shrink_to_fit();
+	wfm->m_coarseOffsets.clear();
+	wfm->m_coarseOffsets.shrink_to_fit();
+
+	wfm->m_packedBase = m_status[0];
+	wfm->m_metadataPacked = true;
+	return true;
+}
+
+/**
+	@brief Regenerates a waveform's int64 timestamp buffers from the packed form, entirely on-device
+
+	No-op if not packed. The packed buffers are freed afterward.
+ */
+bool SparseMetadataPacker::Unpack(SparseWaveformBase* wfm, vk::raii::CommandBuffer& cmdBuf, shared_ptr<QueueHandle> queue)
+{
+	if(!wfm->IsMetadataPacked())
+		return true;
+
+	size_t len = wfm->m_packedOffsets.size();
+	if(!IsAvailable() || !g_gpuFilterEnabled || (len > 0xffffffff) || (len == 0) )
+	{
+		wfm->UnpackMetadata();
+		return true;
+	}
+
+	wfm->m_offsets.resize(len);
+	wfm->m_durations.resize(len);
+
+	SparseUnpackArgs args;
+	args.base = wfm->m_packedBase;
+	args.size = len;
+
+	cmdBuf.begin({});
+	m_unpackPipeline.BindBufferNonblocking(0, wfm->m_packedOffsets, cmdBuf);
+	m_unpackPipeline.BindBufferNonblocking(1, wfm->m_packedDurations, cmdBuf);
+	m_unpackPipeline.BindBufferNonblocking(2, wfm->m_offsets, cmdBuf, true);
+	m_unpackPipeline.BindBufferNonblocking(3, wfm->m_durations, cmdBuf, true);
+	m_unpackPipeline.Dispatch(cmdBuf, args, GetComputeBlockCount(len, 64));
+	cmdBuf.end();
+	queue->SubmitAndBlock(cmdBuf);
+
+	wfm->MarkTimestampsModifiedFromGpu();
+
+	wfm->m_packedOffsets.clear();
+	wfm->m_packedOffsets.shrink_to_fit();
+	wfm->m_packedDurations.clear();
+	wfm->m_packedDurations.shrink_to_fit();
+
+	wfm->m_metadataPacked = false;
+	return true;
+}
@@ -0,0 +1,74 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Declaration of SparseMetadataPacker
+ */
+#ifndef SparseMetadataPacker_h
+#define SparseMetadataPacker_h
+
+/**
+	@brief GPU conversion between sparse waveform timestamps and their packed at-rest form
+
+	On-device counterpart of SparseWaveformBase::PackMetadata() / UnpackMetadata(): converts GPU-resident
+	int64 offsets and durations to the base-plus-uint32-delta representation (and back) without round tripping
+	the metadata through the CPU. The pack shader detects 32 bit overflow on device; Pack() then discards the
+	partial output and returns false, leaving the waveform in the int64 form.
+
+	Requires 64-bit shader storage plus push descriptors; when those are missing (or the waveform is too long
+	for 32 bit sample indexing) both entry points fall back to the CPU conversion, so callers can use this
+	unconditionally.
+ */
+class SparseMetadataPacker
+{
+public:
+	SparseMetadataPacker();
+
+	//not copyable or assignable
+	SparseMetadataPacker(const SparseMetadataPacker&) =delete;
+	SparseMetadataPacker& operator=(const SparseMetadataPacker&) =delete;
+
+	///@brief Checks if the GPU supports the shaders this primitive needs
+	static bool IsAvailable()
+	{ return g_hasShaderInt64 && g_hasPushDescriptor; }
+
+	bool Pack(SparseWaveformBase* wfm, vk::raii::CommandBuffer& cmdBuf, std::shared_ptr<QueueHandle> queue);
+	bool Unpack(SparseWaveformBase* wfm, vk::raii::CommandBuffer& cmdBuf, std::shared_ptr<QueueHandle> queue);
+
+protected:
+	ComputePipeline m_packPipeline;
+	ComputePipeline m_unpackPipeline;
+
+	///@brief Pack results: [0] = base timestamp, [1] = nonzero if any delta overflowed 32 bits
+	AcceleratorBuffer<int64_t> m_status;
+};
+
+#endif
@@ -58,6 +58,7 @@ TektronixOscilloscope::TektronixOscilloscope(SCPITransport* transport)
 	, m_dmmChannel(0)
 	, m_dmmModeValid(false)
 	, m_dmmMode(Multimeter::DC_VOLTAGE)
+	, m_measurementNamesValid(false)
 	, m_digitalChannelBase(0)
 	, m_triggerArmed(false)
 	, m_triggerOneShot(false)
@@ -357,26 +358,44 @@ void TektronixOscilloscope::DetectProbes()
 		case FAMILY_MSO6:
 
 			//Figure out what kind of probe is attached (analog or digital).
-			//If a digital probe (TLP058), disable this channel and mark as not usable
-			for(size_t i=0; i<m_analogChannelCount; i++)
+			//If a digital probe (TLP058), disable this channel and mark as not usable.
+			//Pipeline the queries (one burst per question, not one round trip per channel) since connect
+			//latency on a big rack is dominated by these per-channel probes.
 			{
-				string reply = m_transport->SendCommandQueuedWithReply(GetOscilloscopeChannel(i)->GetHwname() + ":PROBETYPE?");
+				vector<string> typeQueries;
+				for(size_t i=0; i<m_analogChannelCount; i++)
+					typeQueries.push_back(GetOscilloscopeChannel(i)->GetHwname() + ":PROBETYPE?");
+				auto typeReplies = m_transport->SendQueryBatch(typeQueries);
 
-				if(reply == "DIG")
+				//Second burst: probe model for every channel that isn't digital
+				vector<size_t> analogChans;
+				vector<string> idQueries;
+				for(size_t i=0; i<m_analogChannelCount; i++)
 				{
-					lock_guard<recursive_mutex> lock(m_cacheMutex);
-					m_probeTypes[i] = PROBE_TYPE_DIGITAL_8BIT;
-					m_probeNames[i] = "DIG";
+					if(typeReplies[i] == "DIG")
+						continue;
+					analogChans.push_back(i);
+					idQueries.push_back(GetOscilloscopeChannel(i)->GetHwname() + ":PROBE:ID:TYP?");
+				}
+				auto idReplies = m_transport->SendQueryBatch(idQueries);
+
+				lock_guard<recursive_mutex> lock(m_cacheMutex);
+				for(size_t i=0; i<m_analogChannelCount; i++)
+				{
+					if(typeReplies[i] == "DIG")
+					{
+						m_probeTypes[i] = PROBE_TYPE_DIGITAL_8BIT;
+						m_probeNames[i] = "DIG";
+					}
 				}
 
 				//Treat anything else as analog. See what type
-				else
+				for(size_t j=0; j<analogChans.size(); j++)
 				{
-					string id = TrimQuotes(m_transport->SendCommandQueuedWithReply(
-						GetOscilloscopeChannel(i)->GetHwname() + ":PROBE:ID:TYP?"));
+					size_t i = analogChans[j];
+					string id = TrimQuotes(idReplies[j]);
 
-					lock_guard<recursive_mutex> lock(m_cacheMutex);
-					m_probeNames[i] = reply;
+					m_probeNames[i] = typeReplies[i];
 
 					if(id == "TPP1000")
 						m_probeTypes[i] = PROBE_TYPE_ANALOG_250K;
@@ -431,6 +450,7 @@ void TektronixOscilloscope::FlushConfigCache()
 	m_dmmAutorangeValid = false;
 	m_dmmChannelValid = false;
 	m_dmmModeValid = false;
+	m_measurementNamesValid = false;
 
 	delete m_trigger;
 	m_trigger = NULL;
@@ -1524,16 +1544,21 @@ bool TektronixOscilloscope::AcquireData()
 			break;
 	}
 
-	//Now that we have all of the pending waveforms, save them in sets across all channels
+	//Now that we have all of the pending waveforms, save them in sets across all channels.
+	//A FastFrame acquisition yields one waveform per segment on the analog channels; channels that only
+	//produced a single waveform (e.g. spectrum or digital) just go in the first set.
 	m_pendingWaveformsMutex.lock();
-	size_t num_pending = 1;	//TODO: segmented capture support
+	size_t num_pending = 1;
+	for(auto& it : pending_waveforms)
+		num_pending = max(num_pending, it.second.size());
 	for(size_t i=0; i<num_pending; i++)
 	{
 		SequenceSet s;
 		for(size_t j=0; j<m_channels.size(); j++)
 		{
-			if(IsChannelEnabled(j))
-				s[GetOscilloscopeChannel(j)] = pending_waveforms[j][i];
+			auto it = pending_waveforms.find(j);
+			if( (it != pending_waveforms.end()) && (i < it->second.size()) )
+				s[GetOscilloscopeChannel(j)] = it->second[i];
 		}
 		m_pendingWaveforms.push_back(s);
 	}
@@ -1734,6 +1759,19 @@ bool TektronixOscilloscope::AcquireDataMSO56(map<int, vector<WaveformBase*> >& p
 	//Make sure record length is valid
 	GetSampleDepth();
 
+	//If FastFrame (segmented capture) is active, select the full frame range up front so a single CURV? block
+	//returns every segment back to back, rather than paying a SCPI round trip per frame
+	size_t numFrames = 1;
+	if(Trim(m_transport->SendCommandImmediateWithReply("HOR:FASTFRAME:STATE?")) == "1")
+	{
+		numFrames = stoull(Trim(m_transport->SendCommandImmediateWithReply("ACQ:NUMFRAMESACQ?")));
+		if(numFrames == 0)
+			numFrames = 1;
+
+		m_transport->SendCommandImmediate("DAT:FRAMESTART 1");
+		m_transport->SendCommandImmediate("DAT:FRAMESTOP " + to_string(numFrames));
+	}
+
 	//Ask for the analog data
 	bool firstAnalog = true;
 	size_t timebase = 0;
@@ -1791,7 +1829,8 @@ bool TektronixOscilloscope::AcquireDataMSO56(map<int, vector<WaveformBase*> >& p
 				continue; // retry
 			}
 
-			if (nsamples != (size_t)preamble.nr_pt)
+			//Depending on firmware, nr_pt may report per-frame points or the total across all selected frames
+			if( (nsamples != (size_t)preamble.nr_pt) && (nsamples != (size_t)preamble.nr_pt * numFrames) )
 			{
 				LogWarning("Didn't get the right number of points\n");
 
@@ -1802,28 +1841,40 @@ bool TektronixOscilloscope::AcquireDataMSO56(map<int, vector<WaveformBase*> >& p
 				continue; // retry
 			}
 
-			//Set up the capture we're going to store our data into
-			//(no TDC data or fine timestamping available on Tektronix scopes?)
-			auto cap = AllocateAnalogWaveform(m_nickname + "." + GetChannel(i)->GetHwname());
-			cap->m_timescale = timebase;
-			cap->m_triggerPhase = 0;
-			cap->m_startTimestamp = time(NULL);
-			double t = GetTime();
-			cap->m_startFemtoseconds = (t - floor(t)) * FS_PER_SECOND;
-			cap->Resize(nsamples);
-			cap->PrepareForCpuAccess();
+			//Parse segment boundaries locally: the frames are concatenated back to back in the block
+			size_t framelen = nsamples;
+			size_t nframes = 1;
+			if( (numFrames > 1) && ((nsamples % numFrames) == 0) )
+			{
+				nframes = numFrames;
+				framelen = nsamples / numFrames;
+			}
+
+			for(size_t frame = 0; frame < nframes; frame ++)
+			{
+				//Set up the capture we're going to store our data into
+				//(no TDC data or fine timestamping available on Tektronix scopes?)
+				auto cap = AllocateAnalogWaveform(m_nickname + "." + GetChannel(i)->GetHwname());
+				cap->m_timescale = timebase;
+				cap->m_triggerPhase = 0;
+				cap->m_startTimestamp = time(NULL);
+				double t = GetTime();
+				cap->m_startFemtoseconds = (t - floor(t)) * FS_PER_SECOND;
+				cap->Resize(framelen);
+				cap->PrepareForCpuAccess();
 
-			Convert8BitSamples(
-				cap->m_samples.GetCpuPointer(),
-				samples,
-				preamble.ymult,
-				-preamble.yoff,
-				nsamples);
+				Convert8BitSamples(
+					cap->m_samples.GetCpuPointer(),
+					samples + frame*framelen,
+					preamble.ymult,
+					-preamble.yoff,
+					framelen);
 
-			cap->MarkSamplesModifiedFromCpu();
+				cap->MarkSamplesModifiedFromCpu();
 
-			//Done, update the data
-			pending_waveforms[i].push_back(cap);
+				//Done, update the data
+				pending_waveforms[i].push_back(cap);
+			}
 
 			//Done
 			delete[] samples;
@@ -3676,6 +3727,62 @@ int64_t TektronixOscilloscope::GetResolutionBandwidth()
 	}
 }
 
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Hardware measurements
+
+vector<Oscilloscope::HardwareMeasurement> TektronixOscilloscope::GetHardwareMeasurements()
+{
+	vector<HardwareMeasurement> ret;
+
+	switch(m_family)
+	{
+		case FAMILY_MSO5:
+		case FAMILY_MSO6:
+			break;
+
+		default:
+			return ret;
+	}
+
+	//Enumerate the configured measurement slots. This is cached: the set only changes when the user
+	//reconfigures the instrument, which flushes the config cache.
+	vector<string> names;
+	{
+		lock_guard<recursive_mutex> lock(m_cacheMutex);
+		if(!m_measurementNamesValid)
+		{
+			m_measurementNames.clear();
+			auto list = Trim(m_transport->SendCommandQueuedWithReply("MEASU:LIST?"));
+			if(!list.empty() && (list != "NONE") )
+				m_measurementNames = explode(list, ',');
+			m_measurementNamesValid = true;
+		}
+		names = m_measurementNames;
+	}
+	if(names.empty())
+		return ret;
+
+	//Chain the per-slot value queries into one compound query so the whole set costs a single round trip
+	string query;
+	for(auto& name : names)
+	{
+		if(!query.empty())
+			query += ";:";
+		query += string("MEASU:") + Trim(name) + ":RESU:CURR:MEAN?";
+	}
+
+	//Replies come back semicolon separated in query order
+	auto fields = explode(Trim(m_transport->SendCommandQueuedWithReply(query)), ';');
+	for(size_t i=0; (i < fields.size()) && (i < names.size()); i++)
+	{
+		HardwareMeasurement m;
+		m.m_name = Trim(names[i]);
+		m.m_value = stod(fields[i]);
+		ret.push_back(m);
+	}
+	return ret;
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Multimeter mode
 
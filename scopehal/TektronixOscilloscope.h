@@ -205,6 +205,11 @@ public:
 	virtual void SetResolutionBandwidth(int64_t rbw) override;
 	virtual int64_t GetResolutionBandwidth() override;
 
+	////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	// Hardware measurements
+
+	virtual std::vector<HardwareMeasurement> GetHardwareMeasurements() override;
+
 protected:
 	OscilloscopeChannel* m_extTrigChannel;
 	FunctionGeneratorChannel* m_awgChannel;
@@ -286,6 +291,8 @@ protected:
 	int m_dmmChannel;
 	bool m_dmmModeValid;
 	Multimeter::MeasurementTypes m_dmmMode;
+	bool m_measurementNamesValid;
+	std::vector<std::string> m_measurementNames;
 	std::map<size_t, Unit> m_channelUnits;
 
 	///The analog channel for each flex channel
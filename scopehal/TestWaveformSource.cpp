@@ -328,9 +328,9 @@ void TestWaveformSource::DegradeSerialData(
 
 	//Set up new FFT plans
 	if(!m_vkForwardPlan)
-		m_vkForwardPlan = make_unique<VulkanFFTPlan>(npoints, nouts, VulkanFFTPlan::DIRECTION_FORWARD);
+		m_vkForwardPlan = g_vkFFTPlanCache.Acquire(npoints, nouts, VulkanFFTPlan::DIRECTION_FORWARD);
 	if(!m_vkReversePlan)
-		m_vkReversePlan = make_unique<VulkanFFTPlan>(npoints, nouts, VulkanFFTPlan::DIRECTION_REVERSE);
+		m_vkReversePlan = g_vkFFTPlanCache.Acquire(npoints, nouts, VulkanFFTPlan::DIRECTION_REVERSE);
 
 	if(lpf)
 	{
@@ -113,8 +113,8 @@ protected:
 	AcceleratorBuffer<float> m_forwardOutBuf;
 	AcceleratorBuffer<float> m_reverseOutBuf;
 
-	std::unique_ptr<VulkanFFTPlan> m_vkForwardPlan;
-	std::unique_ptr<VulkanFFTPlan> m_vkReversePlan;
+	std::shared_ptr<VulkanFFTPlan> m_vkForwardPlan;
+	std::shared_ptr<VulkanFFTPlan> m_vkReversePlan;
 
 	double m_cachedBinSize;
 	AcceleratorBuffer<float> m_resampledSparamSines;
@@ -0,0 +1,373 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal v0.1                                                                                                     *
+*                                                                                                                      *
+* Copyright (c) 2012-2022 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Implementation of the text scanning toolkit shared by file import code
+ */
+#include "scopehal.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// MappedFileView
+
+MappedFileView::MappedFileView(const string& fname)
+	: m_data(nullptr)
+	, m_len(0)
+{
+#ifndef _WIN32
+	m_mapped = false;
+
+	int fd = open(fname.c_str(), O_RDONLY);
+	if(fd < 0)
+		return;
+
+	struct stat st;
+	if(0 != fstat(fd, &st))
+	{
+		close(fd);
+		return;
+	}
+	m_len = st.st_size;
+
+	//Can't map an empty file, but it's still a legal (if useless) input
+	if(m_len == 0)
+	{
+		close(fd);
+		m_data = "";
+		return;
+	}
+
+	void* p = mmap(nullptr, m_len, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if(p == MAP_FAILED)
+	{
+		m_len = 0;
+		return;
+	}
+
+	//Import code scans the file front to back, so tell the kernel to read ahead aggressively
+	madvise(p, m_len, MADV_SEQUENTIAL);
+
+	m_data = reinterpret_cast<const char*>(p);
+	m_mapped = true;
+
+#else
+	//No mmap, fall back to reading the whole file
+	FILE* fp = fopen(fname.c_str(), "rb");
+	if(!fp)
+		return;
+
+	fseek(fp, 0, SEEK_END);
+	m_len = ftell(fp);
+	fseek(fp, 0, SEEK_SET);
+
+	if(m_len == 0)
+	{
+		fclose(fp);
+		m_data = "";
+		return;
+	}
+
+	m_buf.resize(m_len);
+	if(m_len != fread(&m_buf[0], 1, m_len, fp))
+	{
+		fclose(fp);
+		m_buf.clear();
+		m_len = 0;
+		return;
+	}
+	fclose(fp);
+
+	m_data = &m_buf[0];
+#endif
+}
+
+MappedFileView::~MappedFileView()
+{
+#ifndef _WIN32
+	if(m_mapped)
+		munmap(const_cast<char*>(m_data), m_len);
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Number parsing
+
+/**
+	@brief Parses a decimal number from [p, end) without needing a null terminator
+
+	Handles the formats instrument and exporter output actually contains (optional sign, digits, '.', digits,
+	optional exponent) with no allocations or locale lookups; anything else (inf/nan/hex floats) falls back
+	to strtod().
+ */
+double ParseDouble(const char* p, const char* end)
+{
+	const char* start = p;
+
+	bool neg = false;
+	if( (p < end) && ((*p == '-') || (*p == '+')) )
+	{
+		neg = (*p == '-');
+		p ++;
+	}
+
+	uint64_t mantissa = 0;
+	int exponent = 0;
+	int digits = 0;
+	bool ok = false;
+	while( (p < end) && isdigit(static_cast<unsigned char>(*p)) )
+	{
+		//Digits beyond what a uint64 can hold don't affect the result, just the scale
+		if(digits < 19)
+		{
+			mantissa = mantissa*10 + (*p - '0');
+			digits ++;
+		}
+		else
+			exponent ++;
+		ok = true;
+		p ++;
+	}
+	if( (p < end) && (*p == '.') )
+	{
+		p ++;
+		while( (p < end) && isdigit(static_cast<unsigned char>(*p)) )
+		{
+			if(digits < 19)
+			{
+				mantissa = mantissa*10 + (*p - '0');
+				digits ++;
+				exponent --;
+			}
+			ok = true;
+			p ++;
+		}
+	}
+	if( ok && (p < end) && ((*p == 'e') || (*p == 'E')) )
+	{
+		p ++;
+		bool eneg = false;
+		if( (p < end) && ((*p == '-') || (*p == '+')) )
+		{
+			eneg = (*p == '-');
+			p ++;
+		}
+		int e = 0;
+		while( (p < end) && isdigit(static_cast<unsigned char>(*p)) )
+		{
+			e = e*10 + (*p - '0');
+			p ++;
+		}
+		exponent += eneg ? -e : e;
+	}
+
+	//Unparseable, or trailing garbage: let the C library sort it out
+	if(!ok || (p != end))
+	{
+		string tmp(start, end - start);
+		return strtod(tmp.c_str(), nullptr);
+	}
+
+	//Powers of ten up to 1e22 are exactly representable as doubles
+	static const double pow10[] =
+	{
+		1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10,
+		1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+	};
+
+	double v = static_cast<double>(mantissa);
+	if( (exponent > 0) && (exponent <= 22) )
+		v *= pow10[exponent];
+	else if( (exponent < 0) && (exponent >= -22) )
+		v /= pow10[-exponent];
+	else if(exponent != 0)
+		v *= pow(10.0, exponent);
+
+	return neg ? -v : v;
+}
+
+///@brief Parses a decimal integer from [p, end) without needing a null terminator
+int64_t ParseInt64(const char* p, const char* end)
+{
+	bool neg = false;
+	if( (p < end) && ((*p == '-') || (*p == '+')) )
+	{
+		neg = (*p == '-');
+		p ++;
+	}
+
+	int64_t v = 0;
+	while( (p < end) && isdigit(static_cast<unsigned char>(*p)) )
+	{
+		v = v*10 + (*p - '0');
+		p ++;
+	}
+
+	return neg ? -v : v;
+}
+
+//Powers of ten for exponent scaling in ParseFloat (single precision magnitudes fit comfortably in this range)
+static const double g_pow10[] =
+{
+	1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,
+	1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19,
+	1e20, 1e21, 1e22, 1e23, 1e24, 1e25, 1e26, 1e27, 1e28, 1e29,
+	1e30, 1e31, 1e32, 1e33, 1e34, 1e35, 1e36, 1e37, 1e38
+};
+
+/**
+	@brief Converts a single null terminated ASCII float, stopping at the first character that isn't part of the number
+
+	Much faster than atof() on this workload: no locale lookups, and digit accumulation plus a table-driven
+	exponent scale instead of a general-purpose strtod. Non-numeric input parses as zero, matching atof().
+ */
+float ParseFloat(const char* p)
+{
+	bool neg = false;
+	if(*p == '+')
+		p++;
+	else if(*p == '-')
+	{
+		neg = true;
+		p++;
+	}
+
+	//Integer digits
+	double value = 0;
+	while( (*p >= '0') && (*p <= '9') )
+		value = value*10 + (*p++ - '0');
+
+	//Fractional digits
+	int exponent = 0;
+	if(*p == '.')
+	{
+		p++;
+		while( (*p >= '0') && (*p <= '9') )
+		{
+			value = value*10 + (*p++ - '0');
+			exponent --;
+		}
+	}
+
+	//Exponent
+	if( (*p == 'e') || (*p == 'E') )
+	{
+		p++;
+		bool eneg = false;
+		if(*p == '+')
+			p++;
+		else if(*p == '-')
+		{
+			eneg = true;
+			p++;
+		}
+		int e = 0;
+		while( (*p >= '0') && (*p <= '9') )
+			e = e*10 + (*p++ - '0');
+		exponent += eneg ? -e : e;
+	}
+
+	if(exponent > 0)
+	{
+		if(exponent <= 38)
+			value *= g_pow10[exponent];
+		else
+			value *= pow(10.0, exponent);
+	}
+	else if(exponent < 0)
+	{
+		if(exponent >= -38)
+			value /= g_pow10[-exponent];
+		else
+			value *= pow(10.0, exponent);
+	}
+
+	return neg ? -value : value;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Field splitting
+
+/**
+	@brief Returns the bounds of the k'th delimiter separated field of a line, or false if there aren't that many
+
+	A field wrapped in double quotes may contain the delimiter; the quotes themselves are stripped from the
+	returned bounds. Quoting is only recognized at the start of a field, so unquoted fields that merely contain
+	a quote character somewhere are passed through untouched.
+ */
+bool GetDelimitedField(const TextLineView& line, size_t k, char delim, const char*& fstart, const char*& fend)
+{
+	const char* p = line.m_start;
+	for(size_t i=0; i <= k; i++)
+	{
+		//Quoted field: the delimiter search starts after the closing quote
+		const char* close = nullptr;
+		if( (p < line.m_end) && (*p == '\"') )
+		{
+			close = static_cast<const char*>(memchr(p + 1, '\"', line.m_end - (p + 1)));
+			if(!close)
+				close = line.m_end;
+		}
+
+		const char* search = close ? min(close + 1, line.m_end) : p;
+		auto dp = static_cast<const char*>(memchr(search, delim, line.m_end - search));
+
+		if(i == k)
+		{
+			if(close)
+			{
+				fstart = p + 1;
+				fend = close;
+			}
+			else
+			{
+				fstart = p;
+				fend = dp ? dp : line.m_end;
+			}
+			return true;
+		}
+
+		if(!dp)
+			return false;
+		p = dp + 1;
+	}
+
+	return false;
+}
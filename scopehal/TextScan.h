@@ -0,0 +1,85 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal v0.1                                                                                                     *
+*                                                                                                                      *
+* Copyright (c) 2012-2022 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Declaration of the text scanning toolkit shared by file import code
+ */
+
+#ifndef TextScan_h
+#define TextScan_h
+
+/**
+	@brief Read-only view of a file on disk (memory mapped where available, read to the heap elsewhere)
+
+	Import code that works on a single flat buffer can use memchr() and friends, which process many bytes
+	per cycle, instead of pulling the file through stdio one line at a time.
+ */
+class MappedFileView
+{
+public:
+	MappedFileView(const std::string& fname);
+	~MappedFileView();
+
+	///@brief Returns true if the file was opened and read successfully
+	bool IsValid() const
+	{ return m_data != nullptr; }
+
+	///@brief Pointer to the file contents (not null terminated)
+	const char* m_data;
+
+	///@brief Length of the file, in bytes
+	size_t m_len;
+
+protected:
+#ifndef _WIN32
+	///@brief True if m_data points to a mapping that we need to munmap() on destruction
+	bool m_mapped;
+#else
+	///@brief Backing storage for m_data when the file had to be read rather than mapped
+	std::vector<char> m_buf;
+#endif
+};
+
+///@brief A single line of a text file, with its 1-based line number for error reporting
+struct TextLineView
+{
+	const char* m_start;
+	const char* m_end;
+	size_t m_row;
+};
+
+double ParseDouble(const char* p, const char* end);
+int64_t ParseInt64(const char* p, const char* end);
+float ParseFloat(const char* p);
+bool GetDelimitedField(const TextLineView& line, size_t k, char delim, const char*& fstart, const char*& fend);
+
+#endif
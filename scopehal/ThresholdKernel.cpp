@@ -0,0 +1,393 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Implementation of ThresholdKernel
+ */
+#include "scopehal.h"
+#include "ThresholdKernel.h"
+
+#ifdef __x86_64__
+#include <immintrin.h>
+#endif
+
+#include <omp.h>
+
+using namespace std;
+
+namespace
+{
+	///@brief Appends one level run to a sparse digital waveform
+	void AppendRun(SparseDigitalWaveform* cap, int64_t offset, int64_t duration, bool value)
+	{
+		cap->m_offsets.push_back(offset);
+		cap->m_durations.push_back(duration);
+		cap->m_samples.push_back(value);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Plain threshold (dense output)
+
+/**
+	@brief Thresholds a block of samples with no hysteresis
+
+	Multithreaded for large blocks, with an AVX2 inner loop where available.
+ */
+void ThresholdKernel::Threshold(const float* pin, bool* pout, size_t count, float midpoint)
+{
+	if(count == 0)
+		return;
+
+	//Divide large waveforms into blocks and multithread them
+	if(count > 1000000)
+	{
+		size_t numblocks = omp_get_max_threads();
+		size_t lastblock = numblocks - 1;
+		size_t blocksize = count / numblocks;
+		blocksize = blocksize - (blocksize % 32);
+
+		#pragma omp parallel for
+		for(size_t i=0; i<numblocks; i++)
+		{
+			//Last block gets any extra that didn't divide evenly
+			size_t nsamp = blocksize;
+			if(i == lastblock)
+				nsamp = count - i*blocksize;
+
+			size_t off = i*blocksize;
+			#ifdef __x86_64__
+			if(g_hasAvx2)
+				ThresholdAVX2(pin + off, pout + off, nsamp, midpoint);
+			else
+			#endif
+				ThresholdGeneric(pin + off, pout + off, nsamp, midpoint);
+		}
+	}
+
+	//Small waveforms get done single threaded to avoid overhead
+	else
+	{
+		#ifdef __x86_64__
+		if(g_hasAvx2)
+			ThresholdAVX2(pin, pout, count, midpoint);
+		else
+		#endif
+			ThresholdGeneric(pin, pout, count, midpoint);
+	}
+}
+
+/**
+	@brief Generic backend for Threshold()
+ */
+void ThresholdKernel::ThresholdGeneric(const float* pin, bool* pout, size_t count, float midpoint)
+{
+	for(size_t i=0; i<count; i++)
+		pout[i] = pin[i] > midpoint;
+}
+
+#ifdef __x86_64__
+/**
+	@brief AVX2 backend for Threshold()
+
+	Compares eight samples at a time, then spreads the comparison mask to eight output bytes with a multiply
+	(bit k of the mask lands in a distinct bit of byte k, which a saturating add then collapses to 0/1).
+ */
+__attribute__((target("avx2")))
+void ThresholdKernel::ThresholdAVX2(const float* pin, bool* pout, size_t count, float midpoint)
+{
+	size_t end = count - (count % 8);
+	__m256 vmid = _mm256_set1_ps(midpoint);
+	for(size_t i=0; i<end; i += 8)
+	{
+		__m256 v = _mm256_loadu_ps(pin + i);
+		uint64_t mask = _mm256_movemask_ps(_mm256_cmp_ps(v, vmid, _CMP_GT_OQ));
+
+		uint64_t spread = (mask * 0x0101010101010101ULL) & 0x8040201008040201ULL;
+		uint64_t ones = ((spread + 0x7f7f7f7f7f7f7f7fULL) >> 7) & 0x0101010101010101ULL;
+		memcpy(pout + i, &ones, 8);
+	}
+
+	//Tail samples
+	for(size_t i=end; i<count; i++)
+		pout[i] = pin[i] > midpoint;
+}
+#endif
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Threshold with hysteresis (dense output)
+
+/**
+	@brief Thresholds a block of samples with hysteresis
+
+	The state update is a loop carried dependence so this runs single threaded, but the float comparisons (the
+	bulk of the work) are vectorized where available and blocks with no threshold crossing are skipped outright.
+
+	@param initial	Output state before the first sample
+ */
+void ThresholdKernel::ThresholdWithHysteresis(
+	const float* pin, bool* pout, size_t count, float rising, float falling, bool initial)
+{
+	#ifdef __x86_64__
+	if(g_hasAvx2)
+		ThresholdWithHysteresisAVX2(pin, pout, count, rising, falling, initial);
+	else
+	#endif
+		ThresholdWithHysteresisGeneric(pin, pout, count, rising, falling, initial);
+}
+
+/**
+	@brief Generic backend for ThresholdWithHysteresis()
+ */
+void ThresholdKernel::ThresholdWithHysteresisGeneric(
+	const float* pin, bool* pout, size_t count, float rising, float falling, bool initial)
+{
+	unsigned int cur = initial;
+	for(size_t i=0; i<count; i++)
+	{
+		unsigned int hi = pin[i] > rising;
+		unsigned int lo = pin[i] < falling;
+		cur = hi | (cur & (lo ^ 1));
+		pout[i] = static_cast<bool>(cur);
+	}
+}
+
+#ifdef __x86_64__
+/**
+	@brief AVX2 backend for ThresholdWithHysteresis()
+ */
+__attribute__((target("avx2")))
+void ThresholdKernel::ThresholdWithHysteresisAVX2(
+	const float* pin, bool* pout, size_t count, float rising, float falling, bool initial)
+{
+	unsigned int cur = initial;
+	__m256 vr = _mm256_set1_ps(rising);
+	__m256 vf = _mm256_set1_ps(falling);
+
+	size_t end = count - (count % 8);
+	for(size_t i=0; i<end; i += 8)
+	{
+		__m256 v = _mm256_loadu_ps(pin + i);
+		unsigned int mhi = _mm256_movemask_ps(_mm256_cmp_ps(v, vr, _CMP_GT_OQ));
+		unsigned int mlo = _mm256_movemask_ps(_mm256_cmp_ps(v, vf, _CMP_LT_OQ));
+
+		//Common case for oversampled signals: nothing crosses either threshold, whole block holds state
+		if( (mhi == 0) && (mlo == 0) )
+		{
+			memset(pout + i, cur, 8);
+			continue;
+		}
+
+		//Resolve the state bit by bit
+		for(int k=0; k<8; k++)
+		{
+			unsigned int hi = (mhi >> k) & 1;
+			unsigned int lo = (mlo >> k) & 1;
+			cur = hi | (cur & (lo ^ 1));
+			pout[i+k] = static_cast<bool>(cur);
+		}
+	}
+
+	//Tail samples
+	for(size_t i=end; i<count; i++)
+	{
+		unsigned int hi = pin[i] > rising;
+		unsigned int lo = pin[i] < falling;
+		cur = hi | (cur & (lo ^ 1));
+		pout[i] = static_cast<bool>(cur);
+	}
+}
+#endif
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Threshold with hysteresis (run-length compacted output)
+
+/**
+	@brief Thresholds a block of uniformly sampled data, producing run-length compacted sparse digital output
+
+	Emits one output sample per level run, with offsets and durations in input sample ticks (the caller is
+	expected to copy timescale etc from the input waveform). The initial state is high iff the first sample is
+	above the rising threshold. Marks the output as modified from the CPU.
+ */
+void ThresholdKernel::ThresholdSparse(
+	const float* pin, size_t count, float rising, float falling, SparseDigitalWaveform* cap)
+{
+	cap->clear();
+	if(count == 0)
+	{
+		cap->MarkModifiedFromCpu();
+		return;
+	}
+
+	#ifdef __x86_64__
+	if(g_hasAvx2)
+		ThresholdSparseAVX2(pin, count, rising, falling, cap);
+	else
+	#endif
+		ThresholdSparseGeneric(pin, count, rising, falling, cap);
+
+	cap->MarkModifiedFromCpu();
+}
+
+/**
+	@brief Generic backend for the uniform ThresholdSparse()
+ */
+void ThresholdKernel::ThresholdSparseGeneric(
+	const float* pin, size_t count, float rising, float falling, SparseDigitalWaveform* cap)
+{
+	unsigned int cur = pin[0] > rising;
+	size_t runstart = 0;
+
+	for(size_t i=1; i<count; i++)
+	{
+		unsigned int hi = pin[i] > rising;
+		unsigned int lo = pin[i] < falling;
+		unsigned int next = hi | (cur & (lo ^ 1));
+		if(next != cur)
+		{
+			AppendRun(cap, runstart, i - runstart, cur);
+			runstart = i;
+			cur = next;
+		}
+	}
+
+	AppendRun(cap, runstart, count - runstart, cur);
+}
+
+#ifdef __x86_64__
+/**
+	@brief AVX2 backend for the uniform ThresholdSparse()
+
+	Blocks where no sample crosses either threshold extend the current run without per-sample work, so the cost
+	scales with the number of threshold crossings rather than the number of samples for oversampled signals.
+ */
+__attribute__((target("avx2")))
+void ThresholdKernel::ThresholdSparseAVX2(
+	const float* pin, size_t count, float rising, float falling, SparseDigitalWaveform* cap)
+{
+	unsigned int cur = pin[0] > rising;
+	size_t runstart = 0;
+
+	__m256 vr = _mm256_set1_ps(rising);
+	__m256 vf = _mm256_set1_ps(falling);
+
+	size_t end = count - (count % 8);
+	size_t i = 0;
+
+	//First block includes sample 0, whose state is already folded into cur; resolving it again is harmless
+	for(; i<end; i += 8)
+	{
+		__m256 v = _mm256_loadu_ps(pin + i);
+		unsigned int mhi = _mm256_movemask_ps(_mm256_cmp_ps(v, vr, _CMP_GT_OQ));
+		unsigned int mlo = _mm256_movemask_ps(_mm256_cmp_ps(v, vf, _CMP_LT_OQ));
+
+		//No crossing possible: run continues through the whole block
+		if( (mhi == 0) && (mlo == 0) )
+			continue;
+		if( (mhi == 0xff) && cur )
+			continue;
+		if( (mlo == 0xff) && !cur )
+			continue;
+
+		for(int k=0; k<8; k++)
+		{
+			unsigned int hi = (mhi >> k) & 1;
+			unsigned int lo = (mlo >> k) & 1;
+			unsigned int next = hi | (cur & (lo ^ 1));
+			if(next != cur)
+			{
+				AppendRun(cap, runstart, (i+k) - runstart, cur);
+				runstart = i + k;
+				cur = next;
+			}
+		}
+	}
+
+	//Tail samples
+	for(; i<count; i++)
+	{
+		unsigned int hi = pin[i] > rising;
+		unsigned int lo = pin[i] < falling;
+		unsigned int next = hi | (cur & (lo ^ 1));
+		if(next != cur)
+		{
+			AppendRun(cap, runstart, i - runstart, cur);
+			runstart = i;
+			cur = next;
+		}
+	}
+
+	AppendRun(cap, runstart, count - runstart, cur);
+}
+#endif
+
+/**
+	@brief Thresholds a block of sparse data, producing run-length compacted sparse digital output
+
+	Same as the uniform overload, but run boundaries come from the input's offset/duration arrays so output
+	timestamps stay aligned with the input samples.
+ */
+void ThresholdKernel::ThresholdSparse(
+	const float* pin,
+	const int64_t* offsets,
+	const int64_t* durations,
+	size_t count,
+	float rising,
+	float falling,
+	SparseDigitalWaveform* cap)
+{
+	cap->clear();
+	if(count == 0)
+	{
+		cap->MarkModifiedFromCpu();
+		return;
+	}
+
+	unsigned int cur = pin[0] > rising;
+	size_t runstart = 0;
+
+	for(size_t i=1; i<count; i++)
+	{
+		unsigned int hi = pin[i] > rising;
+		unsigned int lo = pin[i] < falling;
+		unsigned int next = hi | (cur & (lo ^ 1));
+		if(next != cur)
+		{
+			AppendRun(cap, offsets[runstart], offsets[i] - offsets[runstart], cur);
+			runstart = i;
+			cur = next;
+		}
+	}
+
+	AppendRun(cap, offsets[runstart], offsets[count-1] + durations[count-1] - offsets[runstart], cur);
+
+	cap->MarkModifiedFromCpu();
+}
@@ -0,0 +1,87 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Declaration of ThresholdKernel
+ */
+#ifndef ThresholdKernel_h
+#define ThresholdKernel_h
+
+/**
+	@brief Vectorized threshold / hysteresis kernels for analog-to-digital conversion
+
+	Almost every serial decode chain starts by slicing an analog waveform against a threshold, so this is shared as
+	a library primitive rather than re-implemented as a scalar loop in each filter. The plain threshold runs
+	multithreaded with an AVX2 inner loop where available; the hysteresis variants vectorize the two comparisons
+	and keep only the (inherently sequential) state resolution scalar, with a fast skip over blocks where no sample
+	crosses either threshold.
+
+	The sparse variants emit run-length compacted SparseDigitalWaveform output in the same pass, so downstream
+	decoders iterate over level runs instead of per-sample data.
+
+	Hysteresis semantics match ThresholdFilter: the output goes high when the input exceeds the rising threshold
+	and low when it drops below the falling threshold, holding its previous state in between.
+ */
+class ThresholdKernel
+{
+public:
+	static void Threshold(const float* pin, bool* pout, size_t count, float midpoint);
+	static void ThresholdWithHysteresis(
+		const float* pin, bool* pout, size_t count, float rising, float falling, bool initial);
+
+	static void ThresholdSparse(
+		const float* pin, size_t count, float rising, float falling, SparseDigitalWaveform* cap);
+	static void ThresholdSparse(
+		const float* pin,
+		const int64_t* offsets,
+		const int64_t* durations,
+		size_t count,
+		float rising,
+		float falling,
+		SparseDigitalWaveform* cap);
+
+protected:
+	static void ThresholdGeneric(const float* pin, bool* pout, size_t count, float midpoint);
+	static void ThresholdWithHysteresisGeneric(
+		const float* pin, bool* pout, size_t count, float rising, float falling, bool initial);
+	static void ThresholdSparseGeneric(
+		const float* pin, size_t count, float rising, float falling, SparseDigitalWaveform* cap);
+
+#ifdef __x86_64__
+	static void ThresholdAVX2(const float* pin, bool* pout, size_t count, float midpoint);
+	static void ThresholdWithHysteresisAVX2(
+		const float* pin, bool* pout, size_t count, float rising, float falling, bool initial);
+	static void ThresholdSparseAVX2(
+		const float* pin, size_t count, float rising, float falling, SparseDigitalWaveform* cap);
+#endif
+};
+
+#endif
@@ -79,11 +79,12 @@ bool TouchstoneParser::Load(string fname, SParameters& params)
 	}
 	params.Allocate(nports);
 
-	//Read entire file into working buffer
+	//Read entire file into working buffer (with a null terminator so number parsing can't run off the end)
 	fseek(fp, 0, SEEK_END);
 	size_t len = ftell(fp);
 	fseek(fp, 0, SEEK_SET);
-	char* buf = new char[len];
+	char* buf = new char[len + 1];
+	buf[len] = '\0';
 	if(len != fread(buf, 1, len, fp))
 	{
 		delete[] buf;
@@ -92,7 +93,11 @@ bool TouchstoneParser::Load(string fname, SParameters& params)
 	}
 	fclose(fp);
 
-	//Main parsing loop
+	//First pass: parse the option line, strip comments, and index the start of every numeric token.
+	//This has to be sequential since comments can appear anywhere, but it touches each byte exactly once
+	//and does no float conversion.
+	vector<size_t> tokens;
+	tokens.reserve(len / 8);
 	size_t i = 0;
 	bool ok = true;
 	double unit_scale = 1;
@@ -161,74 +166,97 @@ bool TouchstoneParser::Load(string fname, SParameters& params)
 				i++;
 		}
 
-		//Actual network data
+		//Numeric token: record where it starts, then skip ahead to the next whitespace
 		else
 		{
-			//Read the frequency and scale appropriately
-			float freq;
-			if(!ReadFloat(buf, i, len, freq))
-			{
-				ok = false;
-				break;
-			}
-			freq *= unit_scale;
+			tokens.push_back(i);
+			while( (i < len) && !isspace(buf[i]) )
+				i++;
+		}
+	}
+
+	//Each frequency point is a frequency followed by nports^2 mag/angle or real/imaginary tuples.
+	//Line breaks carry no meaning (a 4+ port matrix wraps over several lines), so the token stream is all we need.
+	size_t valsPerPoint = 1 + 2*nports*nports;
+	size_t npoints = tokens.size() / valsPerPoint;
+	if(ok && ( (tokens.size() % valsPerPoint) != 0) )
+	{
+		LogError("Touchstone file %s has a truncated frequency point (%zu values, expected a multiple of %zu)\n",
+			fname.c_str(), tokens.size(), valsPerPoint);
+		ok = false;
+	}
 
-			//The actual S-matrix is nports * nports mag/angle or real/imaginary tuples
-			float mag;
-			float angle;
-			for(size_t outer=1; outer <= nports; outer ++)
+	if(ok)
+	{
+		//Look up the output vectors in matrix order up front, so the conversion loop never touches the map.
+		//NOTE! Parameter ordering is different for 2 vs 3+ port
+		//For 2 port, we loop destination inner and source outer (S11 S21 S12 S22)
+		//For 3+ port, we have source inner and destination outer (S11 S12 S13 S21 S22 S23 ...)
+		//See pages 6 and 8 of Touchstone File Specification rev 1.1
+		vector<SParameterVector*> vecs;
+		for(size_t outer=1; outer <= nports; outer ++)
+		{
+			for(size_t inner=1; inner <= nports; inner ++)
 			{
-				for(size_t inner=1; inner <= nports; inner ++)
+				size_t src;
+				size_t dest;
+				if(nports <= 2)
 				{
-					//NOTE! Parameter ordering is different for 2 vs 3+ port
-					//For 2 port, we loop destination inner and source outer (S11 S21 S12 S22)
-					//For 3+ port, we have source inner and destination outer (S11 S12 S13 S21 S22 S23 ...)
-					//See pages 6 and 8 of Touchstone File Specification rev 1.1
-					size_t src;
-					size_t dest;
-					if(nports <= 2)
-					{
-						dest = inner;
-						src = outer;
-					}
-					else
-					{
-						dest = outer;
-						src = inner;
-					}
+					dest = inner;
+					src = outer;
+				}
+				else
+				{
+					dest = outer;
+					src = inner;
+				}
 
-					//Read the inputs
-					if(!ReadFloat(buf, i, len, mag) || !ReadFloat(buf, i, len, angle))
-					{
-						ok = false;
-						break;
-					}
+				vecs.push_back(params.m_params[SPair(dest, src)]);
+			}
+		}
+		for(auto v : vecs)
+		{
+			v->m_points.resize(npoints);
+			v->m_points.PrepareForCpuAccess();
+		}
 
-					//Convert dB magnitudes to absolute magnitudes
-					if(mag_is_db)
-						mag = pow(10, mag/20);
+		//Second pass: do the actual float conversion.
+		//Frequency points are fixed size in the token stream and write to disjoint output slots,
+		//so they can be converted in any order.
+		size_t matsize = nports*nports;
+		#pragma omp parallel for
+		for(size_t n=0; n<npoints; n++)
+		{
+			size_t base = n * valsPerPoint;
 
-					//Touchstone uses degrees, but we use radians internally
-					if(polar)
-						angle *= (M_PI / 180);
+			//Read the frequency and scale appropriately
+			float freq = ParseFloat(buf + tokens[base]) * unit_scale;
 
-					//Convert real/imaginary format to mag/angle
-					else
-						ComplexToPolar(mag, angle);
+			for(size_t j=0; j<matsize; j++)
+			{
+				float mag = ParseFloat(buf + tokens[base + 1 + j*2]);
+				float angle = ParseFloat(buf + tokens[base + 2 + j*2]);
 
-					//and save the final results
-					params.m_params[SPair(dest, src)]->m_points.push_back(SParameterPoint(freq, mag, angle));
-				}
-				if(!ok)
-					break;
-			}
-			if(!ok)
-				break;
+				//Convert dB magnitudes to absolute magnitudes
+				if(mag_is_db)
+					mag = pow(10, mag/20);
 
-			i++;
+				//Touchstone uses degrees, but we use radians internally
+				if(polar)
+					angle *= (M_PI / 180);
+
+				//Convert real/imaginary format to mag/angle
+				else
+					ComplexToPolar(mag, angle);
+
+				//and save the final results
+				vecs[j]->m_points[n] = SParameterPoint(freq, mag, angle);
+			}
 		}
-	}
 
+		for(auto v : vecs)
+			v->m_points.MarkModifiedFromCpu();
+	}
 
 	delete[] buf;
 	LogTrace("Loaded %zu S-parameter points\n", params.m_params[SPair(1,1)]->m_points.size());
@@ -236,27 +264,6 @@ bool TouchstoneParser::Load(string fname, SParameters& params)
 	return ok;
 }
 
-/**
-	@brief Reads a single ASCII float from the input buffer
- */
-bool TouchstoneParser::ReadFloat(const char* buf, size_t& i, size_t len, float& f)
-{
-	//eat spaces
-	while(isspace(buf[i]) && (i < len) )
-		i++;
-	if(i >= len)
-		return false;
-
-	//read the value
-	f = atof(buf + i);
-
-	//eat digits
-	while(!isspace(buf[i]) && (i < len) )
-		i++;
-	return true;
-
-}
-
 /**
 	@brief Converts a complex number in (real, imaginary) form to (magnitude, angle)
  */
@@ -0,0 +1,194 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief  Implementation of TriggerAlignmentCache
+ */
+#include "scopehal.h"
+#include "TriggerAlignmentCache.h"
+
+using namespace std;
+
+TriggerAlignmentCache g_triggerAlignmentCache;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Construction / destruction
+
+TriggerAlignmentCache::TriggerAlignmentCache(size_t historyDepth)
+	: m_historyDepth(historyDepth)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Index maintenance
+
+/**
+	@brief Records the resolved skew between a scope pair for one trigger.
+
+	Call once per trigger after skew resolution (e.g. cross-correlation of a shared reference channel) with the
+	secondary scope's trigger timestamp. Storing a trigger that is already indexed overwrites the old skew.
+ */
+void TriggerAlignmentCache::StoreSkew(
+	Oscilloscope* primary,
+	Oscilloscope* secondary,
+	time_t triggerSec,
+	int64_t triggerFs,
+	int64_t skewFs)
+{
+	lock_guard<mutex> lock(m_mutex);
+
+	auto& index = m_pairs[ScopePair(primary, secondary)];
+	TriggerTime when(triggerSec, triggerFs);
+
+	//Only grow the history on a fresh trigger (re-resolving the same one just updates the skew)
+	if(index.m_skews.find(when) == index.m_skews.end())
+		index.m_history.push_back(when);
+	index.m_skews[when] = skewFs;
+
+	//Drop the oldest triggers past the depth limit
+	while(index.m_history.size() > m_historyDepth)
+	{
+		index.m_skews.erase(index.m_history.front());
+		index.m_history.pop_front();
+	}
+}
+
+/**
+	@brief Looks up the resolved skew for a trigger.
+
+	Tries an exact timestamp match first, then the nearest indexed trigger within toleranceFs (ganged scopes
+	rarely report bit-identical fine timestamps for the same event).
+
+	@return true if a skew was found, with the value in skewFs
+ */
+bool TriggerAlignmentCache::LookupSkew(
+	Oscilloscope* primary,
+	Oscilloscope* secondary,
+	time_t triggerSec,
+	int64_t triggerFs,
+	int64_t& skewFs,
+	int64_t toleranceFs)
+{
+	lock_guard<mutex> lock(m_mutex);
+
+	auto pit = m_pairs.find(ScopePair(primary, secondary));
+	if(pit == m_pairs.end())
+		return false;
+	auto& skews = pit->second.m_skews;
+
+	//Exact hit?
+	TriggerTime when(triggerSec, triggerFs);
+	auto it = skews.find(when);
+	if(it != skews.end())
+	{
+		skewFs = it->second;
+		return true;
+	}
+	if(toleranceFs <= 0)
+		return false;
+
+	//Check the nearest indexed triggers on either side of the requested time
+	auto next = skews.lower_bound(when);
+	int64_t best = toleranceFs + 1;
+	for(auto candidate : {next, (next == skews.begin()) ? skews.end() : prev(next)})
+	{
+		if(candidate == skews.end())
+			continue;
+
+		//Triggers more than a second apart can't be the same event (and would overflow the fs math)
+		if(llabs(candidate->first.first - triggerSec) > 1)
+			continue;
+
+		//Distance in fs, accounting for the coarse/fine split (tolerances are well under a second in practice)
+		int64_t delta = (candidate->first.first - triggerSec) * FS_PER_SECOND +
+			(candidate->first.second - triggerFs);
+		delta = llabs(delta);
+		if(delta <= toleranceFs && delta < best)
+		{
+			best = delta;
+			skewFs = candidate->second;
+		}
+	}
+	return (best <= toleranceFs);
+}
+
+/**
+	@brief Returns the most recently stored skew for a pair (for pre-aligning a trigger not yet resolved)
+ */
+bool TriggerAlignmentCache::GetLatestSkew(Oscilloscope* primary, Oscilloscope* secondary, int64_t& skewFs)
+{
+	lock_guard<mutex> lock(m_mutex);
+
+	auto pit = m_pairs.find(ScopePair(primary, secondary));
+	if( (pit == m_pairs.end()) || pit->second.m_history.empty() )
+		return false;
+
+	skewFs = pit->second.m_skews[pit->second.m_history.back()];
+	return true;
+}
+
+/**
+	@brief Drops all state involving a scope (call when an instrument is disconnected)
+ */
+void TriggerAlignmentCache::Forget(Oscilloscope* scope)
+{
+	lock_guard<mutex> lock(m_mutex);
+
+	for(auto it = m_pairs.begin(); it != m_pairs.end(); )
+	{
+		if( (it->first.first == scope) || (it->first.second == scope) )
+			it = m_pairs.erase(it);
+		else
+			++it;
+	}
+}
+
+void TriggerAlignmentCache::clear()
+{
+	lock_guard<mutex> lock(m_mutex);
+	m_pairs.clear();
+}
+
+void TriggerAlignmentCache::SetHistoryDepth(size_t depth)
+{
+	lock_guard<mutex> lock(m_mutex);
+
+	m_historyDepth = depth;
+	for(auto& it : m_pairs)
+	{
+		auto& index = it.second;
+		while(index.m_history.size() > m_historyDepth)
+		{
+			index.m_skews.erase(index.m_history.front());
+			index.m_history.pop_front();
+		}
+	}
+}
@@ -0,0 +1,112 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief  Declaration of TriggerAlignmentCache
+ */
+#ifndef TriggerAlignmentCache_h
+#define TriggerAlignmentCache_h
+
+/**
+	@brief Thread safe cache of resolved skews between ganged instruments, indexed by trigger timestamp
+
+	When multiple scopes trigger off a shared event, the skew between a (primary, secondary) pair has to be
+	resolved once per trigger (typically by cross-correlating a reference channel). Downstream alignment passes
+	previously re-searched waveform timestamps on every refresh; this cache makes the resolved skew a single
+	lookup instead.
+
+	Timestamps follow WaveformBase convention: coarse time_t seconds plus femtoseconds since the start of that
+	second. Lookups first try an exact match, then the nearest indexed trigger within a caller-supplied tolerance
+	(ganged scopes rarely report bit-identical fine timestamps for the same event).
+
+	The index is incremental: each resolved trigger is appended as it happens and the oldest entries for a pair
+	are dropped past a depth limit, so memory stays bounded over long streaming sessions.
+ */
+class TriggerAlignmentCache
+{
+public:
+	TriggerAlignmentCache(size_t historyDepth = 1024);
+
+	void StoreSkew(
+		Oscilloscope* primary,
+		Oscilloscope* secondary,
+		time_t triggerSec,
+		int64_t triggerFs,
+		int64_t skewFs);
+
+	bool LookupSkew(
+		Oscilloscope* primary,
+		Oscilloscope* secondary,
+		time_t triggerSec,
+		int64_t triggerFs,
+		int64_t& skewFs,
+		int64_t toleranceFs = 0);
+
+	bool GetLatestSkew(Oscilloscope* primary, Oscilloscope* secondary, int64_t& skewFs);
+
+	void Forget(Oscilloscope* scope);
+	void clear();
+
+	void SetHistoryDepth(size_t depth);
+
+	size_t GetHistoryDepth()
+	{ return m_historyDepth; }
+
+protected:
+
+	///@brief An instrument pair whose skews we track
+	typedef std::pair<Oscilloscope*, Oscilloscope*> ScopePair;
+
+	///@brief Absolute trigger time (coarse seconds, fs since start of second)
+	typedef std::pair<time_t, int64_t> TriggerTime;
+
+	///@brief Skew history for one instrument pair
+	struct PairIndex
+	{
+		///@brief Resolved skews ordered by trigger time (ordered so near-match lookups can bisect)
+		std::map<TriggerTime, int64_t> m_skews;
+
+		///@brief Insertion order, for dropping the oldest entries past the depth limit
+		std::deque<TriggerTime> m_history;
+	};
+
+	///@brief Maximum number of triggers remembered per instrument pair
+	size_t m_historyDepth;
+
+	std::mutex m_mutex;
+
+	std::map<ScopePair, PairIndex> m_pairs;
+};
+
+///@brief Process-wide alignment cache shared by all instruments and filters
+extern TriggerAlignmentCache g_triggerAlignmentCache;
+
+#endif
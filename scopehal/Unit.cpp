@@ -29,7 +29,9 @@
 
 #include "scopehal.h"
 
+#include <atomic>
 #include <cinttypes>
+#include <cstring>
 
 using namespace std;
 
@@ -40,6 +42,96 @@ locale_t Unit::m_locale;
 locale_t Unit::m_defaultLocale;
 #endif
 
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Formatting cache
+
+///@brief Bumped whenever the display locale changes, invalidating all cached strings
+static atomic<uint32_t> g_localeGeneration{0};
+
+namespace
+{
+	/**
+		@brief Memoization cache for Unit::PrettyPrint
+
+		Render-side code (axis labels, cursors, protocol overlays, statistics) formats the same handful of values
+		every frame, so even a small cache eliminates nearly all of the locale and snprintf traffic.
+
+		The cache is direct mapped: a hash of the value picks a slot, and a colliding insert simply replaces the
+		previous occupant. This gives bounded memory and O(1) lookup with no list maintenance on the hot path.
+		One cache per thread, so filter graph workers don't contend over it.
+	 */
+	class UnitFormatCache
+	{
+	public:
+		UnitFormatCache()
+			: m_generation(0)
+		{}
+
+		/**
+			@brief Looks up the slot for a value, returning true if it holds a current string for that exact query
+		 */
+		bool Lookup(uint64_t valueBits, int sigfigs, Unit::UnitType type, size_t& slot)
+		{
+			//Throw out all cached strings if the locale has changed since they were formatted
+			uint32_t gen = g_localeGeneration.load(memory_order_relaxed);
+			if(m_generation != gen)
+			{
+				for(auto& e : m_entries)
+					e.m_valid = false;
+				m_generation = gen;
+			}
+
+			uint64_t h = valueBits ^ (valueBits >> 29);
+			h = (h * 0x9e3779b97f4a7c15UL) ^ (static_cast<uint64_t>(type) << 8) ^ static_cast<uint64_t>(sigfigs + 1);
+			slot = h % CACHE_SIZE;
+
+			auto& e = m_entries[slot];
+			return e.m_valid &&
+				(e.m_valueBits == valueBits) &&
+				(e.m_sigfigs == sigfigs) &&
+				(e.m_type == type);
+		}
+
+		void Insert(size_t slot, uint64_t valueBits, int sigfigs, Unit::UnitType type, const string& text)
+		{
+			auto& e = m_entries[slot];
+			e.m_valueBits = valueBits;
+			e.m_sigfigs = sigfigs;
+			e.m_type = type;
+			e.m_text = text;
+			e.m_valid = true;
+		}
+
+		const string& GetText(size_t slot)
+		{ return m_entries[slot].m_text; }
+
+	protected:
+		static const size_t CACHE_SIZE = 512;
+
+		class Entry
+		{
+		public:
+			Entry()
+				: m_valueBits(0)
+				, m_sigfigs(0)
+				, m_type(Unit::UNIT_COUNTS)
+				, m_valid(false)
+			{}
+
+			uint64_t m_valueBits;
+			int m_sigfigs;
+			Unit::UnitType m_type;
+			bool m_valid;
+			std::string m_text;
+		};
+
+		uint32_t m_generation;
+		Entry m_entries[CACHE_SIZE];
+	};
+
+	thread_local UnitFormatCache g_formatCache;
+}
+
 /**
 	@brief Constructs a new unit from a string
  */
@@ -548,9 +640,55 @@ void Unit::GetUnitSuffix(UnitType type, double num, double& scaleFactor, string&
  */
 string Unit::PrettyPrint(double value, int sigfigs, bool useDisplayLocale) const
 {
+	//Check the memoization cache before doing any locale or stdio work.
+	//The value is keyed by bit pattern, not numeric comparison, so -0.0 and NaN behave sanely.
+	//Strings formatted for serialization bypass the cache; that path isn't hot.
+	uint64_t valueBits;
+	memcpy(&valueBits, &value, sizeof(valueBits));
+	size_t slot = 0;
 	if(useDisplayLocale)
+	{
+		if(g_formatCache.Lookup(valueBits, sigfigs, m_type, slot))
+			return g_formatCache.GetText(slot);
+
 		SetPrintingLocale();
+	}
+
+	string ret = PrettyPrintInternal(value, sigfigs);
 
+	SetDefaultLocale();
+
+	if(useDisplayLocale)
+		g_formatCache.Insert(slot, valueBits, sigfigs, m_type, ret);
+	return ret;
+}
+
+/**
+	@brief Formats a batch of values, e.g. for generating axis labels
+
+	Sets up the display locale once for the whole batch rather than once per value.
+ */
+vector<string> Unit::PrettyPrintBatch(const vector<double>& values, int sigfigs, bool useDisplayLocale) const
+{
+	if(useDisplayLocale)
+		SetPrintingLocale();
+
+	vector<string> ret;
+	ret.reserve(values.size());
+	for(auto v : values)
+		ret.push_back(PrettyPrintInternal(v, sigfigs));
+
+	SetDefaultLocale();
+	return ret;
+}
+
+/**
+	@brief Shared formatting core for PrettyPrint and PrettyPrintBatch
+
+	The caller is responsible for selecting the printing locale before calling and restoring it afterward.
+ */
+string Unit::PrettyPrintInternal(double value, int sigfigs) const
+{
 	//Figure out scaling, prefix, and suffix
 	double scaleFactor;
 	string prefix;
@@ -622,7 +760,6 @@ string Unit::PrettyPrint(double value, int sigfigs, bool useDisplayLocale) const
 			break;
 	}
 
-	SetDefaultLocale();
 	return numprefix + string(tmp);
 }
 
@@ -1146,6 +1283,9 @@ void Unit::SetLocale(const char* locale)
 
 	m_defaultLocale = newlocale(LC_ALL, "C", 0);
 #endif
+
+	//Locale affects formatted output, so invalidate any cached strings
+	g_localeGeneration ++;
 }
 
 /**
@@ -112,6 +112,9 @@ public:
 	std::string PrettyPrint(double value, int sigfigs = -1, bool useDisplayLocale = true) const;
 	std::string PrettyPrintInt64(int64_t value, int sigfigs = -1, bool useDisplayLocale = true) const;
 
+	std::vector<std::string> PrettyPrintBatch(
+		const std::vector<double>& values, int sigfigs = -1, bool useDisplayLocale = true) const;
+
 	std::string PrettyPrintRange(double pixelMin, double pixelMax, double rangeMin, double rangeMax) const;
 
 	double ParseString(const std::string& str, bool useDisplayLocale = true);
@@ -137,6 +140,8 @@ public:
 protected:
 	UnitType m_type;
 
+	std::string PrettyPrintInternal(double value, int sigfigs) const;
+
 	void GetSIScalingFactor(double num, double& scaleFactor, std::string& prefix) const;
 	void GetUnitSuffix(UnitType type, double num, double& scaleFactor, std::string& prefix, std::string& numprefix, std::string& suffix) const;
 
@@ -35,6 +35,11 @@
 
 #include "scopehal.h"
 
+#ifndef _WIN32
+#include <sys/uio.h>
+#include <netinet/tcp.h>
+#endif
+
 using namespace std;
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -43,6 +48,7 @@ using namespace std;
 VICPSocketTransport::VICPSocketTransport(const string& args)
 	: m_nextSequence(1)
 	, m_lastSequence(1)
+	, m_burstFlush(false)
 	, m_socket(AF_INET, SOCK_STREAM, IPPROTO_TCP)
 {
 	char hostname[128];
@@ -81,6 +87,7 @@ VICPSocketTransport::VICPSocketTransport(const string& args)
 
 VICPSocketTransport::~VICPSocketTransport()
 {
+	ShutdownFlusher();
 }
 
 bool VICPSocketTransport::IsConnected()
@@ -121,28 +128,83 @@ bool VICPSocketTransport::SendCommand(const string& cmd)
 	LogTrace("Send (%s): %s\n", m_hostname.c_str(), cmd.c_str());
 
 	//Operation and flags header
-	string payload;
-	uint8_t op 	= OP_DATA | OP_EOI;
-
-	//TODO: remote, clear, poll flags
-	payload += op;
-	payload += 0x01;							//protocol version number
-	payload += GetNextSequenceNumber();
-	payload += '\0';							//reserved
+	uint8_t header[8];
+	header[0] = OP_DATA | OP_EOI;				//TODO: remote, clear, poll flags
+	header[1] = 0x01;							//protocol version number
+	header[2] = GetNextSequenceNumber();
+	header[3] = 0;								//reserved
 
 	//Next 4 header bytes are the message length (network byte order)
 	uint32_t len = cmd.length();
-	payload += (len >> 24) & 0xff;
-	payload += (len >> 16) & 0xff;
-	payload += (len >> 8)  & 0xff;
-	payload += (len >> 0)  & 0xff;
+	header[4] = (len >> 24) & 0xff;
+	header[5] = (len >> 16) & 0xff;
+	header[6] = (len >> 8)  & 0xff;
+	header[7] = (len >> 0)  & 0xff;
+
+	//Scatter-gather send so header and message go out in one segment without copying the message
+	return SendGathered(header, sizeof(header), (const unsigned char*)cmd.c_str(), cmd.length());
+}
 
-	//Add message data
-	payload += cmd;
+/**
+	@brief Sends a header and payload in a single socket write
 
-	//Actually send it
-	SendRawData(payload.size(), (const unsigned char*)payload.c_str());
+	With TCP_NODELAY active, sending them separately would emit two packets per command; a vectored write keeps
+	them in one segment and also avoids copying the payload into a combined buffer first.
+ */
+bool VICPSocketTransport::SendGathered(const unsigned char* header, size_t headerLen, const unsigned char* data, size_t dataLen)
+{
+#ifndef _WIN32
+	struct iovec iov[2];
+	iov[0].iov_base = const_cast<unsigned char*>(header);
+	iov[0].iov_len = headerLen;
+	iov[1].iov_base = const_cast<unsigned char*>(data);
+	iov[1].iov_len = dataLen;
+
+	ssize_t written = writev(m_socket, iov, 2);
+	if(written < 0)
+		return false;
+
+	//Finish off any partial write on the blocking path (rare; only hit when the TX buffer is nearly full)
+	size_t sent = (size_t)written;
+	size_t total = headerLen + dataLen;
+	if(sent < headerLen)
+	{
+		if(!m_socket.SendLooped(header + sent, headerLen - sent))
+			return false;
+		return m_socket.SendLooped(data, dataLen);
+	}
+	else if(sent < total)
+		return m_socket.SendLooped(data + (sent - headerLen), total - sent);
 	return true;
+#else
+	//No writev on Winsock; fall back to a combined buffer
+	string payload((const char*)header, headerLen);
+	payload.append((const char*)data, dataLen);
+	return m_socket.SendLooped((const unsigned char*)payload.c_str(), payload.length());
+#endif
+}
+
+/**
+	@brief Turns Nagle's algorithm on or off on the underlying socket
+ */
+void VICPSocketTransport::SetNagle(bool enabled)
+{
+	int flag = enabled ? 0 : 1;
+	setsockopt(m_socket, IPPROTO_TCP, TCP_NODELAY, (const char*)&flag, sizeof(flag));
+}
+
+bool VICPSocketTransport::FlushCommandQueue()
+{
+	if(!m_burstFlush || !m_socket.IsValid())
+		return SCPITransport::FlushCommandQueue();
+
+	//Let Nagle coalesce the burst of small commands into full segments
+	SetNagle(true);
+	bool ok = SCPITransport::FlushCommandQueue();
+
+	//Turning TCP_NODELAY back on also pushes out anything still waiting in the kernel
+	SetNagle(false);
+	return ok;
 }
 
 string VICPSocketTransport::ReadReply(bool /*endOnSemicolon*/)	//ignore endOnSemicolon, VICP has different framing
@@ -214,12 +276,14 @@ string VICPSocketTransport::ReadReply(bool /*endOnSemicolon*/)	//ignore endOnSem
 void VICPSocketTransport::SendRawData(size_t len, const unsigned char* buf)
 {
 	m_socket.SendLooped(buf, len);
+	CountTxBytes(len);
 }
 
 size_t VICPSocketTransport::ReadRawData(size_t len, unsigned char* buf)
 {
 	if(!m_socket.RecvLooped(buf, len))
 		return 0;
+	CountRxBytes(len);
 	return len;
 }
 
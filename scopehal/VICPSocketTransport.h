@@ -65,6 +65,19 @@ public:
 
 	virtual void FlushRXBuffer() override;
 
+	virtual bool FlushCommandQueue() override;
+
+	/**
+		@brief Opt-in burst mode for the queued command API
+
+		When enabled, FlushCommandQueue() re-enables Nagle for the duration of the drain so the kernel coalesces
+		the burst of small commands into full segments, then turns TCP_NODELAY back on (which also pushes out
+		anything still waiting). Off by default since it adds up to one RTT of latency to the last command in
+		a burst.
+	 */
+	void EnableNagleCoalescedFlush(bool enable)
+	{ m_burstFlush = enable; }
+
 	//VICP constant helpers
 	enum HEADER_OPS
 	{
@@ -82,9 +95,15 @@ public:
 protected:
 	uint8_t GetNextSequenceNumber();
 
+	bool SendGathered(const unsigned char* header, size_t headerLen, const unsigned char* data, size_t dataLen);
+	void SetNagle(bool enabled);
+
 	uint8_t m_nextSequence;
 	uint8_t m_lastSequence;
 
+	///@brief True if FlushCommandQueue() should let Nagle coalesce the burst
+	bool m_burstFlush;
+
 	Socket m_socket;
 
 	std::string m_hostname;
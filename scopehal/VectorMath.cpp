@@ -0,0 +1,159 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Runtime-dispatched vector math helpers
+
+	Array-level wrappers over the SIMD transcendental kernels in avx_mathfun / neon_mathfun. Each helper checks
+	CPU capabilities once per call and processes the bulk of the array with the widest available implementation,
+	finishing the tail with scalar libm. Callers pass plain pointers, so both AcceleratorBuffer contents and
+	scratch arrays work; no alignment is required.
+ */
+#include "scopehal.h"
+
+#ifdef __x86_64__
+#include "avx_mathfun.h"
+#endif
+#ifdef __ARM_NEON
+#include "neon_mathfun.h"
+#endif
+
+using namespace std;
+
+#ifdef __x86_64__
+
+__attribute__((target("avx2")))
+static size_t VectorAtan2AVX2(float* dst, const float* y, const float* x, size_t len)
+{
+	size_t len_rounded = len - (len % 8);
+	for(size_t i=0; i<len_rounded; i += 8)
+	{
+		_mm256_storeu_ps(
+			dst + i,
+			_mm256_atan2_ps(_mm256_loadu_ps(y + i), _mm256_loadu_ps(x + i)));
+	}
+	return len_rounded;
+}
+
+__attribute__((target("avx2")))
+static size_t VectorLog10AVX2(float* dst, const float* src, size_t len)
+{
+	size_t len_rounded = len - (len % 8);
+	for(size_t i=0; i<len_rounded; i += 8)
+		_mm256_storeu_ps(dst + i, _mm256_log10_ps(_mm256_loadu_ps(src + i)));
+	return len_rounded;
+}
+
+__attribute__((target("avx2")))
+static size_t VectorSinCosAVX2(float* sdst, float* cdst, const float* angles, size_t len)
+{
+	size_t len_rounded = len - (len % 8);
+	for(size_t i=0; i<len_rounded; i += 8)
+	{
+		__m256 s;
+		__m256 c;
+		_mm256_sincos_ps(_mm256_loadu_ps(angles + i), &s, &c);
+		_mm256_storeu_ps(sdst + i, s);
+		_mm256_storeu_ps(cdst + i, c);
+	}
+	return len_rounded;
+}
+
+#endif /* __x86_64__ */
+
+/**
+	@brief Computes dst[i] = atan2(y[i], x[i]) for an array of float pairs
+ */
+void VectorAtan2(float* dst, const float* y, const float* x, size_t len)
+{
+	size_t i = 0;
+
+#ifdef __x86_64__
+	if(g_hasAvx2)
+		i = VectorAtan2AVX2(dst, y, x, len);
+#elif defined(__ARM_NEON)
+	size_t len_rounded = len - (len % 4);
+	for(; i<len_rounded; i += 4)
+		vst1q_f32(dst + i, vatan2q_f32(vld1q_f32(y + i), vld1q_f32(x + i)));
+#endif
+
+	for(; i<len; i++)
+		dst[i] = atan2f(y[i], x[i]);
+}
+
+/**
+	@brief Computes dst[i] = log10(src[i]) for an array of float
+ */
+void VectorLog10(float* dst, const float* src, size_t len)
+{
+	size_t i = 0;
+
+#ifdef __x86_64__
+	if(g_hasAvx2)
+		i = VectorLog10AVX2(dst, src, len);
+#elif defined(__ARM_NEON)
+	size_t len_rounded = len - (len % 4);
+	for(; i<len_rounded; i += 4)
+		vst1q_f32(dst + i, vlog10q_f32(vld1q_f32(src + i)));
+#endif
+
+	for(; i<len; i++)
+		dst[i] = log10f(src[i]);
+}
+
+/**
+	@brief Computes sdst[i] = sin(angles[i]) and cdst[i] = cos(angles[i]) in a single pass
+ */
+void VectorSinCos(float* sdst, float* cdst, const float* angles, size_t len)
+{
+	size_t i = 0;
+
+#ifdef __x86_64__
+	if(g_hasAvx2)
+		i = VectorSinCosAVX2(sdst, cdst, angles, len);
+#elif defined(__ARM_NEON)
+	size_t len_rounded = len - (len % 4);
+	for(; i<len_rounded; i += 4)
+	{
+		float32x4_t s;
+		float32x4_t c;
+		vsincosq_f32(vld1q_f32(angles + i), &s, &c);
+		vst1q_f32(sdst + i, s);
+		vst1q_f32(cdst + i, c);
+	}
+#endif
+
+	for(; i<len; i++)
+	{
+		sdst[i] = sinf(angles[i]);
+		cdst[i] = cosf(angles[i]);
+	}
+}
@@ -119,7 +119,7 @@ VulkanFFTPlan::VulkanFFTPlan(
 			cacheKey += "C2R_";
 		else
 			cacheKey += "C2C_";
-		cacheKey += to_string(npoints);
+		cacheKey += to_string(npoints) + "_" + to_string(numBatches);
 	}
 
 	lock_guard<mutex> lock(g_vkTransferMutex);
@@ -250,3 +250,61 @@ void VulkanFFTPlan::AppendReverse(
 
 	dataOut.MarkModifiedFromGpu();
 }
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Plan cache
+
+VulkanFFTPlanCache g_vkFFTPlanCache;
+
+/**
+	@brief Returns a plan of the requested shape, reusing a retired one if possible
+
+	The returned plan is exclusively owned by the caller for as long as the shared_ptr (or a copy of it)
+	is held, and goes back into the cache when the last reference is dropped.
+ */
+shared_ptr<VulkanFFTPlan> VulkanFFTPlanCache::Acquire(
+	size_t npoints,
+	size_t nouts,
+	VulkanFFTPlan::VulkanFFTPlanDirection dir,
+	size_t numBatches,
+	VulkanFFTPlan::VulkanFFTDataType timeDomainType)
+{
+	char tmp[128];
+	snprintf(tmp, sizeof(tmp), "%zu_%zu_%d_%zu_%d", npoints, nouts, dir, numBatches, timeDomainType);
+	string key = tmp;
+
+	//See if we have a retired plan of the right shape we can hand out again
+	{
+		lock_guard<mutex> lock(m_mutex);
+		for(auto it = m_retiredPlans.begin(); it != m_retiredPlans.end(); ++it)
+		{
+			if(it->first == key)
+			{
+				auto plan = it->second.release();
+				m_retiredPlans.erase(it);
+				return shared_ptr<VulkanFFTPlan>(plan, [this, key](VulkanFFTPlan* p){ Retire(key, p); });
+			}
+		}
+	}
+
+	//Nope, make a new one (don't hold the lock during the slow plan creation)
+	return shared_ptr<VulkanFFTPlan>(
+		new VulkanFFTPlan(npoints, nouts, dir, numBatches, timeDomainType),
+		[this, key](VulkanFFTPlan* p){ Retire(key, p); });
+}
+
+///@brief Returns a plan nobody is using anymore to the cache, evicting the oldest entries if we have too many
+void VulkanFFTPlanCache::Retire(const string& key, VulkanFFTPlan* plan)
+{
+	lock_guard<mutex> lock(m_mutex);
+	m_retiredPlans.emplace_back(key, unique_ptr<VulkanFFTPlan>(plan));
+	while(m_retiredPlans.size() > m_maxRetiredPlans)
+		m_retiredPlans.pop_front();
+}
+
+///@brief Frees all retired plans (must be called before Vulkan shutdown)
+void VulkanFFTPlanCache::Clear()
+{
+	lock_guard<mutex> lock(m_mutex);
+	m_retiredPlans.clear();
+}
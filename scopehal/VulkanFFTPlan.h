@@ -46,6 +46,8 @@
 #include <vkFFT.h>
 #pragma GCC diagnostic pop
 
+#include <list>
+
 #include "AcceleratorBuffer.h"
 #include "PipelineCacheManager.h"
 
@@ -125,4 +127,51 @@ protected:
 	uint64_t m_isize;
 };
 
+/**
+	@brief Process-wide cache of VulkanFFTPlan objects, keyed by transform shape
+
+	Plan creation involves shader specialization inside VkFFT and costs tens of milliseconds, so filters should
+	get their plans from here rather than constructing them directly. When the last reference to an acquired plan
+	is dropped, the plan is retired to the cache instead of being destroyed; a later Acquire() of the same shape
+	(e.g. after toggling memory depth on the scope back and forth) reuses it instantly.
+
+	VkFFT rebinds descriptor sets stored inside the plan at append time, so a live plan cannot be shared between
+	concurrently executing filters. Acquire() therefore always hands out an instance with no other users,
+	creating a second plan of the same shape if the first is still checked out.
+ */
+class VulkanFFTPlanCache
+{
+public:
+	VulkanFFTPlanCache()
+		: m_maxRetiredPlans(32)
+	{}
+
+	std::shared_ptr<VulkanFFTPlan> Acquire(
+		size_t npoints,
+		size_t nouts,
+		VulkanFFTPlan::VulkanFFTPlanDirection dir,
+		size_t numBatches = 1,
+		VulkanFFTPlan::VulkanFFTDataType timeDomainType = VulkanFFTPlan::TYPE_REAL);
+
+	void Clear();
+
+	///@brief Sets the maximum number of plans kept alive with no users
+	void SetMaxRetiredPlans(size_t n)
+	{ m_maxRetiredPlans = n; }
+
+protected:
+	void Retire(const std::string& key, VulkanFFTPlan* plan);
+
+	///@brief Mutex guarding the retired-plan list
+	std::mutex m_mutex;
+
+	///@brief Plans not currently checked out by any filter, oldest first
+	std::list<std::pair<std::string, std::unique_ptr<VulkanFFTPlan>>> m_retiredPlans;
+
+	///@brief Maximum size of m_retiredPlans before the oldest entries get evicted
+	size_t m_maxRetiredPlans;
+};
+
+extern VulkanFFTPlanCache g_vkFFTPlanCache;
+
 #endif
@@ -33,9 +33,13 @@
 	@brief Vulkan initialization
  */
 #include "scopehal.h"
+#include <condition_variable>
+#include <deque>
+#include <thread>
 #include <glslang_c_interface.h>
 #include "PipelineCacheManager.h"
 #include "QueueManager.h"
+#include "VulkanFFTPlan.h"
 #include <GLFW/glfw3.h>
 
 //Lots of warnings here, disable them
@@ -102,6 +106,11 @@ std::unique_ptr<QueueManager> g_vkQueueManager;
  */
 mutex g_vkTransferMutex;
 
+/**
+	@brief Background thread running ComputePipeline::WarmupAllPipelines() after initialization
+ */
+static thread g_pipelineWarmupThread;
+
 /**
 	@brief Vulkan memory type for CPU-based memory that is also GPU-readable
  */
@@ -127,6 +136,15 @@ uint32_t g_vkComputeDeviceDriverVer;
  */
 vk::raii::PhysicalDevice* g_vkComputePhysicalDevice;
 
+/**
+	@brief All compute-capable physical devices in the system, in enumeration order
+
+	Only g_vkComputePhysicalDevice has a logical device and does any work in this process; the others are kept
+	addressable (no logical device is created for them, so this costs nothing) so multi-GPU deployments can see
+	what is available and pin additional processes to specific devices via SCOPEHAL_VKDEVICE.
+ */
+std::vector<vk::raii::PhysicalDevice*> g_vkComputeCapableDevices;
+
 /**
 	@brief Heap from which g_vkPinnedMemoryType is allocated
  */
@@ -141,6 +159,7 @@ bool IsDevicePreferred(const vk::PhysicalDeviceProperties& a, const vk::Physical
 
 //Feature flags indicating that we have support for specific data types / features on the GPU
 bool g_hasShaderFloat64 = false;
+bool g_hasShaderFloat16 = false;
 bool g_hasShaderInt64 = false;
 bool g_hasShaderInt16 = false;
 bool g_hasShaderInt8 = false;
@@ -148,8 +167,13 @@ bool g_hasShaderAtomicFloat = false;
 bool g_hasDebugUtils = false;
 bool g_hasMemoryBudget = false;
 bool g_hasPushDescriptor = false;
+bool g_hasTimestampQueries = false;
+bool g_hasTimelineSemaphore = false;
 bool g_vulkanDeviceHasUnifiedMemory = false;
 
+//Nanoseconds per tick of the GPU timestamp counter
+float g_vkTimestampPeriod = 0;
+
 //Max compute group count in each direction
 size_t g_maxComputeGroupCount[3] = {0};
 
@@ -299,7 +323,20 @@ bool VulkanInit(bool skipGLFW)
 
 			size_t bestDevice = 0;
 
+			//Explicit device override, mostly for multi-GPU servers: run one process per GPU and pin
+			//each to its device, so independent workloads use all of them
+			ssize_t forcedDevice = -1;
+			auto devEnv = getenv("SCOPEHAL_VKDEVICE");
+			if(devEnv)
+				forcedDevice = atol(devEnv);
+
 			static vk::raii::PhysicalDevices devices(*g_vkInstance);
+			if(forcedDevice >= (ssize_t)devices.size())
+			{
+				LogWarning("SCOPEHAL_VKDEVICE=%zd requested but only %zu devices present, ignoring\n",
+					forcedDevice, devices.size());
+				forcedDevice = -1;
+			}
 			for(size_t i=0; i<devices.size(); i++)
 			{
 				auto& device = devices[i];
@@ -309,10 +346,21 @@ bool VulkanInit(bool skipGLFW)
 				auto limits = properties.limits;
 
 				//See what device to use
-				//TODO: preference to override this
-				if(IsDevicePreferred(devices[bestDevice].getProperties(), devices[i].getProperties()))
+				if(forcedDevice >= 0)
+					bestDevice = forcedDevice;
+				else if(IsDevicePreferred(devices[bestDevice].getProperties(), devices[i].getProperties()))
 					bestDevice = i;
 
+				//Remember every device we could run compute on, whether or not it gets selected
+				for(auto& f : device.getQueueFamilyProperties())
+				{
+					if(f.queueFlags & vk::QueueFlagBits::eCompute)
+					{
+						g_vkComputeCapableDevices.push_back(&devices[i]);
+						break;
+					}
+				}
+
 				//TODO: check that the extensions we need are supported
 
 				//TODO: sparse properties
@@ -415,6 +463,16 @@ bool VulkanInit(bool skipGLFW)
 					}
 					else
 						LogDebug("int8:                   no\n");
+
+					if(vulkan12Features.shaderFloat16)
+					{
+						if(storageFeatures16.storageBuffer16BitAccess && storageFeatures16.uniformAndStorageBuffer16BitAccess)
+							LogDebug("float16:                yes (allowed in SSBOs)\n");
+						else
+							LogDebug("float16:                yes (but not allowed in SSBOs)\n");
+					}
+					else
+						LogDebug("float16:                no\n");
 				}
 
 				const size_t k = 1024LL;
@@ -537,6 +595,16 @@ bool VulkanInit(bool skipGLFW)
 				g_vkComputeDeviceDriverVer = properties.driverVersion;
 				memcpy(g_vkComputeDeviceUuid, properties.pipelineCacheUUID, 16);
 
+				//Check for timestamp query support, so ComputePipeline can measure GPU-side execution time.
+				//timestampComputeAndGraphics guarantees support on every compute queue, so we don't have to
+				//care which queue family a given dispatch ends up on.
+				g_vkTimestampPeriod = properties.limits.timestampPeriod;
+				if( (properties.limits.timestampComputeAndGraphics != 0) && (g_vkTimestampPeriod > 0) )
+				{
+					g_hasTimestampQueries = true;
+					LogDebug("Timestamp queries available, period = %.3f ns\n", g_vkTimestampPeriod);
+				}
+
 				//Detect driver (used by some workarounds for bugs etc)
 				if(vulkan11Available)
 				{
@@ -672,6 +740,24 @@ bool VulkanInit(bool skipGLFW)
 							g_hasShaderInt8 = true;
 						}
 
+						//Enable 16 bit float shader variables
+						//(only useful to us if we also got 16-bit SSBO access above)
+						if(vulkan12Features.shaderFloat16)
+						{
+							featuresVulkan12.shaderFloat16 = true;
+							LogDebug("Enabling 16-bit float support\n");
+							if(storageFeatures16.storageBuffer16BitAccess && storageFeatures16.uniformAndStorageBuffer16BitAccess)
+								g_hasShaderFloat16 = true;
+						}
+
+						//Enable timeline semaphores (lets QueueHandle batch many command buffers into one submit)
+						if(vulkan12Features.timelineSemaphore)
+						{
+							featuresVulkan12.timelineSemaphore = true;
+							LogDebug("Enabling timeline semaphore support\n");
+							g_hasTimelineSemaphore = true;
+						}
+
 						featuresVulkan12.pNext = pNext;
 						pNext = &featuresVulkan12;
 					}
@@ -848,6 +934,13 @@ bool VulkanInit(bool skipGLFW)
 				LogDebug("Using heap %u, type %u for card-local memory\n", g_vkLocalMemoryHeap, g_vkLocalMemoryType);
 				if(g_vulkanDeviceHasUnifiedMemory) { LogDebug("Unified memory GPU optimizations are enabled\n"); }
 
+				//Make the memory arenas so AcceleratorBuffer sub-allocates rather than
+				//doing one vkAllocateMemory per buffer (implementations cap total allocation count)
+				g_vkPinnedMemoryArena = make_unique<VulkanMemoryArena>(
+					g_vkPinnedMemoryType, true, "g_vkPinnedMemoryArena");
+				g_vkLocalMemoryArena = make_unique<VulkanMemoryArena>(
+					g_vkLocalMemoryType, false, "g_vkLocalMemoryArena");
+
 				//Make the queue manager
 				g_vkQueueManager = make_unique<QueueManager>(g_vkComputePhysicalDevice, g_vkComputeDevice);
 
@@ -867,12 +960,26 @@ bool VulkanInit(bool skipGLFW)
 			}
 
 			//Destroy other physical devices that we're not using
+			//(but keep compute-capable ones addressable via g_vkComputeCapableDevices)
 			for(size_t i=0; i<devices.size(); i++)
 			{
 				if(i == bestDevice)
 					continue;
+				if(find(g_vkComputeCapableDevices.begin(), g_vkComputeCapableDevices.end(), &devices[i]) !=
+					g_vkComputeCapableDevices.end())
+				{
+					continue;
+				}
 				devices[i].clear();
 			}
+
+			//Point out idle hardware so multi-GPU servers know they can scale out
+			if(g_vkComputeCapableDevices.size() > 1)
+			{
+				LogDebug("%zu compute-capable devices present, using one; "
+					"set SCOPEHAL_VKDEVICE=<index> per process to use the others\n",
+					g_vkComputeCapableDevices.size());
+			}
 		}
 	}
 	catch ( vk::SystemError & err )
@@ -904,6 +1011,14 @@ bool VulkanInit(bool skipGLFW)
 	//Initialize our pipeline cache manager and load existing cache data
 	g_pipelineCacheMgr = make_unique<PipelineCacheManager>();
 
+	//Pick the per-device workgroup size for tunable shaders. The winner is cached with the rest of the
+	//pipeline cache, so this only burns time the first time we run on new hardware or a new driver.
+	ComputePipeline::AutoTuneWorkgroupSize();
+
+	//Start compiling every pipeline previous runs used, in the background, so driver shader compilation
+	//overlaps instrument connection instead of hitching the first Refresh of each filter
+	g_pipelineWarmupThread = thread([]{ ComputePipeline::WarmupAllPipelines(); });
+
 	//Print out vkFFT version for debugging
 	int vkfftver = VkFFTGetVersion();
 	int vkfft_major = vkfftver / 10000;
@@ -963,13 +1078,131 @@ bool IsDevicePreferred(const vk::PhysicalDeviceProperties& a, const vk::Physical
 	return false;
 }
 
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Asynchronous transfer dispatch
+
+///@brief Transfer operations waiting to run on the background worker
+static deque<packaged_task<void()>> g_asyncTransferTasks;
+
+///@brief Mutex guarding g_asyncTransferTasks and the worker lifecycle state
+static mutex g_asyncTransferMutex;
+
+///@brief Condition variable for waking the background worker when work arrives (or shutdown is requested)
+static condition_variable g_asyncTransferCvar;
+
+///@brief Background worker thread, started lazily on first use
+static unique_ptr<thread> g_asyncTransferThread;
+
+///@brief Set when the worker should drain its queue and exit
+static bool g_asyncTransferShutdown = false;
+
+///@brief Main loop for the background transfer worker
+static void AsyncTransferThread()
+{
+	#ifdef __linux__
+	pthread_setname_np(pthread_self(), "AsyncTransfer");
+	#endif
+
+	while(true)
+	{
+		packaged_task<void()> task;
+		{
+			unique_lock<mutex> lock(g_asyncTransferMutex);
+			g_asyncTransferCvar.wait(lock, []{ return g_asyncTransferShutdown || !g_asyncTransferTasks.empty(); });
+
+			//Shutting down and nothing left to drain
+			if(g_asyncTransferTasks.empty())
+				return;
+
+			task = std::move(g_asyncTransferTasks.front());
+			g_asyncTransferTasks.pop_front();
+		}
+		task();
+	}
+}
+
+future<void> DispatchAsyncTransfer(function<void()> fn)
+{
+	packaged_task<void()> task(std::move(fn));
+	auto f = task.get_future();
+	{
+		lock_guard<mutex> lock(g_asyncTransferMutex);
+
+		//Start the worker the first time anyone dispatches to it
+		if(!g_asyncTransferThread)
+		{
+			g_asyncTransferShutdown = false;
+			g_asyncTransferThread = make_unique<thread>(AsyncTransferThread);
+		}
+
+		g_asyncTransferTasks.push_back(std::move(task));
+	}
+	g_asyncTransferCvar.notify_one();
+	return f;
+}
+
+///@brief Drains any queued transfers and stops the background worker
+static void ShutdownAsyncTransferThread()
+{
+	{
+		lock_guard<mutex> lock(g_asyncTransferMutex);
+		g_asyncTransferShutdown = true;
+	}
+	g_asyncTransferCvar.notify_all();
+
+	if(g_asyncTransferThread)
+	{
+		g_asyncTransferThread->join();
+		g_asyncTransferThread = nullptr;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Cleanup
+
+///@brief Teardown hooks registered by higher layers holding global GPU resources
+static vector<function<void()>> g_vkCleanupCallbacks;
+
+///@brief Mutex guarding g_vkCleanupCallbacks
+static mutex g_vkCleanupCallbackMutex;
+
+/**
+	@brief Registers a callback to be run early in VulkanCleanup()
+
+	Libraries above scopehal (which VulkanCleanup() cannot call into directly) use this to free any global
+	GPU-resident objects they own before the device goes away.
+ */
+void AddVulkanCleanupCallback(function<void()> cb)
+{
+	lock_guard<mutex> lock(g_vkCleanupCallbackMutex);
+	g_vkCleanupCallbacks.push_back(cb);
+}
+
 /**
 	@brief Free all global Vulkan resources in the correct order
  */
 void VulkanCleanup()
 {
+	//Wait for background pipeline warmup to finish before tearing anything down
+	if(g_pipelineWarmupThread.joinable())
+		g_pipelineWarmupThread.join();
+
 	glfwTerminate();
 
+	//Stop the background transfer worker before we tear down the transfer queue it submits on
+	ShutdownAsyncTransferThread();
+
+	//Let higher layers drop their global GPU resources first
+	{
+		lock_guard<mutex> lock(g_vkCleanupCallbackMutex);
+		for(auto& cb : g_vkCleanupCallbacks)
+			cb();
+		g_vkCleanupCallbacks.clear();
+	}
+
+	//Free retired FFT plans before the device they were created on goes away
+	g_vkFFTPlanCache.Clear();
+
 	g_pipelineCacheMgr = nullptr;
 
 	glslang_finalize_process();
@@ -980,6 +1213,9 @@ void VulkanCleanup()
 
 	g_vkQueueManager = nullptr;
 
+	g_vkPinnedMemoryArena = nullptr;
+	g_vkLocalMemoryArena = nullptr;
+
 	g_vkComputeDevice = nullptr;
 	g_vkInstance = nullptr;
 }
@@ -0,0 +1,249 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@brief Implementation of VulkanMemoryArena
+ */
+#include "scopehal.h"
+
+using namespace std;
+
+unique_ptr<VulkanMemoryArena> g_vkPinnedMemoryArena;
+unique_ptr<VulkanMemoryArena> g_vkLocalMemoryArena;
+
+///@brief Smallest size class we track (smaller requests are rounded up to this)
+static const vk::DeviceSize g_minSizeClass = 4096;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Construction / destruction
+
+VulkanMemoryArena::VulkanMemoryArena(
+	uint32_t memoryType,
+	bool hostVisible,
+	const string& name,
+	vk::DeviceSize slabSize)
+	: m_memoryType(memoryType)
+	, m_hostVisible(hostVisible)
+	, m_name(name)
+	, m_slabSize(slabSize)
+	, m_bytesLive(0)
+	, m_bytesOnFreeLists(0)
+	, m_allocCount(0)
+	, m_freeListHits(0)
+	, m_dedicatedCount(0)
+{
+}
+
+VulkanMemoryArena::~VulkanMemoryArena()
+{
+	lock_guard<mutex> lock(m_mutex);
+
+	if(m_bytesLive != 0)
+		LogWarning("VulkanMemoryArena %s destroyed with %zu bytes still live\n", m_name.c_str(), (size_t)m_bytesLive);
+
+	//Unmap before the raii objects free the underlying memory
+	for(auto& slab : m_slabs)
+	{
+		if(slab.m_mem && slab.m_mapped)
+			slab.m_mem->unmapMemory();
+	}
+	m_slabs.clear();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Allocation
+
+vk::DeviceMemory VulkanMemoryArena::Block::GetMemory()
+{
+	return **m_arena->m_slabs[m_slab].m_mem;
+}
+
+///@brief Rounds a request up to the next power-of-two size class
+vk::DeviceSize VulkanMemoryArena::RoundToSizeClass(vk::DeviceSize size)
+{
+	vk::DeviceSize c = g_minSizeClass;
+	while(c < size)
+		c <<= 1;
+	return c;
+}
+
+/**
+	@brief Allocates a new slab and returns its index, reusing a hole left by a freed dedicated slab if possible
+
+	Assumes m_mutex is locked.
+ */
+size_t VulkanMemoryArena::MakeSlab(vk::DeviceSize size, bool dedicated)
+{
+	Slab slab;
+	vk::MemoryAllocateInfo info(size, m_memoryType);
+	slab.m_mem = make_unique<vk::raii::DeviceMemory>(*g_vkComputeDevice, info);
+	slab.m_mapped = m_hostVisible ? slab.m_mem->mapMemory(0, size) : nullptr;
+	slab.m_size = size;
+	slab.m_used = 0;
+	slab.m_dedicated = dedicated;
+
+	if(g_hasDebugUtils)
+	{
+		string sname = m_name + ".slab" + to_string(m_slabs.size());
+		g_vkComputeDevice->setDebugUtilsObjectNameEXT(
+			vk::DebugUtilsObjectNameInfoEXT(
+				vk::ObjectType::eDeviceMemory,
+				reinterpret_cast<uint64_t>(static_cast<VkDeviceMemory>(**slab.m_mem)),
+				sname.c_str()));
+	}
+
+	for(size_t i=0; i<m_slabs.size(); i++)
+	{
+		if(m_slabs[i].m_mem == nullptr)
+		{
+			m_slabs[i] = move(slab);
+			return i;
+		}
+	}
+	m_slabs.push_back(move(slab));
+	return m_slabs.size() - 1;
+}
+
+/**
+	@brief Allocates a block of at least the requested size, aligned to at least the requested alignment
+ */
+unique_ptr<VulkanMemoryArena::Block> VulkanMemoryArena::Allocate(vk::DeviceSize size, vk::DeviceSize alignment)
+{
+	lock_guard<mutex> lock(m_mutex);
+	m_allocCount ++;
+
+	//Oversized request: give it its own dedicated slab
+	if(size > m_slabSize / 2)
+	{
+		auto islab = MakeSlab(size, true);
+		m_dedicatedCount ++;
+		m_bytesLive += size;
+		return make_unique<Block>(this, islab, 0, size, m_slabs[islab].m_mapped);
+	}
+
+	auto sclass = RoundToSizeClass(size);
+
+	//Size classes are powers of two >= 4 kB and blocks are carved at size-class-aligned offsets,
+	//so any freed block of this class already satisfies typical buffer alignment requirements.
+	//Guard against exotic implementations anyway.
+	if(alignment > sclass)
+		LogFatal("VulkanMemoryArena: alignment %zu exceeds size class %zu\n", (size_t)alignment, (size_t)sclass);
+
+	//Fast path: reuse a block off the free list for this size class
+	auto& flist = m_freeLists[sclass];
+	if(!flist.empty())
+	{
+		auto [islab, offset] = flist.back();
+		flist.pop_back();
+		m_freeListHits ++;
+		m_bytesOnFreeLists -= sclass;
+		m_bytesLive += sclass;
+
+		auto& slab = m_slabs[islab];
+		void* mapped = slab.m_mapped ? (static_cast<uint8_t*>(slab.m_mapped) + offset) : nullptr;
+		return make_unique<Block>(this, islab, offset, sclass, mapped);
+	}
+
+	//Carve a fresh block from a slab with room at the end
+	for(size_t i=0; i<m_slabs.size(); i++)
+	{
+		auto& slab = m_slabs[i];
+		if( (slab.m_mem == nullptr) || slab.m_dedicated)
+			continue;
+
+		//Keep the bump pointer aligned to the size class so every block in a class is class-aligned
+		auto offset = (slab.m_used + sclass - 1) & ~(sclass - 1);
+		if(offset + sclass > slab.m_size)
+			continue;
+
+		slab.m_used = offset + sclass;
+		m_bytesLive += sclass;
+
+		void* mapped = slab.m_mapped ? (static_cast<uint8_t*>(slab.m_mapped) + offset) : nullptr;
+		return make_unique<Block>(this, i, offset, sclass, mapped);
+	}
+
+	//All slabs full, grab a new one
+	auto islab = MakeSlab(m_slabSize, false);
+	m_slabs[islab].m_used = sclass;
+	m_bytesLive += sclass;
+	return make_unique<Block>(this, islab, 0, sclass, m_slabs[islab].m_mapped);
+}
+
+/**
+	@brief Returns a block to the arena (called by Block's destructor)
+ */
+void VulkanMemoryArena::Free(Block& block)
+{
+	lock_guard<mutex> lock(m_mutex);
+
+	auto& slab = m_slabs[block.m_slab];
+	m_bytesLive -= block.m_size;
+
+	//Dedicated slabs die with their block
+	if(slab.m_dedicated)
+	{
+		if(slab.m_mapped)
+			slab.m_mem->unmapMemory();
+		slab.m_mem = nullptr;
+		slab.m_mapped = nullptr;
+		slab.m_size = 0;
+		m_dedicatedCount --;
+		return;
+	}
+
+	m_freeLists[block.m_size].push_back({block.m_slab, block.m_offset});
+	m_bytesOnFreeLists += block.m_size;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Statistics
+
+VulkanMemoryArena::Statistics VulkanMemoryArena::GetStatistics()
+{
+	lock_guard<mutex> lock(m_mutex);
+
+	Statistics stats;
+	stats.m_slabCount = 0;
+	stats.m_bytesReserved = 0;
+	for(auto& slab : m_slabs)
+	{
+		if(slab.m_mem == nullptr)
+			continue;
+		stats.m_slabCount ++;
+		stats.m_bytesReserved += slab.m_size;
+	}
+	stats.m_dedicatedCount = m_dedicatedCount;
+	stats.m_bytesLive = m_bytesLive;
+	stats.m_bytesOnFreeLists = m_bytesOnFreeLists;
+	stats.m_allocCount = m_allocCount;
+	stats.m_freeListHits = m_freeListHits;
+	return stats;
+}
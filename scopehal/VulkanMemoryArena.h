@@ -0,0 +1,196 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@brief Declaration of VulkanMemoryArena
+ */
+#ifndef VulkanMemoryArena_h
+#define VulkanMemoryArena_h
+
+#include <map>
+#include <mutex>
+#include <vector>
+
+/**
+	@brief Slab sub-allocator for a single Vulkan memory type
+
+	Vulkan implementations cap the total number of vkAllocateMemory allocations (maxMemoryAllocationCount, commonly
+	4096) and each allocation is expensive, so AcceleratorBuffer must not do one device allocation per buffer.
+	Instead, the arena grabs large slabs up front and carves buffer-sized blocks out of them.
+
+	Blocks are rounded up to power-of-two size classes with a free list per class, so a freed block can be reused
+	by the next allocation of the same class without touching the slab bump pointer. Allocations too big for
+	sub-allocation get a dedicated slab of their own, released when the block is freed.
+
+	Host-visible arenas map each slab once, persistently; blocks expose a pointer into the slab mapping rather
+	than mapping and unmapping per buffer.
+ */
+class VulkanMemoryArena
+{
+public:
+
+	/**
+		@brief A single sub-allocated block of device memory
+
+		Returned by Allocate() and returns itself to the arena's free lists on destruction.
+	 */
+	class Block
+	{
+	public:
+		Block(VulkanMemoryArena* arena, size_t slab, vk::DeviceSize offset, vk::DeviceSize size, void* mapped)
+			: m_arena(arena)
+			, m_slab(slab)
+			, m_offset(offset)
+			, m_size(size)
+			, m_mapped(mapped)
+		{}
+
+		~Block()
+		{ m_arena->Free(*this); }
+
+		Block(const Block&) = delete;
+		Block& operator=(const Block&) = delete;
+
+		///@brief Gets the device memory object this block lives in (do not free, the arena owns it)
+		vk::DeviceMemory GetMemory();
+
+		///@brief Gets the byte offset of this block within the memory object
+		vk::DeviceSize GetOffset() const
+		{ return m_offset; }
+
+		///@brief Gets the rounded-up size of this block, in bytes
+		vk::DeviceSize GetSize() const
+		{ return m_size; }
+
+		///@brief Gets the CPU-side pointer to this block (null if the arena is not host visible)
+		void* GetMappedPtr() const
+		{ return m_mapped; }
+
+	protected:
+		friend class VulkanMemoryArena;
+
+		VulkanMemoryArena* m_arena;
+		size_t m_slab;
+		vk::DeviceSize m_offset;
+		vk::DeviceSize m_size;
+		void* m_mapped;
+	};
+
+	///@brief Counters describing arena occupancy and fragmentation
+	struct Statistics
+	{
+		///@brief Number of slabs (vkAllocateMemory calls currently outstanding)
+		size_t m_slabCount;
+
+		///@brief Number of dedicated (too-big-to-pool) allocations included in m_slabCount
+		size_t m_dedicatedCount;
+
+		///@brief Total bytes reserved from the Vulkan implementation
+		vk::DeviceSize m_bytesReserved;
+
+		///@brief Bytes currently handed out in live blocks (including size-class rounding)
+		vk::DeviceSize m_bytesLive;
+
+		///@brief Bytes sitting on free lists, reusable only by same-size-class allocations
+		vk::DeviceSize m_bytesOnFreeLists;
+
+		///@brief Lifetime count of Allocate() calls
+		size_t m_allocCount;
+
+		///@brief Lifetime count of allocations satisfied from a free list without new slab traffic
+		size_t m_freeListHits;
+	};
+
+	VulkanMemoryArena(uint32_t memoryType, bool hostVisible, const std::string& name,
+		vk::DeviceSize slabSize = 64 * 1024 * 1024);
+	~VulkanMemoryArena();
+
+	std::unique_ptr<Block> Allocate(vk::DeviceSize size, vk::DeviceSize alignment);
+
+	Statistics GetStatistics();
+
+protected:
+	friend class Block;
+
+	void Free(Block& block);
+
+	///@brief One vkAllocateMemory's worth of backing store
+	struct Slab
+	{
+		std::unique_ptr<vk::raii::DeviceMemory> m_mem;
+		void* m_mapped;
+		vk::DeviceSize m_size;
+
+		///@brief Bump pointer: bytes at the start of the slab that have ever been carved out
+		vk::DeviceSize m_used;
+
+		///@brief True if this slab backs a single oversized block and dies when it's freed
+		bool m_dedicated;
+	};
+
+	size_t MakeSlab(vk::DeviceSize size, bool dedicated);
+	vk::DeviceSize RoundToSizeClass(vk::DeviceSize size);
+
+	///@brief Memory type index we allocate from
+	uint32_t m_memoryType;
+
+	///@brief True if slabs should be persistently mapped for CPU access
+	bool m_hostVisible;
+
+	///@brief Friendly name (for debug tools)
+	std::string m_name;
+
+	///@brief Size of a normal (non-dedicated) slab
+	vk::DeviceSize m_slabSize;
+
+	///@brief Lock guarding all arena state
+	std::mutex m_mutex;
+
+	///@brief All live slabs (dedicated or pooled); freed dedicated slots are nulled and recycled
+	std::vector<Slab> m_slabs;
+
+	///@brief Free blocks, bucketed by size class
+	std::map<vk::DeviceSize, std::vector<std::pair<size_t, vk::DeviceSize>>> m_freeLists;
+
+	//Statistics counters
+	vk::DeviceSize m_bytesLive;
+	vk::DeviceSize m_bytesOnFreeLists;
+	size_t m_allocCount;
+	size_t m_freeListHits;
+	size_t m_dedicatedCount;
+};
+
+///@brief Arena for pinned host-visible memory (g_vkPinnedMemoryType)
+extern std::unique_ptr<VulkanMemoryArena> g_vkPinnedMemoryArena;
+
+///@brief Arena for card-local memory (g_vkLocalMemoryType)
+extern std::unique_ptr<VulkanMemoryArena> g_vkLocalMemoryArena;
+
+#endif
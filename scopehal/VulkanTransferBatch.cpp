@@ -0,0 +1,69 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@brief Implementation of VulkanTransferBatch
+ */
+#include "scopehal.h"
+
+using namespace std;
+
+/**
+	@brief Submits all pending copies as one command buffer with a single fence wait, then clears stale flags
+ */
+void VulkanTransferBatch::Flush()
+{
+	if(m_pending.empty())
+		return;
+
+	{
+		lock_guard<mutex> lock(g_vkTransferMutex);
+
+		//Record every pending copy into a single command buffer
+		g_vkTransferCommandBuffer->begin({});
+		for(auto& copy : m_pending)
+		{
+			vk::BufferCopy region(copy.m_offset, copy.m_offset, copy.m_size);
+			g_vkTransferCommandBuffer->copyBuffer(copy.m_src, copy.m_dst, {region});
+		}
+		g_vkTransferCommandBuffer->end();
+
+		//Submit the request and block until it completes
+		g_vkTransferQueue->SubmitAndBlock(*g_vkTransferCommandBuffer);
+	}
+
+	//Transfers are complete, destination buffers are now up to date
+	for(auto& copy : m_pending)
+	{
+		if(copy.m_staleFlag)
+			*copy.m_staleFlag = false;
+	}
+	m_pending.clear();
+}
@@ -0,0 +1,102 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@brief Declaration of VulkanTransferBatch
+ */
+#ifndef VulkanTransferBatch_h
+#define VulkanTransferBatch_h
+
+#include <vector>
+
+/**
+	@brief Accumulator for host<->device copies that should be submitted as one batch
+
+	CopyToGpu()/CopyToCpu() each record a one-copy command buffer, submit it, and block on the fence. When a trigger
+	lands with many channels needing upload, that means many serialized submit/wait round trips. A VulkanTransferBatch
+	instead collects all the pending copies for a scheduling wave and Flush() submits them in a single command buffer
+	with a single fence wait.
+
+	The caller must keep the source and destination buffers alive until Flush() returns. Staleness flags passed to
+	AddCopy() are cleared by Flush() once the transfer has completed.
+ */
+class VulkanTransferBatch
+{
+public:
+	VulkanTransferBatch()
+	{}
+
+	//not copyable (pending copies reference live buffer state)
+	VulkanTransferBatch(const VulkanTransferBatch&) = delete;
+	VulkanTransferBatch& operator=(const VulkanTransferBatch&) = delete;
+
+	/**
+		@brief Adds a copy to the batch
+
+		@param src			Source buffer
+		@param dst			Destination buffer
+		@param size			Number of bytes to copy
+		@param staleFlag	Staleness flag for the destination, cleared when the batch is flushed (may be null)
+		@param offset		Byte offset into both buffers at which the copy begins
+	 */
+	void AddCopy(vk::Buffer src, vk::Buffer dst, vk::DeviceSize size, bool* staleFlag, vk::DeviceSize offset = 0)
+	{
+		PendingCopy copy;
+		copy.m_src = src;
+		copy.m_dst = dst;
+		copy.m_size = size;
+		copy.m_offset = offset;
+		copy.m_staleFlag = staleFlag;
+		m_pending.push_back(copy);
+	}
+
+	///@brief Returns true if there are no copies waiting to be flushed
+	bool empty() const
+	{ return m_pending.empty(); }
+
+	void Flush();
+
+protected:
+
+	///@brief A single host<->device copy waiting to be submitted
+	struct PendingCopy
+	{
+		vk::Buffer m_src;
+		vk::Buffer m_dst;
+		vk::DeviceSize m_size;
+		vk::DeviceSize m_offset;
+		bool* m_staleFlag;
+	};
+
+	///@brief Copies added since the last Flush()
+	std::vector<PendingCopy> m_pending;
+};
+
+#endif
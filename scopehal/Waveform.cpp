@@ -112,10 +112,7 @@ size_t GetIndexNearestAtOrBeforeTimestamp(WaveformBase* wfm, int64_t time_fs, bo
 			return wfm->size() - 1;
 		}
 
-		result = BinarySearchForGequal(
-			swfm->m_offsets.GetCpuPointer(),
-			wfm->size(),
-			target);
+		result = swfm->FindIndexGequal(target);
 
 		// Unless we found an exact match, step back one sample
 		if (!(swfm->m_offsets[result] <= target))
@@ -301,9 +298,32 @@ uint32_t ColorFromString(const string& str, unsigned int alpha)
 
 /**
 	@brief Updates the cache of packed colors to avoid string parsing every frame
+
+	Waveforms using the palette path (m_colorPalette nonempty) only resolve each palette entry here; the
+	per-sample state is the decoder-filled index buffer, so there is no O(n) work regardless of depth.
  */
 void WaveformBase::CacheColors()
 {
+	//Palette mode: resolve each palette entry exactly once.
+	//Unused slots get the error color so a stray out-of-range index can't read uninitialized data.
+	if(!m_colorPalette.empty())
+	{
+		if(m_cachedColorRevision == m_revision)
+			return;
+		m_cachedColorRevision = m_revision;
+
+		auto errorColor = ColorFromString(StandardColors::colors[StandardColors::COLOR_ERROR], 0xff);
+		for(size_t i=0; i<256; i++)
+			m_resolvedPalette[i] = errorColor;
+		auto n = min(m_colorPalette.size(), (size_t)256);
+		for(size_t i=0; i<n; i++)
+			m_resolvedPalette[i] = ColorFromString(m_colorPalette[i], 0xff);
+
+		//Make sure the index buffer is readable for GetColorCached()
+		m_paletteIndices.PrepareForCpuAccess();
+		return;
+	}
+
 	//no update needed
 	if(!m_protocolColors.empty() && (m_cachedColorRevision == m_revision) )
 		return;
@@ -319,3 +339,480 @@ void WaveformBase::CacheColors()
 
 	m_protocolColors.MarkModifiedFromCpu();
 }
+
+/**
+	@brief Updates the cache of display text to avoid re-formatting every sample each frame
+
+	Renderers should call this once per frame (it's a no-op if the waveform hasn't changed) and then fetch
+	individual strings with GetTextCached(), rather than paying a virtual call and a snprintf per sample per frame
+	through GetText().
+ */
+void WaveformBase::CacheText()
+{
+	//no update needed
+	if(!m_protocolText.empty() && (m_cachedTextRevision == m_revision) )
+		return;
+
+	m_cachedTextRevision = m_revision;
+
+	auto s = size();
+	m_protocolText.resize(s);
+
+	for(size_t i=0; i<s; i++)
+		m_protocolText[i] = GetText(i);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// SparseWaveformBase time index
+
+/**
+	@brief Updates the coarse time index (every TIME_INDEX_STRIDE'th offset) used by FindIndexGequal()
+
+	No-op if the index is already current for this revision of the waveform.
+ */
+void SparseWaveformBase::BuildTimeIndex()
+{
+	//no update needed
+	if(!m_coarseOffsets.empty() && (m_cachedIndexRevision == m_revision) )
+		return;
+
+	m_cachedIndexRevision = m_revision;
+
+	m_offsets.PrepareForCpuAccess();
+
+	auto len = m_offsets.size();
+	m_coarseOffsets.resize( (len + TIME_INDEX_STRIDE - 1) / TIME_INDEX_STRIDE );
+	m_coarseOffsets.PrepareForCpuAccess();
+
+	for(size_t i=0; i*TIME_INDEX_STRIDE < len; i++)
+		m_coarseOffsets[i] = m_offsets[i * TIME_INDEX_STRIDE];
+
+	m_coarseOffsets.MarkModifiedFromCpu();
+}
+
+/**
+	@brief Searches m_offsets for the requested timestamp, using the coarse index to narrow the search window
+
+	Same return contract as BinarySearchForGequal(): the bracketing lower index, clipped to the ends of the waveform.
+
+	Caller must have called PrepareForCpuAccess() on the waveform.
+ */
+size_t SparseWaveformBase::FindIndexGequal(int64_t target)
+{
+	auto len = m_offsets.size();
+	if(len == 0)
+		return 0;
+
+	BuildTimeIndex();
+
+	//Clip to the ends of the waveform (matching BinarySearchForGequal edge behavior)
+	if(m_offsets[0] >= target)
+		return 0;
+	if(m_offsets[len-1] < target)
+		return len - 1;
+
+	//Coarse search picks the block, fine search covers that block plus the next
+	//(the bracketing index may be up to one stride past the coarse hit)
+	size_t block = BinarySearchForGequal(m_coarseOffsets.GetCpuPointer(), m_coarseOffsets.size(), target);
+	size_t lo = block * TIME_INDEX_STRIDE;
+	size_t hi = min( (block + 2) * TIME_INDEX_STRIDE, len );
+	return lo + BinarySearchForGequal(m_offsets.GetCpuPointer() + lo, hi - lo, target);
+}
+
+/**
+	@brief Returns the index of the last sample whose offset is <= target
+
+	If target precedes the first sample, returns 0 (the caller can check m_offsets[0] to detect this).
+ */
+size_t SparseTimeCursor::SeekGequal(SparseWaveformBase* wfm, int64_t target)
+{
+	auto& offsets = wfm->m_offsets;
+	auto len = offsets.size();
+	if(len == 0)
+		return 0;
+
+	//Validate the saved position against the waveform identity and revision.
+	//A producer that only appended samples (revision bumped exactly once, saved position before the dirty
+	//region) left everything we care about intact, so the position survives; any other change invalidates it.
+	if(wfm != m_wfm)
+		m_index = len;
+	else if(wfm->m_revision != m_cachedRevision)
+	{
+		if( (wfm->m_revision != m_cachedRevision + 1) || (m_index >= wfm->m_dirtyStart) )
+			m_index = len;
+	}
+	m_wfm = wfm;
+	m_cachedRevision = wfm->m_revision;
+
+	//If we've been invalidated, or the target moved backwards, restart with an indexed search
+	if( (m_index >= len) || (offsets[m_index] > target) )
+		m_index = wfm->FindIndexGequal(target);
+
+	//Advance linearly (amortized O(1) for monotonically increasing targets)
+	while( (m_index + 1 < len) && (offsets[m_index + 1] <= target) )
+		m_index ++;
+
+	return m_index;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// SparseWaveformBase packed timestamp representation
+
+/**
+	@brief Checks whether the timestamps would fit the packed representation, without converting anything
+
+	True if every offset delta from the first sample, and every duration, fits in 32 bits. Intended for memory
+	layout audits together with GetMetadataBytes(); PackMetadata() performs the same checks itself.
+ */
+bool SparseWaveformBase::CanPackMetadata()
+{
+	if(m_metadataPacked)
+		return true;
+
+	size_t len = m_offsets.size();
+	if(len == 0)
+		return true;
+
+	m_offsets.PrepareForCpuAccess();
+	m_durations.PrepareForCpuAccess();
+
+	//Offsets are monotonic, so the span check only needs the endpoints
+	if( (uint64_t)(m_offsets[len-1] - m_offsets[0]) > 0xffffffff )
+		return false;
+
+	int64_t* durations = m_durations.GetCpuPointer();
+	for(size_t i=0; i<len; i++)
+	{
+		if( (uint64_t)durations[i] > 0xffffffff )
+			return false;
+	}
+
+	return true;
+}
+
+/**
+	@brief Converts the timestamps to the packed at-rest form, halving their memory footprint
+
+	Returns false (leaving the waveform untouched) if any delta overflows 32 bits; the waveform then simply
+	stays in the int64 representation. No-op if already packed.
+
+	The int64 buffers are freed on success, so the waveform must not be used by anything that indexes
+	m_offsets / m_durations until UnpackMetadata() is called.
+ */
+bool SparseWaveformBase::PackMetadata()
+{
+	if(m_metadataPacked)
+		return true;
+
+	size_t len = m_offsets.size();
+	if(len == 0)
+	{
+		m_packedBase = 0;
+		m_metadataPacked = true;
+		return true;
+	}
+
+	if(!CanPackMetadata())
+		return false;
+
+	int64_t* offsets = m_offsets.GetCpuPointer();
+	int64_t* durations = m_durations.GetCpuPointer();
+	int64_t base = offsets[0];
+
+	m_packedOffsets.resize(len);
+	m_packedDurations.resize(len);
+	m_packedOffsets.PrepareForCpuAccess();
+	m_packedDurations.PrepareForCpuAccess();
+	uint32_t* poffsets = m_packedOffsets.GetCpuPointer();
+	uint32_t* pdurations = m_packedDurations.GetCpuPointer();
+
+	if(len > 1000000)
+	{
+		#pragma omp parallel for
+		for(size_t i=0; i<len; i++)
+		{
+			poffsets[i] = (uint32_t)(offsets[i] - base);
+			pdurations[i] = (uint32_t)durations[i];
+		}
+	}
+	else
+	{
+		for(size_t i=0; i<len; i++)
+		{
+			poffsets[i] = (uint32_t)(offsets[i] - base);
+			pdurations[i] = (uint32_t)durations[i];
+		}
+	}
+
+	m_packedOffsets.MarkModifiedFromCpu();
+	m_packedDurations.MarkModifiedFromCpu();
+
+	//Free the wide buffers (and the coarse index, which points into them)
+	m_offsets.clear();
+	m_offsets.shrink_to_fit();
+	m_durations.clear();
+	m_durations.shrink_to_fit();
+	m_coarseOffsets.clear();
+	m_coarseOffsets.shrink_to_fit();
+
+	m_packedBase = base;
+	m_metadataPacked = true;
+	return true;
+}
+
+/**
+	@brief Regenerates the int64 timestamp buffers from the packed form and frees it. No-op if not packed.
+ */
+void SparseWaveformBase::UnpackMetadata()
+{
+	if(!m_metadataPacked)
+		return;
+
+	size_t len = m_packedOffsets.size();
+	m_offsets.resize(len);
+	m_durations.resize(len);
+
+	if(len != 0)
+	{
+		m_packedOffsets.PrepareForCpuAccess();
+		m_packedDurations.PrepareForCpuAccess();
+		m_offsets.PrepareForCpuAccess();
+		m_durations.PrepareForCpuAccess();
+
+		uint32_t* poffsets = m_packedOffsets.GetCpuPointer();
+		uint32_t* pdurations = m_packedDurations.GetCpuPointer();
+		int64_t* offsets = m_offsets.GetCpuPointer();
+		int64_t* durations = m_durations.GetCpuPointer();
+		int64_t base = m_packedBase;
+
+		if(len > 1000000)
+		{
+			#pragma omp parallel for
+			for(size_t i=0; i<len; i++)
+			{
+				offsets[i] = base + poffsets[i];
+				durations[i] = pdurations[i];
+			}
+		}
+		else
+		{
+			for(size_t i=0; i<len; i++)
+			{
+				offsets[i] = base + poffsets[i];
+				durations[i] = pdurations[i];
+			}
+		}
+
+		MarkTimestampsModifiedFromCpu();
+	}
+
+	m_packedOffsets.clear();
+	m_packedOffsets.shrink_to_fit();
+	m_packedDurations.clear();
+	m_packedDurations.shrink_to_fit();
+
+	m_metadataPacked = false;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// QuantizedUniformAnalogWaveform
+
+QuantizedUniformAnalogWaveform::QuantizedUniformAnalogWaveform(const string& name)
+	: UniformAnalogWaveform(name)
+	, m_format(FORMAT_INT8)
+	, m_gain(1)
+	, m_offset(0)
+	, m_floatSamplesValid(false)
+	, m_numSamples(0)
+{
+	//Codes are expected to be filled CPU side and consumed by the dequantization shader
+	m_codes.SetCpuAccessHint(AcceleratorBuffer<uint8_t>::HINT_LIKELY);
+	m_codes.SetGpuAccessHint(AcceleratorBuffer<uint8_t>::HINT_LIKELY);
+
+	Rename(name);
+}
+
+QuantizedUniformAnalogWaveform::~QuantizedUniformAnalogWaveform()
+{
+}
+
+/**
+	@brief Sets the code format and conversion factors
+
+	Call before Resize() so the code buffer is sized for the right code width.
+ */
+void QuantizedUniformAnalogWaveform::Configure(CodeFormat format, float gain, float offset)
+{
+	m_format = format;
+	m_gain = gain;
+	m_offset = offset;
+	m_floatSamplesValid = false;
+}
+
+void QuantizedUniformAnalogWaveform::Rename(const string& name)
+{
+	UniformAnalogWaveform::Rename(name);
+
+	if(name.empty())
+		m_codes.SetName("QuantizedUniformAnalogWaveform.m_codes");
+	else
+		m_codes.SetName(name + ".m_codes");
+}
+
+void QuantizedUniformAnalogWaveform::Resize(size_t size)
+{
+	m_numSamples = size;
+	m_codes.resize(size * GetBytesPerCode());
+
+	//Don't touch m_samples: the float view is only sized when it's materialized
+	m_floatSamplesValid = false;
+}
+
+size_t QuantizedUniformAnalogWaveform::size() const
+{ return m_numSamples; }
+
+void QuantizedUniformAnalogWaveform::clear()
+{
+	m_numSamples = 0;
+	m_codes.clear();
+	m_samples.clear();
+	m_floatSamplesValid = false;
+}
+
+size_t QuantizedUniformAnalogWaveform::GetAllocatedBytes() const
+{
+	return UniformAnalogWaveform::GetAllocatedBytes() +
+		m_codes.GetCpuMemoryBytes() + m_codes.GetGpuMemoryBytes();
+}
+
+/**
+	@brief Invalidates the float view after the code buffer has been rewritten from the CPU
+ */
+void QuantizedUniformAnalogWaveform::MarkCodesModifiedFromCpu()
+{
+	m_codes.MarkModifiedFromCpu();
+	m_floatSamplesValid = false;
+}
+
+void QuantizedUniformAnalogWaveform::PrepareForCpuAccess()
+{
+	if(!m_floatSamplesValid)
+		MaterializeOnCpu();
+
+	UniformAnalogWaveform::PrepareForCpuAccess();
+}
+
+void QuantizedUniformAnalogWaveform::PrepareForGpuAccess()
+{
+	if(!m_floatSamplesValid)
+	{
+		//Dequantize on the GPU when we can, so only the packed codes cross the PCIe bus
+		bool canUseGpu;
+		if(m_format == FORMAT_INT16)
+			canUseGpu = RawSampleConverter::IsGpuConversionAvailable16Bit();
+		else
+			canUseGpu = RawSampleConverter::IsGpuConversionAvailable8Bit();
+
+		if(canUseGpu)
+			MaterializeOnGpu();
+		else
+			MaterializeOnCpu();
+	}
+
+	UniformAnalogWaveform::PrepareForGpuAccess();
+}
+
+//Materialization involves a shader dispatch or CPU-side conversion, neither of which can be deferred to a
+//transfer batch, so the batched variants fall back to the blocking paths when the float view is stale.
+void QuantizedUniformAnalogWaveform::PrepareForCpuAccessBatched(VulkanTransferBatch& batch)
+{
+	if(!m_floatSamplesValid)
+		PrepareForCpuAccess();
+	else
+		UniformAnalogWaveform::PrepareForCpuAccessBatched(batch);
+}
+
+void QuantizedUniformAnalogWaveform::PrepareForGpuAccessBatched(VulkanTransferBatch& batch)
+{
+	if(!m_floatSamplesValid)
+		PrepareForGpuAccess();
+	else
+		UniformAnalogWaveform::PrepareForGpuAccessBatched(batch);
+}
+
+/**
+	@brief Converts the code buffer to floats on the CPU
+ */
+void QuantizedUniformAnalogWaveform::MaterializeOnCpu()
+{
+	m_codes.PrepareForCpuAccess();
+
+	m_samples.resize(m_numSamples);
+	m_samples.PrepareForCpuAccess();
+
+	switch(m_format)
+	{
+		case FORMAT_INT8:
+			{
+				auto codes = reinterpret_cast<const int8_t*>(m_codes.GetCpuPointer());
+				for(size_t i=0; i<m_numSamples; i++)
+					m_samples[i] = codes[i]*m_gain - m_offset;
+			}
+			break;
+
+		case FORMAT_UINT8:
+			{
+				auto codes = m_codes.GetCpuPointer();
+				for(size_t i=0; i<m_numSamples; i++)
+					m_samples[i] = codes[i]*m_gain - m_offset;
+			}
+			break;
+
+		case FORMAT_INT16:
+			{
+				auto codes = reinterpret_cast<const int16_t*>(m_codes.GetCpuPointer());
+				for(size_t i=0; i<m_numSamples; i++)
+					m_samples[i] = codes[i]*m_gain - m_offset;
+			}
+			break;
+	}
+
+	m_samples.MarkModifiedFromCpu();
+	m_floatSamplesValid = true;
+}
+
+/**
+	@brief Converts the code buffer to floats with a compute shader, writing straight to the GPU-side sample buffer
+ */
+void QuantizedUniformAnalogWaveform::MaterializeOnGpu()
+{
+	//Shared converter for all quantized waveforms
+	//(serialized by the mutex; the conversion is cheap relative to the transfers it avoids)
+	static mutex s_converterMutex;
+	static unique_ptr<RawSampleConverter> s_converter;
+
+	lock_guard<mutex> lock(s_converterMutex);
+	if(!s_converter)
+		s_converter = make_unique<RawSampleConverter>("QuantizedUniformAnalogWaveform");
+
+	m_samples.resize(m_numSamples);
+
+	s_converter->Begin();
+	switch(m_format)
+	{
+		case FORMAT_INT8:
+			s_converter->Convert8BitSamples(this, m_codes, m_gain, m_offset);
+			break;
+
+		case FORMAT_UINT8:
+			s_converter->ConvertUnsigned8BitSamples(this, m_codes, m_gain, m_offset);
+			break;
+
+		case FORMAT_INT16:
+			s_converter->Convert16BitSamples(this, m_codes, m_gain, m_offset);
+			break;
+	}
+	s_converter->Submit();
+
+	m_floatSamplesValid = true;
+}
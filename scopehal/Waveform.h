@@ -61,7 +61,9 @@ public:
 		, m_triggerPhase(0)
 		, m_flags(0)
 		, m_revision(0)
+		, m_dirtyStart(0)
 		, m_cachedColorRevision(0)
+		, m_cachedTextRevision(0)
 	{
 	}
 
@@ -72,6 +74,7 @@ public:
 		, m_triggerPhase(rhs.m_triggerPhase)
 		, m_flags(rhs.m_flags)
 		, m_revision(rhs.m_revision)
+		, m_dirtyStart(0)
 	{}
 
 	//empty virtual destructor in case any derived classes need one
@@ -121,6 +124,20 @@ public:
 	 */
 	uint64_t m_revision;
 
+	/**
+		@brief Index of the first sample that may have changed since the previous revision.
+
+		This is a hint for incremental consumers of streaming waveforms: all samples before m_dirtyStart are
+		guaranteed to be identical to the previous revision of this waveform object. Producers that only append
+		samples (for example, trend buffers fed by a streaming instrument) set this to the old length when bumping
+		m_revision; any other modification (trimming, rebasing timestamps, rewriting in place) must reset it to zero.
+
+		A consumer caching per-sample derived state may skip samples before this index only if the waveform pointer
+		is unchanged and m_revision advanced by exactly one since its cached copy; otherwise intermediate updates may
+		have touched earlier samples and a full rescan is required.
+	 */
+	size_t m_dirtyStart;
+
 	enum
 	{
 		WAVEFORM_CLIPPING = 1
@@ -131,6 +148,15 @@ public:
 
 	virtual size_t size() const  =0;
 
+	/**
+		@brief Returns the total CPU + GPU memory allocated by sample data buffers, in bytes
+
+		Used by WaveformPool for memory budgeting. The default implementation returns 0; waveform types meant to
+		be pooled should override it.
+	 */
+	virtual size_t GetAllocatedBytes() const
+	{ return 0; }
+
 	virtual bool empty()
 	{ return size() == 0; }
 
@@ -139,16 +165,40 @@ public:
 		return "(unimplemented)";
 	}
 
-	virtual std::string GetColor(size_t /*i*/)
+	virtual std::string GetColor(size_t i)
 	{
+		if(!m_colorPalette.empty() && (m_paletteIndices[i] < m_colorPalette.size()) )
+			return m_colorPalette[m_paletteIndices[i]];
 		return StandardColors::colors[StandardColors::COLOR_ERROR];
 	}
 
 	virtual uint32_t GetColorCached(size_t i)
-	{ return m_protocolColors[i]; }
+	{
+		if(!m_colorPalette.empty())
+			return m_resolvedPalette[m_paletteIndices[i]];
+		return m_protocolColors[i];
+	}
+
+	///@brief Returns the display text of a sample from the cache built by CacheText()
+	virtual const std::string& GetTextCached(size_t i)
+	{ return m_protocolText[i]; }
 
 	virtual void PrepareForCpuAccess() =0;
 	virtual void PrepareForGpuAccess() =0;
+
+	/**
+		@brief Prepares the waveform for CPU access, deferring any needed copies to the supplied batch.
+
+		Default implementation falls back to the blocking path; waveform types backed by AcceleratorBuffer
+		override this to enqueue their transfers instead.
+	 */
+	virtual void PrepareForCpuAccessBatched(VulkanTransferBatch& /*batch*/)
+	{ PrepareForCpuAccess(); }
+
+	///@brief Prepares the waveform for GPU access, deferring any needed copies to the supplied batch.
+	virtual void PrepareForGpuAccessBatched(VulkanTransferBatch& /*batch*/)
+	{ PrepareForGpuAccess(); }
+
 	virtual void MarkSamplesModifiedFromCpu() =0;
 	virtual void MarkSamplesModifiedFromGpu() =0;
 
@@ -156,14 +206,39 @@ public:
 	virtual void MarkModifiedFromGpu() =0;
 
 	virtual void CacheColors();
+	virtual void CacheText();
+
+	/**
+		@brief Optional color palette for batch color caching.
+
+		Decoders that only ever produce a handful of distinct colors may fill this with one entry per color and
+		write a palette index per sample to m_paletteIndices, instead of overriding GetColor(). CacheColors()
+		then resolves each palette entry to packed RGBA exactly once rather than making a virtual call and
+		parsing a color string per sample, and per-sample color metadata shrinks from four bytes to one.
+
+		Limited to 256 entries; out-of-range indices display as COLOR_ERROR.
+	 */
+	std::vector<std::string> m_colorPalette;
+
+	///@brief Palette index of each sample, filled by the decoder when m_colorPalette is in use
+	AcceleratorBuffer<uint8_t> m_paletteIndices;
 
 protected:
 
 	///@brief Protocol decode colors
 	AcceleratorBuffer<uint32_t> m_protocolColors;
 
+	///@brief Packed RGBA color of each m_colorPalette entry, built by CacheColors()
+	uint32_t m_resolvedPalette[256];
+
 	///@brief Revision we last cached colors of
 	uint64_t m_cachedColorRevision;
+
+	///@brief Protocol decode display text
+	std::vector<std::string> m_protocolText;
+
+	///@brief Revision we last cached text of
+	uint64_t m_cachedTextRevision;
 };
 
 template<class S> class SparseWaveform;
@@ -173,6 +248,9 @@ class SparseWaveformBase : public WaveformBase
 public:
 
 	SparseWaveformBase()
+		: m_packedBase(0)
+		, m_cachedIndexRevision(0)
+		, m_metadataPacked(false)
 	{
 		//Default timestamps to CPU/GPU mirror
 		m_offsets.SetCpuAccessHint(AcceleratorBuffer<int64_t>::HINT_LIKELY);
@@ -181,6 +259,15 @@ public:
 		m_durations.SetCpuAccessHint(AcceleratorBuffer<int64_t>::HINT_LIKELY);
 		m_durations.SetGpuAccessHint(AcceleratorBuffer<int64_t>::HINT_LIKELY);
 
+		m_coarseOffsets.SetCpuAccessHint(AcceleratorBuffer<int64_t>::HINT_LIKELY);
+		m_coarseOffsets.SetGpuAccessHint(AcceleratorBuffer<int64_t>::HINT_LIKELY);
+
+		m_packedOffsets.SetCpuAccessHint(AcceleratorBuffer<uint32_t>::HINT_LIKELY);
+		m_packedOffsets.SetGpuAccessHint(AcceleratorBuffer<uint32_t>::HINT_LIKELY);
+
+		m_packedDurations.SetCpuAccessHint(AcceleratorBuffer<uint32_t>::HINT_LIKELY);
+		m_packedDurations.SetGpuAccessHint(AcceleratorBuffer<uint32_t>::HINT_LIKELY);
+
 		m_offsets.PrepareForCpuAccess();
 		m_durations.PrepareForCpuAccess();
 	}
@@ -226,12 +313,126 @@ public:
 		MarkSamplesModifiedFromGpu();
 		MarkTimestampsModifiedFromGpu();
 	}
+
+	///@brief Stride of the coarse time index (one cached offset per this many samples)
+	static const size_t TIME_INDEX_STRIDE = 64;
+
+	/**
+		@brief Every TIME_INDEX_STRIDE'th sample offset, for narrowing timestamp searches
+
+		Built on demand by BuildTimeIndex() and invalidated by the waveform revision counter. Stored in an
+		AcceleratorBuffer so shaders doing timestamp lookups can bind it as well.
+	 */
+	AcceleratorBuffer<int64_t> m_coarseOffsets;
+
+	void BuildTimeIndex();
+	size_t FindIndexGequal(int64_t target);
+
+	////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	// Packed timestamp representation
+
+	/*
+		Sixteen bytes of int64 offset + duration metadata per sample dominates the footprint of short-duration
+		digital captures, where deltas from the first timestamp almost always fit in 32 bits. PackMetadata()
+		moves the timestamps into a half-size at-rest form (base timestamp plus uint32 deltas) and frees the
+		int64 buffers; UnpackMetadata() regenerates them. A packed waveform must not be handed to anything that
+		indexes m_offsets / m_durations - pack only waveforms at rest (e.g. in history) and unpack before use.
+		See SparseMetadataPacker for the on-device equivalents.
+	 */
+
+	///@brief Returns true if the timestamps are currently in the packed at-rest form
+	bool IsMetadataPacked() const
+	{ return m_metadataPacked; }
+
+	/**
+		@brief Returns the total CPU + GPU memory currently allocated for timestamp metadata, in bytes
+
+		Covers both representations plus the coarse time index, so it's meaningful on packed and unpacked
+		waveforms alike. Intended for memory layout audits alongside CanPackMetadata().
+	 */
+	size_t GetMetadataBytes() const
+	{
+		return m_offsets.GetCpuMemoryBytes() + m_offsets.GetGpuMemoryBytes() +
+			m_durations.GetCpuMemoryBytes() + m_durations.GetGpuMemoryBytes() +
+			m_coarseOffsets.GetCpuMemoryBytes() + m_coarseOffsets.GetGpuMemoryBytes() +
+			m_packedOffsets.GetCpuMemoryBytes() + m_packedOffsets.GetGpuMemoryBytes() +
+			m_packedDurations.GetCpuMemoryBytes() + m_packedDurations.GetGpuMemoryBytes();
+	}
+
+	bool CanPackMetadata();
+	bool PackMetadata();
+	void UnpackMetadata();
+
+	///@brief Timestamp the packed deltas are relative to (the first sample's offset)
+	int64_t m_packedBase;
+
+	///@brief Packed form of m_offsets: per-sample deltas from m_packedBase
+	AcceleratorBuffer<uint32_t> m_packedOffsets;
+
+	///@brief Packed form of m_durations
+	AcceleratorBuffer<uint32_t> m_packedDurations;
+
+protected:
+
+	///@brief Revision we last built the coarse time index of
+	uint64_t m_cachedIndexRevision;
+
+	///@brief True if timestamps currently live in m_packedOffsets / m_packedDurations rather than the int64 buffers
+	bool m_metadataPacked;
+
+	friend class SparseMetadataPacker;
+};
+
+/**
+	@brief Stateful cursor for traversing a sparse waveform by timestamp
+
+	Remembers the index of the previous lookup, so a series of monotonically increasing targets (the common case
+	when a layered decoder or measurement walks a shared upstream output) advances linearly rather than redoing a
+	full binary search per sample. Seeking backwards is legal and falls back to an indexed search.
+
+	The cursor may be kept as a member and reused across filter passes: each seek validates the saved position
+	against the waveform pointer and revision counter, so a stale cursor silently restarts rather than returning
+	garbage. If the producer only appended samples (revision advanced by exactly one and the saved position is
+	before m_dirtyStart), the position is still good and is kept.
+
+	The caller is responsible for calling PrepareForCpuAccess() on the waveform before seeking.
+ */
+class SparseTimeCursor
+{
+public:
+	SparseTimeCursor()
+		: m_wfm(nullptr)
+		, m_index(0)
+		, m_cachedRevision(0)
+	{}
+
+	size_t SeekGequal(SparseWaveformBase* wfm, int64_t target);
+
+	///@brief Forgets the saved position, forcing the next seek to do an indexed search
+	void Reset()
+	{ m_wfm = nullptr; }
+
+	///@brief Returns the index of the most recent lookup
+	size_t GetIndex() const
+	{ return m_index; }
+
+protected:
+	///@brief Waveform the saved position refers to (never dereferenced for validation, only compared)
+	SparseWaveformBase* m_wfm;
+
+	///@brief Index of the most recent lookup
+	size_t m_index;
+
+	///@brief Revision of the waveform as of the most recent lookup
+	uint64_t m_cachedRevision;
 };
 
 class UniformWaveformBase : public WaveformBase
 {
 public:
 	UniformWaveformBase()
+		: m_cachedPyramidRevision(0)
+		, m_pyramidValidLen(0)
 	{}
 
 	/**
@@ -239,10 +440,73 @@ public:
 	 */
 	UniformWaveformBase(const SparseWaveformBase& rhs)
 		: WaveformBase(rhs)
+		, m_cachedPyramidRevision(0)
+		, m_pyramidValidLen(0)
 	{}
 
 	virtual ~UniformWaveformBase()
 	{}
+
+	///@brief Decimation ratio between adjacent levels of the min/max pyramid
+	static const size_t PYRAMID_RATIO = 4;
+
+	/**
+		@brief One level of the optional min/max decimation pyramid
+
+		Level i holds the min and max over each block of PYRAMID_RATIO^(i+1) consecutive input samples.
+		Built and maintained by WaveformPyramid; validity is gated by the waveform revision counter.
+	 */
+	class PyramidLevel
+	{
+	public:
+		PyramidLevel()
+		{
+			m_min.SetCpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
+			m_min.SetGpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
+
+			m_max.SetCpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
+			m_max.SetGpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
+		}
+
+		///@brief Number of input samples per output sample at this level
+		size_t m_decimation;
+
+		///@brief Minimum of each block of m_decimation input samples
+		AcceleratorBuffer<float> m_min;
+
+		///@brief Maximum of each block of m_decimation input samples
+		AcceleratorBuffer<float> m_max;
+	};
+
+	/**
+		@brief Returns the coarsest pyramid level decimating by at most the requested ratio
+
+		Starting from this level, an overview at the requested ratio is O(output samples) work regardless of the
+		length of the full rate waveform. Returns null if the pyramid has not been built, is stale (check
+		m_cachedPyramidRevision against m_revision), or has no level that fine.
+	 */
+	PyramidLevel* GetPyramidLevel(size_t maxDecimation)
+	{
+		if(m_cachedPyramidRevision != m_revision)
+			return nullptr;
+
+		PyramidLevel* best = nullptr;
+		for(auto& p : m_pyramid)
+		{
+			if(p->m_decimation <= maxDecimation)
+				best = p.get();
+		}
+		return best;
+	}
+
+	///@brief Min/max decimation pyramid, finest level first (see WaveformPyramid)
+	std::vector<std::shared_ptr<PyramidLevel>> m_pyramid;
+
+	///@brief Revision the pyramid was last built against
+	uint64_t m_cachedPyramidRevision;
+
+	///@brief Base waveform length covered by the pyramid (lets appends rebuild only the new tail)
+	size_t m_pyramidValidLen;
 };
 
 /**
@@ -296,6 +560,9 @@ public:
 	virtual size_t size() const
 	{ return m_samples.size(); }
 
+	virtual size_t GetAllocatedBytes() const
+	{ return m_samples.GetCpuMemoryBytes() + m_samples.GetGpuMemoryBytes(); }
+
 	virtual void clear()
 	{ m_samples.clear(); }
 
@@ -305,6 +572,12 @@ public:
 	virtual void PrepareForGpuAccess()
 	{ m_samples.PrepareForGpuAccess(); }
 
+	virtual void PrepareForCpuAccessBatched(VulkanTransferBatch& batch)
+	{ m_samples.PrepareForCpuAccessBatched(batch); }
+
+	virtual void PrepareForGpuAccessBatched(VulkanTransferBatch& batch)
+	{ m_samples.PrepareForGpuAccessBatched(batch); }
+
 	virtual void MarkSamplesModifiedFromCpu()
 	{ m_samples.MarkModifiedFromCpu(); }
 
@@ -397,6 +670,11 @@ public:
 	virtual size_t size() const
 	{ return m_samples.size(); }
 
+	virtual size_t GetAllocatedBytes() const
+	{
+		return m_samples.GetCpuMemoryBytes() + m_samples.GetGpuMemoryBytes() + GetMetadataBytes();
+	}
+
 	virtual void clear()
 	{
 		m_offsets.clear();
@@ -418,6 +696,20 @@ public:
 		m_samples.PrepareForGpuAccess();
 	}
 
+	virtual void PrepareForCpuAccessBatched(VulkanTransferBatch& batch)
+	{
+		m_offsets.PrepareForCpuAccessBatched(batch);
+		m_durations.PrepareForCpuAccessBatched(batch);
+		m_samples.PrepareForCpuAccessBatched(batch);
+	}
+
+	virtual void PrepareForGpuAccessBatched(VulkanTransferBatch& batch)
+	{
+		m_offsets.PrepareForGpuAccessBatched(batch);
+		m_durations.PrepareForGpuAccessBatched(batch);
+		m_samples.PrepareForGpuAccessBatched(batch);
+	}
+
 	virtual void MarkSamplesModifiedFromCpu()
 	{ m_samples.MarkModifiedFromCpu(); }
 
@@ -438,6 +730,89 @@ typedef SparseWaveform<float>					SparseAnalogWaveform;
 typedef UniformWaveform<float>					UniformAnalogWaveform;
 typedef SparseWaveform< std::vector<bool> > 	SparseDigitalBusWaveform;
 
+/**
+	@brief An analog waveform stored as raw ADC codes plus gain/offset, with lazy float materialization
+
+	Most scope ADCs produce 8 or 16 bit codes, so keeping the native codes rather than float32 cuts memory and
+	PCIe traffic by 2-4x on long captures. The float view (m_samples) is materialized on demand: for GPU consumers
+	the codes are dequantized by a compute shader so the only host-to-device traffic is the code buffer, while CPU
+	consumers get a float conversion the first time PrepareForCpuAccess() is called after the codes change.
+
+	Producers should call Configure(), then Resize(), fill m_codes with packed little-endian codes, and finally
+	call MarkCodesModifiedFromCpu(). Conversion semantics match Oscilloscope::Convert8BitSamples():
+	volts = code*gain - offset.
+ */
+class QuantizedUniformAnalogWaveform : public UniformAnalogWaveform
+{
+public:
+
+	///@brief Storage format of the code buffer
+	enum CodeFormat
+	{
+		FORMAT_INT8,
+		FORMAT_UINT8,
+		FORMAT_INT16
+	};
+
+	QuantizedUniformAnalogWaveform(const std::string& name = "");
+	virtual ~QuantizedUniformAnalogWaveform();
+
+	void Configure(CodeFormat format, float gain, float offset);
+
+	virtual void Rename(const std::string& name = "") override;
+
+	virtual void Resize(size_t size) override;
+	virtual size_t size() const override;
+	virtual void clear() override;
+	virtual size_t GetAllocatedBytes() const override;
+
+	virtual void PrepareForCpuAccess() override;
+	virtual void PrepareForGpuAccess() override;
+	virtual void PrepareForCpuAccessBatched(VulkanTransferBatch& batch) override;
+	virtual void PrepareForGpuAccessBatched(VulkanTransferBatch& batch) override;
+
+	void MarkCodesModifiedFromCpu();
+
+	///@brief Raw ADC codes, packed little-endian (1 or 2 bytes per sample depending on the format)
+	AcceleratorBuffer<uint8_t> m_codes;
+
+	///@brief Returns the storage format of the code buffer
+	CodeFormat GetFormat() const
+	{ return m_format; }
+
+	///@brief Returns the multiplicative code-to-volts conversion factor
+	float GetGain() const
+	{ return m_gain; }
+
+	///@brief Returns the additive code-to-volts conversion factor
+	float GetOffset() const
+	{ return m_offset; }
+
+protected:
+
+	///@brief Returns the number of bytes each code occupies in m_codes
+	size_t GetBytesPerCode() const
+	{ return (m_format == FORMAT_INT16) ? 2 : 1; }
+
+	void MaterializeOnCpu();
+	void MaterializeOnGpu();
+
+	///@brief Storage format of m_codes
+	CodeFormat m_format;
+
+	///@brief Multiplicative conversion factor from code to volts
+	float m_gain;
+
+	///@brief Additive conversion factor (volts = code*gain - m_offset)
+	float m_offset;
+
+	///@brief True if m_samples currently reflects the contents of m_codes
+	bool m_floatSamplesValid;
+
+	///@brief Number of samples (m_samples is not resized until the float view is materialized)
+	size_t m_numSamples;
+};
+
 //Make sure inline helpers aren't warned about if unused
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wunused-function"
@@ -561,6 +936,53 @@ static T GetValue(const SparseWaveform<T>* sparse, const UniformWaveform<T>* uni
 		return uniform->m_samples[i];
 }
 
+/**
+	@brief Invokes a kernel functor with the concrete type of an analog waveform which may be sparse or uniform.
+
+	The kernel is a generic lambda (or functor with a templated operator()) taking a pointer to the concrete
+	waveform type. It is instantiated separately for SparseAnalogWaveform and UniformAnalogWaveform, so accessors
+	like GetValue() / GetOffsetScaled() in the body resolve to the compile-time overloads and tight per-sample
+	loops compile branch free, instead of paying the sparse-vs-uniform check on every access.
+
+	Typical use in a filter:
+
+		DispatchAnalogKernel(GetInputWaveform(0), [&](auto* wfm)
+		{
+			for(size_t i=0; i<wfm->size(); i++)
+				DoSomething(GetValue(wfm, i), GetOffsetScaled(wfm, i));
+		});
+
+	@return true if the kernel ran, false if the waveform is not analog (kernel not invoked)
+ */
+template<class F>
+bool DispatchAnalogKernel(WaveformBase* wfm, F kernel)
+{
+	if(auto uwfm = dynamic_cast<UniformAnalogWaveform*>(wfm))
+		kernel(uwfm);
+	else if(auto swfm = dynamic_cast<SparseAnalogWaveform*>(wfm))
+		kernel(swfm);
+	else
+		return false;
+	return true;
+}
+
+/**
+	@brief Digital equivalent of DispatchAnalogKernel(): runs the kernel with the concrete sparse or uniform type
+
+	@return true if the kernel ran, false if the waveform is not digital (kernel not invoked)
+ */
+template<class F>
+bool DispatchDigitalKernel(WaveformBase* wfm, F kernel)
+{
+	if(auto uwfm = dynamic_cast<UniformDigitalWaveform*>(wfm))
+		kernel(uwfm);
+	else if(auto swfm = dynamic_cast<SparseDigitalWaveform*>(wfm))
+		kernel(swfm);
+	else
+		return false;
+	return true;
+}
+
 //Template helper methods for validating that an input is the correct type
 static void AssertTypeIsSparseWaveform(const SparseWaveformBase* /*unused*/);
 static void AssertTypeIsUniformWaveform(const UniformWaveformBase* /*unused*/);
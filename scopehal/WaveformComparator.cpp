@@ -0,0 +1,292 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Implementation of WaveformComparator
+ */
+#include "scopehal.h"
+#include "WaveformComparator.h"
+
+#ifdef __x86_64__
+#include <immintrin.h>
+#endif
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Construction / destruction
+
+WaveformComparator::WaveformComparator()
+	: m_refLen(0)
+	, m_verifiedBlocks(0)
+	, m_firstMismatch(0)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Tolerance compare
+
+/**
+	@brief Compares two sample blocks with a per-sample tolerance
+
+	@return True if every |pa[i] - pb[i]| <= tolerance. On failure, firstMismatch is the index of the first
+			sample out of tolerance (a NaN in either input counts as a mismatch).
+ */
+bool WaveformComparator::CompareWithTolerance(
+	const float* pa, const float* pb, size_t count, float tolerance, size_t& firstMismatch)
+{
+	#ifdef __x86_64__
+	if(g_hasAvx2)
+		return CompareWithToleranceAVX2(pa, pb, count, tolerance, firstMismatch);
+	#endif
+	return CompareWithToleranceGeneric(pa, pb, count, tolerance, firstMismatch);
+}
+
+/**
+	@brief Convenience wrapper for comparing two uniform analog waveforms
+
+	A length mismatch fails the compare with firstMismatch at the end of the shorter waveform.
+ */
+bool WaveformComparator::CompareWithTolerance(
+	UniformAnalogWaveform* a, UniformAnalogWaveform* b, float tolerance, size_t& firstMismatch)
+{
+	if(a->size() != b->size())
+	{
+		firstMismatch = min(a->size(), b->size());
+		return false;
+	}
+
+	a->PrepareForCpuAccess();
+	b->PrepareForCpuAccess();
+	return CompareWithTolerance(
+		a->m_samples.GetCpuPointer(), b->m_samples.GetCpuPointer(), a->size(), tolerance, firstMismatch);
+}
+
+/**
+	@brief Generic backend for CompareWithTolerance()
+ */
+bool WaveformComparator::CompareWithToleranceGeneric(
+	const float* pa, const float* pb, size_t count, float tolerance, size_t& firstMismatch)
+{
+	for(size_t i=0; i<count; i++)
+	{
+		//Inverted comparison so a NaN difference fails
+		if(!(fabs(pa[i] - pb[i]) <= tolerance))
+		{
+			firstMismatch = i;
+			return false;
+		}
+	}
+	return true;
+}
+
+#ifdef __x86_64__
+/**
+	@brief AVX2 backend for CompareWithTolerance()
+
+	Compares eight samples at a time with an unordered (NaN = mismatch) predicate, then finds the exact failing
+	lane from the movemask only on the (rare) miss path.
+ */
+__attribute__((target("avx2")))
+bool WaveformComparator::CompareWithToleranceAVX2(
+	const float* pa, const float* pb, size_t count, float tolerance, size_t& firstMismatch)
+{
+	size_t end = count - (count % 8);
+	__m256 vtol = _mm256_set1_ps(tolerance);
+	__m256 vsign = _mm256_set1_ps(-0.0f);
+	for(size_t i=0; i<end; i += 8)
+	{
+		__m256 va = _mm256_loadu_ps(pa + i);
+		__m256 vb = _mm256_loadu_ps(pb + i);
+		__m256 vdiff = _mm256_andnot_ps(vsign, _mm256_sub_ps(va, vb));
+		int mask = _mm256_movemask_ps(_mm256_cmp_ps(vdiff, vtol, _CMP_NLE_UQ));
+		if(mask)
+		{
+			firstMismatch = i + __builtin_ctz(mask);
+			return false;
+		}
+	}
+
+	//Tail samples
+	for(size_t i=end; i<count; i++)
+	{
+		if(!(fabs(pa[i] - pb[i]) <= tolerance))
+		{
+			firstMismatch = i;
+			return false;
+		}
+	}
+	return true;
+}
+#endif
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Hash based exact compare
+
+/**
+	@brief Hashes one block of samples
+ */
+uint32_t WaveformComparator::HashBlock(const float* p, size_t count)
+{
+	return CRC32(reinterpret_cast<const uint8_t*>(p), 0, count*sizeof(float) - 1);
+}
+
+/**
+	@brief Snapshots block hashes of a golden waveform
+
+	The golden samples may be freed after this returns; only the hashes are kept.
+ */
+void WaveformComparator::SetReference(const float* pref, size_t count)
+{
+	m_refLen = count;
+	m_verifiedBlocks = 0;
+	m_firstMismatch = 0;
+
+	size_t nblocks = (count + BLOCK_SIZE - 1) / BLOCK_SIZE;
+	m_refHashes.resize(nblocks);
+
+	//Large references get hashed multithreaded (blocks are independent)
+	if(nblocks > 16)
+	{
+		#pragma omp parallel for
+		for(size_t i=0; i<nblocks; i++)
+		{
+			size_t off = i*BLOCK_SIZE;
+			m_refHashes[i] = HashBlock(pref + off, min((size_t)BLOCK_SIZE, count - off));
+		}
+	}
+	else
+	{
+		for(size_t i=0; i<nblocks; i++)
+		{
+			size_t off = i*BLOCK_SIZE;
+			m_refHashes[i] = HashBlock(pref + off, min((size_t)BLOCK_SIZE, count - off));
+		}
+	}
+}
+
+void WaveformComparator::SetReference(UniformAnalogWaveform* ref)
+{
+	ref->PrepareForCpuAccess();
+	SetReference(ref->m_samples.GetCpuPointer(), ref->size());
+}
+
+/**
+	@brief Verifies a capture against the reference from scratch
+
+	@return True if the first count samples match the reference exactly (see ReVerify() for partial captures)
+ */
+bool WaveformComparator::Verify(const float* ptest, size_t count)
+{
+	m_verifiedBlocks = 0;
+	return ReVerify(ptest, count);
+}
+
+bool WaveformComparator::Verify(UniformAnalogWaveform* test)
+{
+	test->PrepareForCpuAccess();
+	return Verify(test->m_samples.GetCpuPointer(), test->size());
+}
+
+/**
+	@brief Incrementally verifies a capture that has grown since the last call
+
+	Whole blocks that already matched on a previous Verify() / ReVerify() call are skipped, so a capture that
+	streams in across several triggers only pays for the newly appended samples. The caller must not modify
+	already verified data between calls (append only).
+
+	A trailing partial block can only be hash-checked once the capture has reached the full reference length;
+	until then those samples stay pending and get checked when their block fills. A capture longer than the
+	reference always fails.
+
+	@return True if every block checked so far matches the reference. Full equality additionally requires
+			count == GetReferenceLength().
+ */
+bool WaveformComparator::ReVerify(const float* ptest, size_t count)
+{
+	if(count > m_refLen)
+	{
+		m_firstMismatch = m_refLen;
+		return false;
+	}
+
+	size_t nWhole = count / BLOCK_SIZE;
+
+	//Check any whole blocks not yet verified
+	size_t firstBad = nWhole;
+	if( (nWhole - m_verifiedBlocks) > 16)
+	{
+		#pragma omp parallel for reduction(min:firstBad)
+		for(size_t i=m_verifiedBlocks; i<nWhole; i++)
+		{
+			if(HashBlock(ptest + i*BLOCK_SIZE, BLOCK_SIZE) != m_refHashes[i])
+				firstBad = min(firstBad, i);
+		}
+	}
+	else
+	{
+		for(size_t i=m_verifiedBlocks; i<nWhole; i++)
+		{
+			if(HashBlock(ptest + i*BLOCK_SIZE, BLOCK_SIZE) != m_refHashes[i])
+			{
+				firstBad = i;
+				break;
+			}
+		}
+	}
+
+	if(firstBad < nWhole)
+	{
+		m_verifiedBlocks = firstBad;
+		m_firstMismatch = firstBad * BLOCK_SIZE;
+		return false;
+	}
+	m_verifiedBlocks = nWhole;
+
+	//Partial tail block, only comparable once the capture has reached the reference length
+	size_t off = nWhole * BLOCK_SIZE;
+	if( (count == m_refLen) && (count > off) )
+	{
+		if(HashBlock(ptest + off, count - off) != m_refHashes[nWhole])
+		{
+			m_firstMismatch = off;
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool WaveformComparator::ReVerify(UniformAnalogWaveform* test)
+{
+	test->PrepareForCpuAccess();
+	return ReVerify(test->m_samples.GetCpuPointer(), test->size());
+}
@@ -0,0 +1,114 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Declaration of WaveformComparator
+ */
+#ifndef WaveformComparator_h
+#define WaveformComparator_h
+
+/**
+	@brief Fast comparison of captured waveforms against a golden reference
+
+	Intended for regression / production test fixtures that check every acquisition against a known-good capture,
+	where a naive per-sample loop is too slow to keep up with the trigger rate.
+
+	Two comparison modes are provided:
+
+	Exact: SetReference() snapshots CRC32 hashes of the golden waveform in BLOCK_SIZE sample blocks (the golden
+	itself need not be kept around afterward). Verify() re-hashes a test capture and compares block hashes;
+	ReVerify() additionally skips blocks that already matched on a previous call, so a capture that streams in
+	over several triggers only pays for the newly appended samples. On mismatch, GetFirstMismatch() returns the
+	start of the first differing block, narrow from there with a tolerance compare if sample resolution is needed.
+
+	Tolerance: CompareWithTolerance() checks |a - b| <= tolerance per sample (NaN anywhere counts as a mismatch)
+	with an AVX2 inner loop where available, early-outing with the index of the first failing sample.
+ */
+class WaveformComparator
+{
+public:
+	WaveformComparator();
+
+	///@brief Samples per hash block
+	static const size_t BLOCK_SIZE = 65536;
+
+	static bool CompareWithTolerance(
+		const float* pa, const float* pb, size_t count, float tolerance, size_t& firstMismatch);
+	static bool CompareWithTolerance(
+		UniformAnalogWaveform* a, UniformAnalogWaveform* b, float tolerance, size_t& firstMismatch);
+
+	void SetReference(const float* pref, size_t count);
+	void SetReference(UniformAnalogWaveform* ref);
+
+	bool Verify(const float* ptest, size_t count);
+	bool Verify(UniformAnalogWaveform* test);
+
+	bool ReVerify(const float* ptest, size_t count);
+	bool ReVerify(UniformAnalogWaveform* test);
+
+	///@brief Returns the length of the current reference, in samples
+	size_t GetReferenceLength() const
+	{ return m_refLen; }
+
+	/**
+		@brief Returns the index of the first known-mismatching sample from the last failed compare
+
+		For the hash based Verify() / ReVerify() path this is the start of the first mismatching block
+		(block granularity), not necessarily the exact sample.
+	 */
+	size_t GetFirstMismatch() const
+	{ return m_firstMismatch; }
+
+protected:
+	static uint32_t HashBlock(const float* p, size_t count);
+
+	static bool CompareWithToleranceGeneric(
+		const float* pa, const float* pb, size_t count, float tolerance, size_t& firstMismatch);
+
+#ifdef __x86_64__
+	static bool CompareWithToleranceAVX2(
+		const float* pa, const float* pb, size_t count, float tolerance, size_t& firstMismatch);
+#endif
+
+	///@brief Block hashes of the reference waveform (last entry may cover a partial block)
+	std::vector<uint32_t> m_refHashes;
+
+	///@brief Length of the reference waveform, in samples
+	size_t m_refLen;
+
+	///@brief Number of leading whole blocks of the capture already verified against the reference
+	size_t m_verifiedBlocks;
+
+	///@brief First mismatching sample (or block start) from the last failed compare
+	size_t m_firstMismatch;
+};
+
+#endif
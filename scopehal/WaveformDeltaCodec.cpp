@@ -0,0 +1,402 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief  Implementation of WaveformDeltaCodec
+ */
+#include "scopehal.h"
+
+#ifdef HAS_ZSTD
+#include <zstd.h>
+#endif
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Helpers
+
+namespace
+{
+	///@brief Returns the WaveformFile encoding of a waveform, or -1 if it's not a serializable type
+	int GetEncodingOf(WaveformBase* wfm)
+	{
+		if(dynamic_cast<UniformAnalogWaveform*>(wfm))
+			return WaveformFile::ENCODING_UNIFORM_ANALOG;
+		if(dynamic_cast<SparseAnalogWaveform*>(wfm))
+			return WaveformFile::ENCODING_SPARSE_ANALOG;
+		if(dynamic_cast<UniformDigitalWaveform*>(wfm))
+			return WaveformFile::ENCODING_UNIFORM_DIGITAL;
+		if(dynamic_cast<SparseDigitalWaveform*>(wfm))
+			return WaveformFile::ENCODING_SPARSE_DIGITAL;
+		return -1;
+	}
+
+#ifdef HAS_ZSTD
+
+	/**
+		@brief XORs two byte ranges into a third
+
+		Word-at-a-time so the compiler can vectorize it; the loop is memory bound either way, and the real
+		compression win comes from the entropy stage collapsing the zero runs this produces.
+	 */
+	void XorBytes(uint8_t* dst, const uint8_t* a, const uint8_t* b, size_t len)
+	{
+		size_t nwords = len / sizeof(uint64_t);
+		auto dw = reinterpret_cast<uint64_t*>(dst);
+		auto aw = reinterpret_cast<const uint64_t*>(a);
+		auto bw = reinterpret_cast<const uint64_t*>(b);
+		for(size_t i=0; i<nwords; i++)
+			dw[i] = aw[i] ^ bw[i];
+
+		for(size_t i = nwords * sizeof(uint64_t); i < len; i++)
+			dst[i] = a[i] ^ b[i];
+	}
+
+	///@brief Compresses one column's residual against the reference and appends it to the blob
+	template<class T>
+	bool EncodeColumn(
+		AcceleratorBuffer<T>& refbuf,
+		AcceleratorBuffer<T>& buf,
+		uint32_t type,
+		vector<uint8_t>& blob,
+		size_t& rawTotal)
+	{
+		if(refbuf.size() != buf.size())
+			return false;
+
+		size_t rawBytes = buf.size() * sizeof(T);
+		rawTotal += rawBytes;
+
+		WaveformDeltaCodec::DeltaColumn col;
+		col.m_type = type;
+		col.m_elementSize = sizeof(T);
+		col.m_rawBytes = rawBytes;
+
+		refbuf.PrepareForCpuAccess();
+		buf.PrepareForCpuAccess();
+
+		vector<uint8_t> residual(rawBytes);
+		XorBytes(
+			residual.data(),
+			reinterpret_cast<const uint8_t*>(buf.GetCpuPointer()),
+			reinterpret_cast<const uint8_t*>(refbuf.GetCpuPointer()),
+			rawBytes);
+
+		size_t base = blob.size();
+		blob.resize(base + sizeof(col) + ZSTD_compressBound(rawBytes));
+		size_t clen = ZSTD_compress(
+			blob.data() + base + sizeof(col),
+			blob.size() - base - sizeof(col),
+			residual.data(),
+			rawBytes,
+			ZSTD_CLEVEL_DEFAULT);
+		if(ZSTD_isError(clen))
+			return false;
+
+		col.m_compressedBytes = clen;
+		memcpy(blob.data() + base, &col, sizeof(col));
+		blob.resize(base + sizeof(col) + clen);
+		return true;
+	}
+
+	///@brief Decompresses one column's residual and XORs it with the reference to rebuild the original
+	template<class T>
+	bool DecodeColumn(
+		AcceleratorBuffer<T>& refbuf,
+		AcceleratorBuffer<T>& buf,
+		const WaveformDeltaCodec::DeltaColumn& col,
+		const vector<uint8_t>& blob,
+		size_t& cursor)
+	{
+		if(col.m_elementSize != sizeof(T))
+			return false;
+		size_t count = col.m_rawBytes / sizeof(T);
+		if(refbuf.size() != count)
+			return false;
+		if( (cursor + col.m_compressedBytes) > blob.size() )
+			return false;
+
+		buf.resize(count);
+		buf.PrepareForCpuAccess();
+		refbuf.PrepareForCpuAccess();
+
+		size_t dlen = ZSTD_decompress(
+			reinterpret_cast<uint8_t*>(buf.GetCpuPointer()),
+			col.m_rawBytes,
+			blob.data() + cursor,
+			col.m_compressedBytes);
+		if(ZSTD_isError(dlen) || (dlen != col.m_rawBytes) )
+			return false;
+		cursor += col.m_compressedBytes;
+
+		XorBytes(
+			reinterpret_cast<uint8_t*>(buf.GetCpuPointer()),
+			reinterpret_cast<const uint8_t*>(buf.GetCpuPointer()),
+			reinterpret_cast<const uint8_t*>(refbuf.GetCpuPointer()),
+			col.m_rawBytes);
+
+		buf.MarkModifiedFromCpu();
+		return true;
+	}
+
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Compatibility checks
+
+/**
+	@brief Checks if a waveform is a type the codec can encode at all (i.e. could serve as a reference frame)
+ */
+bool WaveformDeltaCodec::IsEncodable(WaveformBase* wfm)
+{
+	if(!wfm || (wfm->size() == 0) )
+		return false;
+
+	//Residuals are computed on the wide in-memory representation, so packed timestamps can't be encoded
+	auto sparse = dynamic_cast<SparseWaveformBase*>(wfm);
+	if(sparse && sparse->IsMetadataPacked())
+		return false;
+
+	return GetEncodingOf(wfm) >= 0;
+}
+
+/**
+	@brief Checks if a waveform can be delta encoded against the given reference frame
+
+	Requires the same concrete waveform type and the same sample count; everything else (timescale, trigger
+	phase, timestamps) is stored per blob and may differ freely.
+ */
+bool WaveformDeltaCodec::IsCompatible(WaveformBase* ref, WaveformBase* wfm)
+{
+	if(!IsEncodable(ref) || !IsEncodable(wfm))
+		return false;
+	if(ref->size() != wfm->size())
+		return false;
+	return GetEncodingOf(ref) == GetEncodingOf(wfm);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Encoding
+
+/**
+	@brief Delta encodes a waveform against a reference frame
+
+	On success the blob fully describes the waveform given the same reference; the original can be freed.
+	Fails (leaving the blob empty) if the waveforms aren't compatible, if compression doesn't at least halve
+	the raw size, or if the library was built without zstd support.
+
+	@return true on success
+ */
+bool WaveformDeltaCodec::Encode(WaveformBase* ref, WaveformBase* wfm, vector<uint8_t>& blob)
+{
+	blob.clear();
+
+#ifndef HAS_ZSTD
+	(void)ref;
+	(void)wfm;
+	return false;
+#else
+
+	if(!IsCompatible(ref, wfm))
+		return false;
+
+	auto rua = dynamic_cast<UniformAnalogWaveform*>(ref);
+	auto rsa = dynamic_cast<SparseAnalogWaveform*>(ref);
+	auto rud = dynamic_cast<UniformDigitalWaveform*>(ref);
+	auto rsd = dynamic_cast<SparseDigitalWaveform*>(ref);
+
+	auto ua = dynamic_cast<UniformAnalogWaveform*>(wfm);
+	auto sa = dynamic_cast<SparseAnalogWaveform*>(wfm);
+	auto ud = dynamic_cast<UniformDigitalWaveform*>(wfm);
+	auto sd = dynamic_cast<SparseDigitalWaveform*>(wfm);
+
+	DeltaHeader header;
+	memset(&header, 0, sizeof(header));
+	header.m_encoding = GetEncodingOf(wfm);
+	header.m_numColumns = (sa || sd) ? 3 : 1;
+	header.m_numSamples = wfm->size();
+	header.m_timescale = wfm->m_timescale;
+	header.m_triggerPhase = wfm->m_triggerPhase;
+	header.m_startTimestamp = wfm->m_startTimestamp;
+	header.m_startFemtoseconds = wfm->m_startFemtoseconds;
+
+	blob.resize(sizeof(header));
+	memcpy(blob.data(), &header, sizeof(header));
+
+	size_t rawTotal = 0;
+	bool ok = true;
+	if(ua)
+		ok = EncodeColumn(rua->m_samples, ua->m_samples, WaveformFile::COLUMN_SAMPLES, blob, rawTotal);
+	else if(ud)
+		ok = EncodeColumn(rud->m_samples, ud->m_samples, WaveformFile::COLUMN_SAMPLES, blob, rawTotal);
+	else if(sa)
+	{
+		ok = EncodeColumn(rsa->m_samples, sa->m_samples, WaveformFile::COLUMN_SAMPLES, blob, rawTotal) &&
+			EncodeColumn(rsa->m_offsets, sa->m_offsets, WaveformFile::COLUMN_OFFSETS, blob, rawTotal) &&
+			EncodeColumn(rsa->m_durations, sa->m_durations, WaveformFile::COLUMN_DURATIONS, blob, rawTotal);
+	}
+	else if(sd)
+	{
+		ok = EncodeColumn(rsd->m_samples, sd->m_samples, WaveformFile::COLUMN_SAMPLES, blob, rawTotal) &&
+			EncodeColumn(rsd->m_offsets, sd->m_offsets, WaveformFile::COLUMN_OFFSETS, blob, rawTotal) &&
+			EncodeColumn(rsd->m_durations, sd->m_durations, WaveformFile::COLUMN_DURATIONS, blob, rawTotal);
+	}
+
+	//Not worth storing as a delta if the residual doesn't compress well (signal isn't actually repetitive);
+	//let the caller fall back to its normal storage path
+	if(!ok || (blob.size() * 2 >= rawTotal) )
+	{
+		blob.clear();
+		return false;
+	}
+
+	return true;
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Decoding
+
+/**
+	@brief Reconstructs a waveform from a blob and the reference frame it was encoded against
+
+	@return the waveform (caller owns it), or nullptr on failure
+ */
+WaveformBase* WaveformDeltaCodec::Decode(WaveformBase* ref, const vector<uint8_t>& blob)
+{
+#ifndef HAS_ZSTD
+	(void)ref;
+	(void)blob;
+	return nullptr;
+#else
+
+	if(!ref || (blob.size() < sizeof(DeltaHeader)) )
+		return nullptr;
+
+	DeltaHeader header;
+	memcpy(&header, blob.data(), sizeof(header));
+
+	//The reference must still be the same shape the blob was encoded against
+	if( (static_cast<int>(header.m_encoding) != GetEncodingOf(ref)) || (ref->size() != header.m_numSamples) )
+		return nullptr;
+
+	auto rua = dynamic_cast<UniformAnalogWaveform*>(ref);
+	auto rsa = dynamic_cast<SparseAnalogWaveform*>(ref);
+	auto rud = dynamic_cast<UniformDigitalWaveform*>(ref);
+	auto rsd = dynamic_cast<SparseDigitalWaveform*>(ref);
+
+	WaveformBase* wfm = nullptr;
+	UniformAnalogWaveform* ua = nullptr;
+	SparseAnalogWaveform* sa = nullptr;
+	UniformDigitalWaveform* ud = nullptr;
+	SparseDigitalWaveform* sd = nullptr;
+	switch(header.m_encoding)
+	{
+		case WaveformFile::ENCODING_UNIFORM_ANALOG:
+			wfm = ua = new UniformAnalogWaveform;
+			break;
+		case WaveformFile::ENCODING_SPARSE_ANALOG:
+			wfm = sa = new SparseAnalogWaveform;
+			break;
+		case WaveformFile::ENCODING_UNIFORM_DIGITAL:
+			wfm = ud = new UniformDigitalWaveform;
+			break;
+		case WaveformFile::ENCODING_SPARSE_DIGITAL:
+			wfm = sd = new SparseDigitalWaveform;
+			break;
+		default:
+			return nullptr;
+	}
+	wfm->m_timescale = header.m_timescale;
+	wfm->m_triggerPhase = header.m_triggerPhase;
+	wfm->m_startTimestamp = header.m_startTimestamp;
+	wfm->m_startFemtoseconds = header.m_startFemtoseconds;
+
+	size_t cursor = sizeof(header);
+	bool ok = true;
+	for(uint32_t i=0; (i < header.m_numColumns) && ok; i++)
+	{
+		if( (cursor + sizeof(DeltaColumn)) > blob.size() )
+		{
+			ok = false;
+			break;
+		}
+
+		DeltaColumn col;
+		memcpy(&col, blob.data() + cursor, sizeof(col));
+		cursor += sizeof(col);
+
+		switch(col.m_type)
+		{
+			case WaveformFile::COLUMN_SAMPLES:
+				if(ua)
+					ok = DecodeColumn(rua->m_samples, ua->m_samples, col, blob, cursor);
+				else if(sa)
+					ok = DecodeColumn(rsa->m_samples, sa->m_samples, col, blob, cursor);
+				else if(ud)
+					ok = DecodeColumn(rud->m_samples, ud->m_samples, col, blob, cursor);
+				else
+					ok = DecodeColumn(rsd->m_samples, sd->m_samples, col, blob, cursor);
+				break;
+
+			case WaveformFile::COLUMN_OFFSETS:
+				if(sa)
+					ok = DecodeColumn(rsa->m_offsets, sa->m_offsets, col, blob, cursor);
+				else if(sd)
+					ok = DecodeColumn(rsd->m_offsets, sd->m_offsets, col, blob, cursor);
+				else
+					ok = false;
+				break;
+
+			case WaveformFile::COLUMN_DURATIONS:
+				if(sa)
+					ok = DecodeColumn(rsa->m_durations, sa->m_durations, col, blob, cursor);
+				else if(sd)
+					ok = DecodeColumn(rsd->m_durations, sd->m_durations, col, blob, cursor);
+				else
+					ok = false;
+				break;
+
+			default:
+				ok = false;
+				break;
+		}
+	}
+
+	if(!ok)
+	{
+		delete wfm;
+		return nullptr;
+	}
+	return wfm;
+#endif
+}
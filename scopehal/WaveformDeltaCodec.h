@@ -0,0 +1,107 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Declaration of WaveformDeltaCodec
+ */
+#ifndef WaveformDeltaCodec_h
+#define WaveformDeltaCodec_h
+
+#include "Waveform.h"
+
+/**
+	@brief Delta encoder for near-identical waveforms, used by WaveformHistory
+
+	Consecutive triggers of a repetitive stimulus produce waveforms that differ only in noise and in the few
+	samples that actually changed. Encode() XORs a waveform's sample data against a reference frame of the
+	same shape and runs the residual through zstd; identical regions XOR to runs of zeroes that the entropy
+	stage collapses almost entirely, so a history of repetitive captures stores one reference frame plus a
+	small residual per trigger. Decode() reverses the process exactly - the round trip is bit exact, including
+	NaNs and denormals, since the residual is computed on raw bytes rather than arithmetic differences.
+
+	Only waveform types WaveformFile can serialize are encodable, and sparse waveforms must have their
+	timestamp metadata unpacked on both sides. Encode() fails (returns false) rather than producing a blob
+	bigger than half the raw data, so a non-repetitive signal just falls back to whatever storage the caller
+	would have used anyway. Without zstd support there is no entropy stage worth having, so Encode() always
+	fails and history storage degrades gracefully to plain spilling.
+ */
+class WaveformDeltaCodec
+{
+public:
+	///@brief Fixed header at the start of an encoded blob
+	struct DeltaHeader
+	{
+		///@brief A WaveformFile::WaveformEncoding value
+		uint32_t	m_encoding;
+
+		///@brief Number of DeltaColumn descriptors following this header
+		uint32_t	m_numColumns;
+
+		///@brief Number of samples in the waveform
+		uint64_t	m_numSamples;
+
+		///@brief WaveformBase::m_timescale
+		int64_t		m_timescale;
+
+		///@brief WaveformBase::m_triggerPhase
+		int64_t		m_triggerPhase;
+
+		///@brief WaveformBase::m_startTimestamp
+		int64_t		m_startTimestamp;
+
+		///@brief WaveformBase::m_startFemtoseconds
+		int64_t		m_startFemtoseconds;
+	};
+
+	///@brief Descriptor for one compressed residual, followed immediately by its payload
+	struct DeltaColumn
+	{
+		///@brief A WaveformFile::ColumnType value
+		uint32_t	m_type;
+
+		///@brief Size of one element of the column, in bytes
+		uint32_t	m_elementSize;
+
+		///@brief Size of the residual before compression (equals the raw column size), in bytes
+		uint64_t	m_rawBytes;
+
+		///@brief Size of the compressed payload, in bytes
+		uint64_t	m_compressedBytes;
+	};
+
+	static bool IsEncodable(WaveformBase* wfm);
+	static bool IsCompatible(WaveformBase* ref, WaveformBase* wfm);
+
+	static bool Encode(WaveformBase* ref, WaveformBase* wfm, std::vector<uint8_t>& blob);
+	static WaveformBase* Decode(WaveformBase* ref, const std::vector<uint8_t>& blob);
+};
+
+#endif
@@ -0,0 +1,902 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief  Implementation of WaveformFile
+ */
+#include "scopehal.h"
+
+#ifdef HAS_ZSTD
+#include <zstd.h>
+#endif
+
+using namespace std;
+
+///@brief Magic number at the start of a waveform file
+static const uint8_t g_waveformFileMagic[8] = { 's', 'c', 'o', 'p', 'e', 'c', 'w', 'f' };
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Helpers
+
+namespace
+{
+	///@brief Rounds a file offset up to the next payload alignment boundary
+	uint64_t AlignOffset(uint64_t offset)
+	{ return (offset + WaveformFile::PAYLOAD_ALIGNMENT - 1) & ~(WaveformFile::PAYLOAD_ALIGNMENT - 1); }
+
+	///@brief Writes one column payload at its assigned offset
+	template<class T>
+	bool SaveColumn(FILE* fp, const WaveformFile::ColumnHeader& col, AcceleratorBuffer<T>& buf)
+	{
+		if(col.m_byteLength == 0)
+			return true;
+
+		buf.PrepareForCpuAccess();
+
+		if(0 != fseek(fp, col.m_fileOffset, SEEK_SET))
+			return false;
+		return buf.size() == fwrite(buf.GetCpuPointer(), sizeof(T), buf.size(), fp);
+	}
+
+	/**
+		@brief Loads one column payload into a buffer
+
+		Tries to map the pages copy-on-write first; falls back to a copying read if that's not possible
+		(Windows, or a file that can't be mapped for whatever reason).
+	 */
+	template<class T>
+	bool LoadColumn(FILE* fp, const WaveformFile::ColumnHeader& col, AcceleratorBuffer<T>& buf)
+	{
+		if(col.m_elementSize != sizeof(T))
+		{
+			LogError("Waveform file column has element size %u, expected %zu\n",
+				col.m_elementSize, sizeof(T));
+			return false;
+		}
+		size_t count = col.m_byteLength / sizeof(T);
+
+		if(buf.AdoptFileMapping(fileno(fp), col.m_fileOffset, count))
+			return true;
+
+		buf.resize(count);
+		if(count == 0)
+			return true;
+		buf.PrepareForCpuAccess();
+		if(0 != fseek(fp, col.m_fileOffset, SEEK_SET))
+			return false;
+		if(count != fread(buf.GetCpuPointer(), sizeof(T), count, fp))
+			return false;
+		buf.MarkModifiedFromCpu();
+		return true;
+	}
+
+	///@brief Loads the frame index of a compressed column payload
+	bool ReadFrameIndex(FILE* fp, const WaveformFile::ColumnHeader& col, vector<WaveformFile::FrameHeader>& frames)
+	{
+		if(0 != fseek(fp, col.m_fileOffset, SEEK_SET))
+			return false;
+
+		uint64_t numFrames;
+		if(1 != fread(&numFrames, sizeof(numFrames), 1, fp))
+			return false;
+
+		//Sanity limit: a frame holds at least one element
+		if(numFrames > (col.m_byteLength / max<uint32_t>(col.m_elementSize, 1) + 1))
+			return false;
+
+		frames.resize(numFrames);
+		if(numFrames != fread(&frames[0], sizeof(WaveformFile::FrameHeader), numFrames, fp))
+			return false;
+		return true;
+	}
+
+#ifdef HAS_ZSTD
+
+	/**
+		@brief Writes one column payload as a frame index plus independently decompressible zstd frames
+
+		On entry, offset points to the first free byte in the file; on successful return it's been advanced
+		past this payload. The column header's file offset and (uncompressed) byte length are filled in.
+	 */
+	bool SaveColumnZstdRaw(
+		FILE* fp,
+		WaveformFile::ColumnHeader& col,
+		const uint8_t* data,
+		size_t elemSize,
+		size_t numElements,
+		uint64_t& offset)
+	{
+		col.m_fileOffset = AlignOffset(offset);
+		col.m_byteLength = numElements * elemSize;
+
+		size_t elemsPerFrame = max<size_t>(1, WaveformFile::ZSTD_FRAME_TARGET_BYTES / elemSize);
+		uint64_t numFrames = (numElements + elemsPerFrame - 1) / elemsPerFrame;
+
+		//Frames start right after the index
+		uint64_t frameOffset = col.m_fileOffset + sizeof(uint64_t) + numFrames*sizeof(WaveformFile::FrameHeader);
+
+		vector<WaveformFile::FrameHeader> frames;
+		vector<uint8_t> cbuf(ZSTD_compressBound(elemsPerFrame * elemSize));
+		if(0 != fseek(fp, frameOffset, SEEK_SET))
+			return false;
+		for(uint64_t i=0; i<numFrames; i++)
+		{
+			WaveformFile::FrameHeader fh;
+			memset(&fh, 0, sizeof(fh));
+			fh.m_firstElement = i * elemsPerFrame;
+			fh.m_numElements = min<uint64_t>(elemsPerFrame, numElements - fh.m_firstElement);
+			fh.m_fileOffset = frameOffset;
+			if( (col.m_type == WaveformFile::COLUMN_OFFSETS) && (elemSize == sizeof(int64_t)) )
+				memcpy(&fh.m_firstOffset, data + fh.m_firstElement*elemSize, sizeof(int64_t));
+
+			size_t clen = ZSTD_compress(
+				cbuf.data(),
+				cbuf.size(),
+				data + fh.m_firstElement*elemSize,
+				fh.m_numElements*elemSize,
+				ZSTD_CLEVEL_DEFAULT);
+			if(ZSTD_isError(clen))
+				return false;
+			fh.m_compressedLength = clen;
+
+			if(clen != fwrite(cbuf.data(), 1, clen, fp))
+				return false;
+			frames.push_back(fh);
+			frameOffset += clen;
+		}
+
+		//Now that all the compressed lengths are known, go back and write the index
+		if(0 != fseek(fp, col.m_fileOffset, SEEK_SET))
+			return false;
+		bool ok = (1 == fwrite(&numFrames, sizeof(numFrames), 1, fp));
+		if(numFrames)
+			ok &= (numFrames == fwrite(&frames[0], sizeof(WaveformFile::FrameHeader), numFrames, fp));
+
+		offset = frameOffset;
+		return ok;
+	}
+
+	///@brief Type safe wrapper around SaveColumnZstdRaw
+	template<class T>
+	bool SaveColumnZstd(FILE* fp, WaveformFile::ColumnHeader& col, AcceleratorBuffer<T>& buf, uint64_t& offset)
+	{
+		buf.PrepareForCpuAccess();
+		return SaveColumnZstdRaw(fp, col, (const uint8_t*)buf.GetCpuPointer(), sizeof(T), buf.size(), offset);
+	}
+
+	///@brief Loads one compressed column payload in full, decompressing every frame
+	template<class T>
+	bool LoadColumnZstd(FILE* fp, const WaveformFile::ColumnHeader& col, AcceleratorBuffer<T>& buf)
+	{
+		if(col.m_elementSize != sizeof(T))
+		{
+			LogError("Waveform file column has element size %u, expected %zu\n",
+				col.m_elementSize, sizeof(T));
+			return false;
+		}
+		size_t count = col.m_byteLength / sizeof(T);
+
+		buf.resize(count);
+		if(count == 0)
+			return true;
+		buf.PrepareForCpuAccess();
+
+		vector<WaveformFile::FrameHeader> frames;
+		if(!ReadFrameIndex(fp, col, frames))
+			return false;
+
+		auto base = (uint8_t*)buf.GetCpuPointer();
+		vector<uint8_t> cbuf;
+		for(auto& fh : frames)
+		{
+			if( (fh.m_firstElement + fh.m_numElements) > count)
+				return false;
+
+			cbuf.resize(fh.m_compressedLength);
+			if(0 != fseek(fp, fh.m_fileOffset, SEEK_SET))
+				return false;
+			if(fh.m_compressedLength != fread(cbuf.data(), 1, fh.m_compressedLength, fp))
+				return false;
+
+			size_t dlen = ZSTD_decompress(
+				base + fh.m_firstElement*sizeof(T),
+				fh.m_numElements*sizeof(T),
+				cbuf.data(),
+				fh.m_compressedLength);
+			if(ZSTD_isError(dlen) || (dlen != fh.m_numElements*sizeof(T)) )
+				return false;
+		}
+
+		buf.MarkModifiedFromCpu();
+		return true;
+	}
+
+#else
+
+	///@brief Stub for builds without zstd support; never reached, since compressed files are rejected at open
+	template<class T>
+	bool LoadColumnZstd(FILE* /*fp*/, const WaveformFile::ColumnHeader& /*col*/, AcceleratorBuffer<T>& /*buf*/)
+	{ return false; }
+
+#endif
+
+	/**
+		@brief Loads a contiguous element range of a column payload into a buffer
+
+		For compressed payloads, only the frames overlapping the range are decompressed.
+	 */
+	template<class T>
+	bool LoadColumnRange(
+		FILE* fp,
+		const WaveformFile::ColumnHeader& col,
+		uint32_t compression,
+		size_t firstElement,
+		size_t numElements,
+		AcceleratorBuffer<T>& buf)
+	{
+		if(col.m_elementSize != sizeof(T))
+		{
+			LogError("Waveform file column has element size %u, expected %zu\n",
+				col.m_elementSize, sizeof(T));
+			return false;
+		}
+
+		buf.resize(numElements);
+		if(numElements == 0)
+			return true;
+		buf.PrepareForCpuAccess();
+
+		if(compression == WaveformFile::COMPRESSION_NONE)
+		{
+			if(0 != fseek(fp, col.m_fileOffset + firstElement*sizeof(T), SEEK_SET))
+				return false;
+			if(numElements != fread(buf.GetCpuPointer(), sizeof(T), numElements, fp))
+				return false;
+		}
+
+	#ifdef HAS_ZSTD
+		else
+		{
+			vector<WaveformFile::FrameHeader> frames;
+			if(!ReadFrameIndex(fp, col, frames))
+				return false;
+
+			auto base = (uint8_t*)buf.GetCpuPointer();
+			vector<uint8_t> cbuf;
+			vector<uint8_t> dbuf;
+			for(auto& fh : frames)
+			{
+				//Skip frames entirely outside the requested range
+				if( (fh.m_firstElement + fh.m_numElements) <= firstElement)
+					continue;
+				if(fh.m_firstElement >= (firstElement + numElements) )
+					break;
+
+				cbuf.resize(fh.m_compressedLength);
+				if(0 != fseek(fp, fh.m_fileOffset, SEEK_SET))
+					return false;
+				if(fh.m_compressedLength != fread(cbuf.data(), 1, fh.m_compressedLength, fp))
+					return false;
+
+				dbuf.resize(fh.m_numElements * sizeof(T));
+				size_t dlen = ZSTD_decompress(dbuf.data(), dbuf.size(), cbuf.data(), fh.m_compressedLength);
+				if(ZSTD_isError(dlen) || (dlen != dbuf.size()) )
+					return false;
+
+				//Copy the overlapping slice of the frame into place
+				size_t copyFirst = max<size_t>(fh.m_firstElement, firstElement);
+				size_t copyEnd = min<size_t>(fh.m_firstElement + fh.m_numElements, firstElement + numElements);
+				memcpy(
+					base + (copyFirst - firstElement)*sizeof(T),
+					dbuf.data() + (copyFirst - fh.m_firstElement)*sizeof(T),
+					(copyEnd - copyFirst)*sizeof(T));
+			}
+		}
+	#else
+		else
+			return false;
+	#endif
+
+		buf.MarkModifiedFromCpu();
+		return true;
+	}
+
+	///@brief Reads a single element of an (uncompressed) int64 column, for binary searching the offsets column
+	bool ReadOffsetAt(FILE* fp, const WaveformFile::ColumnHeader& col, size_t i, int64_t& value)
+	{
+		if(0 != fseek(fp, col.m_fileOffset + i*sizeof(int64_t), SEEK_SET))
+			return false;
+		return (1 == fread(&value, sizeof(value), 1, fp));
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Header parsing (shared by the full and time-range load paths)
+
+/**
+	@brief Opens a waveform file and reads/validates its header and column descriptors
+
+	@return the open file handle, or nullptr on failure
+ */
+static FILE* OpenWaveformFile(
+	const string& path,
+	WaveformFile::FileHeader& header,
+	vector<WaveformFile::ColumnHeader>& columns)
+{
+	FILE* fp = fopen(path.c_str(), "rb");
+	if(!fp)
+	{
+		LogError("Couldn't open waveform file \"%s\"\n", path.c_str());
+		return nullptr;
+	}
+
+	//Read and validate the header
+	if(1 != fread(&header, sizeof(header), 1, fp))
+	{
+		LogError("Couldn't read header of waveform file \"%s\"\n", path.c_str());
+		fclose(fp);
+		return nullptr;
+	}
+	if(0 != memcmp(header.m_magic, g_waveformFileMagic, sizeof(header.m_magic)))
+	{
+		LogError("\"%s\" is not a waveform file (bad magic number)\n", path.c_str());
+		fclose(fp);
+		return nullptr;
+	}
+	if(header.m_version != WaveformFile::FILE_VERSION)
+	{
+		LogError("Waveform file \"%s\" has unsupported version %u\n", path.c_str(), header.m_version);
+		fclose(fp);
+		return nullptr;
+	}
+	if(header.m_compression == WaveformFile::COMPRESSION_ZSTD)
+	{
+	#ifndef HAS_ZSTD
+		LogError("Waveform file \"%s\" is zstd compressed, but we were not built with zstd support\n",
+			path.c_str());
+		fclose(fp);
+		return nullptr;
+	#endif
+	}
+	else if(header.m_compression != WaveformFile::COMPRESSION_NONE)
+	{
+		LogError("Waveform file \"%s\" uses unsupported compression type %u\n",
+			path.c_str(), header.m_compression);
+		fclose(fp);
+		return nullptr;
+	}
+
+	//Read the column descriptors
+	columns.resize(header.m_numColumns);
+	if(header.m_numColumns != fread(&columns[0], sizeof(WaveformFile::ColumnHeader), header.m_numColumns, fp))
+	{
+		LogError("Couldn't read column headers of waveform file \"%s\"\n", path.c_str());
+		fclose(fp);
+		return nullptr;
+	}
+
+	return fp;
+}
+
+///@brief Creates the right type of waveform for a file's encoding and copies the header metadata over
+static WaveformBase* MakeWaveformForHeader(
+	const WaveformFile::FileHeader& header,
+	UniformAnalogWaveform*& ua,
+	SparseAnalogWaveform*& sa,
+	UniformDigitalWaveform*& ud,
+	SparseDigitalWaveform*& sd)
+{
+	ua = nullptr;
+	sa = nullptr;
+	ud = nullptr;
+	sd = nullptr;
+	WaveformBase* wfm;
+	switch(header.m_encoding)
+	{
+		case WaveformFile::ENCODING_UNIFORM_ANALOG:
+			wfm = ua = new UniformAnalogWaveform;
+			break;
+		case WaveformFile::ENCODING_SPARSE_ANALOG:
+			wfm = sa = new SparseAnalogWaveform;
+			break;
+		case WaveformFile::ENCODING_UNIFORM_DIGITAL:
+			wfm = ud = new UniformDigitalWaveform;
+			break;
+		case WaveformFile::ENCODING_SPARSE_DIGITAL:
+			wfm = sd = new SparseDigitalWaveform;
+			break;
+		default:
+			return nullptr;
+	}
+	wfm->m_timescale = header.m_timescale;
+	wfm->m_triggerPhase = header.m_triggerPhase;
+	wfm->m_startTimestamp = header.m_startTimestamp;
+	wfm->m_startFemtoseconds = header.m_startFemtoseconds;
+	return wfm;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Saving
+
+/**
+	@brief Saves a waveform to a file, overwriting any existing content
+
+	Pass COMPRESSION_ZSTD for archival storage: payloads typically shrink 3-5x and time ranges can still be
+	loaded without decompressing the whole capture. If the library was built without zstd support, falls back
+	to an uncompressed save with a warning.
+
+	@return true on success
+ */
+bool WaveformFile::Save(const string& path, WaveformBase* wfm, CompressionType compression)
+{
+#ifndef HAS_ZSTD
+	if(compression == COMPRESSION_ZSTD)
+	{
+		LogWarning("WaveformFile::Save: not built with zstd support, saving \"%s\" uncompressed\n", path.c_str());
+		compression = COMPRESSION_NONE;
+	}
+#endif
+
+	auto ua = dynamic_cast<UniformAnalogWaveform*>(wfm);
+	auto sa = dynamic_cast<SparseAnalogWaveform*>(wfm);
+	auto ud = dynamic_cast<UniformDigitalWaveform*>(wfm);
+	auto sd = dynamic_cast<SparseDigitalWaveform*>(wfm);
+
+	FileHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.m_magic, g_waveformFileMagic, sizeof(header.m_magic));
+	header.m_version = FILE_VERSION;
+	header.m_numSamples = wfm->size();
+	header.m_timescale = wfm->m_timescale;
+	header.m_triggerPhase = wfm->m_triggerPhase;
+	header.m_startTimestamp = wfm->m_startTimestamp;
+	header.m_startFemtoseconds = wfm->m_startFemtoseconds;
+	header.m_compression = compression;
+
+	//Figure out the column layout for this type of waveform
+	vector<ColumnHeader> columns;
+	ColumnHeader col;
+	memset(&col, 0, sizeof(col));
+	col.m_type = COLUMN_SAMPLES;
+	if(ua)
+	{
+		header.m_encoding = ENCODING_UNIFORM_ANALOG;
+		col.m_elementSize = sizeof(float);
+	}
+	else if(sa)
+	{
+		header.m_encoding = ENCODING_SPARSE_ANALOG;
+		col.m_elementSize = sizeof(float);
+	}
+	else if(ud)
+	{
+		header.m_encoding = ENCODING_UNIFORM_DIGITAL;
+		col.m_elementSize = sizeof(bool);
+	}
+	else if(sd)
+	{
+		header.m_encoding = ENCODING_SPARSE_DIGITAL;
+		col.m_elementSize = sizeof(bool);
+	}
+	else
+	{
+		LogError("WaveformFile::Save: unsupported waveform type\n");
+		return false;
+	}
+	columns.push_back(col);
+
+	//Sparse waveforms also store the timebase columns
+	if(sa || sd)
+	{
+		col.m_type = COLUMN_OFFSETS;
+		col.m_elementSize = sizeof(int64_t);
+		columns.push_back(col);
+
+		col.m_type = COLUMN_DURATIONS;
+		columns.push_back(col);
+	}
+	header.m_numColumns = columns.size();
+
+	uint64_t offset = sizeof(FileHeader) + columns.size()*sizeof(ColumnHeader);
+
+	//Uncompressed payload offsets are known up front; compressed ones aren't until after compression,
+	//so in that case the headers written here are placeholders that get rewritten at the end
+	if(compression == COMPRESSION_NONE)
+	{
+		for(auto& c : columns)
+		{
+			c.m_byteLength = header.m_numSamples * c.m_elementSize;
+			c.m_fileOffset = AlignOffset(offset);
+			offset = c.m_fileOffset + c.m_byteLength;
+		}
+	}
+
+	FILE* fp = fopen(path.c_str(), "wb");
+	if(!fp)
+	{
+		LogError("Couldn't open waveform file \"%s\" for writing\n", path.c_str());
+		return false;
+	}
+
+	//Write the headers
+	bool ok = (1 == fwrite(&header, sizeof(header), 1, fp));
+	for(auto& c : columns)
+		ok &= (1 == fwrite(&c, sizeof(c), 1, fp));
+
+	//Write the payloads (the gap up to each aligned offset is left sparse)
+	for(auto& c : columns)
+	{
+		if(compression == COMPRESSION_NONE)
+		{
+			switch(c.m_type)
+			{
+				case COLUMN_SAMPLES:
+					if(ua)
+						ok &= SaveColumn(fp, c, ua->m_samples);
+					else if(sa)
+						ok &= SaveColumn(fp, c, sa->m_samples);
+					else if(ud)
+						ok &= SaveColumn(fp, c, ud->m_samples);
+					else
+						ok &= SaveColumn(fp, c, sd->m_samples);
+					break;
+
+				case COLUMN_OFFSETS:
+					ok &= SaveColumn(fp, c, sa ? sa->m_offsets : sd->m_offsets);
+					break;
+
+				case COLUMN_DURATIONS:
+					ok &= SaveColumn(fp, c, sa ? sa->m_durations : sd->m_durations);
+					break;
+
+				default:
+					break;
+			}
+		}
+
+	#ifdef HAS_ZSTD
+		else
+		{
+			switch(c.m_type)
+			{
+				case COLUMN_SAMPLES:
+					if(ua)
+						ok &= SaveColumnZstd(fp, c, ua->m_samples, offset);
+					else if(sa)
+						ok &= SaveColumnZstd(fp, c, sa->m_samples, offset);
+					else if(ud)
+						ok &= SaveColumnZstd(fp, c, ud->m_samples, offset);
+					else
+						ok &= SaveColumnZstd(fp, c, sd->m_samples, offset);
+					break;
+
+				case COLUMN_OFFSETS:
+					ok &= SaveColumnZstd(fp, c, sa ? sa->m_offsets : sd->m_offsets, offset);
+					break;
+
+				case COLUMN_DURATIONS:
+					ok &= SaveColumnZstd(fp, c, sa ? sa->m_durations : sd->m_durations, offset);
+					break;
+
+				default:
+					break;
+			}
+		}
+	#endif
+	}
+
+	//Rewrite the headers now that the compressed payload locations are known
+	if(ok && (compression != COMPRESSION_NONE) )
+	{
+		ok &= (0 == fseek(fp, 0, SEEK_SET));
+		ok &= (1 == fwrite(&header, sizeof(header), 1, fp));
+		for(auto& c : columns)
+			ok &= (1 == fwrite(&c, sizeof(c), 1, fp));
+	}
+
+	fclose(fp);
+	if(!ok)
+		LogError("Error writing waveform file \"%s\"\n", path.c_str());
+	return ok;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Loading
+
+/**
+	@brief Loads a waveform from a file
+
+	Where the platform allows it, the sample data is mapped copy-on-write rather than read, so this returns
+	quickly regardless of waveform size and pages are only faulted in as the data is actually touched.
+
+	@return the waveform, or nullptr on failure
+ */
+WaveformBase* WaveformFile::Load(const string& path)
+{
+	FileHeader header;
+	vector<ColumnHeader> columns;
+	FILE* fp = OpenWaveformFile(path, header, columns);
+	if(!fp)
+		return nullptr;
+
+	//Make the right kind of waveform
+	UniformAnalogWaveform* ua;
+	SparseAnalogWaveform* sa;
+	UniformDigitalWaveform* ud;
+	SparseDigitalWaveform* sd;
+	auto wfm = MakeWaveformForHeader(header, ua, sa, ud, sd);
+	if(!wfm)
+	{
+		LogError("Waveform file \"%s\" has unsupported encoding %u\n", path.c_str(), header.m_encoding);
+		fclose(fp);
+		return nullptr;
+	}
+
+	//Bring in the columns
+	bool ok = true;
+	bool zstd = (header.m_compression == COMPRESSION_ZSTD);
+	for(auto& c : columns)
+	{
+		switch(c.m_type)
+		{
+			case COLUMN_SAMPLES:
+				if(ua)
+					ok &= zstd ? LoadColumnZstd(fp, c, ua->m_samples) : LoadColumn(fp, c, ua->m_samples);
+				else if(sa)
+					ok &= zstd ? LoadColumnZstd(fp, c, sa->m_samples) : LoadColumn(fp, c, sa->m_samples);
+				else if(ud)
+					ok &= zstd ? LoadColumnZstd(fp, c, ud->m_samples) : LoadColumn(fp, c, ud->m_samples);
+				else
+					ok &= zstd ? LoadColumnZstd(fp, c, sd->m_samples) : LoadColumn(fp, c, sd->m_samples);
+				break;
+
+			case COLUMN_OFFSETS:
+				if(sa)
+					ok &= zstd ? LoadColumnZstd(fp, c, sa->m_offsets) : LoadColumn(fp, c, sa->m_offsets);
+				else if(sd)
+					ok &= zstd ? LoadColumnZstd(fp, c, sd->m_offsets) : LoadColumn(fp, c, sd->m_offsets);
+				else
+					ok = false;
+				break;
+
+			case COLUMN_DURATIONS:
+				if(sa)
+					ok &= zstd ? LoadColumnZstd(fp, c, sa->m_durations) : LoadColumn(fp, c, sa->m_durations);
+				else if(sd)
+					ok &= zstd ? LoadColumnZstd(fp, c, sd->m_durations) : LoadColumn(fp, c, sd->m_durations);
+				else
+					ok = false;
+				break;
+
+			//Skip unrecognized columns so old builds can open files with future additions
+			default:
+				break;
+		}
+	}
+	fclose(fp);
+
+	if(!ok || (wfm->size() != header.m_numSamples))
+	{
+		LogError("Error reading waveform file \"%s\"\n", path.c_str());
+		delete wfm;
+		return nullptr;
+	}
+
+	return wfm;
+}
+
+/**
+	@brief Loads only the samples overlapping a time range, without reading the rest of the file
+
+	Start and end times are in femtoseconds, on the same axis as the waveform's own timestamps (so
+	GetOffsetScaled() values of the loaded samples land inside the requested range). For compressed files,
+	only the zstd frames the range touches are decompressed, so pulling a window out of a multi-gigabyte
+	archive stays fast.
+
+	The returned waveform keeps the original timebase: uniform waveforms get their trigger phase advanced to
+	account for the skipped leading samples, sparse waveforms keep their absolute sample offsets.
+
+	@return the waveform, or nullptr on failure
+ */
+WaveformBase* WaveformFile::LoadTimeRange(const string& path, int64_t startFs, int64_t endFs)
+{
+	FileHeader header;
+	vector<ColumnHeader> columns;
+	FILE* fp = OpenWaveformFile(path, header, columns);
+	if(!fp)
+		return nullptr;
+
+	//Degenerate timescale: no way to map times to samples, just load everything
+	if(header.m_timescale <= 0)
+	{
+		fclose(fp);
+		return Load(path);
+	}
+
+	//Find the column descriptors we need
+	const ColumnHeader* colSamples = nullptr;
+	const ColumnHeader* colOffsets = nullptr;
+	const ColumnHeader* colDurations = nullptr;
+	for(auto& c : columns)
+	{
+		if(c.m_type == COLUMN_SAMPLES)
+			colSamples = &c;
+		else if(c.m_type == COLUMN_OFFSETS)
+			colOffsets = &c;
+		else if(c.m_type == COLUMN_DURATIONS)
+			colDurations = &c;
+	}
+
+	//Make the right kind of waveform
+	UniformAnalogWaveform* ua;
+	SparseAnalogWaveform* sa;
+	UniformDigitalWaveform* ud;
+	SparseDigitalWaveform* sd;
+	auto wfm = MakeWaveformForHeader(header, ua, sa, ud, sd);
+	if(!wfm)
+	{
+		LogError("Waveform file \"%s\" has unsupported encoding %u\n", path.c_str(), header.m_encoding);
+		fclose(fp);
+		return nullptr;
+	}
+
+	//Convert the time range to timebase ticks
+	int64_t startTick = (startFs - header.m_triggerPhase) / header.m_timescale;
+	int64_t endTick = (endFs - header.m_triggerPhase) / header.m_timescale;
+
+	bool ok = (colSamples != nullptr);
+	size_t numSamples = header.m_numSamples;
+
+	if(ua || ud)
+	{
+		//Uniform timebase: ticks map straight to sample indexes
+		size_t first = (startTick < 0) ? 0 : min<size_t>(startTick, numSamples);
+		size_t end = (endTick < 0) ? 0 : min<size_t>(endTick + 1, numSamples);
+		if(end < first)
+			end = first;
+
+		if(ok)
+		{
+			if(ua)
+				ok &= LoadColumnRange(fp, *colSamples, header.m_compression, first, end - first, ua->m_samples);
+			else
+				ok &= LoadColumnRange(fp, *colSamples, header.m_compression, first, end - first, ud->m_samples);
+		}
+
+		//Keep absolute timestamps correct for the samples we skipped
+		wfm->m_triggerPhase += first * header.m_timescale;
+	}
+	else
+	{
+		ok &= (colOffsets != nullptr) && (colDurations != nullptr);
+
+		//Sparse timebase: find the element range covering the tick range
+		size_t first = 0;
+		size_t end = 0;
+		if(!ok || (numSamples == 0) )
+		{}
+		else if(header.m_compression == COMPRESSION_NONE)
+		{
+			//Binary search the offsets column directly on disk
+			auto firstSampleAtOrAfter = [&](int64_t target) -> size_t
+			{
+				size_t lo = 0;
+				size_t hi = numSamples;
+				while(lo < hi)
+				{
+					size_t mid = (lo + hi) / 2;
+					int64_t v;
+					if(!ReadOffsetAt(fp, *colOffsets, mid, v))
+					{
+						ok = false;
+						return 0;
+					}
+					if(v < target)
+						lo = mid + 1;
+					else
+						hi = mid;
+				}
+				return lo;
+			};
+
+			first = firstSampleAtOrAfter(startTick);
+			if(first > 0)
+				first--;	//include the sample spanning the start of the range
+			end = firstSampleAtOrAfter(endTick + 1);
+		}
+		else
+		{
+			//Use the frame index's start times to narrow the search to a window of frames, then
+			//decompress just that window to refine to exact sample bounds
+			vector<FrameHeader> frames;
+			if(!ReadFrameIndex(fp, *colOffsets, frames))
+				ok = false;
+			else if(!frames.empty())
+			{
+				size_t frameLo = 0;
+				size_t frameHi = 0;
+				for(size_t i=0; i<frames.size(); i++)
+				{
+					if(frames[i].m_firstOffset <= startTick)
+						frameLo = i;
+					if(frames[i].m_firstOffset <= endTick)
+						frameHi = i;
+				}
+				size_t e0 = frames[frameLo].m_firstElement;
+				size_t e1 = frames[frameHi].m_firstElement + frames[frameHi].m_numElements;
+
+				AcceleratorBuffer<int64_t> window;
+				ok &= LoadColumnRange(fp, *colOffsets, header.m_compression, e0, e1 - e0, window);
+				if(ok)
+				{
+					window.PrepareForCpuAccess();
+					auto base = window.GetCpuPointer();
+					auto pFirst = lower_bound(base, base + window.size(), startTick);
+					if(pFirst != base)
+						pFirst--;
+					auto pEnd = upper_bound(base, base + window.size(), endTick);
+					first = e0 + (pFirst - base);
+					end = e0 + (pEnd - base);
+				}
+			}
+		}
+
+		if(end < first)
+			end = first;
+		size_t count = end - first;
+		if(ok)
+		{
+			if(sa)
+			{
+				ok &= LoadColumnRange(fp, *colSamples, header.m_compression, first, count, sa->m_samples);
+				ok &= LoadColumnRange(fp, *colOffsets, header.m_compression, first, count, sa->m_offsets);
+				ok &= LoadColumnRange(fp, *colDurations, header.m_compression, first, count, sa->m_durations);
+			}
+			else
+			{
+				ok &= LoadColumnRange(fp, *colSamples, header.m_compression, first, count, sd->m_samples);
+				ok &= LoadColumnRange(fp, *colOffsets, header.m_compression, first, count, sd->m_offsets);
+				ok &= LoadColumnRange(fp, *colDurations, header.m_compression, first, count, sd->m_durations);
+			}
+		}
+	}
+
+	fclose(fp);
+
+	if(!ok)
+	{
+		LogError("Error reading waveform file \"%s\"\n", path.c_str());
+		delete wfm;
+		return nullptr;
+	}
+
+	return wfm;
+}
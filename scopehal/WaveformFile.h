@@ -0,0 +1,179 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Declaration of WaveformFile
+ */
+#ifndef WaveformFile_h
+#define WaveformFile_h
+
+#include "Waveform.h"
+
+/**
+	@brief Reader/writer for the native columnar waveform file format used by session files
+
+	The layout is a fixed header, a table of column descriptors, then one raw payload per column containing the
+	exact in-memory representation of the corresponding AcceleratorBuffer (samples, and for sparse waveforms the
+	offsets and durations). Payloads are page aligned, so loading can map the file copy-on-write and adopt the
+	pages into the waveform's buffers with zero copies - opening a session containing many gigabytes of waveform
+	data faults pages in lazily as they're displayed, rather than parsing and copying everything up front.
+
+	All multi-byte values are little endian (the only kind of host we run on).
+
+	For archival storage, column payloads may instead be zstd compressed. A compressed payload starts with a
+	frame index (frame count, then one FrameHeader per frame) followed by independently decompressible zstd
+	frames of roughly ZSTD_FRAME_TARGET_BYTES of uncompressed data each. The index maps element ranges (and,
+	for the offsets column, start times) to frames, so a time range can be pulled out of a multi-gigabyte
+	capture by decompressing only the frames it touches. Compressed payloads are decompressed into normally
+	allocated buffers at load time rather than mapped.
+ */
+class WaveformFile
+{
+public:
+
+	///@brief File format version we read and write
+	static const uint32_t FILE_VERSION = 1;
+
+	///@brief Alignment of column payloads within the file (one page, so mappings can adopt them directly)
+	static const size_t PAYLOAD_ALIGNMENT = 4096;
+
+	///@brief In-memory layout of the waveform stored in a file
+	enum WaveformEncoding
+	{
+		ENCODING_UNIFORM_ANALOG		= 0,
+		ENCODING_SPARSE_ANALOG		= 1,
+		ENCODING_UNIFORM_DIGITAL	= 2,
+		ENCODING_SPARSE_DIGITAL		= 3
+	};
+
+	///@brief Content of a single column payload
+	enum ColumnType
+	{
+		COLUMN_SAMPLES		= 0,
+		COLUMN_OFFSETS		= 1,
+		COLUMN_DURATIONS	= 2
+	};
+
+	///@brief Compression applied to column payloads
+	enum CompressionType
+	{
+		COMPRESSION_NONE	= 0,
+
+		///@brief Seekable zstd frames with a per-frame element index (requires building with zstd support)
+		COMPRESSION_ZSTD	= 1
+	};
+
+	///@brief Target uncompressed size of one zstd frame (trades compression ratio against seek granularity)
+	static const size_t ZSTD_FRAME_TARGET_BYTES = 4 * 1024 * 1024;
+
+	///@brief Fixed header at the start of the file
+	struct FileHeader
+	{
+		///@brief Magic number, must be FILE_MAGIC
+		uint8_t		m_magic[8];
+
+		///@brief File format version, must be FILE_VERSION
+		uint32_t	m_version;
+
+		///@brief A WaveformEncoding value
+		uint32_t	m_encoding;
+
+		///@brief Number of samples in the waveform
+		uint64_t	m_numSamples;
+
+		///@brief WaveformBase::m_timescale
+		int64_t		m_timescale;
+
+		///@brief WaveformBase::m_triggerPhase
+		int64_t		m_triggerPhase;
+
+		///@brief WaveformBase::m_startTimestamp
+		int64_t		m_startTimestamp;
+
+		///@brief WaveformBase::m_startFemtoseconds
+		int64_t		m_startFemtoseconds;
+
+		///@brief A CompressionType value applying to all column payloads
+		uint32_t	m_compression;
+
+		///@brief Number of ColumnHeader entries following this header
+		uint32_t	m_numColumns;
+
+		///@brief Reserved for future use, write as zero
+		uint64_t	m_reserved0;
+	};
+
+	///@brief Descriptor for one column payload, stored immediately after the FileHeader
+	struct ColumnHeader
+	{
+		///@brief A ColumnType value
+		uint32_t	m_type;
+
+		///@brief Size of one element of the column, in bytes
+		uint32_t	m_elementSize;
+
+		///@brief Byte offset of the payload from the start of the file (multiple of PAYLOAD_ALIGNMENT)
+		uint64_t	m_fileOffset;
+
+		///@brief Length of the payload, in bytes
+		uint64_t	m_byteLength;
+	};
+
+	///@brief Descriptor for one compressed frame within a column payload
+	struct FrameHeader
+	{
+		///@brief Index of the first element stored in this frame
+		uint64_t	m_firstElement;
+
+		///@brief Number of elements stored in this frame
+		uint64_t	m_numElements;
+
+		///@brief Byte offset of the compressed frame from the start of the file
+		uint64_t	m_fileOffset;
+
+		///@brief Length of the compressed frame, in bytes
+		uint64_t	m_compressedLength;
+
+		/**
+			@brief For COLUMN_OFFSETS frames, the value of the first element (zero for other columns)
+
+			This lets time range queries binary search the index for the right frames without decompressing
+			anything else.
+		 */
+		int64_t		m_firstOffset;
+	};
+
+	static bool Save(const std::string& path, WaveformBase* wfm, CompressionType compression = COMPRESSION_NONE);
+	static WaveformBase* Load(const std::string& path);
+	static WaveformBase* LoadTimeRange(const std::string& path, int64_t startFs, int64_t endFs);
+};
+
+#endif
@@ -0,0 +1,489 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief  Implementation of WaveformHistory
+ */
+#include "scopehal.h"
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Construction / destruction
+
+WaveformHistory::WaveformHistory(size_t memoryBudget, size_t depth)
+	: m_memoryBudget(memoryBudget)
+	, m_depth(depth)
+	, m_residentBytes(0)
+	, m_useCounter(0)
+	, m_deltaCompression(false)
+	, m_sinceKeyframe(0)
+{
+}
+
+WaveformHistory::~WaveformHistory()
+{
+	clear();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Ring operations
+
+/**
+	@brief Pushes a new acquisition onto the back of the ring, taking ownership of it
+
+	If this pushes the ring past the configured depth, the oldest entries are dropped (and their spill files
+	deleted). If the new entry pushes resident data over the memory budget, cold entries get spilled to disk.
+ */
+void WaveformHistory::Push(WaveformBase* wfm)
+{
+	lock_guard<mutex> lock(m_mutex);
+
+	HistoryEntry entry;
+	entry.m_waveform = wfm;
+	entry.m_spillPath = "";
+	entry.m_bytes = wfm->GetAllocatedBytes();
+	entry.m_lastUse = m_useCounter ++;
+	entry.m_unspillable = false;
+	entry.m_isReference = false;
+
+	//Assign a delta reference up front, but don't encode yet: encoding happens lazily when memory pressure
+	//would otherwise spill the entry, so a history that fits its budget pays nothing for delta mode
+	if(m_deltaCompression)
+	{
+		if( m_currentRef &&
+			(m_sinceKeyframe < DELTA_KEYFRAME_INTERVAL) &&
+			WaveformDeltaCodec::IsCompatible(m_currentRef->m_waveform, wfm) )
+		{
+			entry.m_deltaRef = m_currentRef;
+			m_sinceKeyframe ++;
+		}
+		else if(WaveformDeltaCodec::IsEncodable(wfm))
+		{
+			//Start a new group with this waveform as the reference frame
+			m_currentRef = make_shared<ReferenceFrame>(wfm);
+			entry.m_deltaRef = m_currentRef;
+			entry.m_isReference = true;
+			m_sinceKeyframe = 0;
+		}
+	}
+
+	m_entries.push_back(entry);
+	m_residentBytes += entry.m_bytes;
+
+	while(m_entries.size() > m_depth)
+	{
+		DropEntry(m_entries.front());
+		m_entries.pop_front();
+	}
+
+	SpillToBudget();
+}
+
+/**
+	@brief Returns the i'th entry in the ring (0 = oldest), faulting it back in from disk if it was spilled
+
+	The returned waveform remains owned by the history; don't delete it. The pointer stays valid until the
+	entry falls off the back of the ring, is cleared, or (if it gets spilled again) until the next call to
+	Push() or Get() - so hold the pointer only briefly, or copy what you need out of it.
+
+	Faulted-back waveforms are backed by a copy-on-write mapping of the spill file, so pulling an entry out
+	of deep history doesn't immediately cost its full footprint in RAM; pages are read as they're touched.
+ */
+WaveformBase* WaveformHistory::Get(size_t i)
+{
+	lock_guard<mutex> lock(m_mutex);
+
+	if(i >= m_entries.size())
+		return nullptr;
+
+	auto& entry = m_entries[i];
+	entry.m_lastUse = m_useCounter ++;
+
+	//Rebuild a delta compressed entry from its reference frame
+	if(!entry.m_waveform && !entry.m_deltaBlob.empty())
+	{
+		entry.m_waveform = WaveformDeltaCodec::Decode(entry.m_deltaRef->m_waveform, entry.m_deltaBlob);
+		if(!entry.m_waveform)
+		{
+			LogError("WaveformHistory: failed to reconstruct delta compressed history entry\n");
+			return nullptr;
+		}
+
+		//Keep the blob around so the next squeeze of this entry is free; count both it and the rebuilt copy
+		size_t wfmBytes = entry.m_waveform->GetAllocatedBytes();
+		m_residentBytes += wfmBytes;
+		entry.m_bytes = entry.m_deltaBlob.size() + wfmBytes;
+
+		SpillToBudget();
+	}
+
+	//Fault a spilled entry back in
+	else if(!entry.m_waveform)
+	{
+		entry.m_waveform = WaveformFile::Load(entry.m_spillPath);
+		if(!entry.m_waveform)
+		{
+			LogError("WaveformHistory: failed to fault history entry back in from %s\n", entry.m_spillPath.c_str());
+			return nullptr;
+		}
+
+		//The mapping is copy-on-write so untouched pages are shared with the page cache, but budget
+		//conservatively as if the whole thing were resident
+		entry.m_bytes = entry.m_waveform->GetAllocatedBytes();
+		m_residentBytes += entry.m_bytes;
+
+		SpillToBudget();
+	}
+
+	//Restore packed timestamp metadata before handing the waveform out. We don't re-spill here even if the
+	//unpack pushed us over budget (the pack pass could immediately repack the very waveform we're about to
+	//return); the overshoot is reconciled on the next Push or Get.
+	auto sparse = dynamic_cast<SparseWaveformBase*>(entry.m_waveform);
+	if(sparse && sparse->IsMetadataPacked())
+	{
+		sparse->UnpackMetadata();
+		size_t newBytes = entry.m_waveform->GetAllocatedBytes();
+		m_residentBytes += newBytes - entry.m_bytes;
+		entry.m_bytes = newBytes;
+	}
+
+	return entry.m_waveform;
+}
+
+size_t WaveformHistory::size()
+{
+	lock_guard<mutex> lock(m_mutex);
+	return m_entries.size();
+}
+
+/**
+	@brief Discards all history, freeing resident waveforms and deleting spill files
+ */
+void WaveformHistory::clear()
+{
+	lock_guard<mutex> lock(m_mutex);
+
+	for(auto& entry : m_entries)
+		DropEntry(entry);
+	m_entries.clear();
+	m_residentBytes = 0;
+	m_currentRef = nullptr;
+	m_sinceKeyframe = 0;
+}
+
+/**
+	@brief Frees an entry's waveform, delta blob, and spill file, if any
+
+	Caller must hold m_mutex. Does not remove the entry from the ring.
+ */
+void WaveformHistory::DropEntry(HistoryEntry& entry)
+{
+	//Delete the waveform first: if it was faulted back in, its sample buffers may still be backed by a
+	//copy-on-write mapping of the spill file, and we mustn't unlink that until the mapping is gone.
+	//A reference frame's waveform is owned by its ReferenceFrame, which keeps it alive as long as any
+	//delta entry is still encoded against it; dropping our shared_ptr below is all we need to do.
+	if(entry.m_waveform)
+	{
+		if(!entry.m_isReference)
+			delete entry.m_waveform;
+		m_residentBytes -= entry.m_bytes;
+		entry.m_waveform = nullptr;
+	}
+
+	//A delta compressed entry has no waveform but its residual blob still counts as resident
+	else if(!entry.m_deltaBlob.empty())
+		m_residentBytes -= entry.m_bytes;
+
+	entry.m_deltaBlob.clear();
+	entry.m_deltaRef = nullptr;
+
+	#ifndef _WIN32
+	if(!entry.m_spillPath.empty())
+	{
+		unlink(entry.m_spillPath.c_str());
+		entry.m_spillPath = "";
+	}
+	#endif
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Spilling
+
+/**
+	@brief Spills the least recently used resident entries to disk until resident data fits the target
+
+	Caller must hold m_mutex.
+ */
+void WaveformHistory::SpillTo(size_t target)
+{
+	//Cheapest relief first: pack the timestamp metadata of resident sparse entries, which roughly halves the
+	//footprint of metadata-dominated captures (e.g. logic analyzer data) without touching the disk. The ring
+	//is oldest-first, so this packs cold entries before hot ones.
+	if(m_residentBytes > target)
+	{
+		for(auto& e : m_entries)
+		{
+			//Skip entries holding a delta blob: their m_bytes includes the blob, and dropping the decoded
+			//copy outright (below) is cheaper than packing it anyway
+			if(!e.m_deltaBlob.empty())
+				continue;
+
+			auto sparse = dynamic_cast<SparseWaveformBase*>(e.m_waveform);
+			if(!sparse || sparse->IsMetadataPacked() || !sparse->PackMetadata())
+				continue;
+
+			size_t newBytes = e.m_waveform->GetAllocatedBytes();
+			m_residentBytes -= (e.m_bytes - newBytes);
+			e.m_bytes = newBytes;
+
+			if(m_residentBytes <= target)
+				break;
+		}
+	}
+
+	while(m_residentBytes > target)
+	{
+		//Find the coldest resident entry we haven't already given up on
+		size_t icold = m_entries.size();
+		uint64_t oldest = UINT64_MAX;
+		for(size_t i=0; i<m_entries.size(); i++)
+		{
+			auto& e = m_entries[i];
+			//Reference frames stay resident: delta entries need them for reconstruction
+			if(e.m_waveform && !e.m_unspillable && !e.m_isReference && (e.m_lastUse < oldest) )
+			{
+				oldest = e.m_lastUse;
+				icold = i;
+			}
+		}
+
+		//Nothing spillable left; we're stuck over budget until entries age off the ring
+		if(icold == m_entries.size())
+			break;
+
+		auto& entry = m_entries[icold];
+
+		//Squeeze delta-eligible entries against their reference frame before touching the disk: a repetitive
+		//capture shrinks 10-50x and the blob stays in RAM, so faulting it back in later is just a decompress
+		//rather than disk traffic
+		if(entry.m_deltaRef)
+		{
+			if(entry.m_deltaBlob.empty())
+				WaveformDeltaCodec::Encode(entry.m_deltaRef->m_waveform, entry.m_waveform, entry.m_deltaBlob);
+
+			if(!entry.m_deltaBlob.empty())
+			{
+				delete entry.m_waveform;
+				entry.m_waveform = nullptr;
+				m_residentBytes -= entry.m_bytes;
+				entry.m_bytes = entry.m_deltaBlob.size();
+				m_residentBytes += entry.m_bytes;
+				continue;
+			}
+
+			//Residual didn't compress (signal isn't actually repetitive); take the normal spill path
+			//from here on
+			entry.m_deltaRef = nullptr;
+		}
+
+		#ifdef _WIN32
+
+			//On Windows, keep everything resident for now
+			//(same fallback AcceleratorBuffer uses for its file-backed storage)
+			entry.m_unspillable = true;
+			continue;
+
+		#else
+
+			//If this entry was spilled before and faulted back in, its on-disk copy is still valid
+			//(the mapping is copy-on-write, we never write the waveform back), so we can just drop the RAM copy.
+			//Otherwise serialize it out first.
+			if(entry.m_spillPath.empty())
+			{
+				//WaveformFile doesn't know the packed timestamp form; restore the wide buffers first.
+				//(The RAM copy is about to be freed anyway, so this only costs a moment of transient footprint.)
+				auto sparse = dynamic_cast<SparseWaveformBase*>(entry.m_waveform);
+				if(sparse && sparse->IsMetadataPacked())
+				{
+					sparse->UnpackMetadata();
+					size_t newBytes = entry.m_waveform->GetAllocatedBytes();
+					m_residentBytes += newBytes - entry.m_bytes;
+					entry.m_bytes = newBytes;
+				}
+
+				//Use the same scratch directory convention as AcceleratorBuffer's file-backed storage
+				char fname[] = "/tmp/glscopeclient-histXXXXXX";
+				int fd = mkstemp(fname);
+				if(fd < 0)
+				{
+					LogError("WaveformHistory: failed to create spill file\n");
+					entry.m_unspillable = true;
+					continue;
+				}
+				close(fd);
+
+				if(!WaveformFile::Save(fname, entry.m_waveform))
+				{
+					//Unsupported waveform type or disk error; keep it resident and don't retry
+					unlink(fname);
+					entry.m_unspillable = true;
+					continue;
+				}
+
+				entry.m_spillPath = fname;
+			}
+
+			delete entry.m_waveform;
+			entry.m_waveform = nullptr;
+			m_residentBytes -= entry.m_bytes;
+
+		#endif
+	}
+}
+
+/**
+	@brief Spills the least recently used resident entries to disk until we're back under the memory budget
+
+	Caller must hold m_mutex.
+ */
+void WaveformHistory::SpillToBudget()
+{
+	SpillTo(m_memoryBudget);
+}
+
+/**
+	@brief Spills resident entries to disk until no more than the requested bytes remain in RAM
+
+	Used by MemoryGovernor to push history out beyond what our own budget requires when the whole process is
+	under memory pressure. Does not change the configured budget, so the history refills normally once the
+	pressure clears.
+ */
+void WaveformHistory::Spill(size_t targetResidentBytes)
+{
+	lock_guard<mutex> lock(m_mutex);
+	SpillTo(targetResidentBytes);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Budget / telemetry
+
+/**
+	@brief Changes the maximum ring depth, dropping the oldest entries if we're now over it
+ */
+void WaveformHistory::SetDepth(size_t depth)
+{
+	lock_guard<mutex> lock(m_mutex);
+	m_depth = depth;
+
+	while(m_entries.size() > m_depth)
+	{
+		DropEntry(m_entries.front());
+		m_entries.pop_front();
+	}
+}
+
+size_t WaveformHistory::GetDepth()
+{
+	lock_guard<mutex> lock(m_mutex);
+	return m_depth;
+}
+
+/**
+	@brief Changes the memory budget, spilling immediately if resident data is over the new cap
+ */
+void WaveformHistory::SetMemoryBudget(size_t bytes)
+{
+	lock_guard<mutex> lock(m_mutex);
+	m_memoryBudget = bytes;
+	SpillToBudget();
+}
+
+size_t WaveformHistory::GetMemoryBudget()
+{
+	lock_guard<mutex> lock(m_mutex);
+	return m_memoryBudget;
+}
+
+/**
+	@brief Turns delta compression of repetitive captures on or off
+
+	Takes effect for subsequently pushed waveforms; existing delta compressed entries remain valid and
+	reconstruct normally. Turning it back on starts a fresh reference frame on the next push.
+ */
+void WaveformHistory::EnableDeltaCompression(bool enable)
+{
+	lock_guard<mutex> lock(m_mutex);
+	m_deltaCompression = enable;
+	if(!enable)
+		m_currentRef = nullptr;
+}
+
+bool WaveformHistory::IsDeltaCompressionEnabled()
+{
+	lock_guard<mutex> lock(m_mutex);
+	return m_deltaCompression;
+}
+
+WaveformHistory::HistoryStats WaveformHistory::GetStats()
+{
+	lock_guard<mutex> lock(m_mutex);
+
+	HistoryStats stats;
+	stats.m_numResident = 0;
+	stats.m_numSpilled = 0;
+	stats.m_residentBytes = m_residentBytes;
+	stats.m_spilledBytes = 0;
+	stats.m_numDelta = 0;
+	stats.m_deltaBytes = 0;
+
+	for(auto& entry : m_entries)
+	{
+		if(!entry.m_deltaBlob.empty())
+			stats.m_deltaBytes += entry.m_deltaBlob.size();
+
+		if(entry.m_waveform)
+			stats.m_numResident ++;
+		else if(!entry.m_deltaBlob.empty())
+			stats.m_numDelta ++;
+		else
+		{
+			stats.m_numSpilled ++;
+			stats.m_spilledBytes += entry.m_bytes;
+		}
+	}
+
+	return stats;
+}
@@ -0,0 +1,198 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Declaration of WaveformHistory
+ */
+#ifndef WaveformHistory_h
+#define WaveformHistory_h
+
+#include "Waveform.h"
+#include "WaveformDeltaCodec.h"
+
+#include <deque>
+
+/**
+	@brief Thread safe ring of past acquisitions with a RAM budget and spill-to-disk
+
+	The history owns the waveforms pushed into it. Entries past the configured depth fall off the back of the
+	ring; entries that still fit in the ring but exceed the memory budget first have sparse timestamp metadata
+	packed in place (SparseWaveformBase::PackMetadata), then get spilled to the columnar waveform
+	file format on disk, coldest first, and their in-memory copies freed. Accessing a spilled entry faults it
+	back in through WaveformFile::Load, which maps the file copy-on-write rather than copying it - so keeping
+	hours of deep history costs disk space, not pinned RAM.
+
+	Only waveform types WaveformFile can serialize (analog and digital, sparse or uniform) are spillable.
+	Anything else (e.g. protocol waveforms) stays resident and just counts against the budget.
+
+	With delta compression enabled (EnableDeltaCompression), repetitive captures are squeezed before the disk
+	is touched: every DELTA_KEYFRAME_INTERVAL'th push becomes a reference frame, and entries between keyframes
+	are delta encoded against it by WaveformDeltaCodec when memory pressure would otherwise spill them. The
+	residual blob stays in RAM (typically 10-50x smaller than the raw capture for a repetitive stimulus) and
+	reconstruction on access is transparent, so deep history of a production test loop costs a few reference
+	frames plus small residuals instead of disk traffic. Signals that don't delta compress well fall back to
+	the normal spill path automatically.
+ */
+class WaveformHistory
+{
+public:
+	WaveformHistory(size_t memoryBudget = 1024 * 1024 * 1024, size_t depth = 100);
+	~WaveformHistory();
+
+	void Push(WaveformBase* wfm);
+	WaveformBase* Get(size_t i);
+	size_t size();
+	void clear();
+
+	void SetDepth(size_t depth);
+	size_t GetDepth();
+
+	void SetMemoryBudget(size_t bytes);
+	size_t GetMemoryBudget();
+
+	void Spill(size_t targetResidentBytes);
+
+	void EnableDeltaCompression(bool enable);
+	bool IsDeltaCompressionEnabled();
+
+	///@brief Telemetry counters, queryable at runtime via GetStats()
+	struct HistoryStats
+	{
+		///@brief Number of entries currently resident in RAM
+		size_t m_numResident;
+
+		///@brief Number of entries currently spilled to disk
+		size_t m_numSpilled;
+
+		///@brief Total bytes of waveform data currently resident in RAM
+		size_t m_residentBytes;
+
+		///@brief Total bytes of waveform data currently spilled to disk
+		size_t m_spilledBytes;
+
+		///@brief Number of entries currently stored as a delta against a reference frame
+		size_t m_numDelta;
+
+		///@brief Total bytes of delta residual blobs currently resident in RAM
+		size_t m_deltaBytes;
+	};
+
+	HistoryStats GetStats();
+
+protected:
+
+	/**
+		@brief A delta compression reference frame, shared by its own ring entry and every entry encoded
+		against it
+
+		Owns the waveform: it stays alive (and resident) as long as any delta entry still needs it for
+		reconstruction, even after its own entry falls off the back of the ring. In that window its footprint
+		is no longer counted against the budget; with dependents being the oldest entries left in the ring,
+		the overhang is brief.
+	 */
+	struct ReferenceFrame
+	{
+		ReferenceFrame(WaveformBase* wfm)
+			: m_waveform(wfm)
+		{}
+
+		~ReferenceFrame()
+		{ delete m_waveform; }
+
+		ReferenceFrame(const ReferenceFrame&) = delete;
+		ReferenceFrame& operator=(const ReferenceFrame&) = delete;
+
+		WaveformBase* m_waveform;
+	};
+
+	///@brief A historical acquisition plus the bookkeeping needed for budgeting and spilling
+	struct HistoryEntry
+	{
+		///@brief The waveform, or nullptr if currently spilled to disk or stored as a delta
+		WaveformBase* m_waveform;
+
+		///@brief Path of the on-disk copy ("" if none exists)
+		std::string m_spillPath;
+
+		///@brief Allocated bytes, sampled when the entry was last resident
+		size_t m_bytes;
+
+		///@brief Value of m_useCounter when the entry was last touched (for cold-first spilling)
+		uint64_t m_lastUse;
+
+		///@brief Set if a previous spill attempt failed (unsupported type or disk error), so we don't retry
+		bool m_unspillable;
+
+		///@brief Reference frame this entry is (or can be) delta encoded against, if delta compression is on
+		std::shared_ptr<ReferenceFrame> m_deltaRef;
+
+		///@brief Delta residual blob (empty if the entry hasn't been delta encoded)
+		std::vector<uint8_t> m_deltaBlob;
+
+		///@brief Set if this entry's waveform *is* the reference frame (owned by m_deltaRef, not us)
+		bool m_isReference;
+	};
+
+	void SpillToBudget();
+	void SpillTo(size_t target);
+	void DropEntry(HistoryEntry& entry);
+
+	///@brief Maximum number of bytes of resident waveform data before spilling
+	size_t m_memoryBudget;
+
+	///@brief Maximum number of entries in the ring
+	size_t m_depth;
+
+	///@brief Total bytes currently resident across all entries
+	size_t m_residentBytes;
+
+	///@brief Monotonically increasing counter used to order entries for cold-first spilling
+	uint64_t m_useCounter;
+
+	///@brief Set if pushed waveforms should be delta encoded against reference frames under memory pressure
+	bool m_deltaCompression;
+
+	///@brief Maximum number of deltas encoded against one reference frame before forcing a new keyframe
+	static const size_t DELTA_KEYFRAME_INTERVAL = 16;
+
+	///@brief Reference frame new pushes get delta encoded against
+	std::shared_ptr<ReferenceFrame> m_currentRef;
+
+	///@brief Number of entries delta encoded against m_currentRef so far
+	size_t m_sinceKeyframe;
+
+	std::mutex m_mutex;
+
+	///@brief The ring itself, oldest entry at the front
+	std::deque<HistoryEntry> m_entries;
+};
+
+#endif
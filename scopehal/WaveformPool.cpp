@@ -0,0 +1,244 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* ngscopeclient                                                                                                        *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg                                                                          *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief  Implementation of WaveformPool
+ */
+#include "scopehal.h"
+
+using namespace std;
+
+///@brief Process-wide pool for recycling analog waveforms
+WaveformPool g_analogWaveformPool;
+
+///@brief Process-wide pool for recycling digital waveforms
+WaveformPool g_digitalWaveformPool(256 * 1024 * 1024);
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Construction / destruction
+
+WaveformPool::WaveformPool(size_t memoryBudget)
+	: m_memoryBudget(memoryBudget)
+	, m_totalBytes(0)
+	, m_useCounter(0)
+	, m_numHits(0)
+	, m_numMisses(0)
+{
+}
+
+WaveformPool::~WaveformPool()
+{
+	for(size_t i=0; i<NUM_BUCKETS; i++)
+	{
+		for(auto& entry : m_buckets[i])
+			delete entry.m_waveform;
+		m_buckets[i].clear();
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Pool operations
+
+/**
+	@brief Adds a waveform to the pool, evicting the least recently pooled waveforms if this exceeds the budget
+ */
+void WaveformPool::Add(WaveformBase* w)
+{
+	lock_guard<mutex> lock(m_mutex);
+
+	w->Rename("WaveformPool.freelist");
+
+	PooledWaveform entry;
+	entry.m_waveform = w;
+	entry.m_bytes = w->GetAllocatedBytes();
+	entry.m_lastUse = m_useCounter ++;
+
+	m_buckets[GetBucketIndex(entry.m_bytes)].push_front(entry);
+	m_totalBytes += entry.m_bytes;
+
+	ShrinkToBudget();
+}
+
+/**
+	@brief Gets a waveform from the pool, or null if nothing suitable is available
+
+	@param sizeHint		Expected sample buffer footprint in bytes. If nonzero, returns the most recently pooled
+						waveform from the smallest bucket at least that big, to minimize reallocation when the
+						caller resizes it. If zero, returns the most recently pooled waveform of any size.
+ */
+WaveformBase* WaveformPool::Get(size_t sizeHint)
+{
+	lock_guard<mutex> lock(m_mutex);
+
+	size_t ibucket = NUM_BUCKETS;
+
+	//Size hint provided: find the smallest bucket that can hold a waveform of that size
+	if(sizeHint != 0)
+	{
+		for(size_t i = GetBucketIndex(sizeHint); i < NUM_BUCKETS; i++)
+		{
+			if(!m_buckets[i].empty())
+			{
+				ibucket = i;
+				break;
+			}
+		}
+	}
+
+	//No hint (or nothing big enough): take the most recently pooled waveform regardless of size
+	if(ibucket == NUM_BUCKETS)
+	{
+		uint64_t newest = 0;
+		for(size_t i=0; i<NUM_BUCKETS; i++)
+		{
+			if(!m_buckets[i].empty() && (m_buckets[i].front().m_lastUse >= newest))
+			{
+				newest = m_buckets[i].front().m_lastUse;
+				ibucket = i;
+			}
+		}
+	}
+
+	//Pool is empty
+	if(ibucket == NUM_BUCKETS)
+	{
+		m_numMisses ++;
+		return nullptr;
+	}
+
+	auto entry = m_buckets[ibucket].front();
+	m_buckets[ibucket].pop_front();
+	m_totalBytes -= entry.m_bytes;
+	m_numHits ++;
+
+	auto ret = entry.m_waveform;
+	ret->m_revision ++;
+	ret->Rename("WaveformPool.allocated");
+	return ret;
+}
+
+/**
+	@brief Frees the least recently pooled waveforms until no more than the requested bytes remain
+
+	Caller must hold m_mutex.
+ */
+void WaveformPool::ShrinkTo(size_t target)
+{
+	while(m_totalBytes > target)
+	{
+		//The back of each bucket is its oldest entry, so the eviction candidate is the oldest of the backs
+		size_t ibucket = NUM_BUCKETS;
+		uint64_t oldest = UINT64_MAX;
+		for(size_t i=0; i<NUM_BUCKETS; i++)
+		{
+			if(!m_buckets[i].empty() && (m_buckets[i].back().m_lastUse < oldest))
+			{
+				oldest = m_buckets[i].back().m_lastUse;
+				ibucket = i;
+			}
+		}
+
+		//Nothing left to evict (budget smaller than a single waveform that's already gone)
+		if(ibucket == NUM_BUCKETS)
+			break;
+
+		auto& entry = m_buckets[ibucket].back();
+		m_totalBytes -= entry.m_bytes;
+		delete entry.m_waveform;
+		m_buckets[ibucket].pop_back();
+	}
+}
+
+/**
+	@brief Frees the least recently pooled waveforms until we're back under the memory budget
+
+	Caller must hold m_mutex.
+ */
+void WaveformPool::ShrinkToBudget()
+{
+	ShrinkTo(m_memoryBudget);
+}
+
+/**
+	@brief Frees pooled waveforms until no more than the requested bytes remain, without changing the budget
+
+	Used by MemoryGovernor to drop recycled buffers under memory pressure; the pool refills normally once the
+	pressure clears.
+ */
+void WaveformPool::Trim(size_t maxBytes)
+{
+	lock_guard<mutex> lock(m_mutex);
+	ShrinkTo(maxBytes);
+}
+
+/**
+	@brief Returns the bucket index for a waveform of the given allocated size (bucket i holds up to 2^i bytes)
+ */
+size_t WaveformPool::GetBucketIndex(size_t bytes)
+{
+	size_t i = 0;
+	while( ( (static_cast<size_t>(1) << i) < bytes) && (i < NUM_BUCKETS-1) )
+		i ++;
+	return i;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Budget / telemetry
+
+WaveformPool::PoolStats WaveformPool::GetStats()
+{
+	lock_guard<mutex> lock(m_mutex);
+
+	PoolStats stats;
+	stats.m_numHits = m_numHits;
+	stats.m_numMisses = m_numMisses;
+	stats.m_bytesPooled = m_totalBytes;
+	stats.m_numWaveforms = 0;
+	for(size_t i=0; i<NUM_BUCKETS; i++)
+		stats.m_numWaveforms += m_buckets[i].size();
+	return stats;
+}
+
+/**
+	@brief Changes the memory budget, evicting immediately if the pool is over the new cap
+ */
+void WaveformPool::SetMemoryBudget(size_t bytes)
+{
+	lock_guard<mutex> lock(m_mutex);
+	m_memoryBudget = bytes;
+	ShrinkToBudget();
+}
+
+size_t WaveformPool::GetMemoryBudget()
+{
+	lock_guard<mutex> lock(m_mutex);
+	return m_memoryBudget;
+}
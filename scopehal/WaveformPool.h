@@ -36,60 +36,88 @@
 #define WaveformPool_h
 
 /**
-	@brief Thread safe memory pool for reusing Waveform objects
+	@brief Thread safe, memory-budgeted pool for reusing Waveform objects
+
+	Recycled waveforms keep their sample buffer allocations, so reusing one avoids reallocating (and potentially
+	re-pinning) large amounts of memory on every trigger. Free waveforms are binned by allocation size so a request
+	with a size hint can be steered to a recycled buffer of similar capacity.
+
+	The total number of bytes held by the pool is capped by a budget; the least recently pooled waveforms are freed
+	when the cap is exceeded, so deep waveform history no longer grows our footprint without bound.
  */
 class WaveformPool
 {
 public:
-	WaveformPool()
-	: m_maxSize(16)
-	{}
+	WaveformPool(size_t memoryBudget = 512 * 1024 * 1024);
+	~WaveformPool();
 
-	~WaveformPool()
-	{
-		for(auto w : m_waveforms)
-			delete w;
-		m_waveforms.clear();
-	}
-
-	/**
-		@brief Adds a new waveform to the pool if there's space for it, otherwise free it
-	 */
-	void Add(WaveformBase* w)
-	{
-		std::lock_guard<std::mutex> lock(m_mutex);
-		w->Rename("WaveformPool.freelist");
-
-		if(m_waveforms.size() < m_maxSize)
-			m_waveforms.push_back(w);
-		else
-			delete w;
-	}
-
-	/**
-		@brief Gets a waveform from the pool if there's space for it, otherwise return null
-	 */
-	WaveformBase* Get()
+	void Add(WaveformBase* w);
+	WaveformBase* Get(size_t sizeHint = 0);
+
+	///@brief Telemetry counters, queryable at runtime via GetStats()
+	struct PoolStats
 	{
-		std::lock_guard<std::mutex> lock(m_mutex);
+		///@brief Number of Get() calls that returned a recycled waveform
+		uint64_t m_numHits;
 
-		if(m_waveforms.empty())
-			return nullptr;
+		///@brief Number of Get() calls that found nothing suitable
+		uint64_t m_numMisses;
 
-		auto ret = *m_waveforms.begin();
-		ret->m_revision ++;
-		m_waveforms.pop_front();
+		///@brief Total bytes of sample buffer memory currently held by the pool
+		size_t m_bytesPooled;
 
-		ret->Rename("WaveformPool.allocated");
-		return ret;
-	}
+		///@brief Number of waveforms currently held by the pool
+		size_t m_numWaveforms;
+	};
+
+	PoolStats GetStats();
+
+	void SetMemoryBudget(size_t bytes);
+	size_t GetMemoryBudget();
+
+	void Trim(size_t maxBytes);
 
 protected:
-	size_t m_maxSize;
+
+	///@brief A pooled waveform plus the bookkeeping needed for budgeting and eviction
+	struct PooledWaveform
+	{
+		WaveformBase* m_waveform;
+
+		///@brief Allocated bytes, sampled when the waveform was added (it may be resized while checked out)
+		size_t m_bytes;
+
+		///@brief Value of m_useCounter when the waveform was added (for LRU eviction)
+		uint64_t m_lastUse;
+	};
+
+	size_t GetBucketIndex(size_t bytes);
+	void ShrinkToBudget();
+	void ShrinkTo(size_t target);
+
+	///@brief Maximum number of bytes the pool may hold before evicting
+	size_t m_memoryBudget;
+
+	///@brief Total bytes currently held across all buckets
+	size_t m_totalBytes;
+
+	///@brief Monotonically increasing counter used to order entries for LRU eviction
+	uint64_t m_useCounter;
+
+	uint64_t m_numHits;
+	uint64_t m_numMisses;
 
 	std::mutex m_mutex;
 
-	std::list<WaveformBase*> m_waveforms;
+	///@brief Number of size buckets (bucket i holds waveforms of up to 2^i bytes)
+	static const size_t NUM_BUCKETS = 48;
+
+	///@brief Free lists binned by power-of-two allocation size, most recently added at the front
+	std::list<PooledWaveform> m_buckets[NUM_BUCKETS];
 };
 
+//Process-wide pools, shared by all instruments so recycled buffers are available wherever the next trigger lands
+extern WaveformPool g_analogWaveformPool;
+extern WaveformPool g_digitalWaveformPool;
+
 #endif
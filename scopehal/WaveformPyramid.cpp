@@ -0,0 +1,272 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Implementation of WaveformPyramid
+ */
+#include "scopehal.h"
+#include "WaveformPyramid.h"
+
+using namespace std;
+
+namespace
+{
+	///@brief Push constants for the WaveformPyramidFirst / WaveformPyramidNext shaders
+	struct WaveformPyramidArgs
+	{
+		uint32_t insize;
+		uint32_t outsize;
+		uint32_t firstOut;
+	};
+
+	///@brief Reduces one block of PYRAMID_RATIO min/max pairs to a single pair
+	void ReduceBlock(const float* pmin, const float* pmax, size_t insize, size_t j, float* pomin, float* pomax)
+	{
+		size_t base = j * UniformWaveformBase::PYRAMID_RATIO;
+		float vmin = pmin[base];
+		float vmax = pmax[base];
+		for(size_t k=1; k<UniformWaveformBase::PYRAMID_RATIO; k++)
+		{
+			size_t idx = base + k;
+			if(idx >= insize)
+				break;
+			vmin = min(vmin, pmin[idx]);
+			vmax = max(vmax, pmax[idx]);
+		}
+		pomin[j] = vmin;
+		pomax[j] = vmax;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Construction / destruction
+
+WaveformPyramid::WaveformPyramid()
+	: m_firstPipeline("shaders/WaveformPyramidFirst.spv", 3, sizeof(WaveformPyramidArgs))
+	, m_nextPipeline("shaders/WaveformPyramidNext.spv", 4, sizeof(WaveformPyramidArgs))
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Pyramid maintenance
+
+/**
+	@brief Brings the pyramid of a waveform up to date, rebuilding from scratch if anything changed
+
+	Does nothing if the pyramid already matches the current waveform revision.
+ */
+void WaveformPyramid::Update(
+	UniformAnalogWaveform* wfm,
+	vk::raii::CommandBuffer& cmdBuf,
+	shared_ptr<QueueHandle> queue)
+{
+	if( (wfm->m_cachedPyramidRevision == wfm->m_revision) && (wfm->m_pyramidValidLen == wfm->size()) )
+		return;
+
+	Build(wfm, 0, cmdBuf, queue);
+}
+
+/**
+	@brief Brings the pyramid of a waveform up to date after an append-only change
+
+	The caller guarantees samples before the previous length are untouched (e.g. streaming acquisition): only
+	pyramid outputs covering the new tail are recomputed, so cost scales with the appended data rather than
+	total waveform length.
+ */
+void WaveformPyramid::UpdateAppended(
+	UniformAnalogWaveform* wfm,
+	vk::raii::CommandBuffer& cmdBuf,
+	shared_ptr<QueueHandle> queue)
+{
+	size_t len = wfm->size();
+	if( (wfm->m_cachedPyramidRevision == wfm->m_revision) && (wfm->m_pyramidValidLen == len) )
+		return;
+
+	//If the waveform shrank it wasn't an append, rebuild fully
+	size_t oldLen = wfm->m_pyramidValidLen;
+	if(oldLen > len)
+		oldLen = 0;
+
+	Build(wfm, oldLen, cmdBuf, queue);
+}
+
+/**
+	@brief (Re)builds all pyramid levels covering samples at or after oldLen
+ */
+void WaveformPyramid::Build(
+	UniformAnalogWaveform* wfm,
+	size_t oldLen,
+	vk::raii::CommandBuffer& cmdBuf,
+	shared_ptr<QueueHandle> queue)
+{
+	size_t len = wfm->size();
+
+	//Figure out level sizes (coarsest level stays at least MIN_LEVEL_SIZE output samples)
+	vector<size_t> sizes;
+	size_t cur = len;
+	while(true)
+	{
+		size_t next = (cur + UniformWaveformBase::PYRAMID_RATIO - 1) / UniformWaveformBase::PYRAMID_RATIO;
+		if(next < MIN_LEVEL_SIZE)
+			break;
+		sizes.push_back(next);
+		cur = next;
+	}
+
+	//A level count change invalidates coarser levels wholesale, easiest to just rebuild everything
+	size_t nlevels = sizes.size();
+	if(nlevels != wfm->m_pyramid.size())
+	{
+		oldLen = 0;
+		wfm->m_pyramid.resize(nlevels);
+		for(size_t i=0; i<nlevels; i++)
+		{
+			if(!wfm->m_pyramid[i])
+				wfm->m_pyramid[i] = make_shared<UniformWaveformBase::PyramidLevel>();
+		}
+	}
+
+	size_t decimation = 1;
+	for(size_t i=0; i<nlevels; i++)
+	{
+		decimation *= UniformWaveformBase::PYRAMID_RATIO;
+		auto& lvl = wfm->m_pyramid[i];
+		lvl->m_decimation = decimation;
+		lvl->m_min.resize(sizes[i]);
+		lvl->m_max.resize(sizes[i]);
+	}
+
+	if(nlevels == 0)
+	{
+		wfm->m_cachedPyramidRevision = wfm->m_revision;
+		wfm->m_pyramidValidLen = len;
+		return;
+	}
+
+	//GPU path: chain of reduce dispatches in a single submit
+	//(shaders index with 32 bit sample positions, larger waveforms take the CPU path)
+	if(g_hasPushDescriptor && (len <= 0xffffffff) )
+	{
+		cmdBuf.begin({});
+
+		WaveformPyramidArgs args;
+		args.insize = len;
+		args.outsize = sizes[0];
+		args.firstOut = oldLen / UniformWaveformBase::PYRAMID_RATIO;
+
+		auto lvl = wfm->m_pyramid[0];
+		m_firstPipeline.BindBufferNonblocking(0, wfm->m_samples, cmdBuf);
+		m_firstPipeline.BindBufferNonblocking(1, lvl->m_min, cmdBuf, true);
+		m_firstPipeline.BindBufferNonblocking(2, lvl->m_max, cmdBuf, true);
+		m_firstPipeline.Dispatch(cmdBuf, args, GetComputeBlockCount(args.outsize - args.firstOut, 64));
+
+		for(size_t i=1; i<nlevels; i++)
+		{
+			m_firstPipeline.AddComputeMemoryBarrier(cmdBuf);
+
+			auto prev = wfm->m_pyramid[i-1];
+			lvl = wfm->m_pyramid[i];
+
+			args.insize = sizes[i-1];
+			args.outsize = sizes[i];
+			args.firstOut = args.firstOut / UniformWaveformBase::PYRAMID_RATIO;
+
+			m_nextPipeline.BindBufferNonblocking(0, prev->m_min, cmdBuf);
+			m_nextPipeline.BindBufferNonblocking(1, prev->m_max, cmdBuf);
+			m_nextPipeline.BindBufferNonblocking(2, lvl->m_min, cmdBuf, true);
+			m_nextPipeline.BindBufferNonblocking(3, lvl->m_max, cmdBuf, true);
+			m_nextPipeline.Dispatch(cmdBuf, args, GetComputeBlockCount(args.outsize - args.firstOut, 64));
+		}
+
+		cmdBuf.end();
+		queue->SubmitAndBlock(cmdBuf);
+
+		for(size_t i=0; i<nlevels; i++)
+		{
+			wfm->m_pyramid[i]->m_min.MarkModifiedFromGpu();
+			wfm->m_pyramid[i]->m_max.MarkModifiedFromGpu();
+		}
+	}
+
+	else
+		BuildCpu(wfm, oldLen);
+
+	wfm->m_cachedPyramidRevision = wfm->m_revision;
+	wfm->m_pyramidValidLen = len;
+}
+
+/**
+	@brief CPU fallback for Build()
+ */
+void WaveformPyramid::BuildCpu(UniformAnalogWaveform* wfm, size_t oldLen)
+{
+	size_t len = wfm->size();
+	size_t nlevels = wfm->m_pyramid.size();
+
+	wfm->PrepareForCpuAccess();
+
+	size_t firstOut = oldLen / UniformWaveformBase::PYRAMID_RATIO;
+	size_t insize = len;
+	const float* pmin = wfm->m_samples.GetCpuPointer();
+	const float* pmax = pmin;
+
+	for(size_t i=0; i<nlevels; i++)
+	{
+		auto& lvl = wfm->m_pyramid[i];
+		size_t outsize = lvl->m_min.size();
+
+		lvl->m_min.PrepareForCpuAccess();
+		lvl->m_max.PrepareForCpuAccess();
+		float* pomin = lvl->m_min.GetCpuPointer();
+		float* pomax = lvl->m_max.GetCpuPointer();
+
+		//Blocks are independent, multithread the big levels
+		if( (outsize - firstOut) > 250000)
+		{
+			#pragma omp parallel for
+			for(size_t j=firstOut; j<outsize; j++)
+				ReduceBlock(pmin, pmax, insize, j, pomin, pomax);
+		}
+		else
+		{
+			for(size_t j=firstOut; j<outsize; j++)
+				ReduceBlock(pmin, pmax, insize, j, pomin, pomax);
+		}
+
+		lvl->m_min.MarkModifiedFromCpu();
+		lvl->m_max.MarkModifiedFromCpu();
+
+		firstOut /= UniformWaveformBase::PYRAMID_RATIO;
+		insize = outsize;
+		pmin = pomin;
+		pmax = pomax;
+	}
+}
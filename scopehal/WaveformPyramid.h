@@ -0,0 +1,89 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Declaration of WaveformPyramid
+ */
+#ifndef WaveformPyramid_h
+#define WaveformPyramid_h
+
+/**
+	@brief Builds and maintains the min/max decimation pyramid attached to uniform analog waveforms
+
+	Overview consumers (minimap renders, peak-hold displays, SLA dashboards) all need min/max decimated views of
+	the same full-rate data. Rather than each recomputing from scratch, this builder populates
+	UniformWaveformBase::m_pyramid with min/max pairs at power-of-4 decimation levels; any consumer then gets an
+	overview at arbitrary zoom in O(output samples) time via GetPyramidLevel() plus a short finishing reduction.
+
+	Levels are built by a chain of GPU reduce dispatches in a single submit where available, with a multithreaded
+	CPU fallback. Update() rebuilds when the waveform revision has changed; UpdateAppended() additionally assumes
+	existing samples are untouched (append-only growth, e.g. streaming acquisition) and only recomputes pyramid
+	outputs covering the new tail.
+
+	The pyramid is optional: waveforms shorter than MIN_LEVEL_SIZE * PYRAMID_RATIO samples get no levels at all,
+	and consumers always need a full-rate fallback path.
+ */
+class WaveformPyramid
+{
+public:
+	WaveformPyramid();
+
+	//not copyable or assignable
+	WaveformPyramid(const WaveformPyramid&) =delete;
+	WaveformPyramid& operator=(const WaveformPyramid&) =delete;
+
+	///@brief Don't build levels coarser than this many output samples
+	static const size_t MIN_LEVEL_SIZE = 64;
+
+	void Update(
+		UniformAnalogWaveform* wfm,
+		vk::raii::CommandBuffer& cmdBuf,
+		std::shared_ptr<QueueHandle> queue);
+
+	void UpdateAppended(
+		UniformAnalogWaveform* wfm,
+		vk::raii::CommandBuffer& cmdBuf,
+		std::shared_ptr<QueueHandle> queue);
+
+protected:
+	void Build(
+		UniformAnalogWaveform* wfm,
+		size_t oldLen,
+		vk::raii::CommandBuffer& cmdBuf,
+		std::shared_ptr<QueueHandle> queue);
+
+	void BuildCpu(UniformAnalogWaveform* wfm, size_t oldLen);
+
+	ComputePipeline m_firstPipeline;
+	ComputePipeline m_nextPipeline;
+};
+
+#endif
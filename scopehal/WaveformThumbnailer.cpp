@@ -0,0 +1,286 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief  Implementation of WaveformThumbnailer
+ */
+#include "scopehal.h"
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Construction / destruction
+
+WaveformThumbnailer::WaveformThumbnailer(size_t width)
+	: m_width(width)
+	, m_activeWaveform(nullptr)
+	, m_shuttingDown(false)
+{
+	m_thread = make_unique<thread>(ThumbnailThread, this);
+}
+
+WaveformThumbnailer::~WaveformThumbnailer()
+{
+	{
+		lock_guard<mutex> lock(m_mutex);
+		m_shuttingDown = true;
+	}
+	m_workCvar.notify_all();
+	m_thread->join();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Request management
+
+/**
+	@brief Queues a waveform for thumbnailing
+
+	If a thumbnail for the waveform's current revision already exists (or rendering one already failed),
+	this is a no-op. Re-requesting something already queued just updates its priority.
+ */
+void WaveformThumbnailer::Request(WaveformBase* wfm, int64_t priority)
+{
+	{
+		lock_guard<mutex> lock(m_mutex);
+
+		//Already rendered (or failed) against the current revision? Nothing to do.
+		auto it = m_cache.find(wfm);
+		if( (it != m_cache.end()) && (it->second.first == wfm->m_revision) )
+			return;
+
+		m_pending[wfm] = priority;
+	}
+	m_workCvar.notify_one();
+}
+
+/**
+	@brief Returns the most recent thumbnail of a waveform, or null if none has been rendered yet
+
+	The thumbnail may have been rendered against an older revision of the waveform; check
+	Thumbnail::m_revision if staleness matters.
+ */
+shared_ptr<WaveformThumbnailer::Thumbnail> WaveformThumbnailer::Get(WaveformBase* wfm)
+{
+	lock_guard<mutex> lock(m_mutex);
+	auto it = m_cache.find(wfm);
+	if(it == m_cache.end())
+		return nullptr;
+	return it->second.second;
+}
+
+/**
+	@brief Drops all state referring to a waveform (call before freeing a history entry)
+
+	Blocks until any in-flight render of the waveform finishes, so the caller may free it as soon as
+	this returns. Thumbnails already handed out by Get() stay valid; they don't reference the source.
+ */
+void WaveformThumbnailer::Forget(WaveformBase* wfm)
+{
+	unique_lock<mutex> lock(m_mutex);
+	m_pending.erase(wfm);
+	m_cache.erase(wfm);
+	m_completionCvar.wait(lock, [this, wfm]{ return m_activeWaveform != wfm; });
+}
+
+///@brief Drops all requests and cached thumbnails, waiting out any render in flight
+void WaveformThumbnailer::clear()
+{
+	unique_lock<mutex> lock(m_mutex);
+	m_pending.clear();
+	m_cache.clear();
+	m_completionCvar.wait(lock, [this]{ return m_activeWaveform == nullptr; });
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Background rendering
+
+void WaveformThumbnailer::ThumbnailThread(WaveformThumbnailer* pThis)
+{
+	pThis->DoThumbnailThread();
+}
+
+void WaveformThumbnailer::DoThumbnailThread()
+{
+	#ifdef __linux__
+	pthread_setname_np(pthread_self(), "Thumbnail");
+	#endif
+
+	while(true)
+	{
+		WaveformBase* wfm;
+		{
+			unique_lock<mutex> lock(m_mutex);
+			m_workCvar.wait(lock, [this]{ return !m_pending.empty() || m_shuttingDown; });
+			if(m_shuttingDown)
+				return;
+
+			wfm = PopNextRequest();
+			m_activeWaveform = wfm;
+		}
+
+		//Render with the lock released, so requests keep flowing while we work
+		uint64_t revision = wfm->m_revision;
+		auto thumb = Render(wfm);
+
+		{
+			lock_guard<mutex> lock(m_mutex);
+			m_cache[wfm] = pair<uint64_t, shared_ptr<Thumbnail>>(revision, thumb);
+			m_activeWaveform = nullptr;
+		}
+		m_completionCvar.notify_all();
+	}
+}
+
+///@brief Removes and returns the highest priority pending request (call with m_mutex held)
+WaveformBase* WaveformThumbnailer::PopNextRequest()
+{
+	//The queue is small, so a linear scan beats maintaining a heap we'd have to re-key on priority updates
+	auto best = m_pending.begin();
+	for(auto it = m_pending.begin(); it != m_pending.end(); ++it)
+	{
+		if(it->second > best->second)
+			best = it;
+	}
+
+	auto wfm = best->first;
+	m_pending.erase(best);
+	return wfm;
+}
+
+/**
+	@brief Renders one thumbnail, preferring the pyramid path
+
+	@return The thumbnail, or null if the waveform type is unsupported or it has no samples
+ */
+shared_ptr<WaveformThumbnailer::Thumbnail> WaveformThumbnailer::Render(WaveformBase* wfm)
+{
+	size_t len = wfm->size();
+	if(len == 0)
+		return nullptr;
+
+	auto thumb = make_shared<Thumbnail>();
+	thumb->m_width = m_width;
+	thumb->m_revision = wfm->m_revision;
+	thumb->m_min.assign(m_width, FLT_MAX);
+	thumb->m_max.assign(m_width, -FLT_MAX);
+
+	auto ua = dynamic_cast<UniformAnalogWaveform*>(wfm);
+	auto sa = dynamic_cast<SparseAnalogWaveform*>(wfm);
+	auto ud = dynamic_cast<UniformDigitalWaveform*>(wfm);
+	auto sd = dynamic_cast<SparseDigitalWaveform*>(wfm);
+
+	//Pyramid path: only touches the coarsest useful level
+	bool rendered = ua && RenderFromPyramid(ua, len, *thumb);
+
+	//Direct paths: full reduction over the samples
+	if(!rendered)
+	{
+		if(ua || sa)
+		{
+			auto& samples = ua ? ua->m_samples : sa->m_samples;
+			samples.PrepareForCpuAccess();
+			for(size_t i=0; i<len; i++)
+			{
+				size_t col = i * m_width / len;
+				float v = samples[i];
+				thumb->m_min[col] = min(thumb->m_min[col], v);
+				thumb->m_max[col] = max(thumb->m_max[col], v);
+			}
+		}
+		else if(ud || sd)
+		{
+			auto& samples = ud ? ud->m_samples : sd->m_samples;
+			samples.PrepareForCpuAccess();
+			for(size_t i=0; i<len; i++)
+			{
+				size_t col = i * m_width / len;
+				float v = samples[i] ? 1 : 0;
+				thumb->m_min[col] = min(thumb->m_min[col], v);
+				thumb->m_max[col] = max(thumb->m_max[col], v);
+			}
+		}
+
+		//Protocol and density waveforms have no scalar envelope to render
+		else
+			return nullptr;
+	}
+
+	//Forward fill any empty columns (possible when the source has fewer samples than columns)
+	float lastmin = 0;
+	float lastmax = 0;
+	for(size_t j=0; j<m_width; j++)
+	{
+		if(thumb->m_min[j] > thumb->m_max[j])
+		{
+			thumb->m_min[j] = lastmin;
+			thumb->m_max[j] = lastmax;
+		}
+		else
+		{
+			lastmin = thumb->m_min[j];
+			lastmax = thumb->m_max[j];
+		}
+	}
+
+	return thumb;
+}
+
+/**
+	@brief Reduces the coarsest useful pyramid level into the thumbnail
+
+	@return True on success, false if the pyramid is missing, stale, or has no level coarse enough to
+			beat reading the samples directly
+ */
+bool WaveformThumbnailer::RenderFromPyramid(UniformWaveformBase* wfm, size_t len, Thumbnail& thumb)
+{
+	size_t samplesPerColumn = len / m_width;
+	if(samplesPerColumn < UniformWaveformBase::PYRAMID_RATIO)
+		return false;
+
+	auto level = wfm->GetPyramidLevel(samplesPerColumn);
+	if(!level)
+		return false;
+
+	size_t nlevel = level->m_min.size();
+	if(nlevel == 0)
+		return false;
+
+	level->m_min.PrepareForCpuAccess();
+	level->m_max.PrepareForCpuAccess();
+
+	for(size_t i=0; i<nlevel; i++)
+	{
+		size_t col = min(i * m_width / nlevel, m_width - 1);
+		thumb.m_min[col] = min(thumb.m_min[col], level->m_min[i]);
+		thumb.m_max[col] = max(thumb.m_max[col], level->m_max[i]);
+	}
+	return true;
+}
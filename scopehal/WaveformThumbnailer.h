@@ -0,0 +1,130 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Declaration of WaveformThumbnailer
+ */
+#ifndef WaveformThumbnailer_h
+#define WaveformThumbnailer_h
+
+#include "Waveform.h"
+
+#include <condition_variable>
+#include <map>
+#include <thread>
+
+/**
+	@brief Background renderer of small min/max overview thumbnails
+
+	Report generators and history browsers need an overview strip per past acquisition; rendering those on
+	demand from full-rate data means browsing 1000 history entries re-reads every sample ever captured. This
+	service renders fixed-width min/max envelopes on a background thread, from the waveform's decimation
+	pyramid when one is present (see WaveformPyramid) so only the coarsest useful level - never the full-rate
+	samples - gets touched. Waveforms without a pyramid (sparse, digital, or too short to have levels) fall
+	back to a direct reduction over their samples.
+
+	Requests carry a priority and the queue serves the highest first, so the entries currently on screen render
+	before the rest of a deep history. Thumbnails are cached against the source waveform's revision and handed
+	out as shared_ptrs, so a consumer may keep one alive after forgetting the entry it came from.
+
+	Forget() blocks until any in-flight render of that waveform finishes, so it is always safe to free a
+	waveform once Forget() has returned.
+ */
+class WaveformThumbnailer
+{
+public:
+	WaveformThumbnailer(size_t width = 256);
+	~WaveformThumbnailer();
+
+	//not copyable or assignable
+	WaveformThumbnailer(const WaveformThumbnailer&) =delete;
+	WaveformThumbnailer& operator=(const WaveformThumbnailer&) =delete;
+
+	///@brief A rendered overview: a per-column min/max envelope of the source waveform
+	struct Thumbnail
+	{
+		///@brief Number of columns
+		size_t m_width;
+
+		///@brief Revision of the source waveform this was rendered from
+		uint64_t m_revision;
+
+		///@brief Lowest sample value under each column
+		std::vector<float> m_min;
+
+		///@brief Highest sample value under each column
+		std::vector<float> m_max;
+	};
+
+	void Request(WaveformBase* wfm, int64_t priority = 0);
+	std::shared_ptr<Thumbnail> Get(WaveformBase* wfm);
+	void Forget(WaveformBase* wfm);
+	void clear();
+
+	///@brief Returns the width, in columns, of the thumbnails this service renders
+	size_t GetWidth()
+	{ return m_width; }
+
+protected:
+	static void ThumbnailThread(WaveformThumbnailer* pThis);
+	void DoThumbnailThread();
+	WaveformBase* PopNextRequest();
+
+	std::shared_ptr<Thumbnail> Render(WaveformBase* wfm);
+	bool RenderFromPyramid(UniformWaveformBase* wfm, size_t len, Thumbnail& thumb);
+
+	///@brief Width of rendered thumbnails, in columns
+	size_t m_width;
+
+	std::mutex m_mutex;
+
+	///@brief Pending requests and their priorities (higher renders first)
+	std::map<WaveformBase*, int64_t> m_pending;
+
+	///@brief Rendered thumbnails (null if the last attempt failed), keyed by source and gated by revision
+	std::map<WaveformBase*, std::pair<uint64_t, std::shared_ptr<Thumbnail>>> m_cache;
+
+	///@brief Waveform currently being rendered, if any (guarded by m_mutex)
+	WaveformBase* m_activeWaveform;
+
+	///@brief Wakes the worker when a request arrives or shutdown is flagged
+	std::condition_variable m_workCvar;
+
+	///@brief Signals completion of the in-flight render (for Forget() to wait on)
+	std::condition_variable m_completionCvar;
+
+	///@brief Set by the destructor to wind down the worker
+	bool m_shuttingDown;
+
+	std::unique_ptr<std::thread> m_thread;
+};
+
+#endif
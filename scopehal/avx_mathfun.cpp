@@ -553,5 +553,80 @@ void _mm256_sincos_ps(v8sf x, v8sf *s, v8sf *c)\
   *c = _mm256_xor_ps(xmm2, sign_bit_cos);
 }
 
+/* base 10 logarithm computed for 8 simultaneous float
+   return NaN for x <= 0
+*/
+__attribute__((target("avx2")))
+v8sf _mm256_log10_ps(v8sf x)
+{
+  _PS256_CONST(cephes_L10E, 0.434294481903251828);	// 1/ln(10)
+
+  return _mm256_mul_ps(_mm256_log_ps(x), _ps256_cephes_L10E);
+}
+
+/* four quadrant arctangent computed for 8 simultaneous float pairs
+
+   The core approximation is a degree 9 minimax polynomial for atan on [0, 1], applied to
+   min(|x|,|y|) / max(|x|,|y|) and then reflected into the correct octant and quadrant.
+   Maximum error vs libm atan2f is about 1e-6 rad.
+
+   Matches atan2f conventions at the edges we care about: atan2(0, 0) = 0,
+   atan2(+/-0, x<0) = +/-pi.
+*/
+__attribute__((target("avx2")))
+v8sf _mm256_atan2_ps(v8sf y, v8sf x)
+{
+  _PS256_CONST(atan_p0, 0.99997726);
+  _PS256_CONST(atan_p1, -0.33262347);
+  _PS256_CONST(atan_p2, 0.19354346);
+  _PS256_CONST(atan_p3, -0.11643287);
+  _PS256_CONST(atan_p4, 0.05265332);
+  _PS256_CONST(atan_p5, -0.01172120);
+  _PS256_CONST(cephes_PIF, 3.141592653589793238);
+  _PS256_CONST(cephes_PIO2F, 1.5707963267948966192);
+  _PS256_CONST_TYPE(sign_mask, int, (int)0x80000000);
+
+  v8sf signbit = _ps256_sign_mask;
+  v8sf ax = _mm256_andnot_ps(signbit, x);
+  v8sf ay = _mm256_andnot_ps(signbit, y);
+
+  // reduce to t = min/max in [0, 1] (0/0 makes a NaN here, fixed up at the end)
+  v8sf hi = _mm256_max_ps(ax, ay);
+  v8sf lo = _mm256_min_ps(ax, ay);
+  v8sf t = _mm256_div_ps(lo, hi);
+  v8sf z = _mm256_mul_ps(t, t);
+
+  // polynomial for atan(t), t in [0, 1]
+  v8sf r = _ps256_atan_p5;
+  r = _mm256_mul_ps(r, z);
+  r = _mm256_add_ps(r, _ps256_atan_p4);
+  r = _mm256_mul_ps(r, z);
+  r = _mm256_add_ps(r, _ps256_atan_p3);
+  r = _mm256_mul_ps(r, z);
+  r = _mm256_add_ps(r, _ps256_atan_p2);
+  r = _mm256_mul_ps(r, z);
+  r = _mm256_add_ps(r, _ps256_atan_p1);
+  r = _mm256_mul_ps(r, z);
+  r = _mm256_add_ps(r, _ps256_atan_p0);
+  r = _mm256_mul_ps(r, t);
+
+  // if |y| > |x| we computed atan(x/y), reflect across pi/4
+  v8sf swap_mask = _mm256_cmp_ps(ay, ax, _CMP_GT_OS);
+  r = _mm256_blendv_ps(r, _mm256_sub_ps(_ps256_cephes_PIO2F, r), swap_mask);
+
+  // left half plane: reflect across pi/2
+  v8sf xneg_mask = _mm256_cmp_ps(x, _mm256_setzero_ps(), _CMP_LT_OS);
+  r = _mm256_blendv_ps(r, _mm256_sub_ps(_ps256_cephes_PIF, r), xneg_mask);
+
+  // both inputs zero (including the NaN from 0/0): angle is zero
+  v8sf zero_mask = _mm256_cmp_ps(hi, _mm256_setzero_ps(), _CMP_EQ_OS);
+  r = _mm256_blendv_ps(r, _mm256_setzero_ps(), zero_mask);
+
+  // lower half plane: negate (the sign of y carries through for +/-0 as well)
+  r = _mm256_or_ps(r, _mm256_and_ps(y, signbit));
+
+  return r;
+}
+
 #endif /* __x86_64__ */
 
@@ -36,6 +36,7 @@
   * Fixed _PS256_CONST
   * Moved constants inside functions so we can handle compiling without -mavx2
   * Moved a bunch of implementation stuff to a source file
+  * Added log10 and atan2
 */
 
 #ifdef __x86_64__
@@ -61,6 +62,10 @@ __attribute__((target("avx2")))
 v8sf _mm256_cos_ps(v8sf);
 __attribute__((target("avx2")))
 void _mm256_sincos_ps(v8sf xx, v8sf*, v8sf*);
+__attribute__((target("avx2")))
+v8sf _mm256_log10_ps(v8sf);
+__attribute__((target("avx2")))
+v8sf _mm256_atan2_ps(v8sf y, v8sf x);
 
 /* declare some AVX constants -- why can't I figure a better way to do that? */
 
@@ -0,0 +1,217 @@
+/*
+   NEON implementation of sincos, log, log10 and atan2
+
+   Based on "neon_mathfun.h", by Julien Pommier
+   http://gruntthepeon.free.fr/ssemath/neon_mathfun.html
+
+   Copyright (C) 2011  Julien Pommier
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+
+  (this is the zlib license)
+*/
+
+#ifdef __ARM_NEON
+
+#include "neon_mathfun.h"
+
+/* natural logarithm computed for 4 simultaneous float
+   return NaN for x <= 0
+*/
+float32x4_t vlogq_f32(float32x4_t x)
+{
+  float32x4_t one = vdupq_n_f32(1);
+
+  x = vmaxq_f32(x, vdupq_n_f32(0)); /* force flush to zero on denormal values */
+  uint32x4_t invalid_mask = vcleq_f32(x, vdupq_n_f32(0));
+
+  int32x4_t ux = vreinterpretq_s32_f32(x);
+
+  int32x4_t emm0 = vshrq_n_s32(ux, 23);
+
+  /* keep only the fractional part */
+  ux = vandq_s32(ux, vdupq_n_s32(~0x7f800000));
+  ux = vorrq_s32(ux, vreinterpretq_s32_f32(vdupq_n_f32(0.5f)));
+  x = vreinterpretq_f32_s32(ux);
+
+  emm0 = vsubq_s32(emm0, vdupq_n_s32(0x7f));
+  float32x4_t e = vcvtq_f32_s32(emm0);
+
+  e = vaddq_f32(e, one);
+
+  /* part2:
+     if( x < SQRTHF ) {
+       e -= 1;
+       x = x + x - 1.0;
+     } else { x = x - 1.0; }
+  */
+  uint32x4_t mask = vcltq_f32(x, vdupq_n_f32(0.707106781186547524f));
+  float32x4_t tmp = vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(x), mask));
+  x = vsubq_f32(x, one);
+  e = vsubq_f32(e, vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(one), mask)));
+  x = vaddq_f32(x, tmp);
+
+  float32x4_t z = vmulq_f32(x, x);
+
+  float32x4_t y = vdupq_n_f32(7.0376836292E-2f);
+  y = vmlaq_f32(vdupq_n_f32(-1.1514610310E-1f), y, x);
+  y = vmlaq_f32(vdupq_n_f32(1.1676998740E-1f), y, x);
+  y = vmlaq_f32(vdupq_n_f32(-1.2420140846E-1f), y, x);
+  y = vmlaq_f32(vdupq_n_f32(1.4249322787E-1f), y, x);
+  y = vmlaq_f32(vdupq_n_f32(-1.6668057665E-1f), y, x);
+  y = vmlaq_f32(vdupq_n_f32(2.0000714765E-1f), y, x);
+  y = vmlaq_f32(vdupq_n_f32(-2.4999993993E-1f), y, x);
+  y = vmlaq_f32(vdupq_n_f32(3.3333331174E-1f), y, x);
+  y = vmulq_f32(y, x);
+
+  y = vmulq_f32(y, z);
+
+  y = vmlaq_f32(y, e, vdupq_n_f32(-2.12194440e-4f));
+
+  y = vmlsq_f32(y, z, vdupq_n_f32(0.5f));
+
+  x = vaddq_f32(x, y);
+  x = vmlaq_f32(x, e, vdupq_n_f32(0.693359375f));
+
+  /* negative arg will be NaN */
+  x = vreinterpretq_f32_u32(vorrq_u32(vreinterpretq_u32_f32(x), invalid_mask));
+  return x;
+}
+
+/* base 10 logarithm computed for 4 simultaneous float
+   return NaN for x <= 0
+*/
+float32x4_t vlog10q_f32(float32x4_t x)
+{
+  return vmulq_f32(vlogq_f32(x), vdupq_n_f32(0.434294481903251828f)); /* 1/ln(10) */
+}
+
+/* computes sin and cos of x for 4 simultaneous float */
+void vsincosq_f32(float32x4_t x, float32x4_t* ysin, float32x4_t* ycos)
+{
+  float32x4_t y;
+
+  uint32x4_t emm2;
+
+  uint32x4_t sign_mask_sin, sign_mask_cos;
+  sign_mask_sin = vcltq_f32(x, vdupq_n_f32(0));
+  x = vabsq_f32(x);
+
+  /* scale by 4/Pi */
+  y = vmulq_f32(x, vdupq_n_f32(1.27323954473516f));
+
+  /* store the integer part of y in mm0 */
+  emm2 = vcvtq_u32_f32(y);
+  /* j=(j+1) & (~1) (see the cephes sources) */
+  emm2 = vaddq_u32(emm2, vdupq_n_u32(1));
+  emm2 = vandq_u32(emm2, vdupq_n_u32(~1));
+  y = vcvtq_f32_u32(emm2);
+
+  /* get the polynom selection mask
+     there is one polynom for 0 <= x <= Pi/4
+     and another one for Pi/4<x<=Pi/2
+
+     Both branches will be computed.
+  */
+  uint32x4_t poly_mask = vtstq_u32(emm2, vdupq_n_u32(2));
+
+  /* The magic pass: "Extended precision modular arithmetic"
+     x = ((x - y * DP1) - y * DP2) - y * DP3; */
+  x = vmlaq_f32(x, y, vdupq_n_f32(-0.78515625f));
+  x = vmlaq_f32(x, y, vdupq_n_f32(-2.4187564849853515625e-4f));
+  x = vmlaq_f32(x, y, vdupq_n_f32(-3.77489497744594108e-8f));
+
+  sign_mask_sin = veorq_u32(sign_mask_sin, vtstq_u32(emm2, vdupq_n_u32(4)));
+  sign_mask_cos = vtstq_u32(vsubq_u32(emm2, vdupq_n_u32(2)), vdupq_n_u32(4));
+
+  /* Evaluate the first polynom  (0 <= x <= Pi/4) in y1,
+     and the second polynom      (Pi/4 <= x <= 0) in y2 */
+  float32x4_t z = vmulq_f32(x, x);
+  float32x4_t y1, y2;
+
+  y1 = vmlaq_f32(vdupq_n_f32(-1.388731625493765e-003f), z, vdupq_n_f32(2.443315711809948e-005f));
+  y2 = vmlaq_f32(vdupq_n_f32(8.3321608736e-3f), z, vdupq_n_f32(-1.9515295891e-4f));
+  y1 = vmlaq_f32(vdupq_n_f32(4.166664568298827e-002f), y1, z);
+  y2 = vmlaq_f32(vdupq_n_f32(-1.6666654611e-1f), y2, z);
+  y1 = vmulq_f32(y1, z);
+  y2 = vmulq_f32(y2, z);
+  y1 = vmulq_f32(y1, z);
+  y1 = vmlsq_f32(y1, z, vdupq_n_f32(0.5f));
+  y2 = vmlaq_f32(x, y2, x);
+  y1 = vaddq_f32(y1, vdupq_n_f32(1));
+
+  /* select the correct result from the two polynoms */
+  float32x4_t ys = vbslq_f32(poly_mask, y1, y2);
+  float32x4_t yc = vbslq_f32(poly_mask, y2, y1);
+  *ysin = vbslq_f32(sign_mask_sin, vnegq_f32(ys), ys);
+  *ycos = vbslq_f32(sign_mask_cos, yc, vnegq_f32(yc));
+}
+
+/* four quadrant arctangent computed for 4 simultaneous float pairs
+
+   Same algorithm as the AVX version in avx_mathfun.cpp: a degree 9 minimax polynomial
+   for atan on [0, 1], applied to min(|x|,|y|) / max(|x|,|y|) and reflected into the
+   correct octant and quadrant. Maximum error vs libm atan2f is about 1e-6 rad.
+*/
+float32x4_t vatan2q_f32(float32x4_t y, float32x4_t x)
+{
+  float32x4_t ax = vabsq_f32(x);
+  float32x4_t ay = vabsq_f32(y);
+
+  /* reduce to t = min/max in [0, 1] (0/0 makes a NaN here, fixed up at the end) */
+  float32x4_t hi = vmaxq_f32(ax, ay);
+  float32x4_t lo = vminq_f32(ax, ay);
+#ifdef __aarch64__
+  float32x4_t t = vdivq_f32(lo, hi);
+#else
+  /* armv7 has no vector divide: reciprocal estimate plus two Newton-Raphson steps */
+  float32x4_t recip = vrecpeq_f32(hi);
+  recip = vmulq_f32(recip, vrecpsq_f32(hi, recip));
+  recip = vmulq_f32(recip, vrecpsq_f32(hi, recip));
+  float32x4_t t = vmulq_f32(lo, recip);
+#endif
+  float32x4_t z = vmulq_f32(t, t);
+
+  /* polynomial for atan(t), t in [0, 1] */
+  float32x4_t r = vdupq_n_f32(-0.01172120f);
+  r = vmlaq_f32(vdupq_n_f32(0.05265332f), r, z);
+  r = vmlaq_f32(vdupq_n_f32(-0.11643287f), r, z);
+  r = vmlaq_f32(vdupq_n_f32(0.19354346f), r, z);
+  r = vmlaq_f32(vdupq_n_f32(-0.33262347f), r, z);
+  r = vmlaq_f32(vdupq_n_f32(0.99997726f), r, z);
+  r = vmulq_f32(r, t);
+
+  /* if |y| > |x| we computed atan(x/y), reflect across pi/4 */
+  uint32x4_t swap_mask = vcgtq_f32(ay, ax);
+  r = vbslq_f32(swap_mask, vsubq_f32(vdupq_n_f32(1.5707963267948966192f), r), r);
+
+  /* left half plane: reflect across pi/2 */
+  uint32x4_t xneg_mask = vcltq_f32(x, vdupq_n_f32(0));
+  r = vbslq_f32(xneg_mask, vsubq_f32(vdupq_n_f32(3.141592653589793238f), r), r);
+
+  /* both inputs zero (including the NaN from 0/0): angle is zero */
+  uint32x4_t zero_mask = vceqq_f32(hi, vdupq_n_f32(0));
+  r = vbslq_f32(zero_mask, vdupq_n_f32(0), r);
+
+  /* lower half plane: negate (the sign of y carries through for +/-0 as well) */
+  uint32x4_t sign = vandq_u32(vreinterpretq_u32_f32(y), vdupq_n_u32(0x80000000));
+  r = vreinterpretq_f32_u32(vorrq_u32(vreinterpretq_u32_f32(r), sign));
+
+  return r;
+}
+
+#endif /* __ARM_NEON */
@@ -0,0 +1,42 @@
+/*
+   NEON implementation of sincos, log, log10 and atan2
+
+   Based on "neon_mathfun.h", by Julien Pommier
+   http://gruntthepeon.free.fr/ssemath/neon_mathfun.html
+
+   Copyright (C) 2011  Julien Pommier
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+
+  (this is the zlib license)
+
+  Modified by A. Zonenberg:
+  * Split prototypes into a header, implementations in a source file
+  * Renamed functions to fit the ARM intrinsic naming schema
+  * Added log10 and atan2
+*/
+
+#ifdef __ARM_NEON
+
+#include <arm_neon.h>
+
+float32x4_t vlogq_f32(float32x4_t x);
+float32x4_t vlog10q_f32(float32x4_t x);
+void vsincosq_f32(float32x4_t x, float32x4_t* ysin, float32x4_t* ycos);
+float32x4_t vatan2q_f32(float32x4_t y, float32x4_t x);
+
+#endif /* __ARM_NEON */
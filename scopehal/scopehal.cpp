@@ -35,6 +35,12 @@
 #include "scopehal.h"
 #include "scopehal-version.h"
 #include <libgen.h>
+#ifdef __x86_64__
+#include <immintrin.h>
+#endif
+#ifdef __ARM_FEATURE_CRC32
+#include <arm_acle.h>
+#endif
 
 #include "AgilentOscilloscope.h"
 #include "HP662xAPowerSupply.h"
@@ -116,6 +122,7 @@ bool g_hasAvx512DQ = false;
 bool g_hasAvx512VL = false;
 bool g_hasAvx2 = false;
 bool g_hasFMA = false;
+bool g_hasPclmul = false;
 #endif
 
 #ifdef __APPLE__
@@ -145,7 +152,14 @@ void TransportStaticInit()
 #endif
 	AddTransportClass(SCPITwinLanTransport);
 	AddTransportClass(SCPIUARTTransport);
+
+	//Shared memory data plane requires POSIX shm
+#ifndef _WIN32
+	AddTransportClass(SCPIShmTransport);
+#endif
 	AddTransportClass(SCPINullTransport);
+	AddTransportClass(SCPIRecordTransport);
+	AddTransportClass(SCPIReplayTransport);
 	AddTransportClass(VICPSocketTransport);
 
 	//SocketCAN is a Linux-specific feature
@@ -159,6 +173,9 @@ void TransportStaticInit()
 #ifdef HAS_LINUXGPIB
 	AddTransportClass(SCPILinuxGPIBTransport);
 #endif
+#ifdef HAS_LIBURING
+	AddTransportClass(SCPIUringTransport);
+#endif
 }
 
 /**
@@ -176,9 +193,12 @@ void DetectCPUFeatures()
 	g_hasAvx512DQ = __builtin_cpu_supports("avx512dq");
 	g_hasAvx2 = __builtin_cpu_supports("avx2");
 	g_hasFMA = __builtin_cpu_supports("fma");
+	g_hasPclmul = __builtin_cpu_supports("pclmul") && __builtin_cpu_supports("sse4.1");
 
 	if(g_hasAvx2)
 		LogDebug("* AVX2\n");
+	if(g_hasPclmul)
+		LogDebug("* PCLMULQDQ\n");
 	if(g_hasFMA)
 		LogDebug("* FMA\n");
 	if(g_hasAvx512F)
@@ -548,6 +568,73 @@ string to_string_sci(double d)
 	return tmp;
 }
 
+/**
+	@brief Appends an integer to a string in decimal, equivalent to printf %ld but much faster
+
+	snprintf spends most of its time parsing the format string and handling locale; bulk exporters formatting
+	millions of values care.
+ */
+void AppendInt64(string& buf, int64_t n)
+{
+	uint64_t u;
+	if(n < 0)
+	{
+		buf += '-';
+		u = uint64_t(-(n + 1)) + 1;	//negate without overflowing on INT64_MIN
+	}
+	else
+		u = n;
+
+	//Emit digits least significant first, then reverse into place
+	char tmp[24];
+	int len = 0;
+	do
+	{
+		tmp[len ++] = '0' + (u % 10);
+		u /= 10;
+	} while(u != 0);
+	for(int i = len-1; i >= 0; i --)
+		buf += tmp[i];
+}
+
+/**
+	@brief Appends a float to a string in fixed point with six decimal places, matching printf %f output
+
+	Non-finite or very large values fall back to snprintf; everything else is formatted with pure integer math.
+ */
+void AppendFloatFixed(string& buf, float f)
+{
+	//Fall back to stdio for values the fast path can't represent exactly
+	double d = f;
+	if(!isfinite(d) || (fabs(d) >= 1e15))
+	{
+		char tmp[64];
+		snprintf(tmp, sizeof(tmp), "%f", d);
+		buf += tmp;
+		return;
+	}
+
+	if(d < 0)
+	{
+		buf += '-';
+		d = -d;
+	}
+
+	//Scale to an integer with six fractional digits, rounding to nearest (as %f does)
+	uint64_t scaled = static_cast<uint64_t>(d * 1e6 + 0.5);
+	AppendInt64(buf, scaled / 1000000);
+
+	//Fractional part, zero padded
+	uint64_t frac = scaled % 1000000;
+	char tmp[8] = {'.', '0', '0', '0', '0', '0', '0', '\0'};
+	for(int i = 6; i >= 1; i --)
+	{
+		tmp[i] = '0' + (frac % 10);
+		frac /= 10;
+	}
+	buf += tmp;
+}
+
 /**
 	@brief Like std::to_string, but output in hex
  */
@@ -938,25 +1025,212 @@ void CreateDirectory(const string& path)
 }
 #endif
 
+///@brief Lookup tables for the table-driven (slicing-by-8) CRC32 path
+static struct CRC32Tables
+{
+	CRC32Tables()
+	{
+		const uint32_t poly = 0xedb88320;
+		for(uint32_t i=0; i<256; i++)
+		{
+			uint32_t c = i;
+			for(int j=0; j<8; j++)
+				c = (c & 1) ? ( (c >> 1) ^ poly ) : (c >> 1);
+			m_tab[0][i] = c;
+		}
+		for(int k=1; k<8; k++)
+		{
+			for(uint32_t i=0; i<256; i++)
+				m_tab[k][i] = (m_tab[k-1][i] >> 8) ^ m_tab[0][m_tab[k-1][i] & 0xff];
+		}
+	}
+
+	uint32_t m_tab[8][256];
+} g_crc32Tables;
+
+/**
+	@brief Table-driven CRC32 core, processing eight bytes per step
+
+	Takes and returns the raw (inverted) shift register state so it can finish off the tail
+	left over by one of the hardware-accelerated paths.
+ */
+static uint32_t CRC32SliceBy8(const uint8_t* p, size_t len, uint32_t crc)
+{
+	auto& tab = g_crc32Tables.m_tab;
+
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+	while(len >= 8)
+	{
+		uint32_t lo;
+		uint32_t hi;
+		memcpy(&lo, p, 4);
+		memcpy(&hi, p+4, 4);
+		lo ^= crc;
+		crc =
+			tab[7][lo & 0xff] ^ tab[6][(lo >> 8) & 0xff] ^ tab[5][(lo >> 16) & 0xff] ^ tab[4][lo >> 24] ^
+			tab[3][hi & 0xff] ^ tab[2][(hi >> 8) & 0xff] ^ tab[1][(hi >> 16) & 0xff] ^ tab[0][hi >> 24];
+		p += 8;
+		len -= 8;
+	}
+#endif
+
+	while(len)
+	{
+		crc = (crc >> 8) ^ tab[0][(crc ^ *p) & 0xff];
+		p ++;
+		len --;
+	}
+
+	return crc;
+}
+
+#ifdef __x86_64__
+/**
+	@brief Carryless-multiply CRC32 core, folding 64 bytes per iteration
+
+	Implements the bit-reflected folding scheme from the Intel whitepaper "Fast CRC Computation for Generic
+	Polynomials Using PCLMULQDQ Instruction" for the Ethernet polynomial.
+
+	len must be at least 64 and a multiple of 16; takes and returns the raw (inverted) shift register state.
+ */
+__attribute__((target("pclmul,sse4.1")))
+static uint32_t CRC32Pclmul(const uint8_t* buf, size_t len, uint32_t crc)
+{
+	//Bit-reflected folding constants and Barrett reduction polynomials from the whitepaper
+	alignas(16) static const uint64_t k1k2[] = { 0x0154442bd4, 0x01c6e41596 };
+	alignas(16) static const uint64_t k3k4[] = { 0x01751997d0, 0x00ccaa009e };
+	alignas(16) static const uint64_t k5k0[] = { 0x0163cd6124, 0x0000000000 };
+	alignas(16) static const uint64_t poly[] = { 0x01db710641, 0x01f7011641 };
+
+	__m128i x0, x1, x2, x3, x4, x5, x6, x7, x8, y5, y6, y7, y8;
+
+	//Load the first block of 64 and mix in the initial CRC
+	x1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(buf + 0x00));
+	x2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(buf + 0x10));
+	x3 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(buf + 0x20));
+	x4 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(buf + 0x30));
+	x1 = _mm_xor_si128(x1, _mm_cvtsi32_si128(crc));
+
+	x0 = _mm_load_si128(reinterpret_cast<const __m128i*>(k1k2));
+	buf += 64;
+	len -= 64;
+
+	//Fold blocks of 64 in parallel
+	while(len >= 64)
+	{
+		x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+		x6 = _mm_clmulepi64_si128(x2, x0, 0x00);
+		x7 = _mm_clmulepi64_si128(x3, x0, 0x00);
+		x8 = _mm_clmulepi64_si128(x4, x0, 0x00);
+
+		x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+		x2 = _mm_clmulepi64_si128(x2, x0, 0x11);
+		x3 = _mm_clmulepi64_si128(x3, x0, 0x11);
+		x4 = _mm_clmulepi64_si128(x4, x0, 0x11);
+
+		y5 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(buf + 0x00));
+		y6 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(buf + 0x10));
+		y7 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(buf + 0x20));
+		y8 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(buf + 0x30));
+
+		x1 = _mm_xor_si128(_mm_xor_si128(x1, x5), y5);
+		x2 = _mm_xor_si128(_mm_xor_si128(x2, x6), y6);
+		x3 = _mm_xor_si128(_mm_xor_si128(x3, x7), y7);
+		x4 = _mm_xor_si128(_mm_xor_si128(x4, x8), y8);
+
+		buf += 64;
+		len -= 64;
+	}
+
+	//Fold the four lanes down to one
+	x0 = _mm_load_si128(reinterpret_cast<const __m128i*>(k3k4));
+
+	x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+	x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+	x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+
+	x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+	x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+	x1 = _mm_xor_si128(_mm_xor_si128(x1, x3), x5);
+
+	x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+	x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+	x1 = _mm_xor_si128(_mm_xor_si128(x1, x4), x5);
+
+	//Fold any remaining blocks of 16
+	while(len >= 16)
+	{
+		x2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(buf));
+
+		x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+		x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+		x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+
+		buf += 16;
+		len -= 16;
+	}
+
+	//Fold 128 bits to 64
+	x2 = _mm_clmulepi64_si128(x1, x0, 0x10);
+	x3 = _mm_setr_epi32(~0, 0, ~0, 0);
+	x1 = _mm_srli_si128(x1, 8);
+	x1 = _mm_xor_si128(x1, x2);
+
+	x0 = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(k5k0));
+
+	x2 = _mm_srli_si128(x1, 4);
+	x1 = _mm_and_si128(x1, x3);
+	x1 = _mm_clmulepi64_si128(x1, x0, 0x00);
+	x1 = _mm_xor_si128(x1, x2);
+
+	//Barrett reduce to 32 bits
+	x0 = _mm_load_si128(reinterpret_cast<const __m128i*>(poly));
+
+	x2 = _mm_and_si128(x1, x3);
+	x2 = _mm_clmulepi64_si128(x2, x0, 0x10);
+	x2 = _mm_and_si128(x2, x3);
+	x2 = _mm_clmulepi64_si128(x2, x0, 0x00);
+	x1 = _mm_xor_si128(x1, x2);
+
+	return _mm_extract_epi32(x1, 1);
+}
+#endif
+
 /**
 	@brief Calculates a CRC32 checksum using the standard Ethernet polynomial
+
+	Uses PCLMULQDQ folding (x86) or the ARMv8 CRC32 extension when available, with a table-driven
+	fallback for older hardware and for the unaligned tail of a block.
  */
 uint32_t CRC32(const uint8_t* bytes, size_t start, size_t end)
 {
-	uint32_t poly = 0xedb88320;
+	const uint8_t* p = bytes + start;
+	size_t len = (end + 1) - start;
 
 	uint32_t crc = 0xffffffff;
-	for(size_t n=start; n <= end; n++)
+
+#if defined(__x86_64__)
+	//Carryless-multiply folding works on 16-byte blocks and needs at least one block of 64 to spin up
+	if(g_hasPclmul && (len >= 64))
 	{
-		uint8_t d = bytes[n];
-		for(int i=0; i<8; i++)
-		{
-			bool b = ( crc ^ (d >> i) ) & 1;
-			crc >>= 1;
-			if(b)
-				crc ^= poly;
-		}
+		size_t lenFolded = len & ~static_cast<size_t>(0xf);
+		crc = CRC32Pclmul(p, lenFolded, crc);
+		p += lenFolded;
+		len -= lenFolded;
 	}
+#elif defined(__ARM_FEATURE_CRC32)
+	//The ARMv8 CRC32 extension implements this exact (bit-reflected Ethernet) polynomial in hardware
+	while(len >= 8)
+	{
+		uint64_t tmp;
+		memcpy(&tmp, p, 8);
+		crc = __crc32d(crc, tmp);
+		p += 8;
+		len -= 8;
+	}
+#endif
+
+	crc = CRC32SliceBy8(p, len, crc);
 
 	return ~(	((crc & 0x000000ff) << 24) |
 				((crc & 0x0000ff00) << 8) |
@@ -969,6 +1243,28 @@ uint32_t CRC32(const vector<uint8_t>& bytes)
 	return CRC32(&bytes[0], 0, bytes.size()-1);
 }
 
+/**
+	@brief Descrambles one 64-bit block of a 64b/66b coded stream (x^58 + x^39 + 1, self synchronizing)
+
+	Equivalent to shifting the scrambled bits through the reference LFSR one at a time, but computed as whole-word
+	shifts and XORs: each output bit is the input bit XORed with the raw input bits 39 and 58 positions earlier,
+	so a full block of taps can be read directly from the current block and the previous one.
+
+	@param block	64 scrambled bits, first bit on the wire in the LSB
+	@param history	The previous scrambled block (zero at start of stream); updated on return
+
+	@return The descrambled block, first bit in the LSB
+ */
+uint64_t Descramble64b66b(uint64_t block, uint64_t& history)
+{
+	uint64_t ret =
+		block ^
+		(block << 39) ^ (history >> 25) ^
+		(block << 58) ^ (history >> 6);
+	history = block;
+	return ret;
+}
+
 /**
 	@brief Returns the library version string (Semantic Version formatted)
  */
@@ -78,12 +78,14 @@ extern bool g_hasAvx512F;
 extern bool g_hasAvx512VL;
 extern bool g_hasAvx512DQ;
 extern bool g_hasAvx2;
+extern bool g_hasPclmul;
 #endif
 
 //Enable flags for various features
 extern bool g_gpuFilterEnabled;
 extern bool g_gpuScopeDriverEnabled;
 extern bool g_hasShaderFloat64;
+extern bool g_hasShaderFloat16;
 extern bool g_hasShaderInt64;
 extern bool g_hasShaderInt16;
 extern bool g_hasShaderInt8;
@@ -91,23 +93,36 @@ extern bool g_hasShaderAtomicFloat;
 extern bool g_hasDebugUtils;
 extern bool g_hasMemoryBudget;
 extern bool g_hasPushDescriptor;
+extern bool g_hasTimestampQueries;
+extern bool g_hasTimelineSemaphore;
 
 extern size_t g_maxComputeGroupCount[3];
 
+///@brief Nanoseconds per tick of the GPU timestamp counter (only valid if g_hasTimestampQueries is set)
+extern float g_vkTimestampPeriod;
+
 #include "Unit.h"
 #include "Bijection.h"
 #include "IDTable.h"
+#include "ProtocolStateTable.h"
+#include "TextScan.h"
+
+#include "PerfCounter.h"
 
 #include "AcceleratorBuffer.h"
 #include "ComputePipeline.h"
 
 #include "SCPITransport.h"
 #include "SCPISocketTransport.h"
+#include "SCPIShmTransport.h"
 #include "SCPITwinLanTransport.h"
 #include "SCPILinuxGPIBTransport.h"
 #include "SCPILxiTransport.h"
 #include "SCPINullTransport.h"
+#include "SCPIRecordTransport.h"
+#include "SCPIReplayTransport.h"
 #include "SCPIUARTTransport.h"
+#include "SCPIUringTransport.h"
 #include "VICPSocketTransport.h"
 #include "SCPIDevice.h"
 #ifdef __linux
@@ -161,6 +176,12 @@ extern size_t g_maxComputeGroupCount[3];
 #include "SParameters.h"
 #include "TouchstoneParser.h"
 #include "IBISParser.h"
+#include "WaveformFile.h"
+#include "WaveformDeltaCodec.h"
+#include "WaveformHistory.h"
+#include "WaveformThumbnailer.h"
+#include "MemoryGovernor.h"
+#include "TriggerAlignmentCache.h"
 
 #include "FilterParameter.h"
 #include "Filter.h"
@@ -170,9 +191,14 @@ extern size_t g_maxComputeGroupCount[3];
 #include "SParameterSourceFilter.h"
 #include "SParameterFilter.h"
 
+#include "DecodeCache.h"
+#include "FilterCostModel.h"
 #include "FilterGraphExecutor.h"
+#include "RemoteFilterGraph.h"
+#include "PolyphaseResampler.h"
 
 #include "QueueManager.h"
+#include "VectorMath.h"
 
 uint64_t ConvertVectorSignalToScalar(const std::vector<bool>& bits);
 
@@ -191,10 +217,14 @@ void GetTimestampOfFile(std::string path, time_t& timestamp, int64_t& fs);
 std::string to_string_sci(double d);
 std::string to_string_hex(uint64_t n, bool zeropad = false, int len = 0);
 
+void AppendFloatFixed(std::string& buf, float f);
+void AppendInt64(std::string& buf, int64_t n);
+
 void TransportStaticInit();
 void DriverStaticInit();
 
 bool VulkanInit(bool skipGLFW = false);
+void AddVulkanCleanupCallback(std::function<void()> cb);
 void InitializeSearchPaths();
 void InitializePlugins();
 void DetectCPUFeatures();
@@ -233,12 +263,33 @@ struct ConvertRawSamplesShaderArgs
 	float offset;
 };
 
+///@brief Arguments to the ConvertInterleaved*Samples shaders (must match layout in the GLSL)
+struct ConvertInterleavedSamplesShaderArgs
+{
+	uint32_t size;
+	uint32_t outbase;
+	float gain;
+	float offset;
+};
+
+///@brief Maximum number of stages in a fused elementwise filter chain (must match ElementwiseChain.glsl)
+#define ELEMENTWISE_CHAIN_MAX_OPS 8
+
+struct ElementwiseChainShaderArgs
+{
+	uint32_t size;
+	uint32_t numOps;
+	uint32_t op[ELEMENTWISE_CHAIN_MAX_OPS];
+	float operand[ELEMENTWISE_CHAIN_MAX_OPS];
+};
+
 //Vulkan global stuff
 extern vk::raii::Context g_vkContext;
 extern std::unique_ptr<vk::raii::Instance> g_vkInstance;
 extern uint8_t g_vkComputeDeviceUuid[16];
 extern uint32_t g_vkComputeDeviceDriverVer;
 extern vk::raii::PhysicalDevice* g_vkComputePhysicalDevice;
+extern std::vector<vk::raii::PhysicalDevice*> g_vkComputeCapableDevices;
 extern std::unique_ptr<QueueManager> g_vkQueueManager;
 extern bool g_vulkanDeviceIsIntelMesa;
 extern bool g_vulkanDeviceIsAnyMesa;
@@ -249,6 +300,10 @@ extern bool g_vulkanDeviceHasUnifiedMemory;
 
 uint32_t GetComputeBlockCount(size_t numGlobal, size_t blockSize);
 
+//Included here (rather than with the other class headers) since it needs the shader arg structs and
+//compute helpers declared above
+#include "RawSampleConverter.h"
+
 //Validation helper for templates
 //Throws compile-time error if specialized for false since there's no implementation
 template<bool> class CompileTimeAssert;
@@ -265,6 +320,9 @@ void CreateDirectory(const std::string& path);
 uint32_t CRC32(const uint8_t* bytes, size_t start, size_t end);
 uint32_t CRC32(const std::vector<uint8_t>& bytes);
 
+//Scrambler helpers
+uint64_t Descramble64b66b(uint64_t block, uint64_t& history);
+
 uint32_t ColorFromString(const std::string& str, unsigned int alpha = 255);
 
 const char* ScopehalGetVersion();
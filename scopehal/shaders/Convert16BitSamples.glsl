@@ -48,7 +48,8 @@ layout(std430, push_constant) uniform constants
 	float offset;
 };
 
-layout(local_size_x=64, local_size_y=1, local_size_z=1) in;
+//Workgroup width is specializable so RawSampleConverter can apply the per-device tuned size
+layout(local_size_x=64, local_size_x_id=0, local_size_y=1, local_size_z=1) in;
 
 void main()
 {
@@ -0,0 +1,70 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopeprotocols                                                                                                    *
+*                                                                                                                      *
+* Copyright (c) 2012-2023 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+#version 430
+#pragma shader_stage(compute)
+#extension GL_EXT_shader_16bit_storage : require
+
+layout(std430, binding=0) restrict writeonly buffer buf_iout
+{
+	float iout[];
+};
+
+layout(std430, binding=1) restrict writeonly buffer buf_qout
+{
+	float qout[];
+};
+
+layout(std430, binding=2) restrict readonly buffer buf_pin
+{
+	int16_t pin[];
+};
+
+layout(std430, push_constant) uniform constants
+{
+	uint size;
+	uint outbase;
+	float gain;
+	float offset;
+};
+
+//Workgroup width is specializable so RawSampleConverter can apply the per-device tuned size
+layout(local_size_x=64, local_size_x_id=0, local_size_y=1, local_size_z=1) in;
+
+//De-interleaves one chunk of IQ pairs: pin holds the chunk only, outputs are indexed from outbase
+//so a large recording can be streamed through a bounded staging buffer
+void main()
+{
+	if(gl_GlobalInvocationID.x >= size)
+		return;
+
+	uint i = gl_GlobalInvocationID.x;
+	iout[outbase + i] = gain*float(int(pin[i*2])) - offset;
+	qout[outbase + i] = gain*float(int(pin[i*2 + 1])) - offset;
+}
@@ -0,0 +1,93 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+//Applies a short program of elementwise operations to a waveform in a single pass,
+//so a fused chain of elementwise filters only reads and writes sample memory once.
+//Opcodes and MAX_OPS must match Filter::ElementwiseOperation / ELEMENTWISE_CHAIN_MAX_OPS.
+
+#version 430
+#pragma shader_stage(compute)
+
+#define OP_ADD		0
+#define OP_MULTIPLY	1
+#define OP_MIN		2
+#define OP_MAX		3
+
+#define MAX_OPS		8
+
+layout(std430, binding=0) restrict readonly buffer buf_pin
+{
+	float pin[];
+};
+
+layout(std430, binding=1) restrict writeonly buffer buf_pout
+{
+	float pout[];
+};
+
+layout(std430, push_constant) uniform constants
+{
+	uint size;
+	uint numOps;
+	uint op[MAX_OPS];
+	float operand[MAX_OPS];
+};
+
+layout(local_size_x=64, local_size_y=1, local_size_z=1) in;
+
+void main()
+{
+	if(gl_GlobalInvocationID.x >= size)
+		return;
+
+	float v = pin[gl_GlobalInvocationID.x];
+	for(uint i=0; i<numOps; i++)
+	{
+		switch(op[i])
+		{
+			case OP_ADD:
+				v += operand[i];
+				break;
+
+			case OP_MULTIPLY:
+				v *= operand[i];
+				break;
+
+			case OP_MIN:
+				v = min(v, operand[i]);
+				break;
+
+			case OP_MAX:
+				v = max(v, operand[i]);
+				break;
+		}
+	}
+
+	pout[gl_GlobalInvocationID.x] = v;
+}
@@ -0,0 +1,98 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+#version 430
+#pragma shader_stage(compute)
+
+layout(std430, binding=0) restrict readonly buffer buf_din
+{
+	float din[];
+};
+
+//Slot 0 is the candidate count, slots 1 ... maxCandidates are candidate bin indices
+layout(std430, binding=1) buffer buf_candidates
+{
+	uint candidates[];
+};
+
+layout(std430, binding=2) restrict writeonly buffer buf_blockmin
+{
+	float blockmin[];
+};
+
+layout(std430, push_constant) uniform constants
+{
+	uint size;
+	uint searchRad;
+	uint minIdx;
+	uint maxCandidates;
+};
+
+layout(local_size_x=64, local_size_y=1, local_size_z=1) in;
+
+shared float minvals[64];
+
+void main()
+{
+	uint i = gl_GlobalInvocationID.x;
+	uint lid = gl_LocalInvocationID.x;
+
+	//Workgroup reduction of the global minimum
+	//(the host finishes the reduction over the per-block results and uses it as the FWHM baseline)
+	minvals[lid] = (i < size) ? din[i] : 3.402823466e38;
+	for(uint stride = 32; stride > 0; stride >>= 1)
+	{
+		barrier();
+		if(lid < stride)
+			minvals[lid] = min(minvals[lid], minvals[lid + stride]);
+	}
+	if(lid == 0)
+		blockmin[gl_WorkGroupID.x] = minvals[0];
+
+	//A bin is a candidate peak iff nothing else in the search window is >= it
+	//(same test as the CPU implementation in PeakDetector::FindPeaks, minus the sequential-skip optimizations)
+	if( (i < minIdx) || (i >= size) )
+		return;
+
+	float target = din[i];
+	uint left = (i >= minIdx + searchRad) ? (i - searchRad) : minIdx;
+	uint right = min(i + searchRad, size - 1);
+	for(uint j = left; j <= right; j++)
+	{
+		if(j == i)
+			continue;
+		if(din[j] >= target)
+			return;
+	}
+
+	//Compact the candidate into the output list
+	uint slot = atomicAdd(candidates[0], 1);
+	if(slot < maxCandidates)
+		candidates[slot + 1] = i;
+}
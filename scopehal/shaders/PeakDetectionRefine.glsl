@@ -0,0 +1,115 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+#version 430
+#pragma shader_stage(compute)
+
+//Must match PeakRefinementResult in PeakDetectionFilter.h
+struct RefinedPeak
+{
+	uint idx;
+	float y;
+	float num;
+	float den;
+	uint hmleft;
+	uint hmright;
+};
+
+layout(std430, binding=0) restrict readonly buffer buf_din
+{
+	float din[];
+};
+
+//Slot 0 is the candidate count, slots 1 ... maxCandidates are candidate bin indices
+layout(std430, binding=1) restrict readonly buffer buf_candidates
+{
+	uint candidates[];
+};
+
+layout(std430, binding=2) restrict writeonly buffer buf_refined
+{
+	RefinedPeak refined[];
+};
+
+layout(std430, push_constant) uniform constants
+{
+	uint size;
+	uint numCandidates;
+	uint fineRad;
+	float baseline;
+};
+
+layout(local_size_x=64, local_size_y=1, local_size_z=1) in;
+
+void main()
+{
+	uint n = gl_GlobalInvocationID.x;
+	if(n >= numCandidates)
+		return;
+
+	uint i = candidates[n + 1];
+	float target = din[i];
+
+	//Do a weighted average of our immediate neighbors to fine tune the position.
+	//Sums are accumulated relative to bin i to keep them small; the host converts back to absolute bins.
+	uint left = (i > fineRad) ? (i - fineRad) : 1;
+	uint right = min(i + fineRad, size - 1);
+	float num = 0;
+	float den = 0;
+	for(uint j = left; j <= right; j++)
+	{
+		num += din[j] * (float(j) - float(i));
+		den += din[j];
+	}
+
+	//Move left and right from the peak until we get half magnitude
+	float hmtarget = (target - baseline)/2 + baseline;
+	uint hmleft = i;
+	uint hmright = i;
+	for(uint j = i; ; j--)
+	{
+		if(din[j] <= hmtarget)
+		{
+			hmleft = j;
+			break;
+		}
+		if(j == 0)
+			break;
+	}
+	for(uint j = i; j < size; j++)
+	{
+		if(din[j] <= hmtarget)
+		{
+			hmright = j;
+			break;
+		}
+	}
+
+	refined[n] = RefinedPeak(i, target, num, den, hmleft, hmright);
+}
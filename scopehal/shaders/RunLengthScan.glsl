@@ -0,0 +1,91 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+//First pass of run-length compaction: flag run boundaries and scan them within each workgroup.
+//The host finishes the scan over the per-block totals, then RunLengthScatter writes the packed output.
+
+#version 430
+#pragma shader_stage(compute)
+#extension GL_EXT_shader_8bit_storage : require
+
+layout(std430, binding=0) restrict readonly buffer buf_din
+{
+	uint8_t din[];
+};
+
+//Exclusive prefix sum of boundary flags within this sample's workgroup
+layout(std430, binding=1) restrict writeonly buffer buf_localScan
+{
+	uint localScan[];
+};
+
+//Number of run boundaries in each workgroup's block
+layout(std430, binding=2) restrict writeonly buffer buf_blockSums
+{
+	uint blockSums[];
+};
+
+layout(std430, push_constant) uniform constants
+{
+	uint size;
+};
+
+layout(local_size_x=256, local_size_y=1, local_size_z=1) in;
+
+shared uint sdata[256];
+
+void main()
+{
+	uint i = gl_GlobalInvocationID.x;
+	uint lid = gl_LocalInvocationID.x;
+
+	//A sample starts a new run iff it differs from its predecessor (sample 0 always does)
+	uint flag = 0;
+	if(i < size)
+		flag = ( (i == 0) || (uint(din[i]) != uint(din[i-1])) ) ? 1 : 0;
+	sdata[lid] = flag;
+
+	//Hillis-Steele inclusive scan over the workgroup
+	for(uint stride=1; stride < 256; stride <<= 1)
+	{
+		barrier();
+		uint v = (lid >= stride) ? sdata[lid - stride] : 0;
+		barrier();
+		sdata[lid] += v;
+	}
+	barrier();
+
+	//Convert to an exclusive scan for the scatter pass
+	if(i < size)
+		localScan[i] = sdata[lid] - flag;
+
+	//Last element of the inclusive scan is the block total
+	if(lid == 0)
+		blockSums[gl_WorkGroupID.x] = sdata[255];
+}
@@ -0,0 +1,84 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+//Second pass of run-length compaction: scatter each run's start offset and value to its final slot,
+//computed from the per-block scan (RunLengthScan) plus the host-scanned block bases.
+
+#version 430
+#pragma shader_stage(compute)
+#extension GL_EXT_shader_8bit_storage : require
+#extension GL_EXT_shader_explicit_arithmetic_types_int64 : require
+
+layout(std430, binding=0) restrict readonly buffer buf_din
+{
+	uint8_t din[];
+};
+
+layout(std430, binding=1) restrict readonly buffer buf_localScan
+{
+	uint localScan[];
+};
+
+//Exclusive prefix sum of the per-block boundary counts (computed on the host)
+layout(std430, binding=2) restrict readonly buffer buf_blockBases
+{
+	uint blockBases[];
+};
+
+layout(std430, binding=3) restrict writeonly buffer buf_offsets
+{
+	int64_t offsets[];
+};
+
+layout(std430, binding=4) restrict writeonly buffer buf_samples
+{
+	uint8_t samples[];
+};
+
+layout(std430, push_constant) uniform constants
+{
+	uint size;
+};
+
+layout(local_size_x=256, local_size_y=1, local_size_z=1) in;
+
+void main()
+{
+	uint i = gl_GlobalInvocationID.x;
+	if(i >= size)
+		return;
+
+	//Only run boundaries produce output
+	if( (i != 0) && (uint(din[i]) == uint(din[i-1])) )
+		return;
+
+	uint slot = blockBases[gl_WorkGroupID.x] + localScan[i];
+	offsets[slot] = int64_t(i);
+	samples[slot] = din[i];
+}
@@ -0,0 +1,87 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+//Packs sparse waveform timestamps into the base-plus-uint32-delta at-rest form (SparseMetadataPacker).
+//Any delta that overflows 32 bits raises the status flag; the host then discards the output.
+
+#version 430
+#pragma shader_stage(compute)
+#extension GL_EXT_shader_explicit_arithmetic_types_int64 : require
+
+layout(std430, binding=0) restrict readonly buffer buf_offsets
+{
+	int64_t offsets[];
+};
+
+layout(std430, binding=1) restrict readonly buffer buf_durations
+{
+	int64_t durations[];
+};
+
+layout(std430, binding=2) restrict writeonly buffer buf_packedOffsets
+{
+	uint packedOffsets[];
+};
+
+layout(std430, binding=3) restrict writeonly buffer buf_packedDurations
+{
+	uint packedDurations[];
+};
+
+//[0] = base timestamp, [1] = overflow flag (all writers store the same value, so plain stores are fine)
+layout(std430, binding=4) restrict buffer buf_status
+{
+	int64_t status[];
+};
+
+layout(std430, push_constant) uniform constants
+{
+	uint size;
+};
+
+layout(local_size_x=64, local_size_y=1, local_size_z=1) in;
+
+void main()
+{
+	uint i = gl_GlobalInvocationID.x;
+	if(i >= size)
+		return;
+
+	int64_t base = offsets[0];
+	if(i == 0)
+		status[0] = base;
+
+	int64_t doff = offsets[i] - base;
+	int64_t dur = durations[i];
+	if( (doff > int64_t(0xfffffffful)) || (dur > int64_t(0xfffffffful)) || (dur < int64_t(0)) )
+		status[1] = int64_t(1);
+
+	packedOffsets[i] = uint(doff);
+	packedDurations[i] = uint(dur);
+}
@@ -92,28 +92,17 @@ void ACRMSMeasurement::Refresh()
 	SetYAxisUnits(m_inputs[0].GetYAxisUnits(), 0);
 	SetYAxisUnits(m_inputs[0].GetYAxisUnits(), 1);
 
-	float average = GetAvgVoltage(sadin, uadin);
 	auto length = din->size();
 
-	//Calculate the global RMS value
-	//Sum the squares of all values after subtracting the DC value
-	float temp = 0;
-	if(uadin)
-	{
-		for (size_t i = 0; i < length; i++)
-			temp += ((uadin->m_samples[i] - average) * (uadin->m_samples[i] - average));
-	}
-	else if(sadin)
-	{
-		for (size_t i = 0; i < length; i++)
-			temp += ((sadin->m_samples[i] - average) * (sadin->m_samples[i] - average));
-	}
-
-	//Divide by total number of samples and take the square root to get the final AC RMS
-	m_streams[1].m_value = sqrt(temp / length);
+	//Calculate the global AC RMS value from the fused single-pass statistics
+	//(shared with any other measurements of this waveform in the same pass):
+	//sum((x - avg)^2) / n = sum(x^2)/n - avg^2
+	auto stats = GetWaveformStats(sadin, uadin);
+	float average = stats.m_sum / stats.m_count;
+	m_streams[1].m_value = sqrt(max(0.0, (stats.m_sumSquares / length) - (double)average*average));
 
 	//Now we can do the cycle-by-cycle value
-	temp = 0;
+	float temp = 0;
 	vector<int64_t> edges;
 
 	//Auto-threshold analog signals at average of the full scale range
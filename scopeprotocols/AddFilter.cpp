@@ -73,13 +73,30 @@ string AddFilter::GetProtocolName()
 	return "Add";
 }
 
+bool AddFilter::GetElementwiseOperation(ElementwiseOperation& op)
+{
+	//Only the scalar + vector configuration is a simple elementwise transform
+	//(vector + vector reads two waveforms, scalar + scalar produces no waveform at all)
+	bool veca = GetInput(0).GetType() == Stream::STREAM_TYPE_ANALOG;
+	bool vecb = GetInput(1).GetType() == Stream::STREAM_TYPE_ANALOG;
+	if(veca == vecb)
+		return false;
+
+	op.m_op = ElementwiseOperation::OP_ADD;
+	op.m_operand = GetInput(veca ? 1 : 0).GetScalarValue();
+	return true;
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Actual decoder logic
 
 void AddFilter::Refresh(vk::raii::CommandBuffer& cmdBuf, shared_ptr<QueueHandle> queue)
 {
-	bool veca = GetInput(0).GetType() == Stream::STREAM_TYPE_ANALOG;
-	bool vecb = GetInput(1).GetType() == Stream::STREAM_TYPE_ANALOG;
+	//Snapshot the inputs once up front (no-op cost if the executor already did it at pass setup)
+	ResolveInputWaveforms();
+
+	bool veca = GetResolvedInput(0).m_type == Stream::STREAM_TYPE_ANALOG;
+	bool vecb = GetResolvedInput(1).m_type == Stream::STREAM_TYPE_ANALOG;
 
 	if(veca && vecb)
 		DoRefreshVectorVector(cmdBuf, queue);
@@ -99,15 +116,15 @@ void AddFilter::DoRefreshScalarScalar()
 	//Add value
 	//TODO: how to handle unequal units?
 	m_streams[0].m_yAxisUnit = GetInput(0).GetYAxisUnits();
-	m_streams[0].m_value = GetInput(0).GetScalarValue() + GetInput(1).GetScalarValue();
+	m_streams[0].m_value = GetResolvedInput(0).m_scalarValue + GetResolvedInput(1).m_scalarValue;
 }
 
 void AddFilter::DoRefreshScalarVector(size_t iScalar, size_t iVector)
 {
 	m_streams[0].m_stype = Stream::STREAM_TYPE_ANALOG;
 
-	float scale = GetInput(iScalar).GetScalarValue();
-	auto din = GetInputWaveform(iVector);
+	float scale = GetResolvedInput(iScalar).m_scalarValue;
+	auto din = GetResolvedInputWaveform(iVector);
 	if(!din)
 	{
 		SetData(nullptr, 0);
@@ -159,8 +176,8 @@ void AddFilter::DoRefreshVectorVector(vk::raii::CommandBuffer& cmdBuf, std::shar
 	}
 
 	//Get inputs
-	auto din_p = GetInputWaveform(0);
-	auto din_n = GetInputWaveform(1);
+	auto din_p = GetResolvedInputWaveform(0);
+	auto din_n = GetResolvedInputWaveform(1);
 	auto sdin_p = dynamic_cast<SparseAnalogWaveform*>(din_p);
 	auto sdin_n = dynamic_cast<SparseAnalogWaveform*>(din_n);
 	auto udin_p = dynamic_cast<UniformAnalogWaveform*>(din_p);
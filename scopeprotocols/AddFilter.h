@@ -46,6 +46,8 @@ public:
 	virtual void Refresh(vk::raii::CommandBuffer& cmdBuf, std::shared_ptr<QueueHandle> queue) override;
 	virtual DataLocation GetInputLocation() override;
 
+	virtual bool GetElementwiseOperation(ElementwiseOperation& op) override;
+
 	static std::string GetProtocolName();
 
 	virtual bool ValidateChannel(size_t i, StreamDescriptor stream) override;
@@ -37,6 +37,9 @@ using namespace std;
 
 AutocorrelationFilter::AutocorrelationFilter(const string& color)
 	: Filter(color, CAT_MATH)
+	, m_rectangularComputePipeline("shaders/RectangularWindow.spv", 2, sizeof(WindowFunctionArgs))
+	, m_squaredMagnitudeComputePipeline("shaders/ComplexSquaredMagnitudeInPlace.spv", 1, sizeof(uint32_t))
+	, m_normalizeComputePipeline("shaders/DeEmbedNormalization.spv", 2, sizeof(DeEmbedNormalizationArgs))
 {
 	AddStream(Unit(Unit::UNIT_VOLTS), "data", Stream::STREAM_TYPE_ANALOG);
 	CreateInput("din");
@@ -44,6 +47,17 @@ AutocorrelationFilter::AutocorrelationFilter(const string& color)
 	m_maxDeltaName = "Max offset";
 	m_parameters[m_maxDeltaName] = FilterParameter(FilterParameter::TYPE_INT, Unit(Unit::UNIT_SAMPLEDEPTH));
 	m_parameters[m_maxDeltaName].SetIntVal(1000);
+
+	m_cachedNumPoints = 0;
+
+	m_forwardInBuf.SetCpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
+	m_forwardInBuf.SetGpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
+
+	m_forwardOutBuf.SetCpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
+	m_forwardOutBuf.SetGpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
+
+	m_reverseOutBuf.SetCpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
+	m_reverseOutBuf.SetGpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -111,3 +125,124 @@ void AutocorrelationFilter::Refresh()
 	cap->MarkSamplesModifiedFromCpu();
 	SetData(cap, 0);
 }
+
+void AutocorrelationFilter::Refresh(vk::raii::CommandBuffer& cmdBuf, shared_ptr<QueueHandle> queue)
+{
+	if(!VerifyAllInputsOKAndUniformAnalog())
+	{
+		SetData(NULL, 0);
+		return;
+	}
+
+	auto din = dynamic_cast<UniformAnalogWaveform*>(GetInputWaveform(0));
+	auto len = din->size();
+
+	//Copy the units
+	SetYAxisUnits(m_inputs[0].m_channel->GetYAxisUnits(0), 0);
+
+	//Sanity check range
+	size_t range = m_parameters[m_maxDeltaName].GetIntVal();
+	if( len <= range)
+	{
+		SetData(NULL, 0);
+		return;
+	}
+
+	//Small jobs finish faster with the direct loop than with FFT plan setup and dispatch overhead,
+	//but the crossover depends on the machine, so use the measured cost model to decide
+	uint64_t work = (uint64_t)len * range;
+	if(!g_gpuFilterEnabled || !g_filterCostModel.PreferGpu(GetProtocolName(), work))
+	{
+		double tstart = GetTime();
+		Refresh();
+		g_filterCostModel.Record(GetProtocolName(), false, work, (GetTime() - tstart) * 1e9);
+		return;
+	}
+	double tstart = GetTime();
+
+	//By Wiener-Khinchin, the autocorrelation is the inverse transform of the power spectrum.
+	//Zero pad to the next power of two above len+range so the lags of interest see no circular wraparound.
+	const size_t npoints = next_pow2(len + range);
+	size_t nouts = npoints/2 + 1;
+
+	//Invalidate old vkFFT plans if size has changed
+	if(m_vkForwardPlan)
+	{
+		if(m_vkForwardPlan->size() != npoints)
+			m_vkForwardPlan = nullptr;
+	}
+	if(m_vkReversePlan)
+	{
+		if(m_vkReversePlan->size() != npoints)
+			m_vkReversePlan = nullptr;
+	}
+
+	//Set up the FFT and allocate buffers if we change point count
+	if(m_cachedNumPoints != npoints)
+	{
+		m_forwardInBuf.resize(npoints);
+		m_forwardOutBuf.resize(2 * nouts);
+		m_reverseOutBuf.resize(npoints);
+
+		m_cachedNumPoints = npoints;
+	}
+
+	//Set up new FFT plans
+	if(!m_vkForwardPlan)
+		m_vkForwardPlan = g_vkFFTPlanCache.Acquire(npoints, nouts, VulkanFFTPlan::DIRECTION_FORWARD);
+	if(!m_vkReversePlan)
+		m_vkReversePlan = g_vkFFTPlanCache.Acquire(npoints, nouts, VulkanFFTPlan::DIRECTION_REVERSE);
+
+	//Set up the output waveform
+	auto cap = SetupEmptyUniformAnalogOutputWaveform(din, 0, true);
+	cap->Resize(range);
+
+	size_t end = len - range;
+
+	//Prepare to do all of our compute stuff in one dispatch call to reduce overhead
+	cmdBuf.begin({});
+
+	//Copy and zero-pad the input as needed
+	WindowFunctionArgs args;
+	args.numActualSamples = len;
+	args.npoints = npoints;
+	args.scale = 0;
+	args.alpha0 = 0;
+	args.alpha1 = 0;
+	args.offsetIn = 0;
+	args.offsetOut = 0;
+	m_rectangularComputePipeline.BindBufferNonblocking(0, din->m_samples, cmdBuf);
+	m_rectangularComputePipeline.BindBufferNonblocking(1, m_forwardInBuf, cmdBuf, true);
+	m_rectangularComputePipeline.Dispatch(cmdBuf, args, GetComputeBlockCount(npoints, 64));
+	m_rectangularComputePipeline.AddComputeMemoryBarrier(cmdBuf);
+	m_forwardInBuf.MarkModifiedFromGpu();
+
+	//Do the actual FFT operation
+	m_vkForwardPlan->AppendForward(m_forwardInBuf, m_forwardOutBuf, cmdBuf);
+
+	//Replace the spectrum with its squared magnitude
+	m_squaredMagnitudeComputePipeline.BindBufferNonblocking(0, m_forwardOutBuf, cmdBuf);
+	m_squaredMagnitudeComputePipeline.Dispatch(cmdBuf, (uint32_t)nouts, GetComputeBlockCount(nouts, 64));
+	m_squaredMagnitudeComputePipeline.AddComputeMemoryBarrier(cmdBuf);
+	m_forwardOutBuf.MarkModifiedFromGpu();
+
+	//Do the actual FFT operation
+	m_vkReversePlan->AppendReverse(m_forwardOutBuf, m_reverseOutBuf, cmdBuf);
+
+	//Extract lags 1 through range and normalize the same way the software implementation does
+	DeEmbedNormalizationArgs nargs;
+	nargs.outlen = range;
+	nargs.istart = 1;
+	nargs.scale = 1.0f / ((float)npoints * (float)end);
+	m_normalizeComputePipeline.BindBufferNonblocking(0, m_reverseOutBuf, cmdBuf);
+	m_normalizeComputePipeline.BindBufferNonblocking(1, cap->m_samples, cmdBuf, true);
+	m_normalizeComputePipeline.Dispatch(cmdBuf, nargs, GetComputeBlockCount(range, 64));
+	m_normalizeComputePipeline.AddComputeMemoryBarrier(cmdBuf);
+
+	//Done, block until the compute operations finish
+	cmdBuf.end();
+	queue->SubmitAndBlock(cmdBuf);
+	cap->MarkModifiedFromGpu();
+
+	g_filterCostModel.Record(GetProtocolName(), true, work, (GetTime() - tstart) * 1e9);
+}
@@ -35,12 +35,15 @@
 #ifndef AutocorrelationFilter_h
 #define AutocorrelationFilter_h
 
+#include "VulkanFFTPlan.h"
+
 class AutocorrelationFilter : public Filter
 {
 public:
 	AutocorrelationFilter(const std::string& color);
 
 	virtual void Refresh() override;
+	virtual void Refresh(vk::raii::CommandBuffer& cmdBuf, std::shared_ptr<QueueHandle> queue) override;
 
 	static std::string GetProtocolName();
 
@@ -50,6 +53,18 @@ public:
 
 protected:
 	std::string m_maxDeltaName;
+
+	size_t m_cachedNumPoints;
+
+	AcceleratorBuffer<float> m_forwardInBuf;
+	AcceleratorBuffer<float> m_forwardOutBuf;
+	AcceleratorBuffer<float> m_reverseOutBuf;
+
+	ComputePipeline m_rectangularComputePipeline;
+	ComputePipeline m_squaredMagnitudeComputePipeline;
+	ComputePipeline m_normalizeComputePipeline;
+	std::shared_ptr<VulkanFFTPlan> m_vkForwardPlan;
+	std::shared_ptr<VulkanFFTPlan> m_vkReversePlan;
 };
 
 #endif
@@ -34,6 +34,7 @@ using namespace std;
 
 AverageFilter::AverageFilter(const string& color)
 	: Filter(color, CAT_MATH)
+	, m_sumPipeline("shaders/WaveformSum.spv", 2, sizeof(uint32_t))
 {
 	AddStream(Unit(Unit::UNIT_VOLTS), "latest", Stream::STREAM_TYPE_ANALOG_SCALAR);
 	AddStream(Unit(Unit::UNIT_VOLTS), "cumulative", Stream::STREAM_TYPE_ANALOG_SCALAR);
@@ -52,7 +53,7 @@ AverageFilter::~AverageFilter()
 {
 }
 
-void AverageFilter::Refresh(vk::raii::CommandBuffer& /*cmdBuf*/, shared_ptr<QueueHandle> /*queue*/)
+void AverageFilter::Refresh(vk::raii::CommandBuffer& cmdBuf, shared_ptr<QueueHandle> queue)
 {
 	auto din = GetInput(0);
 	if(!din)
@@ -89,13 +90,19 @@ void AverageFilter::Refresh(vk::raii::CommandBuffer& /*cmdBuf*/, shared_ptr<Queu
 		double total = 0;
 		size_t len = data->size();
 
-		if(udata)
+		//Large waveforms: sum on the GPU so a GPU-resident input doesn't get downloaded just to be averaged.
+		//Small ones aren't worth a dispatch; add them up wherever they already are.
+		if( (udata || sdata) && (len >= 65536) )
+			total = SumGpu(udata ? udata->m_samples : sdata->m_samples, len, cmdBuf, queue);
+		else if(udata)
 		{
+			udata->PrepareForCpuAccess();
 			for(auto sample : udata->m_samples)
 				total += sample;
 		}
 		else if(sdata)
 		{
+			sdata->PrepareForCpuAccess();
 			for(auto sample : sdata->m_samples)
 				total += sample;
 		}
@@ -109,9 +116,43 @@ void AverageFilter::Refresh(vk::raii::CommandBuffer& /*cmdBuf*/, shared_ptr<Queu
 	}
 }
 
+/**
+	@brief Sums a waveform on the GPU
+
+	Each workgroup reduces a strided subset of the input in shared memory; the per-workgroup partials
+	are merged in double precision on the CPU, matching the accumulation width of the scalar path.
+ */
+double AverageFilter::SumGpu(
+	AcceleratorBuffer<float>& samples,
+	size_t len,
+	vk::raii::CommandBuffer& cmdBuf,
+	shared_ptr<QueueHandle> queue)
+{
+	const uint32_t numGroups = 256;
+	m_partialSumBuf.resize(numGroups);
+	m_partialSumBuf.SetCpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
+	m_partialSumBuf.SetGpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
+
+	cmdBuf.begin({});
+	m_sumPipeline.BindBufferNonblocking(0, samples, cmdBuf);
+	m_sumPipeline.BindBufferNonblocking(1, m_partialSumBuf, cmdBuf, true);
+	m_sumPipeline.Dispatch(cmdBuf, (uint32_t)len, numGroups);
+	cmdBuf.end();
+	queue->SubmitAndBlock(cmdBuf);
+	m_partialSumBuf.MarkModifiedFromGpu();
+
+	//Merge the per-workgroup partials
+	m_partialSumBuf.PrepareForCpuAccess();
+	double total = 0;
+	for(uint32_t i=0; i<numGroups; i++)
+		total += m_partialSumBuf[i];
+	return total;
+}
+
 Filter::DataLocation AverageFilter::GetInputLocation()
 {
-	return LOC_CPU;
+	//We explicitly manage our input memory and don't care where it is when Refresh() is called
+	return LOC_DONTCARE;
 }
 
 string AverageFilter::GetProtocolName()
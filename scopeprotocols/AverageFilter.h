@@ -53,8 +53,20 @@ public:
 	PROTOCOL_DECODER_INITPROC(AverageFilter)
 
 protected:
+	double SumGpu(
+		AcceleratorBuffer<float>& samples,
+		size_t len,
+		vk::raii::CommandBuffer& cmdBuf,
+		std::shared_ptr<QueueHandle> queue);
+
 	double m_pastSum;
 	int64_t m_pastCount;
+
+	///@brief Compute pipeline for summing large waveforms on the GPU
+	ComputePipeline m_sumPipeline;
+
+	///@brief Per-workgroup partial sums, merged on the CPU after readback
+	AcceleratorBuffer<float> m_partialSumBuf;
 };
 
 #endif
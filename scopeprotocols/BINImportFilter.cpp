@@ -32,6 +32,20 @@
 
 using namespace std;
 
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Helpers
+
+/**
+	@brief Returns the number of worker threads to use for converting a block of nsamples samples
+ */
+static size_t GetConvertThreadCount(size_t nsamples)
+{
+	//Not worth spinning up threads for small waveforms
+	if(nsamples < (1024 * 1024))
+		return 1;
+	return min<size_t>(thread::hardware_concurrency(), 8);
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Construction / destruction
 
@@ -154,7 +168,7 @@ void BINImportFilter::OnFileNameChanged()
 		//Digital logic waveform
 		if(wh.type == 6)
 		{
-			//Create 8 streams of digital data
+			//Create 8 streams of digital data, sized up front so samples unpack straight into the buffers
 			vector<UniformDigitalWaveform*> wfms;
 			for(size_t j=0; j<8; j++)
 			{
@@ -165,12 +179,14 @@ void BINImportFilter::OnFileNameChanged()
 				wfm->m_startTimestamp = timestamp;
 				wfm->m_startFemtoseconds = fs;
 				wfm->m_triggerPhase = 0;
+				wfm->Resize((size_t)wh.samples * wh.buffers);
 				SetData(wfm, m_streams.size()-1);
 				wfms.push_back(wfm);
 
 				wfm->PrepareForCpuAccess();
 			}
 
+			size_t nsamp = 0;
 			for(size_t j=0; j<wh.buffers; j++)
 			{
 				LogDebug("Buffer %i:\n", (int)j+1);
@@ -184,39 +200,53 @@ void BINImportFilter::OnFileNameChanged()
 				LogDebug("Sample depth:   %i bits\n", dh.depth*8);
 				LogDebug("Buffer length:  %i KB\n\n\n", dh.length/1024);
 
-				for(size_t k=0; k<wh.samples; k++)
+				if( (dh.type != 5) && (dh.type != 6) )
 				{
-					uint8_t s = -1;
-
-					//Logic samples (counts 32-bit float data waveforms)
-					if (dh.type == 5)
-					{
-						//Do not violate strict aliasing, compiler will optimize out the memcpy
-						float val;
-						memcpy(&val, f.c_str() + fpos, sizeof(float));
-						s = static_cast<uint8_t>(val);
-					}
-					//Logic samples (digital unsigned 8-bit character data)
-					else if (dh.type == 6)
-					{
-						s = *(uint8_t*)(f.c_str() + fpos);
-					}
-					else
-					{
-						LogDebug("Invalid buffer type for logic waveform\n");
-						return;
-					}
+					LogDebug("Invalid buffer type for logic waveform\n");
+					return;
+				}
 
-					for(size_t m=0; m<8; m++)
+				//Unpack bits in parallel chunks, one pass writing all eight streams
+				const char* src = f.c_str() + fpos;
+				auto unpackRange = [&wfms, &dh, src, nsamp](size_t kstart, size_t kend)
+				{
+					for(size_t k=kstart; k<kend; k++)
 					{
-						if(s & (1 << m) )
-							wfms[m]->m_samples.push_back(true);
+						uint8_t s;
+
+						//Logic samples (counts 32-bit float data waveforms)
+						if(dh.type == 5)
+						{
+							//Do not violate strict aliasing, compiler will optimize out the memcpy
+							float val;
+							memcpy(&val, src + k*dh.depth, sizeof(float));
+							s = static_cast<uint8_t>(val);
+						}
+
+						//Logic samples (digital unsigned 8-bit character data)
 						else
-							wfms[m]->m_samples.push_back(false);
+							s = *(const uint8_t*)(src + k*dh.depth);
+
+						for(size_t m=0; m<8; m++)
+							wfms[m]->m_samples[nsamp + k] = ( (s & (1 << m)) != 0 );
 					}
+				};
 
-					fpos += dh.depth;
+				size_t nthreads = GetConvertThreadCount(wh.samples);
+				if(nthreads == 1)
+					unpackRange(0, wh.samples);
+				else
+				{
+					size_t chunklen = (wh.samples + nthreads - 1) / nthreads;
+					vector<thread> threads;
+					for(size_t t=0; t<nthreads; t++)
+						threads.emplace_back(unpackRange, t*chunklen, min<size_t>((t+1)*chunklen, wh.samples));
+					for(auto& t : threads)
+						t.join();
 				}
+
+				fpos += (size_t)wh.samples * dh.depth;
+				nsamp += wh.samples;
 			}
 
 			for(auto w : wfms)
@@ -234,9 +264,11 @@ void BINImportFilter::OnFileNameChanged()
 			wfm->m_startTimestamp = timestamp;
 			wfm->m_startFemtoseconds = fs;
 			wfm->m_triggerPhase = 0;
+			wfm->Resize((size_t)wh.samples * wh.buffers);
 			wfm->PrepareForCpuAccess();
 			SetData(wfm, m_streams.size()-1);
 
+			size_t nsamp = 0;
 			for(size_t j=0; j<wh.buffers; j++)
 			{
 				LogDebug("Buffer %i:\n", (int)j+1);
@@ -250,15 +282,37 @@ void BINImportFilter::OnFileNameChanged()
 				LogDebug("Sample depth:   %i bits\n", dh.depth*8);
 				LogDebug("Buffer length:  %i KB\n\n\n", dh.length/1024);
 
-				//Float samples (analog waveforms)
-				for(size_t k=0; k<wh.samples; k++)
+				//Float samples (analog waveforms), copied straight into the accelerator buffer
+				//in parallel chunks
+				const char* src = f.c_str() + fpos;
+				float* dst = wfm->m_samples.GetCpuPointer() + nsamp;
+				auto copyRange = [&dh, src, dst](size_t kstart, size_t kend)
 				{
-					//Do not violate strict aliasing, compiler will optimize out the memcpy
-					float* sample_f;
-					memcpy(&sample_f, f.c_str() + fpos, sizeof(float));
-					wfm->m_samples.push_back(*sample_f);
-					fpos += dh.depth;
+					if(dh.depth == sizeof(float))
+						memcpy(dst + kstart, src + kstart*sizeof(float), (kend - kstart) * sizeof(float));
+					else
+					{
+						//Do not violate strict aliasing, compiler will optimize out the memcpy
+						for(size_t k=kstart; k<kend; k++)
+							memcpy(dst + k, src + k*dh.depth, sizeof(float));
+					}
+				};
+
+				size_t nthreads = GetConvertThreadCount(wh.samples);
+				if(nthreads == 1)
+					copyRange(0, wh.samples);
+				else
+				{
+					size_t chunklen = (wh.samples + nthreads - 1) / nthreads;
+					vector<thread> threads;
+					for(size_t t=0; t<nthreads; t++)
+						threads.emplace_back(copyRange, t*chunklen, min<size_t>((t+1)*chunklen, wh.samples));
+					for(auto& t : threads)
+						t.join();
 				}
+
+				fpos += (size_t)wh.samples * dh.depth;
+				nsamp += wh.samples;
 			}
 
 			wfm->MarkModifiedFromCpu();
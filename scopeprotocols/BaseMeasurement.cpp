@@ -122,66 +122,70 @@ void BaseMeasurement::Refresh()
 
 	vector<float> samples;
 
-	for(size_t i=0; i < len; i++)
+	//Main loop is dispatched on the concrete waveform type so the per-sample accessors resolve at compile time
+	DispatchAnalogKernel(in, [&](auto* wfm)
 	{
-		//Wait for a rising edge (end of the low period)
-		auto cur = GetValue(sin, uin, i);
-		auto tnow = GetOffsetScaled(sin, uin, i);
+		for(size_t i=0; i < len; i++)
+		{
+			//Wait for a rising edge (end of the low period)
+			float cur = wfm->m_samples[i];
+			int64_t tnow = ::GetOffsetScaled(wfm, i);
 
-		//Find falling edge
-		if( (cur < mid) && (last >= mid) )
-			tfall = tnow;
+			//Find falling edge
+			if( (cur < mid) && (last >= mid) )
+				tfall = tnow;
 
-		//Find rising edge
-		if( (cur > mid) && (last <= mid) )
-		{
-			//Done, add the sample
-			if(!samples.empty())
+			//Find rising edge
+			if( (cur > mid) && (last <= mid) )
 			{
-				if(first)
-					first = false;
-
-				else
+				//Done, add the sample
+				if(!samples.empty())
 				{
-					//Average the middle 50% of the samples.
-					//Discard beginning and end as they include parts of the edge
-					float sum = 0;
-					int64_t count = 0;
-					size_t start = samples.size()/4;
-					size_t end = samples.size() - start;
-					for(size_t j=start; j<=end; j++)
+					if(first)
+						first = false;
+
+					else
 					{
-						sum += samples[j];
-						count ++;
+						//Average the middle 50% of the samples.
+						//Discard beginning and end as they include parts of the edge
+						float sum = 0;
+						int64_t count = 0;
+						size_t start = samples.size()/4;
+						size_t end = samples.size() - start;
+						for(size_t j=start; j<=end; j++)
+						{
+							sum += samples[j];
+							count ++;
+						}
+
+						float vavg = sum / count;
+
+						fmax = max(fmax, vavg);
+						fmin = min(fmin, vavg);
+
+						int64_t tmid = (tnow + tfall) / 2;
+
+						//Update duration for last sample
+						size_t n = cap->m_samples.size();
+						if(n)
+							cap->m_durations[n-1] = tmid - cap->m_offsets[n-1];
+
+						cap->m_offsets.push_back(tmid);
+						cap->m_durations.push_back(1);
+						cap->m_samples.push_back(vavg);
 					}
 
-					float vavg = sum / count;
-
-					fmax = max(fmax, vavg);
-					fmin = min(fmin, vavg);
-
-					int64_t tmid = (tnow + tfall) / 2;
-
-					//Update duration for last sample
-					size_t n = cap->m_samples.size();
-					if(n)
-						cap->m_durations[n-1] = tmid - cap->m_offsets[n-1];
-
-					cap->m_offsets.push_back(tmid);
-					cap->m_durations.push_back(1);
-					cap->m_samples.push_back(vavg);
+					samples.clear();
 				}
-
-				samples.clear();
 			}
-		}
 
-		//If the value is fairly close to the calculated base, average it
-		if(fabs(cur - global_base) < delta)
-			samples.push_back(cur);
+			//If the value is fairly close to the calculated base, average it
+			if(fabs(cur - global_base) < delta)
+				samples.push_back(cur);
 
-		last = cur;
-	}
+			last = cur;
+		}
+	});
 
 	cap->MarkModifiedFromCpu();
 }
@@ -44,11 +44,18 @@ using namespace std;
 CANDecoder::CANDecoder(const string& color)
 	: PacketDecoder(color, CAT_BUS)
 	, m_baudrateName("Bit Rate")
+	, m_highWaterMark(0)
+	, m_lastInput(nullptr)
+	, m_lastTimestamp(0)
+	, m_lastStartFs(0)
+	, m_lastTimescale(0)
+	, m_lastBitrate(0)
 {
 	CreateInput("CANH");
 
 	m_parameters[m_baudrateName] = FilterParameter(FilterParameter::TYPE_INT, Unit(Unit::UNIT_BITRATE));
 	m_parameters[m_baudrateName].SetIntVal(250000);
+	m_cachedBaudrate.Bind(m_parameters[m_baudrateName]);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -75,11 +82,11 @@ string CANDecoder::GetProtocolName()
 
 void CANDecoder::Refresh()
 {
-	ClearPackets();
-
 	//Make sure we've got valid inputs
 	if(!VerifyAllInputsOK())
 	{
+		ClearPackets();
+		m_lastInput = nullptr;
 		SetData(NULL, 0);
 		return;
 	}
@@ -90,68 +97,70 @@ void CANDecoder::Refresh()
 	auto udiff = dynamic_cast<UniformDigitalWaveform*>(din);
 	auto sdiff = dynamic_cast<SparseDigitalWaveform*>(din);
 
-	//Create the capture
-	auto cap = new CANWaveform;
-	cap->m_timescale = din->m_timescale;
-	cap->m_startTimestamp = din->m_startTimestamp;
-	cap->m_startFemtoseconds = din->m_startFemtoseconds;
-	cap->m_triggerPhase = din->m_triggerPhase;
+	auto bitrate = m_cachedBaudrate.GetIntVal();
+	size_t len = din->size();
+
+	//Incremental decode: if the same capture just grew at the tail (streaming acquisition appending in
+	//place, as SocketCANAnalyzer does), resume from where the previous pass stopped rather than
+	//re-decoding the entire history. Any change of input, trigger timestamp, timescale, or bit rate
+	//forces a full re-decode.
+	auto cap = dynamic_cast<CANWaveform*>(GetData(0));
+	bool incremental = cap
+		&& (din == m_lastInput)
+		&& (din->m_startTimestamp == m_lastTimestamp)
+		&& (din->m_startFemtoseconds == m_lastStartFs)
+		&& (din->m_timescale == m_lastTimescale)
+		&& (bitrate == m_lastBitrate)
+		&& (len >= m_highWaterMark);
+
+	//Starting from scratch: reset the decoder context (before ClearPackets() so we never hold a stale
+	//pointer to a deleted partial packet) and create a new capture
+	if(!incremental)
+	{
+		m_decodeState = DecodeState();
+		m_highWaterMark = 0;
+		ClearPackets();
+
+		cap = new CANWaveform;
+		cap->m_timescale = din->m_timescale;
+		cap->m_startTimestamp = din->m_startTimestamp;
+		cap->m_startFemtoseconds = din->m_startFemtoseconds;
+		cap->m_triggerPhase = din->m_triggerPhase;
+	}
 	cap->PrepareForCpuAccess();
 
 	//Calculate some time scale values
 	//Sample point is 3/4 of the way through the UI
-	auto bitrate = m_parameters[m_baudrateName].GetIntVal();
 	int64_t fs_per_ui = FS_PER_SECOND / bitrate;
 	int64_t samples_per_ui = fs_per_ui / din->m_timescale;
 
-	enum
-	{
-		STATE_WAIT_FOR_IDLE,
-		STATE_IDLE,
-		STATE_SOF,
-		STATE_ID,
-		STATE_EXT_ID,
-		STATE_RTR,
-		STATE_IDE,
-		STATE_FD,
-		STATE_R0,
-		STATE_DLC,
-		STATE_DATA,
-		STATE_CRC,
-
-		STATE_CRC_DELIM,
-		STATE_ACK,
-		STATE_ACK_DELIM,
-		STATE_EOF
-	} state = STATE_WAIT_FOR_IDLE;
-
 	//LogDebug("Starting CAN decode\n");
 	//LogIndenter li;
 
-	Packet* pack = NULL;
-
-	size_t len = din->size();
-	int64_t tbitstart = 0;
-	int64_t tblockstart = 0;
-	bool vlast = true;
-	int nbit = 0;
-	bool sampled = false;
-	bool sampled_value = false;
-	bool last_sampled_value = false;
-	int bits_since_toggle = 0;
-	uint32_t current_field = 0;
-	bool frame_is_rtr = false;
-	bool extended_id = false;
-	bool fd_mode = false;
-	int frame_bytes_left = 0;
-	int32_t frame_id = 0;
+	//Pull the persistent decoder context into locals for the hot loop
+	auto state = m_decodeState.m_state;
+	Packet* pack = m_decodeState.m_pack;
+	int64_t tbitstart = m_decodeState.m_tbitstart;
+	int64_t tblockstart = m_decodeState.m_tblockstart;
+	bool vlast = m_decodeState.m_vlast;
+	int nbit = m_decodeState.m_nbit;
+	bool sampled = m_decodeState.m_sampled;
+	bool sampled_value = m_decodeState.m_sampledValue;
+	bool last_sampled_value = m_decodeState.m_lastSampledValue;
+	int bits_since_toggle = m_decodeState.m_bitsSinceToggle;
+	uint32_t current_field = m_decodeState.m_currentField;
+	bool frame_is_rtr = m_decodeState.m_frameIsRtr;
+	bool extended_id = m_decodeState.m_extendedId;
+	bool fd_mode = m_decodeState.m_fdMode;
+	int frame_bytes_left = m_decodeState.m_frameBytesLeft;
+	int32_t frame_id = m_decodeState.m_frameId;
 	char tmp[128];
 
 	// CRC (http://esd.cs.ucr.edu/webres/can20.pdf page 13)
 	const uint16_t crc_poly = 0x4599;
-	uint16_t crc = 0;
+	uint16_t crc = m_decodeState.m_crc;
 
-	for(size_t i = 0; i < len; i++)
+	for(size_t i = m_highWaterMark; i < len; i++)
 	{
 		bool v = GetValue(sdiff, udiff, i);
 		bool toggle = (v != vlast);
@@ -537,6 +546,35 @@ void CANDecoder::Refresh()
 		}
 	}
 
+	//Save the decoder context and resume point so the next pass can pick up at the tail
+	m_decodeState.m_state = state;
+	m_decodeState.m_pack = pack;
+	m_decodeState.m_tbitstart = tbitstart;
+	m_decodeState.m_tblockstart = tblockstart;
+	m_decodeState.m_vlast = vlast;
+	m_decodeState.m_nbit = nbit;
+	m_decodeState.m_sampled = sampled;
+	m_decodeState.m_sampledValue = sampled_value;
+	m_decodeState.m_lastSampledValue = last_sampled_value;
+	m_decodeState.m_bitsSinceToggle = bits_since_toggle;
+	m_decodeState.m_currentField = current_field;
+	m_decodeState.m_frameIsRtr = frame_is_rtr;
+	m_decodeState.m_extendedId = extended_id;
+	m_decodeState.m_fdMode = fd_mode;
+	m_decodeState.m_frameBytesLeft = frame_bytes_left;
+	m_decodeState.m_frameId = frame_id;
+	m_decodeState.m_crc = crc;
+	m_highWaterMark = len;
+	m_lastInput = din;
+	m_lastTimestamp = din->m_startTimestamp;
+	m_lastStartFs = din->m_startFemtoseconds;
+	m_lastTimescale = din->m_timescale;
+	m_lastBitrate = bitrate;
+
+	//Appending to the existing capture doesn't reallocate it, so bump the revision for downstream consumers
+	if(incremental)
+		cap->m_revision ++;
+
 	SetData(cap, 0);
 
 	cap->MarkModifiedFromCpu();
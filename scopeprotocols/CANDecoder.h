@@ -55,6 +55,91 @@ public:
 
 protected:
 	std::string m_baudrateName;
+
+	///@brief Pre-resolved bit rate, so Refresh() never does a string-keyed parameter lookup
+	CachedParameter m_cachedBaudrate;
+
+	///@brief States for the bit-level decode state machine
+	enum decode_state
+	{
+		STATE_WAIT_FOR_IDLE,
+		STATE_IDLE,
+		STATE_SOF,
+		STATE_ID,
+		STATE_EXT_ID,
+		STATE_RTR,
+		STATE_IDE,
+		STATE_FD,
+		STATE_R0,
+		STATE_DLC,
+		STATE_DATA,
+		STATE_CRC,
+
+		STATE_CRC_DELIM,
+		STATE_ACK,
+		STATE_ACK_DELIM,
+		STATE_EOF
+	};
+
+	/**
+		@brief Complete decoder context (state machine position, bit timing phase, partial frame in progress).
+
+		Persisted across Refresh() passes so that a streaming capture which only grew at the tail can resume
+		decoding at the high-water mark rather than re-decoding the entire history.
+	 */
+	struct DecodeState
+	{
+		DecodeState()
+			: m_state(STATE_WAIT_FOR_IDLE)
+			, m_pack(nullptr)
+			, m_tbitstart(0)
+			, m_tblockstart(0)
+			, m_vlast(true)
+			, m_nbit(0)
+			, m_sampled(false)
+			, m_sampledValue(false)
+			, m_lastSampledValue(false)
+			, m_bitsSinceToggle(0)
+			, m_currentField(0)
+			, m_frameIsRtr(false)
+			, m_extendedId(false)
+			, m_fdMode(false)
+			, m_frameBytesLeft(0)
+			, m_frameId(0)
+			, m_crc(0)
+		{}
+
+		decode_state m_state;
+		Packet* m_pack;
+		int64_t m_tbitstart;
+		int64_t m_tblockstart;
+		bool m_vlast;
+		int m_nbit;
+		bool m_sampled;
+		bool m_sampledValue;
+		bool m_lastSampledValue;
+		int m_bitsSinceToggle;
+		uint32_t m_currentField;
+		bool m_frameIsRtr;
+		bool m_extendedId;
+		bool m_fdMode;
+		int m_frameBytesLeft;
+		int32_t m_frameId;
+		uint16_t m_crc;
+	};
+
+	///@brief Decoder context carried over from the previous pass
+	DecodeState m_decodeState;
+
+	///@brief Number of input samples already decoded (resume point for incremental passes)
+	size_t m_highWaterMark;
+
+	//Identity of the input we last decoded, so we only resume when the same capture grew in place
+	WaveformBase* m_lastInput;
+	time_t m_lastTimestamp;
+	int64_t m_lastStartFs;
+	int64_t m_lastTimescale;
+	int64_t m_lastBitrate;
 };
 
 #endif
@@ -31,6 +31,7 @@
 #include "CSVExportFilter.h"
 
 #include <cinttypes>
+#include <thread>
 
 using namespace std;
 
@@ -111,24 +112,28 @@ void CSVExportFilter::Export()
 			m_fp = fopen(m_parameters[m_fname].GetFileName().c_str(), "wb");
 
 		//See if file is empty. If so, write header
+		//(safe to touch the file directly here: it was just opened, so the write queue has nothing in flight for it)
 		fseek(m_fp, 0, SEEK_END);
 		if(ftell(m_fp) == 0)
 		{
+			string hdr;
 			if(xunit == Unit(Unit::UNIT_FS))
-				fprintf(m_fp, "Time (s)");
+				hdr += "Time (s)";
 			else if(xunit == Unit(Unit::UNIT_HZ))
-				fprintf(m_fp, "Frequency (Hz)");
+				hdr += "Frequency (Hz)";
 			else
-				fprintf(m_fp, "X Unit");
+				hdr += "X Unit";
 
 			//Write other fields
 			for(size_t i=0; i<GetInputCount(); i++)
 			{
 				string colname = GetInput(i).GetName();
 				colname = str_replace(",", "_", colname);
-				fprintf(m_fp, ",%s", colname.c_str());
+				hdr += ',';
+				hdr += colname;
 			}
-			fprintf(m_fp, "\n");
+			hdr += '\n';
+			QueueWrite(std::move(hdr));
 		}
 	}
 
@@ -144,6 +149,7 @@ void CSVExportFilter::Export()
 	for(size_t i=0; i<GetInputCount(); i++)
 	{
 		auto data = GetInput(i).GetData();
+		data->PrepareForCpuAccess();
 		sparse.push_back(dynamic_cast<SparseWaveformBase*>(data));
 		uniform.push_back(dynamic_cast<UniformWaveformBase*>(data));
 		sa.push_back(dynamic_cast<SparseAnalogWaveform*>(data));
@@ -154,7 +160,82 @@ void CSVExportFilter::Export()
 		lens.push_back(data->size());
 	}
 
-	//Main export path
+	//Fast path: every column is uniformly sampled analog data on a common timebase. Rows then map 1:1 onto
+	//sample indexes, so the row range can be partitioned across threads, each formatting its chunk into a
+	//private buffer, and the chunks written in order as large fwrite batches.
+	bool uniformAnalog = true;
+	size_t minlen = SIZE_MAX;
+	for(size_t i=0; i<GetInputCount(); i++)
+	{
+		if( !ua[i] || (GetInput(i).GetType() != Stream::STREAM_TYPE_ANALOG) )
+			uniformAnalog = false;
+		else if( (ua[i]->m_timescale != ua[0]->m_timescale) || (ua[i]->m_triggerPhase != ua[0]->m_triggerPhase) )
+			uniformAnalog = false;
+		minlen = min(minlen, lens[i]);
+	}
+	if(uniformAnalog && (minlen >= 2))
+	{
+		//The merge loop below never prints the last sample (no event follows it), so match that here
+		size_t nrows = minlen - 1;
+		size_t ncols = GetInputCount();
+
+		//Don't bother spinning up threads for small exports
+		size_t nthreads = min<size_t>(thread::hardware_concurrency(), 8);
+		if( (nrows < 65536) || (nthreads < 1) )
+			nthreads = 1;
+		size_t chunklen = (nrows + nthreads - 1) / nthreads;
+
+		bool xIsFs = (xunit == Unit(Unit::UNIT_FS));
+		int64_t timescale = ua[0]->m_timescale;
+		int64_t phase = ua[0]->m_triggerPhase;
+
+		vector<string> chunks(nthreads);
+		vector<thread> workers;
+		for(size_t t=0; t<nthreads; t++)
+		{
+			workers.emplace_back([&, t]
+			{
+				size_t rstart = t * chunklen;
+				size_t rend = min(rstart + chunklen, nrows);
+				if(rstart >= rend)
+					return;
+
+				auto& buf = chunks[t];
+				buf.reserve( (rend - rstart) * (18 + 13*ncols) );
+				char tmp[48];
+				for(size_t r=rstart; r<rend; r++)
+				{
+					int64_t ts = int64_t(r)*timescale + phase;
+					if(xIsFs)
+					{
+						snprintf(tmp, sizeof(tmp), "%.10e", ts / FS_PER_SECOND);
+						buf += tmp;
+					}
+					else
+						AppendInt64(buf, ts);
+
+					for(size_t i=0; i<ncols; i++)
+					{
+						buf += ',';
+						AppendFloatFixed(buf, ua[i]->m_samples[r]);
+					}
+					buf += '\n';
+				}
+			});
+		}
+		for(auto& w : workers)
+			w.join();
+		for(auto& c : chunks)
+			QueueWrite(std::move(c));
+		return;
+	}
+
+	//Main export path: merge events across columns in timestamp order, formatting into a bounded buffer
+	//that's flushed as it fills
+	string rowbuf;
+	const size_t flushThreshold = 1024 * 1024;
+	rowbuf.reserve(flushThreshold + 1024);
+	char tmp[48];
 	int64_t timestamp = INT64_MIN;
 	bool first = true;
 	while(true)
@@ -176,38 +257,48 @@ void CSVExportFilter::Export()
 		{
 			//Write timestamp
 			if(xunit == Unit(Unit::UNIT_FS))
-				fprintf(m_fp, "%.10e", timestamp / FS_PER_SECOND);
-			else if(xunit == Unit(Unit::UNIT_HZ))
-				fprintf(m_fp, "%" PRId64 "", timestamp);
+			{
+				snprintf(tmp, sizeof(tmp), "%.10e", timestamp / FS_PER_SECOND);
+				rowbuf += tmp;
+			}
 			else
-				fprintf(m_fp, "%" PRId64 "", timestamp);
+				AppendInt64(rowbuf, timestamp);
 
 			//Write values
 			for(size_t i=0; i<GetInputCount(); i++)
 			{
+				rowbuf += ',';
 				switch(GetInput(i).GetType())
 				{
 					case Stream::STREAM_TYPE_ANALOG:
-					fprintf(m_fp, ",%f", GetValue(sa[i], ua[i], indexes[i]));
-					break;
+						AppendFloatFixed(rowbuf, GetValue(sa[i], ua[i], indexes[i]));
+						break;
 
 					case Stream::STREAM_TYPE_DIGITAL:
-						fprintf(m_fp, ",%d", GetValue(sd[i], ud[i], indexes[i]));
+						rowbuf += GetValue(sd[i], ud[i], indexes[i]) ? '1' : '0';
 						break;
 
 					case Stream::STREAM_TYPE_PROTOCOL:
 						if(sparse[i])
-							fprintf(m_fp, ",%s", sparse[i]->GetText(indexes[i]).c_str());
+							rowbuf += sparse[i]->GetText(indexes[i]);
 						else
-							fprintf(m_fp, ",%s", uniform[i]->GetText(indexes[i]).c_str());
+							rowbuf += uniform[i]->GetText(indexes[i]);
 						break;
 
 					default:
-						fprintf(m_fp, ",%s", "[unimplemented]");
+						rowbuf += "[unimplemented]";
 						break;
 				}
 			}
-			fprintf(m_fp, "\n");
+			rowbuf += '\n';
+
+			//Hand off when the buffer fills, keeping memory bounded regardless of export size
+			if(rowbuf.size() >= flushThreshold)
+			{
+				QueueWrite(std::move(rowbuf));
+				rowbuf.clear();
+				rowbuf.reserve(flushThreshold + 1024);
+			}
 		}
 		first = false;
 
@@ -216,11 +307,14 @@ void CSVExportFilter::Export()
 		for(size_t i=0; i<GetInputCount(); i++)
 			AdvanceToTimestampScaled(sparse[i], uniform[i], indexes[i], lens[i], timestamp);
 	}
+
+	QueueWrite(std::move(rowbuf));
 }
 
 void CSVExportFilter::OnColumnCountChanged()
 {
-	//Close the existing file
+	//Close the existing file (draining pending writes first)
+	FlushWriteQueue();
 	if(m_fp)
 		fclose(m_fp);
 	m_fp = nullptr;
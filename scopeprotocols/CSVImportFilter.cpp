@@ -29,7 +29,6 @@
 
 #include "../scopehal/scopehal.h"
 #include "CSVImportFilter.h"
-
 using namespace std;
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -83,8 +82,9 @@ void CSVImportFilter::OnFileNameChanged()
 	int64_t fs = 0;
 	GetTimestampOfFile(fname, timestamp, fs);
 
-	FILE* fp = fopen(fname.c_str(), "r");
-	if(!fp)
+	//Map the file rather than reading it line by line, so the parser works on one big flat buffer
+	MappedFileView file(fname);
+	if(!file.IsValid())
 	{
 		LogError("Couldn't open CSV file \"%s\"\n", fname.c_str());
 		return;
@@ -92,29 +92,38 @@ void CSVImportFilter::OnFileNameChanged()
 
 	ClearStreams();
 
-	//Read the file
+	//First pass: index data lines with memchr() (which the C library vectorizes), handling comments and the
+	//header row as we go. Only line boundaries are recorded; no sample data is copied or parsed yet.
+	const char* p = file.m_data;
+	const char* fileEnd = p + file.m_len;
 	vector<string> names;
-	vector< vector<string> > lines;
-	vector<int64_t> timestamps;
-	char line[1024];
-	bool digilentFormat;
+	vector<TextLineView> rows;
+	bool digilentFormat = false;
+	bool firstContentLine = true;
 	size_t nrow = 0;
-	size_t ncols = 0;
-	while(!feof(fp))
+	while(p < fileEnd)
 	{
-		if(!fgets(line, sizeof(line), fp))
-			break;
-
+		auto nl = static_cast<const char*>(memchr(p, '\n', fileEnd - p));
+		const char* lineStart = p;
+		const char* lineEnd = nl ? nl : fileEnd;
+		p = nl ? nl+1 : fileEnd;
 		nrow ++;
 
+		//Strip leading and trailing whitespace (including the CR of a CRLF line ending)
+		while( (lineStart < lineEnd) && isspace(static_cast<unsigned char>(*lineStart)) )
+			lineStart ++;
+		while( (lineEnd > lineStart) && isspace(static_cast<unsigned char>(lineEnd[-1])) )
+			lineEnd --;
+
 		//Discard blank lines
-		string s = Trim(line);
-		if(s.empty())
+		if(lineStart == lineEnd)
 			continue;
 
 		//If the line starts with a #, it's a comment. Discard it, but save timestamp metadata if present
-		if(s[0] == '#')
+		if(*lineStart == '#')
 		{
+			string s(lineStart, lineEnd - lineStart);
+
 			if(s == "#Digilent WaveForms Oscilloscope Acquisition")
 			{
 				digilentFormat = true;
@@ -164,97 +173,72 @@ void CSVImportFilter::OnFileNameChanged()
 			continue;
 		}
 
-		//Parse into 2D vector of timestamps and strings
-		string tmp;
-		bool foundTimestamp = false;
-		vector<string> fields;
-		bool headerRow = false;
-		for(size_t i=0; i<s.length(); i++)
+		//The first content line might be a header row: anything non-numeric means names, not data
+		if(firstContentLine)
 		{
-			//End of field
-			if( (s[i] == ',') || (s[i] == '\n') )
+			firstContentLine = false;
+
+			bool headerRow = false;
+			for(const char* q = lineStart; q < lineEnd; q++)
 			{
-				//If this is the first row, check if it's numeric
-				if(names.empty() && timestamps.empty())
+				auto c = *q;
+				if(	!isdigit(static_cast<unsigned char>(c)) && !isspace(static_cast<unsigned char>(c)) &&
+					(c != ',') && (c != '.') && (c != '-') && (c != 'e') && (c != '+'))
 				{
-					//See if it's a header row
-					for(size_t j=0; (j<sizeof(line)) && (line[j] != '\0'); j++)
-					{
-						auto c = line[j];
-						if(	!isdigit(c) && !isspace(c) &&
-							(c != ',') && (c != '.') && (c != '-') && (c != 'e') && (c != '+'))
-						{
-							headerRow = true;
-							LogTrace("Found header row: %s\n", line);
-							break;
-						}
-					}
-
-					//Save the header values
-					if(headerRow)
-						fields.push_back(tmp);
+					headerRow = true;
+					break;
 				}
+			}
 
-				//Load timestamp
-				if(!foundTimestamp)
-				{
-					foundTimestamp = true;
-
-					//Parse time to a float and convert to fs
-					if(m_parameters[m_xunit].GetIntVal() == Unit::UNIT_FS)
-					{
-						double timeSec;
-						if(tmp.find("e") == string::npos)
-							sscanf(tmp.c_str(), "%lf", &timeSec);
-						else
-							sscanf(tmp.c_str(), "%le", &timeSec);
-						timestamps.push_back(FS_PER_SECOND * timeSec);
-					}
+			if(headerRow)
+			{
+				LogTrace("Found header row\n");
 
-					//other units are as-is
-					else
-						timestamps.push_back(stoll(tmp));
+				const char* q = lineStart;
+				while(true)
+				{
+					auto comma = static_cast<const char*>(memchr(q, ',', lineEnd - q));
+					names.push_back(string(q, (comma ? comma : lineEnd) - q));
+					if(!comma)
+						break;
+					q = comma + 1;
 				}
 
-				//Data field. Save it
-				else
-					fields.push_back(tmp);
-				tmp = "";
+				//delete name of timestamp column
+				names.erase(names.begin());
+				continue;
 			}
-
-			//Add to field
-			else
-				tmp += s[i];
 		}
-		if(tmp != "")
-			fields.push_back(tmp);
 
-		//Header row gets special treatment
-		if(headerRow)
-		{
-			//delete name of timestamp column
-			fields.erase(fields.begin());
+		TextLineView row;
+		row.m_start = lineStart;
+		row.m_end = lineEnd;
+		row.m_row = nrow;
+		rows.push_back(row);
+	}
 
-			names = fields;
-			continue;
-		}
+	size_t nrows = rows.size();
+	if(nrows == 0)
+	{
+		m_outputsChangedSignal.emit();
+		return;
+	}
 
-		//Sanity check field count
-		if(ncols == 0)
-			ncols = fields.size();
-		else if(ncols != fields.size())
+	//Column count from the first data row (the first field is the timestamp; ignore an empty trailing field)
+	size_t ncols = 0;
+	{
+		const char* fstart;
+		const char* fend;
+		while(GetDelimitedField(rows[0], ncols + 1, ',', fstart, fend))
 		{
-			LogError("Malformed file (line %zu contains %zu fields, but file started with %zu fields)\n",
-				nrow, fields.size(), ncols);
-			break;
+			if( (fstart == fend) && (fend == rows[0].m_end) )
+				break;
+			ncols ++;
 		}
-
-		lines.push_back(fields);
 	}
+	LogTrace("Indexing completed, %zu rows, %zu columns, %zu names\n", nrows, ncols, names.size());
 
 	//Assign default names to channels if there's no header row or not enough names
-	LogTrace("Initial parsing completed, %zu lines, %zu columns, %zu names, %zu timestamps\n",
-		lines.size(), ncols, names.size(), timestamps.size());
 	for(size_t i=0; i<ncols; i++)
 	{
 		if(names.size() <= i)
@@ -268,12 +252,18 @@ void CSVImportFilter::OnFileNameChanged()
 	{
 		LogIndenter li2;
 
-		//Assume digital, then change to analog if we see anything other than a 0/1 in the first 10 lines
+		//Assume digital, then change to analog if we see anything other than a 0/1 in the first 10 rows
 		bool digital = true;
-		for(size_t j=0; j<lines.size() && j<10; j++)
+		for(size_t j=0; j<nrows && j<10; j++)
 		{
-			string field = lines[j][i];
-			if( (field != "0") && (field != "1") )
+			const char* fstart;
+			const char* fend;
+			if(!GetDelimitedField(rows[j], i+1, ',', fstart, fend))
+			{
+				digital = false;
+				break;
+			}
+			if( (fend - fstart != 1) || ( (*fstart != '0') && (*fstart != '1') ) )
 			{
 				digital = false;
 				break;
@@ -290,7 +280,7 @@ void CSVImportFilter::OnFileNameChanged()
 			wfm->m_startTimestamp = timestamp;
 			wfm->m_startFemtoseconds = fs;
 			wfm->m_triggerPhase = 0;
-			wfm->Resize(lines.size());
+			wfm->Resize(nrows);
 			digwaves.push_back(wfm);
 
 			//no analog waveform
@@ -310,7 +300,7 @@ void CSVImportFilter::OnFileNameChanged()
 			wfm->m_startTimestamp = timestamp;
 			wfm->m_startFemtoseconds = fs;
 			wfm->m_triggerPhase = 0;
-			wfm->Resize(lines.size());
+			wfm->Resize(nrows);
 			anwaves.push_back(wfm);
 
 			//no digital waveform
@@ -321,46 +311,109 @@ void CSVImportFilter::OnFileNameChanged()
 
 	m_outputsChangedSignal.emit();
 
-	//Process each actual waveform and figure out how to handle it
-	for(size_t i=0; i<ncols; i++)
+	//Second pass: parse sample data in parallel across rows. Rows are independent, all fields are slices of
+	//the mapped file, and values go straight into the output waveforms, so there are no allocations and no
+	//shared state in the hot loop.
+	const bool xIsSeconds = (m_parameters[m_xunit].GetIntVal() == Unit::UNIT_FS);
+	vector<int64_t> timestamps(nrows);
+	size_t firstBadRow = nrows;
+	#pragma omp parallel for
+	for(size_t j=0; j<nrows; j++)
 	{
-		if(digwaves[i])
+		const char* lineEnd = rows[j].m_end;
+
+		//Timestamp column
+		const char* q = rows[j].m_start;
+		auto comma = static_cast<const char*>(memchr(q, ',', lineEnd - q));
+		const char* fend = comma ? comma : lineEnd;
+		if(xIsSeconds)
+			timestamps[j] = FS_PER_SECOND * ParseDouble(q, fend);
+		else
+			timestamps[j] = ParseInt64(q, fend);
+
+		//Data columns
+		size_t i = 0;
+		bool bad = false;
+		while(comma)
 		{
-			auto wfm = digwaves[i];
+			q = comma + 1;
+			comma = static_cast<const char*>(memchr(q, ',', lineEnd - q));
+			fend = comma ? comma : lineEnd;
 
-			//Read the sample data
-			auto nlines = min(lines.size(), timestamps.size());
-			for(size_t j=0; j<nlines; j++)
+			//Ignore an empty trailing field (row ends with a comma)
+			if( (q == fend) && !comma )
+				break;
+
+			//Too many fields
+			if(i >= ncols)
 			{
-				wfm->m_offsets[j] = timestamps[j];
+				bad = true;
+				break;
+			}
 
-				//Last one? copy previous sample duration
-				if(j+1 == lines.size())
-					wfm->m_durations[j] = wfm->m_durations[j-1];
+			if(digwaves[i])
+				digwaves[i]->m_samples[j] = (fend - q == 1) && (*q == '1');
+			else
+				anwaves[i]->m_samples[j] = ParseDouble(q, fend);
+			i ++;
+		}
+
+		//Malformed row: remember the first one so we can truncate there, like the serial parser did
+		if(bad || (i != ncols) )
+		{
+			#pragma omp critical
+			firstBadRow = min(firstBadRow, j);
+		}
+	}
 
-				//Set sample duration of previous sample
-				if(j > 0)
-					wfm->m_durations[j-1] = wfm->m_offsets[j] - wfm->m_offsets[j-1];
+	if(firstBadRow < nrows)
+	{
+		LogError("Malformed file (line %zu does not contain %zu fields)\n", rows[firstBadRow].m_row, ncols + 1);
+		nrows = firstBadRow;
+	}
 
-				//Read waveform data
-				if(lines[j][i] == "1")
-					wfm->m_samples[j] = true;
-				else
-					wfm->m_samples[j] = false;
-			}
+	//Compute durations: each sample lasts until the start of the next one, and the last copies the previous
+	vector<int64_t> durations(nrows);
+	#pragma omp parallel for
+	for(size_t j=0; j+1<nrows; j++)
+		durations[j] = timestamps[j+1] - timestamps[j];
+	if(nrows > 1)
+		durations[nrows-1] = durations[nrows-2];
+	else if(nrows == 1)
+		durations[0] = 0;
 
-			if(TryNormalizeTimebase(wfm))
+	//Process each actual waveform and figure out how to handle it
+	for(size_t i=0; i<ncols; i++)
+	{
+		SparseWaveformBase* wfm;
+		if(digwaves[i])
+			wfm = digwaves[i];
+		else
+			wfm = anwaves[i];
+
+		//Shrink if we stopped early at a malformed row, then fill in the shared timebase
+		wfm->Resize(nrows);
+		if(nrows)
+		{
+			memcpy(wfm->m_offsets.GetCpuPointer(), &timestamps[0], nrows * sizeof(int64_t));
+			memcpy(wfm->m_durations.GetCpuPointer(), &durations[0], nrows * sizeof(int64_t));
+		}
+
+		if(digwaves[i])
+		{
+			auto dwfm = digwaves[i];
+			if(TryNormalizeTimebase(dwfm))
 			{
-				auto dense = new UniformDigitalWaveform(*wfm);
+				auto dense = new UniformDigitalWaveform(*dwfm);
 				dense->MarkModifiedFromCpu();
 				SetData(dense, i);
 			}
 			else
 			{
-				wfm->MarkModifiedFromCpu();
+				dwfm->MarkModifiedFromCpu();
 
 				//If we end up with zero length samples due to invalid configuration, nuke the channel
-				if(wfm->empty() || (wfm->m_durations[0] == 0) )
+				if(dwfm->empty() || (dwfm->m_durations[0] == 0) )
 					SetData(nullptr, i);
 			}
 		}
@@ -368,46 +421,22 @@ void CSVImportFilter::OnFileNameChanged()
 		//Analog data
 		else
 		{
-			auto wfm = anwaves[i];
-
-			//Read the sample data
-			auto nlines = min(lines.size(), timestamps.size());
-			for(size_t j=0; j<nlines; j++)
+			auto awfm = anwaves[i];
+			if(TryNormalizeTimebase(awfm))
 			{
-				wfm->m_offsets[j] = timestamps[j];
-
-				//Last one? copy previous sample duration
-				if(j+1 == lines.size())
-					wfm->m_durations[j] = wfm->m_durations[j-1];
-
-				//Set sample duration of previous sample
-				if(j > 0)
-					wfm->m_durations[j-1] = wfm->m_offsets[j] - wfm->m_offsets[j-1];
-
-				//Read waveform data
-				float v;
-				auto tmp = lines[j][i];
-				if(tmp.find("e") == string::npos)
-					sscanf(tmp.c_str(), "%f", &v);
-				else
-					sscanf(tmp.c_str(), "%e", &v);
-				wfm->m_samples[j] = v;
-			}
-
-			if(TryNormalizeTimebase(wfm))
-			{
-				auto dense = new UniformAnalogWaveform(*wfm);
+				auto dense = new UniformAnalogWaveform(*awfm);
 				dense->MarkModifiedFromCpu();
 				SetData(dense, i);
 			}
 			else
 			{
-				wfm->MarkModifiedFromCpu();
+				awfm->MarkModifiedFromCpu();
 
 				//If we end up with zero length samples due to invalid configuration, nuke the channel
-				if(wfm->m_durations[0] == 0)
+				if(awfm->empty() || (awfm->m_durations[0] == 0) )
 					SetData(nullptr, i);
 			}
 		}
 	}
 }
+
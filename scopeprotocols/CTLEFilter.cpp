@@ -58,10 +58,29 @@ CTLEFilter::CTLEFilter(const string& color)
 	m_parameters[m_poleFreq2Name] = FilterParameter(FilterParameter::TYPE_FLOAT, Unit(Unit::UNIT_HZ));
 	m_parameters[m_poleFreq2Name].SetFloatVal(2e9);
 
+	//Parameter sweep: evaluate a batch of DC gain settings in one pass, one output stream per step.
+	//All steps share the input windowing and forward FFT (see DeEmbedFilter sweep support), so sweeping
+	//an equalizer during characterization costs far less than re-running the graph once per value.
+	m_sweepStepsName = "Sweep Steps";
+	m_parameters[m_sweepStepsName] = FilterParameter(FilterParameter::TYPE_INT, Unit(Unit::UNIT_COUNTS));
+	m_parameters[m_sweepStepsName].SetIntVal(1);
+	m_parameters[m_sweepStepsName].signal_changed().connect(sigc::mem_fun(*this, &CTLEFilter::OnSweepStepsChanged));
+
+	m_sweepStartName = "Sweep Start";
+	m_parameters[m_sweepStartName] = FilterParameter(FilterParameter::TYPE_FLOAT, Unit(Unit::UNIT_DB));
+	m_parameters[m_sweepStartName].SetFloatVal(-12);
+
+	m_sweepStopName = "Sweep Stop";
+	m_parameters[m_sweepStopName] = FilterParameter(FilterParameter::TYPE_FLOAT, Unit(Unit::UNIT_DB));
+	m_parameters[m_sweepStopName].SetFloatVal(0);
+
 	m_cachedDcGain = 1;
 	m_cachedZeroFreq = 1;
 	m_cachedPole1Freq = 1;
 	m_cachedPole2Freq = 1;
+	m_cachedSweepStart = 0;
+	m_cachedSweepStop = 0;
+	m_cachedSweepSteps = 1;
 
 	//delete s-param inputs
 	m_signalNames.resize(1);
@@ -89,6 +108,33 @@ void CTLEFilter::InterpolateSparameters(float bin_hz, bool /*invert*/, size_t no
 {
 	m_cachedBinSize = bin_hz;
 
+	//Single-value mode: one response from the current parameters
+	m_response = BuildResponse(m_cachedDcGain, bin_hz, nouts);
+
+	//Sweep mode: one response per step, evenly spaced from sweep start to stop
+	m_sweepResponses.clear();
+	size_t nsteps = GetSweepSize();
+	if(nsteps > 1)
+	{
+		float vstart = m_parameters[m_sweepStartName].GetFloatVal();
+		float vstop = m_parameters[m_sweepStopName].GetFloatVal();
+		for(size_t i=0; i<nsteps; i++)
+		{
+			float frac = i * 1.0f / (nsteps - 1);
+			m_sweepResponses.push_back(BuildResponse(vstart + (vstop - vstart)*frac, bin_hz, nouts));
+		}
+	}
+}
+
+/**
+	@brief Synthesizes the channel response for one DC gain setting
+ */
+shared_ptr<DeEmbedChannelResponse> CTLEFilter::BuildResponse(float dcgain_db, float bin_hz, size_t nouts)
+{
+	//Our response is synthesized from our own parameters rather than a shared S-parameter network,
+	//so it gets a private response object instead of going through the de-embed response cache
+	auto response = make_shared<DeEmbedChannelResponse>();
+
 	typedef complex<float> fcpx;
 
 	fcpx p0(0, -FreqToPhase(m_cachedPole1Freq));
@@ -99,7 +145,7 @@ void CTLEFilter::InterpolateSparameters(float bin_hz, bool /*invert*/, size_t no
 	float prescale = 1.0f / abs(zero / (p0*p1) );
 
 	//Multiply by our gain (in dB, so we have to convert to V/V)
-	prescale *= pow(10, m_cachedDcGain/20);
+	prescale *= pow(10, dcgain_db/20);
 
 	for(size_t i=0; i<nouts; i++)
 	{
@@ -109,9 +155,43 @@ void CTLEFilter::InterpolateSparameters(float bin_hz, bool /*invert*/, size_t no
 		//Phase correction seems unnecessary because this transfer function should be constant rotation?
 		//We get weird results when we do this, too.
 		float phase = 0;//arg(h);
-		m_resampledSparamSines.push_back(sin(phase) * abs(h));
-		m_resampledSparamCosines.push_back(cos(phase) * abs(h));
+		response->m_sines.push_back(sin(phase) * abs(h));
+		response->m_cosines.push_back(cos(phase) * abs(h));
 	}
+
+	return response;
+}
+
+size_t CTLEFilter::GetSweepSize()
+{
+	int64_t n = m_parameters[m_sweepStepsName].GetIntVal();
+	if(n < 1)
+		return 1;
+	return n;
+}
+
+void CTLEFilter::LoadSweepResponse(size_t step, float bin_hz, bool /*invert*/, size_t nouts)
+{
+	//Responses may be stale if only the sweep configuration changed; rebuild if the count doesn't match
+	if(m_sweepResponses.size() != GetSweepSize())
+		InterpolateSparameters(bin_hz, false, nouts);
+
+	if(step < m_sweepResponses.size())
+		m_response = m_sweepResponses[step];
+}
+
+/**
+	@brief Adds or removes output streams when the sweep step count changes
+ */
+void CTLEFilter::OnSweepStepsChanged()
+{
+	size_t nsteps = GetSweepSize();
+
+	//One output stream per sweep step (stream 0 keeps the legacy name so existing sessions load unchanged)
+	ClearStreams();
+	AddStream(Unit(Unit::UNIT_VOLTS), "data", Stream::STREAM_TYPE_ANALOG);
+	for(size_t i=1; i<nsteps; i++)
+		AddStream(Unit(Unit::UNIT_VOLTS), string("step") + to_string(i), Stream::STREAM_TYPE_ANALOG);
 }
 
 void CTLEFilter::Refresh(vk::raii::CommandBuffer& cmdBuf, shared_ptr<QueueHandle> queue)
@@ -121,12 +201,18 @@ void CTLEFilter::Refresh(vk::raii::CommandBuffer& cmdBuf, shared_ptr<QueueHandle
 	float zfreq = m_parameters[m_zeroFreqName].GetFloatVal();
 	float pole1 = m_parameters[m_poleFreq1Name].GetFloatVal();
 	float pole2 = m_parameters[m_poleFreq2Name].GetFloatVal();
+	float sweepstart = m_parameters[m_sweepStartName].GetFloatVal();
+	float sweepstop = m_parameters[m_sweepStopName].GetFloatVal();
+	size_t sweepsteps = GetSweepSize();
 
 	 if(
 		(dcgain_db != m_cachedDcGain) ||
 		(zfreq != m_cachedZeroFreq) ||
 		(pole1 != m_cachedPole1Freq) ||
-		(pole2 != m_cachedPole2Freq) )
+		(pole2 != m_cachedPole2Freq) ||
+		(sweepstart != m_cachedSweepStart) ||
+		(sweepstop != m_cachedSweepStop) ||
+		(sweepsteps != m_cachedSweepSteps) )
 	{
 		//force re-interpolation of S-parameters
 		m_cachedBinSize = 0;
@@ -135,6 +221,9 @@ void CTLEFilter::Refresh(vk::raii::CommandBuffer& cmdBuf, shared_ptr<QueueHandle
 		m_cachedZeroFreq = zfreq;
 		m_cachedPole1Freq = pole1;
 		m_cachedPole2Freq = pole2;
+		m_cachedSweepStart = sweepstart;
+		m_cachedSweepStop = sweepstop;
+		m_cachedSweepSteps = sweepsteps;
 	}
 
 	//Do the actual refresh operation
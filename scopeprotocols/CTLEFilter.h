@@ -51,16 +51,30 @@ public:
 protected:
 	virtual int64_t GetGroupDelay() override;
 	virtual void InterpolateSparameters(float bin_hz, bool invert, size_t nouts) override;
+	virtual size_t GetSweepSize() override;
+	virtual void LoadSweepResponse(size_t step, float bin_hz, bool invert, size_t nouts) override;
+
+	void OnSweepStepsChanged();
+	std::shared_ptr<DeEmbedChannelResponse> BuildResponse(float dcgain_db, float bin_hz, size_t nouts);
 
 	std::string m_dcGainName;
 	std::string m_zeroFreqName;
 	std::string m_poleFreq1Name;
 	std::string m_poleFreq2Name;
+	std::string m_sweepStepsName;
+	std::string m_sweepStartName;
+	std::string m_sweepStopName;
 
 	float m_cachedDcGain;
 	float m_cachedZeroFreq;
 	float m_cachedPole1Freq;
 	float m_cachedPole2Freq;
+	float m_cachedSweepStart;
+	float m_cachedSweepStop;
+	size_t m_cachedSweepSteps;
+
+	///@brief Per-step responses for sweep mode
+	std::vector<std::shared_ptr<DeEmbedChannelResponse> > m_sweepResponses;
 };
 
 #endif
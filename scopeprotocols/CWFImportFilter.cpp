@@ -0,0 +1,113 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopeprotocols                                                                                                    *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Implementation of CWFImportFilter
+ */
+#include "../scopehal/scopehal.h"
+#include "CWFImportFilter.h"
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Construction / destruction
+
+CWFImportFilter::CWFImportFilter(const string& color)
+	: ImportFilter(color)
+{
+	m_fpname = "CWF File";
+	m_parameters[m_fpname] = FilterParameter(FilterParameter::TYPE_FILENAME, Unit(Unit::UNIT_COUNTS));
+	m_parameters[m_fpname].m_fileFilterMask = "*.cwf";
+	m_parameters[m_fpname].m_fileFilterName = "Columnar waveform files (*.cwf)";
+	m_parameters[m_fpname].signal_changed().connect(sigc::mem_fun(*this, &CWFImportFilter::OnFileNameChanged));
+
+	//Optional time range: when both are zero, the full capture is loaded. Anything else loads only the
+	//samples overlapping the range, decompressing only the zstd frames it touches for compressed archives.
+	m_startname = "Start Time";
+	m_parameters[m_startname] = FilterParameter(FilterParameter::TYPE_INT, Unit(Unit::UNIT_FS));
+	m_parameters[m_startname].SetIntVal(0);
+	m_parameters[m_startname].signal_changed().connect(sigc::mem_fun(*this, &CWFImportFilter::OnFileNameChanged));
+
+	m_endname = "End Time";
+	m_parameters[m_endname] = FilterParameter(FilterParameter::TYPE_INT, Unit(Unit::UNIT_FS));
+	m_parameters[m_endname].SetIntVal(0);
+	m_parameters[m_endname].signal_changed().connect(sigc::mem_fun(*this, &CWFImportFilter::OnFileNameChanged));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Accessors
+
+string CWFImportFilter::GetProtocolName()
+{
+	return "CWF Import";
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Actual decoder logic
+
+void CWFImportFilter::OnFileNameChanged()
+{
+	auto fname = m_parameters[m_fpname].ToString();
+	if(fname.empty())
+		return;
+
+	LogDebug("Reading CWF file %s\n", fname.c_str());
+	LogIndenter li;
+
+	//Load the whole capture, or just the requested window of it
+	int64_t start = m_parameters[m_startname].GetIntVal();
+	int64_t end = m_parameters[m_endname].GetIntVal();
+	WaveformBase* wfm;
+	if( (start == 0) && (end == 0) )
+		wfm = WaveformFile::Load(fname);
+	else
+		wfm = WaveformFile::LoadTimeRange(fname, start, end);
+	if(!wfm)
+	{
+		LogError("Couldn't load waveform file \"%s\"\n", fname.c_str());
+		return;
+	}
+
+	//The file doesn't record a Y axis unit, so assume volts
+	//(matching what WaveformHistory spills and session archives contain today)
+	ClearStreams();
+	bool digital = dynamic_cast<UniformDigitalWaveform*>(wfm) || dynamic_cast<SparseDigitalWaveform*>(wfm);
+	if(digital)
+		AddStream(Unit(Unit::UNIT_VOLTS), "data", Stream::STREAM_TYPE_DIGITAL);
+	else
+		AddStream(Unit(Unit::UNIT_VOLTS), "data", Stream::STREAM_TYPE_ANALOG);
+	SetData(wfm, 0);
+
+	if(!digital)
+		AutoscaleVertical(0);
+
+	m_outputsChangedSignal.emit();
+}
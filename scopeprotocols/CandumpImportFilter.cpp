@@ -33,6 +33,20 @@
 
 using namespace std;
 
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Fast parsing helpers
+
+namespace
+{
+	///@brief Returns the value of a hex digit (which must actually be one)
+	unsigned int HexVal(char c)
+	{
+		if(isdigit((unsigned char)c))
+			return c - '0';
+		return (tolower((unsigned char)c) - 'a') + 10;
+	}
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Construction / destruction
 
@@ -94,13 +108,14 @@ void CandumpImportFilter::OnFileNameChanged()
 	//Set unit
 	SetXAxisUnits(Unit(Unit::UNIT_FS));
 
-	//Open the input file
-	FILE* fp = fopen(fname.c_str(), "r");
-	if(!fp)
+	//Map the whole log and scan it in bulk rather than fgets/sscanf per line
+	MappedFileView file(fname);
+	if(!file.IsValid())
 	{
 		LogError("Couldn't open candump file \"%s\"\n", fname.c_str());
 		return;
 	}
+	const char* fend = file.m_data + file.m_len;
 
 	//Create output waveform
 	auto cap = new CANWaveform;
@@ -113,40 +128,121 @@ void CandumpImportFilter::OnFileNameChanged()
 	int64_t baud = m_parameters[m_datarate].GetIntVal();
 	int64_t ui = FS_PER_SECOND / baud;
 
-	//Read the file and process line by line
+	//Count lines up front so the sample and packet storage can be sized in one shot
+	//(a frame emits at most 14 timeline samples: 6 header fields plus up to 8 data bytes)
+	size_t nlines = 0;
+	for(const char* p = file.m_data; p < fend; )
+	{
+		nlines++;
+		auto nl = (const char*)memchr(p, '\n', fend - p);
+		if(!nl)
+			break;
+		p = nl + 1;
+	}
+	cap->m_offsets.reserve(nlines * 14);
+	cap->m_durations.reserve(nlines * 14);
+	cap->m_samples.reserve(nlines * 14);
+	m_packets.reserve(nlines);
+
+	//Fleet logs carry a handful of distinct IDs across millions of frames, so format each one only once
+	map<unsigned int, string> idText;
+	string lenText[9];
+	for(int i=0; i<=8; i++)
+		lenText[i] = to_string(i);
+	const string hID("ID");
+	const string hFormat("Format");
+	const string hMode("Mode");
+	const string hLen("Len");
+	const string vExt("EXT");
+	const string vBase("BASE");
+	const string vCan("CAN");
+
+	//Scan the log line by line
 	bool first = true;
-	double timestamp;
-	char sinterface[128];
-	unsigned int id;
-	unsigned int dbytes[8];
 	double tstart = 0;
-	char line[1024] = {0};
 	int64_t tend = 0;
-	while(!feof(fp))
+	const char* p = file.m_data;
+	while(p < fend)
 	{
-		if(!fgets(line, sizeof(line), fp))
-			break;
+		//Find the end of this line
+		auto nl = (const char*)memchr(p, '\n', fend - p);
+		const char* lend = nl ? nl : fend;
+		const char* q = p;
+		p = nl ? (nl + 1) : fend;
+
+		//Parse the line in place, skipping malformed ones
+		//Expected format: (timestamp) interface id#data
 
-		//Read and skip malformed lines
-		int nfields = sscanf(
-			line,
-			"(%lf) %127s %x#%02x%02x%02x%02x%02x%02x%02x%02x",
-			&timestamp,
-			sinterface,
-			&id,
-			dbytes + 0,
-			dbytes + 1,
-			dbytes + 2,
-			dbytes + 3,
-			dbytes + 4,
-			dbytes + 5,
-			dbytes + 6,
-			dbytes + 7);
-		if(nfields < 3)
+		//Timestamp: integer seconds, then an optional fraction
+		if( (q >= lend) || (*q != '(') )
 			continue;
+		q++;
+		double timestamp = 0;
+		bool digits = false;
+		while( (q < lend) && isdigit((unsigned char)*q) )
+		{
+			timestamp = timestamp*10 + (*q - '0');
+			q++;
+			digits = true;
+		}
+		if( (q < lend) && (*q == '.') )
+		{
+			q++;
+			double scale = 0.1;
+			while( (q < lend) && isdigit((unsigned char)*q) )
+			{
+				timestamp += (*q - '0') * scale;
+				scale *= 0.1;
+				q++;
+				digits = true;
+			}
+		}
+		if(!digits || (q >= lend) || (*q != ')') )
+			continue;
+		q++;
+
+		//Interface name (which we don't use)
+		while( (q < lend) && isspace((unsigned char)*q) )
+			q++;
+		const char* iface = q;
+		while( (q < lend) && !isspace((unsigned char)*q) )
+			q++;
+		if(q == iface)
+			continue;
+		while( (q < lend) && isspace((unsigned char)*q) )
+			q++;
 
-		//See how many data bytes we have
-		int nbytes = nfields - 3;
+		//Message ID
+		unsigned int id = 0;
+		const char* idstart = q;
+		while( (q < lend) && isxdigit((unsigned char)*q) )
+		{
+			id = (id << 4) | HexVal(*q);
+			q++;
+		}
+		if(q == idstart)
+			continue;
+
+		//Data bytes after the '#' separator (a frame with no separator is a zero byte frame,
+		//matching what the old sscanf format string accepted)
+		unsigned int dbytes[8];
+		int nbytes = 0;
+		if( (q < lend) && (*q == '#') )
+		{
+			q++;
+			while( (nbytes < 8) && (q < lend) && isxdigit((unsigned char)*q) )
+			{
+				unsigned int b = HexVal(*q);
+				q++;
+				if( (q < lend) && isxdigit((unsigned char)*q) )
+				{
+					b = (b << 4) | HexVal(*q);
+					q++;
+				}
+				dbytes[nbytes] = b;
+				nbytes++;
+			}
+		}
 
 		//Calculate relative timestamp
 		int64_t trel = 0;
@@ -217,10 +313,13 @@ void CandumpImportFilter::OnFileNameChanged()
 			pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_DATA_READ];
 		else
 			pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_DATA_WRITE];
-		pack->m_headers["ID"] = to_string_hex(id);
-		pack->m_headers["Format"] = ext ? "EXT" : "BASE";
-		pack->m_headers["Mode"] = "CAN";
-		pack->m_headers["Len"] = to_string(nbytes);
+		auto& sid = idText[id];
+		if(sid.empty())
+			sid = to_string_hex(id);
+		pack->m_headers[hID] = sid;
+		pack->m_headers[hFormat] = ext ? vExt : vBase;
+		pack->m_headers[hMode] = vCan;
+		pack->m_headers[hLen] = lenText[nbytes];
 		for(int i=0; i<nbytes; i++)
 			pack->m_data.push_back(dbytes[i]);
 		pack->m_offset = trel;
@@ -228,7 +327,7 @@ void CandumpImportFilter::OnFileNameChanged()
 		m_packets.push_back(pack);
 	}
 
-	fclose(fp);
+	cap->MarkModifiedFromCpu();
 }
 
 bool CandumpImportFilter::ValidateChannel(size_t /*i*/, StreamDescriptor /*stream*/)
@@ -37,8 +37,32 @@ using namespace std;
 
 ChannelEmulationFilter::ChannelEmulationFilter(const string& color)
 	: DeEmbedFilter(color)
+	, m_modeName("Convolution Mode")
+	, m_blockSizeName("Block Size")
+	, m_irLengthName("Impulse Response Length")
+	, m_cachedIrBinSize(0)
+	, m_cachedIrLength(0)
+	, m_cachedBlockLength(0)
+	, m_cachedNumBlocks(0)
+	, m_blockGatherComputePipeline("shaders/BlockConvolutionGather.spv", 2, sizeof(BlockConvolutionGatherArgs))
+	, m_blockAccumulateComputePipeline("shaders/BlockConvolutionAccumulate.spv", 3, sizeof(BlockConvolutionAccumulateArgs))
+	, m_blockOutputComputePipeline("shaders/BlockConvolutionOutput.spv", 2, sizeof(BlockConvolutionOutputArgs))
 {
 	m_parameters[m_maxGainName].MarkHidden();
+
+	//The partitioned convolution path reads a single network directly, so cascade mode doesn't apply here
+	m_parameters[m_stageCountName].MarkHidden();
+
+	m_parameters[m_modeName] = FilterParameter(FilterParameter::TYPE_ENUM, Unit(Unit::UNIT_COUNTS));
+	m_parameters[m_modeName].AddEnumValue("Full Record", MODE_FULL_RECORD);
+	m_parameters[m_modeName].AddEnumValue("Partitioned (Streaming)", MODE_PARTITIONED);
+	m_parameters[m_modeName].SetIntVal(MODE_FULL_RECORD);
+
+	m_parameters[m_blockSizeName] = FilterParameter(FilterParameter::TYPE_INT, Unit(Unit::UNIT_SAMPLEDEPTH));
+	m_parameters[m_blockSizeName].SetIntVal(32768);
+
+	m_parameters[m_irLengthName] = FilterParameter(FilterParameter::TYPE_INT, Unit(Unit::UNIT_SAMPLEDEPTH));
+	m_parameters[m_irLengthName].SetIntVal(256 * 1024);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -54,5 +78,267 @@ string ChannelEmulationFilter::GetProtocolName()
 
 void ChannelEmulationFilter::Refresh(vk::raii::CommandBuffer& cmdBuf, shared_ptr<QueueHandle> queue)
 {
-	DoRefresh(false, cmdBuf, queue);
+	if(m_parameters[m_modeName].GetIntVal() == MODE_PARTITIONED)
+		RefreshPartitioned(cmdBuf, queue);
+	else
+		DoRefresh(false, cmdBuf, queue);
+}
+
+/**
+	@brief Applies the channel model as a partitioned convolution in streaming blocks
+
+	The full-record path FFTs the entire input at next_pow2(record length) each trigger, which gets slow for
+	deep memory. Here the channel's impulse response is derived once from the S-parameters, split into uniform
+	partitions, and each partition's spectrum is cached across triggers. The input is then processed in fixed
+	size overlap-save blocks: one batched forward FFT of all blocks, a frequency domain multiply-accumulate of
+	each block spectrum against the partition spectra (a frequency domain delay line), one batched inverse FFT,
+	and extraction of the valid half of each block. Cost per trigger is bounded by the block size regardless of
+	how long the impulse response is.
+
+	The impulse response is truncated to the "Impulse Response Length" parameter; energy beyond that point is
+	lost, so it should be set comfortably longer than the channel's delay plus dispersion tail.
+ */
+void ChannelEmulationFilter::RefreshPartitioned(vk::raii::CommandBuffer& cmdBuf, shared_ptr<QueueHandle> queue)
+{
+	//Make sure we've got valid inputs
+	if(!VerifyAllInputsOK())
+	{
+		SetData(NULL, 0);
+		return;
+	}
+	auto din = dynamic_cast<UniformAnalogWaveform*>(GetInputWaveform(0));
+	if(!din || (GetInputCount() < 3))
+	{
+		SetData(NULL, 0);
+		return;
+	}
+	const size_t npoints_raw = din->size();
+
+	//Round the block size down to a power of two and derive the rest of the geometry from it.
+	//Each FFT slot holds one block plus one block of history (overlap-save).
+	const size_t blocklen = prev_pow2((size_t)max(m_parameters[m_blockSizeName].GetIntVal(), (int64_t)1024));
+	const size_t fftlen = 2*blocklen;
+	const size_t nbins = fftlen/2 + 1;
+	const size_t irlen = next_pow2(max((size_t)max(m_parameters[m_irLengthName].GetIntVal(), (int64_t)1), fftlen));
+	const size_t npartitions = irlen / blocklen;
+	const size_t nblocks = (npoints_raw + blocklen - 1) / blocklen;
+
+	//Bin size for sampling the frequency response when deriving the impulse response
+	double bin_hz = (FS_PER_SECOND / din->m_timescale) / irlen;
+
+	//Waveform object changed? Cached impulse response partitions are no longer valid
+	bool inchange = false;
+	auto dmag = GetInput(1).GetData();
+	auto dang = GetInput(2).GetData();
+	if( (m_irMagKey != dmag) || (m_irAngleKey != dang) )
+	{
+		inchange = true;
+		m_irMagKey = dmag;
+		m_irAngleKey = dang;
+	}
+
+	//Rebuild the transformed impulse response partitions if anything they depend on changed
+	if( inchange ||
+		m_partitionSpectra.empty() ||
+		(fabs(m_cachedIrBinSize - bin_hz) > FLT_EPSILON) ||
+		(m_cachedIrLength != irlen) ||
+		(m_cachedBlockLength != blocklen) )
+	{
+		BuildImpulseResponsePartitions(irlen, blocklen, npartitions, fftlen, bin_hz, cmdBuf, queue);
+	}
+
+	//Calculate maximum group delay for the first few S-parameter bins (approx propagation delay of the channel)
+	int64_t groupdelay_fs = GetGroupDelay();
+	if(m_parameters[m_groupDelayTruncModeName].GetIntVal() == TRUNC_MANUAL)
+		groupdelay_fs = m_parameters[m_groupDelayTruncName].GetIntVal();
+	int64_t groupdelay_samples = ceil( groupdelay_fs / din->m_timescale );
+	if(static_cast<size_t>(llabs(groupdelay_samples)) >= npoints_raw)
+	{
+		groupdelay_fs = 0;
+		groupdelay_samples = 0;
+	}
+
+	//Set up output, skipping the garbage response at the start of the record (same as the full-record path)
+	size_t istart = groupdelay_samples;
+	size_t outlen = npoints_raw - istart;
+	auto cap = SetupEmptyUniformAnalogOutputWaveform(din, 0);
+	cap->m_triggerPhase = groupdelay_fs;
+	cap->Resize(outlen);
+
+	//Reallocate per-trigger block buffers and plans if the record length changed
+	if(m_cachedNumBlocks != nblocks)
+	{
+		m_blockTime.SetCpuAccessHint(AcceleratorBuffer<float>::HINT_NEVER);
+		m_blockTime.SetGpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
+		m_blockSpectra.SetCpuAccessHint(AcceleratorBuffer<float>::HINT_NEVER);
+		m_blockSpectra.SetGpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
+		m_convSpectra.SetCpuAccessHint(AcceleratorBuffer<float>::HINT_NEVER);
+		m_convSpectra.SetGpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
+		m_blockOutTime.SetCpuAccessHint(AcceleratorBuffer<float>::HINT_NEVER);
+		m_blockOutTime.SetGpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
+	}
+	m_blockTime.resize(nblocks * fftlen);
+	m_blockSpectra.resize(nblocks * 2*nbins);
+	m_convSpectra.resize(nblocks * 2*nbins);
+	m_blockOutTime.resize(nblocks * fftlen);
+
+	if(!m_vkBlockForwardPlan || (m_vkBlockForwardPlan->size() != fftlen) || (m_cachedNumBlocks != nblocks) )
+		m_vkBlockForwardPlan = g_vkFFTPlanCache.Acquire(fftlen, nbins, VulkanFFTPlan::DIRECTION_FORWARD, nblocks);
+	if(!m_vkBlockReversePlan || (m_vkBlockReversePlan->size() != fftlen) || (m_cachedNumBlocks != nblocks) )
+		m_vkBlockReversePlan = g_vkFFTPlanCache.Acquire(fftlen, nbins, VulkanFFTPlan::DIRECTION_REVERSE, nblocks);
+	m_cachedNumBlocks = nblocks;
+
+	//Prepare to do all of our compute stuff in one dispatch call to reduce overhead
+	cmdBuf.begin({});
+
+	//Gather the overlapped input blocks into zero-padded FFT slots
+	BlockConvolutionGatherArgs gargs;
+	gargs.inlen = npoints_raw;
+	gargs.copyLen = fftlen;
+	gargs.blockLen = blocklen;
+	gargs.fftlen = fftlen;
+	gargs.nblocks = nblocks;
+	gargs.preShift = blocklen;
+	m_blockGatherComputePipeline.BindBufferNonblocking(0, din->m_samples, cmdBuf);
+	m_blockGatherComputePipeline.BindBufferNonblocking(1, m_blockTime, cmdBuf, true);
+	m_blockGatherComputePipeline.Dispatch(cmdBuf, gargs, GetComputeBlockCount(nblocks*fftlen, 64));
+	m_blockGatherComputePipeline.AddComputeMemoryBarrier(cmdBuf);
+	m_blockTime.MarkModifiedFromGpu();
+
+	//Forward FFT all of the blocks in one batched call
+	m_vkBlockForwardPlan->AppendForward(m_blockTime, m_blockSpectra, cmdBuf);
+	ComputePipeline::AddComputeMemoryBarrier(cmdBuf);
+
+	//Frequency domain accumulation against the cached impulse response partitions
+	BlockConvolutionAccumulateArgs aargs;
+	aargs.nbins = nbins;
+	aargs.nblocks = nblocks;
+	aargs.npartitions = npartitions;
+	m_blockAccumulateComputePipeline.BindBufferNonblocking(0, m_blockSpectra, cmdBuf);
+	m_blockAccumulateComputePipeline.BindBufferNonblocking(1, m_partitionSpectra, cmdBuf);
+	m_blockAccumulateComputePipeline.BindBufferNonblocking(2, m_convSpectra, cmdBuf, true);
+	m_blockAccumulateComputePipeline.Dispatch(cmdBuf, aargs, GetComputeBlockCount(nblocks*nbins, 64));
+	m_blockAccumulateComputePipeline.AddComputeMemoryBarrier(cmdBuf);
+	m_convSpectra.MarkModifiedFromGpu();
+
+	//Inverse FFT back to the time domain, again one batched call
+	m_vkBlockReversePlan->AppendReverse(m_convSpectra, m_blockOutTime, cmdBuf);
+	ComputePipeline::AddComputeMemoryBarrier(cmdBuf);
+
+	//Extract the valid half of each block and normalize
+	BlockConvolutionOutputArgs oargs;
+	oargs.outlen = outlen;
+	oargs.istart = istart;
+	oargs.blockLen = blocklen;
+	oargs.fftlen = fftlen;
+	oargs.scale = 1.0 / ((double)fftlen * irlen);
+	m_blockOutputComputePipeline.BindBufferNonblocking(0, m_blockOutTime, cmdBuf);
+	m_blockOutputComputePipeline.BindBufferNonblocking(1, cap->m_samples, cmdBuf, true);
+	m_blockOutputComputePipeline.Dispatch(cmdBuf, oargs, GetComputeBlockCount(outlen, 64));
+	m_blockOutputComputePipeline.AddComputeMemoryBarrier(cmdBuf);
+
+	//Done, block until the compute operations finish
+	cmdBuf.end();
+	queue->SubmitAndBlock(cmdBuf);
+	cap->MarkModifiedFromGpu();
+}
+
+/**
+	@brief Derives the channel impulse response from the S-parameters and transforms its partitions
+
+	Samples the frequency response at the impulse response resolution, inverse FFTs it to get the (truncated)
+	time domain impulse response, then splits that into uniform partitions and forward FFTs them all in one
+	batched call. The resulting partition spectra are cached across triggers.
+ */
+void ChannelEmulationFilter::BuildImpulseResponsePartitions(
+	size_t irlen,
+	size_t blocklen,
+	size_t npartitions,
+	size_t fftlen,
+	double bin_hz,
+	vk::raii::CommandBuffer& cmdBuf,
+	shared_ptr<QueueHandle> queue)
+{
+	LogTrace("ChannelEmulationFilter: rebuilding %zu impulse response partitions of %zu points\n",
+		npartitions, blocklen);
+
+	//Extract the S-parameters
+	auto wmag = GetInputWaveform(1);
+	auto wang = GetInputWaveform(2);
+	wmag->PrepareForCpuAccess();
+	wang->PrepareForCpuAccess();
+
+	auto smag = dynamic_cast<SparseAnalogWaveform*>(wmag);
+	auto sang = dynamic_cast<SparseAnalogWaveform*>(wang);
+	auto umag = dynamic_cast<UniformAnalogWaveform*>(wmag);
+	auto uang = dynamic_cast<UniformAnalogWaveform*>(wang);
+
+	if(smag && sang)
+		m_cachedSparams.ConvertFromWaveforms(smag, sang);
+	else
+		m_cachedSparams.ConvertFromWaveforms(umag, uang);
+
+	//Sample the frequency response at the impulse response resolution
+	size_t nbins_ir = irlen/2 + 1;
+	m_irSpectrum.SetCpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
+	m_irSpectrum.SetGpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
+	m_irSpectrum.resize(2 * nbins_ir);
+	for(size_t i=0; i<nbins_ir; i++)
+	{
+		float freq = bin_hz * i;
+		auto pt = m_cachedSparams.InterpolatePoint(freq);
+		m_irSpectrum[i*2] = pt.m_amplitude * cos(pt.m_phase);
+		m_irSpectrum[i*2 + 1] = pt.m_amplitude * sin(pt.m_phase);
+	}
+	m_irSpectrum.MarkModifiedFromCpu();
+
+	//Allocate buffers for the impulse response and its transformed partitions
+	m_irTime.SetCpuAccessHint(AcceleratorBuffer<float>::HINT_NEVER);
+	m_irTime.SetGpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
+	m_irTime.resize(irlen);
+	m_partitionTime.SetCpuAccessHint(AcceleratorBuffer<float>::HINT_NEVER);
+	m_partitionTime.SetGpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
+	m_partitionTime.resize(npartitions * fftlen);
+	m_partitionSpectra.SetCpuAccessHint(AcceleratorBuffer<float>::HINT_NEVER);
+	m_partitionSpectra.SetGpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
+	m_partitionSpectra.resize(npartitions * 2*(fftlen/2 + 1));
+
+	if(!m_vkIrReversePlan || (m_vkIrReversePlan->size() != irlen) )
+		m_vkIrReversePlan = g_vkFFTPlanCache.Acquire(irlen, nbins_ir, VulkanFFTPlan::DIRECTION_REVERSE);
+	if( !m_vkPartitionForwardPlan ||
+		(m_vkPartitionForwardPlan->size() != fftlen) ||
+		(m_cachedIrLength != irlen) ||
+		(m_cachedBlockLength != blocklen) )
+	{
+		m_vkPartitionForwardPlan = g_vkFFTPlanCache.Acquire(
+			fftlen, fftlen/2 + 1, VulkanFFTPlan::DIRECTION_FORWARD, npartitions);
+	}
+
+	//Inverse FFT the frequency response, split it into zero-padded partitions and transform them
+	cmdBuf.begin({});
+
+	m_vkIrReversePlan->AppendReverse(m_irSpectrum, m_irTime, cmdBuf);
+	ComputePipeline::AddComputeMemoryBarrier(cmdBuf);
+
+	BlockConvolutionGatherArgs gargs;
+	gargs.inlen = irlen;
+	gargs.copyLen = blocklen;
+	gargs.blockLen = blocklen;
+	gargs.fftlen = fftlen;
+	gargs.nblocks = npartitions;
+	gargs.preShift = 0;
+	m_blockGatherComputePipeline.BindBufferNonblocking(0, m_irTime, cmdBuf);
+	m_blockGatherComputePipeline.BindBufferNonblocking(1, m_partitionTime, cmdBuf, true);
+	m_blockGatherComputePipeline.Dispatch(cmdBuf, gargs, GetComputeBlockCount(npartitions*fftlen, 64));
+	m_blockGatherComputePipeline.AddComputeMemoryBarrier(cmdBuf);
+	m_partitionTime.MarkModifiedFromGpu();
+
+	m_vkPartitionForwardPlan->AppendForward(m_partitionTime, m_partitionSpectra, cmdBuf);
+
+	cmdBuf.end();
+	queue->SubmitAndBlock(cmdBuf);
+
+	m_cachedIrBinSize = bin_hz;
+	m_cachedIrLength = irlen;
+	m_cachedBlockLength = blocklen;
 }
@@ -37,6 +37,32 @@
 
 #include "DeEmbedFilter.h"
 
+struct BlockConvolutionGatherArgs
+{
+	uint32_t inlen;
+	uint32_t copyLen;
+	uint32_t blockLen;
+	uint32_t fftlen;
+	uint32_t nblocks;
+	int32_t preShift;
+};
+
+struct BlockConvolutionAccumulateArgs
+{
+	uint32_t nbins;
+	uint32_t nblocks;
+	uint32_t npartitions;
+};
+
+struct BlockConvolutionOutputArgs
+{
+	uint32_t outlen;
+	uint32_t istart;
+	uint32_t blockLen;
+	uint32_t fftlen;
+	float scale;
+};
+
 class ChannelEmulationFilter : public DeEmbedFilter
 {
 public:
@@ -47,6 +73,57 @@ public:
 	static std::string GetProtocolName();
 
 	PROTOCOL_DECODER_INITPROC(ChannelEmulationFilter)
+
+	enum ConvolutionMode
+	{
+		MODE_FULL_RECORD,
+		MODE_PARTITIONED
+	};
+
+protected:
+	void RefreshPartitioned(vk::raii::CommandBuffer& cmdBuf, std::shared_ptr<QueueHandle> queue);
+	void BuildImpulseResponsePartitions(
+		size_t irlen,
+		size_t blocklen,
+		size_t npartitions,
+		size_t fftlen,
+		double bin_hz,
+		vk::raii::CommandBuffer& cmdBuf,
+		std::shared_ptr<QueueHandle> queue);
+
+	std::string m_modeName;
+	std::string m_blockSizeName;
+	std::string m_irLengthName;
+
+	//Cache state for the transformed impulse response partitions
+	//(separate keys from the base class so switching modes can't leave either path with stale data)
+	WaveformCacheKey m_irMagKey;
+	WaveformCacheKey m_irAngleKey;
+	double m_cachedIrBinSize;
+	size_t m_cachedIrLength;
+	size_t m_cachedBlockLength;
+	size_t m_cachedNumBlocks;
+
+	//Impulse response derivation (rebuilt only when the S-parameters or sizes change)
+	AcceleratorBuffer<float> m_irSpectrum;
+	AcceleratorBuffer<float> m_irTime;
+	AcceleratorBuffer<float> m_partitionTime;
+	AcceleratorBuffer<float> m_partitionSpectra;
+
+	//Per-trigger streaming block state
+	AcceleratorBuffer<float> m_blockTime;
+	AcceleratorBuffer<float> m_blockSpectra;
+	AcceleratorBuffer<float> m_convSpectra;
+	AcceleratorBuffer<float> m_blockOutTime;
+
+	std::shared_ptr<VulkanFFTPlan> m_vkIrReversePlan;
+	std::shared_ptr<VulkanFFTPlan> m_vkPartitionForwardPlan;
+	std::shared_ptr<VulkanFFTPlan> m_vkBlockForwardPlan;
+	std::shared_ptr<VulkanFFTPlan> m_vkBlockReversePlan;
+
+	ComputePipeline m_blockGatherComputePipeline;
+	ComputePipeline m_blockAccumulateComputePipeline;
+	ComputePipeline m_blockOutputComputePipeline;
 };
 
 #endif
@@ -74,6 +74,17 @@ string ClipFilter::GetProtocolName()
 	return "Clip";
 }
 
+bool ClipFilter::GetElementwiseOperation(ElementwiseOperation& op)
+{
+	//Clipping above a level is min(), clipping below is max()
+	if(m_parameters[m_clipAboveName].GetIntVal())
+		op.m_op = ElementwiseOperation::OP_MIN;
+	else
+		op.m_op = ElementwiseOperation::OP_MAX;
+	op.m_operand = m_parameters[m_clipLevelName].GetFloatVal();
+	return true;
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Actual decoder logic
 
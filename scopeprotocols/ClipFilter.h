@@ -42,6 +42,8 @@ public:
 
 	virtual void Refresh() override;
 
+	virtual bool GetElementwiseOperation(ElementwiseOperation& op) override;
+
 	static std::string GetProtocolName();
 
 	virtual bool ValidateChannel(size_t i, StreamDescriptor stream) override;
@@ -39,6 +39,9 @@ using namespace std;
 
 ClockRecoveryFilter::ClockRecoveryFilter(const string& color)
 	: Filter(color, CAT_CLOCK)
+	, m_hasLock(false)
+	, m_lockedPeriod(0)
+	, m_lockedBaud(0)
 {
 	AddDigitalStream("data");
 	CreateInput("IN");
@@ -52,6 +55,12 @@ ClockRecoveryFilter::ClockRecoveryFilter(const string& color)
 	m_parameters[m_threshname] = FilterParameter(FilterParameter::TYPE_FLOAT, Unit(Unit::UNIT_VOLTS));
 	m_parameters[m_threshname].SetFloatVal(0);
 
+	//Opt-in: seed the NCO with the frequency recovered from the previous waveform instead of the nominal
+	//symbol rate, so back-to-back captures of the same stream skip most of the lock acquisition preamble
+	m_carryname = "Carry lock between waveforms";
+	m_parameters[m_carryname] = FilterParameter(FilterParameter::TYPE_BOOL, Unit(Unit::UNIT_COUNTS));
+	m_parameters[m_carryname].SetBoolVal(false);
+
 	#ifdef PLL_DEBUG_OUTPUTS
 	AddStream(Unit::UNIT_FS, "period", Stream::STREAM_TYPE_ANALOG);
 	AddStream(Unit::UNIT_FS, "dphase", Stream::STREAM_TYPE_ANALOG);
@@ -100,6 +109,13 @@ string ClockRecoveryFilter::GetProtocolName()
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Actual decoder logic
 
+void ClockRecoveryFilter::ClearSweeps()
+{
+	m_hasLock = false;
+	m_lockedPeriod = 0;
+	m_lockedBaud = 0;
+}
+
 void ClockRecoveryFilter::Refresh()
 {
 	//Require a data signal, but not necessarily a gate
@@ -139,10 +155,21 @@ void ClockRecoveryFilter::Refresh()
 	}
 
 	//Get nominal period used for the first cycle of the NCO
-	int64_t initialPeriod = round(FS_PER_SECOND / m_parameters[m_baudname].GetFloatVal());
+	float baud = m_parameters[m_baudname].GetFloatVal();
+	int64_t initialPeriod = round(FS_PER_SECOND / baud);
 	int64_t halfPeriod = initialPeriod / 2;
 	int64_t period = initialPeriod;
 
+	//If we're carrying lock between waveforms, seed the NCO with the frequency recovered from the previous
+	//waveform. The lock is only trusted if it was acquired at the same nominal symbol rate and is still
+	//reasonably close to it (a wildly off carried period means we'd locked onto garbage, so start fresh).
+	bool carry = m_parameters[m_carryname].GetBoolVal();
+	if(carry && m_hasLock && (m_lockedBaud == baud) &&
+		(m_lockedPeriod > 0.75*initialPeriod) && (m_lockedPeriod < 1.25*initialPeriod) )
+	{
+		period = m_lockedPeriod;
+	}
+
 	//Disallow frequencies higher than Nyquist of the input
 	auto fnyquist = 2*din->m_timescale;
 	if( period < fnyquist)
@@ -357,6 +384,16 @@ void ClockRecoveryFilter::Refresh()
 	total_error /= edges.size();
 	//LogTrace("average phase error %zu\n", total_error);
 
+	//Save the settled frequency for the next waveform.
+	//Phase is not carried: triggers aren't phase coherent with the recovered clock between captures,
+	//and the NCO realigns to the first edge anyway.
+	if(carry)
+	{
+		m_hasLock = true;
+		m_lockedPeriod = period;
+		m_lockedBaud = baud;
+	}
+
 	SetData(cap, 0);
 
 	cap->MarkModifiedFromCpu();
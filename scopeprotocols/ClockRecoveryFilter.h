@@ -47,11 +47,23 @@ public:
 
 	virtual bool ValidateChannel(size_t i, StreamDescriptor stream) override;
 
+	virtual void ClearSweeps() override;
+
 	PROTOCOL_DECODER_INITPROC(ClockRecoveryFilter)
 
 protected:
 	std::string m_baudname;
 	std::string m_threshname;
+	std::string m_carryname;
+
+	///@brief True if m_lockedPeriod holds the PLL period from the end of the previous waveform
+	bool m_hasLock;
+
+	///@brief NCO period at the end of the previous waveform, in femtoseconds
+	int64_t m_lockedPeriod;
+
+	///@brief Nominal symbol rate m_lockedPeriod was acquired with, to invalidate the lock on config changes
+	float m_lockedBaud;
 };
 
 #endif
@@ -39,6 +39,8 @@ ComplexImportFilter::ComplexImportFilter(const string& color)
 	: ImportFilter(color)
 	, m_formatname("File Format")
 	, m_sratename("Sample Rate")
+	, m_wstartname("Window Start")
+	, m_wdurname("Window Duration")
 {
 	m_fpname = "Complex File";
 	m_parameters[m_fpname] = FilterParameter(FilterParameter::TYPE_FILENAME, Unit(Unit::UNIT_COUNTS));
@@ -59,6 +61,16 @@ ComplexImportFilter::ComplexImportFilter(const string& color)
 	m_parameters[m_sratename].SetIntVal(1e6);
 	m_parameters[m_sratename].signal_changed().connect(sigc::mem_fun(*this, &ComplexImportFilter::Reload));
 
+	//Windowed import: only the selected time range is converted (0 duration = rest of the file).
+	//Since the file is mapped rather than read, pages outside the window are never touched.
+	m_parameters[m_wstartname] = FilterParameter(FilterParameter::TYPE_INT, Unit(Unit::UNIT_FS));
+	m_parameters[m_wstartname].SetIntVal(0);
+	m_parameters[m_wstartname].signal_changed().connect(sigc::mem_fun(*this, &ComplexImportFilter::Reload));
+
+	m_parameters[m_wdurname] = FilterParameter(FilterParameter::TYPE_INT, Unit(Unit::UNIT_FS));
+	m_parameters[m_wdurname].SetIntVal(0);
+	m_parameters[m_wdurname].signal_changed().connect(sigc::mem_fun(*this, &ComplexImportFilter::Reload));
+
 	AddStream(Unit(Unit::UNIT_VOLTS), "I", Stream::STREAM_TYPE_ANALOG);
 	AddStream(Unit(Unit::UNIT_VOLTS), "Q", Stream::STREAM_TYPE_ANALOG);
 }
@@ -85,34 +97,20 @@ void ComplexImportFilter::Reload()
 	int64_t fs = 0;
 	GetTimestampOfFile(fname, timestamp, fs);
 
-	//Load the file
-	FILE* fp = fopen(fname.c_str(), "rb");
-	if(!fp)
+	//Map the file rather than copying it to the heap; the conversion loops read each byte exactly once
+	MappedFileView file(fname);
+	if(!file.IsValid())
 	{
 		LogError("Couldn't open complex file \"%s\"\n", fname.c_str());
 		return;
 	}
-	fseek(fp, 0, SEEK_END);
-	size_t len_bytes = ftell(fp);
-	fseek(fp, 0, SEEK_SET);
-	uint8_t* buf = new uint8_t[len_bytes];
-	if(len_bytes != fread(buf, 1, len_bytes, fp))
-	{
-		LogError("Failed to read complex data\n");
-		fclose(fp);
-		delete[] buf;
-		return;
-	}
-	fclose(fp);
-	fp = NULL;
+	size_t len_bytes = file.m_len;
+	const char* buf = file.m_data;
 
 	//Create new waveforms
 	int64_t samplerate = m_parameters[m_sratename].GetIntVal();
 	if(samplerate == 0)
-	{
-		delete[] buf;
 		return;
-	}
 	int64_t interval = FS_PER_SECOND / samplerate;
 
 	auto iwfm = new UniformAnalogWaveform;
@@ -153,10 +151,59 @@ void ComplexImportFilter::Reload()
 			bytes_per_sample = 8;
 			break;
 	}
-	size_t nsamples = len_bytes / (bytes_per_sample * 2);
+	size_t totalSamples = len_bytes / (bytes_per_sample * 2);
+
+	//Clip to the import window: samples before it are skipped (their pages never get faulted in),
+	//samples after it are simply not converted
+	int64_t wstart = m_parameters[m_wstartname].GetIntVal();
+	int64_t wdur = m_parameters[m_wdurname].GetIntVal();
+	size_t firstSample = 0;
+	if(wstart > 0)
+		firstSample = min(static_cast<size_t>(wstart / interval), totalSamples);
+	size_t nsamples = totalSamples - firstSample;
+	if(wdur > 0)
+		nsamples = min(nsamples, static_cast<size_t>(wdur / interval));
+	buf += firstSample * bytes_per_sample * 2;
+
+	//Position the window on the time axis so it lines up with an unwindowed import
+	iwfm->m_triggerPhase = firstSample * interval;
+	qwfm->m_triggerPhase = firstSample * interval;
+
 	iwfm->Resize(nsamples);
 	qwfm->Resize(nsamples);
 
+	//Direct-to-GPU path for int16 recordings (the common SDR capture format, and the big ones): stream the
+	//mapped file through a bounded staging buffer and de-interleave/convert on device, so the float form of
+	//a 100GB+ session only ever exists in the waveforms' GPU buffers
+	if( (fmt == FORMAT_SIGNED_INT16) && (nsamples != 0) &&
+		g_gpuFilterEnabled && RawSampleConverter::IsGpuConversionAvailable16Bit() )
+	{
+		if(!m_converter)
+		{
+			m_converter = make_unique<RawSampleConverter>("ComplexImportFilter");
+			m_rawBuf.SetCpuAccessHint(AcceleratorBuffer<int16_t>::HINT_LIKELY);
+			m_rawBuf.SetGpuAccessHint(AcceleratorBuffer<int16_t>::HINT_LIKELY);
+		}
+
+		const size_t chunkPairs = 16 * 1024 * 1024;		//64 MB of staging
+		auto raw = reinterpret_cast<const int16_t*>(buf);
+		float scale = 1.0f / 32767.0f;
+		for(size_t base = 0; base < nsamples; base += chunkPairs)
+		{
+			size_t npairs = min(chunkPairs, nsamples - base);
+
+			m_rawBuf.resize(npairs * 2);
+			m_rawBuf.PrepareForCpuAccess();
+			memcpy(m_rawBuf.GetCpuPointer(), raw + base*2, npairs * 2 * sizeof(int16_t));
+			m_rawBuf.MarkModifiedFromCpu();
+
+			m_converter->Begin();
+			m_converter->ConvertInterleaved16BitSamples(iwfm, qwfm, m_rawBuf, npairs, base, scale, 0);
+			m_converter->Submit();
+		}
+		return;
+	}
+
 	//Actual output processing
 	//TODO: vectorize this?
 	switch(fmt)
@@ -164,7 +211,7 @@ void ComplexImportFilter::Reload()
 		case FORMAT_UNSIGNED_INT8:
 			{
 				float scale = 1.0f / 127.0f;
-				auto wfm = reinterpret_cast<uint8_t*>(buf);
+				auto wfm = reinterpret_cast<const uint8_t*>(buf);
 				for(size_t i=0; i<nsamples; i++)
 				{
 					iwfm->m_samples[i]	= (wfm[i*2] - 128) * scale;
@@ -176,7 +223,7 @@ void ComplexImportFilter::Reload()
 		case FORMAT_SIGNED_INT8:
 			{
 				float scale = 1.0f / 127.0f;
-				auto wfm = reinterpret_cast<int8_t*>(buf);
+				auto wfm = reinterpret_cast<const int8_t*>(buf);
 				for(size_t i=0; i<nsamples; i++)
 				{
 					iwfm->m_samples[i]	= wfm[i*2] * scale;
@@ -188,7 +235,7 @@ void ComplexImportFilter::Reload()
 		case FORMAT_SIGNED_INT16:
 			{
 				float scale = 1.0f / 32767.0f;
-				auto wfm = reinterpret_cast<int16_t*>(buf);
+				auto wfm = reinterpret_cast<const int16_t*>(buf);
 				for(size_t i=0; i<nsamples; i++)
 				{
 					iwfm->m_samples[i]	= wfm[i*2] * scale;
@@ -199,7 +246,7 @@ void ComplexImportFilter::Reload()
 
 		case FORMAT_FLOAT32:
 			{
-				auto wfm = reinterpret_cast<float*>(buf);
+				auto wfm = reinterpret_cast<const float*>(buf);
 				for(size_t i=0; i<nsamples; i++)
 				{
 					iwfm->m_samples[i]	= wfm[i*2];
@@ -210,7 +257,7 @@ void ComplexImportFilter::Reload()
 
 		case FORMAT_FLOAT64:
 			{
-				auto wfm = reinterpret_cast<double*>(buf);
+				auto wfm = reinterpret_cast<const double*>(buf);
 				for(size_t i=0; i<nsamples; i++)
 				{
 					iwfm->m_samples[i]	= wfm[i*2];
@@ -223,7 +270,4 @@ void ComplexImportFilter::Reload()
 
 	iwfm->MarkModifiedFromCpu();
 	qwfm->MarkModifiedFromCpu();
-
-	//Done, clean up
-	delete[] buf;
 }
@@ -56,8 +56,16 @@ public:
 protected:
 	std::string m_formatname;
 	std::string m_sratename;
+	std::string m_wstartname;
+	std::string m_wdurname;
 
 	void Reload();
+
+	///@brief GPU conversion stage for the direct int16 import path (lazily created)
+	std::unique_ptr<RawSampleConverter> m_converter;
+
+	///@brief Bounded staging buffer for streaming raw IQ chunks to the GPU
+	AcceleratorBuffer<int16_t> m_rawBuf;
 };
 
 #endif
@@ -40,6 +40,16 @@ using namespace std;
 ComplexSpectrogramFilter::ComplexSpectrogramFilter(const string& color)
 	: SpectrogramFilter(color)
 	, m_centerFreqName("Center Frequency")
+	, m_updateModeName("Update Mode")
+	, m_lastIncBlocks(0)
+	, m_lastInputI(nullptr)
+	, m_lastInputQ(nullptr)
+	, m_lastTimestamp(0)
+	, m_lastStartFs(0)
+	, m_lastTimescale(0)
+	, m_lastFFTLen(0)
+	, m_lastWindow(FFTFilter::WINDOW_RECTANGULAR)
+	, m_highWaterBlocks(0)
 {
 	//remove base class ports
 	m_signalNames.clear();
@@ -49,18 +59,19 @@ ComplexSpectrogramFilter::ComplexSpectrogramFilter(const string& color)
 	CreateInput("I");
 	CreateInput("Q");
 
-	m_blackmanHarrisComputePipeline.Reinitialize(
-		"shaders/ComplexBlackmanHarrisWindow.spv", 3, sizeof(WindowFunctionArgs));
-	m_rectangularComputePipeline.Reinitialize(
-		"shaders/ComplexRectangularWindow.spv", 3, sizeof(WindowFunctionArgs));
-	m_cosineSumComputePipeline.Reinitialize(
-		"shaders/CosineSumWindow.spv", 3, sizeof(WindowFunctionArgs));
+	m_applyWindowComputePipeline.Reinitialize(
+		"shaders/ApplyComplexWindow.spv", 4, sizeof(ApplyWindowArgs));
 
 	m_postprocessComputePipeline.Reinitialize(
 		"shaders/ComplexSpectrogramPostprocess.spv", 2, sizeof(SpectrogramPostprocessArgs));
 
 	m_parameters[m_centerFreqName] = FilterParameter(FilterParameter::TYPE_INT, Unit(Unit::UNIT_HZ));
 	m_parameters[m_centerFreqName].SetIntVal(0);
+
+	m_parameters[m_updateModeName] = FilterParameter(FilterParameter::TYPE_ENUM, Unit(Unit::UNIT_COUNTS));
+	m_parameters[m_updateModeName].AddEnumValue("Full", UPDATE_FULL);
+	m_parameters[m_updateModeName].AddEnumValue("Incremental", UPDATE_INCREMENTAL);
+	m_parameters[m_updateModeName].SetIntVal(UPDATE_FULL);
 }
 
 ComplexSpectrogramFilter::~ComplexSpectrogramFilter()
@@ -105,7 +116,7 @@ void ComplexSpectrogramFilter::ReallocateBuffers(size_t fftlen, size_t nblocks)
 	}
 	if(!m_vkPlan)
 	{
-		m_vkPlan = make_unique<VulkanFFTPlan>(
+		m_vkPlan = g_vkFFTPlanCache.Acquire(
 			fftlen, nouts, VulkanFFTPlan::DIRECTION_FORWARD, nblocks, VulkanFFTPlan::TYPE_COMPLEX);
 	}
 
@@ -113,6 +124,10 @@ void ComplexSpectrogramFilter::ReallocateBuffers(size_t fftlen, size_t nblocks)
 	m_rdinbuf.SetGpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
 	m_rdoutbuf.SetCpuAccessHint(AcceleratorBuffer<float>::HINT_NEVER);
 	m_rdoutbuf.SetGpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
+	m_rdinIncBuf.SetCpuAccessHint(AcceleratorBuffer<float>::HINT_NEVER);
+	m_rdinIncBuf.SetGpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
+	m_rdoutIncBuf.SetCpuAccessHint(AcceleratorBuffer<float>::HINT_NEVER);
+	m_rdoutIncBuf.SetGpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
 }
 
 void ComplexSpectrogramFilter::Refresh(vk::raii::CommandBuffer& cmdBuf, shared_ptr<QueueHandle> queue)
@@ -121,6 +136,8 @@ void ComplexSpectrogramFilter::Refresh(vk::raii::CommandBuffer& cmdBuf, shared_p
 	if(!VerifyAllInputsOKAndUniformAnalog())
 	{
 		SetData(NULL, 0);
+		m_lastInputI = nullptr;
+		m_lastInputQ = nullptr;
 		return;
 	}
 	auto din_i = dynamic_cast<UniformAnalogWaveform*>(GetInputWaveform(0));
@@ -208,49 +225,49 @@ void ComplexSpectrogramFilter::Refresh(vk::raii::CommandBuffer& cmdBuf, shared_p
 			break;
 	}
 
-	//Configure the window
-	WindowFunctionArgs args;
-	args.numActualSamples = fftlen;
-	args.npoints = fftlen;
-	args.scale = 2 * M_PI / fftlen;
-	switch(window)
+	//Get the shared window coefficients (computed once process-wide, shared read-only across instances)
+	if(!m_windowBuf || (m_windowBuf->size() != fftlen) || (window != m_cachedWindowType))
 	{
-		case FFTFilter::WINDOW_HANN:
-			args.alpha0 = 0.5;
-			break;
-
-		case FFTFilter::WINDOW_HAMMING:
-			args.alpha0 = 25.0f / 46;
-			break;
-
-		default:
-			args.alpha0 = 0;
-			break;
+		m_windowBuf = g_windowFunctionCache.Acquire(window, fftlen);
+		m_cachedWindowType = window;
 	}
-	args.alpha1 = 1 - args.alpha0;
 
-	//Figure out which window shader to use
-	ComputePipeline* wpipe = nullptr;
-	switch(window)
-	{
-		case FFTFilter::WINDOW_BLACKMAN_HARRIS:
-			wpipe = &m_blackmanHarrisComputePipeline;
-			break;
-
-		case FFTFilter::WINDOW_HANN:
-		case FFTFilter::WINDOW_HAMMING:
-			wpipe = &m_cosineSumComputePipeline;
-			break;
-
-		default:
-		case FFTFilter::WINDOW_RECTANGULAR:
-			wpipe = &m_rectangularComputePipeline;
-			break;
-	}
+	//See if we can update incrementally: we're looking at the same waveform as last pass with the same FFT
+	//configuration, and the only change is new samples appended at the end (streaming acquisition)
+	auto mode = static_cast<UpdateMode>(m_parameters[m_updateModeName].GetIntVal());
+	bool incremental =
+		(mode == UPDATE_INCREMENTAL) &&
+		(din_i == m_lastInputI) &&
+		(din_q == m_lastInputQ) &&
+		(din_i->m_startTimestamp == m_lastTimestamp) &&
+		(din_i->m_startFemtoseconds == m_lastStartFs) &&
+		(din_i->m_timescale == m_lastTimescale) &&
+		(fftlen == m_lastFFTLen) &&
+		(window == m_lastWindow) &&
+		(nblocks >= m_highWaterBlocks);
+	size_t firstBlock = incremental ? m_highWaterBlocks : 0;
+	size_t newBlocks = nblocks - firstBlock;
 
 	//Make sure our temporary buffers are big enough
-	m_rdinbuf.resize(nblocks * fftlen * 2);
+	//(growing m_rdoutbuf preserves existing content, so blocks computed in earlier passes survive)
 	m_rdoutbuf.resize(nblocks * (nouts * 2) );
+	if(incremental)
+	{
+		m_rdinIncBuf.resize(newBlocks * fftlen * 2);
+		m_rdoutIncBuf.resize(newBlocks * (nouts * 2) );
+
+		//FFT plan covering just the new blocks
+		//(the plan cache hits as long as the streaming chunk size stays steady)
+		if( (newBlocks != 0) &&
+			(!m_vkIncPlan || (m_vkIncPlan->size() != fftlen) || (newBlocks != m_lastIncBlocks) ) )
+		{
+			m_vkIncPlan = g_vkFFTPlanCache.Acquire(
+				fftlen, nouts, VulkanFFTPlan::DIRECTION_FORWARD, newBlocks, VulkanFFTPlan::TYPE_COMPLEX);
+			m_lastIncBlocks = newBlocks;
+		}
+	}
+	else
+		m_rdinbuf.resize(nblocks * fftlen * 2);
 
 	//Cache a bunch of configuration
 	float minscale = m_parameters[m_rangeMinName].GetFloatVal();
@@ -260,27 +277,69 @@ void ComplexSpectrogramFilter::Refresh(vk::raii::CommandBuffer& cmdBuf, shared_p
 	//Prepare to do all of our compute stuff in one dispatch call to reduce overhead
 	cmdBuf.begin({});
 
-	//Grab the input and apply the window function
-	wpipe->BindBufferNonblocking(0, din_i->m_samples, cmdBuf);
-	wpipe->BindBufferNonblocking(1, m_rdinbuf, cmdBuf, true);
-	wpipe->BindBufferNonblocking(2, din_q->m_samples, cmdBuf);
-	for(size_t block=0; block<nblocks; block++)
+	ApplyWindowArgs args;
+	args.fftlen = fftlen;
+	if(incremental)
 	{
-		args.offsetIn = block*fftlen;
-		args.offsetOut = block*fftlen;
-
-		if(block == 0)
-			wpipe->Dispatch(cmdBuf, args, GetComputeBlockCount(fftlen, 64));
-		else
-			wpipe->DispatchNoRebind(cmdBuf, args, GetComputeBlockCount(fftlen, 64));
+		if(newBlocks != 0)
+		{
+			//Window and FFT only the newly arrived blocks, into the staging buffers
+			args.npoints = newBlocks * fftlen;
+			args.offsetIn = firstBlock * fftlen;
+			m_applyWindowComputePipeline.BindBufferNonblocking(0, din_i->m_samples, cmdBuf);
+			m_applyWindowComputePipeline.BindBufferNonblocking(1, m_rdinIncBuf, cmdBuf, true);
+			m_applyWindowComputePipeline.BindBufferNonblocking(2, din_q->m_samples, cmdBuf);
+			m_applyWindowComputePipeline.BindBufferNonblocking(3, *m_windowBuf, cmdBuf);
+			m_applyWindowComputePipeline.Dispatch(cmdBuf, args, GetComputeBlockCount(args.npoints, 64));
+			m_applyWindowComputePipeline.AddComputeMemoryBarrier(cmdBuf);
+
+			m_vkIncPlan->AppendForward(
+				m_rdinIncBuf,
+				m_rdoutIncBuf,
+				cmdBuf);
+
+			//Wait for the FFT to finish
+			cmdBuf.pipelineBarrier(
+				vk::PipelineStageFlagBits::eComputeShader,
+				vk::PipelineStageFlagBits::eTransfer,
+				{},
+				vk::MemoryBarrier(vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eTransferRead),
+				{},
+				{});
+
+			//Splice the new spectra onto the tail of the persistent FFT output
+			//(raw FFT output is block-major, so newly appended blocks are contiguous at the end)
+			vk::BufferCopy region(0, firstBlock * nouts * 2 * sizeof(float), newBlocks * nouts * 2 * sizeof(float));
+			cmdBuf.copyBuffer(m_rdoutIncBuf.GetBuffer(), m_rdoutbuf.GetBuffer(), {region});
+
+			//And wait for the copy to land before the postprocess shader reads it
+			cmdBuf.pipelineBarrier(
+				vk::PipelineStageFlagBits::eTransfer,
+				vk::PipelineStageFlagBits::eComputeShader,
+				{},
+				vk::MemoryBarrier(vk::AccessFlagBits::eTransferWrite, vk::AccessFlagBits::eShaderRead),
+				{},
+				{});
+		}
+	}
+	else
+	{
+		//Grab the input and apply the window function (all blocks in one dispatch)
+		args.npoints = nblocks * fftlen;
+		args.offsetIn = 0;
+		m_applyWindowComputePipeline.BindBufferNonblocking(0, din_i->m_samples, cmdBuf);
+		m_applyWindowComputePipeline.BindBufferNonblocking(1, m_rdinbuf, cmdBuf, true);
+		m_applyWindowComputePipeline.BindBufferNonblocking(2, din_q->m_samples, cmdBuf);
+		m_applyWindowComputePipeline.BindBufferNonblocking(3, *m_windowBuf, cmdBuf);
+		m_applyWindowComputePipeline.Dispatch(cmdBuf, args, GetComputeBlockCount(args.npoints, 64));
+		m_applyWindowComputePipeline.AddComputeMemoryBarrier(cmdBuf);
+
+		//Do the actual FFT
+		m_vkPlan->AppendForward(
+			m_rdinbuf,
+			m_rdoutbuf,
+			cmdBuf);
 	}
-	wpipe->AddComputeMemoryBarrier(cmdBuf);
-
-	//Do the actual FFT
-	m_vkPlan->AppendForward(
-		m_rdinbuf,
-		m_rdoutbuf,
-		cmdBuf);
 
 	//Postprocess the output
 	//TODO: really deep waveforms might generate a lot of blocks here (enough to exceed the max block count in Y)
@@ -310,4 +369,15 @@ void ComplexSpectrogramFilter::Refresh(vk::raii::CommandBuffer& cmdBuf, shared_p
 	queue->SubmitAndBlock(cmdBuf);
 
 	cap->MarkModifiedFromGpu();
+	m_rdoutbuf.MarkModifiedFromGpu();
+
+	//Save streaming context so the next pass can tell if it's able to update incrementally
+	m_lastInputI = din_i;
+	m_lastInputQ = din_q;
+	m_lastTimestamp = din_i->m_startTimestamp;
+	m_lastStartFs = din_i->m_startFemtoseconds;
+	m_lastTimescale = din_i->m_timescale;
+	m_lastFFTLen = fftlen;
+	m_lastWindow = window;
+	m_highWaterBlocks = nblocks;
 }
@@ -46,6 +46,16 @@ public:
 	ComplexSpectrogramFilter(const std::string& color);
 	virtual ~ComplexSpectrogramFilter();
 
+	enum UpdateMode
+	{
+		//Recompute every FFT block each pass
+		UPDATE_FULL,
+
+		//If the input waveform just grew at the end (streaming acquisition), only FFT the new blocks
+		//and splice them onto the previously computed output
+		UPDATE_INCREMENTAL
+	};
+
 	virtual void Refresh(vk::raii::CommandBuffer& cmdBuf, std::shared_ptr<QueueHandle> queue) override;
 	virtual bool ValidateChannel(size_t i, StreamDescriptor stream) override;
 
@@ -58,6 +68,31 @@ protected:
 	virtual void ReallocateBuffers(size_t fftlen, size_t nblocks) override;
 
 	std::string m_centerFreqName;
+	std::string m_updateModeName;
+
+	///@brief Staging buffer for windowed samples of newly arrived blocks (incremental mode only)
+	AcceleratorBuffer<float> m_rdinIncBuf;
+
+	///@brief Staging buffer for FFT output of newly arrived blocks (incremental mode only)
+	AcceleratorBuffer<float> m_rdoutIncBuf;
+
+	///@brief FFT plan sized for just the new blocks of an incremental pass
+	std::shared_ptr<VulkanFFTPlan> m_vkIncPlan;
+
+	///@brief Batch size m_vkIncPlan was created for
+	size_t m_lastIncBlocks;
+
+	//Streaming context from the previous Refresh, used to decide if an incremental update is legal
+	WaveformBase* m_lastInputI;
+	WaveformBase* m_lastInputQ;
+	time_t m_lastTimestamp;
+	int64_t m_lastStartFs;
+	int64_t m_lastTimescale;
+	size_t m_lastFFTLen;
+	FFTFilter::WindowFunction m_lastWindow;
+
+	///@brief Number of FFT blocks already present in m_rdoutbuf from previous passes
+	size_t m_highWaterBlocks;
 };
 
 #endif
@@ -50,7 +50,12 @@ ConstellationFilter::ConstellationFilter(const string& color)
 	, m_nomr("Range")
 	, m_evmSum(0)
 	, m_evmCount(0)
+	, m_computePipeline("shaders/ConstellationFilter.spv", 5, sizeof(ConstellationAccumArgs))
 {
+	m_pointsBuf.SetName("ConstellationFilter.m_pointsBuf");
+	m_gpuAccumBuf.SetName("ConstellationFilter.m_gpuAccumBuf");
+	m_evmPartialBuf.SetName("ConstellationFilter.m_evmPartialBuf");
+
 	AddStream(Unit(Unit::UNIT_VOLTS), "data", Stream::STREAM_TYPE_CONSTELLATION);
 	AddStream(Unit(Unit::UNIT_VOLTS), "EVM raw", Stream::STREAM_TYPE_ANALOG_SCALAR);
 	AddStream(Unit(Unit::UNIT_PERCENT), "EVM normalized", Stream::STREAM_TYPE_ANALOG_SCALAR);
@@ -125,9 +130,7 @@ void ConstellationFilter::ClearSweeps()
 	m_evmCount = 0;
 }
 
-void ConstellationFilter::Refresh(
-	[[maybe_unused]] vk::raii::CommandBuffer& cmdBuf,
-	[[maybe_unused]] shared_ptr<QueueHandle> queue)
+void ConstellationFilter::Refresh(vk::raii::CommandBuffer& cmdBuf, shared_ptr<QueueHandle> queue)
 {
 	if(!VerifyAllInputsOK())
 	{
@@ -163,38 +166,43 @@ void ConstellationFilter::Refresh(
 	float ymid = m_height / 2;
 
 	//Actual integration loop
-	//TODO: vectorize, GPU, or both?
-	auto data = cap->GetAccumData();
-	for(size_t i=0; i<inlen; i++)
+	//Accumulate on the GPU if we can, falling back to the CPU loop otherwise
+	if(g_gpuFilterEnabled && (inlen > 0))
+		AccumulateGpu(samples_i, samples_q, inlen, cap, xscale, xmid, yscale, ymid, cmdBuf, queue);
+	else
 	{
-		float ival = samples_i.m_samples[i];
-		float qval = samples_q.m_samples[i];
+		auto data = cap->GetAccumData();
+		for(size_t i=0; i<inlen; i++)
+		{
+			float ival = samples_i.m_samples[i];
+			float qval = samples_q.m_samples[i];
 
-		ssize_t x = static_cast<ssize_t>(round(xmid + xscale * ival));
-		ssize_t y = static_cast<ssize_t>(round(ymid + yscale * qval));
+			ssize_t x = static_cast<ssize_t>(round(xmid + xscale * ival));
+			ssize_t y = static_cast<ssize_t>(round(ymid + yscale * qval));
 
-		//bounds check
-		if( (x < 0) || (x >= (ssize_t)m_width) || (y < 0) || (y >= (ssize_t)m_height) )
-			continue;
+			//bounds check
+			if( (x < 0) || (x >= (ssize_t)m_width) || (y < 0) || (y >= (ssize_t)m_height) )
+				continue;
 
-		//fill
-		data[y*m_width + x] ++;
+			//fill
+			data[y*m_width + x] ++;
 
-		//Compute error vector
-		if(m_points.size())
-		{
-			//TODO: this can definitely be made more efficient!!!
-			float minvec = FLT_MAX;
-			for(auto p : m_points)
+			//Compute error vector
+			if(m_points.size())
 			{
-				float dx = (p.m_xval * 1e-6) - ival;
-				float dy = p.m_yval - qval;
-				float dsq = dx*dx + dy*dy;
-				minvec = min(minvec, dsq);
-			}
+				//TODO: this can definitely be made more efficient!!!
+				float minvec = FLT_MAX;
+				for(auto p : m_points)
+				{
+					float dx = (p.m_xval * 1e-6) - ival;
+					float dy = p.m_yval - qval;
+					float dsq = dx*dx + dy*dy;
+					minvec = min(minvec, dsq);
+				}
 
-			m_evmCount ++;
-			m_evmSum += sqrt(minvec);
+				m_evmCount ++;
+				m_evmSum += sqrt(minvec);
+			}
 		}
 	}
 
@@ -209,6 +217,95 @@ void ConstellationFilter::Refresh(
 	cap->Normalize();
 }
 
+/**
+	@brief GPU accumulation path: bins IQ symbols into the density map and sums error vectors on the GPU
+
+	Symbols accumulate into a 32-bit per-pass buffer with atomics (a single pass can't overflow it), which is
+	folded into the persistent 64-bit density bins after readback so normalization and saturation behavior are
+	unchanged. The error vector magnitude is reduced to one partial sum per workgroup in shared memory and summed
+	on the CPU; the EVM sample count equals the number of in-bounds hits, matching the CPU loop which skips
+	out-of-range symbols entirely.
+ */
+void ConstellationFilter::AccumulateGpu(
+	SparseAnalogWaveform& samples_i,
+	SparseAnalogWaveform& samples_q,
+	size_t inlen,
+	ConstellationWaveform* cap,
+	float xscale,
+	float xmid,
+	float yscale,
+	float ymid,
+	vk::raii::CommandBuffer& cmdBuf,
+	shared_ptr<QueueHandle> queue)
+{
+	samples_i.m_samples.PrepareForGpuAccess();
+	samples_q.m_samples.PrepareForGpuAccess();
+
+	//Upload the nominal constellation points as interleaved I/Q pairs, in volts to match the sample data
+	//(always allocate at least one dummy point so the binding is valid with no modulation selected)
+	size_t npoints = m_points.size();
+	m_pointsBuf.resize(max(npoints, (size_t)1) * 2);
+	m_pointsBuf.PrepareForCpuAccess();
+	for(size_t i=0; i<npoints; i++)
+	{
+		m_pointsBuf[i*2] = m_points[i].m_xval * 1e-6;	//stored in uV, convert back to V
+		m_pointsBuf[i*2 + 1] = m_points[i].m_yval;
+	}
+	m_pointsBuf.MarkModifiedFromCpu();
+
+	//Zero the per-pass accumulator
+	size_t npix = m_width * m_height;
+	m_gpuAccumBuf.resize(npix);
+	m_gpuAccumBuf.PrepareForCpuAccess();
+	memset(m_gpuAccumBuf.GetCpuPointer(), 0, npix * sizeof(uint32_t));
+	m_gpuAccumBuf.MarkModifiedFromCpu();
+
+	const uint32_t numGroups = 256;
+	m_evmPartialBuf.resize(numGroups);
+
+	ConstellationAccumArgs args;
+	args.len = inlen;
+	args.width = m_width;
+	args.height = m_height;
+	args.npoints = npoints;
+	args.xscale = xscale;
+	args.xmid = xmid;
+	args.yscale = yscale;
+	args.ymid = ymid;
+
+	cmdBuf.begin({});
+	m_computePipeline.BindBufferNonblocking(0, samples_i.m_samples, cmdBuf);
+	m_computePipeline.BindBufferNonblocking(1, samples_q.m_samples, cmdBuf);
+	m_computePipeline.BindBufferNonblocking(2, m_gpuAccumBuf, cmdBuf);
+	m_computePipeline.BindBufferNonblocking(3, m_pointsBuf, cmdBuf);
+	m_computePipeline.BindBufferNonblocking(4, m_evmPartialBuf, cmdBuf, true);
+	m_computePipeline.Dispatch(cmdBuf, args, numGroups);
+	cmdBuf.end();
+	queue->SubmitAndBlock(cmdBuf);
+	m_gpuAccumBuf.MarkModifiedFromGpu();
+	m_evmPartialBuf.MarkModifiedFromGpu();
+
+	//Fold this pass's hits into the persistent 64-bit accumulator
+	m_gpuAccumBuf.PrepareForCpuAccess();
+	auto data = cap->GetAccumData();
+	uint32_t* hits = m_gpuAccumBuf.GetCpuPointer();
+	size_t totalHits = 0;
+	for(size_t i=0; i<npix; i++)
+	{
+		data[i] += hits[i];
+		totalHits += hits[i];
+	}
+
+	//Merge the error vector partials
+	if(npoints)
+	{
+		m_evmPartialBuf.PrepareForCpuAccess();
+		for(uint32_t i=0; i<numGroups; i++)
+			m_evmSum += m_evmPartialBuf[i];
+		m_evmCount += totalHits;
+	}
+}
+
 void ConstellationFilter::RecomputeNominalPoints()
 {
 	m_points.clear();
@@ -62,6 +62,19 @@ public:
 	float m_ynorm;
 };
 
+///@brief Push constant block for the GPU accumulation path (must match ConstellationFilter.glsl)
+struct ConstellationAccumArgs
+{
+	uint32_t len;
+	uint32_t width;
+	uint32_t height;
+	uint32_t npoints;
+	float xscale;
+	float xmid;
+	float yscale;
+	float ymid;
+};
+
 class ConstellationFilter
 	: public Filter
 	, public ActionProvider
@@ -133,6 +146,19 @@ public:
 
 protected:
 	void RecomputeNominalPoints();
+
+	void AccumulateGpu(
+		SparseAnalogWaveform& samples_i,
+		SparseAnalogWaveform& samples_q,
+		size_t inlen,
+		ConstellationWaveform* cap,
+		float xscale,
+		float xmid,
+		float yscale,
+		float ymid,
+		vk::raii::CommandBuffer& cmdBuf,
+		std::shared_ptr<QueueHandle> queue);
+
 	void GetMinMaxSymbols(
 		std::vector<size_t>& hist,
 		float vmin,
@@ -157,6 +183,18 @@ protected:
 
 	///@brief Nominal locations of each constellation point
 	std::vector<ConstellationPoint> m_points;
+
+	///@brief Compute pipeline for the GPU accumulation path
+	ComputePipeline m_computePipeline;
+
+	///@brief Nominal constellation points as interleaved I/Q pairs, in volts
+	AcceleratorBuffer<float> m_pointsBuf;
+
+	///@brief Per-pass 32-bit density accumulator, folded into the persistent 64-bit bins after readback
+	AcceleratorBuffer<uint32_t> m_gpuAccumBuf;
+
+	///@brief Per-workgroup partial error vector sums
+	AcceleratorBuffer<float> m_evmPartialBuf;
 };
 
 #endif
@@ -28,6 +28,7 @@
 ***********************************************************************************************************************/
 
 #include "../scopehal/scopehal.h"
+#include "../scopehal/ScratchBufferPool.h"
 #include "CouplerDeEmbedFilter.h"
 
 using namespace std;
@@ -65,21 +66,6 @@ CouplerDeEmbedFilter::CouplerDeEmbedFilter(const string& color)
 
 	m_cachedNumPoints = 0;
 	m_cachedMaxGain = 0;
-
-	m_scalarTempBuf1.SetCpuAccessHint(AcceleratorBuffer<float>::HINT_NEVER);
-	m_scalarTempBuf1.SetGpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
-
-	m_vectorTempBuf1.SetCpuAccessHint(AcceleratorBuffer<float>::HINT_NEVER);
-	m_vectorTempBuf1.SetGpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
-
-	m_vectorTempBuf2.SetCpuAccessHint(AcceleratorBuffer<float>::HINT_NEVER);
-	m_vectorTempBuf2.SetGpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
-
-	m_vectorTempBuf3.SetCpuAccessHint(AcceleratorBuffer<float>::HINT_NEVER);
-	m_vectorTempBuf3.SetGpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
-
-	m_vectorTempBuf4.SetCpuAccessHint(AcceleratorBuffer<float>::HINT_NEVER);
-	m_vectorTempBuf4.SetGpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
 }
 
 CouplerDeEmbedFilter::~CouplerDeEmbedFilter()
@@ -176,6 +162,14 @@ void CouplerDeEmbedFilter::Refresh(vk::raii::CommandBuffer& cmdBuf, shared_ptr<Q
 	//Format the input data as raw samples for the FFT
 	size_t nouts = npoints/2 + 1;
 
+	//Borrow scratch space from the shared pool for the duration of this refresh
+	//(returned automatically when these go out of scope, after the blocking submit below)
+	ScratchBuffer scalarTempBuf1(queue, npoints);
+	ScratchBuffer vectorTempBuf1(queue, 2 * nouts);
+	ScratchBuffer vectorTempBuf2(queue, 2 * nouts);
+	ScratchBuffer vectorTempBuf3(queue, 2 * nouts);
+	ScratchBuffer vectorTempBuf4(queue, 2 * nouts);
+
 	//Invalidate old vkFFT plans if size has changed
 	if(m_vkForwardPlan)
 	{
@@ -197,23 +191,17 @@ void CouplerDeEmbedFilter::Refresh(vk::raii::CommandBuffer& cmdBuf, shared_ptr<Q
 	bool sizechange = false;
 	if(m_cachedNumPoints != npoints)
 	{
-		m_scalarTempBuf1.resize(npoints);
-		m_vectorTempBuf1.resize(2 * nouts);
-		m_vectorTempBuf2.resize(2 * nouts);
-		m_vectorTempBuf3.resize(2 * nouts);
-		m_vectorTempBuf4.resize(2 * nouts);
-
 		m_cachedNumPoints = npoints;
 		sizechange = true;
 	}
 
 	//Set up new FFT plans
 	if(!m_vkForwardPlan)
-		m_vkForwardPlan = make_unique<VulkanFFTPlan>(npoints, nouts, VulkanFFTPlan::DIRECTION_FORWARD);
+		m_vkForwardPlan = g_vkFFTPlanCache.Acquire(npoints, nouts, VulkanFFTPlan::DIRECTION_FORWARD);
 	if(!m_vkForwardPlan2)
-		m_vkForwardPlan2 = make_unique<VulkanFFTPlan>(npoints, nouts, VulkanFFTPlan::DIRECTION_FORWARD);
+		m_vkForwardPlan2 = g_vkFFTPlanCache.Acquire(npoints, nouts, VulkanFFTPlan::DIRECTION_FORWARD);
 	if(!m_vkReversePlan)
-		m_vkReversePlan = make_unique<VulkanFFTPlan>(npoints, nouts, VulkanFFTPlan::DIRECTION_REVERSE);
+		m_vkReversePlan = g_vkFFTPlanCache.Acquire(npoints, nouts, VulkanFFTPlan::DIRECTION_REVERSE);
 
 	//Calculate size of each bin
 	double fs = dinFwd->m_timescale;
@@ -263,57 +251,57 @@ void CouplerDeEmbedFilter::Refresh(vk::raii::CommandBuffer& cmdBuf, shared_ptr<Q
 
 	//Pad and FFT both inputs
 	//vec1 = raw rev, vec3 = raw fwd
-	ProcessScalarInput(cmdBuf, m_vkForwardPlan, dinFwd->m_samples, m_vectorTempBuf3, npoints, npoints_raw);
-	ProcessScalarInput(cmdBuf, m_vkForwardPlan2, dinRev->m_samples, m_vectorTempBuf1, npoints, npoints_raw);
+	ProcessScalarInput(cmdBuf, m_vkForwardPlan, dinFwd->m_samples, vectorTempBuf3.Get(), scalarTempBuf1.Get(), npoints, npoints_raw);
+	ProcessScalarInput(cmdBuf, m_vkForwardPlan2, dinRev->m_samples, vectorTempBuf1.Get(), scalarTempBuf1.Get(), npoints, npoints_raw);
 
 	//De-embed the forward path
 	//vec1 = raw rev, vec2 = de-embedded fwd, vec3 = raw fwd
-	ApplySParameters(cmdBuf, m_vectorTempBuf3, m_vectorTempBuf2, m_forwardCoupledParams, npoints, nouts);
+	ApplySParameters(cmdBuf, vectorTempBuf3.Get(), vectorTempBuf2.Get(), m_forwardCoupledParams, npoints, nouts);
 
 	//Calculate forward path leakage from this
 	//TODO: calculate and correct for group delay in the leakage path
 	//vec1 = raw rev, vec2 = fwd leakage, vec3 = raw fwd
-	ApplySParametersInPlace(cmdBuf, m_vectorTempBuf2, m_forwardLeakageParams, npoints, nouts);
+	ApplySParametersInPlace(cmdBuf, vectorTempBuf2.Get(), m_forwardLeakageParams, npoints, nouts);
 
 	//Calculate reverse path signal minus leakage from the forward path
 	//vec1 = raw reverse, vec2 = fwd leakage, vec3 = raw fwd, vec4 = clean reverse
-	Subtract(cmdBuf, m_vectorTempBuf1, m_vectorTempBuf2, m_vectorTempBuf4, nouts*2);
+	Subtract(cmdBuf, vectorTempBuf1.Get(), vectorTempBuf2.Get(), vectorTempBuf4.Get(), nouts*2);
 
 	//Given signal minus leakage (enhanced isolation at the coupler output), de-embed coupler response
 	//to get signal at coupler input
 	//vec1 = raw reverse, vec2 = fwd leakage, vec3 = raw fwd, vec4 = clean reverse
-	ApplySParametersInPlace(cmdBuf, m_vectorTempBuf4, m_reverseCoupledParams, npoints, nouts);
+	ApplySParametersInPlace(cmdBuf, vectorTempBuf4.Get(), m_reverseCoupledParams, npoints, nouts);
 
 	//Generate final clean reverse path output
 	size_t istart = 0;
 	size_t iend = npoints_raw;
 	int64_t phaseshift = 0;
 	GroupDelayCorrection(m_reverseCoupledParams, istart, iend, phaseshift, true);
-	GenerateScalarOutput(cmdBuf, m_vkReversePlan, istart, iend, dinRev, 1, npoints, phaseshift, m_vectorTempBuf4);
+	GenerateScalarOutput(cmdBuf, m_vkReversePlan, istart, iend, dinRev, 1, npoints, phaseshift, vectorTempBuf4.Get(), scalarTempBuf1.Get());
 
 	//De-embed the reverse path
 	//vec1 = de-embedded reverse, vec2 = fwd leakage, vec3 = raw fwd
-	ApplySParametersInPlace(cmdBuf, m_vectorTempBuf1, m_reverseCoupledParams, npoints, nouts);
+	ApplySParametersInPlace(cmdBuf, vectorTempBuf1.Get(), m_reverseCoupledParams, npoints, nouts);
 
 	//Calculate reverse path leakage
 	//TODO: calculate and correct for group delay in the leakage path
 	//vec1 = reverse leakage, vec2 = fwd leakage, vec3 = raw fwd
-	ApplySParametersInPlace(cmdBuf, m_vectorTempBuf1, m_reverseLeakageParams, npoints, nouts);
+	ApplySParametersInPlace(cmdBuf, vectorTempBuf1.Get(), m_reverseLeakageParams, npoints, nouts);
 
 	//Calculate forward path signal minus leakage from the reverse path
 	//vec1 = raw rev, vec2 = reverse leakage, vec3 = clean forward
-	SubtractInPlace(cmdBuf, m_vectorTempBuf3, m_vectorTempBuf1, nouts*2);
+	SubtractInPlace(cmdBuf, vectorTempBuf3.Get(), vectorTempBuf1.Get(), nouts*2);
 
 	//Given signal minus leakage (enhanced isolation at the coupler output), de-embed coupler response
 	//to get signal at coupler input
 	//vec1 = raw rev, vec2 = reverse leakage, vec3 = clean forward, vec4 = final reverse output
-	ApplySParameters(cmdBuf, m_vectorTempBuf3, m_vectorTempBuf4, m_forwardCoupledParams, npoints, nouts);
+	ApplySParameters(cmdBuf, vectorTempBuf3.Get(), vectorTempBuf4.Get(), m_forwardCoupledParams, npoints, nouts);
 
 	//Generate final clean forward path output
 	istart = 0;
 	iend = npoints_raw;
 	GroupDelayCorrection(m_forwardCoupledParams, istart, iend, phaseshift, true);
-	GenerateScalarOutput(cmdBuf, m_vkReversePlan, istart, iend, dinFwd, 0, npoints, phaseshift, m_vectorTempBuf4);
+	GenerateScalarOutput(cmdBuf, m_vkReversePlan, istart, iend, dinFwd, 0, npoints, phaseshift, vectorTempBuf4.Get(), scalarTempBuf1.Get());
 
 	////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
@@ -384,18 +372,19 @@ void CouplerDeEmbedFilter::GroupDelayCorrection(
 /**
 	@brief Generates a scalar output from a complex input
 
-	Overwrites m_scalarTempBuf1
+	Overwrites scalarTemp
  */
 void CouplerDeEmbedFilter::GenerateScalarOutput(
 	vk::raii::CommandBuffer& cmdBuf,
-	unique_ptr<VulkanFFTPlan>& plan,
+	shared_ptr<VulkanFFTPlan>& plan,
 	size_t istart,
 	size_t iend,
 	WaveformBase* refin,
 	size_t stream,
 	size_t npoints,
 	int64_t phaseshift,
-	AcceleratorBuffer<float>& samplesIn)
+	AcceleratorBuffer<float>& samplesIn,
+	AcceleratorBuffer<float>& scalarTemp)
 {
 	//Prepare the output waveform
 	float scale = 1.0f / npoints;
@@ -407,7 +396,7 @@ void CouplerDeEmbedFilter::GenerateScalarOutput(
 	cap->m_triggerPhase = phaseshift;
 
 	//Do the actual FFT operation
-	plan->AppendReverse(samplesIn, m_scalarTempBuf1, cmdBuf);
+	plan->AppendReverse(samplesIn, scalarTemp, cmdBuf);
 
 	//Copy and normalize output
 	//TODO: is there any way to fold this into vkFFT? They can normalize, but offset might be tricky...
@@ -416,7 +405,7 @@ void CouplerDeEmbedFilter::GenerateScalarOutput(
 	nargs.istart = istart;
 	nargs.scale = scale;
 	m_normalizeComputePipeline.Bind(cmdBuf);
-	m_normalizeComputePipeline.BindBufferNonblocking(0, m_scalarTempBuf1, cmdBuf);
+	m_normalizeComputePipeline.BindBufferNonblocking(0, scalarTemp, cmdBuf);
 	m_normalizeComputePipeline.BindBufferNonblocking(1, cap->m_samples, cmdBuf, true);
 	m_normalizeComputePipeline.DispatchNoRebind(cmdBuf, nargs, GetComputeBlockCount(npoints, 64));
 	m_normalizeComputePipeline.AddComputeMemoryBarrier(cmdBuf);
@@ -438,8 +427,8 @@ void CouplerDeEmbedFilter::ApplySParameters(
 	m_deEmbedComputePipeline.Bind(cmdBuf);
 	m_deEmbedComputePipeline.BindBufferNonblocking(0, samplesIn, cmdBuf);
 	m_deEmbedComputePipeline.BindBufferNonblocking(1, samplesOut, cmdBuf, true);
-	m_deEmbedComputePipeline.BindBufferNonblocking(2, params.m_resampledSparamSines, cmdBuf);
-	m_deEmbedComputePipeline.BindBufferNonblocking(3, params.m_resampledSparamCosines, cmdBuf);
+	m_deEmbedComputePipeline.BindBufferNonblocking(2, params.m_response->m_sines, cmdBuf);
+	m_deEmbedComputePipeline.BindBufferNonblocking(3, params.m_response->m_cosines, cmdBuf);
 	m_deEmbedComputePipeline.DispatchNoRebind(cmdBuf, (uint32_t)nouts, GetComputeBlockCount(npoints, 64));
 	m_deEmbedComputePipeline.AddComputeMemoryBarrier(cmdBuf);
 	samplesOut.MarkModifiedFromGpu();
@@ -457,8 +446,8 @@ void CouplerDeEmbedFilter::ApplySParametersInPlace(
 {
 	m_deEmbedInPlaceComputePipeline.Bind(cmdBuf);
 	m_deEmbedInPlaceComputePipeline.BindBufferNonblocking(0, samplesInout, cmdBuf);
-	m_deEmbedInPlaceComputePipeline.BindBufferNonblocking(1, params.m_resampledSparamSines, cmdBuf);
-	m_deEmbedInPlaceComputePipeline.BindBufferNonblocking(2, params.m_resampledSparamCosines, cmdBuf);
+	m_deEmbedInPlaceComputePipeline.BindBufferNonblocking(1, params.m_response->m_sines, cmdBuf);
+	m_deEmbedInPlaceComputePipeline.BindBufferNonblocking(2, params.m_response->m_cosines, cmdBuf);
 	m_deEmbedInPlaceComputePipeline.DispatchNoRebind(cmdBuf, (uint32_t)nouts, GetComputeBlockCount(npoints, 64));
 	m_deEmbedInPlaceComputePipeline.AddComputeMemoryBarrier(cmdBuf);
 	samplesInout.MarkModifiedFromGpu();
@@ -467,13 +456,14 @@ void CouplerDeEmbedFilter::ApplySParametersInPlace(
 /**
 	@brief Zero-pad a scalar input to the proper length and FFT it
 
-	Overwrites m_scalarTempBuf1
+	Overwrites scalarTemp
  */
 void CouplerDeEmbedFilter::ProcessScalarInput(
 	vk::raii::CommandBuffer& cmdBuf,
-	unique_ptr<VulkanFFTPlan>& plan,
+	shared_ptr<VulkanFFTPlan>& plan,
 	AcceleratorBuffer<float>& samplesIn,
 	AcceleratorBuffer<float>& samplesOut,
+	AcceleratorBuffer<float>& scalarTemp,
 	size_t npointsPadded,
 	size_t npointsUnpadded
 	)
@@ -489,13 +479,13 @@ void CouplerDeEmbedFilter::ProcessScalarInput(
 	args.offsetOut = 0;
 	m_rectangularComputePipeline.Bind(cmdBuf);
 	m_rectangularComputePipeline.BindBufferNonblocking(0, samplesIn, cmdBuf);
-	m_rectangularComputePipeline.BindBufferNonblocking(1, m_scalarTempBuf1, cmdBuf, true);
+	m_rectangularComputePipeline.BindBufferNonblocking(1, scalarTemp, cmdBuf, true);
 	m_rectangularComputePipeline.DispatchNoRebind(cmdBuf, args, GetComputeBlockCount(npointsPadded, 64));
 	m_rectangularComputePipeline.AddComputeMemoryBarrier(cmdBuf);
-	m_scalarTempBuf1.MarkModifiedFromGpu();
+	scalarTemp.MarkModifiedFromGpu();
 
 	//Do the actual FFT operation
-	plan->AppendForward(m_scalarTempBuf1, samplesOut, cmdBuf);
+	plan->AppendForward(scalarTemp, samplesOut, cmdBuf);
 	samplesOut.MarkModifiedFromGpu();
 	m_rectangularComputePipeline.AddComputeMemoryBarrier(cmdBuf);
 }
@@ -517,77 +507,3 @@ int64_t CouplerSParameters::GetGroupDelay()
 	}
 	return max_delay * FS_PER_SECOND;
 }
-
-/**
-	@brief Recalculate the cached S-parameters (and clamp gain if requested)
- */
-void CouplerSParameters::InterpolateSparameters(
-	WaveformBase* wmag,
-	WaveformBase* wang,
-	float bin_hz,
-	bool invert,
-	size_t nouts,
-	float maxGain)
-{
-	m_cachedBinSize = bin_hz;
-
-	wmag->PrepareForCpuAccess();
-	wang->PrepareForCpuAccess();
-
-	m_resampledSparamSines.SetCpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
-	m_resampledSparamSines.SetGpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
-
-	m_resampledSparamCosines.SetCpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
-	m_resampledSparamCosines.SetGpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
-
-	auto smag = dynamic_cast<SparseAnalogWaveform*>(wmag);
-	auto sang = dynamic_cast<SparseAnalogWaveform*>(wang);
-	auto umag = dynamic_cast<UniformAnalogWaveform*>(wmag);
-	auto uang = dynamic_cast<UniformAnalogWaveform*>(wang);
-
-	if(smag && sang)
-		m_cachedSparams.ConvertFromWaveforms(smag, sang);
-	else
-		m_cachedSparams.ConvertFromWaveforms(umag, uang);
-
-	m_resampledSparamSines.resize(nouts);
-	m_resampledSparamCosines.resize(nouts);
-
-	//De-embedding
-	if(invert)
-	{
-		for(size_t i=0; i<nouts; i++)
-		{
-			float freq = bin_hz * i;
-			auto pt = m_cachedSparams.InterpolatePoint(freq);
-			float mag = pt.m_amplitude;
-			float ang = pt.m_phase;
-
-			float amp = 0;
-			if(fabs(mag) > FLT_EPSILON)
-				amp = 1.0f / mag;
-			amp = min(amp, maxGain);
-
-			m_resampledSparamSines[i] = sin(-ang) * amp;
-			m_resampledSparamCosines[i] = cos(-ang) * amp;
-		}
-	}
-
-	//Channel emulation
-	else
-	{
-		for(size_t i=0; i<nouts; i++)
-		{
-			float freq = bin_hz * i;
-			auto pt = m_cachedSparams.InterpolatePoint(freq);
-			float mag = pt.m_amplitude;
-			float ang = pt.m_phase;
-
-			m_resampledSparamSines[i] = sin(ang) * mag;
-			m_resampledSparamCosines[i] = cos(ang) * mag;
-		}
-	}
-
-	m_resampledSparamSines.MarkModifiedFromCpu();
-	m_resampledSparamCosines.MarkModifiedFromCpu();
-}
@@ -77,9 +77,9 @@ public:
 		m_magKey = wmag;
 		m_angleKey = wang;
 
-		m_resampledSparamCosines.clear();
-		m_resampledSparamSines.clear();
-		InterpolateSparameters(wmag, wang, bin_hz, invert, nouts, maxGain);
+		m_cachedBinSize = bin_hz;
+		m_response = g_deEmbedResponseCache.Acquire(wmag, wang, bin_hz, nouts, invert, maxGain);
+		m_cachedSparams = m_response->m_sparams;
 
 		m_groupDelayFs = GetGroupDelay();
 		m_groupDelaySamples = ceil( m_groupDelayFs / timescale );
@@ -93,18 +93,10 @@ public:
 		}
 	}
 
-	void InterpolateSparameters(
-		WaveformBase* wmag,
-		WaveformBase* wang,
-		float bin_hz,
-		bool invert,
-		size_t nouts,
-		float maxGain);
-
 	virtual int64_t GetGroupDelay();
 
-	AcceleratorBuffer<float> m_resampledSparamSines;
-	AcceleratorBuffer<float> m_resampledSparamCosines;
+	///@brief Interpolated channel response, shared with other filters referencing the same network
+	std::shared_ptr<DeEmbedChannelResponse> m_response;
 
 	WaveformCacheKey m_magKey;
 	WaveformCacheKey m_angleKey;
@@ -136,9 +128,10 @@ protected:
 
 	void ProcessScalarInput(
 		vk::raii::CommandBuffer& cmdBuf,
-		std::unique_ptr<VulkanFFTPlan>& plan,
+		std::shared_ptr<VulkanFFTPlan>& plan,
 		AcceleratorBuffer<float>& samplesIn,
 		AcceleratorBuffer<float>& samplesOut,
+		AcceleratorBuffer<float>& scalarTemp,
 		size_t npointsPadded,
 		size_t npointsUnpadded
 		);
@@ -173,14 +166,15 @@ protected:
 
 	void GenerateScalarOutput(
 		vk::raii::CommandBuffer& cmdBuf,
-		std::unique_ptr<VulkanFFTPlan>& plan,
+		std::shared_ptr<VulkanFFTPlan>& plan,
 		size_t istart,
 		size_t iend,
 		WaveformBase* refin,
 		size_t stream,
 		size_t npoints,
 		int64_t phaseshift,
-		AcceleratorBuffer<float>& samplesIn);
+		AcceleratorBuffer<float>& samplesIn,
+		AcceleratorBuffer<float>& scalarTemp);
 
 	void GroupDelayCorrection(
 		CouplerSParameters& params,
@@ -206,12 +200,6 @@ protected:
 	CouplerSParameters m_forwardLeakageParams;
 	CouplerSParameters m_reverseLeakageParams;
 
-	AcceleratorBuffer<float> m_scalarTempBuf1;
-	AcceleratorBuffer<float> m_vectorTempBuf1;
-	AcceleratorBuffer<float> m_vectorTempBuf2;
-	AcceleratorBuffer<float> m_vectorTempBuf3;
-	AcceleratorBuffer<float> m_vectorTempBuf4;
-
 	ComputePipeline m_rectangularComputePipeline;
 	ComputePipeline m_deEmbedComputePipeline;
 	ComputePipeline m_deEmbedInPlaceComputePipeline;
@@ -219,10 +207,10 @@ protected:
 	ComputePipeline m_subtractInPlaceComputePipeline;
 	ComputePipeline m_subtractComputePipeline;
 
-	std::unique_ptr<VulkanFFTPlan> m_vkForwardPlan;
-	std::unique_ptr<VulkanFFTPlan> m_vkForwardPlan2;
+	std::shared_ptr<VulkanFFTPlan> m_vkForwardPlan;
+	std::shared_ptr<VulkanFFTPlan> m_vkForwardPlan2;
 
-	std::unique_ptr<VulkanFFTPlan> m_vkReversePlan;
+	std::shared_ptr<VulkanFFTPlan> m_vkReversePlan;
 };
 
 #endif
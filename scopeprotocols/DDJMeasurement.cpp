@@ -29,6 +29,9 @@
 
 #include "../scopehal/scopehal.h"
 #include "DDJMeasurement.h"
+#ifdef __x86_64__
+#include <immintrin.h>
+#endif
 
 using namespace std;
 
@@ -97,9 +100,6 @@ void DDJMeasurement::Refresh()
 	SparseDigitalWaveform samples;
 	SampleOnAnyEdgesBase(GetInputWaveform(1), GetInputWaveform(2), samples);
 
-	//DDJ history (8 UIs)
-	uint8_t window = 0;
-
 	//Table of jitter indexed by history
 	vector<size_t> num_table;
 	vector<float> sum_table;
@@ -115,23 +115,40 @@ void DDJMeasurement::Refresh()
 	size_t tielen = tie->m_samples.size();
 	size_t samplen = samples.m_samples.size();
 
+	//Pack the sampled bits into a bitstream so the 8-UI history window for any bit is an unaligned load
+	//plus a shift, rather than carrying shift-register state through the main loop
+	vector<uint8_t> bitstream(samplen/8 + 3, 0);
+	size_t ibit = 0;
+	#ifdef __x86_64__
+	if(g_hasAvx2)
+	{
+		for(; ibit + 32 <= samplen; ibit += 32)
+		{
+			__m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&samples.m_samples[ibit]));
+			uint32_t mask = _mm256_movemask_epi8(_mm256_cmpgt_epi8(v, _mm256_setzero_si256()));
+			memcpy(&bitstream[ibit/8], &mask, sizeof(mask));
+		}
+	}
+	#endif
+	for(; ibit < samplen; ibit ++)
+	{
+		if(samples.m_samples[ibit])
+			bitstream[ibit/8] |= (1 << (ibit & 7));
+	}
+
+	//Precompute scaled TIE timestamps in one streaming pass
+	//(the merge loop below previously rescaled them once per step)
+	vector<int64_t> tietimes(tielen);
+	for(size_t i=0; i<tielen; i++)
+		tietimes[i] = (tie->m_offsets[i] * tie->m_timescale) + tie->m_triggerPhase;
+
 	size_t itie = 0;
 
-	//Loop over the TIE and threshold waveform and assign jitter to bins
-	size_t nbits = 0;
+	//Loop over the TIE and threshold waveform and assign jitter to bins.
+	//Start at the 9th bit so we have 8 UIs of history plus the current bit.
 	int64_t tfirst = GetOffsetScaled(tie, 0);
-	for(size_t idata=0; idata < samplen; idata ++)
+	for(size_t idata=8; idata < samplen; idata ++)
 	{
-		//Sample the next bit in the thresholded waveform
-		window = (window >> 1);
-		if(samples.m_samples[idata])
-			window |= 0x80;
-		nbits ++;
-
-		//need 8 in last_window, plus one more for the current bit
-		if(nbits < 9)
-			continue;
-
 		//If we're still before the first TIE sample, nothing to do
 		int64_t tstart = samples.m_offsets[idata];
 		if(tstart < tfirst)
@@ -141,7 +158,7 @@ void DDJMeasurement::Refresh()
 		int64_t target = 0;
 		while( (target < tfirst) && (itie < tielen) )
 		{
-			target = GetOffsetScaled(tie, itie);
+			target = tietimes[itie];
 
 			if(target < tstart)
 				itie ++;
@@ -155,6 +172,12 @@ void DDJMeasurement::Refresh()
 		if(target > tend)
 			continue;
 
+		//Extract the DDJ history window: bits idata-7 through idata, most recent at the MSB
+		size_t firstbit = idata - 7;
+		uint16_t wbits;
+		memcpy(&wbits, &bitstream[firstbit >> 3], sizeof(wbits));
+		uint8_t window = (wbits >> (firstbit & 7)) & 0xff;
+
 		//Save the info in the DDJ table
 		num_table[window] ++;
 		sum_table[window] += tie->m_samples[itie];
@@ -121,7 +121,13 @@ void DDR3Decoder::Refresh()
 	len = min(len, cs.size());
 	len = min(len, a12.size());
 	len = min(len, a10.size());
-	for(size_t i=0; i<len; i++)
+
+	//If zoomed in, only decode the visible window at per-command detail
+	size_t istart = 0;
+	size_t iend = len;
+	GetVisibleWindowIndices(&we, len, istart, iend);
+
+	for(size_t i=istart; i<iend; i++)
 	{
 		bool swe = we.m_samples[i];
 		bool sras = ras.m_samples[i];
@@ -176,4 +182,7 @@ void DDR3Decoder::Refresh()
 	}
 	SetData(cap, 0);
 	cap->MarkModifiedFromCpu();
+
+	//Compact the command stream so downstream timing measurements scan flat arrays instead of re-decoding
+	cap->BuildCommandStream();
 }
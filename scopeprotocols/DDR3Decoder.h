@@ -49,6 +49,9 @@ public:
 
 	virtual bool ValidateChannel(size_t i, StreamDescriptor stream) override;
 
+	virtual bool UsesVisibleWindow() override
+	{ return true; }
+
 	PROTOCOL_DECODER_INITPROC(DDR3Decoder)
 
 protected:
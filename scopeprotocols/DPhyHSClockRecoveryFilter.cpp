@@ -85,14 +85,8 @@ void DPhyHSClockRecoveryFilter::Refresh()
 	clk->PrepareForCpuAccess();
 	data->PrepareForCpuAccess();
 
-	//Create the output waveform and copy our timescales
-	auto cap = new SparseDigitalWaveform;
-	cap->m_startTimestamp = clk->m_startTimestamp;
-	cap->m_startFemtoseconds = clk->m_startFemtoseconds;
-	cap->m_triggerPhase = clk->m_triggerPhase;
-	cap->m_timescale = clk->m_timescale;
-	SetData(cap, 0);
-
+	//Create the output waveform and copy our timescales (reusing the previous trigger's allocation when possible)
+	auto cap = SetupEmptySparseDigitalOutputWaveform(clk, 0);
 	cap->PrepareForCpuAccess();
 
 	//Process the data
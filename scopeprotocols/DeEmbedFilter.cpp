@@ -40,6 +40,7 @@ DeEmbedFilter::DeEmbedFilter(const string& color)
 	, m_rectangularComputePipeline("shaders/RectangularWindow.spv", 2, sizeof(WindowFunctionArgs))
 	, m_deEmbedComputePipeline("shaders/DeEmbedFilter.spv", 3, sizeof(uint32_t))
 	, m_normalizeComputePipeline("shaders/DeEmbedNormalization.spv", 2, sizeof(DeEmbedNormalizationArgs))
+	, m_deEmbedOutOfPlacePipeline("shaders/DeEmbedOutOfPlace.spv", 4, sizeof(uint32_t))
 {
 	AddStream(Unit(Unit::UNIT_VOLTS), "data", Stream::STREAM_TYPE_ANALOG);
 	CreateInput("signal");
@@ -60,6 +61,13 @@ DeEmbedFilter::DeEmbedFilter(const string& color)
 	m_parameters[m_groupDelayTruncModeName].AddEnumValue("Manual", TRUNC_MANUAL);
 	m_parameters[m_groupDelayTruncModeName].SetIntVal(TRUNC_AUTO);
 
+	//Cascade mode: each additional stage adds a mag/angle input pair. The networks are pre-multiplied into
+	//one combined response, so a four network fixture costs one FFT round trip instead of four chained filters.
+	m_stageCountName = "Stages";
+	m_parameters[m_stageCountName] = FilterParameter(FilterParameter::TYPE_INT, Unit(Unit::UNIT_COUNTS));
+	m_parameters[m_stageCountName].SetIntVal(1);
+	m_parameters[m_stageCountName].signal_changed().connect(sigc::mem_fun(*this, &DeEmbedFilter::OnStageCountChanged));
+
 	m_cachedBinSize = 0;
 
 	m_cachedNumPoints = 0;
@@ -76,6 +84,8 @@ DeEmbedFilter::DeEmbedFilter(const string& color)
 	m_reverseOutBuf.SetCpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
 	m_reverseOutBuf.SetGpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
 
+	m_sweepFftBuf.SetCpuAccessHint(AcceleratorBuffer<float>::HINT_UNLIKELY);
+	m_sweepFftBuf.SetGpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
 }
 
 DeEmbedFilter::~DeEmbedFilter()
@@ -90,27 +100,69 @@ bool DeEmbedFilter::ValidateChannel(size_t i, StreamDescriptor stream)
 	if(stream.m_channel == NULL)
 		return false;
 
-	switch(i)
+	//signal
+	if(i == 0)
+		return (stream.GetType() == Stream::STREAM_TYPE_ANALOG);
+
+	if(i >= m_signalNames.size())
+		return false;
+
+	//mag inputs sit at odd indexes, angle inputs at even (one pair per cascade stage)
+	if(i & 1)
+	{
+		return (stream.GetType() == Stream::STREAM_TYPE_ANALOG) &&
+				(stream.GetYAxisUnits() == Unit::UNIT_DB);
+	}
+	else
+	{
+		return (stream.GetType() == Stream::STREAM_TYPE_ANALOG) &&
+				(stream.GetYAxisUnits() == Unit::UNIT_DEGREES);
+	}
+}
+
+/**
+	@brief Returns the number of cascaded S-parameter networks (1 unless cascade mode is in use)
+ */
+size_t DeEmbedFilter::GetNumStages()
+{
+	//Subclasses that generate their response internally (e.g. CTLE) delete our parameters, so don't assume it exists
+	auto it = m_parameters.find(m_stageCountName);
+	if(it == m_parameters.end())
+		return 1;
+	int64_t n = it->second.GetIntVal();
+	if(n < 1)
+		return 1;
+	return n;
+}
+
+/**
+	@brief Adds or removes mag/angle input pairs when the stage count changes
+ */
+void DeEmbedFilter::OnStageCountChanged()
+{
+	size_t nstages = GetNumStages();
+
+	//Add new ports
+	size_t sizeNew = 1 + nstages*2;
+	size_t sizeOld = m_inputs.size();
+	for(size_t i=sizeOld; i<sizeNew; i++)
+		CreateInput("xx");
+
+	//Rename ports (first stage keeps the legacy names so existing sessions load unchanged)
+	m_signalNames[1] = "mag";
+	m_signalNames[2] = "angle";
+	for(size_t i=1; i<nstages; i++)
 	{
-		//signal
-		case 0:
-			return (stream.GetType() == Stream::STREAM_TYPE_ANALOG);
-
-		//mag
-		case 1:
-			return (stream.GetType() == Stream::STREAM_TYPE_ANALOG) &&
-					(stream.GetYAxisUnits() == Unit::UNIT_DB);
-
-		//angle
-		case 2:
-			return (stream.GetType() == Stream::STREAM_TYPE_ANALOG) &&
-					(stream.GetYAxisUnits() == Unit::UNIT_DEGREES);
-
-		default:
-			return false;
+		m_signalNames[i*2 + 1] = string("mag") + to_string(i+1);
+		m_signalNames[i*2 + 2] = string("angle") + to_string(i+1);
 	}
 
-	return false;
+	//Remove extra ports, if any
+	m_inputs.resize(sizeNew);
+	m_signalNames.resize(sizeNew);
+
+	//Inputs changed
+	signal_inputsChanged().emit();
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -127,6 +179,14 @@ Filter::DataLocation DeEmbedFilter::GetInputLocation()
 	return LOC_DONTCARE;
 }
 
+bool DeEmbedFilter::CanConsumeDeferredInputs()
+{
+	//The signal input is consumed entirely by GPU dispatches, so an upstream filter's submission may still
+	//be in flight when we run. (The S-parameter inputs are read CPU side when they change, but those come
+	//from import filters and VNA drivers, which never defer their completion.)
+	return true;
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Actual decoder logic
 
@@ -189,9 +249,9 @@ void DeEmbedFilter::DoRefresh(bool invert, vk::raii::CommandBuffer& cmdBuf, shar
 
 	//Set up new FFT plans
 	if(!m_vkForwardPlan)
-		m_vkForwardPlan = make_unique<VulkanFFTPlan>(npoints, nouts, VulkanFFTPlan::DIRECTION_FORWARD);
+		m_vkForwardPlan = g_vkFFTPlanCache.Acquire(npoints, nouts, VulkanFFTPlan::DIRECTION_FORWARD);
 	if(!m_vkReversePlan)
-		m_vkReversePlan = make_unique<VulkanFFTPlan>(npoints, nouts, VulkanFFTPlan::DIRECTION_REVERSE);
+		m_vkReversePlan = g_vkFFTPlanCache.Acquire(npoints, nouts, VulkanFFTPlan::DIRECTION_REVERSE);
 
 	//Calculate size of each bin
 	double fs = din->m_timescale;
@@ -214,26 +274,32 @@ void DeEmbedFilter::DoRefresh(bool invert, vk::raii::CommandBuffer& cmdBuf, shar
 	bool inchange = false;
 	if(GetInputCount() > 1)
 	{
-		auto dmag = GetInput(1).GetData();
-		auto dang = GetInput(2).GetData();
-		if( (m_magKey != dmag) ||
-			(m_angleKey != dang) )
+		size_t nstages = GetNumStages();
+		if(m_magKeys.size() != nstages)
 		{
+			m_magKeys.resize(nstages);
+			m_angleKeys.resize(nstages);
 			inchange = true;
-
-			m_magKey = dmag;
-			m_angleKey = dang;
+		}
+		for(size_t i=0; i<nstages; i++)
+		{
+			auto dmag = GetInput(i*2 + 1).GetData();
+			auto dang = GetInput(i*2 + 2).GetData();
+			if( (m_magKeys[i] != dmag) ||
+				(m_angleKeys[i] != dang) )
+			{
+				inchange = true;
+
+				m_magKeys[i] = dmag;
+				m_angleKeys[i] = dang;
+			}
 		}
 	}
 
 	//Resample our parameter to our FFT bin size if needed.
 	//Cache trig function output because there's no AVX instructions for this.
-	if( (fabs(m_cachedBinSize - bin_hz) > FLT_EPSILON) || sizechange || clipchange || inchange)
-	{
-		m_resampledSparamCosines.clear();
-		m_resampledSparamSines.clear();
+	if( (fabs(m_cachedBinSize - bin_hz) > FLT_EPSILON) || sizechange || clipchange || inchange || !m_response)
 		InterpolateSparameters(bin_hz, invert, nouts);
-	}
 
 	//Calculate maximum group delay for the first few S-parameter bins (approx propagation delay of the channel)
 	int64_t groupdelay_fs = GetGroupDelay();
@@ -293,32 +359,108 @@ void DeEmbedFilter::DoRefresh(bool invert, vk::raii::CommandBuffer& cmdBuf, shar
 	//Do the actual FFT operation
 	m_vkForwardPlan->AppendForward(m_forwardInBuf, m_forwardOutBuf, cmdBuf);
 
-	//Apply the interpolated S-parameters
-	m_deEmbedComputePipeline.BindBufferNonblocking(0, m_forwardOutBuf, cmdBuf);
-	m_deEmbedComputePipeline.BindBufferNonblocking(1, m_resampledSparamSines, cmdBuf);
-	m_deEmbedComputePipeline.BindBufferNonblocking(2, m_resampledSparamCosines, cmdBuf);
-	m_deEmbedComputePipeline.Dispatch(cmdBuf, (uint32_t)nouts, GetComputeBlockCount(npoints, 64));
-	m_deEmbedComputePipeline.AddComputeMemoryBarrier(cmdBuf);
-	m_forwardOutBuf.MarkModifiedFromGpu();
+	size_t nsweep = GetSweepSize();
+	if(nsweep <= 1)
+	{
+		//Apply the interpolated S-parameters
+		m_deEmbedComputePipeline.BindBufferNonblocking(0, m_forwardOutBuf, cmdBuf);
+		m_deEmbedComputePipeline.BindBufferNonblocking(1, m_response->m_sines, cmdBuf);
+		m_deEmbedComputePipeline.BindBufferNonblocking(2, m_response->m_cosines, cmdBuf);
+		m_deEmbedComputePipeline.Dispatch(cmdBuf, (uint32_t)nouts, GetComputeBlockCount(npoints, 64));
+		m_deEmbedComputePipeline.AddComputeMemoryBarrier(cmdBuf);
+		m_forwardOutBuf.MarkModifiedFromGpu();
+
+		//Do the actual FFT operation
+		m_vkReversePlan->AppendReverse(m_forwardOutBuf, m_reverseOutBuf, cmdBuf);
+
+		//Copy and normalize output
+		//TODO: is there any way to fold this into vkFFT? They can normalize, but offset might be tricky...
+		DeEmbedNormalizationArgs nargs;
+		nargs.outlen = outlen;
+		nargs.istart = istart;
+		nargs.scale = scale;
+		m_normalizeComputePipeline.BindBufferNonblocking(0, m_reverseOutBuf, cmdBuf);
+		m_normalizeComputePipeline.BindBufferNonblocking(1, cap->m_samples, cmdBuf, true);
+		m_normalizeComputePipeline.Dispatch(cmdBuf, nargs, GetComputeBlockCount(npoints, 64));
+		m_normalizeComputePipeline.AddComputeMemoryBarrier(cmdBuf);
+
+		//Done. If the scheduler says all our consumers can chain to this submission device side,
+		//leave it in flight; otherwise block until the compute operations finish
+		cmdBuf.end();
+		SubmitOrDefer(cmdBuf, queue);
+		cap->MarkModifiedFromGpu();
+	}
 
-	//Do the actual FFT operation
-	m_vkReversePlan->AppendReverse(m_forwardOutBuf, m_reverseOutBuf, cmdBuf);
-
-	//Copy and normalize output
-	//TODO: is there any way to fold this into vkFFT? They can normalize, but offset might be tricky...
-	DeEmbedNormalizationArgs nargs;
-	nargs.outlen = outlen;
-	nargs.istart = istart;
-	nargs.scale = scale;
-	m_normalizeComputePipeline.BindBufferNonblocking(0, m_reverseOutBuf, cmdBuf);
-	m_normalizeComputePipeline.BindBufferNonblocking(1, cap->m_samples, cmdBuf, true);
-	m_normalizeComputePipeline.Dispatch(cmdBuf, nargs, GetComputeBlockCount(npoints, 64));
-	m_normalizeComputePipeline.AddComputeMemoryBarrier(cmdBuf);
-
-	//Done, block until the compute operations finish
-	cmdBuf.end();
-	queue->SubmitAndBlock(cmdBuf);
-	cap->MarkModifiedFromGpu();
+	//Parameter sweep: the input windowing and forward FFT above are shared by the whole sweep, so each
+	//additional value costs only a response multiply and inverse FFT. The multiply runs out of place to
+	//keep the forward FFT output pristine for the next step, and each step lands in its own output stream.
+	else
+	{
+		if(m_sweepFftBuf.size() != 2*nouts)
+			m_sweepFftBuf.resize(2*nouts);
+
+		vector<UniformAnalogWaveform*> caps;
+		caps.push_back(cap);
+		for(size_t step=0; step<nsweep; step++)
+		{
+			LoadSweepResponse(step, bin_hz, invert, nouts);
+
+			auto scap = cap;
+			if(step > 0)
+			{
+				scap = SetupEmptyUniformAnalogOutputWaveform(din, step);
+				scap->m_triggerPhase = cap->m_triggerPhase;
+				scap->Resize(outlen);
+				caps.push_back(scap);
+			}
+
+			m_deEmbedOutOfPlacePipeline.Bind(cmdBuf);
+			m_deEmbedOutOfPlacePipeline.BindBufferNonblocking(0, m_forwardOutBuf, cmdBuf);
+			m_deEmbedOutOfPlacePipeline.BindBufferNonblocking(1, m_sweepFftBuf, cmdBuf, true);
+			m_deEmbedOutOfPlacePipeline.BindBufferNonblocking(2, m_response->m_sines, cmdBuf);
+			m_deEmbedOutOfPlacePipeline.BindBufferNonblocking(3, m_response->m_cosines, cmdBuf);
+			m_deEmbedOutOfPlacePipeline.DispatchNoRebind(cmdBuf, (uint32_t)nouts, GetComputeBlockCount(npoints, 64));
+			m_deEmbedOutOfPlacePipeline.AddComputeMemoryBarrier(cmdBuf);
+			m_sweepFftBuf.MarkModifiedFromGpu();
+
+			m_vkReversePlan->AppendReverse(m_sweepFftBuf, m_reverseOutBuf, cmdBuf);
+
+			DeEmbedNormalizationArgs nargs;
+			nargs.outlen = outlen;
+			nargs.istart = istart;
+			nargs.scale = scale;
+			m_normalizeComputePipeline.Bind(cmdBuf);
+			m_normalizeComputePipeline.BindBufferNonblocking(0, m_reverseOutBuf, cmdBuf);
+			m_normalizeComputePipeline.BindBufferNonblocking(1, scap->m_samples, cmdBuf, true);
+			m_normalizeComputePipeline.DispatchNoRebind(cmdBuf, nargs, GetComputeBlockCount(npoints, 64));
+			m_normalizeComputePipeline.AddComputeMemoryBarrier(cmdBuf);
+		}
+
+		cmdBuf.end();
+		SubmitOrDefer(cmdBuf, queue);
+		for(auto c : caps)
+			c->MarkModifiedFromGpu();
+	}
+}
+
+/**
+	@brief Returns the number of parameter sweep steps (1 if sweeping is not active)
+
+	Subclasses that synthesize their response from filter parameters (e.g. CTLE) can override this, along with
+	LoadSweepResponse(), to evaluate a batch of parameter values in one pass.
+ */
+size_t DeEmbedFilter::GetSweepSize()
+{
+	return 1;
+}
+
+/**
+	@brief Loads m_response with the channel response for one step of a parameter sweep
+
+	Only called when GetSweepSize() returns more than one step.
+ */
+void DeEmbedFilter::LoadSweepResponse(size_t /*step*/, float /*bin_hz*/, bool /*invert*/, size_t /*nouts*/)
+{
 }
 
 /**
@@ -342,7 +484,8 @@ int64_t DeEmbedFilter::GetGroupDelay()
 /**
 	@brief Recalculate the cached S-parameters (and clamp gain if requested)
 
-	Since there's no AVX sin/cos instructions, precompute sin(phase) and cos(phase)
+	Pulls the interpolated response from the process-wide cache, so other filter instances referencing
+	the same network on the same sample grid share one copy.
  */
 void DeEmbedFilter::InterpolateSparameters(float bin_hz, bool invert, size_t nouts)
 {
@@ -350,17 +493,58 @@ void DeEmbedFilter::InterpolateSparameters(float bin_hz, bool invert, size_t nou
 
 	float maxGain = pow(10, m_parameters[m_maxGainName].GetFloatVal()/20);
 
-	//Extract the S-parameters
-	auto wmag = GetInputWaveform(1);
-	auto wang = GetInputWaveform(2);
+	size_t nstages = GetNumStages();
+	if(nstages <= 1)
+	{
+		m_response = g_deEmbedResponseCache.Acquire(
+			GetInputWaveform(1), GetInputWaveform(2), bin_hz, nouts, invert, maxGain);
+	}
+
+	//Cascade mode: pre-multiply all the networks into one combined response
+	else
+	{
+		vector<pair<WaveformBase*, WaveformBase*> > networks;
+		for(size_t i=0; i<nstages; i++)
+			networks.push_back(pair<WaveformBase*, WaveformBase*>(GetInputWaveform(i*2 + 1), GetInputWaveform(i*2 + 2)));
+		m_response = g_deEmbedResponseCache.AcquireCascade(networks, bin_hz, nouts, invert, maxGain);
+	}
+
+	//Keep a local copy of the un-resampled S-parameters for group delay calculation
+	m_cachedSparams = m_response->m_sparams;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Interpolated response cache
+
+DeEmbedResponseCache g_deEmbedResponseCache;
+
+/**
+	@brief Resample an S-parameter network onto an FFT bin grid
+
+	Since there's no AVX sin/cos instructions, precompute sin(phase) and cos(phase)
+ */
+void DeEmbedChannelResponse::Interpolate(
+	WaveformBase* wmag,
+	WaveformBase* wang,
+	double bin_hz,
+	size_t nouts,
+	bool invert,
+	float maxGain)
+{
 	wmag->PrepareForCpuAccess();
 	wang->PrepareForCpuAccess();
 
-	m_resampledSparamSines.SetCpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
-	m_resampledSparamSines.SetGpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
+	m_sines.SetCpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
+	m_sines.SetGpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
+
+	m_cosines.SetCpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
+	m_cosines.SetGpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
 
-	m_resampledSparamCosines.SetCpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
-	m_resampledSparamCosines.SetGpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
+	m_resampledMag.SetCpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
+	m_resampledMag.SetGpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
+
+	m_resampledAngle.SetCpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
+	m_resampledAngle.SetGpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
 
 	auto smag = dynamic_cast<SparseAnalogWaveform*>(wmag);
 	auto sang = dynamic_cast<SparseAnalogWaveform*>(wang);
@@ -368,30 +552,32 @@ void DeEmbedFilter::InterpolateSparameters(float bin_hz, bool invert, size_t nou
 	auto uang = dynamic_cast<UniformAnalogWaveform*>(wang);
 
 	if(smag && sang)
-		m_cachedSparams.ConvertFromWaveforms(smag, sang);
+		m_sparams.ConvertFromWaveforms(smag, sang);
 	else
-		m_cachedSparams.ConvertFromWaveforms(umag, uang);
+		m_sparams.ConvertFromWaveforms(umag, uang);
+
+	m_sines.resize(nouts);
+	m_cosines.resize(nouts);
 
-	m_resampledSparamSines.resize(nouts);
-	m_resampledSparamCosines.resize(nouts);
+	//Resample the network onto our bin grid in one sequential pass
+	//(rather than a binary search through the points per bin)
+	m_sparams.InterpolateUniformGrid(bin_hz, nouts, m_resampledMag, m_resampledAngle);
 
 	//De-embedding
 	if(invert)
 	{
 		for(size_t i=0; i<nouts; i++)
 		{
-			float freq = bin_hz * i;
-			auto pt = m_cachedSparams.InterpolatePoint(freq);
-			float mag = pt.m_amplitude;
-			float ang = pt.m_phase;
+			float mag = m_resampledMag[i];
+			float ang = m_resampledAngle[i];
 
 			float amp = 0;
 			if(fabs(mag) > FLT_EPSILON)
 				amp = 1.0f / mag;
 			amp = min(amp, maxGain);
 
-			m_resampledSparamSines[i] = sin(-ang) * amp;
-			m_resampledSparamCosines[i] = cos(-ang) * amp;
+			m_sines[i] = sin(-ang) * amp;
+			m_cosines[i] = cos(-ang) * amp;
 		}
 	}
 
@@ -400,16 +586,203 @@ void DeEmbedFilter::InterpolateSparameters(float bin_hz, bool invert, size_t nou
 	{
 		for(size_t i=0; i<nouts; i++)
 		{
-			float freq = bin_hz * i;
-			auto pt = m_cachedSparams.InterpolatePoint(freq);
-			float mag = pt.m_amplitude;
-			float ang = pt.m_phase;
+			float mag = m_resampledMag[i];
+			float ang = m_resampledAngle[i];
 
-			m_resampledSparamSines[i] = sin(ang) * mag;
-			m_resampledSparamCosines[i] = cos(ang) * mag;
+			m_sines[i] = sin(ang) * mag;
+			m_cosines[i] = cos(ang) * mag;
 		}
 	}
 
-	m_resampledSparamSines.MarkModifiedFromCpu();
-	m_resampledSparamCosines.MarkModifiedFromCpu();
+	m_sines.MarkModifiedFromCpu();
+	m_cosines.MarkModifiedFromCpu();
+}
+
+/**
+	@brief Pre-multiply several already-interpolated networks into one combined response
+
+	The stage responses are on the same bin grid, so cascading is a per-bin multiply of magnitudes and sum of
+	phases. Gain clamping (if de-embedding) is applied once to the combined response, not per stage, so a notch
+	in one network can legally be filled by gain in another.
+ */
+void DeEmbedChannelResponse::Cascade(
+	const vector<shared_ptr<DeEmbedChannelResponse> >& stages,
+	double bin_hz,
+	size_t nouts,
+	bool invert,
+	float maxGain)
+{
+	m_sines.SetCpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
+	m_sines.SetGpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
+
+	m_cosines.SetCpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
+	m_cosines.SetGpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
+
+	m_resampledMag.SetCpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
+	m_resampledMag.SetGpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
+
+	m_resampledAngle.SetCpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
+	m_resampledAngle.SetGpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
+
+	m_sines.resize(nouts);
+	m_cosines.resize(nouts);
+	m_resampledMag.resize(nouts);
+	m_resampledAngle.resize(nouts);
+
+	for(size_t i=0; i<nouts; i++)
+	{
+		float mag = 1;
+		float ang = 0;
+		for(auto& s : stages)
+		{
+			mag *= s->m_resampledMag[i];
+			ang += s->m_resampledAngle[i];
+		}
+		m_resampledMag[i] = mag;
+		m_resampledAngle[i] = ang;
+
+		//De-embedding
+		if(invert)
+		{
+			float amp = 0;
+			if(fabs(mag) > FLT_EPSILON)
+				amp = 1.0f / mag;
+			amp = min(amp, maxGain);
+
+			m_sines[i] = sin(-ang) * amp;
+			m_cosines[i] = cos(-ang) * amp;
+		}
+
+		//Channel emulation
+		else
+		{
+			m_sines[i] = sin(ang) * mag;
+			m_cosines[i] = cos(ang) * mag;
+		}
+	}
+
+	//Synthesize combined S-parameters on the bin grid for the group delay calculation
+	//(phases were summed before any wrapping, so the phase slope of the cascade is the sum of the stages')
+	m_sparams.m_points.resize(nouts);
+	m_sparams.m_points.PrepareForCpuAccess();
+	for(size_t i=0; i<nouts; i++)
+		m_sparams.m_points[i] = SParameterPoint(i * bin_hz, m_resampledMag[i], m_resampledAngle[i]);
+	m_sparams.m_points.MarkModifiedFromCpu();
+
+	m_resampledMag.MarkModifiedFromCpu();
+	m_resampledAngle.MarkModifiedFromCpu();
+	m_sines.MarkModifiedFromCpu();
+	m_cosines.MarkModifiedFromCpu();
+}
+
+/**
+	@brief Look up (or compute) the interpolated response for an S-parameter network on a given bin grid
+
+	The key covers the S-parameter waveforms (identity and revision), the bin grid, and the gain clamp,
+	so the response is recomputed when the network or the sample configuration changes and shared
+	otherwise.
+ */
+shared_ptr<DeEmbedChannelResponse> DeEmbedResponseCache::Acquire(
+	WaveformBase* wmag,
+	WaveformBase* wang,
+	double bin_hz,
+	size_t nouts,
+	bool invert,
+	float maxGain)
+{
+	char key[128];
+	snprintf(key, sizeof(key), "%p_%llu_%p_%llu_%e_%zu_%d_%e",
+		static_cast<void*>(wmag),
+		static_cast<unsigned long long>(wmag->m_revision),
+		static_cast<void*>(wang),
+		static_cast<unsigned long long>(wang->m_revision),
+		bin_hz,
+		nouts,
+		invert ? 1 : 0,
+		maxGain);
+
+	//Check cache
+	{
+		lock_guard<mutex> lock(m_mutex);
+		for(auto it = m_entries.begin(); it != m_entries.end(); ++it)
+		{
+			if(it->first == key)
+			{
+				//Hit: move to the back of the LRU list
+				auto resp = it->second;
+				m_entries.splice(m_entries.end(), m_entries, it);
+				return resp;
+			}
+		}
+	}
+
+	//Not in cache: compute outside the lock so a slow interpolation doesn't stall other filters
+	auto resp = make_shared<DeEmbedChannelResponse>();
+	resp->Interpolate(wmag, wang, bin_hz, nouts, invert, maxGain);
+
+	lock_guard<mutex> lock(m_mutex);
+	m_entries.push_back(pair<string, shared_ptr<DeEmbedChannelResponse> >(key, resp));
+	while(m_entries.size() > m_maxEntries)
+		m_entries.pop_front();
+	return resp;
+}
+
+/**
+	@brief Look up (or compute) the combined response of a cascade of S-parameter networks
+
+	The key covers every network in the chain, so editing any one Touchstone file (or a sample grid change)
+	recomputes the combined response, while steady state triggers reuse the cached pre-multiplied copy.
+	The per-stage interpolations go through Acquire(), so they're shared with any single-stage filters
+	referencing the same networks.
+ */
+shared_ptr<DeEmbedChannelResponse> DeEmbedResponseCache::AcquireCascade(
+	const vector<pair<WaveformBase*, WaveformBase*> >& networks,
+	double bin_hz,
+	size_t nouts,
+	bool invert,
+	float maxGain)
+{
+	string key = "cascade";
+	char tmp[64];
+	for(auto& net : networks)
+	{
+		snprintf(tmp, sizeof(tmp), "_%p_%llu_%p_%llu",
+			static_cast<void*>(net.first),
+			static_cast<unsigned long long>(net.first->m_revision),
+			static_cast<void*>(net.second),
+			static_cast<unsigned long long>(net.second->m_revision));
+		key += tmp;
+	}
+	snprintf(tmp, sizeof(tmp), "_%e_%zu_%d_%e", bin_hz, nouts, invert ? 1 : 0, maxGain);
+	key += tmp;
+
+	//Check cache
+	{
+		lock_guard<mutex> lock(m_mutex);
+		for(auto it = m_entries.begin(); it != m_entries.end(); ++it)
+		{
+			if(it->first == key)
+			{
+				//Hit: move to the back of the LRU list
+				auto resp = it->second;
+				m_entries.splice(m_entries.end(), m_entries, it);
+				return resp;
+			}
+		}
+	}
+
+	//Not in cache: interpolate each stage (invert-independent, so acquire the plain forward response with
+	//no gain clamp to maximize sharing), then pre-multiply them into one combined response
+	vector<shared_ptr<DeEmbedChannelResponse> > stages;
+	for(auto& net : networks)
+		stages.push_back(Acquire(net.first, net.second, bin_hz, nouts, false, 1));
+
+	auto resp = make_shared<DeEmbedChannelResponse>();
+	resp->Cascade(stages, bin_hz, nouts, invert, maxGain);
+
+	lock_guard<mutex> lock(m_mutex);
+	m_entries.push_back(pair<string, shared_ptr<DeEmbedChannelResponse> >(key, resp));
+	while(m_entries.size() > m_maxEntries)
+		m_entries.pop_front();
+	return resp;
 }
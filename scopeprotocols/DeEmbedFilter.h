@@ -37,6 +37,86 @@
 
 #include "FFTFilter.h"
 
+#include <list>
+
+/**
+	@brief Complex channel response interpolated onto an FFT bin grid, ready for the de-embedding shader
+
+	Since there's no AVX sin/cos instructions, the response is stored as precomputed sin(phase) and
+	cos(phase) scaled by the (gain clamped, if de-embedding) amplitude.
+ */
+class DeEmbedChannelResponse
+{
+public:
+	void Interpolate(
+		WaveformBase* wmag,
+		WaveformBase* wang,
+		double bin_hz,
+		size_t nouts,
+		bool invert,
+		float maxGain);
+
+	void Cascade(
+		const std::vector<std::shared_ptr<DeEmbedChannelResponse> >& stages,
+		double bin_hz,
+		size_t nouts,
+		bool invert,
+		float maxGain);
+
+	AcceleratorBuffer<float> m_sines;
+	AcceleratorBuffer<float> m_cosines;
+
+	///@brief Struct-of-arrays magnitude of the network resampled onto the FFT bin grid
+	AcceleratorBuffer<float> m_resampledMag;
+
+	///@brief Struct-of-arrays phase of the network resampled onto the FFT bin grid
+	AcceleratorBuffer<float> m_resampledAngle;
+
+	///@brief The un-resampled S-parameters, kept around for group delay calculations
+	SParameterVector m_sparams;
+};
+
+/**
+	@brief Process-wide cache of interpolated channel responses, keyed by S-parameter data and FFT bin grid
+
+	The interpolated response only changes when the sample rate, record length or S-parameter network
+	changes, and is identical for every filter instance referencing the same network. Sharing it means
+	steady state de-embedding is just the FFT and complex multiply.
+ */
+class DeEmbedResponseCache
+{
+public:
+	DeEmbedResponseCache()
+		: m_maxEntries(16)
+	{}
+
+	std::shared_ptr<DeEmbedChannelResponse> Acquire(
+		WaveformBase* wmag,
+		WaveformBase* wang,
+		double bin_hz,
+		size_t nouts,
+		bool invert,
+		float maxGain);
+
+	std::shared_ptr<DeEmbedChannelResponse> AcquireCascade(
+		const std::vector<std::pair<WaveformBase*, WaveformBase*> >& networks,
+		double bin_hz,
+		size_t nouts,
+		bool invert,
+		float maxGain);
+
+protected:
+	std::mutex m_mutex;
+
+	///@brief Cache entries in LRU order (most recently used at the back)
+	std::list<std::pair<std::string, std::shared_ptr<DeEmbedChannelResponse> > > m_entries;
+
+	///@brief Maximum number of cached responses before the least recently used one is dropped
+	size_t m_maxEntries;
+};
+
+extern DeEmbedResponseCache g_deEmbedResponseCache;
+
 class DeEmbedFilter : public Filter
 {
 public:
@@ -45,6 +125,7 @@ public:
 
 	virtual void Refresh(vk::raii::CommandBuffer& cmdBuf, std::shared_ptr<QueueHandle> queue) override;
 	virtual DataLocation GetInputLocation() override;
+	virtual bool CanConsumeDeferredInputs() override;
 
 	static std::string GetProtocolName();
 
@@ -64,10 +145,10 @@ public:
 	{ return m_forwardInBuf; }
 
 	AcceleratorBuffer<float>& test_GetResampledSines()
-	{ return m_resampledSparamSines; }
+	{ return m_response->m_sines; }
 
 	AcceleratorBuffer<float>& test_GetResampledCosines()
-	{ return m_resampledSparamCosines; }
+	{ return m_response->m_cosines; }
 
 	size_t test_GetIstart()
 	{ return m_cachedIstart; }
@@ -76,10 +157,15 @@ protected:
 	virtual int64_t GetGroupDelay();
 	void DoRefresh(bool invert, vk::raii::CommandBuffer& cmdBuf, std::shared_ptr<QueueHandle> queue);
 	virtual void InterpolateSparameters(float bin_hz, bool invert, size_t nouts);
+	void OnStageCountChanged();
+	size_t GetNumStages();
+	virtual size_t GetSweepSize();
+	virtual void LoadSweepResponse(size_t step, float bin_hz, bool invert, size_t nouts);
 
 	std::string m_maxGainName;
 	std::string m_groupDelayTruncModeName;
 	std::string m_groupDelayTruncName;
+	std::string m_stageCountName;
 
 	enum TruncationMode
 	{
@@ -90,8 +176,9 @@ protected:
 	float m_cachedMaxGain;
 
 	double m_cachedBinSize;
-	AcceleratorBuffer<float> m_resampledSparamSines;
-	AcceleratorBuffer<float> m_resampledSparamCosines;
+
+	///@brief Interpolated channel response, shared with other filters referencing the same network
+	std::shared_ptr<DeEmbedChannelResponse> m_response;
 
 	size_t m_cachedNumPoints;
 	size_t m_cachedOutLen;
@@ -101,16 +188,21 @@ protected:
 	AcceleratorBuffer<float> m_forwardOutBuf;
 	AcceleratorBuffer<float> m_reverseOutBuf;
 
-	WaveformCacheKey m_magKey;
-	WaveformCacheKey m_angleKey;
+	///@brief Scratch buffer for the out-of-place response multiply in sweep mode
+	AcceleratorBuffer<float> m_sweepFftBuf;
+
+	///@brief Cache keys for the mag/angle inputs of each stage, so a change to any file invalidates the response
+	std::vector<WaveformCacheKey> m_magKeys;
+	std::vector<WaveformCacheKey> m_angleKeys;
 
 	SParameterVector m_cachedSparams;
 
 	ComputePipeline m_rectangularComputePipeline;
 	ComputePipeline m_deEmbedComputePipeline;
 	ComputePipeline m_normalizeComputePipeline;
-	std::unique_ptr<VulkanFFTPlan> m_vkForwardPlan;
-	std::unique_ptr<VulkanFFTPlan> m_vkReversePlan;
+	ComputePipeline m_deEmbedOutOfPlacePipeline;
+	std::shared_ptr<VulkanFFTPlan> m_vkForwardPlan;
+	std::shared_ptr<VulkanFFTPlan> m_vkReversePlan;
 };
 
 #endif
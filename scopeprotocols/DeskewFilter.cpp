@@ -87,18 +87,23 @@ void DeskewFilter::Refresh()
 	auto sdin = dynamic_cast<SparseAnalogWaveform*>(din);
 	auto udin = dynamic_cast<UniformAnalogWaveform*>(din);
 
-	//Copy the data
+	//The samples are unchanged (only the trigger phase moves), so share the input's sample storage
+	//rather than deep copying it
 	if(sdin)
 	{
 		auto cap = SetupSparseOutputWaveform(sdin, 0, 0, 0);
-		cap->m_samples.CopyFrom(sdin->m_samples);
+		if(!cap->m_samples.ShareFrom(sdin->m_samples))
+			cap->m_samples.CopyFrom(sdin->m_samples);
 		cap->m_triggerPhase += offset;
 	}
 	else
 	{
 		auto cap = SetupEmptyUniformAnalogOutputWaveform(udin, 0);
-		cap->Resize(len);
-		cap->m_samples.CopyFrom(udin->m_samples);
+		if(!cap->m_samples.ShareFrom(udin->m_samples))
+		{
+			cap->Resize(len);
+			cap->m_samples.CopyFrom(udin->m_samples);
+		}
 		cap->m_triggerPhase += offset;
 	}
 }
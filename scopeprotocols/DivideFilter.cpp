@@ -273,8 +273,12 @@ void DivideFilter::DoRefreshVectorVector()
 		case FORMAT_DB:
 			SetYAxisUnits(Unit(Unit::UNIT_DB), 0);
 
+			//Divide into the output buffer, then take the log in place (vectorized)
 			for(i=0; i<len; i++)
-				fdst[i] = 20 * log10(fa[i] / fb[i]);
+				fdst[i] = fa[i] / fb[i];
+			VectorLog10(fdst, fdst, len);
+			for(i=0; i<len; i++)
+				fdst[i] *= 20;
 			break;
 
 		default:
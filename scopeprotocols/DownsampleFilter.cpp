@@ -75,7 +75,7 @@ string DownsampleFilter::GetProtocolName()
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Actual decoder logic
 
-void DownsampleFilter::Refresh()
+void DownsampleFilter::Refresh(vk::raii::CommandBuffer& cmdBuf, shared_ptr<QueueHandle> queue)
 {
 	if(!VerifyAllInputsOKAndUniformAnalog())
 	{
@@ -102,61 +102,40 @@ void DownsampleFilter::Refresh()
 	auto cap = SetupEmptyUniformAnalogOutputWaveform(din, 0);
 	cap->Resize(outlen);
 
-	cap->PrepareForCpuAccess();
-	din->PrepareForCpuAccess();
-
 	//Default path with antialiasing filter
 	if(m_parameters[m_aaname].GetBoolVal())
 	{
-		//Cut off all frequencies shorter than our decimation factor
-		float cutoff_period = factor;
-		float sigma = cutoff_period / sqrt(2 * log(2));
-		int kernel_radius = ceil(3*sigma);
-
-		//Generate the actual Gaussian kernel
-		int kernel_size = kernel_radius*2 + 1;
-		vector<float> kernel;
-		kernel.resize(kernel_size);
-		float alpha = 1.0f / (sigma * sqrt(2*M_PI));
-		for(int x=0; x < kernel_size; x++)
+		//Create the antialiasing filter (no-op if factor is unchanged)
+		m_resampler.ConfigureDecimation(factor);
+
+		if(g_gpuFilterEnabled)
 		{
-			int delta = (x - kernel_radius);
-			kernel[x] = alpha * exp(-delta*delta/(2*sigma));
+			cmdBuf.begin({});
+			m_resampler.Resample(cmdBuf, din->m_samples, cap->m_samples, len, outlen);
+			cmdBuf.end();
+			queue->SubmitAndBlock(cmdBuf);
+			cap->MarkModifiedFromGpu();
 		}
-		float sum = 0;
-		for(auto k : kernel)
-			sum += k;
-		for(int i=0; i<kernel_size; i++)
-			kernel[i] /= sum;
 
-		//Do the actual downsampling.
-		for(size_t i=0; i<outlen; i++)
+		else
 		{
-			//Do the convolution
-			float conv = 0;
-			ssize_t base = i*factor;
-			for(ssize_t delta = -kernel_radius; delta <= kernel_radius; delta ++)
-			{
-				ssize_t pos = base + delta;
-				if( (pos < 0) || (pos >= (ssize_t)len) )
-					continue;
-
-				conv += din->m_samples[pos] * kernel[delta + kernel_radius];
-			}
-
-			//Do the actual decimation
-			cap->m_samples[i] 	= conv;
+			m_resampler.ResampleCpu(din->m_samples, cap->m_samples, len, outlen);
+			cap->MarkModifiedFromCpu();
 		}
 	}
 
 	//Optimized path with no AA if the input is known to not contain any higher frequency content
 	else
 	{
+		cap->PrepareForCpuAccess();
+		din->PrepareForCpuAccess();
+
 		for(size_t i=0; i<outlen; i++)
 			cap->m_samples[i]	= din->m_samples[i*factor];
+
+		cap->MarkModifiedFromCpu();
 	}
 
 	//Copy our time scales from the input
 	cap->m_timescale = din->m_timescale * factor;
-	cap->MarkModifiedFromCpu();
 }
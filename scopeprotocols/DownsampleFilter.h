@@ -35,6 +35,8 @@
 #ifndef DownsampleFilter_h
 #define DownsampleFilter_h
 
+class QueueHandle;
+
 /**
 	@brief Downsample - low-pass filter and decimate a signal
  */
@@ -43,7 +45,7 @@ class DownsampleFilter : public Filter
 public:
 	DownsampleFilter(const std::string& color);
 
-	virtual void Refresh() override;
+	virtual void Refresh(vk::raii::CommandBuffer& cmdBuf, std::shared_ptr<QueueHandle> queue) override;
 
 	static std::string GetProtocolName();
 
@@ -54,6 +56,8 @@ public:
 protected:
 	std::string m_factorname;
 	std::string m_aaname;
+
+	PolyphaseResampler m_resampler;
 };
 
 #endif
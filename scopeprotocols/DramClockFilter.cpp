@@ -131,22 +131,16 @@ void DramClockFilter::Refresh()
 	else
 		FindZeroCrossings(uclk, clkedges);
 
-	//Create output waveforms
-	auto rdclk = new SparseDigitalWaveform;
-	auto wrclk = new SparseDigitalWaveform;
+	//Create output waveforms (reusing the previous trigger's allocations when possible)
+	auto rdclk = SetupEmptySparseDigitalOutputWaveform(dqs, 0);
+	auto wrclk = SetupEmptySparseDigitalOutputWaveform(dqs, 1);
 	rdclk->m_timescale 			= 1;
 	wrclk->m_timescale 			= 1;
-	SetData(rdclk, 0);
-	SetData(wrclk, 1);
+	rdclk->m_triggerPhase		= 0;
+	wrclk->m_triggerPhase		= 0;
 	rdclk->PrepareForCpuAccess();
 	wrclk->PrepareForCpuAccess();
 
-	//Copy timestamps
-	rdclk->m_startTimestamp 	= dqs->m_startTimestamp;
-	wrclk->m_startTimestamp 	= dqs->m_startTimestamp;
-	rdclk->m_startFemtoseconds	= dqs->m_startFemtoseconds;
-	wrclk->m_startFemtoseconds	= dqs->m_startFemtoseconds;
-
 	//Create initial all-zero samples at start of both clocks
 	wrclk->m_samples.push_back(false);
 	wrclk->m_durations.push_back(1);
@@ -78,7 +78,15 @@ void DramRefreshActivateMeasurement::Refresh()
 
 	//Get the input data
 	auto din = dynamic_cast<SDRAMWaveform*>(GetInputWaveform(0));
-	din->PrepareForCpuAccess();
+
+	//Scan the compacted command stream (no-op rebuild if the decoder already made it)
+	din->BuildCommandStream();
+	din->m_cmdTimes.PrepareForCpuAccess();
+	din->m_cmdTypes.PrepareForCpuAccess();
+	din->m_cmdBanks.PrepareForCpuAccess();
+	auto times = din->m_cmdTimes.GetCpuPointer();
+	auto cmds = din->m_cmdTypes.GetCpuPointer();
+	auto banks = din->m_cmdBanks.GetCpuPointer();
 
 	//Create the output
 	auto cap = SetupEmptySparseAnalogOutputWaveform(din, 0, true);
@@ -88,38 +96,36 @@ void DramRefreshActivateMeasurement::Refresh()
 	int64_t lastRef[8] = {0, 0, 0, 0, 0, 0, 0, 0};
 
 	int64_t tlast = 0;
-	size_t len = din->m_samples.size();
+	size_t len = din->m_cmdTimes.size();
 	for(size_t i=0; i<len; i++)
 	{
-		int64_t tnow = din->m_offsets[i] * din->m_timescale;
-
 		//Discard invalid bank IDs
-		auto sample = din->m_samples[i];
-		if( (sample.m_bank < 0) || (sample.m_bank > 8) )
+		auto bank = banks[i];
+		if(bank == SDRAMWaveform::INVALID_BANK)
 			continue;
 
+		int64_t tnow = times[i];
+
 		//If it's a refresh, update the last refresh time
-		if(sample.m_stype == SDRAMSymbol::TYPE_REF)
-			lastRef[sample.m_bank] = din->m_offsets[i] * din->m_timescale;
+		if(cmds[i] == SDRAMSymbol::TYPE_REF)
+			lastRef[bank] = tnow;
 
 		//If it's an activate, measure the latency
-		else if(sample.m_stype == SDRAMSymbol::TYPE_ACT)
+		else if(cmds[i] == SDRAMSymbol::TYPE_ACT)
 		{
-			int64_t tact = din->m_offsets[i] * din->m_timescale;
-
 			//If the refresh command is before the start of the capture, ignore this event
-			int64_t tref= lastRef[sample.m_bank];
+			int64_t tref = lastRef[bank];
 			if(tref == 0)
 				continue;
 
 			//Valid access, measure the latency
 			cap->m_offsets.push_back(tlast);
 			cap->m_durations.push_back(tnow - tlast);
-			cap->m_samples.push_back(tact - tref);
+			cap->m_samples.push_back(tnow - tref);
 			tlast = tnow;
 
 			//Purge the last-refresh timestamp so we don't report false times for the next activate
-			lastRef[sample.m_bank] = 0;
+			lastRef[bank] = 0;
 		}
 	}
 
@@ -78,7 +78,15 @@ void DramRowColumnLatencyMeasurement::Refresh()
 
 	//Get the input data
 	auto din = dynamic_cast<SDRAMWaveform*>(GetInputWaveform(0));
-	din->PrepareForCpuAccess();
+
+	//Scan the compacted command stream (no-op rebuild if the decoder already made it)
+	din->BuildCommandStream();
+	din->m_cmdTimes.PrepareForCpuAccess();
+	din->m_cmdTypes.PrepareForCpuAccess();
+	din->m_cmdBanks.PrepareForCpuAccess();
+	auto times = din->m_cmdTimes.GetCpuPointer();
+	auto cmds = din->m_cmdTypes.GetCpuPointer();
+	auto banks = din->m_cmdBanks.GetCpuPointer();
 
 	//Create the output
 	auto cap = SetupEmptySparseAnalogOutputWaveform(din, 0, true);
@@ -89,41 +97,39 @@ void DramRowColumnLatencyMeasurement::Refresh()
 	int64_t lastAct[8] = {0, 0, 0, 0, 0, 0, 0, 0};
 
 	int64_t tlast = 0;
-	size_t len = din->m_samples.size();
+	size_t len = din->m_cmdTimes.size();
 	for(size_t i=0; i<len; i++)
 	{
-		int64_t tnow = din->m_offsets[i] * din->m_timescale;
-
 		//Discard invalid bank IDs
-		auto sample = din->m_samples[i];
-		if( (sample.m_bank < 0) || (sample.m_bank > 8) )
+		auto bank = banks[i];
+		if(bank == SDRAMWaveform::INVALID_BANK)
 			continue;
 
+		int64_t tnow = times[i];
+
 		//If it's an activate, update the last activation time
-		if(sample.m_stype == SDRAMSymbol::TYPE_ACT)
-			lastAct[sample.m_bank] = tnow;
+		if(cmds[i] == SDRAMSymbol::TYPE_ACT)
+			lastAct[bank] = tnow;
 
 		//If it's a read or write, measure the latency
-		else if( (sample.m_stype == SDRAMSymbol::TYPE_WR) |
-			(sample.m_stype == SDRAMSymbol::TYPE_WRA) |
-			(sample.m_stype == SDRAMSymbol::TYPE_RD) |
-			(sample.m_stype == SDRAMSymbol::TYPE_RDA) )
+		else if( (cmds[i] == SDRAMSymbol::TYPE_WR) |
+			(cmds[i] == SDRAMSymbol::TYPE_WRA) |
+			(cmds[i] == SDRAMSymbol::TYPE_RD) |
+			(cmds[i] == SDRAMSymbol::TYPE_RDA) )
 		{
-			int64_t tcol = tnow;
-
 			//If the activate command is before the start of the capture, ignore this event
-			int64_t tact = lastAct[sample.m_bank];
+			int64_t tact = lastAct[bank];
 			if(tact == 0)
 				continue;
 
 			//Valid access, measure the latency
 			cap->m_offsets.push_back(tlast);
 			cap->m_durations.push_back(tnow - tlast);
-			cap->m_samples.push_back(tcol - tact);
+			cap->m_samples.push_back(tnow - tact);
 			tlast = tnow;
 
-			//Purge the last-refresh activate so we don't report false times for the next read or write
-			lastAct[sample.m_bank] = 0;
+			//Purge the last activate so we don't report false times for the next read or write
+			lastAct[bank] = 0;
 		}
 	}
 
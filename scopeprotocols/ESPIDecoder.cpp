@@ -97,6 +97,7 @@ vector<string> ESPIDecoder::GetHeaders()
 void ESPIDecoder::Refresh()
 {
 	ClearPackets();
+	m_transactionIndex.clear();
 
 	//Make sure we've got valid inputs
 	if(!VerifyAllInputsOK())
@@ -105,6 +106,39 @@ void ESPIDecoder::Refresh()
 		return;
 	}
 
+	//Create the waveform. Call SetData() early on so we can use GetText() in the packet decode
+	auto cap = new ESPIWaveform;
+	auto clk = GetInputWaveform(0);
+	cap->m_timescale = clk->m_timescale;
+	cap->m_startTimestamp = clk->m_startTimestamp;
+	cap->m_startFemtoseconds = clk->m_startFemtoseconds;
+	cap->m_triggerPhase = clk->m_triggerPhase;
+	SetData(cap, 0);
+
+	//Structural pass: emit protocol symbols and index transaction boundaries, but don't build any Packet
+	//objects. Details are materialized on demand by GetPacket() when the analyzer actually displays a row,
+	//so a capture with millions of transactions doesn't pay for header text nobody ever looks at.
+	DoDecode(cap, true, nullptr);
+
+	//One (initially empty) packet slot per indexed transaction
+	m_packets.resize(m_transactionIndex.size(), nullptr);
+
+	cap->MarkModifiedFromCpu();
+}
+
+/**
+	@brief Core decode engine, shared by the structural pass and per-packet materialization.
+
+	In the structural pass (structural = true, start = null) this runs over the entire capture, emitting
+	symbols into cap and recording the start cursor of every transaction in m_transactionIndex.
+
+	In materialization mode (structural = false, start = recorded cursor of one transaction) the same state
+	machine is re-run over just that transaction with text generation enabled, and the resulting Packet is
+	returned. Symbols are emitted into the caller's scratch waveform and discarded, so the packet details
+	match what an eager decode would have produced.
+ */
+Packet* ESPIDecoder::DoDecode(ESPIWaveform* cap, bool structural, const TransactionCursor* start)
+{
 	//Get the input data
 	auto clk = GetInputWaveform(0);
 	auto csn = GetInputWaveform(1);
@@ -152,14 +186,19 @@ void ESPIDecoder::Refresh()
 	size_t idata[4]		= {0};
 	int64_t timestamp	= 0;
 
-	//Create the waveform. Call SetData() early on so we can use GetText() in the packet decode
-	auto cap = new ESPIWaveform;
-	cap->m_timescale = clk->m_timescale;
-	cap->m_startTimestamp = clk->m_startTimestamp;
-	cap->m_startFemtoseconds = clk->m_startFemtoseconds;
-	cap->m_triggerPhase = clk->m_triggerPhase;
+	//Materializing a single transaction? Re-enter the capture at its recorded start point
+	if(start)
+	{
+		ics = start->m_ics;
+		iclk = start->m_iclk;
+		for(int j=0; j<4; j++)
+			idata[j] = start->m_idata[j];
+		timestamp = start->m_timestamp;
+		busWidthMode = start->m_busWidthMode;
+		busWidthModeNext = busWidthMode;
+	}
+
 	cap->PrepareForCpuAccess();
-	SetData(cap, 0);
 
 	ESPISymbol samp;
 	enum
@@ -214,6 +253,7 @@ void ESPIDecoder::Refresh()
 
 	ESPISymbol::ESpiCommand current_cmd = ESPISymbol::COMMAND_RESET;
 	Packet* pack = NULL;
+	TransactionCursor selCursor = {};
 
 	enum
 	{
@@ -259,6 +299,15 @@ void ESPIDecoder::Refresh()
 			case LINK_STATE_DESELECTED:
 				if(!cur_cs)
 				{
+					//Remember where this transaction starts, so the structural pass can index it
+					//for later on-demand materialization
+					selCursor.m_ics = ics;
+					selCursor.m_iclk = iclk;
+					for(int j=0; j<4; j++)
+						selCursor.m_idata[j] = idata[j];
+					selCursor.m_timestamp = timestamp;
+					selCursor.m_busWidthMode = busWidthMode;
+
 					link_state = LINK_STATE_SELECTED_CLKLO;
 					current_byte = 0;
 					bitcount = 0;
@@ -379,6 +428,11 @@ void ESPIDecoder::Refresh()
 			if(pack)
 			{
 				pack->m_len = (timestamp * clk->m_timescale) + clk->m_triggerPhase - pack->m_offset;
+
+				//Materializing a single transaction? We're done as soon as it ends
+				if(!structural)
+					return pack;
+
 				pack = NULL;
 			}
 
@@ -402,19 +456,28 @@ void ESPIDecoder::Refresh()
 				case TXN_STATE_OPCODE:
 
 					//Create a new packet
-					pack = new Packet;
-					pack->m_len = 0;
-					m_packets.push_back(pack);
+					//Structural pass: just index the transaction, the Packet is materialized on demand later
+					if(structural)
+						m_transactionIndex.push_back(selCursor);
+					else
+					{
+						pack = new Packet;
+						if(pack)
+							pack->m_len = 0;
+					}
 
 					current_cmd = (ESPISymbol::ESpiCommand)current_byte;
 
 					//Add symbol for packet type
 					tstart = timestamp;
-					pack->m_offset = bytestart * clk->m_timescale + clk->m_triggerPhase;
 					cap->m_offsets.push_back(bytestart);
 					cap->m_durations.push_back(timestamp - bytestart);
 					cap->m_samples.push_back(ESPISymbol(ESPISymbol::TYPE_COMMAND_TYPE, current_byte));
-					pack->m_headers["Command"] = cap->GetText(cap->m_samples.size()-1);
+					if(pack)
+					{
+						pack->m_offset = bytestart * clk->m_timescale + clk->m_triggerPhase;
+						pack->m_headers["Command"] = cap->GetText(cap->m_samples.size()-1);
+					}
 
 					//Decide what to do based on the opcode
 					count = 0;
@@ -426,7 +489,8 @@ void ESPIDecoder::Refresh()
 						//Expect a 16 bit address
 						case ESPISymbol::COMMAND_GET_CONFIGURATION:
 						case ESPISymbol::COMMAND_SET_CONFIGURATION:
-							pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_CONTROL];
+							if(pack)
+								pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_CONTROL];
 							txn_state = TXN_STATE_CONFIG_ADDRESS;
 							break;
 
@@ -437,55 +501,70 @@ void ESPIDecoder::Refresh()
 
 						//Expect an OOB message
 						case ESPISymbol::COMMAND_PUT_OOB:
-							pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_DATA_READ];
+							if(pack)
+								pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_DATA_READ];
 							txn_state = TXN_STATE_SMBUS_TYPE;
 							break;
 
 						//Expect a virtual wire write packet
 						case ESPISymbol::COMMAND_PUT_VWIRE:
-							pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_DATA_WRITE];
+							if(pack)
+								pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_DATA_WRITE];
 							txn_state = TXN_STATE_VWIRE_COUNT;
 							break;
 
 						//Expect a 16-bit address followed by 1-4 bytes of data
 						case ESPISymbol::COMMAND_PUT_IOWR_SHORT_x1:
 							payload_len = 1;
-							pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_DATA_WRITE];
+							if(pack)
+								pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_DATA_WRITE];
 							txn_state = TXN_STATE_IOWR_ADDR;
 							break;
 						case ESPISymbol::COMMAND_PUT_IOWR_SHORT_x2:
 							payload_len = 2;
-							pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_DATA_WRITE];
+							if(pack)
+								pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_DATA_WRITE];
 							txn_state = TXN_STATE_IOWR_ADDR;
 							break;
 						case ESPISymbol::COMMAND_PUT_IOWR_SHORT_x4:
 							payload_len = 4;
-							pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_DATA_WRITE];
+							if(pack)
+								pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_DATA_WRITE];
 							txn_state = TXN_STATE_IOWR_ADDR;
 							break;
 
 						//Expect a 16 bit address
 						case ESPISymbol::COMMAND_PUT_IORD_SHORT_x1:
-							pack->m_headers["Len"] = "1";
-							pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_DATA_READ];
+							if(pack)
+							{
+								pack->m_headers["Len"] = "1";
+								pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_DATA_READ];
+							}
 							txn_state = TXN_STATE_IORD_ADDR;
 							break;
 
 						case ESPISymbol::COMMAND_PUT_IORD_SHORT_x2:
-							pack->m_headers["Len"] = "2";
-							pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_DATA_READ];
+							if(pack)
+							{
+								pack->m_headers["Len"] = "2";
+								pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_DATA_READ];
+							}
 							txn_state = TXN_STATE_IORD_ADDR;
 							break;
 
 						case ESPISymbol::COMMAND_PUT_IORD_SHORT_x4:
-							pack->m_headers["Len"] = "4";
-							pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_DATA_READ];
+							if(pack)
+							{
+								pack->m_headers["Len"] = "4";
+								pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_DATA_READ];
+							}
 							txn_state = TXN_STATE_IORD_ADDR;
 							break;
 
 						//No arguments
 						case ESPISymbol::COMMAND_GET_STATUS:
-							pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_STATUS];
+							if(pack)
+								pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_STATUS];
 							txn_state = TXN_STATE_COMMAND_CRC8;
 							break;
 						case ESPISymbol::COMMAND_GET_FLASH_NP:
@@ -493,28 +572,33 @@ void ESPIDecoder::Refresh()
 							txn_state = TXN_STATE_COMMAND_CRC8;
 							break;
 						case ESPISymbol::COMMAND_GET_VWIRE:
-							pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_DATA_READ];
+							if(pack)
+								pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_DATA_READ];
 							txn_state = TXN_STATE_COMMAND_CRC8;
 							break;
 						case ESPISymbol::COMMAND_GET_OOB:
-							pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_DATA_WRITE];
+							if(pack)
+								pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_DATA_WRITE];
 							txn_state = TXN_STATE_COMMAND_CRC8;
 							break;
 						case ESPISymbol::COMMAND_RESET:
-							pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_COMMAND];
+							if(pack)
+								pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_COMMAND];
 							txn_state = TXN_STATE_COMMAND_CRC8;
 							break;
 
 						//TODO
 						case ESPISymbol::COMMAND_PUT_PC:
-							pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_DATA_WRITE];
+							if(pack)
+								pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_DATA_WRITE];
 							txn_state = TXN_STATE_IDLE;
 							break;
 
 						//Unknown
 						default:
 							txn_state = TXN_STATE_IDLE;
-							pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_ERROR];
+							if(pack)
+								pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_ERROR];
 							break;
 					}
 
@@ -529,7 +613,8 @@ void ESPIDecoder::Refresh()
 					else
 					{
 						cap->m_samples.push_back(ESPISymbol(ESPISymbol::TYPE_COMMAND_CRC_BAD, current_byte));
-						pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_ERROR];
+						if(pack)
+							pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_ERROR];
 					}
 
 					//Expect a response after a 2-cycle bus turnaround
@@ -565,7 +650,8 @@ void ESPIDecoder::Refresh()
 					{
 						cap->m_durations.push_back(timestamp - tstart);
 						cap->m_samples.push_back(ESPISymbol(ESPISymbol::TYPE_CAPS_ADDR, addr));
-						pack->m_headers["Address"] = cap->GetText(cap->m_samples.size()-1);
+						if(pack)
+							pack->m_headers["Address"] = cap->GetText(cap->m_samples.size()-1);
 
 						if(current_cmd == ESPISymbol::COMMAND_SET_CONFIGURATION)
 						{
@@ -590,7 +676,8 @@ void ESPIDecoder::Refresh()
 
 					//Save data
 					data |= current_byte << ( (count & 3) * 8);
-					pack->m_data.push_back(current_byte);
+					if(pack)
+						pack->m_data.push_back(current_byte);
 					count ++;
 
 					//Add data
@@ -605,7 +692,8 @@ void ESPIDecoder::Refresh()
 								{
 									case 0x8:
 										cap->m_samples.push_back(ESPISymbol(ESPISymbol::TYPE_GENERAL_CAPS_WR, data));
-										pack->m_headers["Info"] = Trim(cap->GetText(cap->m_samples.size()-1));
+										if(pack)
+											pack->m_headers["Info"] = Trim(cap->GetText(cap->m_samples.size()-1));
 
 										//General Capabilities register includes the I/O bus width flag
 										//Decode writes and update our bus width for correct decode of the next packet
@@ -635,17 +723,20 @@ void ESPIDecoder::Refresh()
 
 									case 0x10:
 										cap->m_samples.push_back(ESPISymbol(ESPISymbol::TYPE_CH0_CAPS_WR, data));
-										pack->m_headers["Info"] = Trim(cap->GetText(cap->m_samples.size()-1));
+										if(pack)
+											pack->m_headers["Info"] = Trim(cap->GetText(cap->m_samples.size()-1));
 										break;
 
 									case 0x20:
 										cap->m_samples.push_back(ESPISymbol(ESPISymbol::TYPE_CH1_CAPS_WR, data));
-										pack->m_headers["Info"] = Trim(cap->GetText(cap->m_samples.size()-1));
+										if(pack)
+											pack->m_headers["Info"] = Trim(cap->GetText(cap->m_samples.size()-1));
 										break;
 
 									case 0x30:
 										cap->m_samples.push_back(ESPISymbol(ESPISymbol::TYPE_CH2_CAPS_WR, data));
-										pack->m_headers["Info"] = Trim(cap->GetText(cap->m_samples.size()-1));
+										if(pack)
+											pack->m_headers["Info"] = Trim(cap->GetText(cap->m_samples.size()-1));
 										break;
 
 									default:
@@ -696,7 +787,8 @@ void ESPIDecoder::Refresh()
 						if(completion_type != ESPISymbol::COMPLETION_NONE)
 							LogWarning("Appended completions not implemented yet\n");
 
-						pack->m_headers["Response"] = cap->GetText(cap->m_samples.size()-1);
+						if(pack)
+							pack->m_headers["Response"] = cap->GetText(cap->m_samples.size()-1);
 
 						count = 0;
 						data = 0;
@@ -744,7 +836,8 @@ void ESPIDecoder::Refresh()
 					data |= current_byte << ( (count & 3) * 8);
 					count ++;
 
-					pack->m_data.push_back(current_byte);
+					if(pack)
+						pack->m_data.push_back(current_byte);
 
 					//TODO: different commands have different lengths for reply data
 					if(count == 4)
@@ -758,22 +851,26 @@ void ESPIDecoder::Refresh()
 								{
 									case 0x8:
 										cap->m_samples.push_back(ESPISymbol(ESPISymbol::TYPE_GENERAL_CAPS_RD, data));
-										pack->m_headers["Info"] = Trim(cap->GetText(cap->m_samples.size()-1));
+										if(pack)
+											pack->m_headers["Info"] = Trim(cap->GetText(cap->m_samples.size()-1));
 										break;
 
 									case 0x10:
 										cap->m_samples.push_back(ESPISymbol(ESPISymbol::TYPE_CH0_CAPS_RD, data));
-										pack->m_headers["Info"] = Trim(cap->GetText(cap->m_samples.size()-1));
+										if(pack)
+											pack->m_headers["Info"] = Trim(cap->GetText(cap->m_samples.size()-1));
 										break;
 
 									case 0x20:
 										cap->m_samples.push_back(ESPISymbol(ESPISymbol::TYPE_CH1_CAPS_RD, data));
-										pack->m_headers["Info"] = Trim(cap->GetText(cap->m_samples.size()-1));
+										if(pack)
+											pack->m_headers["Info"] = Trim(cap->GetText(cap->m_samples.size()-1));
 										break;
 
 									case 0x30:
 										cap->m_samples.push_back(ESPISymbol(ESPISymbol::TYPE_CH2_CAPS_RD, data));
-										pack->m_headers["Info"] = Trim(cap->GetText(cap->m_samples.size()-1));
+										if(pack)
+											pack->m_headers["Info"] = Trim(cap->GetText(cap->m_samples.size()-1));
 										break;
 
 									default:
@@ -813,23 +910,26 @@ void ESPIDecoder::Refresh()
 						cap->m_durations.push_back(timestamp - tstart);
 						cap->m_samples.push_back(ESPISymbol(ESPISymbol::TYPE_RESPONSE_STATUS, data));
 
-						//Don't report free space in the protocol analyzer
-						//to save column space
-						if(data & 0x2000)
-							stmp += "FLASH_NP_AVAIL ";
-						if(data & 0x1000)
-							stmp += "FLASH_C_AVAIL ";
-						if(data & 0x0200)
-							stmp += "FLASH_NP_FREE ";
-						if(data & 0x0080)
-							stmp += "OOB_AVAIL ";
-						if(data & 0x0040)
-							stmp += "VWIRE_AVAIL ";
-						if(data & 0x0020)
-							stmp += "NP_AVAIL ";
-						if(data & 0x0010)
-							stmp += "PC_AVAIL ";
-						pack->m_headers["Status"] = stmp;
+						if(pack)
+						{
+							//Don't report free space in the protocol analyzer
+							//to save column space
+							if(data & 0x2000)
+								stmp += "FLASH_NP_AVAIL ";
+							if(data & 0x1000)
+								stmp += "FLASH_C_AVAIL ";
+							if(data & 0x0200)
+								stmp += "FLASH_NP_FREE ";
+							if(data & 0x0080)
+								stmp += "OOB_AVAIL ";
+							if(data & 0x0040)
+								stmp += "VWIRE_AVAIL ";
+							if(data & 0x0020)
+								stmp += "NP_AVAIL ";
+							if(data & 0x0010)
+								stmp += "PC_AVAIL ";
+							pack->m_headers["Status"] = stmp;
+						}
 
 						txn_state = TXN_STATE_RESPONSE_CRC8;
 					}
@@ -846,7 +946,8 @@ void ESPIDecoder::Refresh()
 					{
 						LogDebug("Invalid response CRC (got %02x, expected %02x)\n", current_byte, crc);
 						cap->m_samples.push_back(ESPISymbol(ESPISymbol::TYPE_RESPONSE_CRC_BAD, current_byte));
-						pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_ERROR];
+						if(pack)
+							pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_ERROR];
 					}
 
 					//Commit bus width changes before the next packet
@@ -887,115 +988,119 @@ void ESPIDecoder::Refresh()
 					cap->m_durations.push_back(timestamp - bytestart);
 					cap->m_samples.push_back(ESPISymbol(ESPISymbol::TYPE_VWIRE_DATA, current_byte));
 
-					//Virtual wire indexes 0/1 are IRQs
-					if(addr <= 1)
+					if(pack)
 					{
-						stmp = "IRQ";
-						if(addr == 0)
-							stmp += to_string(current_byte & 0x7f);
-						else
-							stmp += to_string( (current_byte & 0x7f) + 128 );
-						if(current_byte & 0x80)
-							stmp += " high\n";
-						else
-							stmp += " low\n";
-
-						pack->m_headers["Info"] += stmp;
-					}
+						//Virtual wire indexes 0/1 are IRQs
+						if(addr <= 1)
+						{
+							stmp = "IRQ";
+							if(addr == 0)
+								stmp += to_string(current_byte & 0x7f);
+							else
+								stmp += to_string( (current_byte & 0x7f) + 128 );
+							if(current_byte & 0x80)
+								stmp += " high\n";
+							else
+								stmp += " low\n";
+
+							pack->m_headers["Info"] += stmp;
+						}
 
-					//Indexes 2-7 are "system events".
-					//See table 10-15
-					else if(addr <= 7)
-					{
-						switch(addr)
+						//Indexes 2-7 are "system events".
+						//See table 10-15
+						else if(addr <= 7)
 						{
-							//Table 10
-							case 2:
-								if(current_byte & 0x40)
-									stmp += string("SLP_S5#: ") + ((current_byte & 0x4)? "1" : "0") + "\n";
-								if(current_byte & 0x20)
-									stmp += string("SLP_S4#: ") + ((current_byte & 0x2)? "1" : "0") + "\n";
-								if(current_byte & 0x10)
-									stmp += string("SLP_S3#: ") + ((current_byte & 0x1)? "1" : "0") + "\n";
-								break;
+							switch(addr)
+							{
+								//Table 10
+								case 2:
+									if(current_byte & 0x40)
+										stmp += string("SLP_S5#: ") + ((current_byte & 0x4)? "1" : "0") + "\n";
+									if(current_byte & 0x20)
+										stmp += string("SLP_S4#: ") + ((current_byte & 0x2)? "1" : "0") + "\n";
+									if(current_byte & 0x10)
+										stmp += string("SLP_S3#: ") + ((current_byte & 0x1)? "1" : "0") + "\n";
+									break;
 
-							//Table 11
-							case 3:
-								if(current_byte & 0x40)
-									stmp += string("OOB_RST_WARN: ") + ((current_byte & 0x4)? "1" : "0") + "\n";
-								if(current_byte & 0x20)
-									stmp += string("PLTRST#: ") + ((current_byte & 0x2)? "1" : "0") + "\n";
-								if(current_byte & 0x10)
-									stmp += string("SUS_STAT#: ") + ((current_byte & 0x1)? "1" : "0") + "\n";
-								break;
+								//Table 11
+								case 3:
+									if(current_byte & 0x40)
+										stmp += string("OOB_RST_WARN: ") + ((current_byte & 0x4)? "1" : "0") + "\n";
+									if(current_byte & 0x20)
+										stmp += string("PLTRST#: ") + ((current_byte & 0x2)? "1" : "0") + "\n";
+									if(current_byte & 0x10)
+										stmp += string("SUS_STAT#: ") + ((current_byte & 0x1)? "1" : "0") + "\n";
+									break;
 
-							//Table 12
-							case 4:
-								if(current_byte & 0x80)
-									stmp += string("PME#: ") + ((current_byte & 0x8)? "1" : "0") + "\n";
-								if(current_byte & 0x40)
-									stmp += string("WAKE#: ") + ((current_byte & 0x4)? "1" : "0") + "\n";
-								if(current_byte & 0x10)
-									stmp += string("OOB_RST_ACK: ") + ((current_byte & 0x1)? "1" : "0") + "\n";
-								break;
+								//Table 12
+								case 4:
+									if(current_byte & 0x80)
+										stmp += string("PME#: ") + ((current_byte & 0x8)? "1" : "0") + "\n";
+									if(current_byte & 0x40)
+										stmp += string("WAKE#: ") + ((current_byte & 0x4)? "1" : "0") + "\n";
+									if(current_byte & 0x10)
+										stmp += string("OOB_RST_ACK: ") + ((current_byte & 0x1)? "1" : "0") + "\n";
+									break;
 
-							//Table 13
-							case 5:
-								if(current_byte & 0x80)
-									stmp += string("SLAVE_BOOT_LOAD_STATUS: ") + ((current_byte & 0x8)? "1" : "0") + "\n";
-								if(current_byte & 0x40)
-									stmp += string("ERROR_NONFATAL: ") + ((current_byte & 0x4)? "1" : "0") + "\n";
-								if(current_byte & 0x20)
-									stmp += string("ERROR_FATAL: ") + ((current_byte & 0x2)? "1" : "0") + "\n";
-								if(current_byte & 0x10)
-									stmp += string("SLAVE_BOOT_LOAD_DONE: ") + ((current_byte & 0x1)? "1" : "0") + "\n";
-								break;
+								//Table 13
+								case 5:
+									if(current_byte & 0x80)
+										stmp += string("SLAVE_BOOT_LOAD_STATUS: ") + ((current_byte & 0x8)? "1" : "0") + "\n";
+									if(current_byte & 0x40)
+										stmp += string("ERROR_NONFATAL: ") + ((current_byte & 0x4)? "1" : "0") + "\n";
+									if(current_byte & 0x20)
+										stmp += string("ERROR_FATAL: ") + ((current_byte & 0x2)? "1" : "0") + "\n";
+									if(current_byte & 0x10)
+										stmp += string("SLAVE_BOOT_LOAD_DONE: ") + ((current_byte & 0x1)? "1" : "0") + "\n";
+									break;
 
-							//Table 14
-							case 6:
-								if(current_byte & 0x80)
-									stmp += string("HOST_RST_ACK: ") + ((current_byte & 0x8)? "1" : "0") + "\n";
-								if(current_byte & 0x40)
-									stmp += string("RCIN#: ") + ((current_byte & 0x4)? "1" : "0") + "\n";
-								if(current_byte & 0x20)
-									stmp += string("SMI#: ") + ((current_byte & 0x2)? "1" : "0") + "\n";
-								if(current_byte & 0x10)
-									stmp += string("SCI#: ") + ((current_byte & 0x1)? "1" : "0") + "\n";
-								break;
+								//Table 14
+								case 6:
+									if(current_byte & 0x80)
+										stmp += string("HOST_RST_ACK: ") + ((current_byte & 0x8)? "1" : "0") + "\n";
+									if(current_byte & 0x40)
+										stmp += string("RCIN#: ") + ((current_byte & 0x4)? "1" : "0") + "\n";
+									if(current_byte & 0x20)
+										stmp += string("SMI#: ") + ((current_byte & 0x2)? "1" : "0") + "\n";
+									if(current_byte & 0x10)
+										stmp += string("SCI#: ") + ((current_byte & 0x1)? "1" : "0") + "\n";
+									break;
 
-							//Table 15
-							case 7:
-								if(current_byte & 0x40)
-									stmp += string("NMIOUT#: ") + ((current_byte & 0x4)? "1" : "0") + "\n";
-								if(current_byte & 0x20)
-									stmp += string("SMIOUT#: ") + ((current_byte & 0x2)? "1" : "0") + "\n";
-								if(current_byte & 0x10)
-									stmp += string("HOST_RST_WARN: ") + ((current_byte & 0x1)? "1" : "0") + "\n";
-								break;
+								//Table 15
+								case 7:
+									if(current_byte & 0x40)
+										stmp += string("NMIOUT#: ") + ((current_byte & 0x4)? "1" : "0") + "\n";
+									if(current_byte & 0x20)
+										stmp += string("SMIOUT#: ") + ((current_byte & 0x2)? "1" : "0") + "\n";
+									if(current_byte & 0x10)
+										stmp += string("HOST_RST_WARN: ") + ((current_byte & 0x1)? "1" : "0") + "\n";
+									break;
+							}
+
+							pack->m_headers["Info"] += stmp;
 						}
 
-						pack->m_headers["Info"] += stmp;
-					}
+						//Indexes 8-73 are reserved
+						else if(addr <= 63)
+							pack->m_headers["Info"] += "Reserved index\n";
 
-					//Indexes 8-73 are reserved
-					else if(addr <= 63)
-						pack->m_headers["Info"] += "Reserved index\n";
+						//64-127 platform specific
+						else if(addr <= 127)
+						{
+							snprintf(tmp, sizeof(tmp), "Platform specific %02" PRIx64 ":%02x\n", addr, current_byte);
+							pack->m_headers["Info"] += tmp;
+						}
 
-					//64-127 platform specific
-					else if(addr <= 127)
-					{
-						snprintf(tmp, sizeof(tmp), "Platform specific %02" PRIx64 ":%02x\n", addr, current_byte);
-						pack->m_headers["Info"] += tmp;
+						//128-255 GPIO expander TODO
+						else
+							pack->m_headers["Info"] += "GPIO expander decode not implemented\n";
 					}
 
-					//128-255 GPIO expander TODO
-					else
-						pack->m_headers["Info"] += "GPIO expander decode not implemented\n";
-
 					if(count == 0)
 					{
 						//Remove trailing newline
-						pack->m_headers["Info"] = Trim(pack->m_headers["Info"]);
+						if(pack)
+							pack->m_headers["Info"] = Trim(pack->m_headers["Info"]);
 
 						if(current_cmd == ESPISymbol::COMMAND_PUT_VWIRE)
 							txn_state = TXN_STATE_COMMAND_CRC8;
@@ -1015,7 +1120,8 @@ void ESPIDecoder::Refresh()
 				// Flash channel
 
 				case TXN_STATE_FLASH_TYPE:
-					pack->m_data.push_back(current_byte);
+					if(pack)
+						pack->m_data.push_back(current_byte);
 
 					cap->m_offsets.push_back(bytestart);
 					cap->m_durations.push_back(timestamp - bytestart);
@@ -1027,43 +1133,58 @@ void ESPIDecoder::Refresh()
 					switch(cycle_type)
 					{
 						case ESPISymbol::CYCLE_ERASE:
-							pack->m_headers["Info"] = "Erase";
-							pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_DATA_WRITE];
+							if(pack)
+							{
+								pack->m_headers["Info"] = "Erase";
+								pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_DATA_WRITE];
+							}
 							break;
 
 						case ESPISymbol::CYCLE_READ:
-							pack->m_headers["Info"] = "Read";
-							pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_DATA_READ];
+							if(pack)
+							{
+								pack->m_headers["Info"] = "Read";
+								pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_DATA_READ];
+							}
 							break;
 
 						case ESPISymbol::CYCLE_WRITE:
-							pack->m_headers["Info"] = "Write";
-							pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_DATA_WRITE];
+							if(pack)
+							{
+								pack->m_headers["Info"] = "Write";
+								pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_DATA_WRITE];
+							}
 							break;
 
 						case ESPISymbol::CYCLE_SUCCESS_DATA_FIRST:
 						case ESPISymbol::CYCLE_SUCCESS_DATA_MIDDLE:
 						case ESPISymbol::CYCLE_SUCCESS_DATA_LAST:
 						case ESPISymbol::CYCLE_SUCCESS_DATA_ONLY:
-							pack->m_headers["Info"] = "Read Data";
-							pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_DATA_READ];
+							if(pack)
+							{
+								pack->m_headers["Info"] = "Read Data";
+								pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_DATA_READ];
+							}
 							break;
 
 						default:
-							pack->m_headers["Info"] = "Unknown flash op";
+							if(pack)
+								pack->m_headers["Info"] = "Unknown flash op";
 							break;
 					}
 
 					break;	//end TXN_STATE_FLASH_TYPE
 
 				case TXN_STATE_FLASH_TAG_LENHI:
-					pack->m_data.push_back(current_byte);
+					if(pack)
+						pack->m_data.push_back(current_byte);
 
 					//Tag is high 4 bits
 					cap->m_offsets.push_back(bytestart);
 					cap->m_durations.push_back(timestamp - bytestart);
 					cap->m_samples.push_back(ESPISymbol(ESPISymbol::TYPE_REQUEST_TAG, current_byte >> 4));
-					pack->m_headers["Tag"] = to_string(current_byte >> 4);
+					if(pack)
+						pack->m_headers["Tag"] = to_string(current_byte >> 4);
 
 					//Low 4 bits of this byte are the high length bits
 					data = current_byte & 0xf;
@@ -1072,7 +1193,8 @@ void ESPIDecoder::Refresh()
 					break;	//end TXN_STATE_FLASH_TAG_LENHI
 
 				case TXN_STATE_FLASH_LENLO:
-					pack->m_data.push_back(current_byte);
+					if(pack)
+						pack->m_data.push_back(current_byte);
 
 					//Save the rest of the length
 					cap->m_offsets.push_back(bytestart);
@@ -1080,7 +1202,8 @@ void ESPIDecoder::Refresh()
 					payload_len = current_byte | data;
 					cap->m_samples.push_back(ESPISymbol(ESPISymbol::TYPE_REQUEST_LEN, payload_len));
 
-					pack->m_headers["Len"] = to_string(payload_len);
+					if(pack)
+						pack->m_headers["Len"] = to_string(payload_len);
 
 					//Get ready to read the address or data
 					count = 0;
@@ -1088,7 +1211,8 @@ void ESPIDecoder::Refresh()
 
 					if(cycle_type >= ESPISymbol::CYCLE_SUCCESS_NODATA)
 					{
-						pack->m_data.clear();
+						if(pack)
+							pack->m_data.clear();
 						txn_state = TXN_STATE_FLASH_DATA;
 					}
 					else
@@ -1118,7 +1242,8 @@ void ESPIDecoder::Refresh()
 						//Don't report free space in the protocol analyzer
 						//to save column space
 						snprintf(tmp, sizeof(tmp), "%08" PRIx64, data);
-						pack->m_headers["Address"] = tmp;
+						if(pack)
+							pack->m_headers["Address"] = tmp;
 
 						count = 0;
 						data = 0;
@@ -1126,7 +1251,8 @@ void ESPIDecoder::Refresh()
 						//Write requests are followed by data
 						if(cycle_type == ESPISymbol::CYCLE_WRITE)
 						{
-							pack->m_data.clear();
+							if(pack)
+								pack->m_data.clear();
 							txn_state = TXN_STATE_FLASH_DATA;
 						}
 
@@ -1139,7 +1265,8 @@ void ESPIDecoder::Refresh()
 
 				case TXN_STATE_FLASH_DATA:
 
-					pack->m_data.push_back(current_byte);
+					if(pack)
+						pack->m_data.push_back(current_byte);
 
 					//Save the data byte
 					cap->m_offsets.push_back(bytestart);
@@ -1182,7 +1309,8 @@ void ESPIDecoder::Refresh()
 					cap->m_offsets.push_back(bytestart);
 					cap->m_durations.push_back(timestamp - bytestart);
 					cap->m_samples.push_back(ESPISymbol(ESPISymbol::TYPE_REQUEST_TAG, current_byte >> 4));
-					pack->m_headers["Tag"] = to_string(current_byte >> 4);
+					if(pack)
+						pack->m_headers["Tag"] = to_string(current_byte >> 4);
 
 					//Low 4 bits of this byte are the high length bits
 					data = current_byte & 0xf;
@@ -1198,7 +1326,8 @@ void ESPIDecoder::Refresh()
 					payload_len = current_byte | data;
 					cap->m_samples.push_back(ESPISymbol(ESPISymbol::TYPE_REQUEST_LEN, payload_len));
 
-					pack->m_headers["Len"] = to_string(payload_len);
+					if(pack)
+						pack->m_headers["Len"] = to_string(payload_len);
 
 					txn_state = TXN_STATE_SMBUS_ADDR;
 
@@ -1206,7 +1335,8 @@ void ESPIDecoder::Refresh()
 
 				case TXN_STATE_SMBUS_ADDR:
 
-					pack->m_data.clear();
+					if(pack)
+						pack->m_data.clear();
 
 					//Save the SMBus address
 					cap->m_offsets.push_back(bytestart);
@@ -1214,7 +1344,8 @@ void ESPIDecoder::Refresh()
 					cap->m_samples.push_back(ESPISymbol(ESPISymbol::TYPE_SMBUS_REQUEST_ADDR, current_byte));
 
 					snprintf(tmp, sizeof(tmp), "%02x", current_byte);
-					pack->m_headers["Address"] = tmp;
+					if(pack)
+						pack->m_headers["Address"] = tmp;
 
 					//Get ready to read the packet data
 					//We already read the first byte of the SMBus packet (the slave address)
@@ -1229,7 +1360,8 @@ void ESPIDecoder::Refresh()
 				case TXN_STATE_SMBUS_DATA:
 
 					//Save the data byte
-					pack->m_data.push_back(current_byte);
+					if(pack)
+						pack->m_data.push_back(current_byte);
 					cap->m_offsets.push_back(bytestart);
 					cap->m_durations.push_back(timestamp - bytestart);
 					cap->m_samples.push_back(ESPISymbol(ESPISymbol::TYPE_SMBUS_REQUEST_DATA, current_byte));
@@ -1275,9 +1407,11 @@ void ESPIDecoder::Refresh()
 						cap->m_samples.push_back(ESPISymbol(ESPISymbol::TYPE_IO_ADDR, addr));
 
 						snprintf(tmp, sizeof(tmp), "%04" PRIx64, addr);
-						pack->m_headers["Address"] = tmp;
+						if(pack)
+							pack->m_headers["Address"] = tmp;
 
-						pack->m_headers["Len"] = to_string(payload_len);
+						if(pack)
+							pack->m_headers["Len"] = to_string(payload_len);
 
 						count = 0;
 						txn_state = TXN_STATE_IOWR_DATA;
@@ -1288,7 +1422,8 @@ void ESPIDecoder::Refresh()
 				case TXN_STATE_IOWR_DATA:
 
 					//Save the data byte
-					pack->m_data.push_back(current_byte);
+					if(pack)
+						pack->m_data.push_back(current_byte);
 					cap->m_offsets.push_back(bytestart);
 					cap->m_durations.push_back(timestamp - bytestart);
 					cap->m_samples.push_back(ESPISymbol(ESPISymbol::TYPE_SMBUS_REQUEST_DATA, current_byte));
@@ -1324,7 +1459,8 @@ void ESPIDecoder::Refresh()
 						cap->m_samples.push_back(ESPISymbol(ESPISymbol::TYPE_IO_ADDR, addr));
 
 						snprintf(tmp, sizeof(tmp), "%04" PRIx64, addr);
-						pack->m_headers["Address"] = tmp;
+						if(pack)
+							pack->m_headers["Address"] = tmp;
 
 						count = 0;
 						txn_state = TXN_STATE_COMMAND_CRC8;
@@ -1344,20 +1480,23 @@ void ESPIDecoder::Refresh()
 					switch(current_byte)
 					{
 						case ESPISymbol::CYCLE_SUCCESS_NODATA:
-							pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_STATUS];
+							if(pack)
+								pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_STATUS];
 							break;
 
 						case ESPISymbol::CYCLE_SUCCESS_DATA_MIDDLE:
 						case ESPISymbol::CYCLE_SUCCESS_DATA_FIRST:
 						case ESPISymbol::CYCLE_SUCCESS_DATA_LAST:
 						case ESPISymbol::CYCLE_SUCCESS_DATA_ONLY:
-							pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_DATA_READ];
+							if(pack)
+								pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_DATA_READ];
 							break;
 
 						case ESPISymbol::CYCLE_FAIL_LAST:
 						case ESPISymbol::CYCLE_FAIL_ONLY:
 						default:
-							pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_ERROR];
+							if(pack)
+								pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_ERROR];
 							break;
 					}
 
@@ -1371,7 +1510,8 @@ void ESPIDecoder::Refresh()
 					cap->m_offsets.push_back(bytestart);
 					cap->m_durations.push_back(timestamp - bytestart);
 					cap->m_samples.push_back(ESPISymbol(ESPISymbol::TYPE_REQUEST_TAG, current_byte >> 4));
-					pack->m_headers["Tag"] = to_string(current_byte >> 4);
+					if(pack)
+						pack->m_headers["Tag"] = to_string(current_byte >> 4);
 
 					//Low 4 bits of this byte are the high length bits
 					data = current_byte & 0xf;
@@ -1387,7 +1527,8 @@ void ESPIDecoder::Refresh()
 					payload_len = current_byte | data;
 					cap->m_samples.push_back(ESPISymbol(ESPISymbol::TYPE_REQUEST_LEN, payload_len));
 
-					pack->m_headers["Len"] = to_string(payload_len);
+					if(pack)
+						pack->m_headers["Len"] = to_string(payload_len);
 
 					if(payload_len == 0)
 						txn_state = TXN_STATE_STATUS;
@@ -1399,7 +1540,8 @@ void ESPIDecoder::Refresh()
 				case TXN_STATE_COMPLETION_DATA:
 
 					//Save the data byte
-					pack->m_data.push_back(current_byte);
+					if(pack)
+						pack->m_data.push_back(current_byte);
 					cap->m_offsets.push_back(bytestart);
 					cap->m_durations.push_back(timestamp - bytestart);
 					cap->m_samples.push_back(ESPISymbol(ESPISymbol::TYPE_COMPLETION_DATA, current_byte));
@@ -1442,7 +1584,42 @@ void ESPIDecoder::Refresh()
 		AdvanceToTimestamp(sdata3, udata3, idata[3], datalen[3], timestamp);
 	}
 
-	cap->MarkModifiedFromCpu();
+	//Null in the structural pass; only non-null if we were materializing a transaction truncated
+	//at the end of the capture (so there was no chip select rising edge to return at)
+	return pack;
+}
+
+Packet* ESPIDecoder::GetPacket(size_t i)
+{
+	if(i >= m_packets.size())
+		return nullptr;
+
+	//Materialize on first access: re-run the decode engine over just this transaction.
+	//Symbols go to a scratch waveform (our real output already has them, we only want the text here).
+	if(!m_packets[i])
+	{
+		auto data = GetData(0);
+		if(!data)
+			return nullptr;
+
+		ESPIWaveform scratch;
+		scratch.m_timescale = data->m_timescale;
+		scratch.m_startTimestamp = data->m_startTimestamp;
+		scratch.m_startFemtoseconds = data->m_startFemtoseconds;
+		scratch.m_triggerPhase = data->m_triggerPhase;
+
+		m_packets[i] = DoDecode(&scratch, false, &m_transactionIndex[i]);
+	}
+
+	return m_packets[i];
+}
+
+const vector<Packet*>& ESPIDecoder::GetPackets()
+{
+	//Legacy bulk interface: materialize everything before handing out the list
+	for(size_t i=0; i<m_packets.size(); i++)
+		GetPacket(i);
+	return m_packets;
 }
 
 uint8_t ESPIDecoder::UpdateCRC8(uint8_t crc, uint8_t data)
@@ -207,6 +207,9 @@ public:
 
 	std::vector<std::string> GetHeaders() override;
 
+	virtual const std::vector<Packet*>& GetPackets() override;
+	virtual Packet* GetPacket(size_t i) override;
+
 	static std::string GetProtocolName();
 
 	virtual bool ValidateChannel(size_t i, StreamDescriptor stream) override;
@@ -226,6 +229,27 @@ protected:
 		BUS_WIDTH_X4
 	};
 
+	/**
+		@brief Position in the input waveforms at the start of one transaction.
+
+		Records everything the decode engine needs to re-enter the capture at a chip select falling edge:
+		the per-channel sample indices, the timestamp, and the bus width in effect at that point (which can
+		change mid-capture via SET_CONFIGURATION writes).
+	 */
+	struct TransactionCursor
+	{
+		size_t m_ics;
+		size_t m_iclk;
+		size_t m_idata[4];
+		int64_t m_timestamp;
+		BusWidth m_busWidthMode;
+	};
+
+	Packet* DoDecode(ESPIWaveform* cap, bool structural, const TransactionCursor* start);
+
+	///@brief Start cursor of each transaction, recorded by the structural pass for lazy materialization
+	std::vector<TransactionCursor> m_transactionIndex;
+
 	std::string m_busWidthName;
 };
 
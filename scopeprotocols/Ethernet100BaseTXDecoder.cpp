@@ -28,6 +28,7 @@
 ***********************************************************************************************************************/
 
 #include "../scopehal/scopehal.h"
+#include "../scopehal/LineCodeKernels.h"
 #include "EthernetProtocolDecoder.h"
 #include "Ethernet100BaseTXDecoder.h"
 
@@ -116,14 +117,18 @@ void Ethernet100BaseTXDecoder::Refresh()
 		oldstate = nstate;
 	}
 
-	//RX LFSR sync
+	//Pack the line bits into 64-bit words so sync candidates can be tested one word XOR at a time
 	size_t nbits = bits.m_samples.size();
+	vector<uint64_t> packed(((nbits + 63) / 64) + 1, 0);
+	LineCodeKernels::PackBits(bits.m_samples.GetCpuPointer(), nbits, packed.data());
+
+	//RX LFSR sync
 	SparseDigitalWaveform descrambled_bits;
 	descrambled_bits.PrepareForCpuAccess();
 	bool synced = false;
 	for(size_t idle_offset = 0; idle_offset<15000; idle_offset++)
 	{
-		if(TrySync(bits, descrambled_bits, idle_offset, nbits))
+		if(TrySync(bits, packed.data(), descrambled_bits, idle_offset, nbits))
 		{
 			LogTrace("Got good LFSR sync at offset %zu\n", idle_offset);
 			synced = true;
@@ -288,13 +293,13 @@ void Ethernet100BaseTXDecoder::Refresh()
 
 bool Ethernet100BaseTXDecoder::TrySync(
 	SparseDigitalWaveform& bits,
+	const uint64_t* packed,
 	SparseDigitalWaveform& descrambled_bits,
 	size_t idle_offset,
 	size_t stop)
 {
 	if( (idle_offset + 64) >= bits.m_samples.size())
 		return false;
-	descrambled_bits.clear();
 
 	//For now, assume the link is idle at the time we triggered
 	unsigned int lfsr =
@@ -310,33 +315,56 @@ bool Ethernet100BaseTXDecoder::TrySync(
 		( (!bits.m_samples[idle_offset + 9]) << 1 ) |
 		( (!bits.m_samples[idle_offset + 10]) << 0 );
 
-	//Descramble
 	stop = min(stop, bits.m_samples.size());
 	size_t start = idle_offset + 11;
+
+	//Generate the first keystream word bitwise, then jump 64 bits at a time
+	uint64_t kword = 0;
+	{
+		unsigned int tmp = lfsr;
+		for(int j=0; j<64; j++)
+		{
+			tmp = (tmp << 1) ^ ((tmp >> 8)&1) ^ ((tmp >> 10)&1);
+			kword |= static_cast<uint64_t>(tmp & 1) << j;
+		}
+	}
+
+	//We should have at least 64 "1" bits in a row once the descrambling is done.
+	//The minimum inter-frame gap is a lot bigger than this.
+	//Test that window up front as one packed XOR against leapfrogged keystream, so a bad offset is rejected
+	//without descrambling anything. (Skipped, as before, if the capture is too short to reach the window.)
+	size_t checkpos = 2 * (idle_offset + 11);
+	if(stop >= (checkpos + 64))
+	{
+		size_t n0 = idle_offset + 11;
+		uint64_t kw = kword;
+		for(size_t w=0; w < (n0 >> 6); w++)
+			kw = LineCodeKernels::AdvanceSideStreamScrambler64(kw);
+		uint64_t ks[3] = { kw, LineCodeKernels::AdvanceSideStreamScrambler64(kw), 0 };
+
+		uint64_t keys = LineCodeKernels::ExtractBitWindow(ks, n0 & 63);
+		uint64_t line = LineCodeKernels::ExtractBitWindow(packed, checkpos);
+		if( (line ^ keys) != ~static_cast<uint64_t>(0) )
+			return false;
+	}
+
+	//Descramble
+	descrambled_bits.clear();
 	size_t len = stop - start;
 	descrambled_bits.m_offsets.reserve(len);
 	descrambled_bits.m_durations.reserve(len);
 	descrambled_bits.m_samples.reserve(len);
-	size_t window = 64 + idle_offset + 11;
+	uint64_t kw = kword;
 	for(size_t i=start; i < stop; i++)
 	{
-		lfsr = (lfsr << 1) ^ ((lfsr >> 8)&1) ^ ((lfsr >> 10)&1);
+		size_t n = i - start;
+		if( ((n & 63) == 0) && (n != 0) )
+			kw = LineCodeKernels::AdvanceSideStreamScrambler64(kw);
 
 		descrambled_bits.m_offsets.push_back(bits.m_offsets[i]);
 		descrambled_bits.m_durations.push_back(bits.m_durations[i]);
-		bool b = bits.m_samples[i] ^ (lfsr & 1);
+		bool b = bits.m_samples[i] ^ ((kw >> (n & 63)) & 1);
 		descrambled_bits.m_samples.push_back(b);
-
-		if(descrambled_bits.m_samples.size() == window)
-		{
-			//We should have at least 64 "1" bits in a row once the descrambling is done.
-			//The minimum inter-frame gap is a lot bigger than this.
-			for(int j=0; j<64; j++)
-			{
-				if(descrambled_bits.m_samples[j + idle_offset + 11] != 1)
-					return false;
-			}
-		}
 	}
 
 	//Synced, all good
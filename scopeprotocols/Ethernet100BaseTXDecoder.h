@@ -51,6 +51,7 @@ protected:
 	int GetState(float voltage);
 	bool TrySync(
 		SparseDigitalWaveform& bits,
+		const uint64_t* packed,
 		SparseDigitalWaveform& descrambled_bits,
 		size_t idle_offset,
 		size_t stop);
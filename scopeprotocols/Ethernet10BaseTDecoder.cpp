@@ -28,6 +28,7 @@
 ***********************************************************************************************************************/
 
 #include "../scopehal/scopehal.h"
+#include "../scopehal/LineCodeKernels.h"
 #include "EthernetProtocolDecoder.h"
 #include "Ethernet10BaseTDecoder.h"
 
@@ -233,34 +234,20 @@ void Ethernet10BaseTDecoder::Refresh()
 
 bool Ethernet10BaseTDecoder::FindFallingEdge(size_t& i, UniformAnalogWaveform* cap)
 {
-	size_t j = i;
 	size_t len = cap->m_samples.size();
-	while(j < len)
-	{
-		if(cap->m_samples[j] < -1)
-		{
-			i = j;
-			return true;
-		}
-		j++;
-	}
-
-	return false;	//not found
+	size_t j = LineCodeKernels::FindNextBelow(cap->m_samples.GetCpuPointer(), len, i, -1);
+	if(j >= len)
+		return false;	//not found
+	i = j;
+	return true;
 }
 
 bool Ethernet10BaseTDecoder::FindRisingEdge(size_t& i, UniformAnalogWaveform* cap)
 {
-	size_t j = i;
 	size_t len = cap->m_samples.size();
-	while(j < len)
-	{
-		if(cap->m_samples[j] > 1)
-		{
-			i = j;
-			return true;
-		}
-		j++;
-	}
-
-	return false;	//not found
+	size_t j = LineCodeKernels::FindNextAbove(cap->m_samples.GetCpuPointer(), len, i, 1);
+	if(j >= len)
+		return false;	//not found
+	i = j;
+	return true;
 }
@@ -119,8 +119,8 @@ void Ethernet64b66bDecoder::Refresh()
 
 
 	//Decode the actual data
-	bool first		= true;
-	uint64_t lfsr	= 0;
+	bool first			= true;
+	uint64_t history	= 0;
 
 	for(size_t i=best_offset; i<end; i += 66)
 	{
@@ -129,18 +129,14 @@ void Ethernet64b66bDecoder::Refresh()
 			(data.m_samples[i] ? 2 : 0) |
 			(data.m_samples[i+1] ? 1 : 0);
 
-		//Extract the data bits and descramble them.
-		uint64_t codeword = 0;
+		//Extract the data bits, then descramble the whole block at once
+		uint64_t raw = 0;
 		for(size_t j=0; j<64; j++)
 		{
-			bool b = data.m_samples[i + 2 + j];
-
-			codeword >>= 1;
-			if(b ^ ( (lfsr >> 38) & 1) ^ ( (lfsr >> 57) & 1) )
-				codeword |= 0x8000000000000000L;
-
-			lfsr = (lfsr << 1) | b;
+			if(data.m_samples[i + 2 + j])
+				raw |= (static_cast<uint64_t>(1) << j);
 		}
+		uint64_t codeword = Descramble64b66b(raw, history);
 
 		//Need to swap bit/byte ordering around a bunch.
 		uint64_t bytes[8] =
@@ -38,6 +38,7 @@ using namespace std;
 ExponentialMovingAverageFilter::ExponentialMovingAverageFilter(const string& color)
 	: Filter(color, CAT_MATH)
 	, m_halflife("Half-life")
+	, m_computePipeline("shaders/ExponentialMovingAverage.spv", 2, sizeof(ExponentialMovingAverageArgs))
 {
 	AddStream(Unit(Unit::UNIT_VOLTS), "data", Stream::STREAM_TYPE_ANALOG);
 	CreateInput("din");
@@ -83,7 +84,7 @@ void ExponentialMovingAverageFilter::ClearSweeps()
 	SetData(nullptr, 0);
 }
 
-void ExponentialMovingAverageFilter::Refresh(vk::raii::CommandBuffer& /*cmdBuf*/, shared_ptr<QueueHandle> /*queue*/)
+void ExponentialMovingAverageFilter::Refresh(vk::raii::CommandBuffer& cmdBuf, shared_ptr<QueueHandle> queue)
 {
 	//Make sure we've got valid inputs
 	if(!VerifyAllInputsOK())
@@ -102,8 +103,6 @@ void ExponentialMovingAverageFilter::Refresh(vk::raii::CommandBuffer& /*cmdBuf*/
 	float hl = m_parameters[m_halflife].GetIntVal();
 	float decay = 1 / pow(2, 1/hl);
 
-	din->PrepareForCpuAccess();
-
 	//Set up units
 	m_xAxisUnit = m_inputs[0].m_channel->GetXAxisUnits();
 	SetYAxisUnits(m_inputs[0].GetYAxisUnits(), 0);
@@ -112,30 +111,32 @@ void ExponentialMovingAverageFilter::Refresh(vk::raii::CommandBuffer& /*cmdBuf*/
 	auto cap = GetData(0);
 	auto scap = dynamic_cast<SparseAnalogWaveform*>(cap);
 	auto ucap = dynamic_cast<UniformAnalogWaveform*>(cap);
-	if(cap)
-		cap->PrepareForCpuAccess();
+
+	//The blend reads the previous output, so it's only meaningful if the record length hasn't changed.
+	//On the first waveform, or after a memory depth change, restart the average from the new input.
+	AcceleratorBuffer<float>* pin = nullptr;
+	AcceleratorBuffer<float>* pout = nullptr;
 
 	//Sparse path
 	if(sdin)
 	{
-		//No data? Just copy
-		if(!scap)
+		//No prior data? Just copy
+		if(!scap || (scap->size() != len) )
 		{
-			scap = new SparseAnalogWaveform;
-			scap->Resize(din->size());
-			cap = scap;
-
+			if(!scap)
+			{
+				scap = new SparseAnalogWaveform;
+				cap = scap;
+			}
+			scap->Resize(len);
 			scap->m_samples.CopyFrom(sdin->m_samples);
 		}
 
 		//Actual filter code path
 		else
 		{
-			auto pin = sdin->m_samples.GetCpuPointer();
-			auto pout = scap->m_samples.GetCpuPointer();
-
-			for(size_t i=0; i<len; i++)
-				pout[i] = pout[i]*decay + pin[i]*(1-decay);
+			pin = &sdin->m_samples;
+			pout = &scap->m_samples;
 		}
 
 		//Either way we want to reuse the timestamps
@@ -145,27 +146,45 @@ void ExponentialMovingAverageFilter::Refresh(vk::raii::CommandBuffer& /*cmdBuf*/
 	//Uniform path
 	else
 	{
-		//No data? Just copy
-		if(!ucap)
+		//No prior data? Just copy
+		if(!ucap || (ucap->size() != len) )
 		{
-			ucap = new UniformAnalogWaveform;
-			ucap->Resize(din->size());
-			cap = ucap;
-
+			if(!ucap)
+			{
+				ucap = new UniformAnalogWaveform;
+				cap = ucap;
+			}
+			ucap->Resize(len);
 			ucap->m_samples.CopyFrom(udin->m_samples);
 		}
 
 		//Actual filter code path
 		else
 		{
-			auto pin = udin->m_samples.GetCpuPointer();
-			auto pout = ucap->m_samples.GetCpuPointer();
-
-			for(size_t i=0; i<len; i++)
-				pout[i] = pout[i]*decay + pin[i]*(1-decay);
+			pin = &udin->m_samples;
+			pout = &ucap->m_samples;
 		}
 	}
 
+	//Steady state: blend the new waveform into the accumulated output on the GPU.
+	//The blend is element-wise between this waveform and the previous output (not a scan along the waveform),
+	//so a GPU-resident input never has to visit the CPU on its way through us.
+	if(pin)
+	{
+		ExponentialMovingAverageArgs args;
+		args.len = len;
+		args.decay = decay;
+
+		cmdBuf.begin({});
+		m_computePipeline.BindBufferNonblocking(0, *pin, cmdBuf);
+		m_computePipeline.BindBufferNonblocking(1, *pout, cmdBuf);
+		m_computePipeline.Dispatch(cmdBuf, args, GetComputeBlockCount(len, 64));
+		cmdBuf.end();
+		queue->SubmitAndBlock(cmdBuf);
+
+		pout->MarkModifiedFromGpu();
+	}
+
 	//Update timestamps
 	cap->m_startTimestamp 		= din->m_startTimestamp;
 	cap->m_startFemtoseconds	= din->m_startFemtoseconds;
@@ -175,7 +194,6 @@ void ExponentialMovingAverageFilter::Refresh(vk::raii::CommandBuffer& /*cmdBuf*/
 
 	//Done
 	SetData(cap, 0);
-	cap->MarkModifiedFromCpu();
 }
 
 Filter::DataLocation ExponentialMovingAverageFilter::GetInputLocation()
@@ -37,6 +37,12 @@
 
 class QueueHandle;
 
+struct ExponentialMovingAverageArgs
+{
+	uint32_t len;
+	float decay;
+};
+
 class ExponentialMovingAverageFilter : public Filter
 {
 public:
@@ -56,6 +62,9 @@ public:
 
 protected:
 	std::string m_halflife;
+
+	///@brief Compute pipeline for blending a new waveform into the accumulated output
+	ComputePipeline m_computePipeline;
 };
 
 #endif
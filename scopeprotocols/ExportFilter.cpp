@@ -39,7 +39,11 @@ ExportFilter::ExportFilter(const string& color)
 	: Filter(color, CAT_EXPORT)
 	, m_fname("File name")
 	, m_mode("Update mode")
+	, m_overflowPolicy("Overflow policy")
 	, m_fp(nullptr)
+	, m_writeQueueBytes(0)
+	, m_writerBusy(false)
+	, m_writerShuttingDown(false)
 {
 	//No output stream
 
@@ -62,10 +66,27 @@ ExportFilter::ExportFilter(const string& color)
 
 	//Default to manual trigger mode so we don't have the file grow huge before the user can react
 	m_parameters[m_mode].SetIntVal(MODE_MANUAL_OVERWRITE);
+
+	m_parameters[m_overflowPolicy] = FilterParameter(FilterParameter::TYPE_ENUM, Unit(Unit::UNIT_COUNTS));
+	m_parameters[m_overflowPolicy].AddEnumValue("Block (lossless)", POLICY_BLOCK);
+	m_parameters[m_overflowPolicy].AddEnumValue("Drop (bounded latency)", POLICY_DROP);
+	m_parameters[m_overflowPolicy].SetIntVal(POLICY_BLOCK);
+
+	//Spin up the background writer so export I/O happens off the filter graph thread
+	m_writerThread = make_unique<thread>(&ExportFilter::WriterThread, this);
 }
 
 ExportFilter::~ExportFilter()
 {
+	//Drain any pending writes, then shut down the writer before touching the file
+	FlushWriteQueue();
+	{
+		lock_guard<mutex> lock(m_writeMutex);
+		m_writerShuttingDown = true;
+	}
+	m_writeWorkCond.notify_all();
+	m_writerThread->join();
+
 	if(m_fp)
 		fclose(m_fp);
 	m_fp = nullptr;
@@ -118,6 +139,8 @@ bool ExportFilter::PerformAction(const string& id)
  */
 void ExportFilter::OnFileNameChanged()
 {
+	FlushWriteQueue();
+
 	if(m_fp)
 		fclose(m_fp);
 	m_fp = nullptr;
@@ -128,6 +151,8 @@ void ExportFilter::OnFileNameChanged()
  */
 void ExportFilter::Clear()
 {
+	FlushWriteQueue();
+
 	//Close the file if it was open
 	if(m_fp)
 		fclose(m_fp);
@@ -138,3 +163,80 @@ void ExportFilter::Clear()
 	if(ftmp)
 		fclose(ftmp);
 }
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Background writer
+
+void ExportFilter::QueueWrite(string&& data)
+{
+	if(data.empty())
+		return;
+
+	unique_lock<mutex> lock(m_writeMutex);
+
+	//A single block bigger than the bound can never fit alongside anything else, so waiting for
+	//headroom would deadlock and dropping would silently lose the whole export. Admit it alone:
+	//wait for the writer to drain completely, then queue it regardless of policy.
+	if(data.size() > MAX_WRITE_QUEUE_BYTES)
+		m_writeDoneCond.wait(lock, [this]{ return m_writeQueue.empty() && !m_writerBusy; });
+
+	//Queue full: apply the overflow policy
+	else if((m_writeQueueBytes + data.size()) > MAX_WRITE_QUEUE_BYTES)
+	{
+		if(static_cast<OverflowPolicy_t>(m_parameters[m_overflowPolicy].GetIntVal()) == POLICY_DROP)
+		{
+			LogTrace("ExportFilter: write queue full, dropping %zu bytes\n", data.size());
+			return;
+		}
+
+		//Lossless mode: wait for the writer to catch up
+		m_writeDoneCond.wait(lock,
+			[this, &data]{ return (m_writeQueueBytes + data.size()) <= MAX_WRITE_QUEUE_BYTES; });
+	}
+
+	m_writeQueueBytes += data.size();
+	m_writeQueue.push_back(std::move(data));
+	lock.unlock();
+	m_writeWorkCond.notify_one();
+}
+
+void ExportFilter::FlushWriteQueue()
+{
+	unique_lock<mutex> lock(m_writeMutex);
+	m_writeDoneCond.wait(lock, [this]{ return m_writeQueue.empty() && !m_writerBusy; });
+}
+
+void ExportFilter::WriterThread()
+{
+	#ifdef __linux__
+	pthread_setname_np(pthread_self(), "ExportWriter");
+	#endif
+
+	while(true)
+	{
+		string block;
+		{
+			unique_lock<mutex> lock(m_writeMutex);
+			m_writeWorkCond.wait(lock, [this]{ return m_writerShuttingDown || !m_writeQueue.empty(); });
+			if(m_writerShuttingDown)
+				return;
+
+			block = std::move(m_writeQueue.front());
+			m_writeQueue.pop_front();
+			m_writerBusy = true;
+		}
+
+		//Do the actual write with the lock released, so the graph thread can keep formatting.
+		//m_fp is only opened/closed on the foreground thread after FlushWriteQueue(), so it can't
+		//change out from under us mid-block.
+		if(m_fp)
+			fwrite(block.data(), 1, block.size(), m_fp);
+
+		{
+			lock_guard<mutex> lock(m_writeMutex);
+			m_writeQueueBytes -= block.size();
+			m_writerBusy = false;
+		}
+		m_writeDoneCond.notify_all();
+	}
+}
@@ -37,6 +37,10 @@
 
 #include "../scopehal/ActionProvider.h"
 
+#include <condition_variable>
+#include <deque>
+#include <thread>
+
 class ExportFilter
 	: public Filter
 	, public ActionProvider
@@ -58,7 +62,7 @@ protected:
 	virtual void Clear();
 
 	/**
-		@brief Writes the current inputs to the output file in the appropriate format
+		@brief Formats the current inputs and queues them for writing in the appropriate format
 	 */
 	virtual void Export() =0;
 
@@ -70,12 +74,66 @@ protected:
 		MODE_MANUAL_OVERWRITE
 	};
 
+	enum OverflowPolicy_t
+	{
+		POLICY_BLOCK,
+		POLICY_DROP
+	};
+
 	std::string m_fname;
 	std::string m_mode;
+	std::string m_overflowPolicy;
 
 	FILE* m_fp;
 
 	void OnFileNameChanged();
+
+	/**
+		@brief Hands a block of formatted output to the background writer thread
+
+		Subclass Export() implementations format into memory on the filter graph thread (input waveforms are
+		only guaranteed valid during the pass), then queue the bytes here so disk latency never stalls the
+		graph. The queue is bounded: when it fills, the overflow policy decides whether we block until the
+		writer catches up (lossless) or discard the block (bounded latency).
+	 */
+	void QueueWrite(std::string&& data);
+
+	/**
+		@brief Blocks until the writer thread has drained the queue
+
+		Must be called before closing or reopening m_fp on the foreground thread, since the writer holds no
+		lock on the file itself.
+	 */
+	void FlushWriteQueue();
+
+	///@brief Upper bound on formatted data buffered for the writer thread before the overflow policy kicks in
+	static const size_t MAX_WRITE_QUEUE_BYTES = 32 * 1024 * 1024;
+
+	void WriterThread();
+
+	///@brief Mutex protecting the write queue and associated state
+	std::mutex m_writeMutex;
+
+	///@brief Signaled when work is added to the queue (or at shutdown)
+	std::condition_variable m_writeWorkCond;
+
+	///@brief Signaled when the writer finishes a block (wakes blocked producers and FlushWriteQueue)
+	std::condition_variable m_writeDoneCond;
+
+	///@brief Formatted blocks awaiting write, oldest first
+	std::deque<std::string> m_writeQueue;
+
+	///@brief Total bytes in m_writeQueue
+	size_t m_writeQueueBytes;
+
+	///@brief True while the writer thread is mid-fwrite on a popped block
+	bool m_writerBusy;
+
+	///@brief Set during destruction to ask the writer thread to exit
+	bool m_writerShuttingDown;
+
+	///@brief Background writer thread
+	std::unique_ptr<std::thread> m_writerThread;
 };
 
 #endif
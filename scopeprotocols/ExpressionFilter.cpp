@@ -0,0 +1,607 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopeprotocols                                                                                                    *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Implementation of ExpressionFilter
+ */
+#include "../scopehal/scopehal.h"
+#include "ExpressionFilter.h"
+
+using namespace std;
+
+namespace
+{
+	///@brief Push constants for the generated shader
+	struct ExpressionShaderArgs
+	{
+		uint32_t size;
+	};
+
+	///@brief Function name table, indexed by ExprFunc (names are identical in the grammar, GLSL, and libm)
+	const char* g_exprFuncNames[] =
+	{
+		"abs",
+		"sqrt",
+		"exp",
+		"log",
+		"sin",
+		"cos",
+		"tan",
+		"floor",
+		"ceil",
+		"min",
+		"max",
+		"pow"
+	};
+
+	///@brief Number of arguments each ExprFunc takes
+	const int g_exprFuncArgs[] = { 1, 1, 1, 1, 1, 1, 1, 1, 1, 2, 2, 2 };
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Construction / destruction
+
+ExpressionFilter::ExpressionFilter(const string& color)
+	: Filter(color, CAT_MATH)
+	, m_parseOk(false)
+	, m_pipelineOk(false)
+	, m_root(-1)
+	, m_computePipeline("", 0, sizeof(ExpressionShaderArgs))
+{
+	AddStream(Unit(Unit::UNIT_VOLTS), "data", Stream::STREAM_TYPE_ANALOG);
+
+	//One input per variable; only the ones the expression references need to be connected
+	for(size_t i=0; i<MAX_VARS; i++)
+		CreateInput(string(1, (char)('a' + i)));
+
+	m_exprname = "Expression";
+	m_parameters[m_exprname] = FilterParameter(FilterParameter::TYPE_STRING, Unit(Unit::UNIT_COUNTS));
+	m_parameters[m_exprname].SetStringVal("a + b");
+}
+
+ExpressionFilter::~ExpressionFilter()
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Factory methods
+
+bool ExpressionFilter::ValidateChannel(size_t i, StreamDescriptor stream)
+{
+	if(stream.m_channel == NULL)
+		return false;
+
+	if( (i < MAX_VARS) && (stream.GetType() == Stream::STREAM_TYPE_ANALOG) )
+		return true;
+
+	return false;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Accessors
+
+string ExpressionFilter::GetProtocolName()
+{
+	return "Expression";
+}
+
+Filter::DataLocation ExpressionFilter::GetInputLocation()
+{
+	//We explicitly manage our input memory and don't care where it is when Refresh() is called
+	return LOC_DONTCARE;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Expression parsing
+
+int ExpressionFilter::AddNode(const ExprNode& node)
+{
+	m_nodes.push_back(node);
+	return m_nodes.size() - 1;
+}
+
+/**
+	@brief Parses the expression into m_nodes / m_root and records the referenced variables
+
+	Grammar: the usual four operators with standard precedence, unary minus, parentheses, numeric literals,
+	single-letter variables a-h, and the functions in g_exprFuncNames.
+ */
+bool ExpressionFilter::ParseExpression(const string& expr)
+{
+	m_nodes.clear();
+	m_usedVars.clear();
+
+	const char* p = expr.c_str();
+	m_root = ParseSum(p);
+	if(m_root < 0)
+		return false;
+
+	//Trailing junk after a valid expression is an error too
+	while(isspace(*p))
+		p ++;
+	if(*p != '\0')
+	{
+		LogWarning("Expression parse error at \"%s\"\n", p);
+		return false;
+	}
+
+	//Collect the set of variables actually referenced, ascending
+	set<size_t> used;
+	for(auto& node : m_nodes)
+	{
+		if(node.m_type == ExprNode::TYPE_VAR)
+			used.emplace(node.m_var);
+	}
+	m_usedVars.assign(used.begin(), used.end());
+
+	if(m_usedVars.empty())
+	{
+		LogWarning("Expression \"%s\" references no inputs\n", expr.c_str());
+		return false;
+	}
+
+	return true;
+}
+
+int ExpressionFilter::ParseSum(const char*& p)
+{
+	int lhs = ParseProduct(p);
+	while(lhs >= 0)
+	{
+		while(isspace(*p))
+			p ++;
+		if( (*p != '+') && (*p != '-') )
+			break;
+
+		char op = *p;
+		p ++;
+		int rhs = ParseProduct(p);
+		if(rhs < 0)
+			return -1;
+
+		ExprNode node;
+		node.m_type = ExprNode::TYPE_OP;
+		node.m_op = op;
+		node.m_lhs = lhs;
+		node.m_rhs = rhs;
+		lhs = AddNode(node);
+	}
+	return lhs;
+}
+
+int ExpressionFilter::ParseProduct(const char*& p)
+{
+	int lhs = ParseUnary(p);
+	while(lhs >= 0)
+	{
+		while(isspace(*p))
+			p ++;
+		if( (*p != '*') && (*p != '/') )
+			break;
+
+		char op = *p;
+		p ++;
+		int rhs = ParseUnary(p);
+		if(rhs < 0)
+			return -1;
+
+		ExprNode node;
+		node.m_type = ExprNode::TYPE_OP;
+		node.m_op = op;
+		node.m_lhs = lhs;
+		node.m_rhs = rhs;
+		lhs = AddNode(node);
+	}
+	return lhs;
+}
+
+int ExpressionFilter::ParseUnary(const char*& p)
+{
+	while(isspace(*p))
+		p ++;
+
+	//Unary minus is expressed as (0 - x) so codegen and evaluation need no extra node type
+	if(*p == '-')
+	{
+		p ++;
+		int rhs = ParseUnary(p);
+		if(rhs < 0)
+			return -1;
+
+		ExprNode zero;
+		zero.m_type = ExprNode::TYPE_CONST;
+		zero.m_value = 0;
+		zero.m_lhs = -1;
+		zero.m_rhs = -1;
+		int lhs = AddNode(zero);
+
+		ExprNode node;
+		node.m_type = ExprNode::TYPE_OP;
+		node.m_op = '-';
+		node.m_lhs = lhs;
+		node.m_rhs = rhs;
+		return AddNode(node);
+	}
+
+	return ParsePrimary(p);
+}
+
+int ExpressionFilter::ParsePrimary(const char*& p)
+{
+	while(isspace(*p))
+		p ++;
+
+	//Parenthesized subexpression
+	if(*p == '(')
+	{
+		p ++;
+		int inner = ParseSum(p);
+		if(inner < 0)
+			return -1;
+		while(isspace(*p))
+			p ++;
+		if(*p != ')')
+		{
+			LogWarning("Expression parse error: expected ) at \"%s\"\n", p);
+			return -1;
+		}
+		p ++;
+		return inner;
+	}
+
+	//Numeric literal
+	if(isdigit(*p) || (*p == '.') )
+	{
+		char* end;
+		float value = strtof(p, &end);
+		p = end;
+
+		ExprNode node;
+		node.m_type = ExprNode::TYPE_CONST;
+		node.m_value = value;
+		node.m_lhs = -1;
+		node.m_rhs = -1;
+		return AddNode(node);
+	}
+
+	//Identifier: function call or variable
+	if(isalpha(*p))
+	{
+		const char* start = p;
+		while(isalpha(*p))
+			p ++;
+		string name(start, p - start);
+
+		while(isspace(*p))
+			p ++;
+
+		//Function call
+		if(*p == '(')
+		{
+			int func = -1;
+			for(size_t i=0; i<sizeof(g_exprFuncNames)/sizeof(g_exprFuncNames[0]); i++)
+			{
+				if(name == g_exprFuncNames[i])
+				{
+					func = i;
+					break;
+				}
+			}
+			if(func < 0)
+			{
+				LogWarning("Expression parse error: unknown function \"%s\"\n", name.c_str());
+				return -1;
+			}
+
+			p ++;
+			int lhs = ParseSum(p);
+			if(lhs < 0)
+				return -1;
+
+			int rhs = -1;
+			if(g_exprFuncArgs[func] == 2)
+			{
+				while(isspace(*p))
+					p ++;
+				if(*p != ',')
+				{
+					LogWarning("Expression parse error: %s() takes two arguments\n", name.c_str());
+					return -1;
+				}
+				p ++;
+				rhs = ParseSum(p);
+				if(rhs < 0)
+					return -1;
+			}
+
+			while(isspace(*p))
+				p ++;
+			if(*p != ')')
+			{
+				LogWarning("Expression parse error: expected ) at \"%s\"\n", p);
+				return -1;
+			}
+			p ++;
+
+			ExprNode node;
+			node.m_type = ExprNode::TYPE_FUNC;
+			node.m_func = func;
+			node.m_lhs = lhs;
+			node.m_rhs = rhs;
+			return AddNode(node);
+		}
+
+		//Variable
+		if( (name.length() == 1) && (name[0] >= 'a') && (name[0] < (char)('a' + MAX_VARS)) )
+		{
+			ExprNode node;
+			node.m_type = ExprNode::TYPE_VAR;
+			node.m_var = name[0] - 'a';
+			node.m_lhs = -1;
+			node.m_rhs = -1;
+			return AddNode(node);
+		}
+
+		LogWarning("Expression parse error: unknown identifier \"%s\"\n", name.c_str());
+		return -1;
+	}
+
+	LogWarning("Expression parse error at \"%s\"\n", p);
+	return -1;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Code generation
+
+///@brief Emits the GLSL expression for one tree node (fully parenthesized, so precedence needs no thought)
+string ExpressionFilter::EmitGlsl(int inode)
+{
+	auto& node = m_nodes[inode];
+	switch(node.m_type)
+	{
+		case ExprNode::TYPE_CONST:
+			{
+				char tmp[32];
+				snprintf(tmp, sizeof(tmp), "(%.9g)", node.m_value);
+				return tmp;
+			}
+
+		case ExprNode::TYPE_VAR:
+			return string(1, (char)('a' + node.m_var)) + "[i]";
+
+		case ExprNode::TYPE_OP:
+			return string("(") + EmitGlsl(node.m_lhs) + " " + node.m_op + " " + EmitGlsl(node.m_rhs) + ")";
+
+		case ExprNode::TYPE_FUNC:
+		default:
+			{
+				string ret = string(g_exprFuncNames[node.m_func]) + "(" + EmitGlsl(node.m_lhs);
+				if(node.m_rhs >= 0)
+					ret += string(", ") + EmitGlsl(node.m_rhs);
+				return ret + ")";
+			}
+	}
+}
+
+/**
+	@brief Re-parses the expression and rebuilds the generated shader if the parameter changed
+
+	@return True if the expression is usable (parsed, though the GPU pipeline may still be unavailable)
+ */
+bool ExpressionFilter::RecompileIfNeeded()
+{
+	auto expr = m_parameters[m_exprname].ToString();
+	if(expr == m_cachedExpression)
+		return m_parseOk;
+	m_cachedExpression = expr;
+
+	m_pipelineOk = false;
+	m_parseOk = ParseExpression(expr);
+	if(!m_parseOk)
+		return false;
+
+	//Generate the shader: one readonly SSBO per referenced variable, then the output
+	string glsl =
+		"#version 450\n"
+		"layout(local_size_x=64, local_size_y=1, local_size_z=1) in;\n";
+	for(size_t i=0; i<m_usedVars.size(); i++)
+	{
+		char var = (char)('a' + m_usedVars[i]);
+		char tmp[128];
+		snprintf(tmp, sizeof(tmp),
+			"layout(std430, binding=%zu) restrict readonly buffer buf_%c { float %c[]; };\n", i, var, var);
+		glsl += tmp;
+	}
+	{
+		char tmp[128];
+		snprintf(tmp, sizeof(tmp),
+			"layout(std430, binding=%zu) restrict writeonly buffer buf_dout { float dout[]; };\n",
+			m_usedVars.size());
+		glsl += tmp;
+	}
+	glsl +=
+		"layout(push_constant) uniform constants { uint size; };\n"
+		"void main()\n"
+		"{\n"
+		"	uint i = gl_GlobalInvocationID.x;\n"
+		"	if(i >= size)\n"
+		"		return;\n"
+		"	dout[i] = " + EmitGlsl(m_root) + ";\n"
+		"}\n";
+
+	vector<uint32_t> spirv;
+	if(!ComputePipeline::CompileGlsl(glsl, spirv))
+	{
+		LogWarning("Failed to compile expression \"%s\", falling back to CPU evaluation\n", expr.c_str());
+		return true;
+	}
+
+	char name[64];
+	snprintf(name, sizeof(name), "ExpressionFilter_%016zx", (size_t)hash<string>{}(glsl));
+	m_computePipeline.ReinitializeFromSpirv(
+		name, std::move(spirv), m_usedVars.size() + 1, sizeof(ExpressionShaderArgs));
+	m_pipelineOk = true;
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Actual decoder logic
+
+///@brief Interprets the expression tree for one sample (CPU fallback path)
+float ExpressionFilter::Evaluate(int inode, float* const* inputs, size_t i)
+{
+	auto& node = m_nodes[inode];
+	switch(node.m_type)
+	{
+		case ExprNode::TYPE_CONST:
+			return node.m_value;
+
+		case ExprNode::TYPE_VAR:
+			return inputs[node.m_var][i];
+
+		case ExprNode::TYPE_OP:
+			{
+				float lhs = Evaluate(node.m_lhs, inputs, i);
+				float rhs = Evaluate(node.m_rhs, inputs, i);
+				switch(node.m_op)
+				{
+					case '+':
+						return lhs + rhs;
+					case '-':
+						return lhs - rhs;
+					case '*':
+						return lhs * rhs;
+					case '/':
+					default:
+						return lhs / rhs;
+				}
+			}
+
+		case ExprNode::TYPE_FUNC:
+		default:
+			{
+				float lhs = Evaluate(node.m_lhs, inputs, i);
+				switch(node.m_func)
+				{
+					case FUNC_ABS:
+						return fabs(lhs);
+					case FUNC_SQRT:
+						return sqrt(lhs);
+					case FUNC_EXP:
+						return exp(lhs);
+					case FUNC_LOG:
+						return log(lhs);
+					case FUNC_SIN:
+						return sin(lhs);
+					case FUNC_COS:
+						return cos(lhs);
+					case FUNC_TAN:
+						return tan(lhs);
+					case FUNC_FLOOR:
+						return floor(lhs);
+					case FUNC_CEIL:
+						return ceil(lhs);
+					case FUNC_MIN:
+						return min(lhs, Evaluate(node.m_rhs, inputs, i));
+					case FUNC_MAX:
+						return max(lhs, Evaluate(node.m_rhs, inputs, i));
+					case FUNC_POW:
+					default:
+						return pow(lhs, Evaluate(node.m_rhs, inputs, i));
+				}
+			}
+	}
+}
+
+void ExpressionFilter::Refresh(vk::raii::CommandBuffer& cmdBuf, shared_ptr<QueueHandle> queue)
+{
+	if(!RecompileIfNeeded())
+	{
+		SetData(NULL, 0);
+		return;
+	}
+
+	//Gather inputs for each referenced variable (uniform analog only)
+	vector<UniformAnalogWaveform*> wfms;
+	size_t len = SIZE_MAX;
+	for(auto v : m_usedVars)
+	{
+		auto wfm = dynamic_cast<UniformAnalogWaveform*>(GetInputWaveform(v));
+		if(wfm == nullptr)
+		{
+			SetData(NULL, 0);
+			return;
+		}
+		wfms.push_back(wfm);
+		len = min(len, wfm->size());
+	}
+	if(len == 0)
+	{
+		SetData(NULL, 0);
+		return;
+	}
+
+	auto cap = SetupEmptyUniformAnalogOutputWaveform(wfms[0], 0);
+	cap->Resize(len);
+
+	ExpressionShaderArgs args;
+	args.size = len;
+
+	//GPU path: the whole expression is one dispatch of the generated kernel
+	if(m_pipelineOk && g_gpuFilterEnabled && g_hasPushDescriptor)
+	{
+		cmdBuf.begin({});
+		for(size_t i=0; i<wfms.size(); i++)
+			m_computePipeline.BindBufferNonblocking(i, wfms[i]->m_samples, cmdBuf);
+		m_computePipeline.BindBufferNonblocking(wfms.size(), cap->m_samples, cmdBuf, true);
+		m_computePipeline.Dispatch(cmdBuf, args, GetComputeBlockCount(len, 64));
+		cmdBuf.end();
+		SubmitOrDefer(cmdBuf, queue);
+
+		cap->m_samples.MarkModifiedFromGpu();
+		return;
+	}
+
+	//CPU path: interpret the tree per sample
+	float* inputs[MAX_VARS] = {nullptr};
+	for(size_t i=0; i<m_usedVars.size(); i++)
+	{
+		wfms[i]->PrepareForCpuAccess();
+		inputs[m_usedVars[i]] = wfms[i]->m_samples.GetCpuPointer();
+	}
+	cap->PrepareForCpuAccess();
+
+	float* out = cap->m_samples.GetCpuPointer();
+	for(size_t i=0; i<len; i++)
+		out[i] = Evaluate(m_root, inputs, i);
+
+	cap->MarkModifiedFromCpu();
+}
@@ -0,0 +1,153 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopeprotocols                                                                                                    *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Declaration of ExpressionFilter
+ */
+#ifndef ExpressionFilter_h
+#define ExpressionFilter_h
+
+class QueueHandle;
+
+/**
+	@brief Evaluates an arbitrary per-sample math expression in a single compute dispatch
+
+	Replaces chains of Add/Subtract/Multiply/Divide nodes (which pay full graph-node overhead and one dispatch per
+	operator) with one filter: the expression is parsed once when the parameter changes, specialized into a GLSL
+	compute shader, compiled to SPIR-V through glslang, and run through the normal ComputePipeline path. Inputs are
+	the variables a through h; the usual operators, parentheses, numeric literals, and a small set of math functions
+	(abs, sqrt, exp, log, sin, cos, tan, floor, ceil, min, max, pow) are supported.
+
+	Falls back to interpreting the expression tree on the CPU when GPU filtering is unavailable.
+ */
+class ExpressionFilter : public Filter
+{
+public:
+	ExpressionFilter(const std::string& color);
+	virtual ~ExpressionFilter();
+
+	virtual void Refresh(vk::raii::CommandBuffer& cmdBuf, std::shared_ptr<QueueHandle> queue) override;
+	virtual DataLocation GetInputLocation() override;
+
+	static std::string GetProtocolName();
+
+	virtual bool ValidateChannel(size_t i, StreamDescriptor stream) override;
+
+	PROTOCOL_DECODER_INITPROC(ExpressionFilter)
+
+	///@brief Number of input variables (a through h)
+	static const size_t MAX_VARS = 8;
+
+protected:
+
+	///@brief Functions callable from an expression
+	enum ExprFunc
+	{
+		FUNC_ABS,
+		FUNC_SQRT,
+		FUNC_EXP,
+		FUNC_LOG,
+		FUNC_SIN,
+		FUNC_COS,
+		FUNC_TAN,
+		FUNC_FLOOR,
+		FUNC_CEIL,
+		FUNC_MIN,
+		FUNC_MAX,
+		FUNC_POW
+	};
+
+	///@brief One node of the parsed expression tree (flat storage, children referenced by index)
+	struct ExprNode
+	{
+		enum Type
+		{
+			TYPE_CONST,
+			TYPE_VAR,
+			TYPE_OP,
+			TYPE_FUNC
+		} m_type;
+
+		///@brief Value (TYPE_CONST only)
+		float m_value;
+
+		///@brief Variable index, 0 = a (TYPE_VAR only)
+		size_t m_var;
+
+		///@brief One of + - * / (TYPE_OP only)
+		char m_op;
+
+		///@brief An ExprFunc value (TYPE_FUNC only)
+		int m_func;
+
+		///@brief Left / only child (-1 if absent)
+		int m_lhs;
+
+		///@brief Right child (-1 if absent)
+		int m_rhs;
+	};
+
+	bool RecompileIfNeeded();
+	bool ParseExpression(const std::string& expr);
+	int ParseSum(const char*& p);
+	int ParseProduct(const char*& p);
+	int ParseUnary(const char*& p);
+	int ParsePrimary(const char*& p);
+	int AddNode(const ExprNode& node);
+
+	std::string EmitGlsl(int inode);
+	float Evaluate(int inode, float* const* inputs, size_t i);
+
+	std::string m_exprname;
+
+	///@brief Expression text the current tree / pipeline was built from
+	std::string m_cachedExpression;
+
+	///@brief True if m_cachedExpression parsed successfully
+	bool m_parseOk;
+
+	///@brief True if the generated shader for m_cachedExpression compiled successfully
+	bool m_pipelineOk;
+
+	///@brief Parsed expression tree
+	std::vector<ExprNode> m_nodes;
+
+	///@brief Index of the root node
+	int m_root;
+
+	///@brief Variables referenced by the expression, ascending; SSBO binding k is input m_usedVars[k]
+	std::vector<size_t> m_usedVars;
+
+	///@brief Pipeline for the generated shader
+	ComputePipeline m_computePipeline;
+};
+
+#endif
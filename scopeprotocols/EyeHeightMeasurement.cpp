@@ -121,8 +121,8 @@ void EyeHeightMeasurement::Refresh()
 	//Find start/end time bins
 	size_t start_bin = round((tstart + din->m_uiWidth) / fs_per_bin);
 	size_t end_bin = round((tend + din->m_uiWidth) / fs_per_bin);
-	start_bin = min(start_bin, din->GetWidth());
-	end_bin = min(end_bin, din->GetWidth());
+	start_bin = min(start_bin, din->GetWidth()-1);
+	end_bin = min(end_bin, din->GetWidth()-1);
 
 	//Approximate center of the eye opening
 	float vrange = m_inputs[0].GetVoltageRange();
@@ -133,9 +133,8 @@ void EyeHeightMeasurement::Refresh()
 	size_t mid_bin = round( (vmid - volts_at_bottom) / volts_per_row);
 	mid_bin = min(mid_bin, din->GetHeight()-1);
 
-	float* data = din->GetData();
-	int64_t w = din->GetWidth();
-	float ber_max = FLT_EPSILON;
+	//Use the tiled accumulator layout so the column-wise searches below don't pay a cache line per row
+	din->UpdateCachedLayouts();
 	float minheight = FLT_MAX;
 	for(size_t x = start_bin; x <= end_bin; x ++)
 	{
@@ -143,14 +142,14 @@ void EyeHeightMeasurement::Refresh()
 		size_t top_bin = mid_bin;
 		for(; top_bin < height; top_bin ++)
 		{
-			if(data[top_bin*w + x] > ber_max)
+			if(din->GetAccumTiled(x, top_bin) > 0)
 				break;
 		}
 
 		size_t bot_bin = mid_bin;
 		for(; bot_bin > 0; bot_bin --)
 		{
-			if(data[bot_bin*w + x] > ber_max)
+			if(din->GetAccumTiled(x, bot_bin) > 0)
 				break;
 		}
 
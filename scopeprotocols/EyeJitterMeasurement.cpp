@@ -121,17 +121,16 @@ void EyeJitterMeasurement::Refresh()
 	float duration_mv = volts_per_row * 1000;
 	float base_mv = volts_at_bottom * 1000;
 
-	float* data = din->GetData();
+	//Read hit counts straight from the accumulator (via the tiled layout) rather than the normalized density
+	//buffer, so results don't depend on a render pass having run Normalize() first
+	din->UpdateCachedLayouts();
 	int64_t w = din->GetWidth();
 	int64_t xcenter = w / 2;
-	float ber_max = FLT_EPSILON;
 	double width_fs = 2 * din->m_uiWidth;
 	double fs_per_pixel = width_fs / w;
 	int64_t jitter_pp = 0;
 	for(size_t i=start_bin; i <= end_bin; i++)
 	{
-		float* row = data + i*w;
-
 		int64_t cleft = 0;		//left side of eye opening
 		int64_t cright = w-1;	//right side of eye opening
 		int64_t left = cright;	//left side of eye edge
@@ -142,7 +141,7 @@ void EyeJitterMeasurement::Refresh()
 		{
 			//left of center
 			int64_t x = xcenter - dx;
-			if(row[x] > ber_max)
+			if(din->GetAccumTiled(x, i) > 0)
 			{
 				cleft = max(cleft, x);
 				left = min(left, x);
@@ -150,7 +149,7 @@ void EyeJitterMeasurement::Refresh()
 
 			//right of center
 			x = xcenter + dx;
-			if(row[x] > ber_max)
+			if(din->GetAccumTiled(x, i) > 0)
 			{
 				cright = min(cright, x);
 				right = max(right, x);
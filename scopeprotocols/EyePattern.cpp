@@ -36,6 +36,26 @@
 
 using namespace std;
 
+///@brief Push constant block for the GPU rasterization path (must match EyePatternDensePacked.glsl)
+struct EyePatternDensePushConstants
+{
+	int64_t triggerPhase;
+	int64_t timescale;
+	int64_t uiWidth;
+	int64_t uiHalfWidth;
+	uint32_t sampleOffset;
+	uint32_t wend;
+	uint32_t cend;
+	uint32_t width;
+	uint32_t xmax;
+	uint32_t ymax;
+	float xscale;
+	float xoff;
+	float xtimescale;
+	float yscale;
+	float yoff;
+};
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Construction / destruction
 
@@ -55,7 +75,13 @@ EyePattern::EyePattern(const string& color)
 	, m_clockAlignName("Clock Alignment")
 	, m_rateModeName("Bit Rate Mode")
 	, m_rateName("Bit Rate")
+	, m_decayName("Persistence Half-Life")
+	, m_maskModeName("Mask Test Mode")
+	, m_computePipeline("shaders/EyePatternDensePacked.spv", 3, sizeof(EyePatternDensePushConstants))
 {
+	m_clockEdgeBuf.SetName("EyePattern.m_clockEdgeBuf");
+	m_gpuAccumBuf.SetName("EyePattern.m_gpuAccumBuf");
+
 	AddStream(Unit(Unit::UNIT_COUNTS), "data", Stream::STREAM_TYPE_EYE);
 	AddStream(Unit(Unit::UNIT_RATIO_SCI), "hitrate", Stream::STREAM_TYPE_ANALOG_SCALAR);
 	AddStream(Unit(Unit::UNIT_UI), "samplesIntegrated", Stream::STREAM_TYPE_ANALOG_SCALAR);
@@ -99,6 +125,29 @@ EyePattern::EyePattern(const string& color)
 
 	m_parameters[m_rateName] = FilterParameter(FilterParameter::TYPE_INT, Unit(Unit::UNIT_BITRATE));
 	m_parameters[m_rateName].SetIntVal(1250000000);
+
+	//Half-life of accumulated hits in UIs, or zero for infinite persistence
+	m_parameters[m_decayName] = FilterParameter(FilterParameter::TYPE_FLOAT, Unit(Unit::UNIT_UI));
+	m_parameters[m_decayName].SetFloatVal(0);
+
+	//Full: exact worst case hit rate over the entire eye
+	//Fast Fail: early-abort pass/fail test that only refines near potential violations, recording their
+	//locations on the output waveform for failure localization
+	m_parameters[m_maskModeName] = FilterParameter(FilterParameter::TYPE_ENUM, Unit(Unit::UNIT_COUNTS));
+	m_parameters[m_maskModeName].AddEnumValue("Full", MASK_TEST_FULL);
+	m_parameters[m_maskModeName].AddEnumValue("Fast Fail", MASK_TEST_FAST_FAIL);
+	m_parameters[m_maskModeName].SetIntVal(MASK_TEST_FULL);
+
+	m_cachedSaturation.Bind(m_parameters[m_saturationName]);
+	m_cachedCenter.Bind(m_parameters[m_centerName]);
+	m_cachedPolarity.Bind(m_parameters[m_polarityName]);
+	m_cachedVmode.Bind(m_parameters[m_vmodeName]);
+	m_cachedRange.Bind(m_parameters[m_rangeName]);
+	m_cachedClockAlign.Bind(m_parameters[m_clockAlignName]);
+	m_cachedRateMode.Bind(m_parameters[m_rateModeName]);
+	m_cachedRate.Bind(m_parameters[m_rateName]);
+	m_cachedDecay.Bind(m_parameters[m_decayName]);
+	m_cachedMaskMode.Bind(m_parameters[m_maskModeName]);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -127,15 +176,15 @@ string EyePattern::GetProtocolName()
 
 float EyePattern::GetVoltageRange(size_t /*stream*/)
 {
-	if(m_parameters[m_vmodeName].GetIntVal() == RANGE_AUTO)
+	if(m_cachedVmode.GetIntVal() == RANGE_AUTO)
 		return m_inputs[0].GetVoltageRange();
 	else
-		return m_parameters[m_rangeName].GetFloatVal();
+		return m_cachedRange.GetFloatVal();
 }
 
 float EyePattern::GetOffset(size_t /*stream*/)
 {
-	return -m_parameters[m_centerName].GetFloatVal();
+	return -m_cachedCenter.GetFloatVal();
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -147,6 +196,16 @@ void EyePattern::ClearSweeps()
 }
 
 void EyePattern::Refresh()
+{
+	DoRefresh(nullptr, nullptr);
+}
+
+void EyePattern::Refresh(vk::raii::CommandBuffer& cmdBuf, shared_ptr<QueueHandle> queue)
+{
+	DoRefresh(&cmdBuf, queue);
+}
+
+void EyePattern::DoRefresh(vk::raii::CommandBuffer* cmdBuf, shared_ptr<QueueHandle> queue)
 {
 	static double total_time = 0;
 	static double total_frames = 0;
@@ -172,7 +231,7 @@ void EyePattern::Refresh()
 
 	//If center of the eye was changed, reset existing eye data
 	auto cap = dynamic_cast<EyeWaveform*>(GetData(0));
-	double center = m_parameters[m_centerName].GetFloatVal();
+	double center = m_cachedCenter.GetFloatVal();
 	if(cap)
 	{
 		if(fabs(cap->GetCenterVoltage() - center) > 0.001)
@@ -183,7 +242,7 @@ void EyePattern::Refresh()
 	}
 
 	//If clock alignment was changed, reset existing eye data
-	ClockAlignment clock_align = static_cast<ClockAlignment>(m_parameters[m_clockAlignName].GetIntVal());
+	ClockAlignment clock_align = static_cast<ClockAlignment>(m_cachedClockAlign.GetIntVal());
 	if(m_lastClockAlign != clock_align)
 	{
 		SetData(NULL, 0);
@@ -192,7 +251,7 @@ void EyePattern::Refresh()
 	}
 
 	//Load the mask, if needed
-	string maskpath = m_parameters[m_maskName].GetFileName();
+	auto& maskpath = m_parameters[m_maskName].GetFileName();
 	if(maskpath != m_mask.GetFileName())
 		m_mask.Load(maskpath);
 
@@ -200,14 +259,14 @@ void EyePattern::Refresh()
 	//TODO: timestamps? do we need those?
 	if(cap == NULL)
 		cap = ReallocateWaveform();
-	cap->m_saturationLevel = m_parameters[m_saturationName].GetFloatVal();
+	cap->m_saturationLevel = m_cachedSaturation.GetFloatVal();
 	int64_t* data = cap->GetAccumData();
 
 	//Find all toggles in the clock
 	vector<int64_t> clock_edges;
 	auto sclk = dynamic_cast<SparseDigitalWaveform*>(clock);
 	auto uclk = dynamic_cast<UniformDigitalWaveform*>(clock);
-	switch(m_parameters[m_polarityName].GetIntVal())
+	switch(m_cachedPolarity.GetIntVal())
 	{
 		case CLOCK_RISING:
 			FindRisingEdges(sclk, uclk, clock_edges);
@@ -249,6 +308,12 @@ void EyePattern::Refresh()
 	float yoff = -center*yscale + ymid;
 	float xtimescale = waveform->m_timescale * m_xscale;
 
+	//Decaying persistence: fade the existing accumulator before integrating this pass, so the eye
+	//tracks recent link behavior instead of integrating forever. Zero half-life means never decay.
+	float halfLife = m_cachedDecay.GetFloatVal();
+	if(halfLife > FLT_EPSILON)
+		cap->ApplyDecay(pow(0.5f, clock_edges.size() / halfLife));
+
 	//Process the eye
 	size_t cend = clock_edges.size() - 1;
 	size_t wend = waveform->size()-1;
@@ -262,12 +327,18 @@ void EyePattern::Refresh()
 		//We can assume m_offsets[i] = i and m_durations[i] = 0 for all input
 		if(uwfm)
 		{
-			#ifdef __x86_64__
-			if(g_hasAvx2)
-				DensePackedInnerLoopAVX2(uwfm, clock_edges, data, wend, cend, xmax, ymax, xtimescale, yscale, yoff);
+			//Rasterize on the GPU if we can, falling back to the CPU loops otherwise
+			if(cmdBuf && g_gpuFilterEnabled && g_hasShaderInt64)
+				DensePackedInnerLoopGpu(uwfm, clock_edges, data, wend, cend, xmax, ymax, xtimescale, yscale, yoff, *cmdBuf, queue);
 			else
-			#endif
-				DensePackedInnerLoop(uwfm, clock_edges, data, wend, cend, xmax, ymax, xtimescale, yscale, yoff);
+			{
+				#ifdef __x86_64__
+				if(g_hasAvx2)
+					DensePackedInnerLoopAVX2(uwfm, clock_edges, data, wend, cend, xmax, ymax, xtimescale, yscale, yoff);
+				else
+				#endif
+					DensePackedInnerLoop(uwfm, clock_edges, data, wend, cend, xmax, ymax, xtimescale, yscale, yoff);
+			}
 		}
 
 		//Normal main loop
@@ -560,6 +631,86 @@ void EyePattern::DensePackedInnerLoop(
 	}
 }
 
+/**
+	@brief GPU rasterization path: bins samples into the eye with atomics on the GPU
+
+	Accumulates into a 32-bit per-pass buffer (a single pass can't overflow it), then adds that into the
+	64-bit eye bins after readback so saturation behavior matches the CPU paths.
+ */
+void EyePattern::DensePackedInnerLoopGpu(
+	UniformAnalogWaveform* waveform,
+	vector<int64_t>& clock_edges,
+	int64_t* data,
+	size_t wend,
+	size_t cend,
+	int32_t xmax,
+	int32_t ymax,
+	float xtimescale,
+	float yscale,
+	float yoff,
+	vk::raii::CommandBuffer& cmdBuf,
+	shared_ptr<QueueHandle> queue
+	)
+{
+	auto cap = dynamic_cast<EyeWaveform*>(GetData(0));
+
+	//Upload the clock edges
+	m_clockEdgeBuf.resize(clock_edges.size());
+	m_clockEdgeBuf.PrepareForCpuAccess();
+	memcpy(m_clockEdgeBuf.GetCpuPointer(), clock_edges.data(), clock_edges.size() * sizeof(int64_t));
+	m_clockEdgeBuf.MarkModifiedFromCpu();
+
+	//Zero the per-pass accumulator
+	size_t npix = m_width * m_height;
+	m_gpuAccumBuf.resize(npix);
+	m_gpuAccumBuf.PrepareForCpuAccess();
+	memset(m_gpuAccumBuf.GetCpuPointer(), 0, npix * sizeof(uint32_t));
+	m_gpuAccumBuf.MarkModifiedFromCpu();
+
+	EyePatternDensePushConstants push;
+	push.triggerPhase = waveform->m_triggerPhase;
+	push.timescale = waveform->m_timescale;
+	push.uiWidth = cap->GetUIWidth();
+	push.uiHalfWidth = push.uiWidth / 2;
+	push.sampleOffset = 0;
+	push.wend = wend;
+	push.cend = cend;
+	push.width = m_width;
+	push.xmax = xmax;
+	push.ymax = ymax;
+	push.xscale = m_xscale;
+	push.xoff = m_xoff;
+	push.xtimescale = xtimescale;
+	push.yscale = yscale;
+	push.yoff = yoff;
+
+	cmdBuf.begin({});
+
+	m_computePipeline.BindBufferNonblocking(0, waveform->m_samples, cmdBuf);
+	m_computePipeline.BindBufferNonblocking(1, m_clockEdgeBuf, cmdBuf);
+	m_computePipeline.BindBufferNonblocking(2, m_gpuAccumBuf, cmdBuf);
+
+	//Dispatch in chunks so huge captures don't exceed the per-dimension workgroup count limit
+	const size_t samplesPerChunk = 32768 * 64;
+	m_computePipeline.Dispatch(cmdBuf, push, GetComputeBlockCount(min(wend, samplesPerChunk), 64));
+	for(size_t off = samplesPerChunk; off < wend; off += samplesPerChunk)
+	{
+		push.sampleOffset = off;
+		m_computePipeline.DispatchNoRebind(
+			cmdBuf, push, GetComputeBlockCount(min(wend - off, samplesPerChunk), 64));
+	}
+
+	cmdBuf.end();
+	queue->SubmitAndBlock(cmdBuf);
+	m_gpuAccumBuf.MarkModifiedFromGpu();
+
+	//Fold this pass's hits into the persistent 64-bit accumulator
+	m_gpuAccumBuf.PrepareForCpuAccess();
+	uint32_t* hits = m_gpuAccumBuf.GetCpuPointer();
+	for(size_t i=0; i<npix; i++)
+		data[i] += hits[i];
+}
+
 void EyePattern::SparsePackedInnerLoop(
 	SparseAnalogWaveform* waveform,
 	vector<int64_t>& clock_edges,
@@ -637,7 +788,7 @@ void EyePattern::SparsePackedInnerLoop(
 
 EyeWaveform* EyePattern::ReallocateWaveform()
 {
-	auto cap = new EyeWaveform(m_width, m_height, m_parameters[m_centerName].GetFloatVal(), EyeWaveform::EYE_NORMAL);
+	auto cap = new EyeWaveform(m_width, m_height, m_cachedCenter.GetFloatVal(), EyeWaveform::EYE_NORMAL);
 	cap->m_timescale = 1;
 	SetData(cap, 0);
 	return cap;
@@ -650,9 +801,9 @@ void EyePattern::RecalculateUIWidth()
 		cap = ReallocateWaveform();
 
 	//If manual override, don't look at anything else
-	if(m_parameters[m_rateModeName].GetIntVal() == MODE_FIXED)
+	if(m_cachedRateMode.GetIntVal() == MODE_FIXED)
 	{
-		cap->m_uiWidth = FS_PER_SECOND * 1.0 / m_parameters[m_rateName].GetIntVal();
+		cap->m_uiWidth = FS_PER_SECOND * 1.0 / m_cachedRate.GetIntVal();
 		return;
 	}
 
@@ -664,7 +815,7 @@ void EyePattern::RecalculateUIWidth()
 	vector<int64_t> clock_edges;
 	auto sclk = dynamic_cast<SparseDigitalWaveform*>(clock);
 	auto uclk = dynamic_cast<UniformDigitalWaveform*>(clock);
-	switch(m_parameters[m_polarityName].GetIntVal())
+	switch(m_cachedPolarity.GetIntVal())
 	{
 		case CLOCK_RISING:
 			FindRisingEdges(sclk, uclk, clock_edges);
@@ -711,13 +862,50 @@ void EyePattern::RecalculateUIWidth()
  */
 void EyePattern::DoMaskTest(EyeWaveform* cap)
 {
-	auto rate = m_mask.CalculateHitRate(
-		cap,
-		m_width,
-		m_height,
-		GetVoltageRange(0),
-		m_xscale,
-		m_xoff);
+	float rate;
+	if(m_cachedMaskMode.GetIntVal() == MASK_TEST_FAST_FAIL)
+	{
+		//Early-abort pass/fail test: only refine near potential violations, and record where they are
+		vector<EyeMaskHit> hits;
+		rate = m_mask.CheckHitRateFastFail(
+			cap,
+			m_width,
+			m_height,
+			GetVoltageRange(0),
+			m_xscale,
+			m_xoff,
+			m_mask.GetAllowedHitRate(),
+			&hits);
+
+		//Convert violating bins to eye coordinates and index them by time on the output waveform,
+		//so failure localization doesn't have to rescan the source waveform
+		vector<EyeWaveform::MaskViolation> violations;
+		float yscale = GetVoltageRange(0) / m_height;
+		for(auto& hit : hits)
+		{
+			EyeWaveform::MaskViolation v;
+			v.m_time = static_cast<int64_t>( (hit.m_x / m_xscale) + m_xoff );
+			v.m_voltage = ( (m_height * 0.5f) - hit.m_y ) * yscale;
+			v.m_rate = hit.m_rate;
+			violations.push_back(v);
+		}
+		sort(violations.begin(), violations.end(),
+			[](const EyeWaveform::MaskViolation& a, const EyeWaveform::MaskViolation& b)
+			{ return a.m_time < b.m_time; });
+		cap->SetMaskViolations(violations);
+	}
+	else
+	{
+		rate = m_mask.CalculateHitRate(
+			cap,
+			m_width,
+			m_height,
+			GetVoltageRange(0),
+			m_xscale,
+			m_xoff);
+
+		cap->SetMaskViolations(vector<EyeWaveform::MaskViolation>());
+	}
 
 	m_streams[1].m_value = rate;
 	cap->SetMaskHitRate(rate);
@@ -45,6 +45,7 @@ public:
 	EyePattern(const std::string& color);
 
 	virtual void Refresh() override;
+	virtual void Refresh(vk::raii::CommandBuffer& cmdBuf, std::shared_ptr<QueueHandle> queue) override;
 
 	static std::string GetProtocolName();
 
@@ -116,11 +117,34 @@ public:
 		MODE_FIXED
 	};
 
+	enum MaskTestMode
+	{
+		MASK_TEST_FULL,			//exact worst case hit rate over the entire eye
+		MASK_TEST_FAST_FAIL		//early-abort pass/fail test with violation localization
+	};
+
 	PROTOCOL_DECODER_INITPROC(EyePattern)
 
 protected:
+	void DoRefresh(vk::raii::CommandBuffer* cmdBuf, std::shared_ptr<QueueHandle> queue);
+
 	void DoMaskTest(EyeWaveform* cap);
 
+	void DensePackedInnerLoopGpu(
+		UniformAnalogWaveform* waveform,
+		std::vector<int64_t>& clock_edges,
+		int64_t* data,
+		size_t wend,
+		size_t cend,
+		int32_t xmax,
+		int32_t ymax,
+		float xtimescale,
+		float yscale,
+		float yoff,
+		vk::raii::CommandBuffer& cmdBuf,
+		std::shared_ptr<QueueHandle> queue
+		);
+
 	void SparsePackedInnerLoop(
 		SparseAnalogWaveform* waveform,
 		std::vector<int64_t>& clock_edges,
@@ -178,8 +202,31 @@ protected:
 	std::string m_clockAlignName;
 	std::string m_rateModeName;
 	std::string m_rateName;
+	std::string m_decayName;
+	std::string m_maskModeName;
+
+	//Pre-resolved parameter values, so the per-trigger path never does string-keyed parameter lookups
+	CachedParameter m_cachedSaturation;
+	CachedParameter m_cachedCenter;
+	CachedParameter m_cachedPolarity;
+	CachedParameter m_cachedVmode;
+	CachedParameter m_cachedRange;
+	CachedParameter m_cachedClockAlign;
+	CachedParameter m_cachedRateMode;
+	CachedParameter m_cachedRate;
+	CachedParameter m_cachedDecay;
+	CachedParameter m_cachedMaskMode;
 
 	EyeMask m_mask;
+
+	///@brief Compute pipeline for the GPU rasterization path (dense packed waveforms only)
+	ComputePipeline m_computePipeline;
+
+	///@brief GPU-side copy of the clock edge list
+	AcceleratorBuffer<int64_t> m_clockEdgeBuf;
+
+	///@brief Per-pass 32-bit hit accumulator, added into the 64-bit eye bins after readback
+	AcceleratorBuffer<uint32_t> m_gpuAccumBuf;
 };
 
 #endif
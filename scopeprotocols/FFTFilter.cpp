@@ -55,6 +55,7 @@ FFTFilter::FFTFilter(const string& color)
 	m_cachedNumPoints = 0;
 	m_cachedNumPointsFFT = 0;
 	m_cachedNumOuts = 0;
+	m_cachedBatchSize = 0;
 
 	//Default config
 	m_range = 70;
@@ -128,6 +129,88 @@ Filter::DataLocation FFTFilter::GetInputLocation()
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Actual decoder logic
 
+///@brief Rounds the raw input length to the FFT length per the length rounding parameter
+size_t FFTFilter::GetRoundedNumPoints(size_t npoints_raw)
+{
+	if(m_parameters[m_roundingName].GetIntVal() == ROUND_TRUNCATE)
+		return prev_pow2(npoints_raw);
+	else
+		return next_pow2(npoints_raw);
+}
+
+///@brief Returns the window function pipeline for the given window
+ComputePipeline& FFTFilter::GetWindowPipeline(WindowFunction window)
+{
+	switch(window)
+	{
+		case WINDOW_BLACKMAN_HARRIS:
+			return m_blackmanHarrisComputePipeline;
+
+		case WINDOW_HANN:
+		case WINDOW_HAMMING:
+			return m_cosineSumComputePipeline;
+
+		default:
+		case WINDOW_RECTANGULAR:
+			return m_rectangularComputePipeline;
+	}
+}
+
+/**
+	@brief Calculates the output scale factor for the given window function
+
+	The scale is based on the number of points we FFT that contain actual sample data (if we're zero padding,
+	the zeroes don't contribute any power), adjusted by the coherent power gain of the window function.
+ */
+float FFTFilter::GetWindowScale(WindowFunction window, size_t numActualSamples)
+{
+	float scale = sqrt(2.0) / numActualSamples;
+
+	switch(window)
+	{
+		case WINDOW_HAMMING:
+			scale *= 1.862;
+			break;
+
+		case WINDOW_HANN:
+			scale *= 2.013;
+			break;
+
+		case WINDOW_BLACKMAN_HARRIS:
+			scale *= 2.805;
+			break;
+
+		//unit
+		case WINDOW_RECTANGULAR:
+		default:
+			break;
+	}
+
+	return scale;
+}
+
+///@brief Fills out the window-shape fields of the push constants (caller sets npoints and the buffer offsets)
+void FFTFilter::ConfigureWindowArgs(WindowFunctionArgs& args, WindowFunction window, size_t numActualSamples)
+{
+	args.numActualSamples = numActualSamples;
+	args.scale = 2 * M_PI / numActualSamples;
+	switch(window)
+	{
+		case WINDOW_HANN:
+			args.alpha0 = 0.5;
+			break;
+
+		case WINDOW_HAMMING:
+			args.alpha0 = 25.0f / 46;
+			break;
+
+		default:
+			args.alpha0 = 0;
+			break;
+	}
+	args.alpha1 = 1 - args.alpha0;
+}
+
 void FFTFilter::ReallocateBuffers(size_t npoints_raw, size_t npoints, size_t nouts)
 {
 	m_cachedNumPoints = npoints_raw;
@@ -147,7 +230,7 @@ void FFTFilter::ReallocateBuffers(size_t npoints_raw, size_t npoints, size_t nou
 			m_vkPlan = nullptr;
 	}
 	if(!m_vkPlan)
-		m_vkPlan = make_unique<VulkanFFTPlan>(npoints, nouts, VulkanFFTPlan::DIRECTION_FORWARD);
+		m_vkPlan = g_vkFFTPlanCache.Acquire(npoints, nouts, VulkanFFTPlan::DIRECTION_FORWARD);
 
 	m_rdinbuf.resize(npoints);
 	m_rdoutbuf.resize(2*nouts);
@@ -164,11 +247,7 @@ void FFTFilter::Refresh(vk::raii::CommandBuffer& cmdBuf, shared_ptr<QueueHandle>
 	auto din = dynamic_cast<UniformAnalogWaveform*>(GetInputWaveform(0));
 
 	const size_t npoints_raw = din->size();
-	size_t npoints;
-	if(m_parameters[m_roundingName].GetIntVal() == ROUND_TRUNCATE)
-		npoints = prev_pow2(npoints_raw);
-	else
-		npoints = next_pow2(npoints_raw);
+	size_t npoints = GetRoundedNumPoints(npoints_raw);
 	LogTrace("FFTFilter: processing %zu raw points\n", npoints_raw);
 	LogTrace("Rounded to %zu\n", npoints);
 
@@ -204,80 +283,25 @@ void FFTFilter::DoRefresh(
 	cap->m_timescale = bin_hz;
 	cap->Resize(nouts);
 
-	//Output scale is based on the number of points we FFT that contain actual sample data.
-	//(If we're zero padding, the zeroes don't contribute any power)
 	size_t numActualSamples = min(data.size(), npoints);
-	float scale = sqrt(2.0) / numActualSamples;
-
-	//We also need to adjust the scale by the coherent power gain of the window function
-	switch(window)
-	{
-		case WINDOW_HAMMING:
-			scale *= 1.862;
-			break;
-
-		case WINDOW_HANN:
-			scale *= 2.013;
-			break;
-
-		case WINDOW_BLACKMAN_HARRIS:
-			scale *= 2.805;
-			break;
-
-		//unit
-		case WINDOW_RECTANGULAR:
-		default:
-			break;
-	}
+	float scale = GetWindowScale(window, numActualSamples);
 
 	//Configure the window
 	WindowFunctionArgs args;
-	args.numActualSamples = numActualSamples;
+	ConfigureWindowArgs(args, window, numActualSamples);
 	args.npoints = npoints;
-	args.scale = 2 * M_PI / numActualSamples;
 	args.offsetIn = 0;
 	args.offsetOut = 0;
-	switch(window)
-	{
-		case WINDOW_HANN:
-			args.alpha0 = 0.5;
-			break;
-
-		case WINDOW_HAMMING:
-			args.alpha0 = 25.0f / 46;
-			break;
-
-		default:
-			args.alpha0 = 0;
-			break;
-	}
-	args.alpha1 = 1 - args.alpha0;
 
 	//Prepare to do all of our compute stuff in one dispatch call to reduce overhead
 	cmdBuf.begin({});
 
 	//Apply the window function
-	ComputePipeline* wpipe = nullptr;
-	switch(window)
-	{
-		case WINDOW_BLACKMAN_HARRIS:
-			wpipe = &m_blackmanHarrisComputePipeline;
-			break;
-
-		case WINDOW_HANN:
-		case WINDOW_HAMMING:
-			wpipe = &m_cosineSumComputePipeline;
-			break;
-
-		default:
-		case WINDOW_RECTANGULAR:
-			wpipe = &m_rectangularComputePipeline;
-			break;
-	}
-	wpipe->BindBufferNonblocking(0, data, cmdBuf);
-	wpipe->BindBufferNonblocking(1, m_rdinbuf, cmdBuf, true);
-	wpipe->Dispatch(cmdBuf, args, GetComputeBlockCount(npoints, 64));
-	wpipe->AddComputeMemoryBarrier(cmdBuf);
+	auto& wpipe = GetWindowPipeline(window);
+	wpipe.BindBufferNonblocking(0, data, cmdBuf);
+	wpipe.BindBufferNonblocking(1, m_rdinbuf, cmdBuf, true);
+	wpipe.Dispatch(cmdBuf, args, GetComputeBlockCount(npoints, 64));
+	wpipe.AddComputeMemoryBarrier(cmdBuf);
 	m_rdinbuf.MarkModifiedFromGpu();
 
 	//Do the actual FFT operation
@@ -288,6 +312,7 @@ void FFTFilter::DoRefresh(
 		m_complexToLogMagnitudeComputePipeline : m_complexToMagnitudeComputePipeline;
 	ComplexToMagnitudeArgs cargs;
 	cargs.npoints = nouts;
+	cargs.offsetIn = 0;
 	if(log_output)
 	{
 		const float impedance = 50;
@@ -306,6 +331,138 @@ void FFTFilter::DoRefresh(
 
 	cap->MarkModifiedFromGpu();
 
-	//Peak search (for now this runs on the CPU)
-	FindPeaks(cap);
+	//Peak search (on the GPU if filter acceleration is enabled, so the spectrum can stay device resident)
+	FindPeaks(cap, cmdBuf, queue);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Batched execution
+
+string FFTFilter::GetBatchKey()
+{
+	//All transforms in a batched VkFFT execution share a single plan, so only same-length FFTs can be packed
+	//into one group. Window function and scaling are per-channel and don't need to match.
+	if(!VerifyAllInputsOKAndUniformAnalog())
+		return "";
+
+	char tmp[32];
+	snprintf(tmp, sizeof(tmp), "FFT:%zu", GetRoundedNumPoints(GetInputWaveform(0)->size()));
+	return tmp;
+}
+
+bool FFTFilter::RefreshBatch(
+	const vector<Filter*>& filters,
+	vk::raii::CommandBuffer& cmdBuf,
+	shared_ptr<QueueHandle> queue)
+{
+	//Validate the group: everything must still be an FFT of the same length with a valid uniform analog input
+	vector<FFTFilter*> ffts;
+	vector<UniformAnalogWaveform*> dins;
+	size_t npoints = 0;
+	for(auto f : filters)
+	{
+		auto ff = dynamic_cast<FFTFilter*>(f);
+		if(!ff || !ff->VerifyAllInputsOKAndUniformAnalog())
+			return false;
+		auto din = dynamic_cast<UniformAnalogWaveform*>(ff->GetInputWaveform(0));
+		size_t n = ff->GetRoundedNumPoints(din->size());
+		if(ffts.empty())
+			npoints = n;
+		else if(n != npoints)
+			return false;
+		ffts.push_back(ff);
+		dins.push_back(din);
+	}
+	const size_t nouts = npoints/2 + 1;
+	const size_t nbatch = ffts.size();
+	LogTrace("FFTFilter: batching %zu FFTs of %zu points\n", nbatch, npoints);
+
+	//(Re)create the shared plan and concatenated buffers if the geometry changed
+	m_batchInBuf.SetCpuAccessHint(AcceleratorBuffer<float>::HINT_NEVER);
+	m_batchInBuf.SetGpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
+	m_batchOutBuf.SetCpuAccessHint(AcceleratorBuffer<float>::HINT_NEVER);
+	m_batchOutBuf.SetGpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
+	if(m_vkBatchPlan && ( (m_vkBatchPlan->size() != npoints) || (m_cachedBatchSize != nbatch) ) )
+		m_vkBatchPlan = nullptr;
+	if(!m_vkBatchPlan)
+	{
+		m_vkBatchPlan = g_vkFFTPlanCache.Acquire(npoints, nouts, VulkanFFTPlan::DIRECTION_FORWARD, nbatch);
+		m_cachedBatchSize = nbatch;
+	}
+	m_batchInBuf.resize(npoints * nbatch);
+	m_batchOutBuf.resize(2 * nouts * nbatch);
+
+	//Record the compute work for the entire group into one command buffer with a single submit
+	cmdBuf.begin({});
+
+	//Window each input into its slot of the concatenated time domain buffer
+	vector<UniformAnalogWaveform*> caps;
+	vector<float> scales;
+	for(size_t i=0; i<nbatch; i++)
+	{
+		auto ff = ffts[i];
+		auto din = dins[i];
+
+		//Set up output and copy time scales / configuration
+		double sample_ghz = 1e6 / din->m_timescale;
+		double bin_hz = round((0.5f * sample_ghz * 1e9f) / nouts);
+		auto cap = ff->SetupEmptyUniformAnalogOutputWaveform(din, 0);
+		cap->m_triggerPhase = 1*bin_hz;
+		cap->m_timescale = bin_hz;
+		cap->Resize(nouts);
+		caps.push_back(cap);
+
+		auto window = static_cast<WindowFunction>(ff->m_parameters[ff->m_windowName].GetIntVal());
+		size_t numActualSamples = min(din->m_samples.size(), npoints);
+		scales.push_back(GetWindowScale(window, numActualSamples));
+
+		WindowFunctionArgs args;
+		ConfigureWindowArgs(args, window, numActualSamples);
+		args.npoints = npoints;
+		args.offsetIn = 0;
+		args.offsetOut = i*npoints;
+
+		//Use each member's own pipeline objects, so the descriptor sets of the back-to-back dispatches
+		//don't alias each other. The dispatches write disjoint slots so no barriers are needed between them.
+		auto& wpipe = ff->GetWindowPipeline(window);
+		wpipe.BindBufferNonblocking(0, din->m_samples, cmdBuf);
+		wpipe.BindBufferNonblocking(1, m_batchInBuf, cmdBuf, true);
+		wpipe.Dispatch(cmdBuf, args, GetComputeBlockCount(npoints, 64));
+	}
+	ComputePipeline::AddComputeMemoryBarrier(cmdBuf);
+	m_batchInBuf.MarkModifiedFromGpu();
+
+	//One batched FFT over all of the inputs
+	m_vkBatchPlan->AppendForward(m_batchInBuf, m_batchOutBuf, cmdBuf);
+	ComputePipeline::AddComputeMemoryBarrier(cmdBuf);
+
+	//Convert each slot of the concatenated frequency domain buffer to log magnitude in its own output
+	for(size_t i=0; i<nbatch; i++)
+	{
+		auto ff = ffts[i];
+
+		ComplexToMagnitudeArgs cargs;
+		cargs.npoints = nouts;
+		cargs.offsetIn = i * 2*nouts;
+		const float impedance = 50;
+		cargs.scale = scales[i] * scales[i] / impedance;
+
+		auto& pipe = ff->m_complexToLogMagnitudeComputePipeline;
+		pipe.BindBufferNonblocking(0, m_batchOutBuf, cmdBuf);
+		pipe.BindBufferNonblocking(1, caps[i]->m_samples, cmdBuf, true);
+		pipe.Dispatch(cmdBuf, cargs, GetComputeBlockCount(nouts, 64));
+	}
+
+	//Done, block until the compute operations finish
+	cmdBuf.end();
+	queue->SubmitAndBlock(cmdBuf);
+
+	//Peak search (on the GPU if filter acceleration is enabled, so the spectra can stay device resident)
+	for(size_t i=0; i<nbatch; i++)
+	{
+		caps[i]->MarkModifiedFromGpu();
+		ffts[i]->FindPeaks(caps[i], cmdBuf, queue);
+	}
+
+	return true;
 }
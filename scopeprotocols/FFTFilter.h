@@ -42,6 +42,7 @@ class QueueHandle;
 struct ComplexToMagnitudeArgs
 {
 	uint32_t npoints;
+	uint32_t offsetIn;
 	float scale;
 };
 
@@ -54,6 +55,12 @@ public:
 	virtual void Refresh(vk::raii::CommandBuffer& cmdBuf, std::shared_ptr<QueueHandle> queue) override;
 	virtual DataLocation GetInputLocation() override;
 
+	virtual std::string GetBatchKey() override;
+	virtual bool RefreshBatch(
+		const std::vector<Filter*>& filters,
+		vk::raii::CommandBuffer& cmdBuf,
+		std::shared_ptr<QueueHandle> queue) override;
+
 	static std::string GetProtocolName();
 
 	virtual float GetVoltageRange(size_t stream) override;
@@ -94,6 +101,11 @@ protected:
 
 	void ReallocateBuffers(size_t npoints_raw, size_t npoints, size_t nouts);
 
+	size_t GetRoundedNumPoints(size_t npoints_raw);
+	ComputePipeline& GetWindowPipeline(WindowFunction window);
+	static float GetWindowScale(WindowFunction window, size_t numActualSamples);
+	static void ConfigureWindowArgs(WindowFunctionArgs& args, WindowFunction window, size_t numActualSamples);
+
 	void DoRefresh(
 		WaveformBase* din,
 		AcceleratorBuffer<float>& data,
@@ -117,7 +129,13 @@ protected:
 	std::string m_windowName;
 	std::string m_roundingName;
 
-	std::unique_ptr<VulkanFFTPlan> m_vkPlan;
+	std::shared_ptr<VulkanFFTPlan> m_vkPlan;
+
+	//Batched execution state, only used on the head filter of a batch group
+	AcceleratorBuffer<float> m_batchInBuf;
+	AcceleratorBuffer<float> m_batchOutBuf;
+	std::shared_ptr<VulkanFFTPlan> m_vkBatchPlan;
+	size_t m_cachedBatchSize;
 
 	ComputePipeline m_blackmanHarrisComputePipeline;
 	ComputePipeline m_rectangularComputePipeline;
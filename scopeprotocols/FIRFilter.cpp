@@ -46,6 +46,17 @@ FIRFilter::FIRFilter(const string& color)
 	, m_freqLowName("Frequency Low")
 	, m_freqHighName("Frequency High")
 	, m_computePipeline("shaders/FIRFilter.spv", 3, sizeof(FIRFilterArgs))
+	, m_cachedFilterLen(0)
+	, m_cachedFa(-1)
+	, m_cachedFb(-1)
+	, m_cachedAtten(-1)
+	, m_cachedType(FILTER_TYPE_LOWPASS)
+	, m_cachedNumPoints(0)
+	, m_kernelFFTValid(false)
+	, m_rectangularComputePipeline("shaders/RectangularWindow.spv", 2, sizeof(WindowFunctionArgs))
+	, m_kernelRectangularComputePipeline("shaders/RectangularWindow.spv", 2, sizeof(WindowFunctionArgs))
+	, m_multiplyComputePipeline("shaders/ComplexConjugateMultiply.spv", 2, sizeof(uint32_t))
+	, m_normalizeComputePipeline("shaders/DeEmbedNormalization.spv", 2, sizeof(DeEmbedNormalizationArgs))
 {
 	AddStream(Unit(Unit::UNIT_VOLTS), "data", Stream::STREAM_TYPE_ANALOG);
 	CreateInput("in");
@@ -69,8 +80,26 @@ FIRFilter::FIRFilter(const string& color)
 	m_parameters[m_freqHighName] = FilterParameter(FilterParameter::TYPE_FLOAT, Unit(Unit::UNIT_HZ));
 	m_parameters[m_freqHighName].SetFloatVal(100e6);
 
+	m_cachedFilterType.Bind(m_parameters[m_filterTypeName]);
+	m_cachedLength.Bind(m_parameters[m_filterLengthName]);
+	m_cachedStopbandAtten.Bind(m_parameters[m_stopbandAttenName]);
+	m_cachedFreqLow.Bind(m_parameters[m_freqLowName]);
+	m_cachedFreqHigh.Bind(m_parameters[m_freqHighName]);
+
 	m_coefficients.SetCpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
 	m_coefficients.SetGpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
+
+	m_forwardInBuf.SetCpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
+	m_forwardInBuf.SetGpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
+
+	m_forwardOutBuf.SetCpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
+	m_forwardOutBuf.SetGpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
+
+	m_kernelFFTBuf.SetCpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
+	m_kernelFFTBuf.SetGpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
+
+	m_reverseOutBuf.SetCpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
+	m_reverseOutBuf.SetGpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -159,9 +188,9 @@ void FIRFilter::Refresh(vk::raii::CommandBuffer& cmdBuf, shared_ptr<QueueHandle>
 
 	//Calculate limits for our filter
 	float nyquist = sample_hz / 2;
-	float flo = m_parameters[m_freqLowName].GetFloatVal();
-	float fhi = m_parameters[m_freqHighName].GetFloatVal();
-	auto type = static_cast<FilterType>(m_parameters[m_filterTypeName].GetIntVal());
+	float flo = m_cachedFreqLow.GetFloatVal();
+	float fhi = m_cachedFreqHigh.GetFloatVal();
+	auto type = static_cast<FilterType>(m_cachedFilterType.GetIntVal());
 	if(type == FILTER_TYPE_LOWPASS)
 		flo = 0;
 	else if(type == FILTER_TYPE_HIGHPASS)
@@ -180,8 +209,8 @@ void FIRFilter::Refresh(vk::raii::CommandBuffer& cmdBuf, shared_ptr<QueueHandle>
 	fhi = min(fhi, nyquist);
 
 	//Calculate filter order
-	size_t filterlen = m_parameters[m_filterLengthName].GetIntVal();
-	float atten = m_parameters[m_stopbandAttenName].GetFloatVal();
+	size_t filterlen = m_cachedLength.GetIntVal();
+	float atten = m_cachedStopbandAtten.GetFloatVal();
 	if(filterlen == 0)
 		filterlen = (atten / 22) * (sample_hz / (fhi - flo) );
 	filterlen |= 1;	//force length to be odd
@@ -200,9 +229,24 @@ void FIRFilter::Refresh(vk::raii::CommandBuffer& cmdBuf, shared_ptr<QueueHandle>
 		return;
 	}
 
-	//Create the filter coefficients (TODO: cache this)
-	m_coefficients.resize(filterlen);
-	CalculateFilterCoefficients(flo / nyquist, fhi / nyquist, atten, type);
+	//Create the filter coefficients, unless the tap set is unchanged from the last run
+	float fa = flo / nyquist;
+	float fb = fhi / nyquist;
+	if( (m_cachedFilterLen != filterlen) || (m_cachedFa != fa) || (m_cachedFb != fb) ||
+		(m_cachedAtten != atten) || (m_cachedType != type) )
+	{
+		m_coefficients.resize(filterlen);
+		CalculateFilterCoefficients(fa, fb, atten, type);
+
+		m_cachedFilterLen = filterlen;
+		m_cachedFa = fa;
+		m_cachedFb = fb;
+		m_cachedAtten = atten;
+		m_cachedType = type;
+
+		//The forward-transformed kernel is stale too
+		m_kernelFFTValid = false;
+	}
 
 	//Set up output
 	m_xAxisUnit = m_inputs[0].m_channel->GetXAxisUnits();
@@ -224,40 +268,58 @@ void FIRFilter::DoFilterKernel(
 	UniformAnalogWaveform* din,
 	UniformAnalogWaveform* cap)
 {
-	if(g_gpuFilterEnabled)
+	//Direct form is O(samples * taps) while the frequency domain path is roughly constant per sample,
+	//so above this much work the transforms pay for themselves
+	const uint64_t fftCrossover = 64ULL * 1024ULL * 1024ULL;
+	uint64_t work = (uint64_t)(din->size() - m_coefficients.size()) * m_coefficients.size();
+
+	if(g_gpuFilterEnabled && (work >= fftCrossover) )
+		DoFilterKernelFFT(cmdBuf, queue, din, cap);
+
+	else
 	{
-		cmdBuf.begin({});
+		//Below the FFT crossover, let the measured cost model pick between the direct GPU kernel
+		//and the vectorized CPU path (the winner depends on dispatch overhead vs core speed)
+		bool gpu = g_gpuFilterEnabled && g_filterCostModel.PreferGpu(GetProtocolName(), work);
+		double tstart = GetTime();
 
-		FIRFilterArgs args;
-		args.end = din->size() - m_coefficients.size();
-		args.filterlen = m_coefficients.size();
+		if(gpu)
+		{
+			cmdBuf.begin({});
 
-		m_computePipeline.BindBufferNonblocking(0, din->m_samples, cmdBuf);
-		m_computePipeline.BindBufferNonblocking(1, m_coefficients, cmdBuf);
-		m_computePipeline.BindBufferNonblocking(2, cap->m_samples, cmdBuf, true);
-		m_computePipeline.Dispatch(cmdBuf, args, GetComputeBlockCount(args.end, 64));
+			FIRFilterArgs args;
+			args.end = din->size() - m_coefficients.size();
+			args.filterlen = m_coefficients.size();
 
-		cmdBuf.end();
-		queue->SubmitAndBlock(cmdBuf);
+			m_computePipeline.BindBufferNonblocking(0, din->m_samples, cmdBuf);
+			m_computePipeline.BindBufferNonblocking(1, m_coefficients, cmdBuf);
+			m_computePipeline.BindBufferNonblocking(2, cap->m_samples, cmdBuf, true);
+			m_computePipeline.Dispatch(cmdBuf, args, GetComputeBlockCount(args.end, 64));
 
-		cap->m_samples.MarkModifiedFromGpu();
-	}
+			cmdBuf.end();
+			queue->SubmitAndBlock(cmdBuf);
+
+			cap->m_samples.MarkModifiedFromGpu();
+		}
 
-	else
-	{
-		din->PrepareForCpuAccess();
-		cap->PrepareForCpuAccess();
-
-		#ifdef __x86_64__
-		if(g_hasAvx512F)
-			DoFilterKernelAVX512F(din, cap);
-		else if(g_hasAvx2)
-			DoFilterKernelAVX2(din, cap);
 		else
-		#endif
-			DoFilterKernelGeneric(din, cap);
+		{
+			din->PrepareForCpuAccess();
+			cap->PrepareForCpuAccess();
+
+			#ifdef __x86_64__
+			if(g_hasAvx512F)
+				DoFilterKernelAVX512F(din, cap);
+			else if(g_hasAvx2)
+				DoFilterKernelAVX2(din, cap);
+			else
+			#endif
+				DoFilterKernelGeneric(din, cap);
+
+			cap->MarkModifiedFromCpu();
+		}
 
-		cap->MarkModifiedFromCpu();
+		g_filterCostModel.Record(GetProtocolName(), gpu, work, (GetTime() - tstart) * 1e9);
 	}
 }
 
@@ -284,6 +346,140 @@ void FIRFilter::DoFilterKernelGeneric(
 	}
 }
 
+/**
+	@brief Frequency domain convolution, for kernels long enough that the direct form is slower than a transform pair
+
+	Zero padding the input to the next power of two past its length guarantees no sample of the valid output region
+	wraps around, so a single full-length transform behaves like linear convolution. The kernel spectrum is conjugated
+	in the multiply so the result matches the correlation-style indexing of the direct form exactly, and is cached
+	across triggers until the tap set changes.
+ */
+void FIRFilter::DoFilterKernelFFT(
+	vk::raii::CommandBuffer& cmdBuf,
+	shared_ptr<QueueHandle> queue,
+	UniformAnalogWaveform* din,
+	UniformAnalogWaveform* cap)
+{
+	size_t len = din->size();
+	size_t filterlen = m_coefficients.size();
+	size_t outlen = len - filterlen;
+
+	//Zero pad to next power of two up
+	const size_t npoints = next_pow2(len);
+	size_t nouts = npoints/2 + 1;
+
+	//Invalidate old vkFFT plans if size has changed
+	if(m_vkForwardPlan)
+	{
+		if(m_vkForwardPlan->size() != npoints)
+			m_vkForwardPlan = nullptr;
+	}
+	if(m_vkKernelPlan)
+	{
+		if(m_vkKernelPlan->size() != npoints)
+			m_vkKernelPlan = nullptr;
+	}
+	if(m_vkReversePlan)
+	{
+		if(m_vkReversePlan->size() != npoints)
+			m_vkReversePlan = nullptr;
+	}
+
+	//Set up the FFT and allocate buffers if we change point count
+	if(m_cachedNumPoints != npoints)
+	{
+		m_forwardInBuf.resize(npoints);
+		m_forwardOutBuf.resize(2 * nouts);
+		m_kernelFFTBuf.resize(2 * nouts);
+		m_reverseOutBuf.resize(npoints);
+
+		m_cachedNumPoints = npoints;
+
+		//Kernel spectrum was taken at the old point count
+		m_kernelFFTValid = false;
+	}
+
+	//Set up new FFT plans
+	if(!m_vkForwardPlan)
+		m_vkForwardPlan = g_vkFFTPlanCache.Acquire(npoints, nouts, VulkanFFTPlan::DIRECTION_FORWARD);
+	if(!m_vkKernelPlan)
+		m_vkKernelPlan = g_vkFFTPlanCache.Acquire(npoints, nouts, VulkanFFTPlan::DIRECTION_FORWARD);
+	if(!m_vkReversePlan)
+		m_vkReversePlan = g_vkFFTPlanCache.Acquire(npoints, nouts, VulkanFFTPlan::DIRECTION_REVERSE);
+
+	//Prepare to do all of our compute stuff in one dispatch call to reduce overhead
+	cmdBuf.begin({});
+
+	//Transform the kernel if the cached spectrum is stale
+	if(!m_kernelFFTValid)
+	{
+		WindowFunctionArgs kargs;
+		kargs.numActualSamples = filterlen;
+		kargs.npoints = npoints;
+		kargs.scale = 0;
+		kargs.alpha0 = 0;
+		kargs.alpha1 = 0;
+		kargs.offsetIn = 0;
+		kargs.offsetOut = 0;
+		m_kernelRectangularComputePipeline.BindBufferNonblocking(0, m_coefficients, cmdBuf);
+		m_kernelRectangularComputePipeline.BindBufferNonblocking(1, m_forwardInBuf, cmdBuf, true);
+		m_kernelRectangularComputePipeline.Dispatch(cmdBuf, kargs, GetComputeBlockCount(npoints, 64));
+		m_kernelRectangularComputePipeline.AddComputeMemoryBarrier(cmdBuf);
+		m_forwardInBuf.MarkModifiedFromGpu();
+
+		m_vkKernelPlan->AppendForward(m_forwardInBuf, m_kernelFFTBuf, cmdBuf);
+		m_kernelFFTBuf.MarkModifiedFromGpu();
+
+		//m_forwardInBuf is recycled for the input below, so make sure the kernel FFT is done reading it first
+		m_kernelRectangularComputePipeline.AddComputeMemoryBarrier(cmdBuf);
+
+		m_kernelFFTValid = true;
+	}
+
+	//Copy and zero-pad the input as needed
+	WindowFunctionArgs args;
+	args.numActualSamples = len;
+	args.npoints = npoints;
+	args.scale = 0;
+	args.alpha0 = 0;
+	args.alpha1 = 0;
+	args.offsetIn = 0;
+	args.offsetOut = 0;
+	m_rectangularComputePipeline.BindBufferNonblocking(0, din->m_samples, cmdBuf);
+	m_rectangularComputePipeline.BindBufferNonblocking(1, m_forwardInBuf, cmdBuf, true);
+	m_rectangularComputePipeline.Dispatch(cmdBuf, args, GetComputeBlockCount(npoints, 64));
+	m_rectangularComputePipeline.AddComputeMemoryBarrier(cmdBuf);
+	m_forwardInBuf.MarkModifiedFromGpu();
+
+	//Do the actual FFT operation
+	m_vkForwardPlan->AppendForward(m_forwardInBuf, m_forwardOutBuf, cmdBuf);
+
+	//Multiply by the conjugated kernel spectrum
+	m_multiplyComputePipeline.BindBufferNonblocking(0, m_forwardOutBuf, cmdBuf);
+	m_multiplyComputePipeline.BindBufferNonblocking(1, m_kernelFFTBuf, cmdBuf);
+	m_multiplyComputePipeline.Dispatch(cmdBuf, (uint32_t)nouts, GetComputeBlockCount(nouts, 64));
+	m_multiplyComputePipeline.AddComputeMemoryBarrier(cmdBuf);
+	m_forwardOutBuf.MarkModifiedFromGpu();
+
+	//Do the actual FFT operation
+	m_vkReversePlan->AppendReverse(m_forwardOutBuf, m_reverseOutBuf, cmdBuf);
+
+	//Copy and normalize output
+	DeEmbedNormalizationArgs nargs;
+	nargs.outlen = outlen;
+	nargs.istart = 0;
+	nargs.scale = 1.0f / npoints;
+	m_normalizeComputePipeline.BindBufferNonblocking(0, m_reverseOutBuf, cmdBuf);
+	m_normalizeComputePipeline.BindBufferNonblocking(1, cap->m_samples, cmdBuf, true);
+	m_normalizeComputePipeline.Dispatch(cmdBuf, nargs, GetComputeBlockCount(outlen, 64));
+	m_normalizeComputePipeline.AddComputeMemoryBarrier(cmdBuf);
+
+	//Done. Leave the submission in flight if the scheduler allows it, otherwise block
+	cmdBuf.end();
+	SubmitOrDefer(cmdBuf, queue);
+	cap->MarkModifiedFromGpu();
+}
+
 #ifdef __x86_64__
 /**
 	@brief Optimized FIR implementation
@@ -35,6 +35,8 @@
 #ifndef FIRFilter_h
 #define FIRFilter_h
 
+#include "VulkanFFTPlan.h"
+
 struct FIRFilterArgs
 {
 	uint32_t end;
@@ -95,6 +97,12 @@ protected:
 		UniformAnalogWaveform* din,
 		UniformAnalogWaveform* cap);
 
+	void DoFilterKernelFFT(
+		vk::raii::CommandBuffer& cmdBuf,
+		std::shared_ptr<QueueHandle> queue,
+		UniformAnalogWaveform* din,
+		UniformAnalogWaveform* cap);
+
 #ifdef __x86_64__
 	void DoFilterKernelAVX2(
 		UniformAnalogWaveform* din,
@@ -111,9 +119,40 @@ protected:
 	std::string m_freqLowName;
 	std::string m_freqHighName;
 
+	//Pre-resolved parameter values, so Refresh() never does string-keyed parameter lookups
+	CachedParameter m_cachedFilterType;
+	CachedParameter m_cachedLength;
+	CachedParameter m_cachedStopbandAtten;
+	CachedParameter m_cachedFreqLow;
+	CachedParameter m_cachedFreqHigh;
+
 	ComputePipeline m_computePipeline;
 
 	AcceleratorBuffer<float> m_coefficients;
+
+	//Cached tap parameters, so the coefficients (and their forward transform) can be reused across triggers
+	size_t m_cachedFilterLen;
+	float m_cachedFa;
+	float m_cachedFb;
+	float m_cachedAtten;
+	FilterType m_cachedType;
+
+	//Frequency domain convolution path, used for long kernels
+	size_t m_cachedNumPoints;
+	bool m_kernelFFTValid;
+
+	AcceleratorBuffer<float> m_forwardInBuf;
+	AcceleratorBuffer<float> m_forwardOutBuf;
+	AcceleratorBuffer<float> m_kernelFFTBuf;
+	AcceleratorBuffer<float> m_reverseOutBuf;
+
+	ComputePipeline m_rectangularComputePipeline;
+	ComputePipeline m_kernelRectangularComputePipeline;
+	ComputePipeline m_multiplyComputePipeline;
+	ComputePipeline m_normalizeComputePipeline;
+	std::shared_ptr<VulkanFFTPlan> m_vkForwardPlan;
+	std::shared_ptr<VulkanFFTPlan> m_vkKernelPlan;
+	std::shared_ptr<VulkanFFTPlan> m_vkReversePlan;
 };
 
 #endif
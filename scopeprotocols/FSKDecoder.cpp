@@ -28,15 +28,27 @@
 ***********************************************************************************************************************/
 
 #include "../scopehal/scopehal.h"
+#include "../scopehal/ThresholdKernel.h"
 #include "FSKDecoder.h"
+#include "HistogramFilter.h"
 
 using namespace std;
 
+namespace
+{
+	///@brief Frequency samples below this are assumed to have failed squelch and are ignored
+	const float g_squelchFloor = 50;
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Construction / destruction
 
 FSKDecoder::FSKDecoder(const string& color)
 	: Filter(color, CAT_RF)
+	, m_minmaxComputePipeline("shaders/FSKMinMax.spv", 2, sizeof(FSKMinMaxArgs))
+	, m_histogramComputePipeline("shaders/HistogramFilter.spv", 2, sizeof(HistogramBinArgs))
+	, m_blockStateComputePipeline("shaders/FSKBlockState.spv", 2, sizeof(FSKHysteresisArgs))
+	, m_hysteresisComputePipeline("shaders/FSKHysteresis.spv", 3, sizeof(FSKHysteresisArgs))
 {
 	AddDigitalStream("data");
 	CreateInput("Frequency");
@@ -81,6 +93,16 @@ string FSKDecoder::GetProtocolName()
 // Actual decoder logic
 
 void FSKDecoder::Refresh()
+{
+	DoRefresh(nullptr, nullptr);
+}
+
+void FSKDecoder::Refresh(vk::raii::CommandBuffer& cmdBuf, shared_ptr<QueueHandle> queue)
+{
+	DoRefresh(&cmdBuf, queue);
+}
+
+void FSKDecoder::DoRefresh(vk::raii::CommandBuffer* cmdBuf, shared_ptr<QueueHandle> queue)
 {
 	if(!VerifyAllInputsOKAndUniformAnalog())
 	{
@@ -91,25 +113,45 @@ void FSKDecoder::Refresh()
 	//Get the input data
 	auto din = dynamic_cast<UniformAnalogWaveform*>(GetInputWaveform(0));
 	auto len = din->size();
-	din->PrepareForCpuAccess();
+
+	//Demodulate on the GPU if we can, falling back to the CPU path otherwise
+	bool gpu = (cmdBuf != nullptr) && g_gpuFilterEnabled && g_hasShaderInt8 && g_hasPushDescriptor;
+	if(!gpu)
+		din->PrepareForCpuAccess();
 
 	//Calculate min/max of the input data (ignoring really low values that failed squelch)
 	float nmin = FLT_MAX;
 	float nmax = -FLT_MAX;
-	for(float v : din->m_samples)
+	if(gpu)
+		GetMinMaxGpu(din, nmin, nmax, *cmdBuf, queue);
+	else
 	{
-		if(v < 50)		//discard anything that got squelched
-			continue;
+		for(float v : din->m_samples)
+		{
+			if(v < g_squelchFloor)		//discard anything that got squelched
+				continue;
+
+			nmin = min(nmin, v);
+			nmax = max(nmax, v);
+		}
+	}
 
-		nmin = min(nmin, v);
-		nmax = max(nmax, v);
+	//If everything got squelched, there's no signal to slice
+	if(nmax <= nmin)
+	{
+		SetData(NULL, 0);
+		return;
 	}
 
 	//Find threshold by building a histogram of the samples
 	const size_t bin_hz = 500;
 	float vrange = nmax - nmin;
 	const size_t nbins = ceil(vrange / bin_hz);
-	auto hist = MakeHistogramClipped(din, nmin, nmax, nbins);
+	vector<size_t> hist;
+	if(gpu)
+		hist = MakeHistogramGpu(din, nmin, nmax, nbins, *cmdBuf, queue);
+	else
+		hist = MakeHistogramClipped(din, nmin, nmax, nbins);
 
 	//Find the highest two peaks (0 and 1 levels)
 	size_t maxbin1 = 0;
@@ -160,32 +202,186 @@ void FSKDecoder::Refresh()
 	float hys = fabs(freq1 - freq2) * 0.2;
 	auto cap = SetupEmptyUniformDigitalOutputWaveform(din, 0);
 	cap->Resize(len);
-	cap->PrepareForCpuAccess();
 
-	//Threshold all of our samples
-	//Optimized inner loop if no hysteresis
+	float thresh_rising = midpoint + hys/2;
+	float thresh_falling = midpoint - hys/2;
+
+	//Slice all of our samples against the tone thresholds
+	if(gpu)
+	{
+		ThresholdWithHysteresisGpu(din, cap, thresh_rising, thresh_falling, midpoint, *cmdBuf, queue);
+		return;
+	}
+
+	//CPU path: vectorized kernels from ThresholdKernel
+	cap->PrepareForCpuAccess();
 	if(hys == 0)
 	{
-		#pragma omp parallel for
-		for(size_t i=0; i<len; i++)
-			cap->m_samples[i] = din->m_samples[i] > midpoint;
+		ThresholdKernel::Threshold(
+			din->m_samples.GetCpuPointer(), cap->m_samples.GetCpuPointer(), len, midpoint);
 	}
 	else
 	{
-		bool cur = din->m_samples[0] > midpoint;
-		float thresh_rising = midpoint + hys/2;
-		float thresh_falling = midpoint - hys/2;
+		ThresholdKernel::ThresholdWithHysteresis(
+			din->m_samples.GetCpuPointer(), cap->m_samples.GetCpuPointer(), len,
+			thresh_rising, thresh_falling, (len > 0) && (din->m_samples[0] > midpoint));
+	}
+	cap->MarkModifiedFromCpu();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// GPU demod pipeline
+
+/**
+	@brief Finds the min/max of the un-squelched input samples on the GPU
+
+	Each workgroup reduces a strided subset of the samples into a partial result, then the handful
+	of per-workgroup partials are reduced on the CPU after readback.
+ */
+void FSKDecoder::GetMinMaxGpu(
+	UniformAnalogWaveform* din,
+	float& nmin,
+	float& nmax,
+	vk::raii::CommandBuffer& cmdBuf,
+	shared_ptr<QueueHandle> queue)
+{
+	din->m_samples.PrepareForGpuAccess();
+
+	const uint32_t numGroups = 256;
+	m_minmaxBuf.resize(numGroups * 2);
+	m_minmaxBuf.SetCpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
+	m_minmaxBuf.SetGpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
+
+	FSKMinMaxArgs args;
+	args.len = din->size();
+	args.vfloor = g_squelchFloor;
+
+	cmdBuf.begin({});
+	m_minmaxComputePipeline.BindBufferNonblocking(0, din->m_samples, cmdBuf);
+	m_minmaxComputePipeline.BindBufferNonblocking(1, m_minmaxBuf, cmdBuf, true);
+	m_minmaxComputePipeline.Dispatch(cmdBuf, args, numGroups);
+	cmdBuf.end();
+	queue->SubmitAndBlock(cmdBuf);
+	m_minmaxBuf.MarkModifiedFromGpu();
+
+	//Reduce the per-workgroup partials
+	m_minmaxBuf.PrepareForCpuAccess();
+	nmin = FLT_MAX;
+	nmax = -FLT_MAX;
+	for(uint32_t i=0; i<numGroups; i++)
+	{
+		nmin = min(nmin, m_minmaxBuf[i*2]);
+		nmax = max(nmax, m_minmaxBuf[i*2 + 1]);
+	}
+}
 
-		for(size_t i=0; i<len; i++)
-		{
-			float f = din->m_samples[i];
-			if(cur && (f < thresh_falling))
-				cur = false;
-			else if(!cur && (f > thresh_rising))
-				cur = true;
-			cap->m_samples[i] = cur;
-		}
+/**
+	@brief Bins the input into a histogram on the GPU, reusing the HistogramFilter shader
+ */
+vector<size_t> FSKDecoder::MakeHistogramGpu(
+	UniformAnalogWaveform* din,
+	float low,
+	float high,
+	size_t bins,
+	vk::raii::CommandBuffer& cmdBuf,
+	shared_ptr<QueueHandle> queue)
+{
+	din->m_samples.PrepareForGpuAccess();
+
+	//Zero the bin buffer
+	m_gpuHistBuf.resize(bins);
+	m_gpuHistBuf.SetCpuAccessHint(AcceleratorBuffer<uint32_t>::HINT_LIKELY);
+	m_gpuHistBuf.SetGpuAccessHint(AcceleratorBuffer<uint32_t>::HINT_LIKELY);
+	m_gpuHistBuf.PrepareForCpuAccess();
+	memset(m_gpuHistBuf.GetCpuPointer(), 0, bins * sizeof(uint32_t));
+	m_gpuHistBuf.MarkModifiedFromCpu();
+
+	HistogramBinArgs args;
+	args.len = din->size();
+	args.nbins = bins;
+	args.vmin = low;
+	args.delta = high - low;
+
+	cmdBuf.begin({});
+	m_histogramComputePipeline.BindBufferNonblocking(0, din->m_samples, cmdBuf);
+	m_histogramComputePipeline.BindBufferNonblocking(1, m_gpuHistBuf, cmdBuf);
+	m_histogramComputePipeline.Dispatch(cmdBuf, args, 256);
+	cmdBuf.end();
+	queue->SubmitAndBlock(cmdBuf);
+	m_gpuHistBuf.MarkModifiedFromGpu();
+
+	//Widen the counts for the peak search
+	m_gpuHistBuf.PrepareForCpuAccess();
+	vector<size_t> ret(bins);
+	for(size_t i=0; i<bins; i++)
+		ret[i] = m_gpuHistBuf[i];
+	return ret;
+}
+
+/**
+	@brief Slices the frequency waveform against the two tone thresholds on the GPU
+
+	Hysteresis makes the slicer a sequential state machine, so it runs in two phases: a first dispatch finds
+	the last decisive sample (one that crossed either threshold) in each fixed-size block, the host resolves
+	the state entering every block with a tiny serial scan over those results, then a second dispatch slices
+	each block independently from its resolved incoming state. Samples never round-trip to the CPU.
+ */
+void FSKDecoder::ThresholdWithHysteresisGpu(
+	UniformAnalogWaveform* din,
+	UniformDigitalWaveform* cap,
+	float thresh_rising,
+	float thresh_falling,
+	float midpoint,
+	vk::raii::CommandBuffer& cmdBuf,
+	shared_ptr<QueueHandle> queue)
+{
+	size_t len = din->size();
+	const uint32_t blocksize = 256;
+	size_t nblocks = (len + blocksize - 1) / blocksize;
+
+	din->m_samples.PrepareForGpuAccess();
+
+	//One extra element for the seed state (first sample vs the midpoint)
+	m_blockStateBuf.resize(nblocks + 1);
+	m_blockStateBuf.SetCpuAccessHint(AcceleratorBuffer<uint32_t>::HINT_LIKELY);
+	m_blockStateBuf.SetGpuAccessHint(AcceleratorBuffer<uint32_t>::HINT_LIKELY);
+
+	FSKHysteresisArgs args;
+	args.len = len;
+	args.blocksize = blocksize;
+	args.vrise = thresh_rising;
+	args.vfall = thresh_falling;
+	args.midpoint = midpoint;
+
+	//Phase 1: last decisive state within each block
+	cmdBuf.begin({});
+	m_blockStateComputePipeline.BindBufferNonblocking(0, din->m_samples, cmdBuf);
+	m_blockStateComputePipeline.BindBufferNonblocking(1, m_blockStateBuf, cmdBuf, true);
+	m_blockStateComputePipeline.Dispatch(cmdBuf, args, GetComputeBlockCount(nblocks, 64));
+	cmdBuf.end();
+	queue->SubmitAndBlock(cmdBuf);
+	m_blockStateBuf.MarkModifiedFromGpu();
+
+	//Resolve the state entering each block: the last decisive state of any earlier block,
+	//seeded by the first sample's midpoint compare (matching the serial slicer)
+	m_blockStateBuf.PrepareForCpuAccess();
+	uint32_t cur = m_blockStateBuf[nblocks];
+	for(size_t i=0; i<nblocks; i++)
+	{
+		uint32_t last = m_blockStateBuf[i];
+		m_blockStateBuf[i] = cur;
+		if(last != 2)
+			cur = last;
 	}
+	m_blockStateBuf.MarkModifiedFromCpu();
 
-	cap->MarkModifiedFromCpu();
+	//Phase 2: slice each block independently
+	cmdBuf.begin({});
+	m_hysteresisComputePipeline.BindBufferNonblocking(0, din->m_samples, cmdBuf);
+	m_hysteresisComputePipeline.BindBufferNonblocking(1, m_blockStateBuf, cmdBuf);
+	m_hysteresisComputePipeline.BindBufferNonblocking(2, cap->m_samples, cmdBuf, true);
+	m_hysteresisComputePipeline.Dispatch(cmdBuf, args, GetComputeBlockCount(nblocks, 64));
+	cmdBuf.end();
+	queue->SubmitAndBlock(cmdBuf);
+	cap->m_samples.MarkModifiedFromGpu();
 }
@@ -35,12 +35,28 @@
 #ifndef FSKDecoder_h
 #define FSKDecoder_h
 
+struct FSKMinMaxArgs
+{
+	uint32_t len;
+	float vfloor;
+};
+
+struct FSKHysteresisArgs
+{
+	uint32_t len;
+	uint32_t blocksize;
+	float vrise;
+	float vfall;
+	float midpoint;
+};
+
 class FSKDecoder : public Filter
 {
 public:
 	FSKDecoder(const std::string& color);
 
 	virtual void Refresh() override;
+	virtual void Refresh(vk::raii::CommandBuffer& cmdBuf, std::shared_ptr<QueueHandle> queue) override;
 
 	static std::string GetProtocolName();
 
@@ -49,6 +65,40 @@ public:
 	PROTOCOL_DECODER_INITPROC(FSKDecoder)
 
 protected:
+	void DoRefresh(vk::raii::CommandBuffer* cmdBuf, std::shared_ptr<QueueHandle> queue);
+
+	void GetMinMaxGpu(
+		UniformAnalogWaveform* din,
+		float& nmin,
+		float& nmax,
+		vk::raii::CommandBuffer& cmdBuf,
+		std::shared_ptr<QueueHandle> queue);
+
+	std::vector<size_t> MakeHistogramGpu(
+		UniformAnalogWaveform* din,
+		float low,
+		float high,
+		size_t bins,
+		vk::raii::CommandBuffer& cmdBuf,
+		std::shared_ptr<QueueHandle> queue);
+
+	void ThresholdWithHysteresisGpu(
+		UniformAnalogWaveform* din,
+		UniformDigitalWaveform* cap,
+		float thresh_rising,
+		float thresh_falling,
+		float midpoint,
+		vk::raii::CommandBuffer& cmdBuf,
+		std::shared_ptr<QueueHandle> queue);
+
+	//GPU demod state
+	AcceleratorBuffer<float> m_minmaxBuf;
+	AcceleratorBuffer<uint32_t> m_gpuHistBuf;
+	AcceleratorBuffer<uint32_t> m_blockStateBuf;
+	ComputePipeline m_minmaxComputePipeline;
+	ComputePipeline m_histogramComputePipeline;
+	ComputePipeline m_blockStateComputePipeline;
+	ComputePipeline m_hysteresisComputePipeline;
 };
 
 #endif
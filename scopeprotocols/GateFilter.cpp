@@ -89,10 +89,9 @@ void GateFilter::Refresh(vk::raii::CommandBuffer& /*cmdBuf*/, std::shared_ptr<Qu
 		return;
 	}
 
-	//TODO: handle sparse case
-	//for now, drop anything other than uniform
 	auto udin = dynamic_cast<UniformAnalogWaveform*>(din.GetData());
-	if(!udin)
+	auto sdin = dynamic_cast<SparseAnalogWaveform*>(din.GetData());
+	if(!udin && !sdin)
 	{
 		SetData(nullptr, 0);
 		return;
@@ -109,12 +108,28 @@ void GateFilter::Refresh(vk::raii::CommandBuffer& /*cmdBuf*/, std::shared_ptr<Qu
 	}
 
 	//Not gating, echo input to output
-	auto cap = SetupEmptyUniformAnalogOutputWaveform(udin, 0);
-	cap->m_timescale = udin->m_timescale;
-	cap->m_startTimestamp = udin->m_startTimestamp;
-	cap->m_startFemtoseconds = udin->m_startFemtoseconds;
-	cap->m_triggerPhase = udin->m_triggerPhase;
-	cap->m_flags = udin->m_flags;
-	cap->m_revision ++;
-	cap->m_samples.CopyFrom(udin->m_samples);
+	if(udin)
+	{
+		auto cap = SetupEmptyUniformAnalogOutputWaveform(udin, 0);
+		cap->m_timescale = udin->m_timescale;
+		cap->m_startTimestamp = udin->m_startTimestamp;
+		cap->m_startFemtoseconds = udin->m_startFemtoseconds;
+		cap->m_triggerPhase = udin->m_triggerPhase;
+		cap->m_flags = udin->m_flags;
+		cap->m_revision ++;
+		cap->m_samples.CopyFrom(udin->m_samples);
+	}
+	else
+	{
+		auto cap = SetupEmptySparseAnalogOutputWaveform(sdin, 0);
+		cap->m_timescale = sdin->m_timescale;
+		cap->m_startTimestamp = sdin->m_startTimestamp;
+		cap->m_startFemtoseconds = sdin->m_startFemtoseconds;
+		cap->m_triggerPhase = sdin->m_triggerPhase;
+		cap->m_flags = sdin->m_flags;
+		cap->m_revision ++;
+		cap->m_offsets.CopyFrom(sdin->m_offsets);
+		cap->m_durations.CopyFrom(sdin->m_durations);
+		cap->m_samples.CopyFrom(sdin->m_samples);
+	}
 }
@@ -155,7 +155,131 @@ void DoGlitchRemoval(T* din, SparseDigitalWaveform* cap, size_t minwidth)
 	cap->m_samples.shrink_to_fit();
 }
 
-void GlitchRemovalFilter::Refresh()
+/**
+	@brief Glitch removal for large uniform inputs: parallel transition extraction, then a serial merge
+
+	The run merging decisions are inherently sequential (each pulse may extend the previous one), but
+	for uniform inputs almost all of the time goes into scanning samples for transitions. Extract the
+	transition list in parallel with the same chunked two-pass approach as FindZeroCrossings, then run
+	the merge logic over the (much smaller) transition list. Output is identical to DoGlitchRemoval.
+ */
+static void DoGlitchRemovalUniformParallel(UniformDigitalWaveform* din, SparseDigitalWaveform* cap, size_t minwidth)
+{
+	size_t len = din->m_samples.size();
+
+	cap->PrepareForCpuAccess();
+	din->PrepareForCpuAccess();
+
+	auto& samples = din->m_samples;
+
+	//First pass: count transitions in each chunk
+	const size_t chunkSize = 4*1024*1024;
+	size_t nchunks = (len-1 + chunkSize-1) / chunkSize;
+	vector<size_t> chunkCounts(nchunks, 0);
+	#pragma omp parallel for
+	for(size_t c=0; c<nchunks; c++)
+	{
+		size_t istart = 1 + c*chunkSize;
+		size_t iend = min(istart + chunkSize, len);
+
+		size_t n = 0;
+		for(size_t i=istart; i<iend; i++)
+		{
+			if(samples[i] != samples[i-1])
+				n++;
+		}
+		chunkCounts[c] = n;
+	}
+
+	//Serial prefix sum to find where each chunk's transitions go.
+	//Sample zero always starts the first run, so chunk output starts at index 1.
+	vector<size_t> chunkOffsets(nchunks);
+	size_t ntransitions = 1;
+	for(size_t c=0; c<nchunks; c++)
+	{
+		chunkOffsets[c] = ntransitions;
+		ntransitions += chunkCounts[c];
+	}
+
+	//Second pass: extract the transition indices
+	vector<size_t> transitions(ntransitions);
+	transitions[0] = 0;
+	#pragma omp parallel for
+	for(size_t c=0; c<nchunks; c++)
+	{
+		size_t istart = 1 + c*chunkSize;
+		size_t iend = min(istart + chunkSize, len);
+
+		size_t iout = chunkOffsets[c];
+		for(size_t i=istart; i<iend; i++)
+		{
+			if(samples[i] != samples[i-1])
+				transitions[iout ++] = i;
+		}
+	}
+
+	//Serial merge over the transition list (same decisions as DoGlitchRemoval, one iteration per run)
+	cap->Resize(ntransitions);
+	size_t k = 0;
+	size_t tprev = 0;
+	for(size_t j=0; j<ntransitions; j++)
+	{
+		size_t t = transitions[j];
+		size_t running_length = t - tprev;
+		bool last_sample = (j == 0) ? !samples[0] : samples[tprev];
+
+		bool coalesce = false;
+		if (k != 0)
+		{
+			if (last_sample == cap->m_samples[k-1])
+			{
+				// Don't create a new sample, just extend the last one
+				coalesce = true;
+			}
+		}
+
+		if (running_length >= minwidth && !coalesce)
+		{
+			// Install pulse
+			cap->m_offsets[k] = tprev;
+			cap->m_samples[k] = last_sample;
+			cap->m_durations[k] = running_length;
+			k++;
+		}
+		else
+		{
+			if (k != 0)
+			{
+				// Extend last pulse
+				cap->m_durations[k-1] += running_length;
+			}
+			else
+			{
+				// At the beginning and no long-enough pulses yet
+			}
+		}
+
+		tprev = t;
+	}
+
+	if (k != 0)
+	{
+		cap->m_durations[k - 1] += len - tprev; // Extend last to end
+	}
+
+	cap->Resize(k);
+	cap->m_offsets.shrink_to_fit();
+	cap->m_durations.shrink_to_fit();
+	cap->m_samples.shrink_to_fit();
+}
+
+Filter::DataLocation GlitchRemovalFilter::GetInputLocation()
+{
+	//We explicitly manage our input memory and don't care where it is when Refresh() is called
+	return LOC_DONTCARE;
+}
+
+void GlitchRemovalFilter::Refresh(vk::raii::CommandBuffer& cmdBuf, shared_ptr<QueueHandle> queue)
 {
 	//Get the input data
 	auto udin = dynamic_cast<UniformDigitalWaveform*>(GetInputWaveform(0));
@@ -171,8 +295,28 @@ void GlitchRemovalFilter::Refresh()
 
 	size_t minwidth = floor(m_parameters[m_minwidthname].GetFloatVal() / cap->m_timescale);
 
+	const size_t minParallelLen = 1024*1024;
 	if (sdin)
 		DoGlitchRemoval(sdin, cap, minwidth);
+
+	//Large uniform input: extract the run list on the GPU if we can, then merge over the (much smaller) run list
+	else if ( (udin->size() >= minParallelLen) && g_gpuFilterEnabled && RunLengthCompactor::IsAvailable() )
+	{
+		SparseDigitalWaveform runs;
+		if (m_compactor.CompactDigital(udin->m_samples, udin->size(), &runs, cmdBuf, queue))
+		{
+			runs.PrepareForCpuAccess();
+			if (runs.size() > 0)
+				DoGlitchRemoval(&runs, cap, minwidth);
+			else
+				cap->Resize(0);
+		}
+		else
+			DoGlitchRemovalUniformParallel(udin, cap, minwidth);
+	}
+
+	else if (udin->size() >= minParallelLen)
+		DoGlitchRemovalUniformParallel(udin, cap, minwidth);
 	else
 		DoGlitchRemoval(udin, cap, minwidth);
 
@@ -30,6 +30,8 @@
 #ifndef GlitchRemovalFilter_h
 #define GlitchRemovalFilter_h
 
+#include "../scopehal/RunLengthCompactor.h"
+
 /**
 	@brief Removes glitches shorter than a specified length from a sparse digital waveform
  */
@@ -38,7 +40,8 @@ class GlitchRemovalFilter : public Filter
 public:
 	GlitchRemovalFilter(const std::string& color);
 
-	virtual void Refresh() override;
+	virtual void Refresh(vk::raii::CommandBuffer& cmdBuf, std::shared_ptr<QueueHandle> queue) override;
+	virtual DataLocation GetInputLocation() override;
 
 	static std::string GetProtocolName();
 
@@ -48,6 +51,8 @@ public:
 
 protected:
 	std::string m_minwidthname;
+
+	RunLengthCompactor m_compactor;
 };
 
 #endif
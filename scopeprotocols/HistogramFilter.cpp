@@ -40,7 +40,9 @@ HistogramFilter::HistogramFilter(const string& color)
 	  m_autorangeName("Autorange?"),
 	  m_minName("Min Value"),
 	  m_maxName("Max Value"),
-	  m_binSizeName("Bin Size")
+	  m_binSizeName("Bin Size"),
+	  m_minmaxComputePipeline("shaders/HistogramMinMax.spv", 2, sizeof(HistogramMinMaxArgs)),
+	  m_histogramComputePipeline("shaders/HistogramFilter.spv", 2, sizeof(HistogramBinArgs))
 {
 	AddStream(Unit(Unit::UNIT_COUNTS_SCI), "data", Stream::STREAM_TYPE_ANALOG);
 
@@ -134,6 +136,16 @@ void HistogramFilter::ClearSweeps()
 }
 
 void HistogramFilter::Refresh()
+{
+	DoRefresh(nullptr, nullptr);
+}
+
+void HistogramFilter::Refresh(vk::raii::CommandBuffer& cmdBuf, shared_ptr<QueueHandle> queue)
+{
+	DoRefresh(&cmdBuf, queue);
+}
+
+void HistogramFilter::DoRefresh(vk::raii::CommandBuffer* cmdBuf, shared_ptr<QueueHandle> queue)
 {
 	//Make sure we've got valid inputs
 	if(!VerifyAllInputsOK())
@@ -142,8 +154,12 @@ void HistogramFilter::Refresh()
 		return;
 	}
 
+	//Bin on the GPU if we can, falling back to the CPU path otherwise
+	bool gpu = (cmdBuf != nullptr) && g_gpuFilterEnabled;
+
 	auto din = GetInputWaveform(0);
-	din->PrepareForCpuAccess();
+	if(!gpu)
+		din->PrepareForCpuAccess();
 	auto sdin = dynamic_cast<SparseAnalogWaveform*>(din);
 	auto udin = dynamic_cast<UniformAnalogWaveform*>(din);
 
@@ -162,8 +178,15 @@ void HistogramFilter::Refresh()
 	m_parameters[m_binSizeName].SetUnit(m_xAxisUnit);
 
 	//Calculate min/max of the input data
-	float nmin = GetMinVoltage(sdin, udin);
-	float nmax = GetMaxVoltage(sdin, udin);
+	float nmin;
+	float nmax;
+	if(gpu)
+		GetMinMaxGpu(sdin, udin, nmin, nmax, *cmdBuf, queue);
+	else
+	{
+		nmin = GetMinVoltage(sdin, udin);
+		nmax = GetMaxVoltage(sdin, udin);
+	}
 	LogTrace("nmin = %s, nmax = %s\n", xunit.PrettyPrint(nmin).c_str(), xunit.PrettyPrint(nmax).c_str());
 
 	//Calculate bin count
@@ -233,7 +256,11 @@ void HistogramFilter::Refresh()
 	LogTrace("Final configuration: %zu bins of %s\n", bins, xunit.PrettyPrint(binsize).c_str());
 
 	//Calculate histogram for our incoming data
-	auto data = MakeHistogram(sdin, udin, m_min, m_max, bins);
+	vector<size_t> data;
+	if(gpu)
+		data = MakeHistogramGpu(sdin, udin, m_min, m_max, bins, *cmdBuf, queue);
+	else
+		data = MakeHistogram(sdin, udin, m_min, m_max, bins);
 
 	//Reallocate the histogram if we changed it
 	if(reallocate)
@@ -275,3 +302,95 @@ void HistogramFilter::Refresh()
 
 	cap->MarkModifiedFromCpu();
 }
+
+/**
+	@brief Finds the min/max of the input on the GPU
+
+	Each workgroup reduces a strided subset of the samples into a partial result, then the handful
+	of per-workgroup partials are reduced on the CPU after readback.
+ */
+void HistogramFilter::GetMinMaxGpu(
+	SparseAnalogWaveform* sdin,
+	UniformAnalogWaveform* udin,
+	float& nmin,
+	float& nmax,
+	vk::raii::CommandBuffer& cmdBuf,
+	shared_ptr<QueueHandle> queue)
+{
+	auto& samples = sdin ? sdin->m_samples : udin->m_samples;
+	samples.PrepareForGpuAccess();
+
+	const uint32_t numGroups = 256;
+	m_minmaxBuf.resize(numGroups * 2);
+	m_minmaxBuf.SetCpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
+	m_minmaxBuf.SetGpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
+
+	HistogramMinMaxArgs args;
+	args.len = samples.size();
+
+	cmdBuf.begin({});
+	m_minmaxComputePipeline.BindBufferNonblocking(0, samples, cmdBuf);
+	m_minmaxComputePipeline.BindBufferNonblocking(1, m_minmaxBuf, cmdBuf, true);
+	m_minmaxComputePipeline.Dispatch(cmdBuf, args, numGroups);
+	cmdBuf.end();
+	queue->SubmitAndBlock(cmdBuf);
+	m_minmaxBuf.MarkModifiedFromGpu();
+
+	//Reduce the per-workgroup partials
+	m_minmaxBuf.PrepareForCpuAccess();
+	nmin = FLT_MAX;
+	nmax = -FLT_MAX;
+	for(uint32_t i=0; i<numGroups; i++)
+	{
+		nmin = min(nmin, m_minmaxBuf[i*2]);
+		nmax = max(nmax, m_minmaxBuf[i*2 + 1]);
+	}
+}
+
+/**
+	@brief Bins the input into a histogram on the GPU
+
+	Each workgroup accumulates into a shared memory histogram, then merges it into the global bins
+	with atomics (bin counts above the shared memory limit fall back to global atomics in the shader).
+ */
+vector<size_t> HistogramFilter::MakeHistogramGpu(
+	SparseAnalogWaveform* sdin,
+	UniformAnalogWaveform* udin,
+	float low,
+	float high,
+	size_t bins,
+	vk::raii::CommandBuffer& cmdBuf,
+	shared_ptr<QueueHandle> queue)
+{
+	auto& samples = sdin ? sdin->m_samples : udin->m_samples;
+	samples.PrepareForGpuAccess();
+
+	//Zero the per-pass bin buffer
+	m_gpuHistBuf.resize(bins);
+	m_gpuHistBuf.SetCpuAccessHint(AcceleratorBuffer<uint32_t>::HINT_LIKELY);
+	m_gpuHistBuf.SetGpuAccessHint(AcceleratorBuffer<uint32_t>::HINT_LIKELY);
+	m_gpuHistBuf.PrepareForCpuAccess();
+	memset(m_gpuHistBuf.GetCpuPointer(), 0, bins * sizeof(uint32_t));
+	m_gpuHistBuf.MarkModifiedFromCpu();
+
+	HistogramBinArgs args;
+	args.len = samples.size();
+	args.nbins = bins;
+	args.vmin = low;
+	args.delta = high - low;
+
+	cmdBuf.begin({});
+	m_histogramComputePipeline.BindBufferNonblocking(0, samples, cmdBuf);
+	m_histogramComputePipeline.BindBufferNonblocking(1, m_gpuHistBuf, cmdBuf);
+	m_histogramComputePipeline.Dispatch(cmdBuf, args, 256);
+	cmdBuf.end();
+	queue->SubmitAndBlock(cmdBuf);
+	m_gpuHistBuf.MarkModifiedFromGpu();
+
+	//Widen the per-pass counts for merging into the persistent histogram
+	m_gpuHistBuf.PrepareForCpuAccess();
+	vector<size_t> ret(bins);
+	for(size_t i=0; i<bins; i++)
+		ret[i] = m_gpuHistBuf[i];
+	return ret;
+}
@@ -35,12 +35,26 @@
 #ifndef HistogramFilter_h
 #define HistogramFilter_h
 
+struct HistogramMinMaxArgs
+{
+	uint32_t len;
+};
+
+struct HistogramBinArgs
+{
+	uint32_t len;
+	uint32_t nbins;
+	float vmin;
+	float delta;
+};
+
 class HistogramFilter : public Filter
 {
 public:
 	HistogramFilter(const std::string& color);
 
 	virtual void Refresh() override;
+	virtual void Refresh(vk::raii::CommandBuffer& cmdBuf, std::shared_ptr<QueueHandle> queue) override;
 
 	static std::string GetProtocolName();
 	virtual void SetDefaultName() override;
@@ -58,6 +72,25 @@ public:
 	PROTOCOL_DECODER_INITPROC(HistogramFilter)
 
 protected:
+	void DoRefresh(vk::raii::CommandBuffer* cmdBuf, std::shared_ptr<QueueHandle> queue);
+
+	void GetMinMaxGpu(
+		SparseAnalogWaveform* sdin,
+		UniformAnalogWaveform* udin,
+		float& nmin,
+		float& nmax,
+		vk::raii::CommandBuffer& cmdBuf,
+		std::shared_ptr<QueueHandle> queue);
+
+	std::vector<size_t> MakeHistogramGpu(
+		SparseAnalogWaveform* sdin,
+		UniformAnalogWaveform* udin,
+		float low,
+		float high,
+		size_t bins,
+		vk::raii::CommandBuffer& cmdBuf,
+		std::shared_ptr<QueueHandle> queue);
+
 	std::string m_autorangeName;
 	std::string m_minName;
 	std::string m_maxName;
@@ -70,6 +103,12 @@ protected:
 	float m_max;
 
 	std::vector<size_t> m_histogram;
+
+	//GPU binning state
+	AcceleratorBuffer<float> m_minmaxBuf;
+	AcceleratorBuffer<uint32_t> m_gpuHistBuf;
+	ComputePipeline m_minmaxComputePipeline;
+	ComputePipeline m_histogramComputePipeline;
 };
 
 #endif
@@ -38,7 +38,10 @@ using namespace std;
 
 HorizontalBathtub::HorizontalBathtub(const string& color)
 	: Filter(color, CAT_ANALYSIS)
+	, m_computePipeline("shaders/HorizontalBathtub.spv", 2, sizeof(HorizontalBathtubShaderArgs))
 {
+	m_densityBuf.SetName("HorizontalBathtub.m_densityBuf");
+
 	AddStream(Unit(Unit::UNIT_LOG_BER), "data", Stream::STREAM_TYPE_ANALOG);
 
 	//Set up channels
@@ -75,6 +78,16 @@ string HorizontalBathtub::GetProtocolName()
 // Actual decoder logic
 
 void HorizontalBathtub::Refresh()
+{
+	DoRefresh(nullptr, nullptr);
+}
+
+void HorizontalBathtub::Refresh(vk::raii::CommandBuffer& cmdBuf, shared_ptr<QueueHandle> queue)
+{
+	DoRefresh(&cmdBuf, queue);
+}
+
+void HorizontalBathtub::DoRefresh(vk::raii::CommandBuffer* cmdBuf, shared_ptr<QueueHandle> queue)
 {
 	if(!VerifyAllInputsOK(true))
 	{
@@ -113,6 +126,42 @@ void HorizontalBathtub::Refresh()
 	auto halflen = len/2;
 	auto quartlen = halflen/2;
 	cap->Resize(halflen);
+
+	//Integrate on the GPU if we can (one ray walk per output column), falling back to the CPU loop otherwise.
+	//BER eyes are a single table lookup per point, so they always take the CPU path.
+	if(cmdBuf && g_gpuFilterEnabled && (din->GetType() == EyeWaveform::EYE_NORMAL))
+	{
+		//The persistent eye accumulator is host side 64-bit counts, so convert to float for the kernel.
+		//Ratios along a ray are what matters for BER, and those survive the narrowing.
+		size_t npix = din->GetWidth() * din->GetHeight();
+		auto accum = din->GetAccumData();
+		m_densityBuf.resize(npix);
+		m_densityBuf.PrepareForCpuAccess();
+		for(size_t i=0; i<npix; i++)
+			m_densityBuf[i] = accum[i];
+		m_densityBuf.MarkModifiedFromCpu();
+
+		HorizontalBathtubShaderArgs args;
+		args.width = din->GetWidth();
+		args.height = din->GetHeight();
+		args.halflen = halflen;
+		args.quartlen = quartlen;
+		args.ybin = ybin;
+		args.xmid = din->GetWidth()/2;
+		args.ymid = din->GetHeight()/2;
+
+		cmdBuf->begin({});
+		m_computePipeline.BindBufferNonblocking(0, m_densityBuf, *cmdBuf);
+		m_computePipeline.BindBufferNonblocking(1, cap->m_samples, *cmdBuf, true);
+		m_computePipeline.Dispatch(*cmdBuf, args, GetComputeBlockCount(halflen, 64));
+		cmdBuf->end();
+		queue->SubmitAndBlock(*cmdBuf);
+
+		SetData(cap, 0);
+		cap->MarkModifiedFromGpu();
+		return;
+	}
+
 	for(size_t i=0; i<halflen; i++)
 	{
 		auto ber = din->GetBERAtPoint(i + quartlen, ybin, din->GetWidth()/2, din->GetHeight()/2);
@@ -35,12 +35,25 @@
 #ifndef HorizontalBathtub_h
 #define HorizontalBathtub_h
 
+///@brief Push constant block for the GPU bathtub path (must match HorizontalBathtub.glsl)
+struct HorizontalBathtubShaderArgs
+{
+	uint32_t width;
+	uint32_t height;
+	uint32_t halflen;
+	uint32_t quartlen;
+	uint32_t ybin;
+	float xmid;
+	float ymid;
+};
+
 class HorizontalBathtub : public Filter
 {
 public:
 	HorizontalBathtub(const std::string& color);
 
 	virtual void Refresh() override;
+	virtual void Refresh(vk::raii::CommandBuffer& cmdBuf, std::shared_ptr<QueueHandle> queue) override;
 
 	static std::string GetProtocolName();
 
@@ -49,7 +62,15 @@ public:
 	PROTOCOL_DECODER_INITPROC(HorizontalBathtub)
 
 protected:
+	void DoRefresh(vk::raii::CommandBuffer* cmdBuf, std::shared_ptr<QueueHandle> queue);
+
 	std::string m_voltageName;
+
+	///@brief Compute pipeline for the GPU integration path
+	ComputePipeline m_computePipeline;
+
+	///@brief Eye density hit counts converted to float for the GPU integration path
+	AcceleratorBuffer<float> m_densityBuf;
 };
 
 #endif
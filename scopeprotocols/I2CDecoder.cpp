@@ -81,176 +81,258 @@ vector<string> I2CDecoder::GetHeaders()
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Actual decoder logic
 
+namespace
+{
+	///@brief Decoder states (named for the symbol currently being built)
+	enum i2c_state : uint8_t
+	{
+		STATE_IDLE,
+		STATE_START,
+		STATE_RESTART,
+		STATE_DATA,
+		STATE_ACK,
+
+		STATE_COUNT
+	};
+
+	///@brief Bus activity observed at one sample point, highest priority first
+	enum i2c_event : uint8_t
+	{
+		EV_START,			//SDA falling with SCL high
+		EV_STOP,			//SDA rising with SCL high
+		EV_SCL_RISE_0,		//SCL rising with SDA low
+		EV_SCL_RISE_1,		//SCL rising with SDA high
+		EV_LINE_RELEASE,	//No edge of interest, but SDA high or SCL low
+		EV_NONE,			//No edge of interest, SDA low and SCL high
+
+		EV_COUNT
+	};
+
+	///@brief Data side effects attached to transitions
+	enum i2c_action : uint8_t
+	{
+		ACT_NONE,
+		ACT_START,		//Begin a start (or restart, depending on the destination state) condition
+		ACT_END_START,	//Finish the start/restart symbol and begin clocking data
+		ACT_STOP,		//Emit a stop symbol and finish the packet
+		ACT_DATA_BIT,	//Clock in one data bit
+		ACT_ACK_BIT		//Emit the ACK/NAK symbol
+	};
+
+	typedef ProtocolStateTable<i2c_state, i2c_event, i2c_action, STATE_COUNT, EV_COUNT> I2CStateTable;
+
+	constexpr I2CStateTable::Rule g_i2cRules[] =
+	{
+		//A start condition following a completed byte is a restart; anything else is a normal start
+		{ STATE_IDLE,		EV_START,			STATE_START,	ACT_START },
+		{ STATE_START,		EV_START,			STATE_START,	ACT_START },
+		{ STATE_RESTART,	EV_START,			STATE_START,	ACT_START },
+		{ STATE_DATA,		EV_START,			STATE_RESTART,	ACT_START },
+		{ STATE_ACK,		EV_START,			STATE_START,	ACT_START },
+
+		//End a start bit when SDA goes high if the first data bit is a 1
+		//Otherwise end on a falling clock edge
+		//(this takes priority over stop conditions, which also drive SDA high)
+		{ STATE_START,		EV_STOP,			STATE_DATA,		ACT_END_START },
+		{ STATE_START,		EV_SCL_RISE_1,		STATE_DATA,		ACT_END_START },
+		{ STATE_START,		EV_LINE_RELEASE,	STATE_DATA,		ACT_END_START },
+		{ STATE_RESTART,	EV_STOP,			STATE_DATA,		ACT_END_START },
+		{ STATE_RESTART,	EV_SCL_RISE_1,		STATE_DATA,		ACT_END_START },
+		{ STATE_RESTART,	EV_LINE_RELEASE,	STATE_DATA,		ACT_END_START },
+
+		//Stop conditions emit a symbol but leave the decode state alone
+		//(so a start after stop-during-data still reads as a restart, matching the old if/else chain)
+		{ STATE_IDLE,		EV_STOP,			STATE_IDLE,		ACT_STOP },
+		{ STATE_DATA,		EV_STOP,			STATE_DATA,		ACT_STOP },
+		{ STATE_ACK,		EV_STOP,			STATE_ACK,		ACT_STOP },
+
+		//Rising SCL edges clock in data and ACK/NAK bits
+		//(ACT_DATA_BIT overrides the destination to STATE_ACK once eight bits have been shifted in)
+		{ STATE_DATA,		EV_SCL_RISE_0,		STATE_DATA,		ACT_DATA_BIT },
+		{ STATE_DATA,		EV_SCL_RISE_1,		STATE_DATA,		ACT_DATA_BIT },
+		{ STATE_ACK,		EV_SCL_RISE_0,		STATE_DATA,		ACT_ACK_BIT },
+		{ STATE_ACK,		EV_SCL_RISE_1,		STATE_DATA,		ACT_ACK_BIT }
+	};
+
+	constexpr I2CStateTable g_i2cTable(g_i2cRules, ACT_NONE);
+}
+
 template<class T, class U>
 void I2CDecoder::InnerLoop(T* sda, U* scl, I2CWaveform* cap)
 {
 	Packet* pack = nullptr;
 
 	//Loop over the data and look for transactions
-	bool				last_scl = true;
-	bool 				last_sda = true;
-	int64_t				tstart	= 0;
-	I2CSymbol::stype	current_type = I2CSymbol::TYPE_ERROR;
-	uint8_t				current_byte = 0;
-	uint8_t				bitcount = 0;
-	bool				last_was_start	= 0;
-	size_t				sdalen = sda->size();
-	size_t 				scllen = scl->size();
-	size_t 				isda = 0;
-	size_t 				iscl = 0;
-	int64_t 			timestamp	= 0;
+	bool		last_scl = true;
+	bool 		last_sda = true;
+	int64_t		tstart	= 0;
+	i2c_state	state = STATE_IDLE;
+	uint8_t		current_byte = 0;
+	uint8_t		bitcount = 0;
+	bool		last_was_start	= 0;
+	size_t		sdalen = sda->size();
+	size_t 		scllen = scl->size();
+	size_t 		isda = 0;
+	size_t 		iscl = 0;
+	int64_t 	timestamp	= 0;
 
 	while(true)
 	{
 		bool cur_sda = sda->m_samples[isda];
 		bool cur_scl = scl->m_samples[iscl];
 
-		//SDA falling with SCL high is beginning of a start condition
+		//Classify the bus activity at this sample point into an event
+		i2c_event ev;
 		if(!cur_sda && last_sda && cur_scl)
+			ev = EV_START;
+		else if(cur_sda && !last_sda && cur_scl)
+			ev = EV_STOP;
+		else if(cur_scl && !last_scl)
+			ev = cur_sda ? EV_SCL_RISE_1 : EV_SCL_RISE_0;
+		else if(cur_sda || !cur_scl)
+			ev = EV_LINE_RELEASE;
+		else
+			ev = EV_NONE;
+
+		//Look up the transition and run the attached action
+		auto& entry = g_i2cTable(state, ev);
+		auto next = static_cast<i2c_state>(entry.next);
+		switch(entry.action)
 		{
-			LogTrace("found i2c start at time %" PRId64 "\n", timestamp);
+			//Start (or restart) condition
+			case ACT_START:
+				LogTrace("found i2c start at time %" PRId64 "\n", timestamp);
+
+				//If we're following an ACK, this is a restart
+				if(next == STATE_RESTART)
+				{
+					//Finish existing packet, if we have one
+					if(pack)
+					{
+						pack->m_len = timestamp - pack->m_offset;
+						pack->m_headers["Len"] = to_string(pack->m_data.size());
+						m_packets.push_back(pack);
+						pack = nullptr;
+					}
+				}
 
-			//If we're following an ACK, this is a restart
-			if(current_type == I2CSymbol::TYPE_DATA)
-			{
-				current_type = I2CSymbol::TYPE_RESTART;
+				//Otherwise, regular start
+				else
+					tstart = timestamp;
 
-				//Finish existing packet, if we have one
+				//Create a new packet. If we already have an incomplete one that got aborted, reset it
 				if(pack)
 				{
-					pack->m_len = timestamp - pack->m_offset;
-					pack->m_headers["Len"] = to_string(pack->m_data.size());
-					m_packets.push_back(pack);
-					pack = nullptr;
+					pack->m_data.clear();
+					pack->m_headers.clear();
 				}
-			}
+				else
+					pack = new Packet;
+				pack->m_offset = timestamp;
+				pack->m_len = 0;
+				break;
+
+			//End of the start bit
+			case ACT_END_START:
+				cap->m_offsets.push_back(tstart);
+				cap->m_durations.push_back(timestamp - tstart);
+				cap->m_samples.push_back(I2CSymbol(
+					(state == STATE_RESTART) ? I2CSymbol::TYPE_RESTART : I2CSymbol::TYPE_START, 0));
 
-			//Otherwise, regular start
-			else
-			{
+				last_was_start	= true;
 				tstart = timestamp;
-				current_type = I2CSymbol::TYPE_START;
-			}
-
-			//Create a new packet. If we already have an incomplete one that got aborted, reset it
-			if(pack)
-			{
-				pack->m_data.clear();
-				pack->m_headers.clear();
-			}
-			else
-				pack = new Packet;
-			pack->m_offset = timestamp;
-			pack->m_len = 0;
-		}
-
-		//End a start bit when SDA goes high if the first data bit is a 1
-		//Otherwise end on a falling clock edge
-		else if( ((current_type == I2CSymbol::TYPE_START) || (current_type == I2CSymbol::TYPE_RESTART)) &&
-				(cur_sda || !cur_scl) )
-		{
-			cap->m_offsets.push_back(tstart);
-			cap->m_durations.push_back(timestamp - tstart);
-			cap->m_samples.push_back(I2CSymbol(current_type, 0));
-
-			last_was_start	= true;
-			current_type = I2CSymbol::TYPE_DATA;
-			tstart = timestamp;
-			bitcount = 0;
-			current_byte = 0;
-		}
+				bitcount = 0;
+				current_byte = 0;
+				break;
 
-		//SDA rising with SCL high is a stop condition
-		else if(cur_sda && !last_sda && cur_scl)
-		{
-			LogTrace("found i2c stop at time %" PRIx64 "\n", timestamp);
+			//Stop condition
+			case ACT_STOP:
+				LogTrace("found i2c stop at time %" PRIx64 "\n", timestamp);
 
-			cap->m_offsets.push_back(tstart);
-			cap->m_durations.push_back(timestamp - tstart);
-			cap->m_samples.push_back(I2CSymbol(I2CSymbol::TYPE_STOP, 0));
-
-			last_was_start	= false;
+				cap->m_offsets.push_back(tstart);
+				cap->m_durations.push_back(timestamp - tstart);
+				cap->m_samples.push_back(I2CSymbol(I2CSymbol::TYPE_STOP, 0));
 
-			tstart = timestamp;
+				last_was_start	= false;
 
-			//Finish existing packet, if we have one
-			if(pack)
-			{
-				pack->m_len = timestamp - pack->m_offset;
-				pack->m_headers["Len"] = to_string(pack->m_data.size());
-				m_packets.push_back(pack);
-				pack = nullptr;
-			}
-		}
+				tstart = timestamp;
 
-		//On a rising SCL edge, end the current bit
-		else if(cur_scl && !last_scl)
-		{
-			if(current_type == I2CSymbol::TYPE_DATA)
-			{
-				//Save the current data bit
-				bitcount ++;
-				current_byte = (current_byte << 1);
-				if(cur_sda)
-					current_byte |= 1;
-
-				//Add a sample if the byte is over
-				if(bitcount == 8)
+				//Finish existing packet, if we have one
+				if(pack)
 				{
-					int64_t this_len = timestamp - tstart;
+					pack->m_len = timestamp - pack->m_offset;
+					pack->m_headers["Len"] = to_string(pack->m_data.size());
+					m_packets.push_back(pack);
+					pack = nullptr;
+				}
+				break;
 
-					if(last_was_start)
+			//Rising SCL edge in the middle of a byte
+			case ACT_DATA_BIT:
+				{
+					//Save the current data bit
+					bitcount ++;
+					current_byte = (current_byte << 1);
+					if(cur_sda)
+						current_byte |= 1;
+
+					//Add a sample if the byte is over
+					if(bitcount == 8)
 					{
-						//If the start bit was insanely long, shorten it
-						size_t nlast = cap->m_offsets.size() - 1;
-						if(cap->m_durations[nlast] > 3*this_len)
-						{
-							int64_t tend = cap->m_offsets[nlast] + cap->m_durations[nlast];
-							cap->m_durations[nlast] = this_len;
-							cap->m_offsets[nlast] = tend - this_len;
-						}
-
-						cap->m_samples.push_back(I2CSymbol(I2CSymbol::TYPE_ADDRESS, current_byte));
+						int64_t this_len = timestamp - tstart;
 
-						if(pack)
+						if(last_was_start)
 						{
-							pack->m_headers["Address"] = to_string_hex(current_byte & 0xfe);
-							if(current_byte & 1)
+							//If the start bit was insanely long, shorten it
+							size_t nlast = cap->m_offsets.size() - 1;
+							if(cap->m_durations[nlast] > 3*this_len)
 							{
-								pack->m_headers["Op"] = "Read";
-								pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_DATA_READ];
+								int64_t tend = cap->m_offsets[nlast] + cap->m_durations[nlast];
+								cap->m_durations[nlast] = this_len;
+								cap->m_offsets[nlast] = tend - this_len;
 							}
-							else
+
+							cap->m_samples.push_back(I2CSymbol(I2CSymbol::TYPE_ADDRESS, current_byte));
+
+							if(pack)
 							{
-								pack->m_headers["Op"] = "Write";
-								pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_DATA_WRITE];
+								pack->m_headers["Address"] = to_string_hex(current_byte & 0xfe);
+								if(current_byte & 1)
+								{
+									pack->m_headers["Op"] = "Read";
+									pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_DATA_READ];
+								}
+								else
+								{
+									pack->m_headers["Op"] = "Write";
+									pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_DATA_WRITE];
+								}
 							}
 						}
-					}
-					else
-					{
-						cap->m_samples.push_back(I2CSymbol(I2CSymbol::TYPE_DATA, current_byte));
+						else
+						{
+							cap->m_samples.push_back(I2CSymbol(I2CSymbol::TYPE_DATA, current_byte));
 
-						if(pack)
-							pack->m_data.push_back(current_byte);
-					}
+							if(pack)
+								pack->m_data.push_back(current_byte);
+						}
 
-					cap->m_offsets.push_back(tstart);
-					cap->m_durations.push_back(this_len);
+						cap->m_offsets.push_back(tstart);
+						cap->m_durations.push_back(this_len);
 
-					last_was_start	= false;
+						last_was_start	= false;
 
-					bitcount = 0;
-					current_byte = 0;
-					tstart = timestamp;
+						bitcount = 0;
+						current_byte = 0;
+						tstart = timestamp;
 
-					current_type = I2CSymbol::TYPE_ACK;
+						next = STATE_ACK;
+					}
 				}
-			}
+				break;
 
 			//ACK/NAK
-			else if(current_type == I2CSymbol::TYPE_ACK)
-			{
+			case ACT_ACK_BIT:
 				cap->m_offsets.push_back(tstart);
 				cap->m_durations.push_back(timestamp - tstart);
 				cap->m_samples.push_back(I2CSymbol(I2CSymbol::TYPE_ACK, cur_sda));
@@ -258,9 +340,12 @@ void I2CDecoder::InnerLoop(T* sda, U* scl, I2CWaveform* cap)
 				last_was_start	= false;
 
 				tstart = timestamp;
-				current_type = I2CSymbol::TYPE_DATA;
-			}
+				break;
+
+			default:
+				break;
 		}
+		state = next;
 
 		//Save old state of both pins
 		last_sda = cur_sda;
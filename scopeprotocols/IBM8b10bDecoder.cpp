@@ -86,70 +86,13 @@ string IBM8b10bDecoder::GetProtocolName()
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-// Actual decoder logic
+// Batch decode core
 
-void IBM8b10bDecoder::Refresh()
+///@brief Precomputed decode of all 1024 possible 10-bit codewords
+struct IBM8b10bCodeTable
 {
-	LogTrace("IBM8b10bDecoder::Refresh\n");
-	LogIndenter li;
-
-	if(!VerifyAllInputsOK())
-	{
-		SetData(NULL, 0);
-		return;
-	}
-
-	//Get the input data
-	auto din = GetInputWaveform(0);
-	auto clkin = GetInputWaveform(1);
-	din->PrepareForCpuAccess();
-	clkin->PrepareForCpuAccess();
-
-	//Create the capture
-	auto cap = new IBM8b10bWaveform(m_parameters[m_displayformat]);
-	cap->m_timescale = 1;
-	cap->m_startTimestamp = din->m_startTimestamp;
-	cap->m_startFemtoseconds = din->m_startFemtoseconds;
-	cap->PrepareForCpuAccess();
-
-	//Record the value of the data stream at each clock edge
-	//TODO: allow single rate clocks too?
-	SparseDigitalWaveform data;
-	SparseDigitalWaveform wsquelch;
-	SampleOnAnyEdgesBase(din, clkin, data);
-	data.PrepareForCpuAccess();
-
-	//Decode the actual data
-	int last_disp = -1;
-	bool first = true;
-	size_t dlen = data.m_samples.size() - 11;
-	int64_t lastSymbolLength = 0;
-	int64_t lastSymbolEnd = 0;
-	int64_t lastSymbolStart = 0;
-	for(size_t i=0; i<dlen;i+=10)
+	IBM8b10bCodeTable()
 	{
-		//Re-synchronize at start of waveform or if squelch is reopening
-		//If we have a gap
-		if(i == 0)
-			first = true;
-		if( (data.m_offsets[i] - lastSymbolEnd) > 3*lastSymbolLength)
-			first = true;
-		if(first)
-		{
-			LogTrace("Realigning at t=%s\n", Unit(Unit::UNIT_FS).PrettyPrint(data.m_offsets[i]).c_str());
-			Align(data, i);
-		}
-
-		//5b/6b decode
-
-		uint8_t code6 =
-			(data.m_samples[i+0] ? 32 : 0) |
-			(data.m_samples[i+1] ? 16 : 0) |
-			(data.m_samples[i+2] ? 8 : 0) |
-			(data.m_samples[i+3] ? 4 : 0) |
-			(data.m_samples[i+4] ? 2 : 0) |
-			(data.m_samples[i+5] ? 1 : 0);
-
 		static const int code5_table[64] =
 		{
 			 0,  0,  0,  0,  0, 23,  8,  7,	//00-07
@@ -198,18 +141,6 @@ void IBM8b10bDecoder::Refresh()
 			false, false, false, false, false, false, false, false  //38-3f
 		};
 
-		int code5 = code5_table[code6];
-		int disp5 = disp5_table[code6];
-		bool err5 = err5_table[code6];
-		bool ctl5 = ctl5_table[code6];
-
-		//3b/4b decode
-		uint8_t code4 =
-			(data.m_samples[i+6] ? 8 : 0) |
-			(data.m_samples[i+7] ? 4 : 0) |
-			(data.m_samples[i+8] ? 2 : 0) |
-			(data.m_samples[i+9] ? 1 : 0);
-
 		static const bool err3_ctl_table[16] =
 		{
 			 true,  true, false, false, false, false, false, false,
@@ -247,83 +178,229 @@ void IBM8b10bDecoder::Refresh()
 		};
 
 		//true only for Dx.A7
-		const bool alt3_table[16] =
+		static const bool alt3_table[16] =
 		{
 			0, 0, 0, 0, 0, 0, 0, 1,
 			1, 0, 0, 0, 0, 0, 0, 0
 		};
 
-		int code3 = false;
-		int disp3 = 0;
-		int err3 = false;
-		if(ctl5)
+		for(unsigned int code10 = 0; code10 < 1024; code10 ++)
 		{
-			if(disp5 >= 0)
-				code3 = code3_pos_ctl_table[code4];
+			//5b/6b decode
+			uint8_t code6 = code10 >> 4;
+			int code5 = code5_table[code6];
+			int disp5 = disp5_table[code6];
+			bool err5 = err5_table[code6];
+			bool ctl5 = ctl5_table[code6];
+
+			//3b/4b decode
+			uint8_t code4 = code10 & 0xf;
+			int code3;
+			bool err3;
+			if(ctl5)
+			{
+				if(disp5 >= 0)
+					code3 = code3_pos_ctl_table[code4];
+				else
+					code3 = code3_neg_ctl_table[code4];
+				err3 = err3_ctl_table[code4];
+			}
 			else
-				code3 = code3_neg_ctl_table[code4];
-			err3 = err3_ctl_table[code4];
-		}
-		else
-		{
-			code3 = code3_table[code4];
-			err3 = err3_table[code4];
-		}
-		disp3 = disp3_table[code4];
+			{
+				code3 = code3_table[code4];
+				err3 = err3_table[code4];
+			}
+			int disp3 = disp3_table[code4];
 
-		//Disparity tracking
-		int total_disp = disp3 + disp5;
-		if(first)
-		{
-			if(total_disp < 0)
-				last_disp = 1;
-			else
-				last_disp = -1;
-			first = false;
+			//Special processing for a few control codes that use the .A7 format
+			if(alt3_table[code4])
+			{
+				if( (code5 == 23) || (code5 == 27) || (code5 == 29) || (code5 == 30) )
+					ctl5 = true;
+			}
+
+			auto& e = m_entries[code10];
+			e.m_data = (code3 << 5) | code5;
+			e.m_disparity = disp5 + disp3;
+			e.m_control = ctl5;
+			e.m_error5 = err5;
+			e.m_error3 = err3;
 		}
+	}
+
+	IBM8b10bDecoder::CodewordInfo m_entries[1024];
+};
+
+///@brief Returns the codeword table, building it on first use (so library load doesn't pay for it)
+static const IBM8b10bCodeTable& GetCodeTable()
+{
+	static IBM8b10bCodeTable table;
+	return table;
+}
+
+/**
+	@brief Looks up the decode of a single 10-bit codeword (MSB first, i.e. "abcdei fghj" transmission order)
+ */
+const IBM8b10bDecoder::CodewordInfo& IBM8b10bDecoder::LookupCodeword(uint16_t code10)
+{
+	return GetCodeTable().m_entries[code10 & 0x3ff];
+}
+
+/**
+	@brief Decodes a block of consecutive symbols from a bitstream in a single pass
+
+	@param bits				Input bits in transmission order, 10 per symbol, already comma aligned
+	@param numSymbols		Number of symbols to decode
+	@param runningDisparity	Running disparity state (+1 / -1), carried across calls.
+							Pass 0 if unknown; it will be inferred from the first symbol.
+	@param symbols			Output buffer with space for numSymbols decoded symbols
+ */
+void IBM8b10bDecoder::DecodeSymbolBatch(
+	const bool* bits,
+	size_t numSymbols,
+	int& runningDisparity,
+	IBM8b10bSymbol* symbols)
+{
+	auto& table = GetCodeTable();
+
+	for(size_t n=0; n<numSymbols; n++)
+	{
+		const bool* p = bits + n*10;
+		uint16_t code10 =
+			(p[0] ? 512 : 0) |
+			(p[1] ? 256 : 0) |
+			(p[2] ? 128 : 0) |
+			(p[3] ? 64 : 0) |
+			(p[4] ? 32 : 0) |
+			(p[5] ? 16 : 0) |
+			(p[6] ? 8 : 0) |
+			(p[7] ? 4 : 0) |
+			(p[8] ? 2 : 0) |
+			(p[9] ? 1 : 0);
+		auto& e = table.m_entries[code10];
+
+		//If the caller doesn't know the running disparity, infer it from the first symbol
+		if(runningDisparity == 0)
+			runningDisparity = (e.m_disparity < 0) ? 1 : -1;
 
+		//Disparity tracking
 		bool disperr = false;
-		if(total_disp > 0 && last_disp > 0)
-		{
+		if( (e.m_disparity > 0) && (runningDisparity > 0) )
 			disperr = true;
-			last_disp = 1;
-		}
-		else if(total_disp < 0 && last_disp < 0)
-		{
+		else if( (e.m_disparity < 0) && (runningDisparity < 0) )
 			disperr = true;
-			last_disp = -1;
-		}
 		else
-			last_disp += total_disp;
+			runningDisparity += e.m_disparity;
+
+		symbols[n] = IBM8b10bSymbol(e.m_control, e.m_error5, e.m_error3, disperr, e.m_data, runningDisparity);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Actual decoder logic
+
+void IBM8b10bDecoder::Refresh()
+{
+	LogTrace("IBM8b10bDecoder::Refresh\n");
+	LogIndenter li;
+
+	if(!VerifyAllInputsOK())
+	{
+		SetData(NULL, 0);
+		return;
+	}
 
-		//Special processing for a few control codes that use the .A7 format
-		bool alt = alt3_table[code4];
-		if(alt)
+	//Get the input data
+	auto din = GetInputWaveform(0);
+	auto clkin = GetInputWaveform(1);
+	din->PrepareForCpuAccess();
+	clkin->PrepareForCpuAccess();
+
+	//Create the capture
+	auto cap = new IBM8b10bWaveform(m_parameters[m_displayformat]);
+	cap->m_timescale = 1;
+	cap->m_startTimestamp = din->m_startTimestamp;
+	cap->m_startFemtoseconds = din->m_startFemtoseconds;
+	cap->PrepareForCpuAccess();
+
+	//Record the value of the data stream at each clock edge
+	//TODO: allow single rate clocks too?
+	SparseDigitalWaveform data;
+	SparseDigitalWaveform wsquelch;
+	SampleOnAnyEdgesBase(din, clkin, data);
+	data.PrepareForCpuAccess();
+
+	//Decode the actual data
+	int runningDisparity = 0;
+	bool first = true;
+	size_t dlen = data.m_samples.size() - 11;
+	int64_t lastSymbolLength = 0;
+	int64_t lastSymbolEnd = 0;
+	int64_t lastSymbolStart = 0;
+	size_t i = 0;
+	while(i < dlen)
+	{
+		//Re-synchronize at start of waveform or if squelch is reopening
+		if(first)
 		{
-			if( (code5 == 23) || (code5 == 27) || (code5 == 29) || (code5 == 30) )
-				ctl5 = true;
+			LogTrace("Realigning at t=%s\n", Unit(Unit::UNIT_FS).PrettyPrint(data.m_offsets[i]).c_str());
+			Align(data, i);
+			runningDisparity = 0;
+			first = false;
 		}
 
-		//Horizontally shift the decoded symbol back by half a UI
-		//since the recovered clock edge is in the middle of the UI.
-		//We want the decoded signal boundaries to line up with the data edge, not the middle of the UI.
-		auto symbolStart = data.m_offsets[i] - data.m_durations[i]/2;
-		auto symbolLength = data.m_offsets[i+10] - data.m_offsets[i];
-		if( (symbolStart - lastSymbolStart) > 5*symbolLength)
+		//Scan ahead (looking only at the clock edge timestamps) to find how many symbols we can decode before
+		//a gap in the data forces a resync, pushing symbol boundaries as we go. This keeps all of the
+		//data-dependent work out of the decode loop below, which becomes a straight pass over the bits.
+		size_t numSymbols = 0;
+		size_t numConsumed = 0;
+		size_t outbase = cap->m_samples.size();
+		while( (i + numConsumed) < dlen )
 		{
-			LogTrace("Sync lost (big gap)\n");
-			first = true;
+			size_t j = i + numConsumed;
+
+			//A gap before this symbol means it's the start of a new burst, so resync there
+			if( (numConsumed > 0) && ( (data.m_offsets[j] - lastSymbolEnd) > 3*lastSymbolLength ) )
+			{
+				first = true;
+				break;
+			}
+
+			//Horizontally shift the decoded symbol back by half a UI
+			//since the recovered clock edge is in the middle of the UI.
+			//We want the decoded signal boundaries to line up with the data edge, not the middle of the UI.
+			auto symbolStart = data.m_offsets[j] - data.m_durations[j]/2;
+			auto symbolLength = data.m_offsets[j+10] - data.m_offsets[j];
+			bool gap = (symbolStart - lastSymbolStart) > 5*symbolLength;
+
+			if(!gap)
+			{
+				cap->m_offsets.push_back(symbolStart);
+				cap->m_durations.push_back(lastSymbolLength);
+				numSymbols ++;
+			}
+			numConsumed += 10;
+
+			lastSymbolLength = symbolLength;
+			lastSymbolEnd = symbolStart + lastSymbolEnd;
+			lastSymbolStart = symbolStart;
+
+			if(gap)
+			{
+				LogTrace("Sync lost (big gap)\n");
+				first = true;
+				break;
+			}
 		}
-		else
+
+		//Decode the whole run in one pass
+		if(numSymbols)
 		{
-			cap->m_offsets.push_back(symbolStart);
-			cap->m_durations.push_back(lastSymbolLength);
-			cap->m_samples.push_back(IBM8b10bSymbol(ctl5, err5, err3, disperr, (code3 << 5) | code5, last_disp));
+			cap->m_samples.resize(outbase + numSymbols);
+			DecodeSymbolBatch(&data.m_samples[i], numSymbols, runningDisparity, &cap->m_samples[outbase]);
 		}
 
-		lastSymbolLength = symbolLength;
-		lastSymbolEnd = symbolStart + lastSymbolEnd;
-		lastSymbolStart = symbolStart;
+		i += numConsumed;
 	}
 
 	SetData(cap, 0);
@@ -98,6 +98,33 @@ public:
 		FORMAT_HEX
 	};
 
+	///@brief Precomputed decode of a single 10-bit codeword
+	struct CodewordInfo
+	{
+		///@brief Decoded data value (3b field in the high bits, 5b field in the low bits)
+		uint8_t m_data;
+
+		///@brief Change in running disparity caused by this codeword (-2, 0, or +2)
+		int8_t m_disparity;
+
+		///@brief True if this is a control (K) character
+		bool m_control;
+
+		///@brief True if the 5b/6b block is not a legal codeword
+		bool m_error5;
+
+		///@brief True if the 3b/4b block is not a legal codeword
+		bool m_error3;
+	};
+
+	static const CodewordInfo& LookupCodeword(uint16_t code10);
+
+	static void DecodeSymbolBatch(
+		const bool* bits,
+		size_t numSymbols,
+		int& runningDisparity,
+		IBM8b10bSymbol* symbols);
+
 	PROTOCOL_DECODER_INITPROC(IBM8b10bDecoder)
 
 protected:
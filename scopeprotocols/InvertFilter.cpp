@@ -64,6 +64,13 @@ string InvertFilter::GetProtocolName()
 	return "Invert";
 }
 
+bool InvertFilter::GetElementwiseOperation(ElementwiseOperation& op)
+{
+	op.m_op = ElementwiseOperation::OP_MULTIPLY;
+	op.m_operand = -1;
+	return true;
+}
+
 void InvertFilter::SetDefaultName()
 {
 	char hwname[256];
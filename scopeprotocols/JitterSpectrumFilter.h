@@ -46,6 +46,10 @@ public:
 	virtual void Refresh(vk::raii::CommandBuffer& cmdBuf, std::shared_ptr<QueueHandle> queue) override;
 	virtual DataLocation GetInputLocation() override;
 
+	//Jitter spectrum does nontrivial preprocessing in Refresh(), so it can't share FFTFilter's batched path
+	virtual std::string GetBatchKey() override
+	{ return ""; }
+
 	virtual bool ValidateChannel(size_t i, StreamDescriptor stream) override;
 
 	static std::string GetProtocolName();
@@ -79,20 +79,37 @@ void MaximumFilter::Refresh(vk::raii::CommandBuffer& /*cmdBuf*/, shared_ptr<Queu
 		auto data = din.GetData();
 		auto udata = dynamic_cast<UniformAnalogWaveform*>(data);
 		auto sdata = dynamic_cast<SparseAnalogWaveform*>(data);
-		float total = -FLT_MAX;
 		size_t len = data->size();
 
+		//If this is the same waveform object we scanned last time and it has only appended samples since then
+		//(streaming trend buffers advertise this via m_dirtyStart), only scan the new tail
+		size_t start = 0;
+		float total = -FLT_MAX;
+		if( (data == m_cachedData) &&
+			(data->m_revision == (m_cachedRevision + 1)) &&
+			(data->m_dirtyStart == m_cachedLen) &&
+			(len >= m_cachedLen) )
+		{
+			start = m_cachedLen;
+			total = m_cachedTotal;
+		}
+
 		if(udata)
 		{
-			for(auto sample : udata->m_samples)
-				total = max(total, sample);
+			for(size_t i=start; i<len; i++)
+				total = max(total, udata->m_samples[i]);
 		}
 		else if(sdata)
 		{
-			for(auto sample : sdata->m_samples)
-				total = max(total, sample);
+			for(size_t i=start; i<len; i++)
+				total = max(total, sdata->m_samples[i]);
 		}
 
+		m_cachedData = data;
+		m_cachedRevision = data->m_revision;
+		m_cachedLen = len;
+		m_cachedTotal = total;
+
 		m_streams[0].m_value = total;
 		m_streams[1].m_value = max((double)total, m_streams[1].m_value);
 		m_streams[2].m_value += len;
@@ -134,4 +151,9 @@ void MaximumFilter::ClearSweeps()
 	m_streams[1].m_value = -FLT_MAX;
 	m_streams[2].m_value = 0;
 	m_streams[3].m_value = 0;
+
+	m_cachedData = nullptr;
+	m_cachedRevision = 0;
+	m_cachedLen = 0;
+	m_cachedTotal = -FLT_MAX;
 }
@@ -51,6 +51,19 @@ public:
 	virtual void ClearSweeps() override;
 
 	PROTOCOL_DECODER_INITPROC(MaximumFilter)
+
+protected:
+	///@brief Input waveform object the incremental-scan cache below refers to
+	WaveformBase* m_cachedData;
+
+	///@brief Revision of m_cachedData as of the last scan
+	uint64_t m_cachedRevision;
+
+	///@brief Length of m_cachedData as of the last scan
+	size_t m_cachedLen;
+
+	///@brief Maximum over all samples currently in m_cachedData
+	float m_cachedTotal;
 };
 
 #endif
@@ -68,6 +68,19 @@ string MultiplyFilter::GetProtocolName()
 	return "Multiply";
 }
 
+bool MultiplyFilter::GetElementwiseOperation(ElementwiseOperation& op)
+{
+	//Only the scalar * vector configuration is a simple elementwise transform
+	bool veca = GetInput(0).GetType() == Stream::STREAM_TYPE_ANALOG;
+	bool vecb = GetInput(1).GetType() == Stream::STREAM_TYPE_ANALOG;
+	if(veca == vecb)
+		return false;
+
+	op.m_op = ElementwiseOperation::OP_MULTIPLY;
+	op.m_operand = GetInput(veca ? 1 : 0).GetScalarValue();
+	return true;
+}
+
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Actual decoder logic
 
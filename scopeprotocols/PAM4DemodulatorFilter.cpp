@@ -110,22 +110,16 @@ void PAM4DemodulatorFilter::Refresh()
 		m_parameters[m_upperThreshName].GetFloatVal()
 	};
 
-	//Create the captures
-	auto dcap = new SparseDigitalWaveform;
+	//Create the captures (reusing the previous trigger's allocations when possible)
+	auto dcap = SetupEmptySparseDigitalOutputWaveform(din, 0);
 	dcap->m_timescale = 1;
-	dcap->m_startTimestamp = din->m_startTimestamp;
-	dcap->m_startFemtoseconds = din->m_startFemtoseconds;
 	dcap->m_triggerPhase = 0;
 	dcap->PrepareForCpuAccess();
-	SetData(dcap, 0);
 
-	auto ccap = new SparseDigitalWaveform;
+	auto ccap = SetupEmptySparseDigitalOutputWaveform(din, 1);
 	ccap->m_timescale = 1;
-	ccap->m_startTimestamp = din->m_startTimestamp;
-	ccap->m_startFemtoseconds = din->m_startFemtoseconds;
 	ccap->m_triggerPhase = 0;
 	ccap->PrepareForCpuAccess();
-	SetData(ccap, 1);
 
 	//Decode the input data, one symbol (two output bits) at a time
 	dcap->Resize(len*2);
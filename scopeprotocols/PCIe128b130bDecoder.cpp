@@ -263,20 +263,41 @@ string PCIe128b130bWaveform::GetText(size_t i)
 	return ret;
 }
 
-uint8_t PCIe128b130bDecoder::RunScrambler(uint32_t& state)
+///@brief Per-byte state advance and keystream tables for the 128b/130b scrambler (x^23 + x^21 + x^16 + x^8 + x^5 + x^2 + 1)
+static struct Scrambler23Tables
 {
-	uint8_t ret = 0;
-
-	for(int j=0; j<8; j++)
+	Scrambler23Tables()
 	{
-		bool b22 = (state & 0x400000);
-		state <<= 1;
-		if(b22)
+		for(uint32_t i=0; i<256; i++)
 		{
-			state ^= 0x210125;
-			ret |= (1 << j);
+			//Run the reference bit-serial LFSR for eight steps on a state with only the tap window set
+			uint32_t state = i << 15;
+			uint8_t out = 0;
+			for(int j=0; j<8; j++)
+			{
+				bool b22 = (state & 0x400000);
+				state <<= 1;
+				if(b22)
+				{
+					state ^= 0x210125;
+					out |= (1 << j);
+				}
+			}
+
+			//The update is linear, so the contribution of the low state bits is a plain shift
+			//and everything that depends on the tap window lives in the table
+			m_advance[i] = state ^ (i << 23);
+			m_output[i] = out;
 		}
 	}
 
-	return ret;
+	uint32_t m_advance[256];
+	uint8_t m_output[256];
+} g_scrambler23Tables;
+
+uint8_t PCIe128b130bDecoder::RunScrambler(uint32_t& state)
+{
+	uint8_t idx = (state >> 15) & 0xff;
+	state = (state << 8) ^ g_scrambler23Tables.m_advance[idx];
+	return g_scrambler23Tables.m_output[idx];
 }
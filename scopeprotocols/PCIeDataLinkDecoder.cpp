@@ -122,6 +122,12 @@ void PCIeDataLinkDecoder::Refresh()
 
 	size_t len = data->m_samples.size();
 
+	//Upper bound on output size is one sample per input sample
+	//(idle gaps between packets are already merged into spanning symbols by the logical layer)
+	cap->m_offsets.reserve(len);
+	cap->m_durations.reserve(len);
+	cap->m_samples.reserve(len);
+
 	uint8_t dllp_type = 0;
 	uint8_t dllp_data[3] = {0};
 
@@ -899,9 +899,23 @@ void PCIeTransportDecoder::Refresh()
 				//TODO: complain if we have more data than we should have
 				else
 				{
-					cap->m_offsets.push_back(off);
-					cap->m_durations.push_back(dur);
-					cap->m_samples.push_back(PCIeTransportSymbol(PCIeTransportSymbol::TYPE_DATA, sym.m_data));
+					//Describe the whole payload region with a single spanning symbol rather than duplicating
+					//one sample per byte. The per-byte view already exists in the data link layer's buffer,
+					//and the byte values are saved in the packet for the protocol analyzer.
+					if( cap->m_samples.size() &&
+						(cap->m_samples[ilast].m_type == PCIeTransportSymbol::TYPE_DATA) )
+					{
+						cap->m_durations[ilast] = end - cap->m_offsets[ilast];
+						cap->m_samples[ilast].m_data ++;
+					}
+
+					//First payload byte, make the descriptor
+					else
+					{
+						cap->m_offsets.push_back(off);
+						cap->m_durations.push_back(dur);
+						cap->m_samples.push_back(PCIeTransportSymbol(PCIeTransportSymbol::TYPE_DATA, 1));
+					}
 
 					pack->m_data.push_back(sym.m_data);
 				}
@@ -1010,7 +1024,7 @@ string PCIeTransportWaveform::GetText(size_t i)
 			return tmp;
 
 		case PCIeTransportSymbol::TYPE_DATA:
-			snprintf(tmp, sizeof(tmp), "%02" PRIx64, s.m_data);
+			snprintf(tmp, sizeof(tmp), "%" PRIu64 " data bytes", s.m_data);
 			return tmp;
 
 		case PCIeTransportSymbol::TYPE_FLAGS:
@@ -55,6 +55,9 @@ public:
 		TYPE_FIRST_BYTE_ENABLE,
 		TYPE_ADDRESS_X32,
 		TYPE_ADDRESS_X64,
+
+		//Spans the entire TLP payload region, with m_data holding the byte count.
+		//Individual byte values are visible in the data link layer below, and in the packet data.
 		TYPE_DATA,
 		TYPE_COMPLETER_ID,
 		TYPE_COMPLETION_STATUS,
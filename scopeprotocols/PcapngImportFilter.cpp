@@ -31,8 +31,32 @@
 #include "CANDecoder.h"
 #include "PcapngImportFilter.h"
 
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 using namespace std;
 
+namespace
+{
+	///@brief Reads a little endian value from the mapped file, advancing the cursor
+	template<typename T>
+	bool ReadValue(const uint8_t* data, size_t len, size_t& offset, T& out)
+	{
+		if( (offset + sizeof(T)) > len)
+			return false;
+		memcpy(&out, data + offset, sizeof(T));
+		offset += sizeof(T);
+		return true;
+	}
+
+	///@brief Number of packets parsed between flushes of staged data to the visible output
+	const size_t PACKETS_PER_CHUNK = 16384;
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Construction / destruction
 
@@ -42,6 +66,11 @@ PcapngImportFilter::PcapngImportFilter(const string& color)
 	, m_datarate("Data Rate")
 	, m_linkType(LINK_TYPE_UNKNOWN)
 	, m_timestampScale(1)
+	, m_fileData(nullptr)
+	, m_fileLen(0)
+	, m_fileMapped(false)
+	, m_abortLoad(false)
+	, m_loading(false)
 {
 	m_parameters[m_fpname] = FilterParameter(FilterParameter::TYPE_FILENAME, Unit(Unit::UNIT_COUNTS));
 	m_parameters[m_fpname].m_fileFilterMask = "*.pcapng";
@@ -52,6 +81,12 @@ PcapngImportFilter::PcapngImportFilter(const string& color)
 	m_parameters[m_datarate].SetIntVal(500 * 1000);
 }
 
+PcapngImportFilter::~PcapngImportFilter()
+{
+	AbortLoad();
+	UnmapFile();
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Accessors
 
@@ -74,6 +109,101 @@ vector<string> PcapngImportFilter::GetHeaders()
 	return ret;
 }
 
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// File mapping
+
+/**
+	@brief Maps the input file into memory (copying it to the heap on platforms without mmap)
+
+	Mapping rather than reading keeps peak memory bounded by the pages the parser is actually touching,
+	not the whole file, which matters for multi-gigabyte captures.
+ */
+bool PcapngImportFilter::MapFile(const string& fname)
+{
+	UnmapFile();
+
+#ifndef _WIN32
+	int fd = open(fname.c_str(), O_RDONLY);
+	if(fd < 0)
+	{
+		LogError("Couldn't open PcapNG file \"%s\"\n", fname.c_str());
+		return false;
+	}
+
+	struct stat st;
+	if(0 != fstat(fd, &st))
+	{
+		close(fd);
+		return false;
+	}
+	m_fileLen = st.st_size;
+
+	void* p = mmap(nullptr, m_fileLen, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if(p == MAP_FAILED)
+	{
+		LogError("Couldn't map PcapNG file \"%s\"\n", fname.c_str());
+		m_fileLen = 0;
+		return false;
+	}
+
+	//We walk the file front to back exactly once, so tell the kernel to read ahead aggressively
+	madvise(p, m_fileLen, MADV_SEQUENTIAL);
+
+	m_fileData = reinterpret_cast<const uint8_t*>(p);
+	m_fileMapped = true;
+	return true;
+
+#else
+	//No mmap, fall back to reading the whole file
+	FILE* fp = fopen(fname.c_str(), "rb");
+	if(!fp)
+	{
+		LogError("Couldn't open PcapNG file \"%s\"\n", fname.c_str());
+		return false;
+	}
+
+	fseek(fp, 0, SEEK_END);
+	m_fileLen = ftell(fp);
+	fseek(fp, 0, SEEK_SET);
+
+	m_fileBuf.resize(m_fileLen);
+	if(m_fileLen != fread(&m_fileBuf[0], 1, m_fileLen, fp))
+	{
+		fclose(fp);
+		m_fileBuf.clear();
+		m_fileLen = 0;
+		return false;
+	}
+	fclose(fp);
+
+	m_fileData = &m_fileBuf[0];
+	return true;
+#endif
+}
+
+void PcapngImportFilter::UnmapFile()
+{
+#ifndef _WIN32
+	if(m_fileMapped)
+		munmap(const_cast<uint8_t*>(m_fileData), m_fileLen);
+	m_fileMapped = false;
+#endif
+	m_fileBuf.clear();
+	m_fileBuf.shrink_to_fit();
+	m_fileData = nullptr;
+	m_fileLen = 0;
+}
+
+///@brief Requests the load thread stop, then waits for it to do so
+void PcapngImportFilter::AbortLoad()
+{
+	m_abortLoad = true;
+	if(m_loadThread.joinable())
+		m_loadThread.join();
+	m_abortLoad = false;
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Actual decoder logic
 
@@ -89,6 +219,9 @@ void PcapngImportFilter::SetDefaultName()
 
 void PcapngImportFilter::OnFileNameChanged()
 {
+	//Stop any load that's still running before touching shared state
+	AbortLoad();
+
 	ClearPackets();
 
 	auto fname = m_parameters[m_fpname].ToString();
@@ -101,49 +234,52 @@ void PcapngImportFilter::OnFileNameChanged()
 	//Default timestamp resolution is microsecond so 1e9 fs
 	m_timestampScale = 1000LL * 1000LL * 1000LL;
 
-	//Open the input file
+	//Map the input file
 	LogTrace("Loading PcapNG file %s\n", fname.c_str());
 	LogIndenter li;
-	FILE* fp = fopen(fname.c_str(), "r");
-	if(!fp)
-	{
-		LogError("Couldn't open PcapNG file \"%s\"\n", fname.c_str());
+	if(!MapFile(fname))
 		return;
-	}
 
 	//Section Header Block
-	if(!ValidateSHB(fp))
+	size_t offset = 0;
+	if(!ValidateSHB(offset))
+	{
+		UnmapFile();
 		return;
+	}
 
 	//Read trailing block length (and discard for now)
 	//TODO: verify it's correct
 	uint32_t blocklen;
-	if(1 != fread(&blocklen, sizeof(blocklen), 1, fp))
+	if(!ReadValue(m_fileData, m_fileLen, offset, blocklen))
+	{
+		UnmapFile();
 		return;
+	}
 
 	//Read and process packet blocks
 	bool gotEPB = false;
-	long blockstart;
-	while(!feof(fp))
+	size_t blockstart = 0;
+	while(offset < m_fileLen)
 	{
-		blockstart = ftell(fp);
+		blockstart = offset;
 
 		uint32_t blocktype;
-		if(1 != fread(&blocktype, sizeof(blocktype), 1, fp))
-			return;
-		if(1 != fread(&blocklen, sizeof(blocklen), 1, fp))
-			return;
+		if(!ReadValue(m_fileData, m_fileLen, offset, blocktype))
+			break;
+		if(!ReadValue(m_fileData, m_fileLen, offset, blocklen))
+			break;
 		LogTrace("blocktype %d blocklen %d\n", blocktype, blocklen);
 
 		//Interface Definition Block
 		if(blocktype == 1)
 		{
-			if(!ReadIDB(fp))
-				return;
+			if(!ReadIDB(offset))
+				break;
 
 			//read and discard trailing block size
-			if(1 != fread(&blocklen, sizeof(blocklen), 1, fp))
-				return;
+			if(!ReadValue(m_fileData, m_fileLen, offset, blocklen))
+				break;
 		}
 
 		//Enhanced Packet Block: start of data stream
@@ -156,41 +292,51 @@ void PcapngImportFilter::OnFileNameChanged()
 		else
 		{
 			LogWarning("Unknown block type %d\n", blocktype);
-			return;
+			break;
 		}
-
 	}
 	if(!gotEPB)
 	{
 		LogWarning("Didn't get an Enhanced Packet Block, nothing to do\n");
+		UnmapFile();
 		return;
 	}
 
-	//Move back to the start of the EPB
+	//Parse the packet stream on a background thread, starting from the first EPB,
+	//so the first packets show up immediately while the rest of a big capture is still loading
 	LogTrace("Ready to start reading frame data\n");
-	fseek(fp, blockstart, SEEK_SET);
+	m_loading = true;
+	m_loadThread = thread(&PcapngImportFilter::LoadThreadProc, this, blockstart);
+}
+
+///@brief Entry point for the background load thread
+void PcapngImportFilter::LoadThreadProc(size_t offset)
+{
+	#ifdef __linux__
+	pthread_setname_np(pthread_self(), "PcapngLoad");
+	#endif
 
 	switch(m_linkType)
 	{
 		case LINK_TYPE_SOCKETCAN:
-			LoadSocketCAN(fp);
+			LoadSocketCAN(offset);
 			break;
 
 		case LINK_TYPE_LINUX_COOKED:
 			//Linux cooked encapsulation is special: we don't know the output data format initially
 			//and there can be a mix of several which we don't currently implement!
-			LoadLinuxCooked(fp);
+			LoadLinuxCooked(offset);
 			break;
 
 		default:
 			break;
 	}
 
-	fclose(fp);
+	m_loading = false;
 }
 
 //TODO: this shares a lot in common with LoadCANLinuxCooked, how can we share more?
-bool PcapngImportFilter::LoadSocketCAN(FILE* fp)
+bool PcapngImportFilter::LoadSocketCAN(size_t offset)
 {
 	LogTrace("Loading SocketCAN packets\n");
 	LogIndenter li;
@@ -209,25 +355,51 @@ bool PcapngImportFilter::LoadSocketCAN(FILE* fp)
 	int64_t baud = m_parameters[m_datarate].GetIntVal();
 	int64_t ui = FS_PER_SECOND / baud;
 
+	//Staging area for the current chunk, flushed to the visible output periodically
+	//so readers only ever contend for the lock briefly
+	vector<int64_t> stagedOffsets;
+	vector<int64_t> stagedDurations;
+	vector<CANSymbol> stagedSamples;
+	vector<Packet*> stagedPackets;
+	auto flush = [&]()
+	{
+		lock_guard<mutex> lock(m_loadMutex);
+		for(size_t i=0; i<stagedOffsets.size(); i++)
+		{
+			cap->m_offsets.push_back(stagedOffsets[i]);
+			cap->m_durations.push_back(stagedDurations[i]);
+			cap->m_samples.push_back(stagedSamples[i]);
+		}
+		for(auto p : stagedPackets)
+			m_packets.push_back(p);
+		stagedOffsets.clear();
+		stagedDurations.clear();
+		stagedSamples.clear();
+		stagedPackets.clear();
+		cap->MarkModifiedFromCpu();
+	};
+
 	uint32_t blocktype;
 	uint32_t blocklen;
 	int64_t tend = 0;
-	while(!feof(fp))
+	bool ok = true;
+	while( (offset < m_fileLen) && !m_abortLoad)
 	{
-		auto blockstart = ftell(fp);
+		auto blockstart = offset;
 
-		if(1 != fread(&blocktype, sizeof(blocktype), 1, fp))
-			return false;
-		if(1 != fread(&blocklen, sizeof(blocklen), 1, fp))
-			return false;
+		if(!ReadValue(m_fileData, m_fileLen, offset, blocktype))
+			break;
+		if(!ReadValue(m_fileData, m_fileLen, offset, blocklen))
+			break;
 
 		//Should be an EPB, ignore anything else
+		bool skip = false;
 		switch(blocktype)
 		{
 			case 5:
 				LogTrace("Found Block Statistics (%d bytes)\n", blocklen);
-				fseek(fp, blockstart + blocklen, SEEK_SET);
-				continue;
+				skip = true;
+				break;
 
 			case 6:
 				//LogTrace("Found EPB (%d bytes)\n", blocklen);
@@ -236,8 +408,13 @@ bool PcapngImportFilter::LoadSocketCAN(FILE* fp)
 			default:
 				//unknown type, wut?
 				LogWarning("unknown block type %d\n", blocktype);
-				fseek(fp, blockstart + blocklen, SEEK_SET);
-				continue;
+				skip = true;
+				break;
+		}
+		if(skip)
+		{
+			offset = blockstart + blocklen;
+			continue;
 		}
 		LogIndenter li2;
 
@@ -246,14 +423,21 @@ bool PcapngImportFilter::LoadSocketCAN(FILE* fp)
 
 		//For now, ignore interface number since we don't support mixed captures or multiple output streams yet
 		uint32_t ifacenum;
-		if(1 != fread(&ifacenum, sizeof(ifacenum), 1, fp))
-			return false;
+		if(!ReadValue(m_fileData, m_fileLen, offset, ifacenum))
+		{
+			ok = false;
+			break;
+		}
 		//LogTrace("Interface %u\n", ifacenum);
 
 		//Timestamp
 		uint32_t tstamp[2];
-		if(2 != fread(tstamp, sizeof(uint32_t), 2, fp))
-			return false;
+		if(!ReadValue(m_fileData, m_fileLen, offset, tstamp[0]) ||
+			!ReadValue(m_fileData, m_fileLen, offset, tstamp[1]))
+		{
+			ok = false;
+			break;
+		}
 
 		//Convert from packed format in native units to a single 64-bit integer
 		int64_t stamp = tstamp[0];
@@ -281,19 +465,25 @@ bool PcapngImportFilter::LoadSocketCAN(FILE* fp)
 
 		//Actual as-captured packet length
 		uint32_t packlen;
-		if(1 != fread(&packlen, sizeof(packlen), 1, fp))
-			return false;
+		if(!ReadValue(m_fileData, m_fileLen, offset, packlen))
+		{
+			ok = false;
+			break;
+		}
 		if(packlen < 16)
 		{
 			LogWarning("Invalid packet length %d (should be >= 16 to allow room for cooked headers)\n", packlen);
-			fseek(fp, blockstart + blocklen, SEEK_SET);
+			offset = blockstart + blocklen;
 			continue;
 		}
 
 		//Original packet length (might have been truncated, but ignore this)
 		uint32_t origlen;
-		if(1 != fread(&origlen, sizeof(origlen), 1, fp))
-			return false;
+		if(!ReadValue(m_fileData, m_fileLen, offset, origlen))
+		{
+			ok = false;
+			break;
+		}
 
 		//Timestamps sometimes have some jitter due to USB dongles combining several into one transaction,
 		//without logging actual arrival timestamps. So they can appear to be coming at too high a baud rate.
@@ -303,28 +493,39 @@ bool PcapngImportFilter::LoadSocketCAN(FILE* fp)
 
 		//Read CAN ID (32 bit on wire)
 		uint32_t id;
-		if(1 != fread(&id, sizeof(id), 1, fp))
-			return false;
+		if(!ReadValue(m_fileData, m_fileLen, offset, id))
+		{
+			ok = false;
+			break;
+		}
 		id = ntohl(id);
 
 		//Read frame length
 		uint8_t nbytes;
-		if(1 != fread(&nbytes, sizeof(nbytes), 1, fp))
-			return false;
+		if(!ReadValue(m_fileData, m_fileLen, offset, nbytes))
+		{
+			ok = false;
+			break;
+		}
 		if(nbytes > 8)
 		{
 			LogWarning("Invalid DLC %d (should be <= 8)\n", nbytes);
-			fseek(fp, blockstart + blocklen, SEEK_SET);
+			offset = blockstart + blocklen;
 			continue;
 		}
 
 		//Skip 3 bytes of FD flags / reserved before the payload
-		fseek(fp, 3, SEEK_CUR);
+		offset += 3;
 
 		//Read payload
 		uint8_t data[8];
-		if(nbytes != fread(data, 1, nbytes, fp))
-			return false;
+		if( (offset + nbytes) > m_fileLen)
+		{
+			ok = false;
+			break;
+		}
+		memcpy(data, m_fileData + offset, nbytes);
+		offset += nbytes;
 
 		//Extract header bits (packed in with ID)
 		bool ext = (id & 0x80000000);
@@ -334,36 +535,36 @@ bool PcapngImportFilter::LoadSocketCAN(FILE* fp)
 		bool fd = false;//(proto == 0x0d);
 
 		//Add timeline samples
-		cap->m_offsets.push_back(stamp);
-		cap->m_durations.push_back(ui);
-		cap->m_samples.push_back(CANSymbol(CANSymbol::TYPE_SOF, 0));
+		stagedOffsets.push_back(stamp);
+		stagedDurations.push_back(ui);
+		stagedSamples.push_back(CANSymbol(CANSymbol::TYPE_SOF, 0));
 
-		cap->m_offsets.push_back(stamp + ui);
-		cap->m_durations.push_back(31 * ui);
-		cap->m_samples.push_back(CANSymbol(CANSymbol::TYPE_ID, id));
+		stagedOffsets.push_back(stamp + ui);
+		stagedDurations.push_back(31 * ui);
+		stagedSamples.push_back(CANSymbol(CANSymbol::TYPE_ID, id));
 
-		cap->m_offsets.push_back(stamp + 32*ui);
-		cap->m_durations.push_back(ui);
-		cap->m_samples.push_back(CANSymbol(CANSymbol::TYPE_RTR, rtr));
+		stagedOffsets.push_back(stamp + 32*ui);
+		stagedDurations.push_back(ui);
+		stagedSamples.push_back(CANSymbol(CANSymbol::TYPE_RTR, rtr));
 
-		cap->m_offsets.push_back(stamp + 33*ui);
-		cap->m_durations.push_back(ui);
-		cap->m_samples.push_back(CANSymbol(CANSymbol::TYPE_FD, fd));
+		stagedOffsets.push_back(stamp + 33*ui);
+		stagedDurations.push_back(ui);
+		stagedSamples.push_back(CANSymbol(CANSymbol::TYPE_FD, fd));
 
-		cap->m_offsets.push_back(stamp + 34*ui);
-		cap->m_durations.push_back(ui);
-		cap->m_samples.push_back(CANSymbol(CANSymbol::TYPE_R0, 0));
+		stagedOffsets.push_back(stamp + 34*ui);
+		stagedDurations.push_back(ui);
+		stagedSamples.push_back(CANSymbol(CANSymbol::TYPE_R0, 0));
 
-		cap->m_offsets.push_back(stamp + 35*ui);
-		cap->m_durations.push_back(ui*4);
-		cap->m_samples.push_back(CANSymbol(CANSymbol::TYPE_DLC, nbytes));
+		stagedOffsets.push_back(stamp + 35*ui);
+		stagedDurations.push_back(ui*4);
+		stagedSamples.push_back(CANSymbol(CANSymbol::TYPE_DLC, nbytes));
 
 		//Data
 		for(size_t i=0; i<nbytes; i++)
 		{
-			cap->m_offsets.push_back(stamp + 39*ui + i*8*ui);
-			cap->m_durations.push_back(ui*8);
-			cap->m_samples.push_back(CANSymbol(CANSymbol::TYPE_DATA, data[i]));
+			stagedOffsets.push_back(stamp + 39*ui + i*8*ui);
+			stagedDurations.push_back(ui*8);
+			stagedSamples.push_back(CANSymbol(CANSymbol::TYPE_DATA, data[i]));
 		}
 
 		tend = stamp + 39*ui + nbytes*8*ui;
@@ -393,16 +594,23 @@ bool PcapngImportFilter::LoadSocketCAN(FILE* fp)
 			pack->m_data.push_back(data[i]);
 		pack->m_offset = stamp;
 		pack->m_len = 128 * ui;
-		m_packets.push_back(pack);
+		stagedPackets.push_back(pack);
+
+		//Publish the chunk if it's grown big enough
+		if(stagedPackets.size() >= PACKETS_PER_CHUNK)
+			flush();
 
 		//End of the EPB, skip any unread contents
-		fseek(fp, blockstart + blocklen, SEEK_SET);
+		offset = blockstart + blocklen;
 	}
 
-	return true;
+	//Publish whatever's left of the final chunk
+	flush();
+
+	return ok;
 }
 
-bool PcapngImportFilter::LoadLinuxCooked(FILE* fp)
+bool PcapngImportFilter::LoadLinuxCooked(size_t offset)
 {
 	LogTrace("Loading Linux cooked format packets\n");
 	LogIndenter li;
@@ -427,22 +635,18 @@ bool PcapngImportFilter::LoadLinuxCooked(FILE* fp)
 	//So we need to skip ahead 30 bytes and sneak a peek at the AHPHRD_type field to know
 	//what kind of waveform we're dealing with.
 	//TODO: support multiple interfaces and multiple encapsulations in a single packet stream
-	auto orig = ftell(fp);
-	fseek(fp, 30, SEEK_CUR);
+	size_t peek = offset + 30;
 
 	uint16_t arphrd;
-	if(1 != fread(&arphrd, sizeof(arphrd), 1, fp))
+	if(!ReadValue(m_fileData, m_fileLen, peek, arphrd))
 		return false;
 	arphrd = ntohs(arphrd);
 
-	//Ok, back to where we started
-	fseek(fp, orig, SEEK_SET);
-
 	//So what is it?
 	switch(arphrd)
 	{
 		case 280:
-			return LoadCANLinuxCooked(fp);
+			return LoadCANLinuxCooked(offset);
 
 		default:
 			LogError("Unknown inner format %d in Linux cooked encapsulation\n", arphrd);
@@ -452,7 +656,7 @@ bool PcapngImportFilter::LoadLinuxCooked(FILE* fp)
 	return true;
 }
 
-bool PcapngImportFilter::LoadCANLinuxCooked(FILE* fp)
+bool PcapngImportFilter::LoadCANLinuxCooked(size_t offset)
 {
 	LogTrace("Loading CAN frames with Linux cooked encapsulation\n");
 	LogIndenter li;
@@ -471,25 +675,50 @@ bool PcapngImportFilter::LoadCANLinuxCooked(FILE* fp)
 	int64_t baud = m_parameters[m_datarate].GetIntVal();
 	int64_t ui = FS_PER_SECOND / baud;
 
+	//Staging area for the current chunk, flushed to the visible output periodically
+	vector<int64_t> stagedOffsets;
+	vector<int64_t> stagedDurations;
+	vector<CANSymbol> stagedSamples;
+	vector<Packet*> stagedPackets;
+	auto flush = [&]()
+	{
+		lock_guard<mutex> lock(m_loadMutex);
+		for(size_t i=0; i<stagedOffsets.size(); i++)
+		{
+			cap->m_offsets.push_back(stagedOffsets[i]);
+			cap->m_durations.push_back(stagedDurations[i]);
+			cap->m_samples.push_back(stagedSamples[i]);
+		}
+		for(auto p : stagedPackets)
+			m_packets.push_back(p);
+		stagedOffsets.clear();
+		stagedDurations.clear();
+		stagedSamples.clear();
+		stagedPackets.clear();
+		cap->MarkModifiedFromCpu();
+	};
+
 	uint32_t blocktype;
 	uint32_t blocklen;
 	int64_t tend = 0;
-	while(!feof(fp))
+	bool ok = true;
+	while( (offset < m_fileLen) && !m_abortLoad)
 	{
-		auto blockstart = ftell(fp);
+		auto blockstart = offset;
 
-		if(1 != fread(&blocktype, sizeof(blocktype), 1, fp))
-			return false;
-		if(1 != fread(&blocklen, sizeof(blocklen), 1, fp))
-			return false;
+		if(!ReadValue(m_fileData, m_fileLen, offset, blocktype))
+			break;
+		if(!ReadValue(m_fileData, m_fileLen, offset, blocklen))
+			break;
 
 		//Should be an EPB, ignore anything else
+		bool skip = false;
 		switch(blocktype)
 		{
 			case 5:
 				LogTrace("Found Block Statistics (%d bytes)\n", blocklen);
-				fseek(fp, blockstart + blocklen, SEEK_SET);
-				continue;
+				skip = true;
+				break;
 
 			case 6:
 				//LogTrace("Found EPB (%d bytes)\n", blocklen);
@@ -498,8 +727,13 @@ bool PcapngImportFilter::LoadCANLinuxCooked(FILE* fp)
 			default:
 				//unknown type, wut?
 				LogWarning("unknown block type %d\n", blocktype);
-				fseek(fp, blockstart + blocklen, SEEK_SET);
-				continue;
+				skip = true;
+				break;
+		}
+		if(skip)
+		{
+			offset = blockstart + blocklen;
+			continue;
 		}
 		LogIndenter li2;
 
@@ -508,14 +742,21 @@ bool PcapngImportFilter::LoadCANLinuxCooked(FILE* fp)
 
 		//For now, ignore interface number since we don't support mixed captures or multiple output streams yet
 		uint32_t ifacenum;
-		if(1 != fread(&ifacenum, sizeof(ifacenum), 1, fp))
-			return false;
+		if(!ReadValue(m_fileData, m_fileLen, offset, ifacenum))
+		{
+			ok = false;
+			break;
+		}
 		//LogTrace("Interface %u\n", ifacenum);
 
 		//Timestamp
 		uint32_t tstamp[2];
-		if(2 != fread(tstamp, sizeof(uint32_t), 2, fp))
-			return false;
+		if(!ReadValue(m_fileData, m_fileLen, offset, tstamp[0]) ||
+			!ReadValue(m_fileData, m_fileLen, offset, tstamp[1]))
+		{
+			ok = false;
+			break;
+		}
 
 		//Convert from packed format in native units to a single 64-bit integer
 		int64_t stamp = tstamp[0];
@@ -543,67 +784,88 @@ bool PcapngImportFilter::LoadCANLinuxCooked(FILE* fp)
 
 		//Actual as-captured packet length
 		uint32_t packlen;
-		if(1 != fread(&packlen, sizeof(packlen), 1, fp))
-			return false;
+		if(!ReadValue(m_fileData, m_fileLen, offset, packlen))
+		{
+			ok = false;
+			break;
+		}
 		if(packlen < 16)
 		{
 			LogWarning("Invalid packet length %d (should be >= 16 to allow room for cooked headers)\n", packlen);
-			fseek(fp, blockstart + blocklen, SEEK_SET);
+			offset = blockstart + blocklen;
 			continue;
 		}
 
 		//Original packet length (might have been truncated, but ignore this)
 		uint32_t origlen;
-		if(1 != fread(&origlen, sizeof(origlen), 1, fp))
-			return false;
+		if(!ReadValue(m_fileData, m_fileLen, offset, origlen))
+		{
+			ok = false;
+			break;
+		}
 
 		////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 		// Linux cooked packet header
 
 		//Packet type (typically always be 0x01 broadcast, or 0x04 sent by us, for CAN)
 		uint16_t packtype;
-		if(1 != fread(&packtype, sizeof(packtype), 1, fp))
-			return false;
+		if(!ReadValue(m_fileData, m_fileLen, offset, packtype))
+		{
+			ok = false;
+			break;
+		}
 
 		//ARPHRD type (should always be 280, CAN, if we get to this point)
 		uint16_t arphrd;
-		if(1 != fread(&arphrd, sizeof(arphrd), 1, fp))
-			return false;
+		if(!ReadValue(m_fileData, m_fileLen, offset, arphrd))
+		{
+			ok = false;
+			break;
+		}
 		arphrd = ntohs(arphrd);
 		if(arphrd != 280)
 		{
 			LogWarning("Unknown ARPHRD type %d in what we expected to be a CAN capture inside Linux cooked headers\n",
 				arphrd);
-			fseek(fp, blockstart + blocklen, SEEK_SET);
+			offset = blockstart + blocklen;
 			continue;
 		}
 
 		//Link layer address length (should always be 0 for CAN bus)
 		uint16_t linklen;
-		if(1 != fread(&linklen, sizeof(linklen), 1, fp))
-			return false;
+		if(!ReadValue(m_fileData, m_fileLen, offset, linklen))
+		{
+			ok = false;
+			break;
+		}
 		linklen = ntohs(linklen);
 		if(linklen != 0)
 		{
 			LogWarning("Invalid link layer address length %d (should be 0 for CAN)\n", linklen);
-			fseek(fp, blockstart + blocklen, SEEK_SET);
+			offset = blockstart + blocklen;
 			continue;
 		}
 
 		//8 bytes of padding (where link layer address would be if we had one)
 		uint64_t padding;
-		if(1 != fread(&padding, sizeof(padding), 1, fp))
-			return false;
+		if(!ReadValue(m_fileData, m_fileLen, offset, padding))
+		{
+			ok = false;
+			break;
+		}
 
 		//Protocol type (should be 0x0C, CAN bus or 0x0d (CAN-FD))
 		uint16_t proto;
-		if(1 != fread(&proto, sizeof(proto), 1, fp))
-			return false;
+		if(!ReadValue(m_fileData, m_fileLen, offset, proto))
+		{
+			ok = false;
+			break;
+		}
 		proto = ntohs(proto);
 		if( (proto != 0x0c) && (proto != 0x0d) )
 		{
 			LogWarning("Invalid protocol type 0x%02x (should be 0x0c for CAN or 0x0d for CAN-FD)\n", proto);
-			fseek(fp, blockstart + blocklen, SEEK_SET);
+			offset = blockstart + blocklen;
 			continue;
 		}
 
@@ -618,24 +880,35 @@ bool PcapngImportFilter::LoadCANLinuxCooked(FILE* fp)
 
 		//Read CAN ID (32 bit on wire)
 		uint32_t id;
-		if(1 != fread(&id, sizeof(id), 1, fp))
-			return false;
+		if(!ReadValue(m_fileData, m_fileLen, offset, id))
+		{
+			ok = false;
+			break;
+		}
 
 		//Read frame length
 		uint32_t nbytes;
-		if(1 != fread(&nbytes, sizeof(nbytes), 1, fp))
-			return false;
+		if(!ReadValue(m_fileData, m_fileLen, offset, nbytes))
+		{
+			ok = false;
+			break;
+		}
 		if(nbytes > 8)
 		{
 			LogWarning("Invalid DLC %d (should be <= 8)\n", nbytes);
-			fseek(fp, blockstart + blocklen, SEEK_SET);
+			offset = blockstart + blocklen;
 			continue;
 		}
 
 		//Read payload
 		uint8_t data[8];
-		if(nbytes != fread(data, 1, nbytes, fp))
-			return false;
+		if( (offset + nbytes) > m_fileLen)
+		{
+			ok = false;
+			break;
+		}
+		memcpy(data, m_fileData + offset, nbytes);
+		offset += nbytes;
 
 		//Extract header bits (packed in with ID)
 		bool ext = (id & 0x80000000);
@@ -644,36 +917,36 @@ bool PcapngImportFilter::LoadCANLinuxCooked(FILE* fp)
 		bool fd = (proto == 0x0d);
 
 		//Add timeline samples
-		cap->m_offsets.push_back(stamp);
-		cap->m_durations.push_back(ui);
-		cap->m_samples.push_back(CANSymbol(CANSymbol::TYPE_SOF, 0));
+		stagedOffsets.push_back(stamp);
+		stagedDurations.push_back(ui);
+		stagedSamples.push_back(CANSymbol(CANSymbol::TYPE_SOF, 0));
 
-		cap->m_offsets.push_back(stamp + ui);
-		cap->m_durations.push_back(31 * ui);
-		cap->m_samples.push_back(CANSymbol(CANSymbol::TYPE_ID, id));
+		stagedOffsets.push_back(stamp + ui);
+		stagedDurations.push_back(31 * ui);
+		stagedSamples.push_back(CANSymbol(CANSymbol::TYPE_ID, id));
 
-		cap->m_offsets.push_back(stamp + 32*ui);
-		cap->m_durations.push_back(ui);
-		cap->m_samples.push_back(CANSymbol(CANSymbol::TYPE_RTR, rtr));
+		stagedOffsets.push_back(stamp + 32*ui);
+		stagedDurations.push_back(ui);
+		stagedSamples.push_back(CANSymbol(CANSymbol::TYPE_RTR, rtr));
 
-		cap->m_offsets.push_back(stamp + 33*ui);
-		cap->m_durations.push_back(ui);
-		cap->m_samples.push_back(CANSymbol(CANSymbol::TYPE_FD, fd));
+		stagedOffsets.push_back(stamp + 33*ui);
+		stagedDurations.push_back(ui);
+		stagedSamples.push_back(CANSymbol(CANSymbol::TYPE_FD, fd));
 
-		cap->m_offsets.push_back(stamp + 34*ui);
-		cap->m_durations.push_back(ui);
-		cap->m_samples.push_back(CANSymbol(CANSymbol::TYPE_R0, 0));
+		stagedOffsets.push_back(stamp + 34*ui);
+		stagedDurations.push_back(ui);
+		stagedSamples.push_back(CANSymbol(CANSymbol::TYPE_R0, 0));
 
-		cap->m_offsets.push_back(stamp + 35*ui);
-		cap->m_durations.push_back(ui*4);
-		cap->m_samples.push_back(CANSymbol(CANSymbol::TYPE_DLC, nbytes));
+		stagedOffsets.push_back(stamp + 35*ui);
+		stagedDurations.push_back(ui*4);
+		stagedSamples.push_back(CANSymbol(CANSymbol::TYPE_DLC, nbytes));
 
 		//Data
 		for(size_t i=0; i<nbytes; i++)
 		{
-			cap->m_offsets.push_back(stamp + 39*ui + i*8*ui);
-			cap->m_durations.push_back(ui*8);
-			cap->m_samples.push_back(CANSymbol(CANSymbol::TYPE_DATA, data[i]));
+			stagedOffsets.push_back(stamp + 39*ui + i*8*ui);
+			stagedDurations.push_back(ui*8);
+			stagedSamples.push_back(CANSymbol(CANSymbol::TYPE_DATA, data[i]));
 		}
 
 		tend = stamp + 39*ui + nbytes*8*ui;
@@ -699,26 +972,33 @@ bool PcapngImportFilter::LoadCANLinuxCooked(FILE* fp)
 			pack->m_data.push_back(data[i]);
 		pack->m_offset = stamp;
 		pack->m_len = 128 * ui;
-		m_packets.push_back(pack);
+		stagedPackets.push_back(pack);
+
+		//Publish the chunk if it's grown big enough
+		if(stagedPackets.size() >= PACKETS_PER_CHUNK)
+			flush();
 
 		//End of the EPB, skip any unread contents
-		fseek(fp, blockstart + blocklen, SEEK_SET);
+		offset = blockstart + blocklen;
 	}
 
-	return true;
+	//Publish whatever's left of the final chunk
+	flush();
+
+	return ok;
 }
 
 /**
 	@brief Read Interface Definition Block
  */
-bool PcapngImportFilter::ReadIDB(FILE* fp)
+bool PcapngImportFilter::ReadIDB(size_t& offset)
 {
 	LogTrace("Reading interface definition block\n");
 	LogIndenter li;
 
 	//Read link type
 	uint16_t linktype;
-	if(1 != fread(&linktype, sizeof(linktype), 1, fp))
+	if(!ReadValue(m_fileData, m_fileLen, offset, linktype))
 		return false;
 
 	switch(linktype)
@@ -756,17 +1036,16 @@ bool PcapngImportFilter::ReadIDB(FILE* fp)
 
 	//Read and discard two reserved bytes
 	uint16_t reserved;
-	if(1 != fread(&reserved, sizeof(reserved), 1, fp))
+	if(!ReadValue(m_fileData, m_fileLen, offset, reserved))
 		return false;
 
 	//Read snap length (for now, ignore it)
 	uint32_t snaplen;
-	if(1 != fread(&snaplen, sizeof(snaplen), 1, fp))
+	if(!ReadValue(m_fileData, m_fileLen, offset, snaplen))
 		return false;
 	LogTrace("Snap length is %d bytes\n", snaplen);
 
 	//Read IDB options
-	uint8_t tmp;
 	bool done = false;
 	string str;
 	uint16_t t16;
@@ -774,12 +1053,12 @@ bool PcapngImportFilter::ReadIDB(FILE* fp)
 	{
 		//Read the option
 		uint16_t optid;
-		if(1 != fread(&optid, sizeof(optid), 1, fp))
+		if(!ReadValue(m_fileData, m_fileLen, offset, optid))
 			return false;
 
 		//Read option length
 		uint16_t optlen;
-		if(1 != fread(&optlen, sizeof(optlen), 1, fp))
+		if(!ReadValue(m_fileData, m_fileLen, offset, optlen))
 			return false;
 
 		switch(optid)
@@ -791,19 +1070,19 @@ bool PcapngImportFilter::ReadIDB(FILE* fp)
 
 			//if_name
 			case 2:
-				str = ReadFixedLengthString(optlen, fp);
+				str = ReadFixedLengthString(optlen, offset);
 				LogTrace("if_name = %s\n", str.c_str());
 				break;
 
 			//if_description
 			case 3:
-				str = ReadFixedLengthString(optlen, fp);
+				str = ReadFixedLengthString(optlen, offset);
 				LogTrace("if_description = %s\n", str.c_str());
 				break;
 
 			//if_tresol
 			case 9:
-				if(1 != fread(&t16, sizeof(t16), 1, fp))
+				if(!ReadValue(m_fileData, m_fileLen, offset, t16))
 					return false;
 
 				//Nanosecond resolution
@@ -815,26 +1094,24 @@ bool PcapngImportFilter::ReadIDB(FILE* fp)
 
 			//if_filter
 			case 11:
-				str = ReadFixedLengthString(optlen, fp);
+				str = ReadFixedLengthString(optlen, offset);
 				LogTrace("if_filter = %s\n", str.c_str());
 				break;
 
 			//if_os
 			case 12:
-				str = ReadFixedLengthString(optlen, fp);
+				str = ReadFixedLengthString(optlen, offset);
 				LogTrace("if_os = %s\n", str.c_str());
 				break;
 
 			//unknown, discard it
 			default:
 				LogWarning("Unknown IDB option %d\n", optid);
-				for(size_t i=0; i<optlen; i++)
-					fread(&tmp, 1, 1, fp);
+				offset += optlen;
 		}
 
-		//Read and discard padding until 32-bit aligned
-		while(ftell(fp) & 3)
-			fread(&tmp, 1, 1, fp);
+		//Skip padding until 32-bit aligned
+		offset = (offset + 3) & ~((size_t)3);
 	}
 
 	return true;
@@ -843,14 +1120,14 @@ bool PcapngImportFilter::ReadIDB(FILE* fp)
 /**
 	@brief Read Section Header Block
  */
-bool PcapngImportFilter::ValidateSHB(FILE* fp)
+bool PcapngImportFilter::ValidateSHB(size_t& offset)
 {
 	LogTrace("Loading SHB\n");
 	LogIndenter li;
 
 	//Magic number
 	uint32_t blocktype;
-	if(1 != fread(&blocktype, sizeof(blocktype), 1, fp))
+	if(!ReadValue(m_fileData, m_fileLen, offset, blocktype))
 		return false;
 	if(blocktype != 0x0a0d0d0a)
 	{
@@ -860,13 +1137,13 @@ bool PcapngImportFilter::ValidateSHB(FILE* fp)
 
 	//Block length
 	uint32_t blocklen;
-	if(1 != fread(&blocklen, sizeof(blocklen), 1, fp))
+	if(!ReadValue(m_fileData, m_fileLen, offset, blocklen))
 		return false;
 	LogTrace("SHB is %d bytes long\n", blocklen);
 
 	//Byte order (for now, only implement little endian)
 	uint32_t bom;
-	if(1 != fread(&bom, sizeof(bom), 1, fp))
+	if(!ReadValue(m_fileData, m_fileLen, offset, bom))
 		return false;
 	if(bom != 0x1a2b3c4d)
 	{
@@ -876,29 +1153,31 @@ bool PcapngImportFilter::ValidateSHB(FILE* fp)
 
 	//Major and minor version numbers
 	uint16_t versions[2];
-	if(2 != fread(versions, sizeof(uint16_t), 2, fp))
+	if(!ReadValue(m_fileData, m_fileLen, offset, versions[0]) ||
+		!ReadValue(m_fileData, m_fileLen, offset, versions[1]))
+	{
 		return false;
+	}
 	LogTrace("PcapNG file format %d.%d\n", versions[0], versions[1]);
 
 	//Read and discard section length (can't have any content)
 	uint64_t ignoredLen;
-	if(1 != fread(&ignoredLen, sizeof(ignoredLen), 1, fp))
+	if(!ReadValue(m_fileData, m_fileLen, offset, ignoredLen))
 		return false;
 
 	//Read options
-	uint8_t tmp;
 	bool done = false;
 	string str;
 	while(!done)
 	{
 		//Read the option
 		uint16_t optid;
-		if(1 != fread(&optid, sizeof(optid), 1, fp))
+		if(!ReadValue(m_fileData, m_fileLen, offset, optid))
 			return false;
 
 		//Read option length
 		uint16_t optlen;
-		if(1 != fread(&optlen, sizeof(optlen), 1, fp))
+		if(!ReadValue(m_fileData, m_fileLen, offset, optlen))
 			return false;
 
 		switch(optid)
@@ -910,47 +1189,44 @@ bool PcapngImportFilter::ValidateSHB(FILE* fp)
 
 			//shb_hardware
 			case 2:
-				str = ReadFixedLengthString(optlen, fp);
+				str = ReadFixedLengthString(optlen, offset);
 				LogTrace("shb_hardware = %s\n", str.c_str());
 				break;
 
 			//shb_os
 			case 3:
-				str = ReadFixedLengthString(optlen, fp);
+				str = ReadFixedLengthString(optlen, offset);
 				LogTrace("shb_os = %s\n", str.c_str());
 				break;
 
 			//shb_userappl
 			case 4:
-				str = ReadFixedLengthString(optlen, fp);
+				str = ReadFixedLengthString(optlen, offset);
 				LogTrace("shb_userappl = %s\n", str.c_str());
 				break;
 
 			//unknown, discard it
 			default:
 				LogWarning("Unknown SHB option %d\n", optid);
-				for(size_t i=0; i<optlen; i++)
-					fread(&tmp, 1, 1, fp);
+				offset += optlen;
 		}
 
-		//Read and discard padding until 32-bit aligned
-		while(ftell(fp) & 3)
-			fread(&tmp, 1, 1, fp);
+		//Skip padding until 32-bit aligned
+		offset = (offset + 3) & ~((size_t)3);
 	}
 
 	return true;
 }
 
-string PcapngImportFilter::ReadFixedLengthString(uint16_t len, FILE* fp)
+string PcapngImportFilter::ReadFixedLengthString(uint16_t len, size_t& offset)
 {
-	//TODO: make this more efficient
-	string ret;
-	char tmp;
-	for(size_t i=0; i<len; i++)
+	if( (offset + len) > m_fileLen)
 	{
-		fread(&tmp, 1, 1, fp);
-		ret += tmp;
+		offset = m_fileLen;
+		return "";
 	}
+	string ret(reinterpret_cast<const char*>(m_fileData + offset), len);
+	offset += len;
 	return ret;
 }
 
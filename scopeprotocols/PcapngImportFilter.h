@@ -35,10 +35,15 @@
 #ifndef PcapngImportFilter_h
 #define PcapngImportFilter_h
 
+#include <atomic>
+#include <mutex>
+#include <thread>
+
 class PcapngImportFilter : public PacketDecoder
 {
 public:
 	PcapngImportFilter(const std::string& color);
+	virtual ~PcapngImportFilter();
 
 	std::vector<std::string> GetHeaders() override;
 	virtual void SetDefaultName() override;
@@ -47,6 +52,14 @@ public:
 
 	static std::string GetProtocolName();
 
+	///@brief Returns true if a background load is still in progress
+	bool IsLoading()
+	{ return m_loading; }
+
+	///@brief Mutex protecting the output waveform and packet list while a background load is in progress
+	std::mutex& GetLoadMutex()
+	{ return m_loadMutex; }
+
 	PROTOCOL_DECODER_INITPROC(PcapngImportFilter)
 
 protected:
@@ -55,13 +68,18 @@ protected:
 
 	void OnFileNameChanged();
 
-	bool ValidateSHB(FILE* fp);
-	bool ReadIDB(FILE* fp);
-	std::string ReadFixedLengthString(uint16_t len, FILE* fp);
+	bool MapFile(const std::string& fname);
+	void UnmapFile();
+	void AbortLoad();
+	void LoadThreadProc(size_t offset);
 
-	bool LoadLinuxCooked(FILE* fp);
-	bool LoadCANLinuxCooked(FILE* fp);
-	bool LoadSocketCAN(FILE* fp);
+	bool ValidateSHB(size_t& offset);
+	bool ReadIDB(size_t& offset);
+	std::string ReadFixedLengthString(uint16_t len, size_t& offset);
+
+	bool LoadLinuxCooked(size_t offset);
+	bool LoadCANLinuxCooked(size_t offset);
+	bool LoadSocketCAN(size_t offset);
 
 	enum LinkType
 	{
@@ -74,6 +92,30 @@ protected:
 	} m_linkType;
 
 	int64_t m_timestampScale;
+
+	///@brief Contents of the input file (memory mapped where available, a heap copy otherwise)
+	const uint8_t* m_fileData;
+
+	///@brief Length of the input file, in bytes
+	size_t m_fileLen;
+
+	///@brief True if m_fileData is a live mmap mapping rather than heap memory
+	bool m_fileMapped;
+
+	///@brief Heap storage for the file contents on platforms without mmap
+	std::vector<uint8_t> m_fileBuf;
+
+	///@brief Background thread parsing packet blocks
+	std::thread m_loadThread;
+
+	///@brief Set to request the load thread stop early
+	std::atomic<bool> m_abortLoad;
+
+	///@brief True while the load thread is running
+	std::atomic<bool> m_loading;
+
+	///@brief Serializes load-thread appends against readers of the partially loaded output
+	std::mutex m_loadMutex;
 };
 
 #endif
@@ -37,11 +37,18 @@ using namespace std;
 
 PeakHoldFilter::PeakHoldFilter(const string& color)
 	: PeakDetectionFilter(color, CAT_MATH)
+	, m_decayname("Decay")
+	, m_computePipeline("shaders/PeakHoldFilter.spv", 2, sizeof(PeakHoldShaderArgs))
 {
 	AddStream(Unit(Unit::UNIT_VOLTS), "data", Stream::STREAM_TYPE_ANALOG);
 	CreateInput("din");
 
 	//Copy input unit
+
+	//Amount the held trace decays toward the input per update, in Y axis units.
+	//Zero gives classic infinite peak hold; nonzero gives a spectrum analyzer style decaying max trace.
+	m_parameters[m_decayname] = FilterParameter(FilterParameter::TYPE_FLOAT, Unit(Unit::UNIT_VOLTS));
+	m_parameters[m_decayname].SetFloatVal(0);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -75,6 +82,16 @@ void PeakHoldFilter::ClearSweeps()
 // Actual decoder logic
 
 void PeakHoldFilter::Refresh()
+{
+	DoRefresh(nullptr, nullptr);
+}
+
+void PeakHoldFilter::Refresh(vk::raii::CommandBuffer& cmdBuf, shared_ptr<QueueHandle> queue)
+{
+	DoRefresh(&cmdBuf, queue);
+}
+
+void PeakHoldFilter::DoRefresh(vk::raii::CommandBuffer* cmdBuf, shared_ptr<QueueHandle> queue)
 {
 	//Make sure we've got valid inputs
 	if(!VerifyAllInputsOK())
@@ -92,6 +109,7 @@ void PeakHoldFilter::Refresh()
 	//Create waveform if we don't have one already
 	size_t len = din->size();
 	bool first = false;
+	float decay = m_parameters[m_decayname].GetFloatVal();
 
 	auto sdin = dynamic_cast<SparseAnalogWaveform*>(din);
 	auto udin = dynamic_cast<UniformAnalogWaveform*>(din);
@@ -122,6 +140,9 @@ void PeakHoldFilter::Refresh()
 		//Copy timestamps from the input
 		cap->CopyTimestamps(sdin);
 
+		din->PrepareForCpuAccess();
+		cap->PrepareForCpuAccess();
+
 		//First waveform just copies the input
 		if(first)
 		{
@@ -133,9 +154,11 @@ void PeakHoldFilter::Refresh()
 		else
 		{
 			for(size_t i=0; i<len; i++)
-				cap->m_samples[i] = max((float)cap->m_samples[i], (float)sdin->m_samples[i]);
+				cap->m_samples[i] = max((float)cap->m_samples[i] - decay, (float)sdin->m_samples[i]);
 		}
 
+		cap->MarkModifiedFromCpu();
+
 		FindPeaks(cap);
 	}
 	else
@@ -161,6 +184,33 @@ void PeakHoldFilter::Refresh()
 		cap->m_startTimestamp = din->m_startTimestamp;
 		cap->m_startFemtoseconds = din->m_startFemtoseconds;
 
+		//Hold on the GPU if we can, keeping the accumulator GPU resident between updates
+		if(cmdBuf && g_gpuFilterEnabled)
+		{
+			udin->m_samples.PrepareForGpuAccess();
+			cap->m_samples.PrepareForGpuAccess();
+
+			PeakHoldShaderArgs args;
+			args.len = len;
+			args.first = first ? 1 : 0;
+			args.decay = decay;
+
+			cmdBuf->begin({});
+			m_computePipeline.BindBufferNonblocking(0, udin->m_samples, *cmdBuf);
+			m_computePipeline.BindBufferNonblocking(1, cap->m_samples, *cmdBuf, first);
+			m_computePipeline.Dispatch(*cmdBuf, args, GetComputeBlockCount(len, 64));
+			cmdBuf->end();
+			queue->SubmitAndBlock(*cmdBuf);
+			cap->m_samples.MarkModifiedFromGpu();
+
+			//Run the peak search against the buffer the hold pass just wrote
+			FindPeaks(cap, *cmdBuf, queue);
+			return;
+		}
+
+		din->PrepareForCpuAccess();
+		cap->PrepareForCpuAccess();
+
 		//First waveform just copies the input
 		if(first)
 		{
@@ -172,9 +222,11 @@ void PeakHoldFilter::Refresh()
 		else
 		{
 			for(size_t i=0; i<len; i++)
-				cap->m_samples[i] = max((float)cap->m_samples[i], (float)udin->m_samples[i]);
+				cap->m_samples[i] = max((float)cap->m_samples[i] - decay, (float)udin->m_samples[i]);
 		}
 
+		cap->MarkModifiedFromCpu();
+
 		FindPeaks(cap);
 	}
 }
@@ -35,12 +35,21 @@
 #ifndef PeakHoldFilter_h
 #define PeakHoldFilter_h
 
+///@brief Push constant block for the GPU peak hold path (must match PeakHoldFilter.glsl)
+struct PeakHoldShaderArgs
+{
+	uint32_t len;
+	uint32_t first;
+	float decay;
+};
+
 class PeakHoldFilter : public PeakDetectionFilter
 {
 public:
 	PeakHoldFilter(const std::string& color);
 
 	virtual void Refresh() override;
+	virtual void Refresh(vk::raii::CommandBuffer& cmdBuf, std::shared_ptr<QueueHandle> queue) override;
 
 	static std::string GetProtocolName();
 
@@ -51,6 +60,11 @@ public:
 	PROTOCOL_DECODER_INITPROC(PeakHoldFilter)
 
 protected:
+	void DoRefresh(vk::raii::CommandBuffer* cmdBuf, std::shared_ptr<QueueHandle> queue);
+
+	std::string m_decayname;
+
+	ComputePipeline m_computePipeline;
 };
 
 #endif
@@ -119,8 +119,9 @@ void PhaseMeasurement::Refresh()
 		vector<int64_t> durations;
 		for(size_t i=0; i<edgelen-2; i++)
 			durations.push_back(edges[i+2] - edges[i]);
-		std::sort(durations.begin(), durations.end());
-		period = durations[durations.size()/2];
+		auto mid = durations.begin() + durations.size()/2;
+		std::nth_element(durations.begin(), mid, durations.end());
+		period = *mid;
 	}
 
 	//Manual: use user-selected frequency
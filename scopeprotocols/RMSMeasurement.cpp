@@ -93,30 +93,18 @@ void RMSMeasurement::Refresh()
 	SetYAxisUnits(m_inputs[0].GetYAxisUnits(), 1);
 	auto length = din->size();
 
-	//Calculate the global RMS value
-	//Sum the squares of all values after subtracting the DC value
-	float temp = 0;
-	if(uadin)
-	{
-		for (size_t i = 0; i < length; i++)
-			temp += uadin->m_samples[i] * uadin->m_samples[i];
-	}
-	else if(sadin)
-	{
-		for (size_t i = 0; i < length; i++)
-			temp += sadin->m_samples[i] * sadin->m_samples[i];
-	}
-
-	//Divide by total number of samples and take the square root to get the final AC RMS
-	m_streams[1].m_value = sqrt(temp / length);
+	//Calculate the global RMS value from the fused single-pass statistics
+	//(shared with any other measurements of this waveform in the same pass)
+	auto stats = GetWaveformStats(sadin, uadin);
+	m_streams[1].m_value = sqrt(stats.m_sumSquares / length);
 
 	//Now we can do the cycle-by-cycle value
-	temp = 0;
+	float temp = 0;
 	vector<int64_t> edges;
 
 	//Auto-threshold analog signals at average value
 	//TODO: make threshold configurable?
-	float threshold = GetAvgVoltage(sadin, uadin);
+	float threshold = stats.m_sum / stats.m_count;
 	if(uadin)
 		FindZeroCrossings(uadin, threshold, edges);
 	else if(sadin)
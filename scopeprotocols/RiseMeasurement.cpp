@@ -119,50 +119,60 @@ void RiseMeasurement::Refresh()
 	cap->m_timescale = 1;
 	cap->PrepareForCpuAccess();
 
-	float last = 1e20;
-	double tedge = 0;
+	//Query the shared edge extraction cache for crossings of both levels,
+	//so the waveform is only scanned once per pass no matter how many filters measure it
+	vector<int64_t> startCrossings;
+	vector<int64_t> endCrossings;
+	if(udin)
+	{
+		FindZeroCrossings(udin, vstart, startCrossings);
+		FindZeroCrossings(udin, vend, endCrossings);
+	}
+	else
+	{
+		FindZeroCrossings(sdin, vstart, startCrossings);
+		FindZeroCrossings(sdin, vend, endCrossings);
+	}
 
-	int state = 0;
-	int64_t tlast = 0;
+	//Crossings of a level strictly alternate direction, so the polarity of the first one tells us all of them
+	bool firstStartRising = (len >= 2) && !(GetValue(sdin, udin, 1) > vstart);
 
 	//LogDebug("vstart = %.3f, vend = %.3f\n", vstart, vend);
 	double sum = 0;
 	int64_t num = 0;
-	for(size_t i=0; i < len; i++)
+	int64_t tlast = 0;
+	int64_t tdone = INT64_MIN;
+	size_t iend = 0;
+	for(size_t i=0; i < startCrossings.size(); i++)
 	{
-		float cur = GetValue(sdin, udin, i);
-		int64_t tnow = ::GetOffsetScaled(sdin, udin, i);
-
-		//Find start of edge
-		if(state == 0)
-		{
-			if( (cur > vstart) && (last <= vstart) )
-			{
-				tedge = tnow - din->m_timescale + InterpolateTime(sdin, udin, i-1, vstart)*din->m_timescale;
-				state = 1;
-			}
-		}
-
-		//Find end of edge
-		else if(state == 1)
-		{
-			if( (cur > vend) && (last <= vend) )
-			{
-				double dt = InterpolateTime(sdin, udin, i-1, vend)*din->m_timescale + tnow - din->m_timescale - tedge;
-
-				cap->m_offsets.push_back(tlast);
-				cap->m_durations.push_back(tnow-tlast);
-				cap->m_samples.push_back(dt);
-				tlast = tnow;
-
-				sum += dt;
-				num ++;
-
-				state = 0;
-			}
-		}
-
-		last = cur;
+		//Skip falling crossings of the start level
+		bool rising = (i & 1) ? !firstStartRising : firstStartRising;
+		if(!rising)
+			continue;
+
+		//Skip start crossings that occur before the previous edge finished
+		int64_t tedge = startCrossings[i];
+		if(tedge <= tdone)
+			continue;
+
+		//The first end-level crossing after the start must be in the same direction
+		//(we'd have to rise through it before we could fall back through it)
+		while( (iend < endCrossings.size()) && (endCrossings[iend] <= tedge) )
+			iend ++;
+		if(iend >= endCrossings.size())
+			break;
+		int64_t tend = endCrossings[iend];
+
+		double dt = tend - tedge;
+
+		cap->m_offsets.push_back(tlast);
+		cap->m_durations.push_back(tend - tlast);
+		cap->m_samples.push_back(dt);
+		tlast = tend;
+		tdone = tend;
+
+		sum += dt;
+		num ++;
 	}
 
 	SetData(cap, 0);
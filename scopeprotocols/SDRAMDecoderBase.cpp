@@ -116,3 +116,43 @@ string SDRAMWaveform::GetText(size_t i)
 			return "ERR";
 	}
 }
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Command stream compaction
+
+/**
+	@brief Rebuilds the compacted command stream if the waveform changed since the last call
+
+	Decoders call this once at the end of a decode pass; measurements call it before scanning (it's a no-op
+	if already current) so they work even on a waveform loaded from a session file.
+ */
+void SDRAMWaveform::BuildCommandStream()
+{
+	//no update needed
+	if(!m_cmdTimes.empty() && (m_cachedCommandRevision == m_revision) )
+		return;
+
+	m_cachedCommandRevision = m_revision;
+
+	PrepareForCpuAccess();
+
+	size_t len = m_samples.size();
+	m_cmdTimes.resize(len);
+	m_cmdTypes.resize(len);
+	m_cmdBanks.resize(len);
+	m_cmdTimes.PrepareForCpuAccess();
+	m_cmdTypes.PrepareForCpuAccess();
+	m_cmdBanks.PrepareForCpuAccess();
+
+	for(size_t i=0; i<len; i++)
+	{
+		auto& s = m_samples[i];
+		m_cmdTimes[i] = m_offsets[i] * m_timescale;
+		m_cmdTypes[i] = s.m_stype;
+		m_cmdBanks[i] = ( (s.m_bank >= 0) && (s.m_bank < 8) ) ? s.m_bank : INVALID_BANK;
+	}
+
+	m_cmdTimes.MarkModifiedFromCpu();
+	m_cmdTypes.MarkModifiedFromCpu();
+	m_cmdBanks.MarkModifiedFromCpu();
+}
@@ -74,9 +74,35 @@ public:
 class SDRAMWaveform : public SparseWaveform<SDRAMSymbol>
 {
 public:
-	SDRAMWaveform () : SparseWaveform<SDRAMSymbol>() {};
+	SDRAMWaveform ()
+	: SparseWaveform<SDRAMSymbol>()
+	, m_cachedCommandRevision(0)
+	{};
 	virtual std::string GetText(size_t) override;
 	virtual std::string GetColor(size_t) override;
+
+	void BuildCommandStream();
+
+	///@brief Bank value in m_cmdBanks for commands with no valid bank ID
+	static const uint8_t INVALID_BANK = 0xff;
+
+	//Compacted command stream, built once per decode by BuildCommandStream().
+	//Structure-of-arrays layout with timestamps pre-multiplied to femtoseconds, so a DRAM timing measurement
+	//is one linear scan over flat arrays instead of another walk of the symbol waveform; adding a new timing
+	//check to a long trace costs one pass over these buffers, not another decode.
+
+	///@brief Timestamp of each command, in femtoseconds (m_offsets pre-multiplied by m_timescale)
+	AcceleratorBuffer<int64_t> m_cmdTimes;
+
+	///@brief Opcode of each command (SDRAMSymbol::stype, one byte each)
+	AcceleratorBuffer<uint8_t> m_cmdTypes;
+
+	///@brief Bank ID of each command (INVALID_BANK if out of range)
+	AcceleratorBuffer<uint8_t> m_cmdBanks;
+
+protected:
+	///@brief Revision we last compacted the command stream of
+	uint64_t m_cachedCommandRevision;
 };
 
 class SDRAMDecoderBase : public Filter
@@ -0,0 +1,250 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopeprotocols                                                                                                    *
+*                                                                                                                      *
+* Copyright (c) 2012-2023 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+#include "../scopehal/scopehal.h"
+#include "SDRFrontEndFilter.h"
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Construction / destruction
+
+SDRFrontEndFilter::SDRFrontEndFilter(const string& color)
+	: Filter(color, CAT_RF)
+	, m_computePipeline("shaders/SDRFrontEnd.spv", 4, sizeof(SDRFrontEndArgs))
+{
+	//Set up channels
+	CreateInput("RF");
+	AddStream(Unit(Unit::UNIT_VOLTS), "I", Stream::STREAM_TYPE_ANALOG);
+	AddStream(Unit(Unit::UNIT_VOLTS), "Q", Stream::STREAM_TYPE_ANALOG);
+
+	//Optional input for LO frequency (overrides parameter)
+	CreateInput("LOFrequency");
+
+	m_freqname = "LO Frequency";
+	m_parameters[m_freqname] = FilterParameter(FilterParameter::TYPE_FLOAT, Unit(Unit::UNIT_HZ));
+	m_parameters[m_freqname].SetFloatVal(1e9);
+
+	m_factorname = "Decimation Factor";
+	m_parameters[m_factorname] = FilterParameter(FilterParameter::TYPE_INT, Unit(Unit::UNIT_COUNTS));
+	m_parameters[m_factorname].SetIntVal(10);
+
+	m_thresholdname = "Squelch Threshold";
+	m_parameters[m_thresholdname] = FilterParameter(FilterParameter::TYPE_FLOAT, Unit(Unit::UNIT_VOLTS));
+	m_parameters[m_thresholdname].SetFloatVal(0);
+
+	m_holdtimename = "Hold time";
+	m_parameters[m_holdtimename] = FilterParameter(FilterParameter::TYPE_INT, Unit(Unit::UNIT_FS));
+	m_parameters[m_holdtimename].SetIntVal(1e6);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Factory methods
+
+bool SDRFrontEndFilter::ValidateChannel(size_t i, StreamDescriptor stream)
+{
+	if(stream.m_channel == NULL)
+		return false;
+
+	if( (i == 0) && (stream.GetType() == Stream::STREAM_TYPE_ANALOG) )
+		return true;
+	if( (i == 1) && (stream.GetType() == Stream::STREAM_TYPE_ANALOG_SCALAR) )
+		return true;
+
+	return false;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Accessors
+
+string SDRFrontEndFilter::GetProtocolName()
+{
+	return "SDR Front End";
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Actual decoder logic
+
+void SDRFrontEndFilter::Refresh(vk::raii::CommandBuffer& cmdBuf, shared_ptr<QueueHandle> queue)
+{
+	//Get the input data
+	auto din = dynamic_cast<UniformAnalogWaveform*>(GetInputWaveform(0));
+	if(!din)
+	{
+		SetData(NULL, 0);
+		SetData(NULL, 1);
+		return;
+	}
+	size_t len = din->size();
+
+	int64_t factor = m_parameters[m_factorname].GetIntVal();
+	if(factor == 0)
+	{
+		// Occurs momentarily while editing the value sometimes in glscopeclient
+		return;
+	}
+	size_t outlen = len / factor;
+
+	//Get LO frequency
+	//(input channel overrides parameter)
+	double lo_freq = m_parameters[m_freqname].GetFloatVal();
+	auto loin = GetInput(1);
+	if(loin)
+		lo_freq = loin.GetScalarValue();
+
+	//Track the LO phase as a 32-bit fixed point fraction of a cycle, advanced per input sample.
+	//A float accumulator loses precision after a few hundred thousand cycles of LO; the fixed point phase wraps
+	//for free on integer overflow and keeps the same ~2^-24 cycle resolution at sample one billion as at sample one.
+	double lo_cycles_per_sample = lo_freq * din->m_timescale / FS_PER_SECOND;
+	double lo_cycles_at_trigger = din->m_triggerPhase * lo_freq / FS_PER_SECOND;
+	const double fixedPointScale = 4294967296.0;	//2^32
+	uint32_t phase_step = static_cast<uint32_t>(
+		round( (lo_cycles_per_sample - floor(lo_cycles_per_sample)) * fixedPointScale));
+	uint32_t phase_offset = static_cast<uint32_t>(
+		round( (lo_cycles_at_trigger - floor(lo_cycles_at_trigger)) * fixedPointScale));
+
+	//Create the antialiasing kernel (no-op if factor is unchanged)
+	m_resampler.ConfigureDecimation(factor);
+
+	//Set up output waveforms at the decimated rate
+	auto dout_i = SetupEmptyUniformAnalogOutputWaveform(din, 0);
+	auto dout_q = SetupEmptyUniformAnalogOutputWaveform(din, 1);
+	dout_i->Resize(outlen);
+	dout_q->Resize(outlen);
+
+	if(g_gpuFilterEnabled)
+	{
+		cmdBuf.begin({});
+
+		SDRFrontEndArgs args;
+		args.outlen = outlen;
+		args.inlen = len;
+		args.decimation = factor;
+		args.filterlen = m_resampler.GetTapsPerPhase();
+		args.center = m_resampler.GetCenter();
+		args.phaseStep = phase_step;
+		args.phaseOffset = phase_offset;
+
+		m_computePipeline.BindBufferNonblocking(0, din->m_samples, cmdBuf);
+		m_computePipeline.BindBufferNonblocking(1, m_resampler.GetCoefficients(), cmdBuf);
+		m_computePipeline.BindBufferNonblocking(2, dout_i->m_samples, cmdBuf, true);
+		m_computePipeline.BindBufferNonblocking(3, dout_q->m_samples, cmdBuf, true);
+		m_computePipeline.Dispatch(cmdBuf, args, GetComputeBlockCount(outlen, 64));
+
+		cmdBuf.end();
+		queue->SubmitAndBlock(cmdBuf);
+
+		dout_i->MarkModifiedFromGpu();
+		dout_q->MarkModifiedFromGpu();
+	}
+
+	else
+	{
+		din->PrepareForCpuAccess();
+		dout_i->PrepareForCpuAccess();
+		dout_q->PrepareForCpuAccess();
+
+		auto& taps = m_resampler.GetCoefficients();
+		taps.PrepareForCpuAccess();
+		size_t filterlen = m_resampler.GetTapsPerPhase();
+		int64_t center = m_resampler.GetCenter();
+		const double radPerFixedPointLsb = 2 * M_PI / fixedPointScale;
+
+		for(size_t j=0; j<outlen; j++)
+		{
+			int64_t base = j * factor;
+			float acc_i = 0;
+			float acc_q = 0;
+			for(size_t t=0; t<filterlen; t++)
+			{
+				int64_t idx = base + t - center;
+				if( (idx < 0) || (idx >= (int64_t)len) )
+					continue;
+
+				uint32_t phase_fp = phase_step * static_cast<uint32_t>(idx) + phase_offset;
+				double phase = phase_fp * radPerFixedPointLsb;
+				float samp = din->m_samples[idx] * taps[t];
+				acc_i += samp * sin(phase);
+				acc_q += samp * cos(phase);
+			}
+			dout_i->m_samples[j] = acc_i;
+			dout_q->m_samples[j] = acc_q;
+		}
+
+		dout_i->MarkModifiedFromCpu();
+		dout_q->MarkModifiedFromCpu();
+	}
+
+	//Copy our time scales from the input
+	dout_i->m_timescale = din->m_timescale * factor;
+	dout_q->m_timescale = din->m_timescale * factor;
+
+	//Apply the squelch to the decimated output.
+	//The hold time hysteresis is inherently serial, but at 1/factor the rate it's cheap enough to leave on the CPU.
+	auto threshold = m_parameters[m_thresholdname].GetFloatVal();
+	if(threshold > 0)
+	{
+		dout_i->PrepareForCpuAccess();
+		dout_q->PrepareForCpuAccess();
+
+		auto holdtime_fs = m_parameters[m_holdtimename].GetIntVal();
+		size_t holdtime_samples = holdtime_fs / dout_i->m_timescale;
+
+		bool open = false;
+		float tsq = threshold * threshold;
+		size_t topen = 0;
+		for(size_t i=0; i<outlen; i++)
+		{
+			//Find I/Q magnitude (do comparison on squared mag to avoid a ton of sqrts)
+			float vi = dout_i->m_samples[i];
+			float vq = dout_q->m_samples[i];
+			float msq = vi*vi + vq*vq;
+
+			//Signal amplitude is above threshold - open squelch immediately
+			if(msq > tsq)
+			{
+				open = true;
+				topen = i;
+			}
+
+			//Signal amplitude below threshold - close squelch after hold time elapses
+			else if(open && ( (i - topen) > holdtime_samples) )
+				open = false;
+
+			if(!open)
+			{
+				dout_i->m_samples[i] = 0.0f;
+				dout_q->m_samples[i] = 0.0f;
+			}
+		}
+
+		dout_i->MarkModifiedFromCpu();
+		dout_q->MarkModifiedFromCpu();
+	}
+}
@@ -0,0 +1,88 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopeprotocols                                                                                                    *
+*                                                                                                                      *
+* Copyright (c) 2012-2023 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Declaration of SDRFrontEndFilter
+ */
+#ifndef SDRFrontEndFilter_h
+#define SDRFrontEndFilter_h
+
+class QueueHandle;
+
+///@brief Push constants for the fused SDR front end shader
+struct SDRFrontEndArgs
+{
+	uint32_t outlen;
+	uint32_t inlen;
+	uint32_t decimation;
+	uint32_t filterlen;
+	int32_t center;
+	uint32_t phaseStep;
+	uint32_t phaseOffset;
+};
+
+/**
+	@brief Fused SDR front end - downconvert, antialias, and decimate in a single pass
+
+	Equivalent to the cascade DownconvertFilter -> DownsampleFilter (x2, one per I/Q leg) -> IQSquelchFilter, but
+	the mixer and decimating FIR run in one GPU dispatch that only ever writes samples at the decimated rate, so the
+	full rate I/Q intermediates never touch memory. The LO phase is tracked as a 32-bit fixed point fraction of a
+	cycle, so phase accuracy does not degrade at large sample indices the way a single precision accumulator would.
+
+	The squelch is a serial hysteresis and runs on the CPU, but over the decimated output, so it costs 1/decimation
+	as much as a standalone IQSquelchFilter at the input rate.
+ */
+class SDRFrontEndFilter : public Filter
+{
+public:
+	SDRFrontEndFilter(const std::string& color);
+
+	virtual void Refresh(vk::raii::CommandBuffer& cmdBuf, std::shared_ptr<QueueHandle> queue) override;
+
+	static std::string GetProtocolName();
+
+	virtual bool ValidateChannel(size_t i, StreamDescriptor stream) override;
+
+	PROTOCOL_DECODER_INITPROC(SDRFrontEndFilter)
+
+protected:
+	std::string m_freqname;
+	std::string m_factorname;
+	std::string m_thresholdname;
+	std::string m_holdtimename;
+
+	///@brief Provides the Gaussian antialiasing kernel (we run our own fused dispatch rather than its FIR)
+	PolyphaseResampler m_resampler;
+
+	ComputePipeline m_computePipeline;
+};
+
+#endif
@@ -68,6 +68,13 @@ string ScaleFilter::GetProtocolName()
 	return "Scale";
 }
 
+bool ScaleFilter::GetElementwiseOperation(ElementwiseOperation& op)
+{
+	op.m_op = ElementwiseOperation::OP_MULTIPLY;
+	op.m_operand = m_parameters[m_scalefactorname].GetFloatVal();
+	return true;
+}
+
 void ScaleFilter::SetDefaultName()
 {
 	char hwname[256];
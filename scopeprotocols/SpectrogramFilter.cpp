@@ -59,9 +59,8 @@ SpectrogramFilter::SpectrogramFilter(const string& color)
 	, m_fftLengthName("FFT length")
 	, m_rangeMinName("Range Min")
 	, m_rangeMaxName("Range Max")
-	, m_blackmanHarrisComputePipeline("shaders/BlackmanHarrisWindow.spv", 2, sizeof(WindowFunctionArgs))
-	, m_rectangularComputePipeline("shaders/RectangularWindow.spv", 2, sizeof(WindowFunctionArgs))
-	, m_cosineSumComputePipeline("shaders/CosineSumWindow.spv", 2, sizeof(WindowFunctionArgs))
+	, m_cachedWindowType(FFTFilter::WINDOW_RECTANGULAR)
+	, m_applyWindowComputePipeline("shaders/ApplyWindow.spv", 3, sizeof(ApplyWindowArgs))
 	, m_postprocessComputePipeline("shaders/SpectrogramPostprocess.spv", 2, sizeof(SpectrogramPostprocessArgs))
 {
 	AddStream(Unit(Unit::UNIT_HZ), "data", Stream::STREAM_TYPE_SPECTROGRAM);
@@ -163,7 +162,7 @@ void SpectrogramFilter::ReallocateBuffers(size_t fftlen, size_t nblocks)
 			m_vkPlan = nullptr;
 	}
 	if(!m_vkPlan)
-		m_vkPlan = make_unique<VulkanFFTPlan>(fftlen, nouts, VulkanFFTPlan::DIRECTION_FORWARD, nblocks);
+		m_vkPlan = g_vkFFTPlanCache.Acquire(fftlen, nouts, VulkanFFTPlan::DIRECTION_FORWARD, nblocks);
 
 	m_rdinbuf.SetCpuAccessHint(AcceleratorBuffer<float>::HINT_NEVER);
 	m_rdinbuf.SetGpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
@@ -263,44 +262,11 @@ void SpectrogramFilter::Refresh(vk::raii::CommandBuffer& cmdBuf, shared_ptr<Queu
 			break;
 	}
 
-	//Configure the window
-	WindowFunctionArgs args;
-	args.numActualSamples = fftlen;
-	args.npoints = fftlen;
-	args.scale = 2 * M_PI / fftlen;
-	switch(window)
+	//Get the shared window coefficients (computed once process-wide, shared read-only across instances)
+	if(!m_windowBuf || (m_windowBuf->size() != fftlen) || (window != m_cachedWindowType))
 	{
-		case FFTFilter::WINDOW_HANN:
-			args.alpha0 = 0.5;
-			break;
-
-		case FFTFilter::WINDOW_HAMMING:
-			args.alpha0 = 25.0f / 46;
-			break;
-
-		default:
-			args.alpha0 = 0;
-			break;
-	}
-	args.alpha1 = 1 - args.alpha0;
-
-	//Figure out which window shader to use
-	ComputePipeline* wpipe = nullptr;
-	switch(window)
-	{
-		case FFTFilter::WINDOW_BLACKMAN_HARRIS:
-			wpipe = &m_blackmanHarrisComputePipeline;
-			break;
-
-		case FFTFilter::WINDOW_HANN:
-		case FFTFilter::WINDOW_HAMMING:
-			wpipe = &m_cosineSumComputePipeline;
-			break;
-
-		default:
-		case FFTFilter::WINDOW_RECTANGULAR:
-			wpipe = &m_rectangularComputePipeline;
-			break;
+		m_windowBuf = g_windowFunctionCache.Acquire(window, fftlen);
+		m_cachedWindowType = window;
 	}
 
 	//Make sure our temporary buffers are big enough
@@ -315,20 +281,16 @@ void SpectrogramFilter::Refresh(vk::raii::CommandBuffer& cmdBuf, shared_ptr<Queu
 	//Prepare to do all of our compute stuff in one dispatch call to reduce overhead
 	cmdBuf.begin({});
 
-	//Grab the input and apply the window function
-	wpipe->BindBufferNonblocking(0, din->m_samples, cmdBuf);
-	wpipe->BindBufferNonblocking(1, m_rdinbuf, cmdBuf, true);
-	for(size_t block=0; block<nblocks; block++)
-	{
-		args.offsetIn = block*fftlen;
-		args.offsetOut = block*fftlen;
-
-		if(block == 0)
-			wpipe->Dispatch(cmdBuf, args, GetComputeBlockCount(fftlen, 64));
-		else
-			wpipe->DispatchNoRebind(cmdBuf, args, GetComputeBlockCount(fftlen, 64));
-	}
-	wpipe->AddComputeMemoryBarrier(cmdBuf);
+	//Grab the input and apply the window function (all blocks in one dispatch)
+	ApplyWindowArgs args;
+	args.npoints = nblocks * fftlen;
+	args.fftlen = fftlen;
+	args.offsetIn = 0;
+	m_applyWindowComputePipeline.BindBufferNonblocking(0, din->m_samples, cmdBuf);
+	m_applyWindowComputePipeline.BindBufferNonblocking(1, m_rdinbuf, cmdBuf, true);
+	m_applyWindowComputePipeline.BindBufferNonblocking(2, *m_windowBuf, cmdBuf);
+	m_applyWindowComputePipeline.Dispatch(cmdBuf, args, GetComputeBlockCount(args.npoints, 64));
+	m_applyWindowComputePipeline.AddComputeMemoryBarrier(cmdBuf);
 
 	//Do the actual FFT
 	m_vkPlan->AppendForward(
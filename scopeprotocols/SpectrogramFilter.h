@@ -38,6 +38,7 @@
 #include "VulkanFFTPlan.h"
 
 #include "../scopehal/DensityFunctionWaveform.h"
+#include "WindowFunctionCache.h"
 
 struct SpectrogramPostprocessArgs
 {
@@ -108,11 +109,15 @@ protected:
 	std::string m_rangeMinName;
 	std::string m_rangeMaxName;
 
-	std::unique_ptr<VulkanFFTPlan> m_vkPlan;
+	std::shared_ptr<VulkanFFTPlan> m_vkPlan;
 
-	ComputePipeline m_blackmanHarrisComputePipeline;
-	ComputePipeline m_rectangularComputePipeline;
-	ComputePipeline m_cosineSumComputePipeline;
+	///@brief Shared window coefficients from the process-wide cache (bound read-only)
+	std::shared_ptr<AcceleratorBuffer<float>> m_windowBuf;
+
+	///@brief Window type m_windowBuf was acquired for
+	FFTFilter::WindowFunction m_cachedWindowType;
+
+	ComputePipeline m_applyWindowComputePipeline;
 
 	ComputePipeline m_postprocessComputePipeline;
 };
@@ -78,6 +78,9 @@ string SubtractFilter::GetProtocolName()
 
 void SubtractFilter::Refresh(vk::raii::CommandBuffer& cmdBuf, shared_ptr<QueueHandle> queue)
 {
+	//Snapshot the inputs once up front (no-op cost if the executor already did it at pass setup)
+	ResolveInputWaveforms();
+
 	//Set units as early as possible so we can spawn in the same plot as our parent signal when creating a filter
 	if(GetInput(0))
 	{
@@ -85,8 +88,8 @@ void SubtractFilter::Refresh(vk::raii::CommandBuffer& cmdBuf, shared_ptr<QueueHa
 		SetYAxisUnits(m_inputs[0].GetYAxisUnits(), 0);
 	}
 
-	bool veca = GetInput(0).GetType() == Stream::STREAM_TYPE_ANALOG;
-	bool vecb = GetInput(1).GetType() == Stream::STREAM_TYPE_ANALOG;
+	bool veca = GetResolvedInput(0).m_type == Stream::STREAM_TYPE_ANALOG;
+	bool vecb = GetResolvedInput(1).m_type == Stream::STREAM_TYPE_ANALOG;
 
 	if(veca && vecb)
 		DoRefreshVectorVector(cmdBuf, queue);
@@ -107,7 +110,7 @@ void SubtractFilter::DoRefreshScalarScalar()
 	//Subtract value
 	//TODO: how to handle unequal units?
 	m_streams[0].m_yAxisUnit = GetInput(0).GetYAxisUnits();
-	m_streams[0].m_value = GetInput(0).GetScalarValue() - GetInput(1).GetScalarValue();
+	m_streams[0].m_value = GetResolvedInput(0).m_scalarValue - GetResolvedInput(1).m_scalarValue;
 }
 
 void SubtractFilter::DoRefreshVectorVector(vk::raii::CommandBuffer& cmdBuf, std::shared_ptr<QueueHandle> queue)
@@ -120,8 +123,8 @@ void SubtractFilter::DoRefreshVectorVector(vk::raii::CommandBuffer& cmdBuf, std:
 	}
 
 	//Get inputs
-	auto din_p = GetInputWaveform(0);
-	auto din_n = GetInputWaveform(1);
+	auto din_p = GetResolvedInputWaveform(0);
+	auto din_n = GetResolvedInputWaveform(1);
 	auto sdin_p = dynamic_cast<SparseAnalogWaveform*>(din_p);
 	auto sdin_n = dynamic_cast<SparseAnalogWaveform*>(din_n);
 	auto udin_p = dynamic_cast<UniformAnalogWaveform*>(din_p);
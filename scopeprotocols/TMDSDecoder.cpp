@@ -188,6 +188,7 @@ void TMDSDecoder::Refresh()
 				cap->m_offsets.push_back(sampdata.m_offsets[i]);
 				cap->m_durations.push_back(sampdata.m_offsets[i+10] - sampdata.m_offsets[i]);
 				cap->m_samples.push_back(TMDSSymbol(TMDSSymbol::TMDS_TYPE_CONTROL, j));
+				cap->m_paletteIndices.push_back(TMDSSymbol::TMDS_TYPE_CONTROL);
 
 				last_symbol_type = TYPE_PREAMBLE;
 				break;
@@ -212,6 +213,7 @@ void TMDSDecoder::Refresh()
 				cap->m_offsets.push_back(sampdata.m_offsets[i]);
 				cap->m_durations.push_back(sampdata.m_offsets[i+10] - sampdata.m_offsets[i]);
 				cap->m_samples.push_back(TMDSSymbol(TMDSSymbol::TMDS_TYPE_GUARD, 0));
+				cap->m_paletteIndices.push_back(TMDSSymbol::TMDS_TYPE_GUARD);
 				//last_symbol_type = TYPE_GUARD;
 				break;
 			}
@@ -244,6 +246,7 @@ void TMDSDecoder::Refresh()
 		cap->m_offsets.push_back(sampdata.m_offsets[i]);
 		cap->m_durations.push_back(sampdata.m_offsets[i+10] - sampdata.m_offsets[i]);
 		cap->m_samples.push_back(TMDSSymbol(TMDSSymbol::TMDS_TYPE_DATA, d));
+		cap->m_paletteIndices.push_back(TMDSSymbol::TMDS_TYPE_DATA);
 		last_symbol_type = TYPE_DATA;
 	}
 
@@ -251,27 +254,6 @@ void TMDSDecoder::Refresh()
 	cap->MarkModifiedFromCpu();
 }
 
-std::string TMDSWaveform::GetColor(size_t i)
-{
-	const TMDSSymbol& s = m_samples[i];
-
-	switch(s.m_type)
-	{
-		case TMDSSymbol::TMDS_TYPE_CONTROL:
-			return StandardColors::colors[StandardColors::COLOR_CONTROL];
-
-		case TMDSSymbol::TMDS_TYPE_GUARD:
-			return StandardColors::colors[StandardColors::COLOR_PREAMBLE];
-
-		case TMDSSymbol::TMDS_TYPE_DATA:
-			return StandardColors::colors[StandardColors::COLOR_DATA];
-
-		case TMDSSymbol::TMDS_TYPE_ERROR:
-		default:
-			return StandardColors::colors[StandardColors::COLOR_ERROR];
-	}
-}
-
 string TMDSWaveform::GetText(size_t i)
 {
 	const TMDSSymbol& s = m_samples[i];
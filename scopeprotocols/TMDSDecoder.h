@@ -68,9 +68,15 @@ public:
 class TMDSWaveform : public SparseWaveform<TMDSSymbol>
 {
 public:
-	TMDSWaveform () : SparseWaveform<TMDSSymbol>() {};
+	TMDSWaveform () : SparseWaveform<TMDSSymbol>()
+	{
+		//Palette indexed by TMDSSymbol::TMDSType; the decoder writes one index per sample
+		m_colorPalette.push_back(StandardColors::colors[StandardColors::COLOR_CONTROL]);
+		m_colorPalette.push_back(StandardColors::colors[StandardColors::COLOR_PREAMBLE]);
+		m_colorPalette.push_back(StandardColors::colors[StandardColors::COLOR_ERROR]);
+		m_colorPalette.push_back(StandardColors::colors[StandardColors::COLOR_DATA]);
+	};
 	virtual std::string GetText(size_t) override;
-	virtual std::string GetColor(size_t) override;
 };
 
 class TMDSDecoder : public Filter
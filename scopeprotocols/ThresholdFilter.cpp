@@ -28,15 +28,27 @@
 ***********************************************************************************************************************/
 
 #include "../scopehal/scopehal.h"
+#include "../scopehal/ThresholdKernel.h"
 #include "ThresholdFilter.h"
 
 using namespace std;
 
+namespace
+{
+	///@brief Push constants for the ThresholdWaveform shader
+	struct ThresholdShaderArgs
+	{
+		uint32_t size;
+		float midpoint;
+	};
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Construction / destruction
 
 ThresholdFilter::ThresholdFilter(const string& color)
 	: Filter(color, CAT_MATH)
+	, m_computePipeline("shaders/ThresholdWaveform.spv", 2, sizeof(ThresholdShaderArgs))
 {
 	AddDigitalStream("data");
 	CreateInput("din");
@@ -72,10 +84,16 @@ string ThresholdFilter::GetProtocolName()
 	return "Threshold";
 }
 
+Filter::DataLocation ThresholdFilter::GetInputLocation()
+{
+	//We explicitly manage our input memory and don't care where it is when Refresh() is called
+	return LOC_DONTCARE;
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Actual decoder logic
 
-void ThresholdFilter::Refresh()
+void ThresholdFilter::Refresh(vk::raii::CommandBuffer& cmdBuf, shared_ptr<QueueHandle> queue)
 {
 	if(!VerifyAllInputsOK())
 	{
@@ -91,39 +109,51 @@ void ThresholdFilter::Refresh()
 	float midpoint = m_parameters[m_threshname].GetFloatVal();
 	float hys = m_parameters[m_hysname].GetFloatVal();
 
-	din->PrepareForCpuAccess();
-
 	auto sdin = dynamic_cast<SparseAnalogWaveform*>(din);
 	auto udin = dynamic_cast<UniformAnalogWaveform*>(din);
 
+	//GPU path: thresholding a uniform waveform with no hysteresis is a pure elementwise map
+	if(udin && (hys == 0) && g_gpuFilterEnabled && g_hasShaderInt8 && g_hasPushDescriptor)
+	{
+		auto cap = SetupEmptyUniformDigitalOutputWaveform(din, 0);
+		cap->Resize(len);
+
+		ThresholdShaderArgs args;
+		args.size = len;
+		args.midpoint = midpoint;
+
+		cmdBuf.begin({});
+		m_computePipeline.BindBufferNonblocking(0, udin->m_samples, cmdBuf);
+		m_computePipeline.BindBufferNonblocking(1, cap->m_samples, cmdBuf, true);
+		m_computePipeline.Dispatch(cmdBuf, args, GetComputeBlockCount(len, 64));
+		cmdBuf.end();
+		SubmitOrDefer(cmdBuf, queue);
+
+		cap->m_samples.MarkModifiedFromGpu();
+		return;
+	}
+
+	//CPU path: vectorized kernels from ThresholdKernel
+	din->PrepareForCpuAccess();
+
+	float thresh_rising = midpoint + hys/2;
+	float thresh_falling = midpoint - hys/2;
+
 	if(sdin)
 	{
 		auto cap = SetupSparseDigitalOutputWaveform(sdin, 0, 0, 0);
 		cap->PrepareForCpuAccess();
 
-		//Threshold all of our samples
-		//Optimized inner loop if no hysteresis
 		if(hys == 0)
 		{
-			#pragma omp parallel for
-			for(size_t i=0; i<len; i++)
-				cap->m_samples[i] = sdin->m_samples[i] > midpoint;
+			ThresholdKernel::Threshold(
+				sdin->m_samples.GetCpuPointer(), cap->m_samples.GetCpuPointer(), len, midpoint);
 		}
 		else
 		{
-			bool cur = sdin->m_samples[0] > midpoint;
-			float thresh_rising = midpoint + hys/2;
-			float thresh_falling = midpoint - hys/2;
-
-			for(size_t i=0; i<len; i++)
-			{
-				float f = sdin->m_samples[i];
-				if(cur && (f < thresh_falling))
-					cur = false;
-				else if(!cur && (f > thresh_rising))
-					cur = true;
-				cap->m_samples[i] = cur;
-			}
+			ThresholdKernel::ThresholdWithHysteresis(
+				sdin->m_samples.GetCpuPointer(), cap->m_samples.GetCpuPointer(), len,
+				thresh_rising, thresh_falling, (len > 0) && (sdin->m_samples[0] > midpoint));
 		}
 
 		cap->MarkModifiedFromCpu();
@@ -134,29 +164,16 @@ void ThresholdFilter::Refresh()
 		cap->Resize(len);
 		cap->PrepareForCpuAccess();
 
-		//Threshold all of our samples
-		//Optimized inner loop if no hysteresis
 		if(hys == 0)
 		{
-			#pragma omp parallel for
-			for(size_t i=0; i<len; i++)
-				cap->m_samples[i] = udin->m_samples[i] > midpoint;
+			ThresholdKernel::Threshold(
+				udin->m_samples.GetCpuPointer(), cap->m_samples.GetCpuPointer(), len, midpoint);
 		}
 		else
 		{
-			bool cur = udin->m_samples[0] > midpoint;
-			float thresh_rising = midpoint + hys/2;
-			float thresh_falling = midpoint - hys/2;
-
-			for(size_t i=0; i<len; i++)
-			{
-				float f = udin->m_samples[i];
-				if(cur && (f < thresh_falling))
-					cur = false;
-				else if(!cur && (f > thresh_rising))
-					cur = true;
-				cap->m_samples[i] = cur;
-			}
+			ThresholdKernel::ThresholdWithHysteresis(
+				udin->m_samples.GetCpuPointer(), cap->m_samples.GetCpuPointer(), len,
+				thresh_rising, thresh_falling, (len > 0) && (udin->m_samples[0] > midpoint));
 		}
 
 		cap->MarkModifiedFromCpu();
@@ -35,12 +35,15 @@
 #ifndef ThresholdFilter_h
 #define ThresholdFilter_h
 
+class QueueHandle;
+
 class ThresholdFilter : public Filter
 {
 public:
 	ThresholdFilter(const std::string& color);
 
-	virtual void Refresh() override;
+	virtual void Refresh(vk::raii::CommandBuffer& cmdBuf, std::shared_ptr<QueueHandle> queue) override;
+	virtual DataLocation GetInputLocation() override;
 
 	static std::string GetProtocolName();
 
@@ -51,6 +54,8 @@ public:
 protected:
 	std::string m_threshname;
 	std::string m_hysname;
+
+	ComputePipeline m_computePipeline;
 };
 
 #endif
@@ -118,34 +118,38 @@ void TopMeasurement::Refresh()
 	int64_t count = 0;
 	float delta = range * 0.1;
 
-	for(size_t i=0; i < len; i++)
+	//Main loop is dispatched on the concrete waveform type so the per-sample accessors resolve at compile time
+	DispatchAnalogKernel(din, [&](auto* wfm)
 	{
-		//Wait for a rising edge
-		float cur = GetValue(sdin, udin, i);
-		int64_t tnow = ::GetOffsetScaled(sdin, udin, i);
-
-		if( (cur > midpoint) && (last <= midpoint) )
+		for(size_t i=0; i < len; i++)
 		{
-			//Done, add the sample
-			if(count != 0)
+			//Wait for a rising edge
+			float cur = wfm->m_samples[i];
+			int64_t tnow = ::GetOffsetScaled(wfm, i);
+
+			if( (cur > midpoint) && (last <= midpoint) )
 			{
-				cap->m_offsets.push_back(tedge);
-				cap->m_durations.push_back(tnow - tedge);
-				cap->m_samples.push_back(sum / count);
+				//Done, add the sample
+				if(count != 0)
+				{
+					cap->m_offsets.push_back(tedge);
+					cap->m_durations.push_back(tnow - tedge);
+					cap->m_samples.push_back(sum / count);
+				}
+				tedge = tnow;
 			}
-			tedge = tnow;
-		}
 
-		//If the value is fairly close to the calculated top, average it
-		//TODO: discard samples on the rising/falling edges as this will skew the results
-		if(fabs(cur - global_top) < delta)
-		{
-			count ++;
-			sum += cur;
-		}
+			//If the value is fairly close to the calculated top, average it
+			//TODO: discard samples on the rising/falling edges as this will skew the results
+			if(fabs(cur - global_top) < delta)
+			{
+				count ++;
+				sum += cur;
+			}
 
-		last = cur;
-	}
+			last = cur;
+		}
+	});
 
 	SetData(cap, 0);
 
@@ -40,6 +40,9 @@ TouchstoneExportFilter::TouchstoneExportFilter(const string& color)
 	, m_portCount("Ports")
 	, m_freqUnit("Frequency unit")
 	, m_format("Format")
+	, m_minExportFreq("Min Frequency")
+	, m_maxExportFreq("Max Frequency")
+	, m_exportDecimation("Decimation")
 {
 	m_parameters[m_fname].m_fileFilterMask = "*.s*p";
 	m_parameters[m_fname].m_fileFilterName = "Touchstone S-parameter files (*.s*p)";
@@ -61,6 +64,17 @@ TouchstoneExportFilter::TouchstoneExportFilter(const string& color)
 	m_parameters[m_format].AddEnumValue("Real / imaginary", SParameters::FORMAT_REAL_IMAGINARY);
 	m_parameters[m_format].SetIntVal(SParameters::FORMAT_MAG_ANGLE);
 
+	//Export windowing: clip to a frequency band and/or decimate at export time
+	//(0 in Max Frequency = no upper limit)
+	m_parameters[m_minExportFreq] = FilterParameter(FilterParameter::TYPE_FLOAT, Unit(Unit::UNIT_HZ));
+	m_parameters[m_minExportFreq].SetFloatVal(0);
+
+	m_parameters[m_maxExportFreq] = FilterParameter(FilterParameter::TYPE_FLOAT, Unit(Unit::UNIT_HZ));
+	m_parameters[m_maxExportFreq].SetFloatVal(0);
+
+	m_parameters[m_exportDecimation] = FilterParameter(FilterParameter::TYPE_INT, Unit(Unit::UNIT_COUNTS));
+	m_parameters[m_exportDecimation].SetIntVal(1);
+
 	OnPortCountChanged();
 }
 
@@ -193,11 +207,19 @@ void TouchstoneExportFilter::Export()
 	auto format = static_cast<SParameters::ParameterFormat>(m_parameters[m_format].GetIntVal());
 	auto freqUnit = static_cast<SParameters::FreqUnit>(m_parameters[m_freqUnit].GetIntVal());
 
+	SParameters::ExportWindow window;
+	window.m_minFreq = m_parameters[m_minExportFreq].GetFloatVal();
+	float maxFreq = m_parameters[m_maxExportFreq].GetFloatVal();
+	if(maxFreq > 0)
+		window.m_maxFreq = maxFreq;
+	window.m_decimation = max(m_parameters[m_exportDecimation].GetIntVal(), static_cast<int64_t>(1));
+
 	//Done, save it
 	params.SaveToFile(
 		m_parameters[m_fname].GetFileName(),
 		format,
-		freqUnit);
+		freqUnit,
+		window);
 }
 
 void TouchstoneExportFilter::OnPortCountChanged()
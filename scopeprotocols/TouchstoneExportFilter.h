@@ -57,6 +57,10 @@ protected:
 
 	std::string m_freqUnit;
 	std::string m_format;
+
+	std::string m_minExportFreq;
+	std::string m_maxExportFreq;
+	std::string m_exportDecimation;
 };
 
 #endif
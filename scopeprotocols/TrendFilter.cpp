@@ -100,18 +100,7 @@ void TrendFilter::Refresh(vk::raii::CommandBuffer& /*cmdBuf*/, std::shared_ptr<Q
 	//See if we have output already
 	double now = GetTime();
 	auto wfm = dynamic_cast<SparseAnalogWaveform*>(GetData(0));
-	if(wfm)
-	{
-		//Remove old samples
-		size_t nmax = m_parameters[m_depthname].GetIntVal();
-		while(wfm->m_samples.size() > nmax)
-		{
-			wfm->m_samples.pop_front();
-			wfm->m_durations.pop_front();
-			wfm->m_offsets.pop_front();
-		}
-	}
-	else
+	if(!wfm)
 	{
 		wfm = new SparseAnalogWaveform;
 		SetData(wfm, 0);
@@ -133,18 +122,48 @@ void TrendFilter::Refresh(vk::raii::CommandBuffer& /*cmdBuf*/, std::shared_ptr<Q
 	if(len > 0)
 		wfm->m_durations[len-1] = dt;
 
-	//Add the new sample
-	wfm->m_samples.push_back(GetInput(0).GetScalarValue());
+	//Add the new sample.
+	//Offsets stay monotonic from the start of the buffer and the newest sample is pulled to x=0 via the trigger
+	//phase, so an append is O(1) rather than rebasing every old offset each update.
+	wfm->m_samples.push_back(din.GetScalarValue());
 	wfm->m_durations.push_back(dt);
 	if(wfm->m_offsets.empty())
 		wfm->m_offsets.push_back(0);
 	else
 		wfm->m_offsets.push_back(dt + wfm->m_offsets[len-1]);
+	wfm->m_dirtyStart = len;
+	len ++;
+
+	//Ring buffer trimming: let the buffer run a bit past the requested depth, then cut it back in one pass.
+	//This keeps the per-update cost amortized O(1) instead of shifting the whole buffer every sample.
+	size_t nmax = m_parameters[m_depthname].GetIntVal();
+	size_t slack = max(nmax / 4, (size_t)64);
+	bool rebase = (len > nmax + slack);
+
+	//Also rebase before the monotonic offsets can overflow int64 femtoseconds (a few hours of wall clock time)
+	if(!rebase && (wfm->m_offsets[len-1] > (INT64_MAX / 2)) )
+		rebase = true;
+
+	if(rebase)
+	{
+		size_t ntrim = (len > nmax) ? (len - nmax) : 0;
+		size_t nkeep = len - ntrim;
+		int64_t base = wfm->m_offsets[ntrim];
+		for(size_t i=0; i<nkeep; i++)
+		{
+			wfm->m_samples[i] = wfm->m_samples[i + ntrim];
+			wfm->m_durations[i] = wfm->m_durations[i + ntrim];
+			wfm->m_offsets[i] = wfm->m_offsets[i + ntrim] - base;
+		}
+		wfm->Resize(nkeep);
+		len = nkeep;
+
+		//Offsets moved, so any cached per-sample state downstream is no longer valid
+		wfm->m_dirtyStart = 0;
+	}
 
-	//Update offsets of old samples
-	len = wfm->m_samples.size();
-	for(size_t i=0; i<len; i++)
-		wfm->m_offsets[i] -= dt;
+	//Pull the newest sample to x=0
+	wfm->m_triggerPhase = -wfm->m_offsets[len-1];
 
 	wfm->MarkModifiedFromCpu();
 
@@ -105,238 +105,257 @@ void USB2PacketDecoder::Refresh()
 	cap->m_startFemtoseconds = din->m_startFemtoseconds;
 	cap->PrepareForCpuAccess();
 
-	enum
-	{
-		STATE_IDLE,
-		STATE_PID,
-		STATE_END,
-		STATE_TOKEN_0,
-		STATE_TOKEN_1,
-		STATE_SOF_0,
-		STATE_SOF_1,
-		STATE_DATA
-	} state = STATE_IDLE;
-
-	//Decode stuff
-	uint8_t last = 0;
-	uint64_t last_offset;
-	uint8_t crc5_in[2] = {0};
-	uint8_t packet_crc5;
-	vector<uint8_t> packet_data;
-	for(size_t i=0; i<len; i++)
-	{
-		auto& sin = din->m_samples[i];
-		int64_t halfdur = din->m_durations[i]/2;
-
-		switch(state)
+	//Decode one chunk of the PCS stream.
+	//All decoder state resets at an EOP, so restarting cold at any SYNC symbol is safe.
+	auto decodeChunk = [this, din](size_t start, size_t end, USB2PacketWaveform* cap, vector<Packet*>& /*packets*/)
+	{
+		enum
+		{
+			STATE_IDLE,
+			STATE_PID,
+			STATE_END,
+			STATE_TOKEN_0,
+			STATE_TOKEN_1,
+			STATE_SOF_0,
+			STATE_SOF_1,
+			STATE_DATA
+		} state = STATE_IDLE;
+
+		//Decode stuff
+		uint8_t last = 0;
+		uint64_t last_offset;
+		uint8_t crc5_in[2] = {0};
+		uint8_t packet_crc5;
+		vector<uint8_t> packet_data;
+		for(size_t i=start; i<end; i++)
 		{
-			case STATE_IDLE:
-
-				//Expect SYNC
-				switch(sin.m_type)
-				{
-					//Start a new packet if we see a SYNC
-					case USB2PCSSymbol::TYPE_SYNC:
-						state = STATE_PID;
-						break;
-
-					//Anything else is an error
-					default:
+			auto& sin = din->m_samples[i];
+			int64_t halfdur = din->m_durations[i]/2;
+
+			switch(state)
+			{
+				case STATE_IDLE:
+
+					//Expect SYNC
+					switch(sin.m_type)
+					{
+						//Start a new packet if we see a SYNC
+						case USB2PCSSymbol::TYPE_SYNC:
+							state = STATE_PID;
+							break;
+
+						//Anything else is an error
+						default:
+							cap->m_offsets.push_back(din->m_offsets[i]);
+							cap->m_durations.push_back(din->m_durations[i]);
+							cap->m_samples.push_back(USB2PacketSymbol(USB2PacketSymbol::TYPE_ERROR, 0));
+							break;
+					}
+
+					break;
+
+				//Started a new packet, expect PID
+				case STATE_PID:
+
+					//Should be data
+					if(sin.m_type != USB2PCSSymbol::TYPE_DATA)
+					{
 						cap->m_offsets.push_back(din->m_offsets[i]);
 						cap->m_durations.push_back(din->m_durations[i]);
 						cap->m_samples.push_back(USB2PacketSymbol(USB2PacketSymbol::TYPE_ERROR, 0));
-						break;
-				}
-
-				break;
 
-			//Started a new packet, expect PID
-			case STATE_PID:
+						state = STATE_IDLE;
+						continue;
+					}
 
-				//Should be data
-				if(sin.m_type != USB2PCSSymbol::TYPE_DATA)
-				{
-					cap->m_offsets.push_back(din->m_offsets[i]);
-					cap->m_durations.push_back(din->m_durations[i]);
-					cap->m_samples.push_back(USB2PacketSymbol(USB2PacketSymbol::TYPE_ERROR, 0));
+					//If the low bits don't match the complement of the high bits, we have a bad PID
+					if( (sin.m_data >> 4) != (0xf & ~sin.m_data) )
+					{
+						cap->m_offsets.push_back(din->m_offsets[i]);
+						cap->m_durations.push_back(din->m_durations[i]);
+						cap->m_samples.push_back(USB2PacketSymbol(USB2PacketSymbol::TYPE_ERROR, 0));
 
-					state = STATE_IDLE;
-					continue;
-				}
+						state = STATE_IDLE;
+						continue;
+					}
 
-				//If the low bits don't match the complement of the high bits, we have a bad PID
-				if( (sin.m_data >> 4) != (0xf & ~sin.m_data) )
-				{
+					//All good, add the PID
 					cap->m_offsets.push_back(din->m_offsets[i]);
 					cap->m_durations.push_back(din->m_durations[i]);
-					cap->m_samples.push_back(USB2PacketSymbol(USB2PacketSymbol::TYPE_ERROR, 0));
-
-					state = STATE_IDLE;
-					continue;
-				}
-
-				//All good, add the PID
-				cap->m_offsets.push_back(din->m_offsets[i]);
-				cap->m_durations.push_back(din->m_durations[i]);
-				cap->m_samples.push_back(USB2PacketSymbol(USB2PacketSymbol::TYPE_PID, sin.m_data));
-
-				//Look at the PID and decide what to expect next
-				switch(sin.m_data & 0xf)
-				{
-					case USB2PacketSymbol::PID_ACK:
-					case USB2PacketSymbol::PID_STALL:
-					case USB2PacketSymbol::PID_NAK:
-					case USB2PacketSymbol::PID_NYET:
-						state = STATE_END;
-						break;
-
-					//TODO: handle low bandwidth PRE stuff
-					//for now assume USB 2.0 ERR
-					case USB2PacketSymbol::PID_PRE_ERR:
-						state = STATE_END;
-						break;
-
-					case USB2PacketSymbol::PID_IN:
-					case USB2PacketSymbol::PID_OUT:
-					case USB2PacketSymbol::PID_SETUP:
-					case USB2PacketSymbol::PID_PING:
-					case USB2PacketSymbol::PID_SPLIT:
-						state = STATE_TOKEN_0;
-						break;
-
-					case USB2PacketSymbol::PID_SOF:
-						state = STATE_SOF_0;
-						break;
-
-					case USB2PacketSymbol::PID_DATA0:
-					case USB2PacketSymbol::PID_DATA1:
-					case USB2PacketSymbol::PID_DATA2:
-					case USB2PacketSymbol::PID_MDATA:
-						state = STATE_DATA;
-						packet_data.clear();
-						break;
-				}
+					cap->m_samples.push_back(USB2PacketSymbol(USB2PacketSymbol::TYPE_PID, sin.m_data));
+
+					//Look at the PID and decide what to expect next
+					switch(sin.m_data & 0xf)
+					{
+						case USB2PacketSymbol::PID_ACK:
+						case USB2PacketSymbol::PID_STALL:
+						case USB2PacketSymbol::PID_NAK:
+						case USB2PacketSymbol::PID_NYET:
+							state = STATE_END;
+							break;
+
+						//TODO: handle low bandwidth PRE stuff
+						//for now assume USB 2.0 ERR
+						case USB2PacketSymbol::PID_PRE_ERR:
+							state = STATE_END;
+							break;
+
+						case USB2PacketSymbol::PID_IN:
+						case USB2PacketSymbol::PID_OUT:
+						case USB2PacketSymbol::PID_SETUP:
+						case USB2PacketSymbol::PID_PING:
+						case USB2PacketSymbol::PID_SPLIT:
+							state = STATE_TOKEN_0;
+							break;
+
+						case USB2PacketSymbol::PID_SOF:
+							state = STATE_SOF_0;
+							break;
+
+						case USB2PacketSymbol::PID_DATA0:
+						case USB2PacketSymbol::PID_DATA1:
+						case USB2PacketSymbol::PID_DATA2:
+						case USB2PacketSymbol::PID_MDATA:
+							state = STATE_DATA;
+							packet_data.clear();
+							break;
+					}
+
+					break;
+
+				//Done, expect EOP
+				case STATE_END:
+					if(sin.m_type != USB2PCSSymbol::TYPE_EOP)
+					{
+						cap->m_offsets.push_back(din->m_offsets[i]);
+						cap->m_durations.push_back(din->m_durations[i]);
+						cap->m_samples.push_back(USB2PacketSymbol(USB2PacketSymbol::TYPE_ERROR, 0));
+					}
+					break;
 
-				break;
+				//Tokens cross byte boundaries YAY!
+				case STATE_TOKEN_0:
 
-			//Done, expect EOP
-			case STATE_END:
-				if(sin.m_type != USB2PCSSymbol::TYPE_EOP)
-				{
+					//Pull out the 7-bit address
 					cap->m_offsets.push_back(din->m_offsets[i]);
 					cap->m_durations.push_back(din->m_durations[i]);
-					cap->m_samples.push_back(USB2PacketSymbol(USB2PacketSymbol::TYPE_ERROR, 0));
-				}
-				break;
-
-			//Tokens cross byte boundaries YAY!
-			case STATE_TOKEN_0:
-
-				//Pull out the 7-bit address
-				cap->m_offsets.push_back(din->m_offsets[i]);
-				cap->m_durations.push_back(din->m_durations[i]);
-				cap->m_samples.push_back(USB2PacketSymbol(USB2PacketSymbol::TYPE_ADDR, sin.m_data & 0x7f));
+					cap->m_samples.push_back(USB2PacketSymbol(USB2PacketSymbol::TYPE_ADDR, sin.m_data & 0x7f));
 
-				crc5_in[0] = sin.m_data;
-				last = sin.m_data;
-
-				state = STATE_TOKEN_1;
-				break;
+					crc5_in[0] = sin.m_data;
+					last = sin.m_data;
 
-			case STATE_TOKEN_1:
+					state = STATE_TOKEN_1;
+					break;
 
-				cap->m_offsets.push_back(din->m_offsets[i]);
-				cap->m_durations.push_back(halfdur);
-				cap->m_samples.push_back(USB2PacketSymbol(USB2PacketSymbol::TYPE_ENDP,
-					( last >> 7) | ( (sin.m_data & 0x7) << 1 )));
+				case STATE_TOKEN_1:
 
-				//Verify the CRC
-				crc5_in[1] = sin.m_data;
-				packet_crc5 = (sin.m_data >> 3);
-				cap->m_offsets.push_back(din->m_offsets[i] + halfdur);
-				cap->m_durations.push_back(halfdur);
-				if(VerifyCRC5(crc5_in))
-					cap->m_samples.push_back(USB2PacketSymbol(USB2PacketSymbol::TYPE_CRC5_GOOD, packet_crc5));
-				else
-					cap->m_samples.push_back(USB2PacketSymbol(USB2PacketSymbol::TYPE_CRC5_BAD, packet_crc5));
+					cap->m_offsets.push_back(din->m_offsets[i]);
+					cap->m_durations.push_back(halfdur);
+					cap->m_samples.push_back(USB2PacketSymbol(USB2PacketSymbol::TYPE_ENDP,
+						( last >> 7) | ( (sin.m_data & 0x7) << 1 )));
 
-				state = STATE_END;
-				break;
+					//Verify the CRC
+					crc5_in[1] = sin.m_data;
+					packet_crc5 = (sin.m_data >> 3);
+					cap->m_offsets.push_back(din->m_offsets[i] + halfdur);
+					cap->m_durations.push_back(halfdur);
+					if(VerifyCRC5(crc5_in))
+						cap->m_samples.push_back(USB2PacketSymbol(USB2PacketSymbol::TYPE_CRC5_GOOD, packet_crc5));
+					else
+						cap->m_samples.push_back(USB2PacketSymbol(USB2PacketSymbol::TYPE_CRC5_BAD, packet_crc5));
 
-			case STATE_SOF_0:
+					state = STATE_END;
+					break;
 
-				last = sin.m_data;
-				last_offset = din->m_offsets[i];
-				crc5_in[0] = sin.m_data;
+				case STATE_SOF_0:
 
-				state = STATE_SOF_1;
-				break;
+					last = sin.m_data;
+					last_offset = din->m_offsets[i];
+					crc5_in[0] = sin.m_data;
 
-			case STATE_SOF_1:
-
-				//Frame number is the entire previous symbol, plus the low 3 bits of this one
-				cap->m_offsets.push_back(last_offset);
-				cap->m_durations.push_back(din->m_offsets[i] - last_offset + halfdur);
-				cap->m_samples.push_back(USB2PacketSymbol(USB2PacketSymbol::TYPE_NFRAME,
-						(sin.m_data & 0x7 ) << 8 | last));
-
-				//CRC
-				crc5_in[1] = sin.m_data;
-				packet_crc5 = (sin.m_data >> 3);
-				cap->m_offsets.push_back(din->m_offsets[i] + halfdur);
-				cap->m_durations.push_back(halfdur);
-				if(VerifyCRC5(crc5_in))
-					cap->m_samples.push_back(USB2PacketSymbol(USB2PacketSymbol::TYPE_CRC5_GOOD, packet_crc5));
-				else
-					cap->m_samples.push_back(USB2PacketSymbol(USB2PacketSymbol::TYPE_CRC5_BAD, packet_crc5));
-
-				state = STATE_END;
-				break;
+					state = STATE_SOF_1;
+					break;
 
-			case STATE_DATA:
+				case STATE_SOF_1:
 
-				//Assume data bytes are data (but they might be CRC, can't tell yet)
-				if(sin.m_type == USB2PCSSymbol::TYPE_DATA)
-				{
-					cap->m_offsets.push_back(din->m_offsets[i]);
-					cap->m_durations.push_back(din->m_durations[i]);
-					cap->m_samples.push_back(USB2PacketSymbol(USB2PacketSymbol::TYPE_DATA, sin.m_data));
+					//Frame number is the entire previous symbol, plus the low 3 bits of this one
+					cap->m_offsets.push_back(last_offset);
+					cap->m_durations.push_back(din->m_offsets[i] - last_offset + halfdur);
+					cap->m_samples.push_back(USB2PacketSymbol(USB2PacketSymbol::TYPE_NFRAME,
+							(sin.m_data & 0x7 ) << 8 | last));
 
-					packet_data.push_back(sin.m_data);
-				}
+					//CRC
+					crc5_in[1] = sin.m_data;
+					packet_crc5 = (sin.m_data >> 3);
+					cap->m_offsets.push_back(din->m_offsets[i] + halfdur);
+					cap->m_durations.push_back(halfdur);
+					if(VerifyCRC5(crc5_in))
+						cap->m_samples.push_back(USB2PacketSymbol(USB2PacketSymbol::TYPE_CRC5_GOOD, packet_crc5));
+					else
+						cap->m_samples.push_back(USB2PacketSymbol(USB2PacketSymbol::TYPE_CRC5_BAD, packet_crc5));
 
-				//Last two bytes were actually the CRC!
-				//Merge them into the first one and delete the second
-				else if(sin.m_type == USB2PCSSymbol::TYPE_EOP)
-				{
-					size_t firstoff = cap->m_samples.size() - 2;
-					size_t secondoff = cap->m_samples.size() - 1;
+					state = STATE_END;
+					break;
 
-					//Extract the CRC value and remove it from the packet body
-					uint16_t crc16 = (cap->m_samples[firstoff].m_data << 8) | cap->m_samples[secondoff].m_data;
-					packet_data.pop_back();
-					packet_data.pop_back();
+				case STATE_DATA:
 
-					//Verify the CRC
-					uint16_t crc16_calculated = CalculateCRC16(packet_data);
-					cap->m_durations[firstoff] += cap->m_durations[secondoff];
-					if(crc16 == crc16_calculated)
-						cap->m_samples[firstoff] = USB2PacketSymbol(USB2PacketSymbol::TYPE_CRC16_GOOD, crc16);
-					else
-						cap->m_samples[firstoff] = USB2PacketSymbol(USB2PacketSymbol::TYPE_CRC16_BAD, crc16);
+					//Assume data bytes are data (but they might be CRC, can't tell yet)
+					if(sin.m_type == USB2PCSSymbol::TYPE_DATA)
+					{
+						cap->m_offsets.push_back(din->m_offsets[i]);
+						cap->m_durations.push_back(din->m_durations[i]);
+						cap->m_samples.push_back(USB2PacketSymbol(USB2PacketSymbol::TYPE_DATA, sin.m_data));
+
+						packet_data.push_back(sin.m_data);
+					}
+
+					//Last two bytes were actually the CRC!
+					//Merge them into the first one and delete the second
+					else if(sin.m_type == USB2PCSSymbol::TYPE_EOP)
+					{
+						size_t firstoff = cap->m_samples.size() - 2;
+						size_t secondoff = cap->m_samples.size() - 1;
+
+						//Extract the CRC value and remove it from the packet body
+						uint16_t crc16 = (cap->m_samples[firstoff].m_data << 8) | cap->m_samples[secondoff].m_data;
+						packet_data.pop_back();
+						packet_data.pop_back();
+
+						//Verify the CRC
+						uint16_t crc16_calculated = CalculateCRC16(packet_data);
+						cap->m_durations[firstoff] += cap->m_durations[secondoff];
+						if(crc16 == crc16_calculated)
+							cap->m_samples[firstoff] = USB2PacketSymbol(USB2PacketSymbol::TYPE_CRC16_GOOD, crc16);
+						else
+							cap->m_samples[firstoff] = USB2PacketSymbol(USB2PacketSymbol::TYPE_CRC16_BAD, crc16);
+
+						cap->m_offsets.resize(secondoff);
+						cap->m_durations.resize(secondoff);
+						cap->m_samples.resize(secondoff);
+					}
+
+					break;
+			}
 
-					cap->m_offsets.resize(secondoff);
-					cap->m_durations.resize(secondoff);
-					cap->m_samples.resize(secondoff);
-				}
+			//EOP always returns us to idle state
+			if(sin.m_type == USB2PCSSymbol::TYPE_EOP)
+				state = STATE_IDLE;
+		}
+	};
 
+	//Safe restart points are the SYNC at the start of each packet
+	auto findBoundary = [din, len](size_t i)
+	{
+		for(; i<len; i++)
+		{
+			if(din->m_samples[i].m_type == USB2PCSSymbol::TYPE_SYNC)
 				break;
 		}
+		return i;
+	};
 
-		//EOP always returns us to idle state
-		if(sin.m_type == USB2PCSSymbol::TYPE_EOP)
-			state = STATE_IDLE;
-	}
+	//Split the capture at packet boundaries and decode the chunks in parallel
+	DecodeChunked<USB2PacketWaveform>(len, findBoundary, decodeChunk, cap);
 
 	//Done
 	SetData(cap, 0);
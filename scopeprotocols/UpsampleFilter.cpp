@@ -36,35 +36,11 @@
 
 using namespace std;
 
-float sinc(float x, float width);
-float blackman(float x, float width);
-
-float sinc(float x, float width)
-{
-	float xi = x - width/2;
-
-	if(fabs(xi) < 1e-7)
-		return 1.0f;
-	else
-	{
-		float px = M_PI*xi;
-		return sin(px) / px;
-	}
-}
-
-float blackman(float x, float width)
-{
-	if(x > width)
-		return 0;
-	return 0.42 - 0.5*cos(2*M_PI * x / width) + 0.08 * cos(4*M_PI*x/width);
-}
-
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Construction / destruction
 
 UpsampleFilter::UpsampleFilter(const string& color)
 	: Filter(color, CAT_MATH)
-	, m_computePipeline("shaders/UpsampleFilter.spv", 3, sizeof(UpsampleFilterArgs))
 {
 	AddStream(Unit(Unit::UNIT_VOLTS), "data", Stream::STREAM_TYPE_ANALOG);
 	CreateInput("din");
@@ -72,10 +48,6 @@ UpsampleFilter::UpsampleFilter(const string& color)
 	m_factorname = "Upsample factor";
 	m_parameters[m_factorname] = FilterParameter(FilterParameter::TYPE_INT, Unit(Unit::UNIT_SAMPLEDEPTH));
 	m_parameters[m_factorname].SetIntVal(10);
-
-	//Use pinned memory for filter kernel
-	m_filter.SetCpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
-	m_filter.SetGpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -117,51 +89,30 @@ void UpsampleFilter::Refresh(vk::raii::CommandBuffer& cmdBuf, shared_ptr<QueueHa
 	//Configuration parameters (TODO: allow window to be user specified)
 	size_t upsample_factor = m_parameters[m_factorname].GetIntVal();
 	size_t window = 5;
-	size_t kernel = window*upsample_factor;
 	if(upsample_factor <= 0)
 	{
 		SetData(NULL, 0);
 		return;
 	}
 
-	//Create the interpolation filter
-	//TODO: if upsampling factor and window size have not changed, keep the same filter coefficients
-	//(no need to push every time)
-	float frac_kernel = kernel * 1.0f / upsample_factor;
-	m_filter.resize(kernel);
-	m_filter.PrepareForCpuAccess();
-	for(size_t i=0; i<kernel; i++)
-	{
-		float frac = i*1.0f / upsample_factor;
-		m_filter[i] = sinc(frac, frac_kernel) * blackman(frac, frac_kernel);
-	}
-	m_filter.MarkModifiedFromCpu();
+	//Create the interpolation filter (no-op if factor and window are unchanged)
+	m_resampler.ConfigureUpsample(upsample_factor, window);
 
 	//Create the output and configure it
 	auto cap = SetupEmptyUniformAnalogOutputWaveform(din, 0);
 	cap->m_timescale = din->m_timescale / upsample_factor;
 	size_t len = din->size();
-	size_t imax = len - window;
-	size_t outlen = imax*upsample_factor;
+	size_t outlen = m_resampler.GetOutputLength(len);
 	cap->Resize(outlen);
 
-	if(g_gpuFilterEnabled)
+	//Let the measured cost model pick between GPU dispatch and the parallel CPU path
+	bool gpu = g_gpuFilterEnabled && g_filterCostModel.PreferGpu(GetProtocolName(), outlen);
+	double tstart = GetTime();
+
+	if(gpu)
 	{
 		cmdBuf.begin({});
-
-		//Update our descriptor sets with current buffers
-		m_computePipeline.BindBufferNonblocking(0, din->m_samples, cmdBuf);
-		m_computePipeline.BindBufferNonblocking(1, m_filter, cmdBuf);
-		m_computePipeline.BindBufferNonblocking(2, cap->m_samples, cmdBuf, true);
-
-		UpsampleFilterArgs args;
-		args.imax = imax;
-		args.upsample_factor = upsample_factor;
-		args.kernel = kernel;
-
-		m_computePipeline.Dispatch(cmdBuf, args, GetComputeBlockCount(imax, 64), GetComputeBlockCount(upsample_factor, 1));
-
-		//Done, submit to the queue and wait
+		m_resampler.Resample(cmdBuf, din->m_samples, cap->m_samples, len, outlen);
 		cmdBuf.end();
 		queue->SubmitAndBlock(cmdBuf);
 		cap->MarkModifiedFromGpu();
@@ -169,35 +120,11 @@ void UpsampleFilter::Refresh(vk::raii::CommandBuffer& cmdBuf, shared_ptr<QueueHa
 
 	else
 	{
-		din->PrepareForCpuAccess();
-		cap->PrepareForCpuAccess();
-
-		//Logically, we upsample by inserting zeroes, then convolve with the sinc filter.
-		//Optimization: don't actually waste time multiplying by zero
-		#pragma omp parallel for
-		for(size_t i=0; i < imax; i++)
-		{
-			size_t offset = i * upsample_factor;
-			for(size_t j=0; j<upsample_factor; j++)
-			{
-				size_t start = 0;
-				size_t sstart = 0;
-				if(j > 0)
-				{
-					sstart = 1;
-					start = upsample_factor - j;
-				}
-
-				float f = 0;
-				for(size_t k = start; k<kernel; k += upsample_factor, sstart ++)
-					f += m_filter[k] * din->m_samples[i + sstart];
-
-				cap->m_samples[offset + j] = f;
-			}
-		}
-
+		m_resampler.ResampleCpu(din->m_samples, cap->m_samples, len, outlen);
 		cap->MarkModifiedFromCpu();
 	}
+
+	g_filterCostModel.Record(GetProtocolName(), gpu, outlen, (GetTime() - tstart) * 1e9);
 }
 
 Filter::DataLocation UpsampleFilter::GetInputLocation()
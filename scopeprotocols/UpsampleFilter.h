@@ -37,13 +37,6 @@
 
 class QueueHandle;
 
-struct UpsampleFilterArgs
-{
-	uint32_t imax;
-	uint32_t upsample_factor;
-	uint32_t kernel;
-};
-
 class UpsampleFilter : public Filter
 {
 public:
@@ -61,9 +54,7 @@ public:
 protected:
 	std::string m_factorname;
 
-	AcceleratorBuffer<float> m_filter;
-
-	ComputePipeline m_computePipeline;
+	PolyphaseResampler m_resampler;
 };
 
 #endif
@@ -90,12 +90,14 @@ void VectorFrequencyFilter::Refresh()
 	//Calculate scaling factor from rad/sample to Hz
 	float sample_hz = FS_PER_SECOND / din_i->m_timescale;
 	float scale = sample_hz / (2 * M_PI);
+
+	//Compute all of the phase angles up front (vectorized), then differentiate
+	vector<float> theta;
+	theta.resize(len);
+	VectorAtan2(&theta[0], (float*)&din_q->m_samples[0], (float*)&din_i->m_samples[0], len);
 	for(size_t i=0; i<len-1; i++)
 	{
-		//TODO: this can probably be made more efficient...
-		float theta1 = atan2(din_q->m_samples[i], din_i->m_samples[i]);
-		float theta2 = atan2(din_q->m_samples[i+1], din_i->m_samples[i+1]);
-		float dphase = theta2 - theta1;
+		float dphase = theta[i+1] - theta[i];
 		if(dphase < -M_PI)
 			dphase += 2*M_PI;
 		if(dphase > M_PI)
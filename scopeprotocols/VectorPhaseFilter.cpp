@@ -94,9 +94,11 @@ void VectorPhaseFilter::Refresh()
 
 	float* fa = (float*)&a->m_samples[0];
 	float* fb = (float*)&b->m_samples[0];
+	float* fdst = (float*)&cap->m_samples[0];
 	float scale = 180 / M_PI;
+	VectorAtan2(fdst, fa, fb, len);
 	for(size_t i=0; i<len; i++)
-		cap->m_samples[i] = atan2(fa[i], fb[i]) * scale;
+		fdst[i] *= scale;
 
 	cap->MarkModifiedFromCpu();
 }
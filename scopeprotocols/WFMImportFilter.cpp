@@ -43,6 +43,11 @@ WFMImportFilter::WFMImportFilter(const string& color)
 	m_parameters[m_fpname].m_fileFilterMask = "*.wfm";
 	m_parameters[m_fpname].m_fileFilterName = "Tektronix WFM files (*.wfm)";
 	m_parameters[m_fpname].signal_changed().connect(sigc::mem_fun(*this, &WFMImportFilter::OnFileNameChanged));
+
+	m_lazyname = "Lazy Loading";
+	m_parameters[m_lazyname] = FilterParameter(FilterParameter::TYPE_BOOL, Unit(Unit::UNIT_COUNTS));
+	m_parameters[m_lazyname].SetBoolVal(true);
+	m_parameters[m_lazyname].signal_changed().connect(sigc::mem_fun(*this, &WFMImportFilter::OnFileNameChanged));
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -634,6 +639,56 @@ void WFMImportFilter::OnFileNameChanged()
 	//TODO: handle multi channel etc
 	ClearStreams();
 	AddStream(yunit, "data", Stream::STREAM_TYPE_ANALOG);
+
+	//Lazy loading: stop after header parsing and keep the native ADC codes, mapping them straight out of the
+	//page cache where possible. Float conversion happens on first access to the waveform, so opening a large
+	//directory of files for batch comparison only pays for the headers up front.
+	if(m_parameters[m_lazyname].GetBoolVal())
+	{
+		auto qwfm = new QuantizedUniformAnalogWaveform;
+		qwfm->m_timescale = FS_PER_SECOND * (spacing+1) * xscale;
+		qwfm->m_startTimestamp = gmtSec;
+		qwfm->m_startFemtoseconds = fracSec * FS_PER_SECOND;
+		qwfm->m_triggerPhase = triggerPhase * qwfm->m_timescale;
+		qwfm->Configure(
+			(bytesperpoint == 2)
+				? QuantizedUniformAnalogWaveform::FORMAT_INT16
+				: QuantizedUniformAnalogWaveform::FORMAT_INT8,
+			yscale,
+			-yoff);
+
+		//Map the curve buffer out of the file if we can (page aligned offset, platform with mmap),
+		//otherwise bulk-read the raw codes. Either way no sample conversion happens at import time.
+		if(qwfm->m_codes.AdoptFileMapping(fileno(fp), curveoffset, numBytes))
+			qwfm->Resize(numRealSamples);
+		else
+		{
+			qwfm->Resize(numRealSamples);
+			fseek(fp, curveoffset, SEEK_SET);
+			if(numBytes != fread(qwfm->m_codes.GetCpuPointer(), 1, numBytes, fp))
+			{
+				LogError("Fail to read waveform data\n");
+				delete qwfm;
+				fclose(fp);
+				return;
+			}
+			qwfm->MarkCodesModifiedFromCpu();
+		}
+		SetData(qwfm, 0);
+
+		//Set the scale analytically from the code format's full scale range
+		//so we don't have to materialize the float view just to autoscale
+		float fsmin = (bytesperpoint == 2) ? -32768 : -128;
+		float fsmax = (bytesperpoint == 2) ? 32767 : 127;
+		float vmin = fsmin*yscale + yoff;
+		float vmax = fsmax*yscale + yoff;
+		SetVoltageRange((vmax - vmin) * 1.05, 0);
+		SetOffset(-(vmin + vmax) / 2, 0);
+
+		fclose(fp);
+		return;
+	}
+
 	auto wfm = new UniformAnalogWaveform;
 	wfm->m_timescale = FS_PER_SECOND * (spacing+1) * xscale;
 	wfm->Resize(numRealSamples);
@@ -46,6 +46,8 @@ public:
 
 protected:
 	void OnFileNameChanged();
+
+	std::string m_lazyname;
 };
 
 #endif
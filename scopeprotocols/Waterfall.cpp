@@ -36,15 +36,19 @@ using namespace std;
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Construction / destruction
 
-WaterfallWaveform::WaterfallWaveform(size_t width, size_t height)
+WaterfallWaveform::WaterfallWaveform(size_t width, size_t height, bool halfPrecision)
 	: DensityFunctionWaveform(width, height)
-	, m_tempBuf("WaterfallWaveform.m_tempBuf")
+	, m_ringBuf("WaterfallWaveform.m_ringBuf")
+	, m_firstRow(0)
+	, m_halfPrecision(halfPrecision)
 {
-	//Temporary buffer is GPU-only
-	m_tempBuf.SetCpuAccessHint(AcceleratorBuffer<float>::HINT_NEVER);
-	m_tempBuf.SetGpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
+	//Ring buffer is GPU-only
+	m_ringBuf.SetCpuAccessHint(AcceleratorBuffer<uint8_t>::HINT_NEVER);
+	m_ringBuf.SetGpuAccessHint(AcceleratorBuffer<uint8_t>::HINT_LIKELY);
 
-	m_tempBuf.resize(width*height);
+	//Round the byte size up to a multiple of 4 so vkCmdFillBuffer can clear the whole thing
+	size_t nbytes = width * height * (halfPrecision ? sizeof(uint16_t) : sizeof(float));
+	m_ringBuf.resize( (nbytes + 3) & ~3UL );
 }
 
 WaterfallWaveform::~WaterfallWaveform()
@@ -61,6 +65,16 @@ Waterfall::Waterfall(const string& color)
 	, m_maxwidth("Max width")
 	, m_computePipeline("shaders/WaterfallFilter.spv", 3, sizeof(WaterfallFilterArgs))
 {
+	//The waterfall is display-only (nothing downstream measures it), so store the ring buffer at fp16
+	//if the GPU supports it: half the memory and bandwidth for a precision loss below display quantization
+	if(g_hasShaderFloat16)
+	{
+		m_computePipelineFP16 = std::make_unique<ComputePipeline>(
+			"shaders/WaterfallFilterFP16.spv", 3, sizeof(WaterfallFilterArgs));
+		m_unrollPipelineFP16 = std::make_unique<ComputePipeline>(
+			"shaders/WaterfallUnrollFP16.spv", 2, sizeof(WaterfallUnrollArgs));
+	}
+
 	AddStream(Unit(Unit::UNIT_DBM), "data", Stream::STREAM_TYPE_WATERFALL);
 	m_xAxisUnit = Unit(Unit::UNIT_HZ);
 
@@ -135,11 +149,13 @@ void Waterfall::Refresh(vk::raii::CommandBuffer& cmdBuf, shared_ptr<QueueHandle>
 
 	//Reallocate if input size changed, or we don't have an input capture at all
 	auto cap = dynamic_cast<WaterfallWaveform*>(GetData(0));
+	bool firstPass = false;
 	if( (cap == nullptr) || (m_width != capwidth) || (m_width != cap->GetWidth()) || (m_height != cap->GetHeight()) )
 	{
-		cap = new WaterfallWaveform(capwidth, m_height);
+		cap = new WaterfallWaveform(capwidth, m_height, g_hasShaderFloat16);
 		m_width = capwidth;
 		SetData(cap, 0);
+		firstPass = true;
 	}
 
 	//Figure out the frequency span of the input
@@ -153,7 +169,6 @@ void Waterfall::Refresh(vk::raii::CommandBuffer& cmdBuf, shared_ptr<QueueHandle>
 	//Calculate some coefficients
 	WaterfallFilterArgs args;
 	args.width = m_width;
-	args.height = m_height;
 	args.inlen = inlen;
 	args.vrange = m_inputs[0].GetVoltageRange(); //db from min to max scale
 	args.vfs = args.vrange/2 - m_inputs[0].GetOffset();
@@ -161,33 +176,84 @@ void Waterfall::Refresh(vk::raii::CommandBuffer& cmdBuf, shared_ptr<QueueHandle>
 	//TODO: is this OK or are we going to lose too much precision doing this?
 	args.timescaleRatio = cap->m_timescale * 1.0 / din->m_timescale;
 
+	//Advance the ring buffer: the oldest row is overwritten by the new line, so scrolling is
+	//a changing read offset rather than a full-texture rewrite
+	size_t newRow = cap->m_firstRow;
+	cap->m_firstRow = (cap->m_firstRow + 1) % m_height;
+	args.rowOffset = newRow * m_width;
+
 	//Make sure input is ready
 	din->PrepareForGpuAccess();
 	cap->PrepareForGpuAccess();
-	cap->m_tempBuf.PrepareForGpuAccess();
+	cap->m_ringBuf.PrepareForGpuAccess();
 
 	cmdBuf.begin({});
 
-	//Run the actual compute on the GPU
-	m_computePipeline.BindBufferNonblocking(0, din->m_samples, cmdBuf);
-	m_computePipeline.BindBufferNonblocking(1, cap->GetOutData(), cmdBuf);
-	m_computePipeline.BindBufferNonblocking(2, cap->m_tempBuf, cmdBuf, true);
-	m_computePipeline.Dispatch(cmdBuf, args, GetComputeBlockCount(args.width, 64), m_height);
-
-	//Wait for the shader to finish
-	cmdBuf.pipelineBarrier(
-		vk::PipelineStageFlagBits::eComputeShader | vk::PipelineStageFlagBits::eTransfer,
-		vk::PipelineStageFlagBits::eTransfer,
-		{},
-		vk::MemoryBarrier(
-			vk::AccessFlagBits::eShaderWrite | vk::AccessFlagBits::eTransferWrite,
-			vk::AccessFlagBits::eTransferRead),
-		{},
-		{});
-
-	//Copy the output buffer over the input
-	vk::BufferCopy region(0, 0, cap->GetOutData().size() * sizeof(float));
-	cmdBuf.copyBuffer(cap->m_tempBuf.GetBuffer(), cap->GetOutData().GetBuffer(), {region});
+	//A freshly allocated ring buffer contains garbage, clear it before first use
+	if(firstPass)
+	{
+		//Buffer size is in bytes (fp16 or fp32 elements depending on GPU support)
+		cmdBuf.fillBuffer(cap->m_ringBuf.GetBuffer(), 0, cap->m_ringBuf.size(), 0);
+		cmdBuf.pipelineBarrier(
+			vk::PipelineStageFlagBits::eTransfer,
+			vk::PipelineStageFlagBits::eComputeShader,
+			{},
+			vk::MemoryBarrier(vk::AccessFlagBits::eTransferWrite, vk::AccessFlagBits::eShaderWrite),
+			{},
+			{});
+	}
+
+	//Compute just the new line of the waterfall, then unroll the ring into the row-major output bitmap
+	//(renderers consume the output as a linear fp32 texture, so the scroll offset gets applied here)
+	if(cap->m_halfPrecision)
+	{
+		m_computePipelineFP16->BindBufferNonblocking(0, din->m_samples, cmdBuf);
+		m_computePipelineFP16->BindBufferNonblocking(1, cap->m_ringBuf, cmdBuf, true);
+		m_computePipelineFP16->Dispatch(cmdBuf, args, GetComputeBlockCount(args.width, 64));
+		m_computePipelineFP16->AddComputeMemoryBarrier(cmdBuf);
+
+		//The fp16 ring can't be DMA'd straight to the fp32 output, so expand it in a second shader pass
+		WaterfallUnrollArgs uargs;
+		uargs.width = m_width;
+		uargs.height = m_height;
+		uargs.firstRow = cap->m_firstRow;
+		m_unrollPipelineFP16->BindBufferNonblocking(0, cap->m_ringBuf, cmdBuf);
+		m_unrollPipelineFP16->BindBufferNonblocking(1, cap->GetOutData(), cmdBuf, true);
+		m_unrollPipelineFP16->Dispatch(cmdBuf, uargs, GetComputeBlockCount(m_width * m_height, 64));
+	}
+	else
+	{
+		m_computePipeline.BindBufferNonblocking(0, din->m_samples, cmdBuf);
+		m_computePipeline.BindBufferNonblocking(1, cap->m_ringBuf, cmdBuf, true);
+		m_computePipeline.Dispatch(cmdBuf, args, GetComputeBlockCount(args.width, 64));
+
+		//Wait for the shader to finish
+		cmdBuf.pipelineBarrier(
+			vk::PipelineStageFlagBits::eComputeShader | vk::PipelineStageFlagBits::eTransfer,
+			vk::PipelineStageFlagBits::eTransfer,
+			{},
+			vk::MemoryBarrier(
+				vk::AccessFlagBits::eShaderWrite | vk::AccessFlagBits::eTransferWrite,
+				vk::AccessFlagBits::eTransferRead),
+			{},
+			{});
+
+		//Same element size on both sides here, so the unroll is pure DMA copies
+		size_t rowsToEnd = m_height - cap->m_firstRow;
+		vector<vk::BufferCopy> regions;
+		regions.push_back(vk::BufferCopy(
+			cap->m_firstRow * m_width * sizeof(float),
+			0,
+			rowsToEnd * m_width * sizeof(float)));
+		if(cap->m_firstRow != 0)
+		{
+			regions.push_back(vk::BufferCopy(
+				0,
+				rowsToEnd * m_width * sizeof(float),
+				cap->m_firstRow * m_width * sizeof(float)));
+		}
+		cmdBuf.copyBuffer(cap->m_ringBuf.GetBuffer(), cap->GetOutData().GetBuffer(), regions);
+	}
 
 	cmdBuf.end();
 	queue->SubmitAndBlock(cmdBuf);
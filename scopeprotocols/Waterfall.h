@@ -40,24 +40,43 @@
 struct WaterfallFilterArgs
 {
 	uint32_t width;
-	uint32_t height;
 	uint32_t inlen;
+	uint32_t rowOffset;
 	float vrange;
 	float vfs;
 	float timescaleRatio;
 };
 
+struct WaterfallUnrollArgs
+{
+	uint32_t width;
+	uint32_t height;
+	uint32_t firstRow;
+};
+
 class WaterfallWaveform : public DensityFunctionWaveform
 {
 public:
-	WaterfallWaveform(size_t width, size_t height);
+	WaterfallWaveform(size_t width, size_t height, bool halfPrecision);
 	virtual ~WaterfallWaveform();
 
 	//not copyable or assignable
 	WaterfallWaveform(const WaterfallWaveform&) =delete;
 	WaterfallWaveform& operator=(const WaterfallWaveform&) =delete;
 
-	AcceleratorBuffer<float> m_tempBuf;
+	/**
+		@brief Ring buffer backing store: physical row (m_firstRow + y) % height holds logical row y
+
+		Raw byte storage; elements are fp16 if m_halfPrecision is set, fp32 otherwise. The buffer is GPU-only
+		so the CPU-side element type never matters, and shaders bind it with whichever view matches.
+	 */
+	AcceleratorBuffer<uint8_t> m_ringBuf;
+
+	///@brief Physical row index of the oldest (bottom) row in the ring buffer
+	size_t m_firstRow;
+
+	///@brief True if the ring buffer stores fp16 values (display precision) rather than fp32
+	bool m_halfPrecision;
 };
 
 class Waterfall : public Filter
@@ -100,7 +119,14 @@ protected:
 
 	std::string m_maxwidth;
 
+	///@brief fp32 path: computes the new line directly into the fp32 ring buffer
 	ComputePipeline m_computePipeline;
+
+	///@brief fp16 path: computes the new line into the fp16 ring buffer (only created if g_hasShaderFloat16)
+	std::unique_ptr<ComputePipeline> m_computePipelineFP16;
+
+	///@brief fp16 path: unrolls the fp16 ring into the fp32 output bitmap (only created if g_hasShaderFloat16)
+	std::unique_ptr<ComputePipeline> m_unrollPipelineFP16;
 };
 
 #endif
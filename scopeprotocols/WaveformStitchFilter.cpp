@@ -0,0 +1,145 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopeprotocols                                                                                                    *
+*                                                                                                                      *
+* Copyright (c) 2012-2022 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+#include "../scopehal/scopehal.h"
+#include "WaveformStitchFilter.h"
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Construction / destruction
+
+WaveformStitchFilter::WaveformStitchFilter(const string& color)
+	: Filter(color, CAT_MATH)
+{
+	AddStream(Unit(Unit::UNIT_VOLTS), "data", Stream::STREAM_TYPE_ANALOG);
+	CreateInput("coarse");
+	CreateInput("fine");
+
+	m_offsetname = "Fine Offset";
+	m_parameters[m_offsetname] = FilterParameter(FilterParameter::TYPE_INT, Unit(Unit::UNIT_FS));
+	m_parameters[m_offsetname].SetIntVal(0);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Factory methods
+
+bool WaveformStitchFilter::ValidateChannel(size_t i, StreamDescriptor stream)
+{
+	if(stream.m_channel == NULL)
+		return false;
+
+	if( (i < 2) && (stream.GetType() == Stream::STREAM_TYPE_ANALOG) )
+		return true;
+
+	return false;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Accessors
+
+string WaveformStitchFilter::GetProtocolName()
+{
+	return "Waveform Stitch";
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Actual decoder logic
+
+void WaveformStitchFilter::Refresh()
+{
+	if(!VerifyAllInputsOKAndUniformAnalog())
+	{
+		SetData(NULL, 0);
+		return;
+	}
+
+	auto coarse = dynamic_cast<UniformAnalogWaveform*>(GetInputWaveform(0));
+	auto fine = dynamic_cast<UniformAnalogWaveform*>(GetInputWaveform(1));
+	coarse->PrepareForCpuAccess();
+	fine->PrepareForCpuAccess();
+
+	size_t clen = coarse->size();
+	size_t flen = fine->size();
+	int64_t cperiod = coarse->m_timescale;
+	int64_t fperiod = fine->m_timescale;
+
+	//Figure out where the fine capture sits relative to the coarse one
+	int64_t wstart = m_parameters[m_offsetname].GetIntVal() + fine->m_triggerPhase;
+	int64_t wend = wstart + flen*fperiod;
+
+	//Output is sparse with femtosecond resolution, since the two inputs generally have different sample rates
+	auto cap = new SparseAnalogWaveform;
+	cap->m_timescale = 1;
+	cap->m_startTimestamp = coarse->m_startTimestamp;
+	cap->m_startFemtoseconds = coarse->m_startFemtoseconds;
+	cap->m_triggerPhase = 0;
+	cap->PrepareForCpuAccess();
+	cap->m_offsets.reserve(clen + flen);
+	cap->m_durations.reserve(clen + flen);
+	cap->m_samples.reserve(clen + flen);
+
+	//Coarse samples before the window
+	size_t i = 0;
+	for(; i<clen; i++)
+	{
+		int64_t pos = i*cperiod + coarse->m_triggerPhase;
+		if(pos >= wstart)
+			break;
+
+		cap->m_offsets.push_back(pos);
+		cap->m_durations.push_back(cperiod);
+		cap->m_samples.push_back(coarse->m_samples[i]);
+	}
+
+	//The window itself, at full detail
+	for(size_t j=0; j<flen; j++)
+	{
+		cap->m_offsets.push_back(wstart + j*fperiod);
+		cap->m_durations.push_back(fperiod);
+		cap->m_samples.push_back(fine->m_samples[j]);
+	}
+
+	//Coarse samples after the window
+	for(; i<clen; i++)
+	{
+		int64_t pos = i*cperiod + coarse->m_triggerPhase;
+		if(pos < wend)
+			continue;
+
+		cap->m_offsets.push_back(pos);
+		cap->m_durations.push_back(cperiod);
+		cap->m_samples.push_back(coarse->m_samples[i]);
+	}
+
+	SetYAxisUnits(GetInput(0).GetYAxisUnits(), 0);
+
+	SetData(cap, 0);
+	cap->MarkModifiedFromCpu();
+}
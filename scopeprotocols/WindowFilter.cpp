@@ -105,9 +105,24 @@ void WindowFilter::Refresh()
 	int64_t start_time = m_parameters[m_startTimeName].GetIntVal();
 	int64_t end_time = start_time + m_parameters[m_durationName].GetIntVal();
 
-	bool dontcare;
-	size_t start_sample = GetIndexNearestAtOrBeforeTimestamp(in, start_time, dontcare);
-	size_t end_sample = GetIndexNearestAtOrBeforeTimestamp(in, end_time, dontcare);
+	size_t start_sample;
+	size_t end_sample;
+	if(auto sparse = dynamic_cast<SparseWaveformBase*>(in))
+	{
+		//Sparse path: persistent cursors, so a window sliding forward over a streaming capture re-seeks
+		//in amortized constant time across passes rather than redoing a binary search each time
+		in->PrepareForCpuAccess();
+		start_sample = m_startCursor.SeekGequal(sparse,
+			static_cast<int64_t>(floor(1.0 * (start_time - in->m_triggerPhase) / in->m_timescale)));
+		end_sample = m_endCursor.SeekGequal(sparse,
+			static_cast<int64_t>(floor(1.0 * (end_time - in->m_triggerPhase) / in->m_timescale)));
+	}
+	else
+	{
+		bool dontcare;
+		start_sample = GetIndexNearestAtOrBeforeTimestamp(in, start_time, dontcare);
+		end_sample = GetIndexNearestAtOrBeforeTimestamp(in, end_time, dontcare);
+	}
 
 	if (start_sample >= in->size())
 		start_sample = in->size() - 1;
@@ -51,6 +51,10 @@ public:
 protected:
 	std::string m_startTimeName;
 	std::string m_durationName;
+
+	///@brief Cursors tracking the window endpoints in sparse inputs across passes
+	SparseTimeCursor m_startCursor;
+	SparseTimeCursor m_endCursor;
 };
 
 #endif
@@ -0,0 +1,120 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopeprotocols                                                                                                    *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Implementation of WindowFunctionCache
+ */
+#include "scopeprotocols.h"
+#include "WindowFunctionCache.h"
+
+using namespace std;
+
+WindowFunctionCache g_windowFunctionCache;
+
+/**
+	@brief Returns the coefficient buffer for a given window shape, computing it if this is the first request
+
+	The returned buffer is shared: consumers must only ever bind it read-only.
+ */
+shared_ptr<AcceleratorBuffer<float>> WindowFunctionCache::Acquire(FFTFilter::WindowFunction window, size_t length)
+{
+	lock_guard<mutex> lock(m_mutex);
+
+	auto key = make_pair(window, length);
+	auto it = m_windows.find(key);
+	if(it != m_windows.end())
+		return it->second;
+
+	//First use: arrange to drop our GPU buffers before the device is torn down
+	if(m_windows.empty())
+		AddVulkanCleanupCallback([this]{ Clear(); });
+
+	//Not cached yet, compute the coefficients (formulas match the window shaders)
+	auto buf = make_shared<AcceleratorBuffer<float>>("WindowFunctionCache");
+	buf->SetCpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
+	buf->SetGpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
+	buf->resize(length);
+	buf->PrepareForCpuAccess();
+
+	float scale = 2 * M_PI / length;
+	switch(window)
+	{
+		case FFTFilter::WINDOW_BLACKMAN_HARRIS:
+			{
+				const float alpha0 = 0.35875;
+				const float alpha1 = 0.48829;
+				const float alpha2 = 0.14128;
+				const float alpha3 = 0.01168;
+
+				for(size_t i=0; i<length; i++)
+				{
+					float num = i * scale;
+					buf->GetCpuPointer()[i] =
+						alpha0 -
+						alpha1 * cosf(num) +
+						alpha2 * cosf(2*num) -
+						alpha3 * cosf(6*num);
+				}
+			}
+			break;
+
+		case FFTFilter::WINDOW_HANN:
+		case FFTFilter::WINDOW_HAMMING:
+			{
+				float alpha0 = (window == FFTFilter::WINDOW_HANN) ? 0.5 : (25.0f / 46);
+				float alpha1 = 1 - alpha0;
+
+				for(size_t i=0; i<length; i++)
+					buf->GetCpuPointer()[i] = alpha0 - alpha1*cosf(i * scale);
+			}
+			break;
+
+		case FFTFilter::WINDOW_RECTANGULAR:
+		default:
+			for(size_t i=0; i<length; i++)
+				buf->GetCpuPointer()[i] = 1;
+			break;
+	}
+	buf->MarkModifiedFromCpu();
+
+	//Push to the GPU now, while we still have exclusive access to the buffer
+	buf->PrepareForGpuAccess();
+
+	m_windows[key] = buf;
+	return buf;
+}
+
+///@brief Drops all cached windows (on shutdown, before the Vulkan context goes away)
+void WindowFunctionCache::Clear()
+{
+	lock_guard<mutex> lock(m_mutex);
+	m_windows.clear();
+}
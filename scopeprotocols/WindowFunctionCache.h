@@ -0,0 +1,83 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopeprotocols                                                                                                    *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Declaration of WindowFunctionCache
+ */
+#ifndef WindowFunctionCache_h
+#define WindowFunctionCache_h
+
+#include "FFTFilter.h"
+
+/**
+	@brief Push constants for the ApplyWindow / ApplyComplexWindow shaders
+
+	offsetIn shifts the input read position (in samples) so that a dispatch can window only the tail of a
+	streaming waveform; it must be a multiple of fftlen so the window phase is unchanged.
+ */
+struct ApplyWindowArgs
+{
+	uint32_t npoints;
+	uint32_t fftlen;
+	uint32_t offsetIn;
+};
+
+/**
+	@brief Process-wide cache of GPU-resident window function coefficients, keyed by (type, length)
+
+	Every spectrogram channel with the same window and FFT length needs the exact same coefficients, so they're
+	computed once here and shared read-only across filter instances rather than being recomputed per block by the
+	window shaders. The buffer is pushed to the GPU before it's handed out, so concurrently executing consumers
+	never race to start a transfer on first use.
+
+	Cached windows are small (one float per FFT bin) and there are only a handful of distinct shapes in a typical
+	session, so entries are kept for the lifetime of the process.
+ */
+class WindowFunctionCache
+{
+public:
+
+	std::shared_ptr<AcceleratorBuffer<float>> Acquire(FFTFilter::WindowFunction window, size_t length);
+
+	void Clear();
+
+protected:
+
+	///@brief Mutex guarding the cache
+	std::mutex m_mutex;
+
+	///@brief Coefficient buffers, keyed by (window type, length)
+	std::map<std::pair<FFTFilter::WindowFunction, size_t>, std::shared_ptr<AcceleratorBuffer<float>>> m_windows;
+};
+
+extern WindowFunctionCache g_windowFunctionCache;
+
+#endif
@@ -66,6 +66,7 @@ void ScopeProtocolStaticInit()
 	AddDecoderClass(CouplerDeEmbedFilter);
 	AddDecoderClass(CSVExportFilter);
 	AddDecoderClass(CSVImportFilter);
+	AddDecoderClass(CWFImportFilter);
 	AddDecoderClass(CTLEFilter);
 	AddDecoderClass(CurrentShuntFilter);
 	AddDecoderClass(DCDMeasurement);
@@ -111,6 +112,7 @@ void ScopeProtocolStaticInit()
 	AddDecoderClass(EthernetAutonegotiationPageDecoder);
 	AddDecoderClass(EthernetBaseXAutonegotiationDecoder);
 	AddDecoderClass(ExponentialMovingAverageFilter);
+	AddDecoderClass(ExpressionFilter);
 	AddDecoderClass(EyeBitRateMeasurement);
 	AddDecoderClass(EyePattern);
 	AddDecoderClass(EyeHeightMeasurement);
@@ -189,6 +191,7 @@ void ScopeProtocolStaticInit()
 	AddDecoderClass(ScaleFilter);
 	AddDecoderClass(SDCmdDecoder);
 	AddDecoderClass(SDDataDecoder);
+	AddDecoderClass(SDRFrontEndFilter);
 	AddDecoderClass(SNRFilter);
 	AddDecoderClass(SParameterCascadeFilter);
 	AddDecoderClass(SParameterDeEmbedFilter);
@@ -230,6 +233,7 @@ void ScopeProtocolStaticInit()
 	AddDecoderClass(VerticalBathtub);
 	AddDecoderClass(VICPDecoder);
 	AddDecoderClass(Waterfall);
+	AddDecoderClass(WaveformStitchFilter);
 	AddDecoderClass(WAVImportFilter);
 	AddDecoderClass(WFMImportFilter);
 	AddDecoderClass(WindowedAutocorrelationFilter);
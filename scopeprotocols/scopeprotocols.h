@@ -65,6 +65,7 @@
 #include "CouplerDeEmbedFilter.h"
 #include "CSVExportFilter.h"
 #include "CSVImportFilter.h"
+#include "CWFImportFilter.h"
 #include "CTLEFilter.h"
 #include "CurrentShuntFilter.h"
 #include "DCDMeasurement.h"
@@ -111,6 +112,7 @@
 #include "Ethernet10GBaseRDecoder.h"
 #include "Ethernet64b66bDecoder.h"
 #include "ExponentialMovingAverageFilter.h"
+#include "ExpressionFilter.h"
 #include "EyeBitRateMeasurement.h"
 #include "EyePattern.h"
 #include "EyeHeightMeasurement.h"
@@ -189,6 +191,7 @@
 #include "ScaleFilter.h"
 #include "SDCmdDecoder.h"
 #include "SDDataDecoder.h"
+#include "SDRFrontEndFilter.h"
 #include "SNRFilter.h"
 #include "SParameterCascadeFilter.h"
 #include "SParameterDeEmbedFilter.h"
@@ -230,10 +233,12 @@
 #include "VerticalBathtub.h"
 #include "VICPDecoder.h"
 #include "Waterfall.h"
+#include "WaveformStitchFilter.h"
 #include "WAVImportFilter.h"
 #include "WFMImportFilter.h"
 #include "WindowedAutocorrelationFilter.h"
 #include "WindowFilter.h"
+#include "WindowFunctionCache.h"
 #include "XYSweepFilter.h"
 
 void ScopeProtocolStaticInit();
@@ -2,7 +2,7 @@
 *                                                                                                                      *
 * libscopeprotocols                                                                                                    *
 *                                                                                                                      *
-* Copyright (c) 2012-2022 Andrew D. Zonenberg and contributors                                                         *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
 * All rights reserved.                                                                                                 *
 *                                                                                                                      *
 * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
@@ -27,6 +27,9 @@
 *                                                                                                                      *
 ***********************************************************************************************************************/
 
+//Multiplies consecutive FFT blocks by precomputed window coefficients (see WindowFunctionCache),
+//covering every block of a spectrogram in a single dispatch
+
 #version 430
 #pragma shader_stage(compute)
 
@@ -35,43 +38,32 @@ layout(std430, binding=0) restrict readonly buffer buf_din
 	float din[];
 };
 
-layout(std430, binding=1) restrict readonly buffer buf_fkernel
+layout(std430, binding=1) restrict writeonly buffer buf_dout
 {
-	float fkernel[];
+	float dout[];
 };
 
-layout(std430, binding=2) restrict writeonly buffer buf_dout
+layout(std430, binding=2) restrict readonly buffer buf_window
 {
-	float dout[];
+	float window[];
 };
 
 layout(std430, push_constant) uniform constants
 {
-	uint imax;
-	uint upsample_factor;
-	uint kernel;
+	uint npoints;
+	uint fftlen;
+
+	//Offset of the first input sample (multiple of fftlen, so the window phase is unchanged)
+	uint offsetIn;
 };
 
 layout(local_size_x=64, local_size_y=1, local_size_z=1) in;
 
 void main()
 {
-	if(gl_GlobalInvocationID.x >= imax)				//i
+	//If off end of array, stop
+	if(gl_GlobalInvocationID.x >= npoints)
 		return;
-	if(gl_GlobalInvocationID.y >= upsample_factor)	//j
-		return;
-
-	uint start = 0;
-	uint sstart = 0;
-	if(gl_GlobalInvocationID.y > 0)
-	{
-		sstart = 1;
-		start = upsample_factor - gl_GlobalInvocationID.y;
-	}
-
-	float f = 0;
-	for(uint k = start; k<kernel; k += upsample_factor, sstart ++)
-		f += fkernel[k] * din[gl_GlobalInvocationID.x + sstart];
 
-	dout[gl_GlobalInvocationID.x*upsample_factor + gl_GlobalInvocationID.y] = f;
+	dout[gl_GlobalInvocationID.x] = window[gl_GlobalInvocationID.x % fftlen] * din[gl_GlobalInvocationID.x + offsetIn];
 }
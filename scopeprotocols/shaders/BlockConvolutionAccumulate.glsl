@@ -0,0 +1,91 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopeprotocols                                                                                                    *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+#version 430
+#pragma shader_stage(compute)
+
+layout(std430, binding=0) restrict readonly buffer buf_din
+{
+	float din[];
+};
+
+layout(std430, binding=1) restrict readonly buffer buf_partitions
+{
+	float partitions[];
+};
+
+layout(std430, binding=2) restrict writeonly buffer buf_dout
+{
+	float dout[];
+};
+
+layout(std430, push_constant) uniform constants
+{
+	uint nbins;			//complex bins per block spectrum
+	uint nblocks;		//number of input block spectra
+	uint npartitions;	//number of impulse response partition spectra
+};
+
+layout(local_size_x=64, local_size_y=1, local_size_z=1) in;
+
+/*
+	Frequency domain accumulation for partitioned convolution.
+
+	Output spectrum of block k is the sum over partitions p of X[k-p] * H[p], i.e. the frequency domain
+	delay line of recent input block spectra convolved with the transformed impulse response partitions.
+ */
+void main()
+{
+	if(gl_GlobalInvocationID.x >= (nblocks * nbins))
+		return;
+
+	uint block = gl_GlobalInvocationID.x / nbins;
+	uint bin = gl_GlobalInvocationID.x % nbins;
+
+	uint nparts = min(npartitions, block + 1);
+	float re = 0;
+	float im = 0;
+	for(uint p=0; p<nparts; p++)
+	{
+		uint xbase = (block - p) * nbins * 2 + bin * 2;
+		uint hbase = p * nbins * 2 + bin * 2;
+
+		float xr = din[xbase];
+		float xi = din[xbase + 1];
+		float hr = partitions[hbase];
+		float hi = partitions[hbase + 1];
+
+		re += xr*hr - xi*hi;
+		im += xr*hi + xi*hr;
+	}
+
+	uint obase = block * nbins * 2 + bin * 2;
+	dout[obase] = re;
+	dout[obase + 1] = im;
+}
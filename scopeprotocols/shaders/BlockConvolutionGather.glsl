@@ -0,0 +1,75 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopeprotocols                                                                                                    *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+#version 430
+#pragma shader_stage(compute)
+
+layout(std430, binding=0) restrict readonly buffer buf_din
+{
+	float din[];
+};
+
+layout(std430, binding=1) restrict writeonly buffer buf_dout
+{
+	float dout[];
+};
+
+layout(std430, push_constant) uniform constants
+{
+	uint inlen;			//number of valid input samples
+	uint copyLen;		//number of samples copied into each slot before zero padding begins
+	uint blockLen;		//stride between successive blocks in the input
+	uint fftlen;		//size of each output slot
+	uint nblocks;		//number of slots
+	int preShift;		//samples of history before the block start to include (for overlap-save)
+};
+
+layout(local_size_x=64, local_size_y=1, local_size_z=1) in;
+
+/*
+	Gathers overlapping (or contiguous) blocks of a waveform into zero-padded FFT slots.
+
+	Slot k element i gets input sample k*blockLen + i - preShift, or zero if that's out of bounds
+	or past the copy length.
+ */
+void main()
+{
+	//If off end of array, stop
+	if(gl_GlobalInvocationID.x >= (nblocks * fftlen))
+		return;
+
+	uint block = gl_GlobalInvocationID.x / fftlen;
+	uint i = gl_GlobalInvocationID.x % fftlen;
+
+	int idx = int(block * blockLen + i) - preShift;
+	if( (i >= copyLen) || (idx < 0) || (idx >= int(inlen)) )
+		dout[gl_GlobalInvocationID.x] = 0;
+	else
+		dout[gl_GlobalInvocationID.x] = din[idx];
+}
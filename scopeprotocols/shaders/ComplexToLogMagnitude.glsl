@@ -43,6 +43,7 @@ layout(std430, binding=1) restrict writeonly buffer buf_dout
 layout(std430, push_constant) uniform constants
 {
 	uint npoints;
+	uint offsetIn;
 	float scale;
 };
 
@@ -54,8 +55,8 @@ void main()
 	if(gl_GlobalInvocationID.x >= npoints)
 		return;
 
-	float real = din[gl_GlobalInvocationID.x*2];
-	float imag = din[gl_GlobalInvocationID.x*2 + 1];
+	float real = din[gl_GlobalInvocationID.x*2 + offsetIn];
+	float imag = din[gl_GlobalInvocationID.x*2 + offsetIn + 1];
 
 	float v = real*real + imag*imag;
 
@@ -0,0 +1,121 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopeprotocols                                                                                                    *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+
+#version 430
+#pragma shader_stage(compute)
+
+layout(std430, binding=0) restrict readonly buffer buf_din_i
+{
+	float din_i[];
+};
+
+layout(std430, binding=1) restrict readonly buffer buf_din_q
+{
+	float din_q[];
+};
+
+layout(std430, binding=2) restrict buffer buf_accum
+{
+	uint accum[];
+};
+
+layout(std430, binding=3) restrict readonly buffer buf_points
+{
+	vec2 points[];
+};
+
+layout(std430, binding=4) restrict writeonly buffer buf_evm
+{
+	float evmsum[];
+};
+
+layout(std430, push_constant) uniform constants
+{
+	uint len;
+	uint width;
+	uint height;
+	uint npoints;
+	float xscale;
+	float xmid;
+	float yscale;
+	float ymid;
+};
+
+layout(local_size_x=256, local_size_y=1, local_size_z=1) in;
+
+shared float g_evmPartial[256];
+
+void main()
+{
+	float evm = 0.0;
+
+	//Grid stride loop: each thread bins a strided subset of the symbols.
+	//Same math as the CPU integration loop: out of range points are dropped entirely.
+	uint stride = gl_WorkGroupSize.x * gl_NumWorkGroups.x;
+	for(uint i = gl_GlobalInvocationID.x; i < len; i += stride)
+	{
+		float ival = din_i[i];
+		float qval = din_q[i];
+
+		int x = int(round(xmid + xscale * ival));
+		int y = int(round(ymid + yscale * qval));
+
+		//bounds check
+		if( (x < 0) || (x >= int(width)) || (y < 0) || (y >= int(height)) )
+			continue;
+
+		//fill
+		atomicAdd(accum[uint(y)*width + uint(x)], 1);
+
+		//Error vector: squared distance to the nearest nominal constellation point
+		if(npoints != 0)
+		{
+			float minvec = 3.402823e38;
+			for(uint p = 0; p < npoints; p ++)
+			{
+				vec2 d = points[p] - vec2(ival, qval);
+				minvec = min(minvec, dot(d, d));
+			}
+			evm += sqrt(minvec);
+		}
+	}
+
+	//Tree reduction of the per-thread error vector sums, one partial result per workgroup
+	g_evmPartial[gl_LocalInvocationID.x] = evm;
+	barrier();
+	for(uint s = gl_WorkGroupSize.x / 2; s > 0; s >>= 1)
+	{
+		if(gl_LocalInvocationID.x < s)
+			g_evmPartial[gl_LocalInvocationID.x] += g_evmPartial[gl_LocalInvocationID.x + s];
+		barrier();
+	}
+	if(gl_LocalInvocationID.x == 0)
+		evmsum[gl_WorkGroupID.x] = g_evmPartial[0];
+}
@@ -0,0 +1,128 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopeprotocols                                                                                                    *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+#version 430
+#pragma shader_stage(compute)
+#extension GL_EXT_shader_explicit_arithmetic_types_int64 : require
+
+layout(std430, binding=0) restrict readonly buffer buf_samples
+{
+	float samples[];
+};
+
+layout(std430, binding=1) restrict readonly buffer buf_clockEdges
+{
+	int64_t clockEdges[];
+};
+
+//32-bit per-pass accumulator, added into the 64-bit eye bins on the CPU side after readback
+layout(std430, binding=2) restrict buffer buf_accum
+{
+	uint accum[];
+};
+
+layout(std430, push_constant) uniform constants
+{
+	int64_t triggerPhase;
+	int64_t timescale;
+	int64_t uiWidth;
+	int64_t uiHalfWidth;
+	uint sampleOffset;
+	uint wend;
+	uint cend;
+	uint width;
+	uint xmax;
+	uint ymax;
+	float xscale;
+	float xoff;
+	float xtimescale;
+	float yscale;
+	float yoff;
+};
+
+layout(local_size_x=64, local_size_y=1, local_size_z=1) in;
+
+void main()
+{
+	uint i = gl_GlobalInvocationID.x + sampleOffset;
+	if(i >= wend)
+		return;
+
+	//Find time of this sample, then the last clock edge at or before it (binary search)
+	int64_t tstart = int64_t(i) * timescale + triggerPhase;
+	if(tstart < clockEdges[0])
+		return;
+	uint lo = 0;
+	uint hi = cend;
+	while(hi > lo + 1)
+	{
+		uint mid = (lo + hi) / 2;
+		if(clockEdges[mid] <= tstart)
+			lo = mid;
+		else
+			hi = mid;
+	}
+	if(lo >= cend)
+		return;
+	int64_t offset = tstart - clockEdges[lo];
+	int64_t tnext = clockEdges[lo + 1];
+
+	//Interpolate position
+	float pixel_x_f = (float(offset) - xoff) * xscale;
+	float pixel_x_fround = floor(pixel_x_f);
+	float dx_frac = (pixel_x_f - pixel_x_fround) / xtimescale;
+
+	//Drop anything past half a UI if the next clock edge is a long ways out
+	//(this is needed for irregularly sampled data like DDR RAM)
+	int64_t ttnext = tnext - tstart;
+	if( (offset > uiHalfWidth) && (ttnext > uiWidth) )
+		return;
+
+	//Early out if off end of plot
+	int pixel_x_round = int(pixel_x_fround);
+	if( (pixel_x_round > int(xmax)) || (pixel_x_round < 0) )
+		return;
+
+	//Interpolate voltage, early out if clipping
+	float dv = samples[i+1] - samples[i];
+	float nominal_voltage = samples[i] + dv*dx_frac;
+	float nominal_pixel_y = nominal_voltage*yscale + yoff;
+	int y1 = int(nominal_pixel_y);
+	if( (y1 >= int(ymax)) || (y1 < 0) )
+		return;
+
+	//Calculate how much of the pixel's intensity to put in each row
+	float yfrac = nominal_pixel_y - floor(nominal_pixel_y);
+	uint bin2 = uint(yfrac * 64);
+	uint pix = uint(y1)*width + uint(pixel_x_round);
+
+	//Plot each point (this only draws the right half of the eye, we copy to the left later)
+	atomicAdd(accum[pix], 64 - bin2);
+	atomicAdd(accum[pix + width], bin2);
+}
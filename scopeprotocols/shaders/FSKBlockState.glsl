@@ -0,0 +1,87 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopeprotocols                                                                                                    *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+#version 430
+#pragma shader_stage(compute)
+
+layout(std430, binding=0) restrict readonly buffer buf_din
+{
+	float din[];
+};
+
+//Last decisive slicer state in each block (0 = low, 1 = high, 2 = no sample crossed either threshold).
+//One extra element at [nblocks] holds the global seed state (first sample vs the midpoint).
+layout(std430, binding=1) restrict writeonly buffer buf_blockstate
+{
+	uint blockstate[];
+};
+
+layout(std430, push_constant) uniform constants
+{
+	uint len;
+	uint blocksize;
+	float vrise;
+	float vfall;
+	float midpoint;
+};
+
+layout(local_size_x=64, local_size_y=1, local_size_z=1) in;
+
+void main()
+{
+	uint nblocks = (len + blocksize - 1) / blocksize;
+	uint block = gl_GlobalInvocationID.x;
+	if(block >= nblocks)
+		return;
+
+	//First invocation also records the seed state, so the host never has to read the samples back
+	if(block == 0)
+		blockstate[nblocks] = (din[0] > midpoint) ? 1 : 0;
+
+	uint base = block * blocksize;
+	uint end = min(base + blocksize, len);
+
+	//Last decisive sample wins, so scan backward and stop at the first one we find
+	uint state = 2;
+	for(uint i = end; i > base; i--)
+	{
+		float f = din[i-1];
+		if(f > vrise)
+		{
+			state = 1;
+			break;
+		}
+		if(f < vfall)
+		{
+			state = 0;
+			break;
+		}
+	}
+	blockstate[block] = state;
+}
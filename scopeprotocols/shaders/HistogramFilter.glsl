@@ -0,0 +1,96 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopeprotocols                                                                                                    *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+#version 430
+#pragma shader_stage(compute)
+
+layout(std430, binding=0) restrict readonly buffer buf_din
+{
+	float din[];
+};
+
+layout(std430, binding=1) restrict buffer buf_hist
+{
+	uint hist[];
+};
+
+layout(std430, push_constant) uniform constants
+{
+	uint len;
+	uint nbins;
+	float vmin;
+	float delta;
+};
+
+layout(local_size_x=256, local_size_y=1, local_size_z=1) in;
+
+//Per-workgroup histogram, merged into the global one with atomics at the end.
+//Histograms with more bins than this (rare; the filter caps at 10K) bypass shared memory
+//and accumulate straight into the global bins.
+#define SHARED_BINS 4096
+shared uint g_localHist[SHARED_BINS];
+
+void main()
+{
+	//Uniform branch: every invocation takes the same path, so the barriers are safe
+	bool useShared = (nbins <= SHARED_BINS);
+
+	if(useShared)
+	{
+		for(uint b = gl_LocalInvocationID.x; b < nbins; b += gl_WorkGroupSize.x)
+			g_localHist[b] = 0;
+		barrier();
+	}
+
+	//Grid stride loop: each thread bins a strided subset of the input.
+	//Bin math matches Filter::MakeHistogram(): values outside the range clamp to the first/last bin.
+	uint stride = gl_WorkGroupSize.x * gl_NumWorkGroups.x;
+	for(uint i = gl_GlobalInvocationID.x; i < len; i += stride)
+	{
+		float fbin = (din[i] - vmin) / delta;
+		uint bin = uint(floor(clamp(fbin, 0.0, 1.0) * float(nbins)));
+		bin = min(bin, nbins - 1);
+
+		if(useShared)
+			atomicAdd(g_localHist[bin], 1);
+		else
+			atomicAdd(hist[bin], 1);
+	}
+
+	if(useShared)
+	{
+		barrier();
+		for(uint b = gl_LocalInvocationID.x; b < nbins; b += gl_WorkGroupSize.x)
+		{
+			uint n = g_localHist[b];
+			if(n != 0)
+				atomicAdd(hist[b], n);
+		}
+	}
+}
@@ -0,0 +1,86 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopeprotocols                                                                                                    *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+#version 430
+#pragma shader_stage(compute)
+
+layout(std430, binding=0) restrict readonly buffer buf_din
+{
+	float din[];
+};
+
+//Interleaved {min, max} partial result for each workgroup, reduced on the CPU after readback
+layout(std430, binding=1) restrict writeonly buffer buf_minmax
+{
+	float minmax[];
+};
+
+layout(std430, push_constant) uniform constants
+{
+	uint len;
+};
+
+layout(local_size_x=256, local_size_y=1, local_size_z=1) in;
+
+shared float g_min[256];
+shared float g_max[256];
+
+void main()
+{
+	//Grid stride loop: each thread reduces a strided subset of the input
+	float vmin = 3.402823466e38;
+	float vmax = -3.402823466e38;
+	uint stride = gl_WorkGroupSize.x * gl_NumWorkGroups.x;
+	for(uint i = gl_GlobalInvocationID.x; i < len; i += stride)
+	{
+		float f = din[i];
+		vmin = min(vmin, f);
+		vmax = max(vmax, f);
+	}
+
+	//Tree reduction across the workgroup in shared memory
+	g_min[gl_LocalInvocationID.x] = vmin;
+	g_max[gl_LocalInvocationID.x] = vmax;
+	barrier();
+	for(uint s = gl_WorkGroupSize.x / 2; s > 0; s >>= 1)
+	{
+		if(gl_LocalInvocationID.x < s)
+		{
+			g_min[gl_LocalInvocationID.x] = min(g_min[gl_LocalInvocationID.x], g_min[gl_LocalInvocationID.x + s]);
+			g_max[gl_LocalInvocationID.x] = max(g_max[gl_LocalInvocationID.x], g_max[gl_LocalInvocationID.x + s]);
+		}
+		barrier();
+	}
+
+	if(gl_LocalInvocationID.x == 0)
+	{
+		minmax[gl_WorkGroupID.x*2] = g_min[0];
+		minmax[gl_WorkGroupID.x*2 + 1] = g_max[0];
+	}
+}
@@ -0,0 +1,116 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopeprotocols                                                                                                    *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+
+#version 430
+#pragma shader_stage(compute)
+
+layout(std430, binding=0) restrict readonly buffer buf_density
+{
+	float density[];
+};
+
+layout(std430, binding=1) restrict writeonly buffer buf_dout
+{
+	float dout[];
+};
+
+layout(std430, push_constant) uniform constants
+{
+	uint width;
+	uint height;
+	uint halflen;
+	uint quartlen;
+	uint ybin;
+	float xmid;
+	float ymid;
+};
+
+layout(local_size_x=64, local_size_y=1, local_size_z=1) in;
+
+//Each invocation walks one ray from the eye center through its output column at the threshold row,
+//continuing to the edge of the eye. Same integration as EyeWaveform::GetBERAtPoint().
+void main()
+{
+	uint i = gl_GlobalInvocationID.x;
+	if(i >= halflen)
+		return;
+
+	float pointx = float(i + quartlen);
+	float pointy = float(ybin);
+
+	//Unit vector from cursor towards the center of the eye
+	//BER at center of eye is zero by definition
+	float uvecx = pointx - xmid;
+	float uvecy = pointy - ymid;
+	float len = sqrt(uvecx*uvecx + uvecy*uvecy);
+	if(len < 0.5)
+	{
+		dout[i] = -20;
+		return;
+	}
+	uvecx /= len;
+	uvecy /= len;
+
+	//Integrate from the center out to the cursor
+	float innerhits = 0;
+	for(float t = 0; t < len; t ++)
+	{
+		int x = int(round(xmid + uvecx*t));
+		int y = int(round(ymid + uvecy*t));
+		innerhits += density[uint(y)*width + uint(x)];
+	}
+
+	//Continue along the path until we hit the edge of the eye
+	float totalhits = innerhits;
+	for(float t = len; ; t ++)
+	{
+		int x = int(round(xmid + uvecx*t));
+		int y = int(round(ymid + uvecy*t));
+
+		if( (x < 0) || (x >= int(width)) || (y < 0) || (y >= int(height)) )
+			break;
+
+		totalhits += density[uint(y)*width + uint(x)];
+	}
+
+	//Find how many of the total hits were between our cursor and the eye center.
+	//An empty ray has no error hits at all, so call it error free.
+	if(totalhits <= 0)
+	{
+		dout[i] = -20;
+		return;
+	}
+
+	float ber = innerhits / totalhits;
+	if(ber < 1e-20)
+		dout[i] = -20;
+	else
+		dout[i] = log(ber) * 0.4342944819;	//log10
+}
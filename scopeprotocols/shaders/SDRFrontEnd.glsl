@@ -0,0 +1,95 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopeprotocols                                                                                                    *
+*                                                                                                                      *
+* Copyright (c) 2012-2023 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+#version 430
+#pragma shader_stage(compute)
+
+layout(std430, binding=0) restrict readonly buffer buf_din
+{
+	float din[];
+};
+
+layout(std430, binding=1) restrict readonly buffer buf_taps
+{
+	float taps[];
+};
+
+layout(std430, binding=2) restrict writeonly buffer buf_dout_i
+{
+	float dout_i[];
+};
+
+layout(std430, binding=3) restrict writeonly buffer buf_dout_q
+{
+	float dout_q[];
+};
+
+layout(std430, push_constant) uniform constants
+{
+	uint outlen;
+	uint inlen;
+	uint decimation;
+	uint filterlen;
+	int center;
+	uint phaseStep;
+	uint phaseOffset;
+};
+
+layout(local_size_x=64, local_size_y=1, local_size_z=1) in;
+
+//Radians per LSB of the 32-bit fixed point phase accumulator (2*pi / 2^32)
+const float PHASE_SCALE = 1.46291808e-9;
+
+void main()
+{
+	//If off end of array, stop
+	if(gl_GlobalInvocationID.x >= outlen)
+		return;
+
+	//Mix each input tap down by the LO and accumulate through the antialiasing FIR, emitting only the
+	//decimated sample. The phase is reconstructed per tap from the fixed point step, which wraps for free
+	//on 32-bit overflow, so precision is flat across the whole record.
+	int base = int(gl_GlobalInvocationID.x * decimation);
+	float acc_i = 0;
+	float acc_q = 0;
+	for(uint t=0; t<filterlen; t++)
+	{
+		int idx = base + int(t) - center;
+		if( (idx < 0) || (idx >= int(inlen)) )
+			continue;
+
+		uint phase_fp = phaseStep * uint(idx) + phaseOffset;
+		float phase = float(phase_fp) * PHASE_SCALE;
+		float samp = din[idx] * taps[t];
+		acc_i += samp * sin(phase);
+		acc_q += samp * cos(phase);
+	}
+	dout_i[gl_GlobalInvocationID.x] = acc_i;
+	dout_q[gl_GlobalInvocationID.x] = acc_q;
+}
@@ -0,0 +1,78 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopeprotocols                                                                                                    *
+*                                                                                                                      *
+* Copyright (c) 2012-2023 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+#version 430
+#pragma shader_stage(compute)
+#extension GL_EXT_shader_16bit_storage : require
+#extension GL_EXT_shader_explicit_arithmetic_types_float16 : require
+
+layout(std430, binding=0) restrict readonly buffer buf_dnew
+{
+	float dnew[];
+};
+
+layout(std430, binding=1) restrict writeonly buffer buf_dout
+{
+	float16_t dout[];
+};
+
+layout(std430, push_constant) uniform constants
+{
+	uint width;
+	uint inlen;
+	uint rowOffset;
+	float vrange;
+	float vfs;
+	float timescaleRatio;
+};
+
+layout(local_size_x=64, local_size_y=1, local_size_z=1) in;
+
+//fp16 variant of WaterfallFilter: the math runs at fp32, only the ring buffer store is halved.
+//Intensities are normalized to [0, 1] so fp16's 10-bit mantissa is still finer than display quantization.
+void main()
+{
+	//Bounds check
+	if(gl_GlobalInvocationID.x >= width)
+		return;
+
+	float vmin = 1.0 / 255.0;
+
+	uint binMin = uint(round(gl_GlobalInvocationID.x * timescaleRatio));
+	uint binMax = uint(round((gl_GlobalInvocationID.x+1) * timescaleRatio)) - 1;
+
+	float maxAmplitude = vmin;
+	for(uint i=binMin; (i <= binMax) && (i <= inlen); i++)
+	{
+		float v = 1 - ( (dnew[i] - vfs) / -vrange);
+		maxAmplitude = max(maxAmplitude, v);
+	}
+
+	dout[rowOffset + gl_GlobalInvocationID.x] = float16_t(maxAmplitude);
+}